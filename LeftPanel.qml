@@ -130,6 +130,7 @@ Rectangle {
                     width: 260
                     height: 135
                     fillMode: Image.PreserveAspectFit
+                    asynchronous: true
                     source: MoneroComponents.Style.blackTheme ? "qrc:///images/card-background-black" + (currentAccountIndex % MoneroComponents.Style.accountColors.length) + ".png" : "qrc:///images/card-background-white.png"
                 }
 
@@ -0,0 +1,58 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import QtQuick 2.9
+
+// Cycles through the frames of a fountain coded QR transfer, see
+// WalletManager::fountainQrFrames. The receiving scanner reassembles the
+// data from any large enough subset of frames, so looping covers misses.
+Image {
+    id: root
+
+    property var frames: []
+    property int frameInterval: 200
+    property int currentFrame: 0
+    property bool running: visible && frames.length > 0
+
+    onFramesChanged: currentFrame = 0
+
+    fillMode: Image.PreserveAspectFit
+    smooth: false
+    // frames are generated on the image provider's worker threads
+    cache: false
+    sourceSize.width: width
+    sourceSize.height: height
+    source: frames.length > 0 ? "image://qrcode/" + frames[currentFrame] : ""
+
+    Timer {
+        interval: root.frameInterval
+        repeat: true
+        running: root.running
+        onTriggered: root.currentFrame = (root.currentFrame + 1) % root.frames.length
+    }
+}
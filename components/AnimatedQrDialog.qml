@@ -0,0 +1,110 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import QtQuick 2.9
+import QtQuick.Controls 2.0
+import QtQuick.Layouts 1.1
+
+import "../components" as MoneroComponents
+
+// Plays a file as an animated QR code for a camera on the other side of an
+// air gap, the receiving wallet scans it with QRCodeScanner
+Rectangle {
+    id: root
+    x: parent.width/2 - root.width/2
+    y: parent.height/2 - root.height/2
+    width: content.implicitWidth + 2 * content.anchors.margins
+    height: content.implicitHeight + 2 * content.anchors.margins
+    color: MoneroComponents.Style.blackTheme ? "black" : "white"
+    visible: false
+    radius: 10
+    border.color: MoneroComponents.Style.blackTheme ? Qt.rgba(255, 255, 255, 0.25) : Qt.rgba(0, 0, 0, 0.25)
+    border.width: 1
+    Keys.enabled: true
+    Keys.onEscapePressed: root.close()
+    KeyNavigation.tab: doneButton
+
+    property alias title: titleLabel.text
+
+    // returns false if the file can't be read
+    function open(title, path) {
+        const frames = walletManager.fountainQrFrames(path);
+        if (frames.length == 0)
+            return false;
+        root.title = title;
+        qrCode.frames = frames;
+        root.visible = true;
+        return true;
+    }
+
+    function close() {
+        root.visible = false;
+        qrCode.frames = [];
+    }
+
+    ColumnLayout {
+        id: content
+        spacing: 10
+        anchors.fill: parent
+        anchors.margins: 25
+
+        MoneroComponents.Label {
+            id: titleLabel
+            Layout.alignment: Qt.AlignHCenter
+            fontSize: 18
+            fontFamily: "Arial"
+            horizontalAlignment: Text.AlignHCenter
+        }
+
+        MoneroComponents.TextPlain {
+            Layout.fillWidth: true
+            Layout.preferredWidth: qrCode.Layout.preferredWidth
+            horizontalAlignment: Text.AlignHCenter
+            wrapMode: Text.Wrap
+            font.pixelSize: 14
+            color: MoneroComponents.Style.defaultFontColor
+            text: qsTr("Scan with the other wallet until it has received every part") + translationManager.emptyString
+        }
+
+        MoneroComponents.AnimatedQrCode {
+            id: qrCode
+            Layout.alignment: Qt.AlignHCenter
+            Layout.preferredWidth: 360
+            Layout.preferredHeight: 360
+        }
+
+        MoneroComponents.StandardButton {
+            id: doneButton
+            Layout.alignment: Qt.AlignHCenter
+            text: qsTr("Done") + translationManager.emptyString;
+            width: 200
+            focus: root.visible
+            onClicked: root.close()
+        }
+    }
+}
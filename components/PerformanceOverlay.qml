@@ -0,0 +1,89 @@
+// Copyright (c) 2014-2024, The Monero Project
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+import QtQuick 2.9
+import QtQuick.Layouts 1.1
+
+import "../components" as MoneroComponents
+
+// Toggled with Ctrl+Shift+P, the numbers come from PerformanceMonitor once a second
+Rectangle {
+    id: overlay
+
+    property int historyRows: 0
+    property int subaddressRows: 0
+    property int addressBookRows: 0
+
+    visible: performanceMonitor.enabled
+    width: column.width + 20
+    height: column.height + 20
+    radius: 4
+    color: MoneroComponents.Style.blackTheme ? "#CC000000" : "#CCFFFFFF"
+    border.color: MoneroComponents.Style.inputBorderColorInActive
+    border.width: 1
+
+    Connections {
+        target: performanceMonitor
+        function onUpdated() {
+            // row counts are only read while the overlay shows
+            overlay.historyRows = currentWallet ? currentWallet.historyModel.rowCount() : 0;
+            overlay.subaddressRows = currentWallet ? currentWallet.subaddressModel.rowCount() : 0;
+            overlay.addressBookRows = currentWallet ? currentWallet.addressBookModel.rowCount() : 0;
+        }
+    }
+
+    ColumnLayout {
+        id: column
+
+        anchors.left: parent.left
+        anchors.top: parent.top
+        anchors.margins: 10
+        spacing: 2
+
+        Repeater {
+            model: [
+                qsTr("Frame: %1 ms avg, %2 ms max").arg(performanceMonitor.frameTimeMs.toFixed(1)).arg(performanceMonitor.maxFrameTimeMs.toFixed(1)) + translationManager.emptyString,
+                qsTr("FPS: %1").arg(performanceMonitor.framesPerSecond) + translationManager.emptyString,
+                qsTr("Event loop latency: %1 ms").arg(performanceMonitor.eventLoopLatencyMs.toFixed(0)) + translationManager.emptyString,
+                qsTr("Thread pool: %1 / %2").arg(performanceMonitor.poolActive).arg(performanceMonitor.poolMax) + translationManager.emptyString,
+                qsTr("Tasks: %1 running, %2 queued").arg(performanceMonitor.tasksRunning).arg(performanceMonitor.tasksQueued) + translationManager.emptyString,
+                qsTr("Network: %1 requests, %2 failed, %3 kB in, %4 kB out").arg(networkStats.requests).arg(networkStats.errors).arg((networkStats.bytesIn / 1024).toFixed(0)).arg((networkStats.bytesOut / 1024).toFixed(0)) + translationManager.emptyString,
+                qsTr("Memory: %1 MB").arg((performanceMonitor.rssKb / 1024).toFixed(0)) + translationManager.emptyString,
+                qsTr("Rows: %1 history, %2 subaddresses, %3 contacts").arg(overlay.historyRows).arg(overlay.subaddressRows).arg(overlay.addressBookRows) + translationManager.emptyString
+            ]
+
+            MoneroComponents.TextPlain {
+                text: modelData
+                font.pixelSize: 12
+                font.family: MoneroComponents.Style.fontMonoRegular.name
+                color: MoneroComponents.Style.defaultFontColor
+                themeTransition: false
+            }
+        }
+    }
+}
@@ -45,6 +45,10 @@ Rectangle {
     state: "Stopped"
 
     signal qrcode_decoded(string address, string payment_id, string amount, string tx_description, string recipient_name, var extra_parameters)
+    // payload of an animated QR code, e.g. an unsigned or signed transaction
+    signal data_decoded(var data)
+    property int fountainReceived: 0
+    property int fountainTotal: 0
 
     states: [
         State {
@@ -55,6 +59,8 @@ Rectangle {
                     camera.captureMode = Camera.CaptureStillImage
                     camera.cameraState = Camera.ActiveState
                     camera.start()
+                    root.fountainReceived = 0
+                    root.fountainTotal = 0
                     finder.enabled = true
                 }
             }
@@ -85,6 +91,7 @@ Rectangle {
     QRCodeScanner {
         id : finder
         objectName: "QrFinder"
+        Component.onCompleted: setSource(camera.mediaObject)
         onDecoded : {
             const parsed = walletManager.parse_uri_to_object(data);
             if (!parsed.error) {
@@ -97,6 +104,14 @@ Rectangle {
                 onNotifyError(parsed.error);
             }
         }
+        onFountainProgress: {
+            root.fountainReceived = received;
+            root.fountainTotal = total;
+        }
+        onFountainDecoded: {
+            root.data_decoded(data);
+            root.state = "Stopped";
+        }
         onNotifyError : {
             if( warning )
                 messageDialog.icon = StandardIcon.Critical
@@ -135,6 +150,17 @@ Rectangle {
         }
     }
 
+    Text {
+        visible: root.state == "Capture" && root.fountainTotal > 0
+        anchors.bottom: parent.bottom
+        anchors.bottomMargin: 20
+        anchors.horizontalCenter: parent.horizontalCenter
+        z: viewfinder.z + 1
+        color: "white"
+        font.pixelSize: 16
+        text: qsTr("Received %1 of %2 parts").arg(root.fountainReceived).arg(root.fountainTotal) + translationManager.emptyString
+    }
+
     MessageDialog {
         id: messageDialog
         title: qsTr("QrCode Scanned")  + translationManager.emptyString
@@ -50,6 +50,20 @@ ColumnLayout {
         onClicked: remoteNodeDialog.add(remoteNodesModel.append)
     }
 
+    MoneroComponents.CheckBox {
+        border: false
+        checkedIcon: FontAwesome.searchPlus
+        uncheckedIcon: FontAwesome.searchPlus
+        fontAwesomeIcons: true
+        fontSize: 16
+        iconOnTheLeft: true
+        enabled: !remoteNodeSelector.probing
+        visible: remoteNodesModel.count > 1
+        text: (remoteNodeSelector.probing ? qsTr("Probing remote nodes...") : qsTr("Select fastest remote node")) + translationManager.emptyString
+        toggleOnClick: false
+        onClicked: remoteNodesModel.applyFastestRemoteNode()
+    }
+
     ColumnLayout {
         spacing: 0
 
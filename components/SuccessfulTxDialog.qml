@@ -135,7 +135,7 @@ Rectangle {
         // view progress / open folder / done buttons
         RowLayout {
             id: buttons
-            spacing: 70
+            spacing: appWindow.viewOnly ? 20 : 70
             Layout.alignment: Qt.AlignBottom | Qt.AlignHCenter
             Layout.fillWidth: true
             Layout.preferredHeight: 50
@@ -158,17 +158,32 @@ Rectangle {
                 id: openFolderButton
                 visible: appWindow.viewOnly
                 text: qsTr("Open folder") + translationManager.emptyString;
-                width: 200
-                KeyNavigation.tab: doneButton
+                width: 150
+                KeyNavigation.tab: qrCodeButton
                 onClicked: {
                     oshelper.openContainingFolder(walletManager.urlToLocalPath(saveTxDialog.fileUrl))
                 }
             }
 
+            MoneroComponents.StandardButton {
+                id: qrCodeButton
+                visible: appWindow.viewOnly
+                text: qsTr("QR code") + translationManager.emptyString;
+                width: 150
+                primary: false
+                KeyNavigation.tab: doneButton
+                onClicked: {
+                    const path = walletManager.urlToLocalPath(saveTxDialog.fileUrl);
+                    root.close()
+                    root.accepted()
+                    appWindow.showAnimatedQrCode(qsTr("Unsigned transaction") + translationManager.emptyString, path)
+                }
+            }
+
             MoneroComponents.StandardButton {
                 id: doneButton
                 text: qsTr("Done") + translationManager.emptyString;
-                width: 200
+                width: appWindow.viewOnly ? 150 : 200
                 focus: root.visible
                 KeyNavigation.tab: appWindow.viewOnly ? openFolderButton : viewProgressButton
                 onClicked: {
@@ -79,8 +79,13 @@ function isValidOpenAliasAddress(address) {
     return isNaN(parseInt(lastPart)) || lastPart !== parseInt(lastPart).toString();
 }
 
-function handleOpenAliasResolution(address, descriptionText) {
-    const result = walletManager.resolveOpenAlias(address);
+function handleOpenAliasResolutionAsync(address, descriptionText, callback) {
+    walletManager.resolveOpenAliasAsync(address, function(alias, result) {
+        callback(openAliasResponse(alias, result, descriptionText));
+    });
+}
+
+function openAliasResponse(address, result, descriptionText) {
     if (!result) {
         return { message: qsTr("No address found") };
     }
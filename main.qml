@@ -36,6 +36,7 @@ import moneroComponents.Network 1.0
 import moneroComponents.NetworkType 1.0
 import moneroComponents.P2PoolManager 1.0
 import moneroComponents.PendingTransaction 1.0
+import moneroComponents.RemoteNodeSelector 1.0
 import moneroComponents.Settings 1.0
 import moneroComponents.Wallet 1.0
 import moneroComponents.WalletManager 1.0
@@ -58,6 +59,9 @@ ApplicationWindow {
     property var walletPassword
     property int restoreHeight: 0
     property bool daemonSynced: false
+    // trust last given to the local node, it changes once the node stops using its bootstrap node
+    property bool localDaemonTrusted: false
+    property bool restoreHeightTableExtended: false
     property bool walletSynced: false
     property int maxWindowHeight: (isAndroid || isIOS) ? screenAvailableHeight : (screenAvailableHeight < 900) ? 720 : 800
     property bool daemonRunning: !persistentSettings.useRemoteNode && !disconnected
@@ -158,6 +162,8 @@ ApplicationWindow {
             middlePanel.state = "Advanced";
         } else if (seq === "Ctrl+T") {
             middlePanel.state = "Account";
+        } else if (seq === "Ctrl+Shift+P") {
+            performanceMonitor.enabled = !performanceMonitor.enabled;
         } else if (seq === "Ctrl+Tab" || seq === "Alt+Tab") {
             /*
             if(middlePanel.state === "Transfer") middlePanel.state = "Receive"
@@ -305,6 +311,7 @@ ApplicationWindow {
         currentWallet.deviceButtonPressed.disconnect(onDeviceButtonPressed);
         currentWallet.walletPassphraseNeeded.disconnect(onWalletPassphraseNeededWallet);
         currentWallet.transactionCommitted.disconnect(onTransactionCommitted);
+        currentWallet.daemonFailover.disconnect(onDaemonFailover);
         middlePanel.paymentClicked.disconnect(handlePayment);
         middlePanel.sweepUnmixableClicked.disconnect(handleSweepUnmixable);
         middlePanel.getProofClicked.disconnect(handleGetProof);
@@ -350,7 +357,9 @@ ApplicationWindow {
         currentWallet.deviceButtonPressed.connect(onDeviceButtonPressed);
         currentWallet.walletPassphraseNeeded.connect(onWalletPassphraseNeededWallet);
         currentWallet.transactionCommitted.connect(onTransactionCommitted);
+        currentWallet.daemonFailover.connect(onDaemonFailover);
         currentWallet.proxyAddress = Qt.binding(persistentSettings.getWalletProxyAddress);
+        currentWallet.hedgeDaemonRequests = Qt.binding(function() { return persistentSettings.hedgeRemoteNodeRequests; });
         middlePanel.paymentClicked.connect(handlePayment);
         middlePanel.sweepUnmixableClicked.connect(handleSweepUnmixable);
         middlePanel.getProofClicked.connect(handleGetProof);
@@ -364,15 +373,41 @@ ApplicationWindow {
             currentWallet.setDaemonLogin(remoteNode.username, remoteNode.password);
         } else {
             currentDaemonAddress = localDaemonAddress;
+            watchLocalBootstrap();
         }
         console.log("initializing with daemon address: ", currentDaemonAddress);
         currentWallet.initAsync(currentDaemonAddress, isTrustedDaemon(), 0, persistentSettings.is_recovering, persistentSettings.is_recovering_from_device, persistentSettings.restore_height, persistentSettings.getWalletProxyAddress());
+        updateFailoverNodes();
         // save wallet keys in case wallet settings have been changed in the init
         currentWallet.setPassword(walletPassword);
     }
 
     function isTrustedDaemon() {
-        return appWindow.walletMode >= 2 && (!persistentSettings.useRemoteNode || remoteNodesModel.currentRemoteNode().trusted);
+        if (persistentSettings.useRemoteNode)
+            return appWindow.walletMode >= 2 && remoteNodesModel.currentRemoteNode().trusted;
+
+        // a local node short of the tip answers through its bootstrap node, simple mode
+        // only trusts the node once it was seen taking over from it
+        localDaemonTrusted = typeof daemonManager != "undefined" && !daemonManager.bootstrapping &&
+            (appWindow.walletMode >= 2 || (appWindow.walletMode == 1 && daemonManager.localSynchronized));
+        return localDaemonTrusted;
+    }
+
+    function watchLocalBootstrap() {
+        if (typeof daemonManager != "undefined")
+            daemonManager.watchBootstrap(persistentSettings.nettype);
+    }
+
+    function onBootstrapStatusChanged() {
+        if (!currentWallet || persistentSettings.useRemoteNode)
+            return;
+
+        // the wallet keeps scanning, later requests go to the local chain as a trusted node
+        const wasTrusted = localDaemonTrusted;
+        if (isTrustedDaemon() != wasTrusted) {
+            console.log("local node " + (localDaemonTrusted ? "took over from its bootstrap node" : "uses its bootstrap node"));
+            currentWallet.setTrustedDaemon(localDaemonTrusted);
+        }
     }
 
     function usefulName(path) {
@@ -488,7 +523,11 @@ ApplicationWindow {
         } else {
             prevSplashText = splash.messageText;
             splashDisplayedBeforeButtonRequest = splash.visible;
-            appWindow.showProcessingSplash(qsTr("Please proceed to the device..."));
+            var waiting = currentWallet ? currentWallet.deviceQueue.pending : 0;
+            if (waiting > 0)
+                appWindow.showProcessingSplash(qsTr("Please proceed to the device... (%1 more requests waiting)").arg(waiting) + translationManager.emptyString);
+            else
+                appWindow.showProcessingSplash(qsTr("Please proceed to the device..."));
         }
     }
 
@@ -652,6 +691,23 @@ ApplicationWindow {
         passwordDialog.close();
     }
 
+    // the camera and its scan thread are only needed once the user scans a code
+    function ensureCameraUi() {
+        if (cameraUi || !qrScannerEnabled) {
+            return !!cameraUi;
+        }
+        console.log("qrScannerEnabled : load component QRCodeScanner");
+        var component = Qt.createComponent("components/QRCodeScanner.qml");
+        if (component.status == Component.Ready) {
+            console.log("Camera component ready");
+            cameraUi = component.createObject(appWindow);
+        } else {
+            console.log("component not READY !!!");
+            qrScannerEnabled = false;
+        }
+        return !!cameraUi;
+    }
+
     function connectRemoteNode() {
         console.log("connecting remote node");
         p2poolManager.exit();
@@ -662,6 +718,7 @@ ApplicationWindow {
             currentDaemonAddress = remoteNode.address;
             currentWallet.setDaemonLogin(remoteNode.username, remoteNode.password);
             currentWallet.initAsync(currentDaemonAddress, isTrustedDaemon(), 0, false, false, 0, persistentSettings.getWalletProxyAddress());
+            updateFailoverNodes();
             walletManager.setDaemonAddressAsync(currentDaemonAddress);
         };
         if (typeof daemonManager != "undefined" && daemonRunning)
@@ -679,12 +736,40 @@ ApplicationWindow {
         p2poolManager.getStatus();
         persistentSettings.useRemoteNode = false;
         currentDaemonAddress = localDaemonAddress;
+        watchLocalBootstrap();
         currentWallet.setDaemonLogin("", "");
         currentWallet.initAsync(currentDaemonAddress, isTrustedDaemon(), 0, false, false, 0, persistentSettings.getWalletProxyAddress());
+        updateFailoverNodes();
         walletManager.setDaemonAddressAsync(currentDaemonAddress);
         firstBlockSeen = 0;
     }
 
+    function updateFailoverNodes() {
+        if (typeof currentWallet === "undefined" || currentWallet === null)
+            return;
+
+        var nodes = [];
+        if (persistentSettings.useRemoteNode && persistentSettings.remoteNodeFailover) {
+            for (var index = 0; index < remoteNodesModel.count; ++index) {
+                const remoteNode = remoteNodesModel.get(index);
+                nodes.push({
+                    "address": remoteNode.address,
+                    "username": remoteNode.username,
+                    "password": remoteNode.password,
+                    "trusted": appWindow.walletMode >= 2 && remoteNode.trusted
+                });
+            }
+        }
+        currentWallet.setFailoverNodes(nodes, remoteNodesModel.selected, persistentSettings.getProxyAddress());
+    }
+
+    function onDaemonFailover(index, address) {
+        console.log("remote node failed over to: ", address);
+        remoteNodesModel.selected = index;
+        currentDaemonAddress = address;
+        walletManager.setDaemonAddressAsync(currentDaemonAddress);
+    }
+
     function onHeightRefreshed(bcHeight, dCurrentBlock, dTargetBlock) {
         // Daemon fully synced
         // TODO: implement onDaemonSynced or similar in wallet API and don't start refresh thread before daemon is synced
@@ -693,6 +778,10 @@ ApplicationWindow {
             firstBlockSeen = dCurrentBlock;
 
         daemonSynced = dCurrentBlock >= dTargetBlock && dTargetBlock != 1;
+        if (daemonSynced && !restoreHeightTableExtended) {
+            restoreHeightTableExtended = true;
+            currentWallet.extendRestoreHeightTable();
+        }
         walletSynced = bcHeight >= dTargetBlock;
         // Update progress bars
         if (!daemonSynced) {
@@ -704,6 +793,11 @@ ApplicationWindow {
                 leftPanel.progressBar.updateProgress(bcHeight, dTargetBlock, dTargetBlock - bcHeight, qsTr("Wallet is synchronized"));
 
         }
+        // the heights above are the bootstrap node's, the wallet doesn't wait for the local chain
+        if (!persistentSettings.useRemoteNode && typeof daemonManager != "undefined" && daemonManager.bootstrapping && daemonManager.localTargetHeight > 0) {
+            leftPanel.daemonProgressBar.updateProgress(daemonManager.localHeight, daemonManager.localTargetHeight, daemonManager.localTargetHeight,
+                qsTr("Local node syncing (%1/%2), using bootstrap node").arg(daemonManager.localHeight.toFixed(0)).arg(daemonManager.localTargetHeight.toFixed(0)));
+        }
         // Update wallet sync progress
         leftPanel.isSyncing = !disconnected && !daemonSynced;
         // Update transfer page status
@@ -740,6 +834,7 @@ ApplicationWindow {
         currentWallet.pauseRefresh();
         const noSync = appWindow.walletMode === 0;
         const bootstrapNodeAddress = persistentSettings.walletMode < 2 ? "auto" : persistentSettings.bootstrapNodeAddress;
+        daemonManager.resourceProfile = persistentSettings.daemonResourceProfile;
         daemonManager.start(flags, persistentSettings.nettype, persistentSettings.blockchainDataDir, bootstrapNodeAddress, noSync, persistentSettings.pruneBlockchain);
     }
 
@@ -980,6 +1075,11 @@ ApplicationWindow {
         });
     }
 
+    // returns false if the file can't be read
+    function showAnimatedQrCode(title, path) {
+        return animatedQrPopup.open(title, path);
+    }
+
     function doSearchInHistory(searchTerm) {
         middlePanel.searchInHistory(searchTerm);
         leftPanel.selectItem(middlePanel.state);
@@ -995,8 +1095,17 @@ ApplicationWindow {
         }
 
         if (amount !== null && amount.length > 0) {
-            var result = currentWallet.getReserveProof(false, currentWallet.currentSubaddressAccount, walletManager.amountFromString(amount), message);
-            txProofComputed(null, result);
+            informationPopup.title = qsTr("Reserve proof") + translationManager.emptyString;
+            informationPopup.text = qsTr("Generating the reserve proof, this can take a while on wallets with many outputs.") + translationManager.emptyString;
+            informationPopup.icon = StandardIcon.Information;
+            informationPopup.onCloseCallback = function() {
+                currentWallet.cancelReserveProof();
+            };
+            currentWallet.getReserveProofAsync(false, currentWallet.currentSubaddressAccount, walletManager.amountFromString(amount), message, function(result) {
+                informationPopup.onCloseCallback = null;
+                if (result !== "error|cancelled")
+                    txProofComputed(null, result);
+            });
         } else {
             console.log("Getting payment proof: ");
             console.log("\ttxid: ", txid, ", address: ", address, ", message: ", message);
@@ -1023,14 +1132,24 @@ ApplicationWindow {
     function handleCheckProof(txid, address, message, signature) {
         console.log("Checking payment proof: ");
         console.log("\ttxid: ", txid, ", address: ", address, ", message: ", message, ", signature: ", signature);
-        var result;
         var isReserveProof = signature.indexOf("ReserveProofV") === 0;
-        if (address.length > 0 && !isReserveProof)
+        if (isReserveProof) {
+            currentWallet.checkReserveProofAsync(address, message, signature, function(result) {
+                if (result !== "error|cancelled")
+                    txProofChecked(address, true, result);
+            });
+            return;
+        }
+
+        var result;
+        if (address.length > 0)
             result = currentWallet.checkTxProof(txid, address, message, signature);
-        else if (isReserveProof)
-            result = currentWallet.checkReserveProof(address, message, signature);
         else
             result = currentWallet.checkSpendProof(txid, message, signature);
+        txProofChecked(address, false, result);
+    }
+
+    function txProofChecked(address, isReserveProof, result) {
         var results = result.split("|");
         if (address.length > 0 && results.length == 5 && results[0] === "true" && !isReserveProof) {
             var good = results[1] === "true";
@@ -1325,7 +1444,6 @@ ApplicationWindow {
         const alreadyAsked = updateDialog.url == downloadUrl && updateDialog.hash == hash;
         if (!alreadyAsked)
             updateDialog.show(version, isMac || isWindows || isLinux ? downloadUrl : "", hash);
-
     }
 
     function getBuildTag() {
@@ -1341,6 +1459,19 @@ ApplicationWindow {
         return "source";
     }
 
+    // Build the proxy circuit to the price API before the fiat ticker needs it.
+    // The remote node isn't warmed up, libwallet doesn't use network's pool.
+    function warmUpProxy() {
+        if (persistentSettings.getProxyAddress() == "")
+            return;
+
+        var urls = [];
+        const provider = appWindow.fiatPriceAPIs[persistentSettings.fiatPriceProvider];
+        if (persistentSettings.fiatPriceEnabled && provider && provider.hasOwnProperty(persistentSettings.fiatPriceCurrency))
+            urls.push(provider[persistentSettings.fiatPriceCurrency]);
+        network.warmUp(urls);
+    }
+
     function checkUpdates() {
         const version = Version.GUI_VERSION.match(/\d+\.\d+\.\d+\.\d+/);
         if (version)
@@ -1404,6 +1535,7 @@ ApplicationWindow {
         txConfirmationPopup.clearFields();
         txConfirmationPopup.rejected();
         successfulTxPopup.close();
+        animatedQrPopup.close();
         if (currentWallet && currentWallet.getBackgroundSyncType() != Wallet.BackgroundSync_Off) {
             appWindow.showProcessingSplash(qsTr("Locking..."));
             currentWallet.startBackgroundSync();
@@ -1486,22 +1618,10 @@ ApplicationWindow {
             daemonManager.daemonStarted.connect(onDaemonStarted);
             daemonManager.daemonStartFailure.connect(onDaemonStartFailure);
             daemonManager.daemonStopped.connect(onDaemonStopped);
+            daemonManager.bootstrapStatusChanged.connect(onBootstrapStatusChanged);
         }
         // Connect app exit to qml window exit handling
         mainApp.closing.connect(appWindow.close);
-        if (appWindow.qrScannerEnabled) {
-            console.log("qrScannerEnabled : load component QRCodeScanner");
-            var component = Qt.createComponent("components/QRCodeScanner.qml");
-            if (component.status == Component.Ready) {
-                console.log("Camera component ready");
-                cameraUi = component.createObject(appWindow);
-            } else {
-                console.log("component not READY !!!");
-                appWindow.qrScannerEnabled = false;
-            }
-        } else {
-            console.log("qrScannerEnabled disabled");
-        }
         if (!walletsFound()) {
             wizard.wizardState = "wizardLanguage";
             rootItem.state = "wizard";
@@ -1530,13 +1650,14 @@ ApplicationWindow {
             }
         }
         remoteNodesModel.initialize();
+        warmUpProxy();
     }
     onClosing: {
         close.accepted = false;
         console.log("blocking close event");
         if (isAndroid) {
             console.log("blocking android exit");
-            if (qrScannerEnabled)
+            if (cameraUi)
                 cameraUi.state = "Stopped";
 
             if (!androidCloseTapped) {
@@ -1617,6 +1738,7 @@ ApplicationWindow {
         property bool customDecorations: true
         property string daemonFlags
         property string p2poolFlags
+        property bool p2poolAutoTuneThreads: false
         property int logLevel: 0
         property string logCategories: ""
         property string daemonUsername: "" // TODO: drop after v0.17.2.0 release
@@ -1645,6 +1767,10 @@ ApplicationWindow {
         property bool displayWalletNameInTitleBar: true
         property bool hideBalance: false
         property bool askPasswordBeforeSending: true
+        property bool prepareTransactions: false
+        property bool remoteNodeFailover: true
+        property bool hedgeRemoteNodeRequests: false
+        property bool coldSyncIncremental: false
         property bool lockOnUserInActivity: true
         property int walletMode: 2
         property int lockOnUserInActivityInterval: 10 // minutes
@@ -1653,6 +1779,7 @@ ApplicationWindow {
         property bool autosave: true
         property int autosaveMinutes: 10
         property bool pruneBlockchain: false
+        property string daemonResourceProfile: "auto"
         property bool fiatPriceEnabled: false
         property bool fiatPriceToggle: false
         property string fiatPriceProvider: "kraken"
@@ -1747,6 +1874,19 @@ ApplicationWindow {
             }
         }
 
+        function applyFastestRemoteNode() {
+            var remoteNodes = [];
+            for (var index = 0; index < remoteNodesModel.count; ++index) {
+                const remoteNode = remoteNodesModel.get(index);
+                remoteNodes.push({
+                    "address": remoteNode.address,
+                    "username": remoteNode.username,
+                    "password": remoteNode.password
+                });
+            }
+            remoteNodeSelector.rank(remoteNodes, persistentSettings.nettype);
+        }
+
         function currentRemoteNode() {
             if (selected < remoteNodesModel.count)
                 return remoteNodesModel.get(selected);
@@ -1767,9 +1907,18 @@ ApplicationWindow {
                 selected = selected - 1;
         }
 
-        onCountChanged: store()
-        onDataChanged: store()
-        onSelectedChanged: store()
+        onCountChanged: {
+            store();
+            appWindow.updateFailoverNodes();
+        }
+        onDataChanged: {
+            store();
+            appWindow.updateFailoverNodes();
+        }
+        onSelectedChanged: {
+            store();
+            appWindow.updateFailoverNodes();
+        }
     }
 
     // Information dialog
@@ -1825,6 +1974,12 @@ ApplicationWindow {
         z: parent.z + 1
     }
 
+    AnimatedQrDialog {
+        id: animatedQrPopup
+
+        z: parent.z + 1
+    }
+
     StandardDialog {
         id: confirmationDialog
 
@@ -2135,7 +2290,7 @@ ApplicationWindow {
             anchors.fill: blurredArea
             source: blurredArea
             radius: 64
-            visible: passwordDialog.visible || inputDialog.visible || splash.visible || updateDialog.visible || devicePassphraseDialog.visible || txConfirmationPopup.visible || successfulTxPopup.visible || remoteNodeDialog.visible
+            visible: passwordDialog.visible || inputDialog.visible || splash.visible || updateDialog.visible || devicePassphraseDialog.visible || txConfirmationPopup.visible || successfulTxPopup.visible || animatedQrPopup.visible || remoteNodeDialog.visible
         }
 
         MouseArea {
@@ -2329,6 +2484,14 @@ ApplicationWindow {
 
     }
 
+    MoneroComponents.PerformanceOverlay {
+        z: 99
+        anchors.top: parent.top
+        anchors.topMargin: titleBar.height + 10
+        anchors.right: parent.right
+        anchors.rightMargin: 10
+    }
+
     Timer {
         id: updatesTimer
 
@@ -2451,6 +2614,22 @@ ApplicationWindow {
         proxyAddress: persistentSettings.getProxyAddress()
     }
 
+    RemoteNodeSelector {
+        id: remoteNodeSelector
+
+        proxyAddress: persistentSettings.getProxyAddress()
+        onRankingFinished: function(nodes) {
+            // the list may have been edited while probing
+            if (nodes.length > 0 && nodes[0].ok && nodes[0].index < remoteNodesModel.count &&
+                remoteNodesModel.get(nodes[0].index).address == nodes[0].address) {
+                console.log("fastest remote node: " + nodes[0].address + ", latency " + nodes[0].latency + " ms");
+                remoteNodesModel.applyRemoteNode(nodes[0].index);
+            } else {
+                console.error("no remote node responded");
+            }
+        }
+    }
+
     WalletManager {
         id: walletManager
 
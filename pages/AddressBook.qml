@@ -47,9 +47,30 @@ Rectangle {
     property alias addressbookHeight: mainLayout.height
     property bool selectAndSend: false
     property bool editEntry: false
+    property int qrGrabRequest: -1
 
     Clipboard { id: clipboard }
 
+    Connections {
+        target: oshelper
+        function onQrCodesGrabbed(request, codes) {
+            if (request !== root.qrGrabRequest)
+                return;
+            root.qrGrabRequest = -1;
+            for (var index = 0; index < codes.length; ++index) {
+                const parsed = walletManager.parse_uri_to_object(codes[index]);
+                if (!parsed.error) {
+                    addressLine.text = parsed.address
+                    descriptionLine.text = parsed.recipient_name
+                    break;
+                } else if (walletManager.addressValid(codes[index], appWindow.persistentSettings.nettype)) {
+                    addressLine.text = codes[index];
+                    break;
+                }
+            }
+        }
+    }
+
     ColumnLayout {
         id: mainLayout
         anchors.margins: 20
@@ -351,18 +372,7 @@ Rectangle {
                     tooltip: qsTr("Grab QR code from screen") + translationManager.emptyString
                     onClicked: {
                         clearFields();
-                        const codes = oshelper.grabQrCodesFromScreen();
-                        for (var index = 0; index < codes.length; ++index) {
-                            const parsed = walletManager.parse_uri_to_object(codes[index]);
-                            if (!parsed.error) {
-                                addressLine.text = parsed.address
-                                descriptionLine.text = parsed.recipient_name
-                                break;
-                            } else if (walletManager.addressValid(codes[index], appWindow.persistentSettings.nettype)) {
-                                addressLine.text = codes[index];
-                                break;
-                            }
-                        }
+                        root.qrGrabRequest = oshelper.grabQrCodesFromScreenAsync();
                     }
                 }
 
@@ -372,8 +382,10 @@ Rectangle {
                     text: FontAwesome.qrcode
                     visible : appWindow.qrScannerEnabled && !addressLine.text
                     onClicked: {
-                        cameraUi.state = "Capture"
-                        cameraUi.qrcode_decoded.connect(root.updateFromQrCode)
+                        if (appWindow.ensureCameraUi()) {
+                            cameraUi.state = "Capture"
+                            cameraUi.qrcode_decoded.connect(root.updateFromQrCode)
+                        }
                     }
                 }
             }
@@ -387,8 +399,11 @@ Rectangle {
                 visible: TxUtils.isValidOpenAliasAddress(addressLine.text)
                 enabled : visible
                 onClicked: {
-                    const response = TxUtils.handleOpenAliasResolution(addressLine.text, descriptionLine.text);
-                    if (response) {
+                    const alias = addressLine.text;
+                    TxUtils.handleOpenAliasResolutionAsync(alias, descriptionLine.text, function(response) {
+                        if (!response || addressLine.text !== alias) {
+                            return;
+                        }
                         if (response.message) {
                             oa_message(response.message);
                         }
@@ -398,7 +413,7 @@ Rectangle {
                         if (response.description) {
                             descriptionLine.text = response.description;
                         }
-                    }
+                    });
                 }
             }
 
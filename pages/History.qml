@@ -56,8 +56,7 @@ Rectangle {
     property var sortSearchString: null
     property bool sortDirection: true  // true = desc, false = asc
     property string sortBy: "blockheight"
-    property var txModelData: []  // representation of transaction data (appWindow.currentWallet.historyModel)
-    property var txData: []  // representation of FILTERED transation data
+    property int txFetchSize: 100  // rows the model materializes per fetch, see historyModel.pageSize
     property var txDataCollapsed: []  // keep track of which txs are collapsed
     property string historyStatusMessage: ""
     property alias contentHeight: pageRoot.height
@@ -69,6 +68,14 @@ Rectangle {
 
     onTxMaxChanged: root.updateDisplay(root.txOffset, root.txMax);
 
+    Connections {
+        target: root.model
+        function onPageUpdated() {
+            root.txCount = root.model.totalCount;
+            root.updateDisplay(root.txOffset, root.txMax);
+        }
+    }
+
     ColumnLayout {
         id: pageRoot
         anchors.topMargin: 40
@@ -1414,9 +1421,6 @@ Rectangle {
             toDatePicker.currentDate = root.model.transactionHistory.lastDateTime
         }
 
-        // extract from model, create JS array of txs
-        root.updateTransactionsFromModel();
-
         // fill listview, update UI
         root.updateDisplay(root.txOffset, root.txMax);
     }
@@ -1437,91 +1441,65 @@ Rectangle {
     }
 
     function updateFilter(currentPage){
-        // applying filters
-        root.txData = JSON.parse(JSON.stringify(root.txModelData)); // deepcopy
-
-        const timezoneOffset = new Date().getTimezoneOffset() * 60;
-        var fromDate = Math.floor(fromDatePicker.currentDate.getTime() / 86400000) * 86400 + timezoneOffset;
-        var toDate = (Math.floor(toDatePicker.currentDate.getTime() / 86400000) + 1) * 86400 + timezoneOffset;
+        // filtering runs on the packed history in historyModel, which signals pageUpdated once done
+        if (typeof root.model === 'undefined' || root.model == null) return;
 
-        var txs = [];
-        for (var i = 0; i < root.txData.length; i++){
-            var item = root.txData[i];
-
-            // daterange filtering
-            if(item.timestamp < fromDate || item.timestamp > toDate){
-                continue;
-            }
-
-            // search string filtering
-            if(root.sortSearchString == null || root.sortSearchString === ""){
-                txs.push(root.txData[i]);
-                continue;
-            }
+        root.model.dateFromFilter = fromDatePicker.currentDate;
+        root.model.dateToFilter = toDatePicker.currentDate;
+        root.model.searchFilter = root.sortSearchString != null ? root.sortSearchString : "";
+        root.txCount = root.model.totalCount;
 
-            if(root.sortSearchString.length >= 1){
-                if(item.amount && item.amount.toString().startsWith(root.sortSearchString)){
-                    txs.push(item);
-                } else if(item.address !== "" && item.address.toLowerCase().startsWith(root.sortSearchString.toLowerCase())){
-                    txs.push(item);
-                } else if(item.receivingAddress !== "" && item.receivingAddress.toLowerCase().startsWith(root.sortSearchString.toLowerCase())){
-                    txs.push(item);
-                } else if(item.receivingAddressLabel !== "" && item.receivingAddressLabel.toLowerCase().startsWith(root.sortSearchString.toLowerCase())){
-                    txs.push(item);
-                } else if(item.addressBookName !== "" && item.addressBookName.toLowerCase().startsWith(root.sortSearchString.toLowerCase())){
-                    txs.push(item);
-                } else if(typeof item.blockheight !== "undefined" && item.blockheight.toString().startsWith(root.sortSearchString)) {
-                    txs.push(item);
-                } else if(item.tx_note.toLowerCase().indexOf(root.sortSearchString.toLowerCase()) !== -1) {
-                    txs.push(item);
-                } else if (item.hash.startsWith(root.sortSearchString)){
-                    txs.push(item);
-                }
-            }
-        }
-
-        root.txData = txs;
-        root.txCount = root.txData.length;
-
-        root.updateSort();
-        root.updateDisplay(root.txOffset, root.txMax);
+        root.txOffset = 0;
         if (currentPage) {
             root.paginationJump(parseInt(currentPage));
+        } else {
+            root.updateDisplay(root.txOffset, root.txMax);
         }
     }
 
     function updateSort(){
         // applying sorts
         root.txOffset = 0;
-        root.txData.sort(function(a, b) {
-            return a[root.sortBy] - b[root.sortBy];
-        });
+        if (typeof root.model === 'undefined' || root.model == null) return;
 
-        if(root.sortDirection)
-            root.txData.reverse();
+        if (root.sortBy === "timestamp")
+            root.model.sortRole = TransactionHistoryModel.TransactionTimeStampRole;
+        else if (root.sortBy === "amount")
+            root.model.sortRole = TransactionHistoryModel.TransactionAtomicAmountRole;
+        else
+            root.model.sortRole = TransactionHistoryModel.TransactionBlockHeightRole;
+        root.model.sort(0, root.sortDirection ? Qt.DescendingOrder : Qt.AscendingOrder);
 
         root.updateDisplay(root.txOffset, root.txMax);
     }
 
     function updateDisplay(tx_offset, tx_max) {
         txListViewModel.clear();
+        if (typeof root.model === 'undefined' || root.model == null) return;
+
+        // rows past the fetched page arrive with the next pageUpdated
+        root.model.fetchRows(tx_offset + tx_max);
 
         // limit results as per tx_max (root.txMax)
-        var txs = root.txData.slice(tx_offset, tx_offset + tx_max);
+        var end = Math.min(root.model.rowCount(), tx_offset + tx_max);
+        var txs = [];
+        for (var i = tx_offset; i < end; ++i) {
+            txs.push(root.transactionFromModel(i));
+        }
 
         // collapse tx if there is a single result
         if(root.txPage === 1 && txs.length === 1)
             root.txDataCollapsed.push(txs[0]['hash']);
 
         // populate listview
-        for (var i = 0; i < txs.length; i++){
-            txListViewModel.append(txs[i]);
+        for (var j = 0; j < txs.length; j++){
+            txListViewModel.append(txs[j]);
         }
 
         root.updateHistoryStatusMessage();
 
         // determine pagination button states
-        var count = txData.length;
+        var count = root.txCount;
         if(count <= root.txMax) {
             paginationPrev.enabled = false;
             paginationNext.enabled = false;
@@ -1539,99 +1517,80 @@ Rectangle {
             paginationNext.enabled = true;
     }
 
-    function updateTransactionsFromModel() {
-        // This function copies the items of `appWindow.currentWallet.historyModel` to `root.txModelData`, as a list of javascript objects
-        if(currentWallet == null || typeof currentWallet.history === "undefined" ) return;
-        if(currentWallet.isBackgroundSyncing()) return;
-
+    function transactionFromModel(i) {
+        // This function copies row `i` of `appWindow.currentWallet.historyModel` to a javascript object
         var _model = root.model;
-        var total = 0
-        var count = _model.rowCount()
-        root.txModelData = [];
-
-        for (var i = 0; i < count; ++i) {
-            var idx = _model.index(i, 0);
-            var isPending = model.data(idx, TransactionHistoryModel.TransactionPendingRole);
-            var isFailed = model.data(idx, TransactionHistoryModel.TransactionFailedRole);
-            var isout = _model.data(idx, TransactionHistoryModel.TransactionIsOutRole);
-            var amount = _model.data(idx, TransactionHistoryModel.TransactionAmountRole);
-            var hash = _model.data(idx, TransactionHistoryModel.TransactionHashRole);
-            var paymentId = _model.data(idx, TransactionHistoryModel.TransactionPaymentIdRole);
-            var destinations = _model.data(idx, TransactionHistoryModel.TransactionDestinationsRole);
-            var time = _model.data(idx, TransactionHistoryModel.TransactionTimeRole);
-            var date = _model.data(idx, TransactionHistoryModel.TransactionDateRole);
-            var blockheight = _model.data(idx, TransactionHistoryModel.TransactionBlockHeightRole);
-            var confirmations = _model.data(idx, TransactionHistoryModel.TransactionConfirmationsRole);
-            var confirmationsRequired = _model.data(idx, TransactionHistoryModel.TransactionConfirmationsRequiredRole);
-            var fee = _model.data(idx, TransactionHistoryModel.TransactionFeeRole);
-            var subaddrAccount = model.data(idx, TransactionHistoryModel.TransactionSubaddrAccountRole);
-            var subaddrIndex = model.data(idx, TransactionHistoryModel.TransactionSubaddrIndexRole);
-            var timestamp = new Date(date + " " + time).getTime() / 1000;
-            var dateHuman = Utils.ago(timestamp);
-
-            if (amount === 0) {
-                // transactions to the same account have amount === 0, while the 'destinations string'
-                // has the correct amount, so we try to fetch it from that instead.
-                amount = Number(TxUtils.destinationsToAmount(destinations));
-            }
-            var displayAmount = Utils.removeTrailingZeros(amount.toFixed(12)) + " XMR";
-
-            var tx_note = currentWallet.getUserNote(hash);
-            var address = "";
-            var addressBookName = "";
-            var receivingAddress = "";
-            var receivingAddressLabel = "";
-
-            if (isout) {
-                address = TxUtils.destinationsToAddress(destinations);
-                addressBookName = currentWallet ? currentWallet.addressBook.getDescription(address) : null;
-            } else {
-                receivingAddress = currentWallet ? currentWallet.address(subaddrAccount, subaddrIndex) : null;
-                receivingAddressLabel = currentWallet ? appWindow.currentWallet.getSubaddressLabel(subaddrAccount, subaddrIndex) : null;
-            }
+        var idx = _model.index(i, 0);
+        var isPending = _model.data(idx, TransactionHistoryModel.TransactionPendingRole);
+        var isFailed = _model.data(idx, TransactionHistoryModel.TransactionFailedRole);
+        var isout = _model.data(idx, TransactionHistoryModel.TransactionIsOutRole);
+        var amount = _model.data(idx, TransactionHistoryModel.TransactionAmountRole);
+        var hash = _model.data(idx, TransactionHistoryModel.TransactionHashRole);
+        var paymentId = _model.data(idx, TransactionHistoryModel.TransactionPaymentIdRole);
+        var destinations = _model.data(idx, TransactionHistoryModel.TransactionDestinationsRole);
+        var time = _model.data(idx, TransactionHistoryModel.TransactionTimeRole);
+        var date = _model.data(idx, TransactionHistoryModel.TransactionDateRole);
+        var blockheight = _model.data(idx, TransactionHistoryModel.TransactionBlockHeightRole);
+        var confirmations = _model.data(idx, TransactionHistoryModel.TransactionConfirmationsRole);
+        var confirmationsRequired = _model.data(idx, TransactionHistoryModel.TransactionConfirmationsRequiredRole);
+        var fee = _model.data(idx, TransactionHistoryModel.TransactionFeeRole);
+        var subaddrAccount = _model.data(idx, TransactionHistoryModel.TransactionSubaddrAccountRole);
+        var subaddrIndex = _model.data(idx, TransactionHistoryModel.TransactionSubaddrIndexRole);
+        var timestamp = new Date(date + " " + time).getTime() / 1000;
+        var dateHuman = Utils.ago(timestamp);
+
+        if (amount === 0) {
+            // transactions to the same account have amount === 0, while the 'destinations string'
+            // has the correct amount, so we try to fetch it from that instead.
+            amount = Number(TxUtils.destinationsToAmount(destinations));
+        }
+        var displayAmount = Utils.removeTrailingZeros(amount.toFixed(12)) + " XMR";
 
-            if (isout)
-                total = walletManager.subi(total, amount)
-            else
-                total = walletManager.addi(total, amount)
-
-            root.txModelData.push({
-                "i": i,
-                "isPending": isPending,
-                "isFailed": isFailed,
-                "isout": isout,
-                "amount": amount,
-                "displayAmount": displayAmount,
-                "hash": hash,
-                "paymentId": paymentId,
-                "address": address,
-                "addressBookName": addressBookName,
-                "destinations": destinations,
-                "tx_note": tx_note,
-                "dateHuman": dateHuman,
-                "dateTime": date + " " + time,
-                "blockheight": blockheight,
-                "address": address,
-                "timestamp": timestamp,
-                "fee": fee,
-                "confirmations": confirmations,
-                "confirmationsRequired": confirmationsRequired,
-                "receivingAddress": receivingAddress,
-                "receivingAddressLabel": receivingAddressLabel,
-                "subaddrAccount": subaddrAccount,
-                "subaddrIndex": subaddrIndex
-            });
+        var tx_note = currentWallet.getUserNote(hash);
+        var address = "";
+        var addressBookName = "";
+        var receivingAddress = "";
+        var receivingAddressLabel = "";
+
+        if (isout) {
+            address = TxUtils.destinationsToAddress(destinations);
+            addressBookName = currentWallet ? currentWallet.addressBook.getDescription(address) : null;
+        } else {
+            receivingAddress = currentWallet ? currentWallet.address(subaddrAccount, subaddrIndex) : null;
+            receivingAddressLabel = currentWallet ? appWindow.currentWallet.getSubaddressLabel(subaddrAccount, subaddrIndex) : null;
         }
 
-        root.txData = JSON.parse(JSON.stringify(root.txModelData)); // deepcopy
-        root.txCount = root.txData.length;
+        return {
+            "i": i,
+            "isPending": isPending,
+            "isFailed": isFailed,
+            "isout": isout,
+            "amount": amount,
+            "displayAmount": displayAmount,
+            "hash": hash,
+            "paymentId": paymentId,
+            "address": address,
+            "addressBookName": addressBookName,
+            "destinations": destinations,
+            "tx_note": tx_note,
+            "dateHuman": dateHuman,
+            "dateTime": date + " " + time,
+            "blockheight": blockheight,
+            "timestamp": timestamp,
+            "fee": fee,
+            "confirmations": confirmations,
+            "confirmationsRequired": confirmationsRequired,
+            "receivingAddress": receivingAddress,
+            "receivingAddressLabel": receivingAddressLabel,
+            "subaddrAccount": subaddrAccount,
+            "subaddrIndex": subaddrIndex
+        };
     }
 
     function update(currentPage) {
         // handle outside mutation of tx model; incoming/outgoing funds or new blocks. Update table.
         currentWallet.history.refresh(currentWallet.currentSubaddressAccount);
 
-        root.updateTransactionsFromModel();
         root.updateFilter(currentPage);
     }
 
@@ -1668,12 +1627,12 @@ Rectangle {
     }
 
     function updateHistoryStatusMessage(){
-        if(root.txModelData.length <= 0){
+        if(currentWallet == null || currentWallet.history.count <= 0){
             root.historyStatusMessage = qsTr("No transaction history yet.") + translationManager.emptyString;
-        } else if (root.txData.length <= 0){
+        } else if (root.txCount <= 0){
             root.historyStatusMessage = qsTr("No results.") + translationManager.emptyString;
         } else {
-            root.historyStatusMessage = qsTr("%1 transactions total, showing %2.").arg(root.txData.length).arg(txListViewModel.count) + translationManager.emptyString;
+            root.historyStatusMessage = qsTr("%1 transactions total, showing %2.").arg(root.txCount).arg(txListViewModel.count) + translationManager.emptyString;
         }
     }
 
@@ -1762,28 +1721,28 @@ Rectangle {
         }
         onAccepted: {
             var dataDir = walletManager.urlToLocalPath(writeCSVFileDialog.fileUrl);
-            var written = currentWallet.history.writeCSV(currentWallet.currentSubaddressAccount, dataDir);
-
-            if(written !== ""){
-                confirmationDialog.title = qsTr("Success") + translationManager.emptyString;
-                var text = qsTr("CSV file written to: %1").arg(written) + "\n\n"
-                text += qsTr("Tip: Use your favorite spreadsheet software to sort on blockheight.") + "\n\n" + translationManager.emptyString;
-                confirmationDialog.text = text;
-                confirmationDialog.icon = StandardIcon.Information;
-                confirmationDialog.cancelText = qsTr("Open folder") + translationManager.emptyString;
-                confirmationDialog.onAcceptedCallback = null;
-                confirmationDialog.onRejectedCallback = function() {
-                    oshelper.openContainingFolder(written);
-                }
-                confirmationDialog.open();
-            } else {
-                informationPopup.title = qsTr("Error") + translationManager.emptyString;
-                informationPopup.text = qsTr("Error exporting transaction data.") + "\n\n" + translationManager.emptyString;
-                informationPopup.icon = StandardIcon.Critical;
-                informationPopup.onCloseCallback = null;
-                informationPopup.open();
+            currentWallet.history.writeCSVAsync(currentWallet.currentSubaddressAccount, false, dataDir, function(written) {
+                if(written !== ""){
+                    confirmationDialog.title = qsTr("Success") + translationManager.emptyString;
+                    var text = qsTr("CSV file written to: %1").arg(written) + "\n\n"
+                    text += qsTr("Tip: Use your favorite spreadsheet software to sort on blockheight.") + "\n\n" + translationManager.emptyString;
+                    confirmationDialog.text = text;
+                    confirmationDialog.icon = StandardIcon.Information;
+                    confirmationDialog.cancelText = qsTr("Open folder") + translationManager.emptyString;
+                    confirmationDialog.onAcceptedCallback = null;
+                    confirmationDialog.onRejectedCallback = function() {
+                        oshelper.openContainingFolder(written);
+                    }
+                    confirmationDialog.open();
+                } else {
+                    informationPopup.title = qsTr("Error") + translationManager.emptyString;
+                    informationPopup.text = qsTr("Error exporting transaction data.") + "\n\n" + translationManager.emptyString;
+                    informationPopup.icon = StandardIcon.Critical;
+                    informationPopup.onCloseCallback = null;
+                    informationPopup.open();
 
-            }
+                }
+            });
         }
         Component.onCompleted: {
             var _folder = 'file://' + appWindow.accountsDir;
@@ -1801,16 +1760,10 @@ Rectangle {
         // setup date filter scope according to real transactions
         if(appWindow.currentWallet != null){
             root.model = appWindow.currentWallet.historyModel;
-            root.model.sortRole = TransactionHistoryModel.TransactionBlockHeightRole
-            root.model.sort(0, Qt.DescendingOrder);
-            var count = root.model.rowCount()
-            if (count > 0) {
-                //date of the first transaction
-                fromDatePicker.currentDate = root.model.data(root.model.index((count - 1), 0), TransactionHistoryModel.TransactionDateRole);
-            } else {
-                //date of monero birth (2014-04-18)
-                fromDatePicker.currentDate = model.transactionHistory.firstDateTime
-            }
+            root.model.pageSize = root.txFetchSize;
+            root.updateSort();
+            //date of the first transaction, or of monero birth (2014-04-18) without any
+            fromDatePicker.currentDate = root.model.transactionHistory.firstDateTime
         }
 
         root.reset();
@@ -1823,6 +1776,11 @@ Rectangle {
         root.initialized = false;
         root.reset(true);
         root.clearFields();
+        if (typeof root.model !== 'undefined' && root.model != null) {
+            // other pages walk every row of historyModel
+            root.model.searchFilter = "";
+            root.model.pageSize = 0;
+        }
     }
 
     function searchInHistory(searchTerm){
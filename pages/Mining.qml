@@ -217,6 +217,29 @@ Rectangle {
                     }
                 }
 
+                RowLayout {
+                    visible: persistentSettings.allow_p2pool_mining
+                    MoneroComponents.CheckBox {
+                        id: autoTuneThreads
+                        enabled: startSoloMinerButton.enabled
+                        checked: persistentSettings.p2poolAutoTuneThreads
+                        onClicked: persistentSettings.p2poolAutoTuneThreads = checked
+                        text: qsTr("Auto-tune threads (benchmarks this computer once)") + translationManager.emptyString
+                    }
+
+                    MoneroComponents.StandardButton {
+                        small: true
+                        primary: false
+                        visible: persistentSettings.p2poolAutoTuneThreads
+                        enabled: startSoloMinerButton.enabled
+                        text: qsTr("Benchmark again") + translationManager.emptyString
+                        onClicked: {
+                            p2poolManager.resetAutoTune()
+                            appWindow.showStatusMessage(qsTr("Threads will be benchmarked on the next start") + translationManager.emptyString, 3)
+                        }
+                    }
+                }
+
                 RowLayout {
                     // Disable this option until stable
                     visible: false
@@ -528,26 +551,28 @@ Rectangle {
         }
     }
 
-    function updateStatusText(p2poolHashrate) {
+    function updateStatusText(hashrate) {
         if (appWindow.isMining) {
             if (persistentSettings.allow_p2pool_mining) {
-                if (p2poolHashrate === 0) {
+                if (hashrate === 0) {
                     statusText.text = qsTr("Starting P2Pool") + translationManager.emptyString;
                 }
                 else {
-                    statusText.text = qsTr("Mining with P2Pool, at %1 H/s").arg(p2poolHashrate) + translationManager.emptyString;
+                    statusText.text = qsTr("Mining with P2Pool, at %1 H/s").arg(hashrate) + translationManager.emptyString;
                 }
             }
             else {
-                var userHashRate = walletManager.miningHashRate();
+                var userHashRate = hashrate;
                 if (userHashRate === 0) {
                     statusText.text = qsTr("Mining temporarily suspended.") + translationManager.emptyString;
                 }
                 else {
                     var blockTime = 120;
                     var blocksPerDay = 86400 / blockTime;
-                    var globalHashRate = walletManager.networkDifficulty() / blockTime;
-                    var probabilityFindNextBlock = userHashRate / globalHashRate;
+                    var globalHashRate = walletManager.miningMonitor.networkDifficulty / blockTime;
+                    // the recent average doesn't jump around with every sample
+                    var averageHashRate = walletManager.miningMonitor.averageHashRate() || userHashRate;
+                    var probabilityFindNextBlock = averageHashRate / globalHashRate;
                     var probabilityFindBlockDay = 1 - Math.pow(1 - probabilityFindNextBlock, blocksPerDay);
                     var chanceFindBlockDay = Math.round(1 / probabilityFindBlockDay);
                     statusText.text = qsTr("Mining at %1 H/s. It gives you a 1 in %2 daily chance of finding a block.").arg(userHashRate).arg(chanceFindBlockDay) + translationManager.emptyString;
@@ -576,8 +601,8 @@ Rectangle {
             p2poolManager.getStatus();
         }
         else {
-            walletManager.miningStatusAsync();
-        } 
+            onMiningStatus(walletManager.miningMonitor.active, walletManager.miningMonitor.hashRate);
+        }
     }
 
     function miningError(message) {
@@ -595,14 +620,36 @@ Rectangle {
         cancelVisible: false
     }
 
+    readonly property bool statusWatched: middlePanel.advancedView.state === "Mining" && middlePanel.state === "Advanced" && currentWallet !== undefined && (!persistentSettings.useRemoteNode || persistentSettings.allowRemoteNodeMining)
+
+    // solo mining status is pushed by walletManager.miningMonitor, only P2Pool is polled
     Timer {
         id: timer
         interval: 2000
-        running: middlePanel.advancedView.state === "Mining" && middlePanel.state === "Advanced" && currentWallet !== undefined && (!persistentSettings.useRemoteNode || persistentSettings.allowRemoteNodeMining)
+        running: statusWatched && miningModeDropdown.currentIndex === 1
         repeat: true
         onTriggered: update()
     }
 
+    Binding {
+        target: walletManager.miningMonitor
+        property: "watched"
+        value: statusWatched && miningModeDropdown.currentIndex !== 1
+    }
+
+    // pushed statuses only arrive on change, the buttons also follow the daemon
+    Connections {
+        target: appWindow
+        function onDaemonSyncedChanged() {
+            if (statusWatched)
+                update();
+        }
+    }
+    onStatusWatchedChanged: {
+        if (statusWatched)
+            update();
+    }
+
     function startP2PoolLocal() {
         var noSync = false;
         //these args will be deleted because DaemonManager::start will re-add them later.
@@ -652,7 +699,7 @@ allArgs = allArgs.filter( ( el ) => !defaultArgs.includes( el.split(" ")[0] ) )
             chain = "nano"
         }
         var p2poolArgs = persistentSettings.p2poolFlags;
-        var success = p2poolManager.start(p2poolArgs, address, chain, threads);
+        var success = p2poolManager.start(p2poolArgs, address, chain, persistentSettings.p2poolAutoTuneThreads ? "auto" : threads);
         if (success) 
         {
             update()
@@ -662,6 +709,15 @@ allArgs = allArgs.filter( ( el ) => !defaultArgs.includes( el.split(" ")[0] ) )
         }
     }
 
+    function p2poolAutoTuneProgress(threadCount, step, steps) {
+        appWindow.showStatusMessage(qsTr("Benchmarking %1 threads (%2/%3)").arg(threadCount).arg(step).arg(steps) + translationManager.emptyString, 5)
+    }
+
+    function p2poolAutoTuneFinished(threadCount, hashrate) {
+        threads = threadCount
+        appWindow.showStatusMessage(qsTr("Auto-tune selected %1 threads").arg(threadCount) + translationManager.emptyString, 5)
+    }
+
     function p2poolDownloadFailed(errorCode) {
         statusMessage.visible = false
         errorPopup.title = qsTr("P2Pool Installation Failed") + translationManager.emptyString;
@@ -696,9 +752,11 @@ allArgs = allArgs.filter( ( el ) => !defaultArgs.includes( el.split(" ")[0] ) )
     }
 
     Component.onCompleted: {
-        walletManager.miningStatus.connect(onMiningStatus);
+        walletManager.miningMonitor.statusUpdated.connect(onMiningStatus);
         p2poolManager.p2poolStatus.connect(onMiningStatus);
         p2poolManager.p2poolDownloadFailure.connect(p2poolDownloadFailed);
         p2poolManager.p2poolDownloadSuccess.connect(p2poolDownloadSucceeded);
+        p2poolManager.p2poolAutoTuneProgress.connect(p2poolAutoTuneProgress);
+        p2poolManager.p2poolAutoTuneFinished.connect(p2poolAutoTuneFinished);
     }
 }
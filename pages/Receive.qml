@@ -126,6 +126,8 @@ Rectangle {
                     anchors.margins: 1
                     smooth: false
                     fillMode: Image.PreserveAspectFit
+                    sourceSize.width: width
+                    sourceSize.height: height
                     source: "image://qrcode/" + generateQRCodeString();
 
                     MouseArea {
@@ -76,6 +76,7 @@ Rectangle {
     }
     property string startLinkText: "<style type='text/css'>a {text-decoration: none; color: #FF6C3C; font-size: 14px;}</style><a href='#'>(%1)</a>".arg(qsTr("Start daemon")) + translationManager.emptyString
     property bool warningLongPidDescription: descriptionLine.text.match(/^[0-9a-f]{64}$/i)
+    property int qrGrabRequest: -1
 
     signal paymentClicked(var recipients, string paymentId, int mixinCount, int priority, string description)
     signal sweepUnmixableClicked()
@@ -88,6 +89,25 @@ Rectangle {
         oaPopup.open();
     }
 
+    Connections {
+        target: oshelper
+        function onQrCodesGrabbed(request, codes) {
+            if (request !== root.qrGrabRequest)
+                return;
+            root.qrGrabRequest = -1;
+            for (var index = 0; index < codes.length; ++index) {
+                const parsed = walletManager.parse_uri_to_object(codes[index]);
+                if (!parsed.error) {
+                    fillPaymentDetails(parsed.address, parsed.payment_id, parsed.amount, parsed.tx_description, parsed.recipient_name);
+                    break;
+                } else if (walletManager.addressValid(codes[index], appWindow.persistentSettings.nettype)) {
+                    fillPaymentDetails(codes[index]);
+                    break;
+                }
+            }
+        }
+    }
+
     function fillPaymentDetails(address, payment_id, amount, tx_description, recipient_name) {
         if (recipientModel.count > 0) {
             const last = recipientModel.count - 1;
@@ -106,6 +126,105 @@ Rectangle {
         cameraUi.qrcode_decoded.disconnect(updateFromQrCode);
     }
 
+    // a transaction scanned from an animated QR code goes back the same way once signed
+    function signTxFile(path, showQrCode) {
+        // Load the unsigned tx from file
+        var transaction = currentWallet.loadTxFile(path);
+        if (transaction.status !== PendingTransaction.Status_Ok) {
+            console.error("Can't load unsigned transaction: ", transaction.errorString);
+            informationPopup.title = qsTr("Error") + translationManager.emptyString;
+            informationPopup.text = qsTr("Can't load unsigned transaction: ") + transaction.errorString;
+            informationPopup.icon = StandardIcon.Critical;
+            informationPopup.onCloseCallback = null;
+            informationPopup.open();
+            // deleting transaction object, we don't want memleaks
+            transaction.destroy();
+        } else {
+            confirmationDialog.text = qsTr("\nConfirmation message:\n ") + transaction.confirmationMessage;
+            console.log(transaction.confirmationMessage);
+            // Show confirmation dialog
+            confirmationDialog.title = qsTr("Confirmation") + translationManager.emptyString;
+            confirmationDialog.icon = StandardIcon.Question;
+            confirmationDialog.onAcceptedCallback = function() {
+                const signed = transaction.sign(path + "_signed");
+                transaction.destroy();
+                if (signed && showQrCode)
+                    appWindow.showAnimatedQrCode(qsTr("Signed transaction") + translationManager.emptyString, path + "_signed");
+            };
+            confirmationDialog.onRejectedCallback = transaction.destroy;
+            confirmationDialog.open();
+        }
+    }
+
+    function submitTxFile(path) {
+        if (!currentWallet.submitTxFile(path)) {
+            informationPopup.title = qsTr("Error") + translationManager.emptyString;
+            informationPopup.text = qsTr("Can't submit transaction: ") + currentWallet.errorString;
+            informationPopup.icon = StandardIcon.Critical;
+            informationPopup.onCloseCallback = null;
+            informationPopup.open();
+        } else {
+            informationPopup.title = qsTr("Information") + translationManager.emptyString;
+            informationPopup.text = qsTr("Monero sent successfully") + translationManager.emptyString;
+            informationPopup.icon = StandardIcon.Information;
+            informationPopup.onCloseCallback = null;
+            informationPopup.open();
+        }
+    }
+
+    function importOutputsFile(path) {
+        appWindow.showProcessingSplash(qsTr("Please wait...") + translationManager.emptyString);
+        currentWallet.importOutputsAsync(path, function(success, error) {
+            appWindow.hideProcessingSplash();
+            if (success)
+                appWindow.showStatusMessage(qsTr("Outputs successfully imported to wallet") + translationManager.emptyString, 3);
+            else
+                appWindow.showStatusMessage(error, 5);
+        });
+    }
+
+    function importKeyImagesFile(path) {
+        appWindow.showProcessingSplash(qsTr("Please wait...") + translationManager.emptyString);
+        currentWallet.importKeyImagesAsync(path, function(success, error) {
+            appWindow.hideProcessingSplash();
+            if (success)
+                appWindow.showStatusMessage(qsTr("Key images successfully imported to wallet") + translationManager.emptyString, 3);
+            else
+                appWindow.showStatusMessage(error, 5);
+        });
+    }
+
+    // outputs, key images and transactions come in as animated QR codes from
+    // the other side of the air gap, the file goes the usual import path
+    function importFromQrData(data) {
+        cameraUi.data_decoded.disconnect(importFromQrData);
+        const kind = walletManager.fountainQrDataKind(data);
+        const allowed = {
+            "outputs": !appWindow.viewOnly,
+            "key_images": appWindow.viewOnly && appWindow.isTrustedDaemon(),
+            "unsigned_tx": !appWindow.viewOnly,
+            "signed_tx": appWindow.viewOnly,
+        };
+        if (!allowed[kind]) {
+            appWindow.showStatusMessage(qsTr("The scanned data can't be imported into this wallet") + translationManager.emptyString, 5);
+            return;
+        }
+
+        const path = appWindow.accountsDir + "/" + kind + "_" + Date.now();
+        if (!walletManager.saveFountainQrData(data, path)) {
+            appWindow.showStatusMessage(qsTr("Failed to save the scanned data") + translationManager.emptyString, 5);
+            return;
+        }
+        if (kind == "outputs")
+            importOutputsFile(path);
+        else if (kind == "key_images")
+            importKeyImagesFile(path);
+        else if (kind == "unsigned_tx")
+            signTxFile(path, true);
+        else
+            submitTxFile(path);
+    }
+
     function setDescription(value) {
         descriptionLine.text = value;
         descriptionCheckbox.checked = descriptionLine.text != "";
@@ -182,6 +301,41 @@ Rectangle {
         id: clipboard
     }
 
+    // builds the transaction once the form has been idle for a moment so the
+    // confirmation opens right away, hardware wallets would prompt the device.
+    // Each build fetches new decoys for the same inputs, only a local or trusted
+    // node gets to see several of them.
+    Timer {
+        id: prepareTransactionTimer
+        interval: 1500
+        onTriggered: {
+            if (!persistentSettings.prepareTransactions || !currentWallet || currentWallet.isHwBacked() || !sendButton.enabled || !appWindow.isTrustedDaemon())
+                return;
+
+            var addresses = [];
+            var amounts = [];
+            for (var index = 0; index < recipientModel.count; ++index) {
+                const recipient = recipientModel.get(index);
+                if (recipient.amount == "(all)")
+                    return;
+                addresses.push(recipient.address);
+                amounts.push(recipient.amount);
+            }
+            currentWallet.prepareTransactionAsync(addresses, paymentIdLine.text.trim(), amounts, root.mixin, priorityModelV5.get(priorityDropdown.currentIndex).priority);
+        }
+    }
+
+    // looks up typed or pasted aliases in the background so Resolve answers
+    // from the cache. DNS doesn't go through the proxy, so not while one is set.
+    Timer {
+        id: openAliasPrefetchTimer
+        interval: 1000
+        onTriggered: {
+            if (persistentSettings.getProxyAddress() === "")
+                walletManager.prefetchOpenAliases(recipientModel.openAliasCandidates());
+        }
+    }
+
     // Information dialog
     StandardDialog {
         id: oaPopup
@@ -248,6 +402,16 @@ Rectangle {
                 return false;
             }
 
+            function openAliasCandidates() {
+                var aliases = [];
+                for (var index = 0; index < recipientModel.count; ++index) {
+                    const address = recipientModel.get(index).address;
+                    if (TxUtils.isValidOpenAliasAddress(address))
+                        aliases.push(address);
+                }
+                return aliases;
+            }
+
             function getRecipients() {
                 var recipients = [];
                 for (var index = 0; index < recipientModel.count; ++index) {
@@ -347,17 +511,7 @@ Rectangle {
                             tooltip: qsTr("Grab QR code from screen") + translationManager.emptyString
                             onClicked: {
                                 clearFields();
-                                const codes = oshelper.grabQrCodesFromScreen();
-                                for (var index = 0; index < codes.length; ++index) {
-                                    const parsed = walletManager.parse_uri_to_object(codes[index]);
-                                    if (!parsed.error) {
-                                        fillPaymentDetails(parsed.address, parsed.payment_id, parsed.amount, parsed.tx_description, parsed.recipient_name);
-                                        break;
-                                    } else if (walletManager.addressValid(codes[index], appWindow.persistentSettings.nettype)) {
-                                        fillPaymentDetails(codes[index]);
-                                        break;
-                                    }
-                                }
+                                root.qrGrabRequest = oshelper.grabQrCodesFromScreenAsync();
                             }
                         }
 
@@ -368,8 +522,10 @@ Rectangle {
                             visible: appWindow.qrScannerEnabled
                             tooltip: qsTr("Scan QR code") + translationManager.emptyString
                             onClicked: {
-                                cameraUi.state = "Capture";
-                                cameraUi.qrcode_decoded.connect(updateFromQrCode);
+                                if (appWindow.ensureCameraUi()) {
+                                    cameraUi.state = "Capture";
+                                    cameraUi.qrcode_decoded.connect(updateFromQrCode);
+                                }
                             }
                         }
 
@@ -479,6 +635,8 @@ Rectangle {
                                         fillPaymentDetails(parsed.address, parsed.payment_id, parsed.amount, parsed.tx_description, parsed.recipient_name);
 
                                     address = text;
+                                    if (TxUtils.isValidOpenAliasAddress(text))
+                                        openAliasPrefetchTimer.restart();
                                 }
                                 text: address
 
@@ -487,19 +645,25 @@ Rectangle {
                                     text: qsTr("Resolve") + translationManager.emptyString
                                     visible: TxUtils.isValidOpenAliasAddress(address)
                                     onClicked: {
-                                        const response = TxUtils.handleOpenAliasResolution(address, descriptionLine.text);
-                                        if (response) {
+                                        const recipientIndex = index;
+                                        const alias = address;
+                                        TxUtils.handleOpenAliasResolutionAsync(alias, descriptionLine.text, function(response) {
+                                            // the recipient may have been edited or removed meanwhile
+                                            const recipient = recipientRepeater.itemAt(recipientIndex);
+                                            if (!response || !recipient || recipientModel.get(recipientIndex).address !== alias)
+                                                return;
+
                                             if (response.message)
                                                 oa_message(response.message);
 
                                             if (response.address)
-                                                recipientRepeater.itemAt(index).children[1].children[0].text = response.address;
+                                                recipient.children[1].children[0].text = response.address;
 
                                             if (response.description) {
                                                 descriptionLine.text = response.description;
                                                 descriptionCheckbox.checked = true;
                                             }
-                                        }
+                                        });
                                     }
                                 }
 
@@ -811,6 +975,7 @@ Rectangle {
                         estimating = sendButton.enabled;
                         if (!sendButton.enabled || !currentWallet)
                             return ;
+                        prepareTransactionTimer.restart();
 
                         var addresses = [];
                         var amounts = [];
@@ -1040,6 +1205,13 @@ Rectangle {
             }
         }
 
+        MoneroComponents.CheckBox {
+            visible: persistentSettings.transferShowAdvanced && appWindow.walletMode >= 2
+            checked: persistentSettings.coldSyncIncremental
+            onClicked: persistentSettings.coldSyncIncremental = !persistentSettings.coldSyncIncremental
+            text: qsTr("Only export outputs and key images added since the last export") + translationManager.emptyString
+        }
+
         AdvancedOptionsItem {
             visible: persistentSettings.transferShowAdvanced && appWindow.walletMode >= 2
             title: qsTr("Offline transaction signing") + translationManager.emptyString
@@ -1074,6 +1246,29 @@ Rectangle {
             }
         }
 
+        AdvancedOptionsItem {
+            visible: persistentSettings.transferShowAdvanced && appWindow.walletMode >= 2
+            title: qsTr("Animated QR code") + translationManager.emptyString
+            button1.text: qsTr("Show") + translationManager.emptyString
+            button1.onClicked: {
+                console.log("Transfer: show animated QR code clicked");
+                animatedQrFileDialog.open();
+            }
+            button2.text: qsTr("Scan") + translationManager.emptyString
+            button2.enabled: appWindow.qrScannerEnabled
+            button2.onClicked: {
+                console.log("Transfer: scan animated QR code clicked");
+                if (appWindow.ensureCameraUi()) {
+                    cameraUi.state = "Capture";
+                    cameraUi.data_decoded.connect(importFromQrData);
+                }
+            }
+            tooltip: {
+                var header = qsTr("Move outputs, key images and transactions between the wallets without a file transfer") + translationManager.emptyString;
+                return "<style type='text/css'>.header{ font-size: 13px; } p{line-height:20px; margin-top:0px; margin-bottom:0px; " + ";} p.orange{color:#ff9323;}</style>" + "<div class='header'>" + header + "</div>" + "<p>" + qsTr("1. Export the outputs, key images or transaction into a file as above") + "</p>" + "<p>" + qsTr("2. Show the file as an animated QR code") + "</p>" + "<p>" + qsTr("3. Using the other wallet, scan the code, it is imported, signed or submitted right away") + "</p>" + translationManager.emptyString;
+            }
+        }
+
         AdvancedOptionsItem {
             visible: persistentSettings.transferShowAdvanced && appWindow.walletMode >= 2
             title: qsTr("Unmixable outputs") + translationManager.emptyString
@@ -1096,31 +1291,7 @@ Rectangle {
         currentFolder: "file://" + appWindow.accountsDir
         nameFilters: ["Unsigned transfers (*)"]
         onAccepted: {
-            var path = walletManager.urlToLocalPath(selectedFile);
-            // Load the unsigned tx from file
-            var transaction = currentWallet.loadTxFile(path);
-            if (transaction.status !== PendingTransaction.Status_Ok) {
-                console.error("Can't load unsigned transaction: ", transaction.errorString);
-                informationPopup.title = qsTr("Error") + translationManager.emptyString;
-                informationPopup.text = qsTr("Can't load unsigned transaction: ") + transaction.errorString;
-                informationPopup.icon = StandardIcon.Critical;
-                informationPopup.onCloseCallback = null;
-                informationPopup.open();
-                // deleting transaction object, we don't want memleaks
-                transaction.destroy();
-            } else {
-                confirmationDialog.text = qsTr("\nConfirmation message:\n ") + transaction.confirmationMessage;
-                console.log(transaction.confirmationMessage);
-                // Show confirmation dialog
-                confirmationDialog.title = qsTr("Confirmation") + translationManager.emptyString;
-                confirmationDialog.icon = StandardIcon.Question;
-                confirmationDialog.onAcceptedCallback = function() {
-                    transaction.sign(path + "_signed");
-                    transaction.destroy();
-                };
-                confirmationDialog.onRejectedCallback = transaction.destroy;
-                confirmationDialog.open();
-            }
+            signTxFile(walletManager.urlToLocalPath(selectedFile), false);
         }
         onRejected: {
             // File dialog closed
@@ -1136,19 +1307,24 @@ Rectangle {
         currentFolder: "file://" + appWindow.accountsDir
         nameFilters: ["signed transfers (*)"]
         onAccepted: {
-            if (!currentWallet.submitTxFile(walletManager.urlToLocalPath(selectedFile))) {
-                informationPopup.title = qsTr("Error") + translationManager.emptyString;
-                informationPopup.text = qsTr("Can't submit transaction: ") + currentWallet.errorString;
-                informationPopup.icon = StandardIcon.Critical;
-                informationPopup.onCloseCallback = null;
-                informationPopup.open();
-            } else {
-                informationPopup.title = qsTr("Information") + translationManager.emptyString;
-                informationPopup.text = qsTr("Monero sent successfully") + translationManager.emptyString;
-                informationPopup.icon = StandardIcon.Information;
-                informationPopup.onCloseCallback = null;
-                informationPopup.open();
-            }
+            submitTxFile(walletManager.urlToLocalPath(selectedFile));
+        }
+        onRejected: {
+            console.log("Canceled");
+        }
+    }
+
+    FileDialog {
+        id: animatedQrFileDialog
+
+        selectMultiple: false
+        selectExisting: true
+        title: qsTr("Please choose a file") + translationManager.emptyString
+        currentFolder: "file://" + appWindow.accountsDir
+        onAccepted: {
+            const path = walletManager.urlToLocalPath(animatedQrFileDialog.selectedFile);
+            if (!appWindow.showAnimatedQrCode(qsTr("Animated QR code") + translationManager.emptyString, path))
+                appWindow.showStatusMessage(qsTr("Can't read the file") + translationManager.emptyString, 5);
         }
         onRejected: {
             console.log("Canceled");
@@ -1162,10 +1338,14 @@ Rectangle {
         selectExisting: false
         onAccepted: {
             console.log(walletManager.urlToLocalPath(exportOutputsDialog.selectedFile));
-            if (currentWallet.exportOutputs(walletManager.urlToLocalPath(exportOutputsDialog.selectedFile), true))
-                appWindow.showStatusMessage(qsTr("Outputs successfully exported to file") + translationManager.emptyString, 3);
-            else
-                appWindow.showStatusMessage(currentWallet.errorString, 5);
+            appWindow.showProcessingSplash(qsTr("Please wait...") + translationManager.emptyString);
+            currentWallet.exportOutputsAsync(walletManager.urlToLocalPath(exportOutputsDialog.selectedFile), !persistentSettings.coldSyncIncremental, function(success, error) {
+                appWindow.hideProcessingSplash();
+                if (success)
+                    appWindow.showStatusMessage(qsTr("Outputs successfully exported to file") + translationManager.emptyString, 3);
+                else
+                    appWindow.showStatusMessage(error, 5);
+            });
         }
         onRejected: {
             console.log("Canceled");
@@ -1180,10 +1360,7 @@ Rectangle {
         title: qsTr("Please choose a file") + translationManager.emptyString
         onAccepted: {
             console.log(walletManager.urlToLocalPath(importOutputsDialog.selectedFile));
-            if (currentWallet.importOutputs(walletManager.urlToLocalPath(importOutputsDialog.selectedFile)))
-                appWindow.showStatusMessage(qsTr("Outputs successfully imported to wallet") + translationManager.emptyString, 3);
-            else
-                appWindow.showStatusMessage(currentWallet.errorString, 5);
+            importOutputsFile(walletManager.urlToLocalPath(importOutputsDialog.selectedFile));
         }
         onRejected: {
             console.log("Canceled");
@@ -1198,10 +1375,14 @@ Rectangle {
         selectExisting: false
         onAccepted: {
             console.log(walletManager.urlToLocalPath(exportKeyImagesDialog.selectedFile));
-            if (currentWallet.exportKeyImages(walletManager.urlToLocalPath(exportKeyImagesDialog.selectedFile), true))
-                appWindow.showStatusMessage(qsTr("Key images successfully exported to file") + translationManager.emptyString, 3);
-            else
-                appWindow.showStatusMessage(currentWallet.errorString, 5);
+            appWindow.showProcessingSplash(qsTr("Please wait...") + translationManager.emptyString);
+            currentWallet.exportKeyImagesAsync(walletManager.urlToLocalPath(exportKeyImagesDialog.selectedFile), !persistentSettings.coldSyncIncremental, function(success, error) {
+                appWindow.hideProcessingSplash();
+                if (success)
+                    appWindow.showStatusMessage(qsTr("Key images successfully exported to file") + translationManager.emptyString, 3);
+                else
+                    appWindow.showStatusMessage(error, 5);
+            });
         }
         onRejected: {
             console.log("Canceled");
@@ -1217,10 +1398,7 @@ Rectangle {
         title: qsTr("Please choose a file") + translationManager.emptyString
         onAccepted: {
             console.log(walletManager.urlToLocalPath(importKeyImagesDialog.selectedFile));
-            if (currentWallet.importKeyImages(walletManager.urlToLocalPath(importKeyImagesDialog.selectedFile)))
-                appWindow.showStatusMessage(qsTr("Key images successfully imported to wallet") + translationManager.emptyString, 3);
-            else
-                appWindow.showStatusMessage(currentWallet.errorString, 5);
+            importKeyImagesFile(walletManager.urlToLocalPath(importKeyImagesDialog.selectedFile));
         }
         onRejected: {
             console.log("Canceled");
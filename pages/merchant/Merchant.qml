@@ -211,6 +211,8 @@ Item {
 
                     smooth: false
                     fillMode: Image.PreserveAspectFit
+                    sourceSize.width: width
+                    sourceSize.height: height
                     source: "image://qrcode/" + walletManager.make_uri(appWindow.current_address, walletManager.amountFromString(amountToReceive.text))
 
                     MouseArea {
@@ -170,6 +170,13 @@ ColumnLayout {
         settingsStateView.settingsLogView.consoleArea.logMessage(message)
     }
 
+    function onDaemonConsoleLinesUpdated(lines){
+        var consoleArea = settingsStateView.settingsLogView.consoleArea;
+        for (var i = 0; i < lines.length; ++i) {
+            consoleArea.logMessage(lines[i]);
+        }
+    }
+
     // fires on every page load
     function onPageCompleted() {
         console.log("Settings page loaded");
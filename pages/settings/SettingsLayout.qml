@@ -115,6 +115,13 @@ Rectangle {
             }
         }
 
+        MoneroComponents.CheckBox {
+            checked: persistentSettings.prepareTransactions
+            onClicked: persistentSettings.prepareTransactions = !persistentSettings.prepareTransactions
+            text: qsTr("Prepare transactions while filling in the send form (local or trusted node only)") + translationManager.emptyString
+            tooltip: qsTr("Every change to the form builds a new transaction with new decoys for the same inputs.\nA remote node seeing several of them could tell the real inputs apart,\nso transactions are only prepared while connected to a local or trusted node.") + translationManager.emptyString
+        }
+
         MoneroComponents.CheckBox {
             checked: persistentSettings.autosave
             onClicked: persistentSettings.autosave = !persistentSettings.autosave
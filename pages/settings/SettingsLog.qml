@@ -143,6 +143,8 @@ Rectangle {
                     consoleArea.append(daemonLogText.replace(/#ffffff/g, '#000000').replace(/#00ff00/g, '#008000'));
                 }
                 flickable.contentY = flickableContentYBefore
+                // the recoloured log is a single block now
+                consoleArea.entryLengths = consoleArea.length > 0 ? [consoleArea.length] : [];
             }
         }
 
@@ -175,9 +177,31 @@ Rectangle {
                     font.pixelSize: 14
                     wrapMode: TextEdit.Wrap
                     readOnly: true
+                    // keeps as many entries as the daemon manager retains output lines
+                    readonly property int maxEntries: typeof daemonManager != "undefined" ? daemonManager.consoleMaxLines : 1000
+                    // plain text length of every appended entry, including the preceding paragraph separator
+                    property var entryLengths: []
+                    function appendEntry(msg){
+                        var lengthBefore = consoleArea.length;
+                        consoleArea.append(msg);
+                        entryLengths.push(consoleArea.length - lengthBefore);
+
+                        // trim in chunks so the document is not edited on every line
+                        var excess = entryLengths.length - maxEntries;
+                        if (excess >= Math.max(1, Math.floor(maxEntries / 10))) {
+                            var removed = 0;
+                            for (var i = 0; i < excess; ++i) {
+                                removed += entryLengths[i];
+                            }
+                            entryLengths = entryLengths.slice(excess);
+                            // the separator in front of the new first entry goes as well
+                            consoleArea.remove(0, removed + 1);
+                            entryLengths[0] -= 1;
+                        }
+                    }
                     function logCommand(msg){
                         msg = log_color(msg, MoneroComponents.Style.blackTheme ? "lime" : "green");
-                        consoleArea.append(msg);
+                        appendEntry(msg);
                     }
                     function logMessage(msg){
                         msg = msg.trim();
@@ -207,7 +231,7 @@ Rectangle {
 
                         var _timestamp = log_color("[" + timestamp + "]", MoneroComponents.Style.defaultFontColor);
                         var _msg = log_color(msg, color);
-                        consoleArea.append(_timestamp + " " + _msg);
+                        appendEntry(_timestamp + " " + _msg);
 
                         // scroll to bottom
                         //if(flickable.contentHeight > content.height){
@@ -268,7 +292,9 @@ Rectangle {
     }
 
     Component.onCompleted: {
-        if(typeof daemonManager != "undefined")
+        if(typeof daemonManager != "undefined") {
             daemonManager.daemonConsoleUpdated.connect(onDaemonConsoleUpdated)
+            daemonManager.daemonConsoleLinesUpdated.connect(onDaemonConsoleLinesUpdated)
+        }
     }
 }
@@ -261,6 +261,25 @@ Rectangle{
             visible: persistentSettings.useRemoteNode
         }
 
+        MoneroComponents.CheckBox {
+            Layout.topMargin: 20
+            visible: persistentSettings.useRemoteNode
+            checked: persistentSettings.remoteNodeFailover
+            onClicked: {
+                persistentSettings.remoteNodeFailover = !persistentSettings.remoteNodeFailover;
+                appWindow.updateFailoverNodes();
+            }
+            text: qsTr("Switch to another remote node when the current one stops responding") + translationManager.emptyString
+        }
+
+        MoneroComponents.CheckBox {
+            Layout.topMargin: 10
+            visible: persistentSettings.useRemoteNode && persistentSettings.remoteNodeFailover
+            checked: persistentSettings.hedgeRemoteNodeRequests
+            onClicked: persistentSettings.hedgeRemoteNodeRequests = !persistentSettings.hedgeRemoteNodeRequests
+            text: qsTr("Ask a second remote node for the chain height when the current one is slow") + translationManager.emptyString
+        }
+
         ColumnLayout {
             id: localNodeLayout
             spacing: 20
@@ -106,24 +106,54 @@ Rectangle {
             visible: appWindow.walletMode >= 2
 
             onClicked: {
-                if (!currentWallet.rescanSpent()) {
-                    console.error("Error: ", currentWallet.errorString);
-                    informationPopup.title = qsTr("Error") + translationManager.emptyString;
-                    if (currentWallet.errorString == "Rescan spent can only be used with a trusted daemon") {
-                        informationPopup.text = qsTr("Error: ") + qsTr("Rescan spent can only be used with a trusted remote node. If you trust the current node you are connected to (%1), you can mark it as trusted in Settings > Node page.").arg(remoteNodesModel.currentRemoteNode().address) + translationManager.emptyString;
+                appWindow.showProcessingSplash(qsTr("Please wait...") + translationManager.emptyString);
+                currentWallet.rescanSpentAsync(function(success, error) {
+                    appWindow.hideProcessingSplash();
+                    if (!success) {
+                        console.error("Error: ", error);
+                        informationPopup.title = qsTr("Error") + translationManager.emptyString;
+                        if (error == "Rescan spent can only be used with a trusted daemon") {
+                            informationPopup.text = qsTr("Error: ") + qsTr("Rescan spent can only be used with a trusted remote node. If you trust the current node you are connected to (%1), you can mark it as trusted in Settings > Node page.").arg(remoteNodesModel.currentRemoteNode().address) + translationManager.emptyString;
+                        } else {
+                            informationPopup.text = qsTr("Error: ") + error;
+                        }
+                        informationPopup.icon  = StandardIcon.Critical
+                        informationPopup.onCloseCallback = null
+                        informationPopup.open();
                     } else {
-                        informationPopup.text = qsTr("Error: ") + currentWallet.errorString;
+                        informationPopup.title = qsTr("Information") + translationManager.emptyString
+                        informationPopup.text  = qsTr("Successfully rescanned spent outputs.") + translationManager.emptyString
+                        informationPopup.icon  = StandardIcon.Information
+                        informationPopup.onCloseCallback = null
+                        informationPopup.open();
                     }
-                    informationPopup.icon  = StandardIcon.Critical
-                    informationPopup.onCloseCallback = null
-                    informationPopup.open();
-                } else {
-                    informationPopup.title = qsTr("Information") + translationManager.emptyString
-                    informationPopup.text  = qsTr("Successfully rescanned spent outputs.") + translationManager.emptyString
-                    informationPopup.icon  = StandardIcon.Information
-                    informationPopup.onCloseCallback = null
-                    informationPopup.open();
-                }
+                });
+            }
+        }
+
+        MoneroComponents.SettingsListItem {
+            enabled: leftPanel.progressBar.fillLevel == 100
+            iconText: FontAwesome.repeat
+            description: qsTr("Use this feature if payments to subaddresses far beyond the last used one are missing. Looks further ahead of the used addresses of each account (currently %1) and rescans the blockchain, which can take a long time.").arg(currentWallet ? currentWallet.subaddressLookahead : 0) + translationManager.emptyString
+            title: qsTr("Grow subaddress lookahead and rescan") + translationManager.emptyString
+            visible: appWindow.walletMode >= 2
+
+            onClicked: {
+                appWindow.showProcessingSplash(qsTr("Please wait...") + translationManager.emptyString);
+                currentWallet.growSubaddressLookaheadAndRescanAsync(function(success, error) {
+                    appWindow.hideProcessingSplash();
+                    if (success) {
+                        updateBalance();
+                        appWindow.showStatusMessage(qsTr("Blockchain successfully rescanned"), 3);
+                    } else {
+                        console.error("Error: ", error);
+                        informationPopup.title = qsTr("Error") + translationManager.emptyString;
+                        informationPopup.text = qsTr("Error: ") + error;
+                        informationPopup.icon = StandardIcon.Critical
+                        informationPopup.onCloseCallback = null
+                        informationPopup.open();
+                    }
+                });
             }
         }
 
@@ -137,21 +167,23 @@ Rectangle {
                 inputDialog.labelText = qsTr("Enter a transaction ID:") + translationManager.emptyString;
                 inputDialog.onAcceptedCallback = function() {
                     var txid = inputDialog.inputText.trim();
-                    if (currentWallet.scanTransactions([txid])) {
-                        updateBalance();
-                        appWindow.showStatusMessage(qsTr("Transaction successfully scanned"), 3);
-                    } else {
-                        console.error("Error: ", currentWallet.errorString);
-                        if (currentWallet.errorString == "The wallet has already seen 1 or more recent transactions than the scanned tx") {
-                            informationPopup.title = qsTr("Error") + translationManager.emptyString;
-                            informationPopup.text = qsTr("The wallet has already seen 1 or more recent transactions than the scanned transaction.\n\nIn order to rescan the transaction, you can re-sync your wallet by resetting the wallet restore height in the Settings > Info page. Make sure to use a restore height from before your wallet's earliest transaction.") + translationManager.emptyString;
-                            informationPopup.icon = StandardIcon.Critical
-                            informationPopup.onCloseCallback = null
-                            informationPopup.open();
+                    currentWallet.scanTransactionsAsync([txid], function(success, error) {
+                        if (success) {
+                            updateBalance();
+                            appWindow.showStatusMessage(qsTr("Transaction successfully scanned"), 3);
                         } else {
-                            appWindow.showStatusMessage(qsTr("Failed to scan transaction") + ": " + currentWallet.errorString, 5);
+                            console.error("Error: ", error);
+                            if (error == "The wallet has already seen 1 or more recent transactions than the scanned tx") {
+                                informationPopup.title = qsTr("Error") + translationManager.emptyString;
+                                informationPopup.text = qsTr("The wallet has already seen 1 or more recent transactions than the scanned transaction.\n\nIn order to rescan the transaction, you can re-sync your wallet by resetting the wallet restore height in the Settings > Info page. Make sure to use a restore height from before your wallet's earliest transaction.") + translationManager.emptyString;
+                                informationPopup.icon = StandardIcon.Critical
+                                informationPopup.onCloseCallback = null
+                                informationPopup.open();
+                            } else {
+                                appWindow.showStatusMessage(qsTr("Failed to scan transaction") + ": " + error, 5);
+                            }
                         }
-                    }
+                    });
                 }
                 inputDialog.onRejectedCallback = null;
                 inputDialog.open()
@@ -28,10 +28,73 @@
 
 #include "Decoder.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "quirc.h"
 
+namespace
+{
+
+// larger images are searched downscaled first
+constexpr int DOWNSCALE_ABOVE = 1280;
+// keeps the box filter sums within uint16_t
+constexpr int MAX_DOWNSCALE_FACTOR = 16;
+
+int downscaleFactor(int width, int height)
+{
+    int factor = 1;
+    while (std::max(width, height) / factor > DOWNSCALE_ABOVE && factor < MAX_DOWNSCALE_FACTOR)
+    {
+        factor *= 2;
+    }
+    return factor;
+}
+
+// Box filter, every output pixel is the mean of a factor x factor block. The
+// inner loops are plain strided sums the compiler vectorizes.
+std::vector<uint8_t> downscale(const uchar *luma, int width, int height, int bytesPerLine, int factor, int &scaledWidth, int &scaledHeight)
+{
+    scaledWidth = width / factor;
+    scaledHeight = height / factor;
+    std::vector<uint8_t> scaled(static_cast<size_t>(scaledWidth) * scaledHeight);
+    std::vector<uint16_t> sums(scaledWidth);
+    const int area = factor * factor;
+    for (int y = 0; y < scaledHeight; ++y)
+    {
+        std::fill(sums.begin(), sums.end(), 0);
+        for (int dy = 0; dy < factor; ++dy)
+        {
+            const uchar *line = luma + static_cast<size_t>(y * factor + dy) * bytesPerLine;
+            for (int x = 0; x < scaledWidth; ++x)
+            {
+                const uchar *block = line + x * factor;
+                uint16_t sum = 0;
+                for (int dx = 0; dx < factor; ++dx)
+                {
+                    sum += block[dx];
+                }
+                sums[x] += sum;
+            }
+        }
+        uint8_t *scaledLine = &scaled[static_cast<size_t>(y) * scaledWidth];
+        for (int x = 0; x < scaledWidth; ++x)
+        {
+            scaledLine[x] = static_cast<uint8_t>(sums[x] / area);
+        }
+    }
+    return scaled;
+}
+
+// room for a code that moved or was located coarsely
+QRect expanded(const QRect &box, int width, int height)
+{
+    const int margin = std::max(box.width(), box.height()) / 4 + 16;
+    return box.adjusted(-margin, -margin, margin, margin).intersected(QRect(0, 0, width, height));
+}
+
+} // namespace
+
 QrDecoder::QrDecoder()
     : m_qr(quirc_new())
 {
@@ -57,7 +120,74 @@ std::vector<std::string> QrDecoder::decode(const QImage &image)
 
 std::vector<std::string> QrDecoder::decodeGrayscale8(const QImage &image)
 {
-    if (quirc_resize(m_qr, image.width(), image.height()) < 0)
+    return decodeLuma(image.constBits(), image.width(), image.height(), image.bytesPerLine());
+}
+
+std::vector<std::string> QrDecoder::decodeLuma(const uchar *luma, int width, int height, int bytesPerLine)
+{
+    const QRect image(0, 0, width, height);
+    std::vector<std::string> result;
+    QRect decoded;
+
+    // codes rarely move much between camera frames
+    if (!m_roi.isEmpty() && image.contains(m_roi) && m_roi != image)
+    {
+        result = scanRegion(luma, bytesPerLine, m_roi, decoded);
+        if (!result.empty())
+        {
+            m_roi = expanded(decoded, width, height);
+            return result;
+        }
+    }
+
+    std::vector<QRect> detected;
+    const int factor = downscaleFactor(width, height);
+    if (factor > 1)
+    {
+        int scaledWidth, scaledHeight;
+        const std::vector<uint8_t> scaled = downscale(luma, width, height, bytesPerLine, factor, scaledWidth, scaledHeight);
+        scan(scaled.data(), scaledWidth, scaledHeight, scaledWidth, QPoint(), factor, result, detected, decoded);
+
+        // finder patterns found but too coarse to decode, refine around them
+        for (const QRect &box : detected)
+        {
+            if (!result.empty())
+            {
+                break;
+            }
+            result = scanRegion(luma, bytesPerLine, expanded(box, width, height), decoded);
+        }
+    }
+    else
+    {
+        scan(luma, width, height, bytesPerLine, QPoint(), 1, result, detected, decoded);
+    }
+
+    m_roi = result.empty() ? QRect() : expanded(decoded, width, height);
+    return result;
+}
+
+std::vector<std::string> QrDecoder::scanRegion(const uchar *luma, int bytesPerLine, const QRect &region, QRect &decoded)
+{
+    std::vector<std::string> result;
+    std::vector<QRect> detected;
+    const uchar *origin = luma + static_cast<size_t>(region.y()) * bytesPerLine + region.x();
+    scan(origin, region.width(), region.height(), bytesPerLine, region.topLeft(), 1, result, detected, decoded);
+    return result;
+}
+
+void QrDecoder::scan(
+    const uchar *luma,
+    int width,
+    int height,
+    int bytesPerLine,
+    const QPoint &offset,
+    int scale,
+    std::vector<std::string> &result,
+    std::vector<QRect> &detected,
+    QRect &decoded)
+{
+    if (quirc_resize(m_qr, width, height) < 0)
     {
         throw std::runtime_error("QUIRC: failed to allocate video memory");
     }
@@ -67,11 +197,12 @@ std::vector<std::string> QrDecoder::decodeGrayscale8(const QImage &image)
     {
         throw std::runtime_error("QUIRC: failed to get image buffer");
     }
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    std::copy(image.constBits(), image.constBits() + image.sizeInBytes(), rawImage);
-#else
-    std::copy(image.constBits(), image.constBits() + image.byteCount(), rawImage);
-#endif
+    // rows may be padded, quirc expects them packed
+    for (int row = 0; row < height; ++row)
+    {
+        const uchar *line = luma + static_cast<size_t>(row) * bytesPerLine;
+        std::copy(line, line + width, rawImage + static_cast<size_t>(row) * width);
+    }
     quirc_end(m_qr);
 
     const int count = quirc_count(m_qr);
@@ -80,20 +211,29 @@ std::vector<std::string> QrDecoder::decodeGrayscale8(const QImage &image)
         throw std::runtime_error("QUIRC: failed to get the number of recognized QR-codes");
     }
 
-    std::vector<std::string> result;
-    result.reserve(static_cast<size_t>(count));
+    result.reserve(result.size() + static_cast<size_t>(count));
     for (int index = 0; index < count; ++index)
     {
         quirc_code code;
         quirc_extract(m_qr, index, &code);
 
+        int left = std::numeric_limits<int>::max(), top = left, right = std::numeric_limits<int>::min(), bottom = right;
+        for (const quirc_point &corner : code.corners)
+        {
+            left = std::min(left, corner.x);
+            top = std::min(top, corner.y);
+            right = std::max(right, corner.x);
+            bottom = std::max(bottom, corner.y);
+        }
+        const QRect box = QRect(QPoint(left * scale, top * scale), QPoint((right + 1) * scale - 1, (bottom + 1) * scale - 1)).translated(offset);
+        detected.push_back(box);
+
         quirc_data data;
         const quirc_decode_error_t err = quirc_decode(&code, &data);
         if (err == QUIRC_SUCCESS)
         {
             result.emplace_back(&data.payload[0], &data.payload[data.payload_len]);
+            decoded = decoded.united(box);
         }
     }
-
-    return result;
 }
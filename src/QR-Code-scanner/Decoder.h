@@ -40,10 +40,27 @@ public:
     ~QrDecoder();
 
     std::vector<std::string> decode(const QImage &image);
+    // 8-bit luma rows, e.g. the Y plane of a mapped YUV video frame
+    std::vector<std::string> decodeLuma(const uchar *luma, int width, int height, int bytesPerLine);
 
 private:
     std::vector<std::string> decodeGrayscale8(const QImage &image);
+    // boxes of the detected and the decoded codes are reported in the
+    // coordinates of the full image, luma being scaled down by scale
+    void scan(
+        const uchar *luma,
+        int width,
+        int height,
+        int bytesPerLine,
+        const QPoint &offset,
+        int scale,
+        std::vector<std::string> &result,
+        std::vector<QRect> &detected,
+        QRect &decoded);
+    std::vector<std::string> scanRegion(const uchar *luma, int bytesPerLine, const QRect &region, QRect &decoded);
 
 private:
     quirc *m_qr;
+    // where the last code was found, tried first on the next frame
+    QRect m_roi;
 };
@@ -0,0 +1,348 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "FountainCode.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QStringList>
+
+namespace
+{
+
+const char FRAME_PREFIX[] = "MXF1:";
+// unsigned transactions and key images stay well below, a crafted frame
+// must not make the decoder allocate more
+const int MAX_LENGTH = 4 * 1024 * 1024;
+
+// splitmix64, the frame contents must not depend on the standard library
+class Random
+{
+public:
+    explicit Random(quint64 seed)
+        : m_state(seed)
+    {
+    }
+
+    quint64 next()
+    {
+        quint64 z = (m_state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    double nextDouble()
+    {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+private:
+    quint64 m_state;
+};
+
+void xorInto(QByteArray &target, const QByteArray &source)
+{
+    char *data = target.data();
+    const char *other = source.constData();
+    for (qsizetype index = 0; index < target.size(); ++index)
+    {
+        data[index] ^= other[index];
+    }
+}
+
+} // namespace
+
+namespace fountain
+{
+
+std::vector<int> chooseFragments(quint32 sequence, int fragmentCount, quint32 checksum)
+{
+    if (sequence < static_cast<quint32>(fragmentCount))
+    {
+        return {static_cast<int>(sequence)};
+    }
+
+    Random random((static_cast<quint64>(checksum) << 32) | sequence);
+
+    // ideal soliton-like distribution, degree d is chosen with weight 1/d
+    double total = 0;
+    for (int degree = 1; degree <= fragmentCount; ++degree)
+    {
+        total += 1.0 / degree;
+    }
+    const double target = random.nextDouble() * total;
+    int degree = 1;
+    for (double sum = 1.0; sum < target && degree < fragmentCount; sum += 1.0 / ++degree)
+    {
+    }
+
+    std::vector<int> indexes(fragmentCount);
+    for (int index = 0; index < fragmentCount; ++index)
+    {
+        indexes[index] = index;
+    }
+    for (int index = 0; index < degree; ++index)
+    {
+        const int other = index + static_cast<int>(random.next() % static_cast<quint64>(fragmentCount - index));
+        std::swap(indexes[index], indexes[other]);
+    }
+    indexes.resize(degree);
+    return indexes;
+}
+
+quint32 crc32(const QByteArray &data)
+{
+    quint32 crc = 0xffffffff;
+    for (const char byte : data)
+    {
+        crc ^= static_cast<quint8>(byte);
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+bool isFrame(const QString &text)
+{
+    return text.startsWith(QLatin1String(FRAME_PREFIX));
+}
+
+} // namespace fountain
+
+FountainEncoder::FountainEncoder(const QByteArray &data, int fragmentSize)
+    : m_length(data.size())
+    , m_checksum(fountain::crc32(data))
+{
+    fragmentSize = std::max(1, fragmentSize);
+    for (qsizetype offset = 0; offset < std::max<qsizetype>(data.size(), 1); offset += fragmentSize)
+    {
+        QByteArray fragment = data.mid(offset, fragmentSize);
+        fragment.append(fragmentSize - fragment.size(), '\0');
+        m_fragments.append(fragment);
+    }
+}
+
+int FountainEncoder::fragmentCount() const
+{
+    return m_fragments.size();
+}
+
+QString FountainEncoder::frame(quint32 sequence) const
+{
+    const std::vector<int> indexes = fountain::chooseFragments(sequence, m_fragments.size(), m_checksum);
+    QByteArray payload = m_fragments[indexes.front()];
+    for (size_t index = 1; index < indexes.size(); ++index)
+    {
+        xorInto(payload, m_fragments[indexes[index]]);
+    }
+
+    return QString("%1%2:%3:%4:%5:%6")
+        .arg(QLatin1String(FRAME_PREFIX))
+        .arg(sequence)
+        .arg(m_fragments.size())
+        .arg(m_length)
+        .arg(m_checksum, 8, 16, QLatin1Char('0'))
+        .arg(QString::fromLatin1(payload.toBase64()));
+}
+
+FountainDecoder::FountainDecoder()
+{
+    reset();
+}
+
+void FountainDecoder::reset()
+{
+    m_fragmentCount = 0;
+    m_fragmentSize = 0;
+    m_length = 0;
+    m_checksum = 0;
+    m_fragments.clear();
+    m_received = 0;
+    m_mixed.clear();
+    m_sequences.clear();
+    m_data.clear();
+}
+
+bool FountainDecoder::receive(const QString &frame)
+{
+    if (!fountain::isFrame(frame))
+    {
+        return false;
+    }
+
+    const QStringList fields = frame.mid(sizeof(FRAME_PREFIX) - 1).split(':');
+    if (fields.size() != 5)
+    {
+        return false;
+    }
+    bool sequenceOk, countOk, lengthOk, checksumOk;
+    const quint32 sequence = fields[0].toUInt(&sequenceOk);
+    const int fragmentCount = fields[1].toInt(&countOk);
+    const int length = fields[2].toInt(&lengthOk);
+    const quint32 checksum = fields[3].toUInt(&checksumOk, 16);
+    const QByteArray payload = QByteArray::fromBase64(fields[4].toLatin1());
+    if (!sequenceOk || !countOk || !lengthOk || !checksumOk || length < 0 || length > MAX_LENGTH || payload.isEmpty())
+    {
+        return false;
+    }
+    // the encoder emits a single fragment for empty data
+    const qint64 expectedCount = std::max<qint64>(1, (static_cast<qint64>(length) + payload.size() - 1) / payload.size());
+    if (fragmentCount != expectedCount)
+    {
+        return false;
+    }
+
+    if (fragmentCount != m_fragmentCount || length != m_length || checksum != m_checksum || payload.size() != m_fragmentSize)
+    {
+        reset();
+        m_fragmentCount = fragmentCount;
+        m_fragmentSize = payload.size();
+        m_length = length;
+        m_checksum = checksum;
+        for (int index = 0; index < fragmentCount; ++index)
+        {
+            m_fragments.append(QByteArray());
+        }
+    }
+
+    if (complete() || m_sequences.contains(sequence))
+    {
+        return true;
+    }
+    m_sequences.insert(sequence);
+
+    const std::vector<int> indexes = fountain::chooseFragments(sequence, fragmentCount, checksum);
+    Part part{std::set<int>(indexes.begin(), indexes.end()), payload};
+    reduce(part);
+    if (!part.indexes.empty())
+    {
+        solve(std::move(part));
+    }
+
+    if (m_received == m_fragmentCount)
+    {
+        QByteArray data;
+        for (const QByteArray &fragment : m_fragments)
+        {
+            data.append(fragment);
+        }
+        data.truncate(m_length);
+        if (fountain::crc32(data) != m_checksum)
+        {
+            qWarning() << "Fountain QR transfer failed the checksum, starting over";
+            reset();
+            return true;
+        }
+        m_data = data;
+    }
+    return true;
+}
+
+void FountainDecoder::reduce(Part &part) const
+{
+    for (auto it = part.indexes.begin(); it != part.indexes.end();)
+    {
+        const QByteArray &fragment = m_fragments[*it];
+        if (fragment.isNull())
+        {
+            ++it;
+            continue;
+        }
+        xorInto(part.data, fragment);
+        it = part.indexes.erase(it);
+    }
+}
+
+// peels every part down to single fragments as far as possible
+void FountainDecoder::solve(Part part)
+{
+    std::vector<Part> simple;
+    if (part.indexes.size() == 1)
+    {
+        simple.push_back(std::move(part));
+    }
+    else
+    {
+        m_mixed.push_back(std::move(part));
+    }
+
+    while (!simple.empty())
+    {
+        Part solved = std::move(simple.back());
+        simple.pop_back();
+        const int index = *solved.indexes.begin();
+        if (!m_fragments[index].isNull())
+        {
+            continue;
+        }
+        m_fragments[index] = solved.data;
+        ++m_received;
+
+        for (auto it = m_mixed.begin(); it != m_mixed.end();)
+        {
+            if (it->indexes.erase(index) != 0)
+            {
+                xorInto(it->data, solved.data);
+            }
+            if (it->indexes.size() <= 1)
+            {
+                if (it->indexes.size() == 1)
+                {
+                    simple.push_back(std::move(*it));
+                }
+                it = m_mixed.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+}
+
+bool FountainDecoder::complete() const
+{
+    return !m_data.isNull();
+}
+
+QByteArray FountainDecoder::data() const
+{
+    return m_data;
+}
+
+int FountainDecoder::receivedFragments() const
+{
+    return m_received;
+}
+
+int FountainDecoder::fragmentCount() const
+{
+    return m_fragmentCount;
+}
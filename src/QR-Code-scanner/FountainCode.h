@@ -0,0 +1,107 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _FOUNTAINCODE_H_
+#define _FOUNTAINCODE_H_
+
+#include <set>
+#include <vector>
+
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+// Fountain code for moving data too large for one QR code as an animated
+// sequence of QR frames. The first frames carry the fragments as they are,
+// every later frame is the XOR of a pseudo-randomly chosen set of fragments,
+// so the receiver can reassemble the data from any sufficiently large set of
+// frames in any order. Frames are text:
+//   MXF1:<sequence>:<fragment count>:<data length>:<crc32>:<base64 payload>
+namespace fountain
+{
+    // fragment indexes mixed into the frame with the given sequence number
+    std::vector<int> chooseFragments(quint32 sequence, int fragmentCount, quint32 checksum);
+    quint32 crc32(const QByteArray &data);
+    bool isFrame(const QString &text);
+}
+
+class FountainEncoder
+{
+public:
+    explicit FountainEncoder(const QByteArray &data, int fragmentSize = 200);
+
+    int fragmentCount() const;
+    // sequence numbers below fragmentCount() are plain fragments, any
+    // number above produces another mixed frame
+    QString frame(quint32 sequence) const;
+
+private:
+    QList<QByteArray> m_fragments;
+    int m_length;
+    quint32 m_checksum;
+};
+
+class FountainDecoder
+{
+public:
+    FountainDecoder();
+
+    // a frame of a different transfer starts over, returns false for text
+    // that isn't a valid frame
+    bool receive(const QString &frame);
+    void reset();
+
+    bool complete() const;
+    QByteArray data() const;
+    int receivedFragments() const;
+    int fragmentCount() const;
+
+private:
+    struct Part
+    {
+        std::set<int> indexes;
+        QByteArray data;
+    };
+
+    void reduce(Part &part) const;
+    void solve(Part part);
+
+private:
+    int m_fragmentCount;
+    qsizetype m_fragmentSize;
+    int m_length;
+    quint32 m_checksum;
+    QList<QByteArray> m_fragments;
+    int m_received;
+    std::vector<Part> m_mixed;
+    QSet<quint32> m_sequences;
+    QByteArray m_data;
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include "QrCodeScanner.h"
 #include <QVideoProbe>
 #include <QCamera>
+#include <QDebug>
 
 QrCodeScanner::QrCodeScanner(QObject *parent)
     : QObject(parent)
@@ -41,11 +42,23 @@ QrCodeScanner::QrCodeScanner(QObject *parent)
     m_thread->start();
     QObject::connect(m_thread, SIGNAL(decoded(QString)), this, SIGNAL(decoded(QString)));
     QObject::connect(m_thread, SIGNAL(notifyError(const QString &, bool)), this, SIGNAL(notifyError(const QString &, bool)));
+    QObject::connect(m_thread, SIGNAL(fountainProgress(int, int)), this, SIGNAL(fountainProgress(int, int)));
+    QObject::connect(m_thread, SIGNAL(fountainDecoded(const QByteArray &)), this, SIGNAL(fountainDecoded(const QByteArray &)));
+    // an animated code shows a new frame several times a second, sample
+    // faster while one is being received
+    connect(m_thread, &QrScanThread::fountainProgress, this, [this] { setProcessInterval(150); });
+    connect(m_thread, &QrScanThread::fountainDecoded, this, [this] { setProcessInterval(750); });
     connect(m_probe, SIGNAL(videoFrameProbed(QVideoFrame)), this, SLOT(processFrame(QVideoFrame)));
 }
-void QrCodeScanner::setSource(QCamera *camera)
+void QrCodeScanner::setSource(QObject *camera)
 {
-    m_probe->setSource(camera);
+    QCamera *source = qobject_cast<QCamera *>(camera);
+    if (!source)
+    {
+        qWarning() << "QrCodeScanner: no camera to scan from";
+        return;
+    }
+    m_probe->setSource(source);
 }
 void QrCodeScanner::processFrame(QVideoFrame frame)
 {
@@ -71,6 +84,17 @@ void QrCodeScanner::setEnabled(bool enabled)
     }
     emit enabledChanged();
 }
+void QrCodeScanner::setProcessInterval(int interval)
+{
+    if (m_processInterval == interval)
+        return;
+    m_processInterval = interval;
+    if (m_processTimerId != -1)
+    {
+        this->killTimer(m_processTimerId);
+        m_processTimerId = this->startTimer(m_processInterval);
+    }
+}
 void QrCodeScanner::timerEvent(QTimerEvent *event)
 {
     if( (event->timerId() == m_processTimerId) ){
@@ -45,7 +45,8 @@ class QrCodeScanner : public QObject
 public:
     QrCodeScanner(QObject *parent = Q_NULLPTR);
     ~QrCodeScanner();
-    void setSource(QCamera*);
+    //! camera is the mediaObject of a QML Camera
+    Q_INVOKABLE void setSource(QObject *camera);
 
     bool enabled() const;
     void setEnabled(bool enabled);
@@ -58,9 +59,12 @@ Q_SIGNALS:
 
     void decoded(const QString &data);
     void notifyError(const QString &error, bool warning = false);
+    void fountainProgress(int received, int total);
+    void fountainDecoded(const QByteArray &data);
 
 protected:
     void timerEvent(QTimerEvent *);
+    void setProcessInterval(int interval);
     QrScanThread *m_thread;
     int m_processTimerId;
     int m_processInterval;
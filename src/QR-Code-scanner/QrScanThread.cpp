@@ -37,34 +37,123 @@ extern QImage qt_imageFromVideoFrame(const QVideoFrame &f);
 QrScanThread::QrScanThread(QObject *parent)
       : QThread(parent)
        ,m_running(true)
+       ,m_hasPendingFrame(false)
 {
 }
 
-void QrScanThread::processQImage(const QImage &qimg)
+void QrScanThread::emitDecoded(const std::vector<std::string> &codes)
 {
-    try {
-        for (const std::string &code : m_decoder.decode(qimg))
+    for (const std::string &code : codes)
+    {
+        const QString text = QString::fromStdString(code);
+        if (!fountain::isFrame(text))
+        {
+            emit decoded(text);
+            continue;
+        }
+
+        // frames arrive in any order, duplicates are ignored
+        const bool wasComplete = m_fountain.complete();
+        if (!m_fountain.receive(text))
         {
-            emit decoded(QString::fromStdString(code));
+            continue;
+        }
+        emit fountainProgress(m_fountain.receivedFragments(), m_fountain.fragmentCount());
+        if (m_fountain.complete() && !wasComplete)
+        {
+            emit fountainDecoded(m_fountain.data());
         }
     }
+}
+
+void QrScanThread::processQImage(const QImage &qimg)
+{
+    try {
+        emitDecoded(m_decoder.decode(qimg));
+    }
     catch(std::exception &e) {
         qDebug() << "ERROR: " << e.what();
         emit notifyError(e.what());
     }
 }
 
+// Planar and semi-planar YUV frames start with a full resolution Y plane,
+// which is the grayscale image quirc wants
+bool QrScanThread::processLumaPlane(const QVideoFrame &frame)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    switch (frame.pixelFormat())
+    {
+    case QVideoFrameFormat::Format_NV12:
+    case QVideoFrameFormat::Format_NV21:
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YUV422P:
+    case QVideoFrameFormat::Format_YV12:
+    case QVideoFrameFormat::Format_IMC1:
+    case QVideoFrameFormat::Format_IMC2:
+    case QVideoFrameFormat::Format_IMC3:
+    case QVideoFrameFormat::Format_IMC4:
+    case QVideoFrameFormat::Format_Y8:
+        break;
+    default:
+        return false;
+    }
+    const auto readOnly = QVideoFrame::ReadOnly;
+#else
+    switch (frame.pixelFormat())
+    {
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+    case QVideoFrame::Format_IMC1:
+    case QVideoFrame::Format_IMC2:
+    case QVideoFrame::Format_IMC3:
+    case QVideoFrame::Format_IMC4:
+    case QVideoFrame::Format_Y8:
+        break;
+    default:
+        return false;
+    }
+    const auto readOnly = QAbstractVideoBuffer::ReadOnly;
+#endif
+
+    QVideoFrame mapped(frame);
+    if (!mapped.map(readOnly))
+    {
+        return false;
+    }
+
+    try {
+        emitDecoded(m_decoder.decodeLuma(mapped.bits(0), mapped.width(), mapped.height(), mapped.bytesPerLine(0)));
+    }
+    catch(std::exception &e) {
+        qDebug() << "ERROR: " << e.what();
+        emit notifyError(e.what());
+    }
+    mapped.unmap();
+    return true;
+}
+
 void QrScanThread::processVideoFrame(const QVideoFrame &frame)
 {
+    if (processLumaPlane(frame))
+    {
+        return;
+    }
+
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
     processQImage( qt_imageFromVideoFrame(frame) );
-#else
+#elif QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
     processQImage(frame.image());
+#else
+    processQImage(frame.toImage());
 #endif
 }
 
 void QrScanThread::stop()
 {
+    QMutexLocker locker(&m_mutex);
     m_running = false;
     m_waitCondition.wakeOne();
 }
@@ -72,19 +161,26 @@ void QrScanThread::stop()
 void QrScanThread::addFrame(const QVideoFrame &frame)
 {
     QMutexLocker locker(&m_mutex);
-    m_queue.append(frame);
+    m_pendingFrame = frame;
+    m_hasPendingFrame = true;
     m_waitCondition.wakeOne();
 }
 
 void QrScanThread::run()
 {
-    QVideoFrame frame;
     while(m_running) {
-        QMutexLocker locker(&m_mutex);
-        while(m_queue.isEmpty() && m_running)
-            m_waitCondition.wait(&m_mutex);
-        if(!m_queue.isEmpty())
-            processVideoFrame(m_queue.takeFirst());
+        QVideoFrame frame;
+        {
+            QMutexLocker locker(&m_mutex);
+            while(!m_hasPendingFrame && m_running)
+                m_waitCondition.wait(&m_mutex);
+            if(!m_running)
+                break;
+            frame = std::move(m_pendingFrame);
+            m_pendingFrame = QVideoFrame();
+            m_hasPendingFrame = false;
+        }
+        // decoding doesn't block addFrame()
+        processVideoFrame(frame);
     }
 }
-
@@ -29,6 +29,8 @@
 #ifndef _QRSCANTHREAD_H_
 #define _QRSCANTHREAD_H_
 
+#include <atomic>
+
 #include <QThread>
 #include <QMutex>
 #include <QWaitCondition>
@@ -37,6 +39,7 @@
 #include <QCamera>
 
 #include "Decoder.h"
+#include "FountainCode.h"
 
 class QrScanThread : public QThread
 {
@@ -50,17 +53,25 @@ public:
 Q_SIGNALS:
     void decoded(const QString &data);
     void notifyError(const QString &error, bool warning = false);
+    // animated multi-frame codes
+    void fountainProgress(int received, int total);
+    void fountainDecoded(const QByteArray &data);
 
 protected:
     virtual void run();
     void processVideoFrame(const QVideoFrame &);
+    bool processLumaPlane(const QVideoFrame &);
     void processQImage(const QImage &);
+    void emitDecoded(const std::vector<std::string> &codes);
 
 private:
     QrDecoder m_decoder;
-    bool m_running;
+    FountainDecoder m_fountain;
+    std::atomic<bool> m_running;
     QMutex m_mutex;
     QWaitCondition m_waitCondition;
-    QList<QVideoFrame> m_queue;
+    // latest frame wins, frames arriving during a decode replace each other
+    QVideoFrame m_pendingFrame;
+    bool m_hasPendingFrame;
 };
 #endif
@@ -39,16 +39,27 @@ TranslationManager * TranslationManager::m_instance = nullptr;
 
 
 TranslationManager::TranslationManager(QObject *parent) : QObject(parent)
+    , m_translator(nullptr)
+    , m_language("en")
 {
-    m_translator = new QTranslator(this);
 }
 
 bool TranslationManager::setLanguage(const QString &language)
 {
     qDebug() << __FUNCTION__ << " " << language;
+    // every qsTr binding is evaluated again on a change, skip no-op switches
+    if (language.compare(m_language, Qt::CaseInsensitive) == 0) {
+        return true;
+    }
+
     // if language is "en", remove translator
     if (language.toLower() == "en") {
-        qApp->removeTranslator(m_translator);
+        if (m_translator) {
+            qApp->removeTranslator(m_translator);
+            m_translator->deleteLater();
+            m_translator = nullptr;
+        }
+        m_language = language;
         emit languageChanged();
         return true;
     }
@@ -59,12 +70,13 @@ bool TranslationManager::setLanguage(const QString &language)
     qDebug("%s: loading translation file '%s' from '%s'",
            __FUNCTION__, qPrintable(filename), qPrintable(dir));
 
-    if (m_translator->load(filename, dir)) {
+    // only the active catalog is kept, the current one stays installed until its replacement loaded
+    QTranslator *translator = new QTranslator(this);
+    if (translator->load(filename, dir)) {
         qDebug("%s: translation for language '%s' loaded successfully",
                __FUNCTION__, qPrintable(language));
         // TODO: apply locale?
-        qApp->installTranslator(m_translator);
-        emit languageChanged();
+        installTranslator(translator, language);
         return true;
     }
 
@@ -73,19 +85,32 @@ bool TranslationManager::setLanguage(const QString &language)
     qDebug("%s: loading embedded translation file '%s'",
            __FUNCTION__, qPrintable(filename));
 
-    if (m_translator->load(filename, ":")) {
+    // the catalogs are stored uncompressed, QTranslator reads them in place from the resource data
+    if (translator->load(filename, ":")) {
         qDebug("%s: embedded translation for language '%s' loaded successfully",
                __FUNCTION__, qPrintable(language));
-        qApp->installTranslator(m_translator);
-        emit languageChanged();
+        installTranslator(translator, language);
         return true;
     }
 
+    delete translator;
     qCritical("%s: error loading translation for language '%s'",
               __FUNCTION__, qPrintable(language));
     return false;
 }
 
+void TranslationManager::installTranslator(QTranslator *translator, const QString &language)
+{
+    qApp->installTranslator(translator);
+    if (m_translator) {
+        qApp->removeTranslator(m_translator);
+        m_translator->deleteLater();
+    }
+    m_translator = translator;
+    m_language = language;
+    emit languageChanged();
+}
+
 TranslationManager *TranslationManager::instance()
 {
     if (!m_instance) {
@@ -30,6 +30,7 @@
 #define TRANSLATIONMANAGER_H
 
 #include <QObject>
+#include <QString>
 
 class QTranslator;
 class TranslationManager : public QObject
@@ -47,10 +48,12 @@ signals:
 
 private:
     explicit TranslationManager(QObject *parent = 0);
+    void installTranslator(QTranslator *translator, const QString &language);
 
 private:
     static TranslationManager * m_instance;
     QTranslator * m_translator;
+    QString m_language;
 
 };
 
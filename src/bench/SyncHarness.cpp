@@ -0,0 +1,571 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SyncHarness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+
+#include <wallet/api/wallet2_api.h>
+
+#include "SubaddressModel.h"
+#include "SyncProfile.h"
+#include "TransactionHistory.h"
+#include "TransactionHistoryModel.h"
+#include "TransactionHistorySortFilterModel.h"
+#include "Wallet.h"
+#include "qt/ScopeGuard.h"
+
+namespace
+{
+
+// regtest keeps mainnet's unlock windows
+const int COINBASE_UNLOCK_BLOCKS = 60;
+const int TRANSFER_UNLOCK_BLOCKS = 10;
+// ring size 16
+const uint32_t MIXIN = 15;
+// blocks per generateblocks call
+const quint64 GENERATE_BATCH = 1000;
+const std::chrono::milliseconds RPC_TIMEOUT = std::chrono::minutes(10);
+const char FIXTURE_FILE[] = "fixture.json";
+
+QJsonObject toJson(const QHash<QString, qint64> &counters)
+{
+    QJsonObject object;
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it)
+    {
+        object.insert(it.key(), it.value());
+    }
+    return object;
+}
+
+} // namespace
+
+SyncHarness::SyncHarness(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    // DaemonManager::stopAsync takes a JS callback, the engine must not own us
+    QJSEngine::setObjectOwnership(this, QJSEngine::CppOwnership);
+    m_engine.globalObject().setProperty("harness", m_engine.newQObject(this));
+
+    m_rpcClient.set_server("127.0.0.1", std::to_string(m_options.rpcPort), {}, epee::net_utils::ssl_support_t::e_ssl_support_disabled);
+
+    m_timeout.setSingleShot(true);
+    connect(&m_timeout, &QTimer::timeout, this, [this] {
+        fail(QString("not synchronized after %1 seconds").arg(m_options.timeoutSeconds));
+    });
+}
+
+SyncHarness::~SyncHarness() = default;
+
+void SyncHarness::start()
+{
+    QString error;
+    if (!m_options.prepare && !loadFixture(error))
+    {
+        fail(error);
+        return;
+    }
+
+    // emitted from DaemonManager's watcher thread
+    connect(&m_daemonManager, &DaemonManager::daemonStarted, this, &SyncHarness::daemonStarted, Qt::QueuedConnection);
+    connect(&m_daemonManager, &DaemonManager::daemonStartFailure, this, [this](const QString &error) {
+        fail("monerod failed to start: " + error);
+    }, Qt::QueuedConnection);
+    m_daemonManager.start(daemonFlags(), NetworkType::MAINNET, chainDir());
+}
+
+void SyncHarness::daemonStarted()
+{
+    m_daemonRunning = true;
+    if (m_finishing)
+    {
+        return;
+    }
+
+    if (!m_options.prepare)
+    {
+        if (m_options.baseline)
+        {
+            runBaseline();
+        }
+        else
+        {
+            runGui();
+        }
+        return;
+    }
+
+    QString error;
+    if (!prepare(error))
+    {
+        fail(error);
+        return;
+    }
+    finish(0);
+}
+
+bool SyncHarness::prepare(QString &error)
+{
+    Monero::WalletManager *manager = Monero::WalletManagerFactory::getWalletManager();
+
+    // wallets of an earlier preparation belong to the chain monerod just reset
+    QDir(m_options.dataDir).mkpath("wallets");
+    for (const QString &name : {QStringLiteral("bench"), QStringLiteral("miner")})
+    {
+        QFile::remove(walletPath(name));
+        QFile::remove(walletPath(name) + ".keys");
+    }
+
+    Monero::Wallet *bench = manager->createWallet(walletPath("bench").toStdString(), "", "English", Monero::MAINNET, 1);
+    if (bench->status() != Monero::Wallet::Status_Ok)
+    {
+        error = "failed to create the bench wallet: " + QString::fromStdString(bench->errorString());
+        manager->closeWallet(bench, false);
+        return false;
+    }
+    // the height estimated for a new mainnet wallet is far past the regtest chain
+    bench->setRefreshFromBlockHeight(0);
+    std::vector<std::string> addresses;
+    for (int i = 1; i <= m_options.subaddresses; ++i)
+    {
+        bench->addSubaddress(0, "bench #" + std::to_string(i));
+        addresses.push_back(bench->address(0, i));
+    }
+    if (addresses.empty())
+    {
+        addresses.push_back(bench->address(0, 0));
+    }
+    // stored without a refresh, so every run scans the whole chain
+    manager->closeWallet(bench, true);
+
+    Monero::Wallet *miner = manager->createWallet(walletPath("miner").toStdString(), "", "English", Monero::MAINNET, 1);
+    const auto closeMiner = sg::make_scope_guard([manager, miner]() noexcept {
+        manager->closeWallet(miner, true);
+    });
+    if (miner->status() != Monero::Wallet::Status_Ok)
+    {
+        error = "failed to create the miner wallet: " + QString::fromStdString(miner->errorString());
+        return false;
+    }
+    miner->setRefreshFromBlockHeight(0);
+    if (!miner->init(daemonAddress().toStdString(), 0, "", "", false, false, ""))
+    {
+        error = "failed to connect the miner wallet: " + QString::fromStdString(miner->errorString());
+        return false;
+    }
+    miner->setTrustedDaemon(true);
+    const std::string minerAddress = miner->address(0, 0);
+
+    // a coinbase output per transaction, all unlocked by the time they're spent
+    qInfo("mining %d blocks", m_options.transactions + COINBASE_UNLOCK_BLOCKS);
+    if (!generateBlocks(m_options.transactions + COINBASE_UNLOCK_BLOCKS, minerAddress, error))
+    {
+        return false;
+    }
+    miner->refresh();
+
+    for (int i = 0; i < m_options.transactions; ++i)
+    {
+        // 0.01 to 1 XMR
+        const uint64_t amount = static_cast<uint64_t>(1 + i % 100) * 10000000000ULL;
+        bool sent = false;
+        QString sendError;
+        // short of unlocked outputs, mined change unlocks after TRANSFER_UNLOCK_BLOCKS
+        for (int attempt = 0; !sent && attempt <= COINBASE_UNLOCK_BLOCKS / TRANSFER_UNLOCK_BLOCKS; ++attempt)
+        {
+            if (attempt > 0)
+            {
+                if (!generateBlocks(TRANSFER_UNLOCK_BLOCKS, minerAddress, error))
+                {
+                    return false;
+                }
+                miner->refresh();
+            }
+
+            Monero::PendingTransaction *tx = miner->createTransaction(addresses[i % addresses.size()], "",
+                Monero::optional<uint64_t>(amount), MIXIN, Monero::PendingTransaction::Priority_Default, 0, {});
+            sent = tx->status() == Monero::PendingTransaction::Status_Ok && tx->commit();
+            if (!sent)
+            {
+                sendError = QString::fromStdString(tx->errorString());
+            }
+            miner->disposeTransaction(tx);
+        }
+        if (!sent)
+        {
+            error = QString("transaction %1 failed: %2").arg(i).arg(sendError);
+            return false;
+        }
+
+        if ((i + 1) % m_options.transactionsPerBlock == 0)
+        {
+            if (!generateBlocks(1, minerAddress, error))
+            {
+                return false;
+            }
+            miner->refresh();
+        }
+        if ((i + 1) % 100 == 0)
+        {
+            qInfo("sent %d of %d transactions", i + 1, m_options.transactions);
+        }
+    }
+
+    // every transfer mined and unlocked below the tip
+    if (!generateBlocks(TRANSFER_UNLOCK_BLOCKS, minerAddress, error))
+    {
+        return false;
+    }
+
+    const quint64 height = daemonHeight();
+    const QJsonObject fixture{
+        {"transactions", m_options.transactions},
+        {"subaddresses", m_options.subaddresses},
+        {"height", static_cast<qint64>(height)},
+    };
+    QFile file(QDir(m_options.dataDir).filePath(FIXTURE_FILE));
+    if (height == 0 || !file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(QJsonDocument(fixture).toJson()) < 0)
+    {
+        error = QString("failed to write %1").arg(file.fileName());
+        return false;
+    }
+    qInfo("prepared %d transactions over %d subaddresses up to height %llu", m_options.transactions, m_options.subaddresses, height);
+    return true;
+}
+
+bool SyncHarness::loadFixture(QString &error)
+{
+    QFile file(QDir(m_options.dataDir).filePath(FIXTURE_FILE));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QString("%1 is not prepared, run with --prepare first").arg(m_options.dataDir);
+        return false;
+    }
+    const QJsonObject fixture = QJsonDocument::fromJson(file.readAll()).object();
+    m_transactions = fixture.value("transactions").toInt();
+    m_subaddresses = fixture.value("subaddresses").toInt();
+    m_targetHeight = fixture.value("height").toInteger();
+    if (m_targetHeight == 0)
+    {
+        error = QString("%1 is not a fixture").arg(file.fileName());
+        return false;
+    }
+
+    // every run starts over from the wallet as prepared
+    if (!m_runDir.isValid())
+    {
+        error = "failed to create a temporary directory";
+        return false;
+    }
+    for (const QString &suffix : {QString(), QStringLiteral(".keys")})
+    {
+        if (!QFile::copy(walletPath("bench") + suffix, m_runDir.filePath("bench") + suffix))
+        {
+            error = QString("failed to copy %1").arg(walletPath("bench") + suffix);
+            return false;
+        }
+    }
+    return true;
+}
+
+void SyncHarness::runGui()
+{
+    m_startCpuMs = SyncProfile::processCpuMs();
+    m_timer.start();
+    m_wallet = m_walletManager.openWallet(m_runDir.filePath("bench"), "", NetworkType::MAINNET, 1);
+    m_openMs = m_timer.elapsed();
+    if (!m_wallet || m_wallet->status() != Wallet::Status_Ok)
+    {
+        fail("failed to open the wallet: " + (m_wallet ? m_wallet->errorString() : QString()));
+        return;
+    }
+
+    const auto counter = [](QHash<QString, qint64> &counters, const QString &name) {
+        return [&counters, name] {
+            ++counters[name];
+        };
+    };
+
+    connect(m_wallet, &Wallet::newBlock, this, counter(m_signals, "newBlock"));
+    connect(m_wallet, &Wallet::refreshed, this, counter(m_signals, "refreshed"));
+    connect(m_wallet, &Wallet::updated, this, counter(m_signals, "updated"));
+    connect(m_wallet, &Wallet::moneyReceived, this, counter(m_signals, "moneyReceived"));
+    connect(m_wallet, &Wallet::unconfirmedMoneyReceived, this, counter(m_signals, "unconfirmedMoneyReceived"));
+    connect(m_wallet, &Wallet::moneySpent, this, counter(m_signals, "moneySpent"));
+
+    TransactionHistory *history = m_wallet->history();
+    connect(history, &TransactionHistory::refreshFinished, this, counter(m_signals, "history.refreshFinished"));
+    connect(history, &TransactionHistory::transactionsInserted, this, counter(m_signals, "history.transactionsInserted"));
+    connect(history, &TransactionHistory::transactionsChanged, this, counter(m_signals, "history.transactionsChanged"));
+    connect(history, &TransactionHistory::aggregatesChanged, this, counter(m_signals, "history.aggregatesChanged"));
+
+    // the models the GUI binds while syncing
+    TransactionHistorySortFilterModel *historyModel = m_wallet->historyModel();
+    const std::pair<QAbstractItemModel *, QString> models[] = {
+        {historyModel->sourceModel(), "historyModel"},
+        {historyModel, "historySortFilterModel"},
+        {m_wallet->subaddressModel(), "subaddressModel"},
+    };
+    for (const auto &model : models)
+    {
+        connect(model.first, &QAbstractItemModel::modelReset, this, counter(m_modelResets, model.second + ".modelReset"));
+        connect(model.first, &QAbstractItemModel::layoutChanged, this, counter(m_modelResets, model.second + ".layoutChanged"));
+        connect(model.first, &QAbstractItemModel::rowsInserted, this, counter(m_signals, model.second + ".rowsInserted"));
+        connect(model.first, &QAbstractItemModel::dataChanged, this, counter(m_signals, model.second + ".dataChanged"));
+    }
+
+    connect(m_wallet, &Wallet::updated, this, &SyncHarness::checkSynchronized, Qt::QueuedConnection);
+    connect(history, &TransactionHistory::transactionsInserted, this, &SyncHarness::checkSynchronized, Qt::QueuedConnection);
+
+    m_timeout.start(m_options.timeoutSeconds * 1000);
+    // trusted, as a local node is
+    m_wallet->initAsync(daemonAddress(), true, 0, false, false, 0, "");
+}
+
+void SyncHarness::runBaseline()
+{
+    // wallet2 on its own, the same open and refresh without the GUI's wrapper
+    Monero::WalletManager *manager = Monero::WalletManagerFactory::getWalletManager();
+    m_startCpuMs = SyncProfile::processCpuMs();
+    m_timer.start();
+    Monero::Wallet *wallet = manager->openWallet(m_runDir.filePath("bench").toStdString(), "", Monero::MAINNET, 1, nullptr);
+    m_openMs = m_timer.elapsed();
+    const auto close = sg::make_scope_guard([manager, wallet]() noexcept {
+        manager->closeWallet(wallet, false);
+    });
+    if (wallet->status() != Monero::Wallet::Status_Ok)
+    {
+        fail("failed to open the wallet: " + QString::fromStdString(wallet->errorString()));
+        return;
+    }
+    if (!wallet->init(daemonAddress().toStdString(), 0, "", "", false, false, ""))
+    {
+        fail("failed to connect the wallet: " + QString::fromStdString(wallet->errorString()));
+        return;
+    }
+    wallet->setTrustedDaemon(true);
+
+    // a refresh stops at the daemon height as of its start
+    while (wallet->blockChainHeight() < m_targetHeight)
+    {
+        if (!wallet->refresh())
+        {
+            fail("refresh failed: " + QString::fromStdString(wallet->errorString()));
+            return;
+        }
+    }
+    wallet->history()->refresh();
+
+    report(wallet->blockChainHeight(), wallet->history()->count());
+    finish(0);
+}
+
+void SyncHarness::checkSynchronized()
+{
+    if (m_finishing || !m_wallet)
+    {
+        return;
+    }
+
+    // the history follows the wallet by a queued refresh
+    const qint64 rows = m_wallet->history()->rows().size();
+    if (!m_wallet->synchronized() || rows < m_transactions)
+    {
+        return;
+    }
+
+    report(m_targetHeight, rows);
+    finish(0);
+}
+
+void SyncHarness::report(quint64 height, qint64 historyRows)
+{
+    const QJsonObject line{
+        {"mode", m_options.baseline ? "wallet2" : "gui"},
+        {"transactions", m_transactions},
+        {"subaddresses", m_subaddresses},
+        {"blocks", static_cast<qint64>(height)},
+        {"historyRows", historyRows},
+        {"openMs", m_openMs},
+        {"wallMs", m_timer.elapsed()},
+        {"cpuMs", SyncProfile::processCpuMs() - m_startCpuMs},
+        {"peakRssKb", SyncProfile::peakRssKb()},
+        {"signals", toJson(m_signals)},
+        {"modelResets", toJson(m_modelResets)},
+    };
+
+    const QByteArray json = QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n';
+    std::fwrite(json.constData(), 1, json.size(), stdout);
+    std::fflush(stdout);
+}
+
+void SyncHarness::fail(const QString &error)
+{
+    qCritical().noquote() << error;
+    finish(1);
+}
+
+void SyncHarness::finish(int exitCode)
+{
+    if (m_finishing)
+    {
+        return;
+    }
+    m_finishing = true;
+    m_exitCode = exitCode;
+    m_timeout.stop();
+
+    if (m_wallet)
+    {
+        m_walletManager.closeWallet();
+        m_wallet = nullptr;
+    }
+
+    if (!m_daemonRunning)
+    {
+        QMetaObject::invokeMethod(qApp, [exitCode] {
+            QCoreApplication::exit(exitCode);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // the chain stays in the data dir for the next run
+    m_daemonManager.stopAsync(NetworkType::MAINNET, chainDir(), m_engine.evaluate("(function() { harness.daemonStopped(); })"));
+}
+
+void SyncHarness::daemonStopped()
+{
+    QCoreApplication::exit(m_exitCode);
+}
+
+QString SyncHarness::chainDir() const
+{
+    return QDir(m_options.dataDir).filePath("chain");
+}
+
+QString SyncHarness::walletPath(const QString &name) const
+{
+    return QDir(m_options.dataDir).filePath("wallets/" + name);
+}
+
+QString SyncHarness::daemonAddress() const
+{
+    return QString("127.0.0.1:%1").arg(m_options.rpcPort);
+}
+
+QString SyncHarness::daemonFlags() const
+{
+    QStringList flags = {
+        "--regtest",
+        "--offline",
+        "--fixed-difficulty", "1",
+        "--no-igd",
+        "--no-zmq",
+        "--rpc-bind-ip", "127.0.0.1",
+        "--rpc-bind-port", QString::number(m_options.rpcPort),
+        "--p2p-bind-port", QString::number(m_options.rpcPort - 1),
+        "--log-level", "0",
+    };
+    // monerod resets a fakechain on start unless told otherwise
+    if (!m_options.prepare)
+    {
+        flags << "--keep-fakechain";
+    }
+    return flags.join(' ');
+}
+
+bool SyncHarness::rpc(const char *uri, const std::string &body, QJsonObject &response, QString &error)
+{
+    const epee::net_utils::http::http_response_info *info = nullptr;
+    const epee::net_utils::http::fields_list headers({{"Content-Type", "application/json"}});
+    if (!m_rpcClient.invoke(uri, "POST", body, RPC_TIMEOUT, std::addressof(info), headers) || info == nullptr)
+    {
+        error = QString("%1 failed").arg(uri);
+        return false;
+    }
+    if (info->m_response_code != 200)
+    {
+        error = QString("%1 answered %2").arg(uri).arg(info->m_response_code);
+        return false;
+    }
+    response = QJsonDocument::fromJson(QByteArray::fromStdString(info->m_body)).object();
+    return true;
+}
+
+bool SyncHarness::generateBlocks(quint64 count, const std::string &address, QString &error)
+{
+    // generateblocks is only served in regtest
+    for (quint64 generated = 0; generated < count;)
+    {
+        const quint64 batch = std::min(count - generated, GENERATE_BATCH);
+        const QJsonObject request{
+            {"jsonrpc", "2.0"},
+            {"id", "0"},
+            {"method", "generateblocks"},
+            {"params", QJsonObject{
+                {"amount_of_blocks", static_cast<qint64>(batch)},
+                {"wallet_address", QString::fromStdString(address)},
+            }},
+        };
+
+        QJsonObject response;
+        if (!rpc("/json_rpc", QJsonDocument(request).toJson(QJsonDocument::Compact).toStdString(), response, error))
+        {
+            return false;
+        }
+        if (response.contains("error"))
+        {
+            error = "generateblocks failed: " + response.value("error").toObject().value("message").toString();
+            return false;
+        }
+        generated += batch;
+    }
+    return true;
+}
+
+quint64 SyncHarness::daemonHeight()
+{
+    QJsonObject response;
+    QString error;
+    if (!rpc("/get_height", "{}", response, error))
+    {
+        qWarning().noquote() << error;
+        return 0;
+    }
+    return response.value("height").toInteger();
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SYNCHARNESS_H
+#define SYNCHARNESS_H
+
+#include <string>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJSEngine>
+#include <QJsonObject>
+#include <QObject>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <net/http.h>
+
+#include "WalletManager.h"
+#include "daemon/DaemonManager.h"
+
+class Wallet;
+
+/*!
+ * \brief Measures a wallet's sync from scratch through the GUI layer against a
+ *        regtest monerod started by DaemonManager.
+ *
+ *        Preparing mines a fakechain in the data dir with a wallet that
+ *        received transactions over subaddresses. A run keeps that chain,
+ *        copies the never refreshed wallet and drives WalletManager::openWallet,
+ *        Wallet::initAsync and the refresh loop to the tip, or wallet2 on its
+ *        own for the baseline. The result is one JSON object on stdout: wall
+ *        and CPU time, peak RSS, the wallet's signals and the model resets.
+ */
+class SyncHarness : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        QString dataDir;
+        bool prepare = false;
+        bool baseline = false;
+        int transactions = 1000;
+        int subaddresses = 100;
+        int transactionsPerBlock = 10;
+        quint16 rpcPort = 18181;
+        int timeoutSeconds = 3600;
+    };
+
+    explicit SyncHarness(const Options &options, QObject *parent = nullptr);
+    ~SyncHarness();
+
+    //! starts the daemon, the application exits with the result once it is stopped again
+    void start();
+
+    //! DaemonManager::stopAsync callback
+    Q_INVOKABLE void daemonStopped();
+
+private:
+    void daemonStarted();
+    //! mines the chain and fills the wallet, blocks the event loop meanwhile
+    bool prepare(QString &error);
+    bool loadFixture(QString &error);
+    void runGui();
+    void runBaseline();
+    void checkSynchronized();
+    void report(quint64 height, qint64 historyRows);
+    void fail(const QString &error);
+    //! stops the daemon, the application exits once it is down
+    void finish(int exitCode);
+
+    QString chainDir() const;
+    QString walletPath(const QString &name) const;
+    QString daemonAddress() const;
+    QString daemonFlags() const;
+    bool rpc(const char *uri, const std::string &body, QJsonObject &response, QString &error);
+    bool generateBlocks(quint64 count, const std::string &address, QString &error);
+    quint64 daemonHeight();
+
+private:
+    const Options m_options;
+    DaemonManager m_daemonManager;
+    WalletManager m_walletManager;
+    QJSEngine m_engine;
+    net::http::client m_rpcClient;
+    QTemporaryDir m_runDir;
+    QTimer m_timeout;
+    int m_exitCode = 0;
+    bool m_daemonRunning = false;
+    bool m_finishing = false;
+
+    // as written by the preparation
+    quint64 m_targetHeight = 0;
+    int m_transactions = 0;
+    int m_subaddresses = 0;
+
+    Wallet *m_wallet = nullptr;
+    QElapsedTimer m_timer;
+    qint64 m_startCpuMs = 0;
+    qint64 m_openMs = 0;
+    QHash<QString, qint64> m_signals;
+    QHash<QString, qint64> m_modelResets;
+};
+
+#endif // SYNCHARNESS_H
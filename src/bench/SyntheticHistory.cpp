@@ -0,0 +1,221 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SyntheticHistory.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <wallet/api/wallet2_api.h>
+
+#include "TransactionHistory.h"
+
+namespace
+{
+
+const uint64_t FIRST_HEIGHT = 3000000;
+const std::time_t FIRST_TIMESTAMP = 1700000000;
+// a few rows per block, about the density of a busy merchant wallet
+const int ROWS_PER_BLOCK = 4;
+const uint32_t SUBADDRESSES = 20;
+
+uint64_t mix(uint64_t value)
+{
+    // splitmix64, stable hashes and amounts without a random source
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+std::string hex(uint64_t seed, int words)
+{
+    std::string out;
+    char word[17];
+    for (int i = 0; i < words; ++i)
+    {
+        seed = mix(seed);
+        std::snprintf(word, sizeof(word), "%016" PRIx64, seed);
+        out += word;
+    }
+    return out;
+}
+
+class SyntheticTransaction : public Monero::TransactionInfo
+{
+public:
+    SyntheticTransaction(int row, int rows, quint32 accounts)
+    {
+        const uint64_t seed = mix(static_cast<uint64_t>(row));
+        const uint64_t tip = FIRST_HEIGHT + rows / ROWS_PER_BLOCK + 10;
+
+        m_direction = row % 3 == 0 ? Direction_Out : Direction_In;
+        m_pending = row >= rows - 8;
+        m_failed = !m_pending && row % 997 == 500;
+        m_coinbase = m_direction == Direction_In && row % 499 == 1;
+        m_amount = (seed % 100000 + 1) * 100000000ULL;
+        m_fee = m_direction == Direction_Out ? 30000000 + seed % 1000000 : 0;
+        m_blockHeight = m_pending ? 0 : FIRST_HEIGHT + row / ROWS_PER_BLOCK;
+        m_confirmations = m_pending ? 0 : tip - m_blockHeight;
+        m_timestamp = FIRST_TIMESTAMP + static_cast<std::time_t>(row) * 120 / ROWS_PER_BLOCK;
+        m_subaddrAccount = row % accounts;
+        m_subaddrIndex.insert(static_cast<uint32_t>(seed % SUBADDRESSES));
+        m_hash = hex(seed, 4);
+        m_paymentId = row % 10 == 0 ? hex(seed + 1, 1) : std::string(16, '0');
+        if (row % 5 == 0)
+        {
+            m_description = "invoice " + std::to_string(row);
+        }
+        if (m_direction == Direction_In)
+        {
+            m_label = "Subaddress #" + std::to_string(*m_subaddrIndex.begin());
+        }
+        else
+        {
+            // spent from the primary address, paid to one or two destinations
+            m_subaddrIndex.insert(0);
+            const int destinations = 1 + row % 2;
+            m_transfers.reserve(destinations);
+            for (int i = 0; i < destinations; ++i)
+            {
+                m_transfers.emplace_back(m_amount / destinations, "4" + hex(seed + 2 + i, 6).substr(0, 94));
+            }
+        }
+    }
+
+    int direction() const override { return m_direction; }
+    bool isPending() const override { return m_pending; }
+    bool isFailed() const override { return m_failed; }
+    bool isCoinbase() const override { return m_coinbase; }
+    uint64_t amount() const override { return m_amount; }
+    uint64_t fee() const override { return m_fee; }
+    uint64_t blockHeight() const override { return m_blockHeight; }
+    std::string description() const override { return m_description; }
+    std::set<uint32_t> subaddrIndex() const override { return m_subaddrIndex; }
+    uint32_t subaddrAccount() const override { return m_subaddrAccount; }
+    std::string label() const override { return m_label; }
+    uint64_t confirmations() const override { return m_confirmations; }
+    uint64_t unlockTime() const override { return 0; }
+    std::string hash() const override { return m_hash; }
+    std::time_t timestamp() const override { return m_timestamp; }
+    std::string paymentId() const override { return m_paymentId; }
+    const std::vector<Transfer> &transfers() const override { return m_transfers; }
+
+private:
+    int m_direction;
+    bool m_pending;
+    bool m_failed;
+    bool m_coinbase;
+    uint64_t m_amount;
+    uint64_t m_fee;
+    uint64_t m_blockHeight;
+    uint64_t m_confirmations;
+    std::time_t m_timestamp;
+    uint32_t m_subaddrAccount;
+    std::set<uint32_t> m_subaddrIndex;
+    std::string m_hash;
+    std::string m_paymentId;
+    std::string m_description;
+    std::string m_label;
+    std::vector<Transfer> m_transfers;
+};
+
+} // namespace
+
+class SyntheticHistoryImpl : public Monero::TransactionHistory
+{
+public:
+    SyntheticHistoryImpl(int rows, quint32 accounts)
+    {
+        m_rows.reserve(rows);
+        m_all.reserve(rows);
+        for (int row = 0; row < rows; ++row)
+        {
+            m_rows.emplace_back(row, rows, accounts);
+            m_all.push_back(&m_rows.back());
+        }
+        for (Monero::TransactionInfo *info : m_all)
+        {
+            m_byHash.emplace(info->hash(), info);
+        }
+    }
+
+    int count() const override
+    {
+        return static_cast<int>(m_all.size());
+    }
+
+    Monero::TransactionInfo *transaction(int index) const override
+    {
+        return index >= 0 && index < count() ? m_all[index] : nullptr;
+    }
+
+    Monero::TransactionInfo *transaction(const std::string &id) const override
+    {
+        const auto it = m_byHash.find(id);
+        return it != m_byHash.end() ? it->second : nullptr;
+    }
+
+    std::vector<Monero::TransactionInfo *> getAll() const override
+    {
+        return m_all;
+    }
+
+    // the rows are fixed, libwallet would reread its transfers here
+    void refresh() override
+    {
+    }
+
+    void setTxNote(const std::string &, const std::string &) override
+    {
+    }
+
+private:
+    std::vector<SyntheticTransaction> m_rows;
+    std::vector<Monero::TransactionInfo *> m_all;
+    std::unordered_map<std::string, Monero::TransactionInfo *> m_byHash;
+};
+
+SyntheticHistory::SyntheticHistory(int rows, quint32 accounts /* = 4 */)
+    : m_impl(new SyntheticHistoryImpl(rows, accounts))
+    , m_history(new TransactionHistory(m_impl.get()))
+{
+    // on this thread, the rows are in place once refresh() returns
+    m_history->refresh(0);
+}
+
+SyntheticHistory::~SyntheticHistory() = default;
+
+TransactionHistory *SyntheticHistory::history() const
+{
+    return m_history.get();
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SYNTHETICHISTORY_H
+#define SYNTHETICHISTORY_H
+
+#include <memory>
+
+#include <QtGlobal>
+
+class TransactionHistory;
+class SyntheticHistoryImpl;
+
+/*!
+ * \brief A TransactionHistory over generated libwallet rows, so the history,
+ *        its models and the CSV export can be measured without a wallet.
+ *        Rows are spread over accounts and subaddresses, a few of them are
+ *        pending or failed and outgoing ones carry destinations.
+ */
+class SyntheticHistory
+{
+public:
+    explicit SyntheticHistory(int rows, quint32 accounts = 4);
+    ~SyntheticHistory();
+
+    //! holds the rows of every account, refreshed once by the constructor
+    TransactionHistory *history() const;
+
+private:
+    std::unique_ptr<SyntheticHistoryImpl> m_impl;
+    std::unique_ptr<TransactionHistory> m_history;
+};
+
+#endif // SYNTHETICHISTORY_H
@@ -0,0 +1,447 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Benchmarks of the GUI's hot paths over generated data:
+//
+//   monero-gui-bench [QtTest options] [function[:row]]
+//
+// e.g. "monero-gui-bench historyFilter:100k/hash -iterations 10", see
+// "monero-gui-bench -help" for the QtTest options (-tickcounter, -csv, ...).
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QImage>
+#include <QMetaEnum>
+#include <QPainter>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTimerEvent>
+#include <QtTest>
+
+#include <openpgp/openpgp.h>
+
+#include "Decoder.h"
+#include "FountainCode.h"
+#include "QRCodeImageProvider.h"
+#include "SyntheticHistory.h"
+#include "TransactionHistory.h"
+#include "TransactionHistoryModel.h"
+#include "TransactionHistorySortFilterModel.h"
+#include "qt/MoneroSettings.h"
+
+namespace
+{
+
+const std::pair<const char *, int> HISTORY_SIZES[] = {
+    {"10k", 10000},
+    {"100k", 100000},
+};
+
+const QString RECEIVE_URI = "monero:888tNkZrPN6JsEgekjMnABU4TBzc2Dt29EPAvkRxbANsAnjyPbb3iQ1YBRk1UXcdRsiKc9dhwMVgN5S9cQUiyoogDavup3H"
+                            "?tx_amount=1.250000000000&recipient_name=Bench&tx_description=invoice%2042";
+
+// upper bound for a page to be published, a 100k row pass takes well below that
+const int PAGE_TIMEOUT = 30000;
+
+QByteArray fixture(const char *name)
+{
+    QFile file(QString(BENCH_FIXTURES_DIR) + "/" + name);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qFatal("failed to read fixture %s", name);
+    }
+    return file.readAll();
+}
+
+bool waitForPage(TransactionHistorySortFilterModel &model, const std::function<void ()> &change)
+{
+    QSignalSpy spy(&model, &TransactionHistorySortFilterModel::pageUpdated);
+    change();
+    return spy.count() > 0 || spy.wait(PAGE_TIMEOUT);
+}
+
+void addHistorySizes()
+{
+    QTest::addColumn<int>("rows");
+    for (const auto &size : HISTORY_SIZES)
+    {
+        QTest::newRow(size.first) << size.second;
+    }
+}
+
+} // namespace
+
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void historyModelData_data();
+    void historyModelData();
+    void historyFilter_data();
+    void historyFilter();
+    void historySort_data();
+    void historySort();
+    void writeCSV_data();
+    void writeCSV();
+
+    void qrDecode_data();
+    void qrDecode();
+    void qrImage_data();
+    void qrImage();
+
+    void signatureVerify_data();
+    void signatureVerify();
+
+    void settingsWrite_data();
+    void settingsWrite();
+
+private:
+    //! histories are generated once per size and shared between the benchmarks
+    TransactionHistory *history(int rows, quint32 accounts = 4);
+
+    std::map<std::pair<int, quint32>, std::unique_ptr<SyntheticHistory>> m_histories;
+    QTemporaryDir m_dir;
+    QQmlEngine m_engine;
+};
+
+void Benchmarks::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    qmlRegisterType<MoneroSettings>("moneroComponents.Settings", 1, 0, "MoneroSettings");
+}
+
+TransactionHistory *Benchmarks::history(int rows, quint32 accounts /* = 4 */)
+{
+    std::unique_ptr<SyntheticHistory> &history = m_histories[{rows, accounts}];
+    if (!history)
+    {
+        history.reset(new SyntheticHistory(rows, accounts));
+    }
+    return history->history();
+}
+
+void Benchmarks::historyModelData_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("role");
+
+    const QMetaEnum roles = QMetaEnum::fromType<TransactionHistoryModel::TransactionInfoRole>();
+    for (const auto &size : HISTORY_SIZES)
+    {
+        for (int i = 0; i < roles.keyCount(); ++i)
+        {
+            QTest::addRow("%s/%s", size.first, roles.key(i)) << size.second << roles.value(i);
+        }
+    }
+}
+
+void Benchmarks::historyModelData()
+{
+    QFETCH(int, rows);
+    QFETCH(int, role);
+
+    TransactionHistoryModel model;
+    model.setTransactionHistory(history(rows));
+    QVERIFY(model.rowCount() > 0);
+
+    // a delegate reads one role of every row it shows
+    int valid = 0;
+    QBENCHMARK {
+        valid = 0;
+        for (int row = 0; row < model.rowCount(); ++row)
+        {
+            valid += model.data(model.index(row), role).isValid();
+        }
+    }
+    QVERIFY(valid > 0);
+}
+
+void Benchmarks::historyFilter_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<QString>("needle");
+
+    const std::pair<const char *, const char *> needles[] = {
+        {"hash", "ab"},
+        {"label", "subaddress #1"},
+        {"description", "invoice 9"},
+        {"miss", "no such row"},
+    };
+    for (const auto &size : HISTORY_SIZES)
+    {
+        for (const auto &needle : needles)
+        {
+            QTest::addRow("%s/%s", size.first, needle.first) << size.second << QString(needle.second);
+        }
+    }
+}
+
+void Benchmarks::historyFilter()
+{
+    QFETCH(int, rows);
+    QFETCH(QString, needle);
+
+    TransactionHistoryModel source;
+    source.setTransactionHistory(history(rows));
+    TransactionHistorySortFilterModel model;
+    model.setSortRole(TransactionHistoryModel::TransactionBlockHeightRole);
+    model.sort(0, Qt::DescendingOrder);
+    QVERIFY(waitForPage(model, [&] { model.setSourceModel(&source); }));
+
+    // a search and clearing it again, until both pages are published
+    QBENCHMARK {
+        QVERIFY(waitForPage(model, [&] { model.setSearchFilter(needle); }));
+        QVERIFY(waitForPage(model, [&] { model.setSearchFilter(QString()); }));
+    }
+}
+
+void Benchmarks::historySort_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("role");
+
+    // the orders History.qml offers
+    const std::pair<const char *, int> roles[] = {
+        {"timestamp", TransactionHistoryModel::TransactionTimeStampRole},
+        {"amount", TransactionHistoryModel::TransactionAtomicAmountRole},
+        {"blockHeight", TransactionHistoryModel::TransactionBlockHeightRole},
+    };
+    for (const auto &size : HISTORY_SIZES)
+    {
+        for (const auto &role : roles)
+        {
+            QTest::addRow("%s/%s", size.first, role.first) << size.second << role.second;
+        }
+    }
+}
+
+void Benchmarks::historySort()
+{
+    QFETCH(int, rows);
+    QFETCH(int, role);
+
+    TransactionHistoryModel source;
+    source.setTransactionHistory(history(rows));
+    TransactionHistorySortFilterModel model;
+    // paged like History.qml, an order change recuts the first page
+    model.setPageSize(100);
+    model.setSortRole(role);
+    QVERIFY(waitForPage(model, [&] {
+        model.setSourceModel(&source);
+        model.sort(0, Qt::DescendingOrder);
+    }));
+
+    QBENCHMARK {
+        QVERIFY(waitForPage(model, [&] { model.sort(0, Qt::AscendingOrder); }));
+        QVERIFY(waitForPage(model, [&] { model.sort(0, Qt::DescendingOrder); }));
+    }
+}
+
+void Benchmarks::writeCSV_data()
+{
+    addHistorySizes();
+}
+
+void Benchmarks::writeCSV()
+{
+    QFETCH(int, rows);
+
+    // a single account so every row is exported
+    TransactionHistory *transactions = history(rows, 1);
+    QString path;
+    QBENCHMARK {
+        path = transactions->writeCSV(0, m_dir.path());
+    }
+    QVERIFY(!path.isEmpty());
+    QFile::remove(path);
+}
+
+void Benchmarks::qrDecode_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("320x240") << QSize(320, 240);
+    QTest::newRow("640x480") << QSize(640, 480);
+    QTest::newRow("1280x720") << QSize(1280, 720);
+    QTest::newRow("1920x1080") << QSize(1920, 1080);
+}
+
+void Benchmarks::qrDecode()
+{
+    QFETCH(QSize, size);
+
+    // a receive code over half the frame height on a grey background, about
+    // what a webcam pointed at a screen delivers
+    QSize qrSize;
+    const QImage qr = QRCodeImageProvider::genQrImage(RECEIVE_URI, &qrSize, QSize(size.height() / 2, size.height() / 2))
+        .convertToFormat(QImage::Format_Grayscale8);
+    QImage frame(size, QImage::Format_Grayscale8);
+    frame.fill(QColor(190, 190, 190));
+    {
+        QPainter painter(&frame);
+        painter.drawImage((size.width() - qrSize.width()) / 2, (size.height() - qrSize.height()) / 2, qr);
+    }
+
+    QrDecoder decoder;
+    std::vector<std::string> decoded;
+    QBENCHMARK {
+        decoded = decoder.decode(frame);
+    }
+    QCOMPARE(decoded.size(), size_t(1));
+    QCOMPARE(QString::fromStdString(decoded.front()), RECEIVE_URI);
+}
+
+void Benchmarks::qrImage_data()
+{
+    QTest::addColumn<QString>("payload");
+    QTest::addColumn<int>("requestedSize");
+    QTest::addColumn<bool>("cached");
+
+    // one frame of an animated code, as WalletManager::fountainQrFrames makes them
+    const QString frame = FountainEncoder(fixture("hashes.txt.asc")).frame(7);
+    QTest::newRow("address/256") << RECEIVE_URI << 256 << false;
+    QTest::newRow("address/256/cached") << RECEIVE_URI << 256 << true;
+    QTest::newRow("address/1024") << RECEIVE_URI << 1024 << false;
+    QTest::newRow("frame/512") << frame << 512 << false;
+    QTest::newRow("frame/512/cached") << frame << 512 << true;
+}
+
+void Benchmarks::qrImage()
+{
+    QFETCH(QString, payload);
+    QFETCH(int, requestedSize);
+    QFETCH(bool, cached);
+
+    // the provider caches encodings by id, a counter keeps every id new
+    int counter = 0;
+    QSize size;
+    QImage image;
+    QBENCHMARK {
+        const QString id = cached ? payload : payload + "&n=" + QString::number(++counter);
+        image = QRCodeImageProvider::genQrImage(id, &size, QSize(requestedSize, requestedSize));
+    }
+    QVERIFY(!image.isNull());
+}
+
+void Benchmarks::signatureVerify_data()
+{
+    QTest::addColumn<bool>("parse");
+
+    // parsing the key and the armor every time is what an update check does
+    QTest::newRow("parse and verify") << true;
+    QTest::newRow("verify") << false;
+}
+
+void Benchmarks::signatureVerify()
+{
+    QFETCH(bool, parse);
+
+    // an RSA 4096 key and a clearsigned hashes.txt, as the maintainers publish
+    const std::string key = fixture("bench.asc").toStdString();
+    const std::string message = fixture("hashes.txt.asc").toStdString();
+
+    bool verified = false;
+    if (parse)
+    {
+        QBENCHMARK {
+            const openpgp::public_key_block keys(key);
+            const openpgp::message_armored signedMessage(message);
+            verified = openpgp::signature_rsa::from_armored(message).verify(signedMessage, keys.front());
+        }
+    }
+    else
+    {
+        const openpgp::public_key_block keys(key);
+        const openpgp::message_armored signedMessage(message);
+        const openpgp::signature_rsa signature = openpgp::signature_rsa::from_armored(message);
+        QBENCHMARK {
+            verified = signature.verify(signedMessage, keys.front());
+        }
+    }
+    QVERIFY(verified);
+}
+
+void Benchmarks::settingsWrite_data()
+{
+    QTest::addColumn<int>("properties");
+
+    // a single setting as most changes are, and a settings page worth
+    QTest::newRow("1") << 1;
+    QTest::newRow("16") << 16;
+    QTest::newRow("64") << 64;
+}
+
+void Benchmarks::settingsWrite()
+{
+    QFETCH(int, properties);
+
+    const QString fileName = m_dir.filePath(QString("settings_%1.ini").arg(properties));
+    QString qml = QString("import moneroComponents.Settings 1.0\nMoneroSettings {\n    fileName: \"%1\"\n").arg(fileName);
+    for (int i = 0; i < properties; ++i)
+    {
+        qml += QString("    property string setting%1: \"\"\n").arg(i);
+    }
+    qml += "}\n";
+
+    QQmlComponent component(&m_engine);
+    component.setData(qml.toUtf8(), QUrl());
+    std::unique_ptr<QObject> object(component.create());
+    QVERIFY2(object, qPrintable(component.errorString()));
+    MoneroSettings *settings = qobject_cast<MoneroSettings *>(object.get());
+    QVERIFY(settings);
+
+    // changed values plus the write as it happens once settingsWriteDelay passes
+    int counter = 0;
+    QBENCHMARK {
+        ++counter;
+        for (int i = 0; i < properties; ++i)
+        {
+            settings->setProperty(qPrintable(QString("setting%1").arg(i)), QString("value %1").arg(counter));
+        }
+        QTimerEvent timeout(settings->m_timerId);
+        QCoreApplication::sendEvent(settings, &timeout);
+        settings->waitForPendingWrites();
+    }
+
+    QSettings written(fileName, QSettings::IniFormat);
+    QCOMPARE(written.value("setting0").toString(), QString("value %1").arg(counter));
+}
+
+QTEST_GUILESS_MAIN(Benchmarks)
+
+#include "bench.moc"
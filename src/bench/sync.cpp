@@ -0,0 +1,91 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QLoggingCategory>
+
+#include "Logger.h"
+#include "SyncHarness.h"
+#include "wallet/api/wallet2_api.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("monero-gui-sync-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Syncs a synthetic wallet against a regtest monerod and writes the measurements to stdout as one JSON line.");
+    QCommandLineOption dataDirOption("data-dir", "Keep the regtest chain, the wallets and the fixture in <dir>.", "dir");
+    QCommandLineOption prepareOption("prepare", "Mine a new chain and generate the wallet instead of measuring a sync.");
+    QCommandLineOption baselineOption("baseline", "Sync through wallet2 alone, without the GUI wallet and its models.");
+    QCommandLineOption transactionsOption("transactions", "Transactions the prepared wallet receives.", "count", "1000");
+    QCommandLineOption subaddressesOption("subaddresses", "Subaddresses the prepared wallet receives them on.", "count", "100");
+    QCommandLineOption transactionsPerBlockOption("transactions-per-block", "Transactions mined into one block while preparing.", "count", "10");
+    QCommandLineOption rpcPortOption("rpc-port", "RPC port of the regtest monerod, the P2P port is the one below.", "port", "18181");
+    QCommandLineOption timeoutOption("timeout", "Give up when the sync takes longer than <seconds>.", "seconds", "3600");
+    QCommandLineOption perfLogOption("perf-log", "Also log the SyncProfile phases of the GUI wallet.");
+    QCommandLineOption logPathOption(QStringList() << "l" << "log-file",
+        QCoreApplication::translate("main", "Log to specified file"),
+        QCoreApplication::translate("main", "file"));
+    parser.addOptions({dataDirOption, prepareOption, baselineOption, transactionsOption, subaddressesOption,
+        transactionsPerBlockOption, rpcPortOption, timeoutOption, perfLogOption, logPathOption});
+    parser.addHelpOption();
+    parser.process(app);
+
+    if (!parser.isSet(dataDirOption)) {
+        qCritical("--data-dir is required");
+        return 1;
+    }
+    if (parser.isSet(perfLogOption))
+        QLoggingCategory::setFilterRules("monero.perf.debug=true");
+
+    Monero::Utils::onStartup();
+
+    // stdout carries the JSON line, the log only goes to the file
+    Logger logger(app, parser.value(logPathOption), false);
+    logger.resetLogFilePath(false);
+
+    SyncHarness::Options options;
+    options.dataDir = parser.value(dataDirOption);
+    options.prepare = parser.isSet(prepareOption);
+    options.baseline = parser.isSet(baselineOption);
+    options.transactions = parser.value(transactionsOption).toInt();
+    options.subaddresses = parser.value(subaddressesOption).toInt();
+    options.transactionsPerBlock = parser.value(transactionsPerBlockOption).toInt();
+    options.rpcPort = parser.value(rpcPortOption).toUShort();
+    options.timeoutSeconds = parser.value(timeoutOption).toInt();
+    if (options.transactions < 1 || options.subaddresses < 1 || options.transactionsPerBlock < 1 || options.rpcPort < 2 || options.timeoutSeconds < 1) {
+        qCritical("counts, port and timeout must be positive");
+        return 1;
+    }
+
+    SyncHarness harness(options);
+    harness.start();
+    return app.exec();
+}
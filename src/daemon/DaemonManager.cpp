@@ -27,7 +27,13 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "DaemonManager.h"
+#include "HostResources.h"
 #include "common/util.h"
+#include "qt/EventTrace.h"
+#include "qt/NetworkStats.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QMutexLocker>
@@ -43,11 +49,77 @@
 #include <QVariantMap>
 #include <QVariant>
 #include <QMap>
+#include <QLoggingCategory>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// TODO: wallet_merged - epee library triggers the warnings
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wreorder"
+#include <net/http.h>
+#pragma GCC diagnostic pop
 
 namespace {
     static const int DAEMON_START_TIMEOUT_SECONDS = 120;
+    static const int DAEMON_STOP_KILL_TIMEOUT_MS = 10000;
+    // start and stop detection polls with exponential backoff between these delays
+    static const unsigned long DAEMON_PROBE_MIN_DELAY_MS = 250;
+    static const unsigned long DAEMON_PROBE_MAX_DELAY_MS = 2000;
+    static const std::chrono::milliseconds DAEMON_RPC_TIMEOUT = std::chrono::seconds(3);
+    static const int DAEMON_TELEMETRY_INTERVAL_MS = 10000;
+    static const int DAEMON_BOOTSTRAP_POLL_INTERVAL_MS = 5000;
+    // one hour of samples
+    static const int DAEMON_TELEMETRY_SAMPLES = 360;
+    static const double DAEMON_TELEMETRY_SMOOTHING = 0.3;
+    // the background profile runs at full speed after this long without user input
+    static const int DAEMON_USER_IDLE_MS = 60000;
+    static const int DAEMON_BACKGROUND_LIMIT_DOWN_KBPS = 1024;
+    static const int DAEMON_BACKGROUND_LIMIT_UP_KBPS = 256;
+    static const quint64 DAEMON_LOW_MEMORY_BYTES = 4ull * 1024 * 1024 * 1024;
+    static const int DAEMON_CONSOLE_MAX_LINES = 1000;
+    static const int DAEMON_CONSOLE_FLUSH_INTERVAL_MS = 16;
+    // an unterminated line longer than this is passed on as is
+    static const int DAEMON_CONSOLE_MAX_LINE_LENGTH = 64 * 1024;
 }
 
+// Keeps a single connection to the local daemon RPC open between probes
+struct DaemonManager::RpcProbe
+{
+    bool invoke(const std::string &host, const std::string &port, const char *uri, const char *method, const std::string &body, std::string &response, int &responseCode)
+    {
+        QMutexLocker locker(&mutex);
+        if (host != serverHost || port != serverPort)
+        {
+            client.set_server(host, port, {}, epee::net_utils::ssl_support_t::e_ssl_support_disabled);
+            serverHost = host;
+            serverPort = port;
+        }
+
+        const epee::net_utils::http::http_response_info *info = nullptr;
+        const epee::net_utils::http::fields_list headers({{"Content-Type", "application/json"}});
+        NetworkRequestScope stats(QString::fromStdString(host + ":" + port), "daemon-rpc", body.size());
+        if (!client.invoke(uri, method, body, DAEMON_RPC_TIMEOUT, std::addressof(info), headers) || info == nullptr)
+        {
+            return false;
+        }
+
+        stats.received(info->m_response_code, info->m_body.size());
+        responseCode = info->m_response_code;
+        response = info->m_body;
+        return true;
+    }
+
+    QMutex mutex;
+    net::http::client client;
+    std::string serverHost;
+    std::string serverPort;
+};
+
+// monerod stdout gets its own category so the logger rate limits it separately
+Q_LOGGING_CATEGORY(daemonOutput, "monerod.output")
+
 bool DaemonManager::start(const QString &flags, NetworkType::Type nettype, const QString &dataDir, const QString &bootstrapNodeAddress, bool noSync /* = false*/, bool pruneBlockchain /* = false*/)
 {
     if (!QFileInfo(m_monerod).isFile())
@@ -81,11 +153,48 @@ bool DaemonManager::start(const QString &flags, NetworkType::Type nettype, const
         arguments << "--data-dir" << dataDir;
     }
 
+    // RPC endpoint used to probe the daemon, custom bind flags override the defaults
+    {
+        QString rpcHost;
+        quint16 rpcPort = 0;
+        for (int index = 0; index < arguments.size(); ++index) {
+            const QString &argument = arguments[index];
+            const QString next = index + 1 < arguments.size() ? arguments[index + 1] : QString();
+            if (argument == "--rpc-bind-port")
+                rpcPort = next.toUShort();
+            else if (argument.startsWith("--rpc-bind-port="))
+                rpcPort = argument.mid(16).toUShort();
+            else if (argument == "--rpc-bind-ip")
+                rpcHost = next;
+            else if (argument.startsWith("--rpc-bind-ip="))
+                rpcHost = argument.mid(14);
+        }
+        // wildcard and IPv6 binds are reachable through the loopback address
+        if (rpcHost == "0.0.0.0" || rpcHost.contains(':'))
+            rpcHost.clear();
+
+        QMutexLocker locker(&m_rpcEndpointMutex);
+        m_rpcHost = rpcHost;
+        m_rpcPort = rpcPort;
+    }
+    m_startedNettype = nettype;
+
     // Bootstrap node address
     if(!bootstrapNodeAddress.isEmpty()) {
         arguments << "--bootstrap-daemon-address" << bootstrapNodeAddress;
     }
 
+    // the wallet connects before the first poll, it scans through the bootstrap node until
+    // the local chain reaches the tip; a --no-sync node never does
+    m_localSynchronized = false;
+    m_bootstrapping = !bootstrapNodeAddress.isEmpty();
+    if (m_bootstrapping && !noSync) {
+        watchBootstrap(nettype);
+    } else {
+        m_bootstrapTimer.stop();
+    }
+    emit bootstrapStatusChanged();
+
     if (pruneBlockchain) {
         if (!checkLmdbExists(dataDir)) { // check that DB has not already been created
             arguments << "--prune-blockchain";
@@ -99,12 +208,7 @@ bool DaemonManager::start(const QString &flags, NetworkType::Type nettype, const
     arguments << "--check-updates" << "disabled";
     arguments << "--non-interactive";
 
-    // --max-concurrency based on threads available.
-    int32_t concurrency = qMax(1, QThread::idealThreadCount() / 2);
-
-    if(!flags.contains("--max-concurrency", Qt::CaseSensitive)){
-        arguments << "--max-concurrency" << QString::number(concurrency);
-    }
+    arguments << tunedArguments(flags, dataDir);
 
     qDebug() << "starting monerod " + m_monerod;
     qDebug() << "With command line arguments " << arguments;
@@ -112,6 +216,8 @@ bool DaemonManager::start(const QString &flags, NetworkType::Type nettype, const
     QMutexLocker locker(&m_daemonMutex);
 
     m_daemon.reset(new QProcess());
+    m_stdoutPartialLine.clear();
+    m_stderrPartialLine.clear();
 
     // Connect output slots
     connect(m_daemon.get(), SIGNAL(readyReadStandardOutput()), this, SLOT(printOutput()));
@@ -137,19 +243,30 @@ bool DaemonManager::start(const QString &flags, NetworkType::Type nettype, const
         } else {
             emit daemonStartFailure(tr("Timed out, local node is not responding after %1 seconds").arg(DAEMON_START_TIMEOUT_SECONDS));
         }
-    });
+    }, FutureScheduler::BlockingIO, "DaemonManager::start");
 
     return true;
 }
 
 void DaemonManager::stopAsync(NetworkType::Type nettype, const QString &dataDir, const QJSValue& callback)
 {
+    m_bootstrapTimer.stop();
+    if (m_bootstrapping || m_localSynchronized) {
+        m_bootstrapping = false;
+        m_localSynchronized = false;
+        emit bootstrapStatusChanged();
+    }
+
     const auto feature = m_scheduler.run([this, nettype, dataDir] {
-        QString message;
-        sendCommand({"exit"}, nettype, dataDir, message);
+        if (!rpcStopDaemon(nettype))
+        {
+            // restricted RPC refuses stop_daemon
+            QString message;
+            sendCommand({"exit"}, nettype, dataDir, message);
+        }
 
         return QJSValueList({stopWatcher(nettype, dataDir)});
-    }, callback);
+    }, callback, FutureScheduler::BlockingIO, "DaemonManager::stopAsync");
 
     if (!feature.first)
     {
@@ -157,46 +274,382 @@ void DaemonManager::stopAsync(NetworkType::Type nettype, const QString &dataDir,
     }
 }
 
+QStringList DaemonManager::tunedArguments(const QString &flags, const QString &dataDir) const
+{
+    // flags given by the user always win
+    QStringList arguments;
+    auto add = [&flags, &arguments](const QString &flag, const QString &value) {
+        if (!flags.contains(flag, Qt::CaseSensitive)) {
+            arguments << flag << value;
+        }
+    };
+
+    // monerod defaults to ~/.bitmonero when no data dir is given
+    const HostResources host = HostResources::inspect(dataDir.isEmpty() ? QDir::homePath() : dataDir);
+    if (m_resourceProfile == "default") {
+        // --max-concurrency based on threads available.
+        add("--max-concurrency", QString::number(qMax(1, host.cores / 2)));
+        return arguments;
+    }
+
+    const bool lowMemory = host.memoryBytes > 0 && host.memoryBytes < DAEMON_LOW_MEMORY_BYTES;
+    const bool conserve = host.onBattery || m_resourceProfile == "background";
+    qDebug() << "daemon resource profile" << m_resourceProfile << "cores" << host.cores << "memory" << host.memoryBytes
+             << "storage" << host.storage << "on battery" << host.onBattery;
+
+    add("--max-concurrency", QString::number(qMax(1, host.cores / (conserve ? 4 : 2))));
+
+    // fewer, larger commits keep a rotational disk from seeking on every batch
+    if (host.storage == HostResources::StorageRotational) {
+        add("--db-sync-mode", "fast:async:1000000000bytes");
+    }
+
+    // smaller sync batches bound the memory used while verifying blocks
+    if (lowMemory) {
+        add("--block-sync-size", "10");
+    }
+
+    if (lowMemory || host.onBattery) {
+        add("--out-peers", "8");
+        add("--in-peers", "16");
+    }
+
+    return arguments;
+}
+
+QString DaemonManager::resourceProfile() const
+{
+    return m_resourceProfile;
+}
+
+void DaemonManager::setResourceProfile(const QString &profile)
+{
+    if (profile == m_resourceProfile) {
+        return;
+    }
+
+    m_resourceProfile = profile;
+    if (m_resourceProfile != "background") {
+        m_userIdleTimer.stop();
+        setBackgroundThrottle(false);
+    }
+    emit resourceProfileChanged();
+}
+
+void DaemonManager::userActivity()
+{
+    if (!m_daemonRunning || m_resourceProfile != "background") {
+        return;
+    }
+
+    m_userIdleTimer.start();
+    setBackgroundThrottle(true);
+}
+
+void DaemonManager::setBackgroundThrottle(bool throttled)
+{
+    if (throttled == m_backgroundThrottled || (throttled && !m_daemonRunning)) {
+        return;
+    }
+    m_backgroundThrottled = throttled;
+
+    // -1 restores the daemon defaults
+    const int limitDown = throttled ? DAEMON_BACKGROUND_LIMIT_DOWN_KBPS : -1;
+    const int limitUp = throttled ? DAEMON_BACKGROUND_LIMIT_UP_KBPS : -1;
+    const NetworkType::Type nettype = m_startedNettype;
+    m_scheduler.run([this, nettype, limitDown, limitUp] {
+        const std::string body = QString("{\"limit_down\":%1,\"limit_up\":%2}").arg(limitDown).arg(limitUp).toStdString();
+        std::string response;
+        int responseCode = 0;
+        if (!rpcInvoke(nettype, "/set_limit", "POST", body, response, responseCode) || responseCode != 200) {
+            qWarning() << "Failed to set daemon bandwidth limits";
+        }
+    }, FutureScheduler::BlockingIO, "DaemonManager::setBackgroundThrottle");
+}
+
 bool DaemonManager::startWatcher(NetworkType::Type nettype, const QString &dataDir) const
 {
-    // Check if daemon is started every 2 seconds
+    // Probe the daemon RPC until it responds, backing off up to DAEMON_PROBE_MAX_DELAY_MS
     QElapsedTimer timer;
     timer.start();
-    while(true && !m_app_exit && timer.elapsed() / 1000 < DAEMON_START_TIMEOUT_SECONDS  ) {
-        QThread::sleep(2);
-        if(!running(nettype, dataDir)) {
-            qDebug() << "daemon not running. checking again in 2 seconds.";
-        } else {
-            qDebug() << "daemon is started. Waiting 5 seconds to let daemon catch up";
-            QThread::sleep(5);
+    unsigned long delay = DAEMON_PROBE_MIN_DELAY_MS;
+    while(!m_app_exit && timer.elapsed() / 1000 < DAEMON_START_TIMEOUT_SECONDS) {
+        if (!m_scheduler.token().sleepFor(std::chrono::milliseconds(delay))) {
+            return false;
+        }
+        if(running(nettype, dataDir)) {
+            qDebug() << "daemon is started";
             return true;
         }
+        delay = std::min(delay * 2, DAEMON_PROBE_MAX_DELAY_MS);
+        qDebug() << "daemon not running. checking again in" << delay << "ms";
     }
     return false;
 }
 
 bool DaemonManager::stopWatcher(NetworkType::Type nettype, const QString &dataDir) const
 {
-    // Check if daemon is running every 2 seconds. Kill if still running after 10 seconds
-    int counter = 0;
-    while(true && !m_app_exit) {
-        QThread::sleep(2);
-        counter++;
-        if(running(nettype, dataDir)) {
-            qDebug() << "Daemon still running.  " << counter;
-            if(counter >= 5) {
-                qDebug() << "Killing it! ";
+    // Probe the daemon RPC until it stops responding. Kill if still running after 10 seconds
+    QElapsedTimer timer;
+    timer.start();
+    unsigned long delay = DAEMON_PROBE_MIN_DELAY_MS;
+    while(!m_app_exit) {
+        // stop_daemon was sent already, monerod goes down without the GUI watching
+        if (!m_scheduler.token().sleepFor(std::chrono::milliseconds(delay))) {
+            return false;
+        }
+        if(!running(nettype, dataDir)) {
+            return true;
+        }
+
+        qDebug() << "Daemon still running after" << timer.elapsed() << "ms";
+        if(timer.elapsed() >= DAEMON_STOP_KILL_TIMEOUT_MS) {
+            qDebug() << "Killing it! ";
 #ifdef Q_OS_WIN
-                QProcess::execute("taskkill",  {"/F", "/IM", "monerod.exe"});
+            QProcess::execute("taskkill",  {"/F", "/IM", "monerod.exe"});
 #else
-                QProcess::execute("pkill", {"monerod"});
+            QProcess::execute("pkill", {"monerod"});
 #endif
+        }
+        delay = std::min(delay * 2, DAEMON_PROBE_MAX_DELAY_MS);
+    }
+    return false;
+}
+
+bool DaemonManager::rpcInvoke(NetworkType::Type nettype, const char *uri, const char *method, const std::string &body, std::string &response, int &responseCode) const
+{
+    QString host;
+    quint16 port;
+    {
+        QMutexLocker locker(&m_rpcEndpointMutex);
+        host = m_rpcHost.isEmpty() ? QStringLiteral("127.0.0.1") : m_rpcHost;
+        port = m_rpcPort;
+    }
+    if (port == 0) {
+        port = nettype == NetworkType::TESTNET ? 28081 : nettype == NetworkType::STAGENET ? 38081 : 18081;
+    }
+
+    return m_rpcProbe->invoke(host.toStdString(), std::to_string(port), uri, method, body, response, responseCode);
+}
+
+DaemonManager::RpcStatus DaemonManager::rpcStatus(NetworkType::Type nettype) const
+{
+    RpcStatus status;
+
+    std::string response;
+    int responseCode = 0;
+    if (!rpcInvoke(nettype, "/get_info", "GET", {}, response, responseCode)) {
+        return status;
+    }
+
+    // any HTTP response, including a login challenge, means the daemon is up
+    status.running = true;
+    if (responseCode != 200) {
+        return status;
+    }
+
+    const QJsonObject info = QJsonDocument::fromJson(QByteArray::fromStdString(response)).object();
+    status.untrusted = info.value("untrusted").toBool();
+    // the bootstrap node's tip is the target of the local chain
+    status.height = status.untrusted ? info.value("height_without_bootstrap").toInteger() : info.value("height").toInteger();
+    status.targetHeight = std::max<quint64>(status.height, std::max(info.value("height").toInteger(), info.value("target_height").toInteger()));
+    status.synchronized = !status.untrusted && info.value("synchronized").toBool();
+    status.incomingPeers = static_cast<quint32>(info.value("incoming_connections_count").toInteger());
+    status.outgoingPeers = static_cast<quint32>(info.value("outgoing_connections_count").toInteger());
+    status.peerCount = status.incomingPeers + status.outgoingPeers;
+    status.databaseSize = info.value("database_size").toInteger();
+    return status;
+}
+
+bool DaemonManager::rpcStopDaemon(NetworkType::Type nettype) const
+{
+    std::string response;
+    int responseCode = 0;
+    if (!rpcInvoke(nettype, "/stop_daemon", "POST", "{}", response, responseCode) || responseCode != 200) {
+        return false;
+    }
+    return QJsonDocument::fromJson(QByteArray::fromStdString(response)).object().value("status").toString() == "OK";
+}
+
+quint64 DaemonManager::rpcBytesReceived(NetworkType::Type nettype) const
+{
+    std::string response;
+    int responseCode = 0;
+    if (!rpcInvoke(nettype, "/get_net_stats", "POST", "{}", response, responseCode) || responseCode != 200) {
+        return 0;
+    }
+    return QJsonDocument::fromJson(QByteArray::fromStdString(response)).object().value("total_bytes_in").toInteger();
+}
+
+void DaemonManager::startTelemetry(NetworkType::Type nettype)
+{
+    if (m_telemetryTimer.isActive() && m_telemetryNettype == nettype) {
+        return;
+    }
+
+    m_telemetryNettype = nettype;
+    m_telemetry.clear();
+    m_lastTelemetrySample = TelemetrySample();
+    m_telemetryTimer.start();
+    sampleTelemetry();
+}
+
+void DaemonManager::stopTelemetry()
+{
+    m_telemetryTimer.stop();
+}
+
+void DaemonManager::sampleTelemetry()
+{
+    if (m_telemetrySampling) {
+        return;
+    }
+
+    const NetworkType::Type nettype = m_telemetryNettype;
+    m_telemetrySampling = m_scheduler.run([this, nettype] {
+        TelemetrySample sample;
+        sample.timestamp = QDateTime::currentMSecsSinceEpoch();
+        const RpcStatus status = rpcStatus(nettype);
+        if (status.running) {
+            sample.height = status.height;
+            sample.targetHeight = status.targetHeight;
+            sample.databaseSize = status.databaseSize;
+            sample.incomingPeers = status.incomingPeers;
+            sample.outgoingPeers = status.outgoingPeers;
+            sample.bytesReceived = rpcBytesReceived(nettype);
+        }
+
+        QMetaObject::invokeMethod(this, [this, status, sample] {
+            m_telemetrySampling = false;
+            if (status.running && m_telemetryTimer.isActive()) {
+                appendTelemetrySample(sample);
             }
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "DaemonManager::sampleTelemetry").first;
+}
 
-        } else
-            return true;
+void DaemonManager::watchBootstrap(NetworkType::Type nettype)
+{
+    m_bootstrapNettype = nettype;
+    if (m_localSynchronized || m_bootstrapTimer.isActive()) {
+        return;
     }
-    return false;
+
+    m_bootstrapTimer.start();
+    pollBootstrap();
+}
+
+void DaemonManager::pollBootstrap()
+{
+    if (m_bootstrapPolling) {
+        return;
+    }
+
+    const NetworkType::Type nettype = m_bootstrapNettype;
+    m_bootstrapPolling = m_scheduler.run([this, nettype] {
+        const RpcStatus status = rpcStatus(nettype);
+        QMetaObject::invokeMethod(this, [this, status] {
+            m_bootstrapPolling = false;
+            // not up yet, or stopped meanwhile
+            if (!status.running || !m_bootstrapTimer.isActive()) {
+                return;
+            }
+
+            const bool handedOver = status.synchronized;
+            if (status.untrusted == m_bootstrapping && handedOver == m_localSynchronized &&
+                status.height == m_localHeight && status.targetHeight == m_localTargetHeight) {
+                return;
+            }
+            m_bootstrapping = status.untrusted;
+            m_localSynchronized = handedOver;
+            m_localHeight = status.height;
+            m_localTargetHeight = status.targetHeight;
+            if (handedOver) {
+                qDebug() << "local node reached the tip at" << m_localHeight << ", bootstrap node no longer used";
+                m_bootstrapTimer.stop();
+            }
+            emit bootstrapStatusChanged();
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "DaemonManager::pollBootstrap").first;
+}
+
+bool DaemonManager::bootstrapping() const
+{
+    return m_bootstrapping;
+}
+
+bool DaemonManager::localSynchronized() const
+{
+    return m_localSynchronized;
+}
+
+quint64 DaemonManager::localHeight() const
+{
+    return m_localHeight;
+}
+
+quint64 DaemonManager::localTargetHeight() const
+{
+    return m_localTargetHeight;
+}
+
+void DaemonManager::appendTelemetrySample(TelemetrySample sample)
+{
+    const TelemetrySample &previous = m_lastTelemetrySample;
+    const double seconds = (sample.timestamp - previous.timestamp) / 1000.0;
+    if (previous.timestamp > 0 && seconds > 0) {
+        const double blocksPerSecond = sample.height > previous.height ? (sample.height - previous.height) / seconds : 0;
+        const double bytesPerSecond = sample.bytesReceived > previous.bytesReceived ? (sample.bytesReceived - previous.bytesReceived) / seconds : 0;
+        // smoothed, single samples swing with block sizes
+        sample.blocksPerSecond = previous.blocksPerSecond > 0
+            ? DAEMON_TELEMETRY_SMOOTHING * blocksPerSecond + (1 - DAEMON_TELEMETRY_SMOOTHING) * previous.blocksPerSecond
+            : blocksPerSecond;
+        sample.downloadBytesPerSecond = previous.downloadBytesPerSecond > 0
+            ? DAEMON_TELEMETRY_SMOOTHING * bytesPerSecond + (1 - DAEMON_TELEMETRY_SMOOTHING) * previous.downloadBytesPerSecond
+            : bytesPerSecond;
+    }
+
+    const quint64 remaining = sample.targetHeight > sample.height ? sample.targetHeight - sample.height : 0;
+    sample.etaSeconds = remaining == 0 ? 0 : sample.blocksPerSecond > 0 ? static_cast<qint64>(remaining / sample.blocksPerSecond) : -1;
+
+    m_lastTelemetrySample = sample;
+    m_telemetry.append(sample);
+    emit telemetryUpdated();
+}
+
+QVariantMap DaemonManager::telemetrySampleToMap(const TelemetrySample &sample)
+{
+    QVariantMap map;
+    map["timestamp"] = sample.timestamp;
+    map["height"] = sample.height;
+    map["targetHeight"] = sample.targetHeight;
+    map["blocksPerSecond"] = sample.blocksPerSecond;
+    map["downloadBytesPerSecond"] = sample.downloadBytesPerSecond;
+    map["databaseSize"] = sample.databaseSize;
+    map["incomingPeers"] = sample.incomingPeers;
+    map["outgoingPeers"] = sample.outgoingPeers;
+    map["etaSeconds"] = sample.etaSeconds;
+    return map;
+}
+
+QVariantList DaemonManager::telemetry() const
+{
+    QVariantList samples;
+    samples.reserve(m_telemetry.count());
+    for (qsizetype index = m_telemetry.firstIndex(); index <= m_telemetry.lastIndex(); ++index) {
+        samples.append(telemetrySampleToMap(m_telemetry.at(index)));
+    }
+    return samples;
+}
+
+QVariantMap DaemonManager::latestTelemetry() const
+{
+    return m_telemetry.isEmpty() ? QVariantMap() : telemetrySampleToMap(m_telemetry.last());
+}
+
+int DaemonManager::telemetryCapacity() const
+{
+    return DAEMON_TELEMETRY_SAMPLES;
 }
 
 
@@ -204,44 +657,112 @@ void DaemonManager::stateChanged(QProcess::ProcessState state)
 {
     qDebug() << "STATE CHANGED: " << state;
     if (state == QProcess::NotRunning) {
+        // pass on unterminated output left by the exited process
+        appendConsoleLine(QString::fromUtf8(std::exchange(m_stdoutPartialLine, QByteArray())), "Daemon: ");
+        appendConsoleLine(QString::fromUtf8(std::exchange(m_stderrPartialLine, QByteArray())), "Daemon ERROR: ");
+        flushConsoleLines();
         emit daemonStopped();
     }
 }
 
 void DaemonManager::printOutput()
 {
-    QByteArray byteArray = [this]() {
+    const QByteArray output = [this]() {
         QMutexLocker locker(&m_daemonMutex);
         return m_daemon->readAllStandardOutput();
     }();
-    QStringList strLines = QString(byteArray).split("\n");
-
-    foreach (QString line, strLines) {
-        emit daemonConsoleUpdated(line);
-        qDebug() << "Daemon: " + line;
-    }
+    appendConsoleOutput(m_stdoutPartialLine, output, "Daemon: ");
 }
 
 void DaemonManager::printError()
 {
-    QByteArray byteArray = [this]() {
+    const QByteArray output = [this]() {
         QMutexLocker locker(&m_daemonMutex);
         return m_daemon->readAllStandardError();
     }();
-    QStringList strLines = QString(byteArray).split("\n");
+    appendConsoleOutput(m_stderrPartialLine, output, "Daemon ERROR: ");
+}
+
+void DaemonManager::appendConsoleOutput(QByteArray &partialLine, const QByteArray &output, const char *logPrefix)
+{
+    // a read can end in the middle of a line, the tail is kept until its newline arrives
+    partialLine.append(output);
+
+    qsizetype lineStart = 0;
+    for (qsizetype newline = partialLine.indexOf('\n'); newline >= 0; newline = partialLine.indexOf('\n', lineStart))
+    {
+        qsizetype lineEnd = newline;
+        if (lineEnd > lineStart && partialLine.at(lineEnd - 1) == '\r')
+        {
+            --lineEnd;
+        }
+        appendConsoleLine(QString::fromUtf8(partialLine.constData() + lineStart, lineEnd - lineStart), logPrefix);
+        lineStart = newline + 1;
+    }
+
+    // remove() keeps the allocation, the buffer is reused by the next read
+    partialLine.remove(0, lineStart);
+    if (partialLine.size() > DAEMON_CONSOLE_MAX_LINE_LENGTH)
+    {
+        appendConsoleLine(QString::fromUtf8(partialLine), logPrefix);
+        partialLine.clear();
+    }
+}
+
+void DaemonManager::appendConsoleLine(QString line, const char *logPrefix)
+{
+    if (line.isEmpty())
+    {
+        return;
+    }
+
+    qCDebug(daemonOutput) << logPrefix + line;
+
+    m_consoleLines.append(line);
+    // lines beyond the cap would be trimmed by the console right away
+    if (m_pendingConsoleLines.size() == DAEMON_CONSOLE_MAX_LINES)
+    {
+        m_pendingConsoleLines.removeFirst();
+    }
+    m_pendingConsoleLines.append(std::move(line));
 
-    foreach (QString line, strLines) {
-        emit daemonConsoleUpdated(line);
-        qDebug() << "Daemon ERROR: " + line;
+    if (!m_consoleFlushTimer.isActive())
+    {
+        m_consoleFlushTimer.start();
+    }
+}
+
+void DaemonManager::flushConsoleLines()
+{
+    m_consoleFlushTimer.stop();
+    if (m_pendingConsoleLines.isEmpty())
+    {
+        return;
+    }
+
+    emit daemonConsoleLinesUpdated(std::exchange(m_pendingConsoleLines, QStringList()));
+}
+
+QStringList DaemonManager::consoleLines() const
+{
+    QStringList lines;
+    lines.reserve(m_consoleLines.count());
+    for (qsizetype index = m_consoleLines.firstIndex(); index <= m_consoleLines.lastIndex(); ++index)
+    {
+        lines.append(m_consoleLines.at(index));
     }
+    return lines;
+}
+
+int DaemonManager::consoleMaxLines() const
+{
+    return DAEMON_CONSOLE_MAX_LINES;
 }
 
 bool DaemonManager::running(NetworkType::Type nettype, const QString &dataDir) const
-{ 
-    QString status;
-    sendCommand({"sync_info"}, nettype, dataDir, status);
-    qDebug() << status;
-    return status.contains("Height:");
+{
+    Q_UNUSED(dataDir);
+    return rpcStatus(nettype).running;
 }
 
 bool DaemonManager::noSync() const noexcept
@@ -253,11 +774,26 @@ void DaemonManager::runningAsync(NetworkType::Type nettype, const QString &dataD
 { 
     m_scheduler.run([this, nettype, dataDir] {
         return QJSValueList({running(nettype, dataDir)});
-    }, callback);
+    }, callback, FutureScheduler::BlockingIO, "DaemonManager::runningAsync");
+}
+
+void DaemonManager::statusAsync(NetworkType::Type nettype, const QJSValue& callback) const
+{
+    m_scheduler.run([this, nettype] {
+        const RpcStatus status = rpcStatus(nettype);
+        return QJSValueList({
+            status.running,
+            static_cast<double>(status.height),
+            static_cast<double>(status.targetHeight),
+            status.synchronized,
+            status.peerCount,
+        });
+    }, callback, FutureScheduler::BlockingIO, "DaemonManager::statusAsync");
 }
 
 bool DaemonManager::sendCommand(const QStringList &cmd, NetworkType::Type nettype, const QString &dataDir, QString &message) const
 {
+    const TraceScope trace("daemon", "DaemonManager::sendCommand");
     QProcess p;
     QStringList external_cmd(cmd);
 
@@ -288,7 +824,7 @@ void DaemonManager::sendCommandAsync(const QStringList &cmd, NetworkType::Type n
     m_scheduler.run([this, cmd, nettype, dataDir] {
         QString message;
         return QJSValueList({sendCommand(cmd, nettype, dataDir, message)});
-    }, callback);
+    }, callback, FutureScheduler::BlockingIO, "DaemonManager::sendCommandAsync");
 }
 
 void DaemonManager::exit()
@@ -395,8 +931,38 @@ QString DaemonManager::getArgs(const QString &dataDir) {
 
 DaemonManager::DaemonManager(QObject *parent)
     : QObject(parent)
+    , m_rpcProbe(new RpcProbe())
+    , m_consoleLines(DAEMON_CONSOLE_MAX_LINES)
+    , m_telemetry(DAEMON_TELEMETRY_SAMPLES)
     , m_scheduler(this)
 {
+    m_consoleFlushTimer.setSingleShot(true);
+    m_consoleFlushTimer.setInterval(DAEMON_CONSOLE_FLUSH_INTERVAL_MS);
+    connect(&m_consoleFlushTimer, &QTimer::timeout, this, &DaemonManager::flushConsoleLines);
+
+    m_telemetryTimer.setInterval(DAEMON_TELEMETRY_INTERVAL_MS);
+    connect(&m_telemetryTimer, &QTimer::timeout, this, &DaemonManager::sampleTelemetry);
+    m_bootstrapTimer.setInterval(DAEMON_BOOTSTRAP_POLL_INTERVAL_MS);
+    connect(&m_bootstrapTimer, &QTimer::timeout, this, &DaemonManager::pollBootstrap);
+    // daemonStarted is emitted by the start watcher task, handled on our thread
+    connect(this, &DaemonManager::daemonStarted, this, [this] {
+        m_daemonRunning = true;
+        startTelemetry(m_startedNettype);
+        // the user just asked for the daemon, treat them as active
+        userActivity();
+    });
+    connect(this, &DaemonManager::daemonStopped, this, [this] {
+        stopTelemetry();
+        m_userIdleTimer.stop();
+        m_backgroundThrottled = false;
+        m_daemonRunning = false;
+    });
+
+    m_userIdleTimer.setSingleShot(true);
+    m_userIdleTimer.setInterval(DAEMON_USER_IDLE_MS);
+    connect(&m_userIdleTimer, &QTimer::timeout, this, [this] {
+        setBackgroundThrottle(false);
+    });
 
     // Platform depetent path to monerod
 #ifdef Q_OS_WIN
@@ -29,12 +29,17 @@
 #ifndef DAEMONMANAGER_H
 #define DAEMONMANAGER_H
 
+#include <atomic>
 #include <memory>
 
+#include <QContiguousCache>
 #include <QMutex>
 #include <QObject>
 #include <QUrl>
 #include <QProcess>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantList>
 #include <QVariantMap>
 #include "qt/FutureScheduler.h"
 #include "NetworkType.h"
@@ -42,6 +47,14 @@
 class DaemonManager : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(int consoleMaxLines READ consoleMaxLines CONSTANT)
+    Q_PROPERTY(QVariantMap latestTelemetry READ latestTelemetry NOTIFY telemetryUpdated)
+    Q_PROPERTY(int telemetryCapacity READ telemetryCapacity CONSTANT)
+    Q_PROPERTY(QString resourceProfile READ resourceProfile WRITE setResourceProfile NOTIFY resourceProfileChanged)
+    Q_PROPERTY(bool bootstrapping READ bootstrapping NOTIFY bootstrapStatusChanged)
+    Q_PROPERTY(bool localSynchronized READ localSynchronized NOTIFY bootstrapStatusChanged)
+    Q_PROPERTY(quint64 localHeight READ localHeight NOTIFY bootstrapStatusChanged)
+    Q_PROPERTY(quint64 localTargetHeight READ localTargetHeight NOTIFY bootstrapStatusChanged)
 
 public:
     explicit DaemonManager(QObject *parent = 0);
@@ -53,29 +66,107 @@ public:
     Q_INVOKABLE bool noSync() const noexcept;
     // return true if daemon process is started
     Q_INVOKABLE void runningAsync(NetworkType::Type nettype, const QString &dataDir, const QJSValue& callback) const;
+    // calls back with (running, height, targetHeight, synchronized, peerCount)
+    Q_INVOKABLE void statusAsync(NetworkType::Type nettype, const QJSValue& callback) const;
     // Send daemon command from qml and prints output in console window.
     Q_INVOKABLE void sendCommandAsync(const QStringList &cmd, NetworkType::Type nettype, const QString &dataDir, const QJSValue& callback) const;
     Q_INVOKABLE void exit();
     Q_INVOKABLE QVariantMap validateDataDir(const QString &dataDir) const;
     Q_INVOKABLE bool checkLmdbExists(QString datadir);
     Q_INVOKABLE QString getArgs(const QString &dataDir);
+    // most recent daemon output lines, at most consoleMaxLines
+    Q_INVOKABLE QStringList consoleLines() const;
+    int consoleMaxLines() const;
+
+    // Samples the daemon RPC every 10 seconds, started and stopped along with a daemon
+    // managed by us. Samples are maps of timestamp, height, targetHeight, blocksPerSecond,
+    // downloadBytesPerSecond, databaseSize, incomingPeers, outgoingPeers and etaSeconds
+    // (-1 while unknown), the oldest first, at most telemetryCapacity of them.
+    Q_INVOKABLE void startTelemetry(NetworkType::Type nettype);
+    Q_INVOKABLE void stopTelemetry();
+    Q_INVOKABLE QVariantList telemetry() const;
+    QVariantMap latestTelemetry() const;
+    int telemetryCapacity() const;
+
+    // "auto" tunes the daemon flags for the host, "background" additionally throttles
+    // the daemon bandwidth while the user is active, "default" only sets --max-concurrency
+    QString resourceProfile() const;
+    void setResourceProfile(const QString &profile);
+
+    // A local node short of the tip answers wallet RPC through its bootstrap node, which
+    // must not be trusted. Polls the node every 5 seconds until it serves the tip itself,
+    // started by start() and for local nodes the GUI didn't start. bootstrapping is set
+    // while the answers come from the bootstrap node, localSynchronized once the node
+    // caught up, localHeight and localTargetHeight track its own chain meanwhile.
+    Q_INVOKABLE void watchBootstrap(NetworkType::Type nettype);
+    bool bootstrapping() const;
+    bool localSynchronized() const;
+    quint64 localHeight() const;
+    quint64 localTargetHeight() const;
 
 private:
+    struct RpcStatus
+    {
+        bool running = false;
+        quint64 height = 0;
+        quint64 targetHeight = 0;
+        bool synchronized = false;
+        quint32 peerCount = 0;
+        quint32 incomingPeers = 0;
+        quint32 outgoingPeers = 0;
+        quint64 databaseSize = 0;
+        // answered by the bootstrap node, height is the local chain's
+        bool untrusted = false;
+    };
+    struct TelemetrySample
+    {
+        qint64 timestamp = 0;
+        quint64 height = 0;
+        quint64 targetHeight = 0;
+        quint64 bytesReceived = 0;
+        double blocksPerSecond = 0;
+        double downloadBytesPerSecond = 0;
+        quint64 databaseSize = 0;
+        quint32 incomingPeers = 0;
+        quint32 outgoingPeers = 0;
+        qint64 etaSeconds = -1;
+    };
+    struct RpcProbe;
 
+    bool rpcInvoke(NetworkType::Type nettype, const char *uri, const char *method, const std::string &body, std::string &response, int &responseCode) const;
+    RpcStatus rpcStatus(NetworkType::Type nettype) const;
+    bool rpcStopDaemon(NetworkType::Type nettype) const;
+    quint64 rpcBytesReceived(NetworkType::Type nettype) const;
+    QStringList tunedArguments(const QString &flags, const QString &dataDir) const;
+    void setBackgroundThrottle(bool throttled);
+    void sampleTelemetry();
+    void appendTelemetrySample(TelemetrySample sample);
+    void pollBootstrap();
+    static QVariantMap telemetrySampleToMap(const TelemetrySample &sample);
     bool running(NetworkType::Type nettype, const QString &dataDir) const;
     bool sendCommand(const QStringList &cmd, NetworkType::Type nettype, const QString &dataDir, QString &message) const;
     bool startWatcher(NetworkType::Type nettype, const QString &dataDir) const;
     bool stopWatcher(NetworkType::Type nettype, const QString &dataDir) const;
+    void appendConsoleOutput(QByteArray &partialLine, const QByteArray &output, const char *logPrefix);
+    void appendConsoleLine(QString line, const char *logPrefix);
+    void flushConsoleLines();
 signals:
     void daemonStarted() const;
     void daemonStopped() const;
     void daemonStartFailure(const QString &error) const;
     void daemonConsoleUpdated(QString message) const;
+    // daemon output framed into complete lines, delivered at most once per frame
+    void daemonConsoleLinesUpdated(const QStringList &lines) const;
+    void telemetryUpdated() const;
+    void resourceProfileChanged() const;
+    void bootstrapStatusChanged() const;
 
 public slots:
     void printOutput();
     void printError();
     void stateChanged(QProcess::ProcessState state);
+    // connected to filter::userActivity
+    void userActivity();
 
 private:
     std::unique_ptr<QProcess> m_daemon;
@@ -84,6 +175,37 @@ private:
     bool m_app_exit = false;
     bool m_noSync = false;
     QString args = "";
+    // RPC endpoint of the daemon we started, empty host and zero port select the defaults
+    QString m_rpcHost;
+    quint16 m_rpcPort = 0;
+    mutable QMutex m_rpcEndpointMutex;
+    std::unique_ptr<RpcProbe> m_rpcProbe;
+
+    QByteArray m_stdoutPartialLine;
+    QByteArray m_stderrPartialLine;
+    QStringList m_pendingConsoleLines;
+    QContiguousCache<QString> m_consoleLines;
+    QTimer m_consoleFlushTimer;
+
+    NetworkType::Type m_startedNettype = NetworkType::MAINNET;
+    NetworkType::Type m_telemetryNettype = NetworkType::MAINNET;
+    QContiguousCache<TelemetrySample> m_telemetry;
+    TelemetrySample m_lastTelemetrySample;
+    QTimer m_telemetryTimer;
+    bool m_telemetrySampling = false;
+
+    NetworkType::Type m_bootstrapNettype = NetworkType::MAINNET;
+    QTimer m_bootstrapTimer;
+    bool m_bootstrapPolling = false;
+    bool m_bootstrapping = false;
+    bool m_localSynchronized = false;
+    quint64 m_localHeight = 0;
+    quint64 m_localTargetHeight = 0;
+
+    QString m_resourceProfile = "auto";
+    bool m_daemonRunning = false;
+    bool m_backgroundThrottled = false;
+    QTimer m_userIdleTimer;
 
     mutable FutureScheduler m_scheduler;
 };
@@ -0,0 +1,131 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "HostResources.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStorageInfo>
+#include <QThread>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_MAC)
+#include <sys/sysctl.h>
+#include <sys/types.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+quint64 physicalMemory()
+{
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    return GlobalMemoryStatusEx(&status) ? status.ullTotalPhys : 0;
+#elif defined(Q_OS_MAC)
+    int64_t memory = 0;
+    size_t size = sizeof(memory);
+    return sysctlbyname("hw.memsize", &memory, &size, nullptr, 0) == 0 ? static_cast<quint64>(memory) : 0;
+#else
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+    return pages > 0 && pageSize > 0 ? static_cast<quint64>(pages) * static_cast<quint64>(pageSize) : 0;
+#endif
+}
+
+HostResources::Storage storageKind(const QString &path)
+{
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    // walk from the partition up to the disk, only the disk has queue/rotational
+    const QStorageInfo storage(QFileInfo(path).exists() ? path : QFileInfo(path).absolutePath());
+    const QString device = QFileInfo(QString::fromLocal8Bit(storage.device())).canonicalFilePath();
+    if (!device.startsWith("/dev/"))
+    {
+        return HostResources::StorageUnknown;
+    }
+
+    QDir block(QFileInfo("/sys/class/block/" + QFileInfo(device).fileName()).canonicalFilePath());
+    for (int depth = 0; depth < 2 && block.exists(); ++depth)
+    {
+        QFile rotational(block.filePath("queue/rotational"));
+        if (rotational.open(QIODevice::ReadOnly))
+        {
+            return rotational.readAll().trimmed() == "0" ? HostResources::StorageSolidState : HostResources::StorageRotational;
+        }
+        block.cdUp();
+    }
+#else
+    Q_UNUSED(path);
+#endif
+    return HostResources::StorageUnknown;
+}
+
+bool onBattery()
+{
+#if defined(Q_OS_WIN)
+    SYSTEM_POWER_STATUS status;
+    return GetSystemPowerStatus(&status) && status.ACLineStatus == 0;
+#elif defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+    const QDir supplies("/sys/class/power_supply");
+    for (const QString &supply : supplies.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        QFile type(supplies.filePath(supply + "/type"));
+        QFile status(supplies.filePath(supply + "/status"));
+        if (type.open(QIODevice::ReadOnly) && type.readAll().trimmed() == "Battery" &&
+            status.open(QIODevice::ReadOnly) && status.readAll().trimmed() == "Discharging")
+        {
+            return true;
+        }
+    }
+    return false;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+HostResources HostResources::inspect(const QString &path)
+{
+    HostResources resources;
+    resources.cores = qMax(1, QThread::idealThreadCount());
+    resources.memoryBytes = physicalMemory();
+    resources.storage = storageKind(path);
+    resources.onBattery = onBattery();
+    return resources;
+}
+
+bool HostResources::batteryPowered()
+{
+    return onBattery();
+}
@@ -27,10 +27,25 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "AddressBook.h"
+#include "CsvReader.h"
 #include <QDebug>
+#include <QStringList>
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
 
-AddressBook::AddressBook(Monero::AddressBook *abImpl,QObject *parent)
-  : QObject(parent), m_addressBookImpl(abImpl)
+namespace
+{
+    QString entryKey(const QString &address, const QString &paymentId)
+    {
+        return address + QLatin1Char('\n') + paymentId;
+    }
+
+    // rows validated and committed at a time while importing
+    constexpr int IMPORT_CHUNK_ROWS = 1024;
+}
+
+AddressBook::AddressBook(Monero::AddressBook *abImpl, Monero::NetworkType nettype, QObject *parent)
+  : QObject(parent), m_addressBookImpl(abImpl), m_nettype(nettype)
 {
     getAll();
 }
@@ -47,32 +62,128 @@ int AddressBook::errorCode() const
 
 void AddressBook::getAll()
 {
-    emit refreshStarted();
+    std::vector<Monero::AddressBookRow> rows;
+    for (const auto *row : m_addressBookImpl->getAll())
+    {
+        rows.push_back(*row);
+    }
+    update(std::move(rows));
+}
 
+void AddressBook::update(std::vector<Monero::AddressBookRow> &&rows)
+{
+    const auto sameRow = [](const Monero::AddressBookRow &a, const Monero::AddressBookRow &b) {
+        return a.getAddress() == b.getAddress() && a.getPaymentId() == b.getPaymentId();
+    };
+    const size_t previous = m_rows.size();
+    const size_t current = rows.size();
+    size_t prefix = 0;
+    while (prefix < previous && prefix < current && sameRow(m_rows[prefix], rows[prefix]))
     {
-        QWriteLocker locker(&m_lock);
+        ++prefix;
+    }
+
+    if (prefix == previous)
+    {
+        int firstChanged = -1;
+        int lastChanged = -1;
+        for (size_t row = 0; row < previous; ++row)
+        {
+            if (m_rows[row].getDescription() != rows[row].getDescription())
+            {
+                if (firstChanged == -1)
+                {
+                    firstChanged = row;
+                }
+                lastChanged = row;
+            }
+        }
 
-        m_addresses.clear();
-        m_rows.clear();
-        for (auto &abr: m_addressBookImpl->getAll()) {
-            m_addresses.insert(QString::fromStdString(abr->getAddress()), m_rows.size());
-            m_rows.append(abr);
+        const bool appended = current > previous;
+        if (appended)
+        {
+            emit rowInsertionStarted(previous, current - 1);
         }
+        {
+            QWriteLocker locker(&m_lock);
+            m_rows = std::move(rows);
+            for (size_t row = previous; row < current; ++row)
+            {
+                indexRow(row);
+            }
+        }
+        if (appended)
+        {
+            emit rowInsertionFinished();
+        }
+
+        if (firstChanged != -1)
+        {
+            emit rowsChanged(firstChanged, lastChanged);
+        }
+        return;
     }
 
+    // deleting a row shifts the ones after it
+    if (current + 1 == previous)
+    {
+        bool removed = true;
+        for (size_t row = prefix; removed && row < current; ++row)
+        {
+            removed = sameRow(m_rows[row + 1], rows[row]);
+        }
+        if (removed)
+        {
+            emit rowRemovalStarted(prefix, prefix);
+            {
+                QWriteLocker locker(&m_lock);
+                m_rows = std::move(rows);
+                reindex();
+            }
+            emit rowRemovalFinished();
+            return;
+        }
+    }
+
+    emit refreshStarted();
+    {
+        QWriteLocker locker(&m_lock);
+        m_rows = std::move(rows);
+        reindex();
+    }
     emit refreshFinished();
 }
 
+void AddressBook::reindex()
+{
+    m_addresses.clear();
+    m_entries.clear();
+    m_addresses.reserve(m_rows.size());
+    m_entries.reserve(m_rows.size());
+    for (size_t row = 0; row < m_rows.size(); ++row)
+    {
+        indexRow(row);
+    }
+}
+
+void AddressBook::indexRow(size_t row)
+{
+    const Monero::AddressBookRow &entry = m_rows[row];
+    const QString address = QString::fromStdString(entry.getAddress());
+    m_addresses.insert(address, row);
+    m_entries.insert(entryKey(address, QString::fromStdString(entry.getPaymentId())), row);
+}
+
 bool AddressBook::getRow(int index, std::function<void (Monero::AddressBookRow &)> callback) const
 {
     QReadLocker locker(&m_lock);
 
-    if (index < 0 || index >= m_rows.size())
+    if (index < 0 || static_cast<size_t>(index) >= m_rows.size())
     {
         return false;
     }
 
-    callback(*m_rows.value(index));
+    callback(m_rows[index]);
     return true;
 }
 
@@ -125,12 +236,78 @@ QString AddressBook::getDescription(const QString &address) const
 {
     QReadLocker locker(&m_lock);
 
-    const QMap<QString, size_t>::const_iterator it = m_addresses.find(address);
-    if (it == m_addresses.end())
+    const QHash<QString, size_t>::const_iterator it = m_addresses.constFind(address);
+    if (it == m_addresses.constEnd())
     {
         return {};
     }
-    return QString::fromStdString(m_rows.value(*it)->getDescription());
+    return QString::fromStdString(m_rows[*it].getDescription());
+}
+
+int AddressBook::findRow(const QString &address, const QString &payment_id) const
+{
+    QReadLocker locker(&m_lock);
+
+    const QHash<QString, size_t>::const_iterator it = m_entries.constFind(entryKey(address, payment_id));
+    return it == m_entries.constEnd() ? -1 : static_cast<int>(*it);
+}
+
+int AddressBook::importCsv(const QString &path)
+{
+    CsvReader reader(path);
+    if (!reader.open())
+    {
+        qWarning() << "Failed to open" << path;
+        return -1;
+    }
+
+    struct Entry
+    {
+        QString address;
+        QString description;
+        QString paymentId;
+        bool valid;
+    };
+
+    int added = 0;
+    while (!reader.atEnd())
+    {
+        QVector<Entry> entries;
+        for (const QStringList &fields : reader.read(IMPORT_CHUNK_ROWS))
+        {
+            entries.append({fields.at(0), fields.value(1), fields.value(2), false});
+        }
+
+        // a header line or a malformed row is dropped here, libwallet only
+        // gets rows it accepts
+        QtConcurrent::blockingMap(entries, [this](Entry &entry) {
+            entry.valid = Monero::Wallet::addressValid(entry.address.toStdString(), m_nettype) &&
+                (entry.paymentId.isEmpty() || Monero::Wallet::paymentIdValid(entry.paymentId.toStdString()));
+        });
+
+        QWriteLocker locker(&m_lock);
+        for (const Entry &entry : entries)
+        {
+            const QString key = entryKey(entry.address, entry.paymentId);
+            if (!entry.valid || m_entries.contains(key))
+            {
+                continue;
+            }
+            if (m_addressBookImpl->addRow(entry.address.toStdString(), entry.paymentId.toStdString(), entry.description.toStdString()))
+            {
+                // keeps duplicates within the file out without a full update
+                m_entries.insert(key, m_rows.size() + added);
+                ++added;
+            }
+        }
+    }
+
+    // the rows are published once, in a single append
+    if (added > 0)
+    {
+        getAll();
+    }
+    return added;
 }
 
 void AddressBook::setDescription(int index, const QString &description)
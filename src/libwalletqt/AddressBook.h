@@ -29,8 +29,10 @@
 #ifndef ADDRESSBOOK_H
 #define ADDRESSBOOK_H
 
+#include <vector>
+
 #include <wallet/api/wallet2_api.h>
-#include <QMap>
+#include <QHash>
 #include <QObject>
 #include <QReadWriteLock>
 #include <QList>
@@ -53,6 +55,13 @@ public:
     Q_INVOKABLE int errorCode() const;
     Q_INVOKABLE QString getDescription(const QString &address) const;
     Q_INVOKABLE void setDescription(int index, const QString &label);
+    //! index of the row with the address and payment id, or -1
+    Q_INVOKABLE int findRow(const QString &address, const QString &payment_id = QString()) const;
+    //! adds "address,description[,payment id]" lines not in the book yet,
+    //! returns the number of rows added or -1 if the file can't be read.
+    //! The file is read in chunks whose addresses are validated in parallel,
+    //! the model is notified once at the end.
+    Q_INVOKABLE int importCsv(const QString &path);
 
     enum ErrorCode {
         Status_Ok,
@@ -65,21 +74,33 @@ public:
 
 private:
     void getAll();
+    void update(std::vector<Monero::AddressBookRow> &&rows);
+    void reindex();
+    void indexRow(size_t row);
 
 signals:
     void refreshStarted() const;
     void refreshFinished() const;
+    // rows are inserted, removed and changed in place, see AddressBookModel
+    void rowRemovalStarted(int first, int last) const;
+    void rowRemovalFinished() const;
+    void rowInsertionStarted(int first, int last) const;
+    void rowInsertionFinished() const;
+    void rowsChanged(int first, int last) const;
 
 
 public slots:
 
 private:
-    explicit AddressBook(Monero::AddressBook * abImpl, QObject *parent);
+    explicit AddressBook(Monero::AddressBook * abImpl, Monero::NetworkType nettype, QObject *parent);
     friend class Wallet;
     Monero::AddressBook * m_addressBookImpl;
+    const Monero::NetworkType m_nettype;
     mutable QReadWriteLock m_lock;
-    QList<Monero::AddressBookRow*> m_rows;
-    QMap<QString, size_t> m_addresses;
+    // copies, the rows owned by the wallet api are recreated on every change
+    std::vector<Monero::AddressBookRow> m_rows;
+    QHash<QString, size_t> m_addresses;
+    QHash<QString, size_t> m_entries;
 };
 
 #endif // ADDRESSBOOK_H
@@ -0,0 +1,106 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "CsvReader.h"
+
+CsvReader::CsvReader(const QString &path)
+    : m_file(path)
+{
+}
+
+bool CsvReader::open()
+{
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    return true;
+}
+
+bool CsvReader::atEnd() const
+{
+    return m_stream.device() == nullptr || m_stream.atEnd();
+}
+
+QVector<QStringList> CsvReader::read(int maxRows)
+{
+    QVector<QStringList> rows;
+    rows.reserve(maxRows);
+    while (rows.size() < maxRows && !atEnd())
+    {
+        const QString line = m_stream.readLine().trimmed();
+        if (!line.isEmpty())
+        {
+            rows.append(fields(line));
+        }
+    }
+    return rows;
+}
+
+QStringList CsvReader::fields(const QString &line)
+{
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+    for (int i = 0; i < line.size(); ++i)
+    {
+        const QChar c = line.at(i);
+        if (quoted)
+        {
+            if (c == QLatin1Char('"') && i + 1 < line.size() && line.at(i + 1) == QLatin1Char('"'))
+            {
+                field += c;
+                ++i;
+            }
+            else if (c == QLatin1Char('"'))
+            {
+                quoted = false;
+            }
+            else
+            {
+                field += c;
+            }
+        }
+        else if (c == QLatin1Char('"'))
+        {
+            quoted = true;
+        }
+        else if (c == QLatin1Char(','))
+        {
+            fields.append(field.trimmed());
+            field.clear();
+        }
+        else
+        {
+            field += c;
+        }
+    }
+    fields.append(field.trimmed());
+    return fields;
+}
@@ -0,0 +1,279 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "DaemonPool.h"
+#include "qt/NetworkStats.h"
+#include "qt/utils.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+#include <net/http.h>
+
+namespace
+{
+
+// untried nodes rank behind any node that answers within a second
+constexpr double DAEMON_POOL_UNKNOWN_LATENCY_MS = 1000;
+constexpr double DAEMON_POOL_LATENCY_WEIGHT = 0.3;
+constexpr int DAEMON_POOL_FAILOVER_FAILURES = 2;
+constexpr int DAEMON_POOL_FAILOVER_SLOW = 3;
+constexpr qint64 DAEMON_POOL_BACKOFF_MS = 30 * 1000;
+constexpr qint64 DAEMON_POOL_MAX_BACKOFF_MS = 10 * 60 * 1000;
+
+} // namespace
+
+DaemonPool::DaemonPool()
+    : m_current(-1)
+    , m_generation(0)
+    , m_hedgeClient(new net::http::client())
+    , m_hedgeIndex(-1)
+    , m_hedgeGeneration(0)
+{
+}
+
+DaemonPool::~DaemonPool() = default;
+
+void DaemonPool::setNodes(const std::vector<Node> &nodes, int current, const QString &proxyAddress)
+{
+    // not m_hedgeMutex, a hedge holds it for its whole request; the
+    // generation tells it to reconnect instead
+    QMutexLocker locker(&m_mutex);
+
+    // nodes that stay in the list keep their score
+    std::vector<Health> health(nodes.size());
+    for (size_t index = 0; index < nodes.size(); ++index)
+    {
+        for (size_t old = 0; old < m_nodes.size(); ++old)
+        {
+            if (m_nodes[old].address == nodes[index].address)
+            {
+                health[index] = m_health[old];
+                break;
+            }
+        }
+    }
+
+    m_nodes = nodes;
+    m_health = std::move(health);
+    m_proxyAddress = proxyAddress;
+    m_current = current >= 0 && current < static_cast<int>(m_nodes.size()) ? current : -1;
+    ++m_generation;
+}
+
+bool DaemonPool::enabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_current >= 0 && m_nodes.size() > 1;
+}
+
+QString DaemonPool::proxyAddress(const Node &node) const
+{
+    QMutexLocker locker(&m_mutex);
+    return isLocalAddress(node.address) ? QString() : m_proxyAddress;
+}
+
+void DaemonPool::recordSuccess(std::chrono::milliseconds latency, std::chrono::milliseconds budget)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_current < 0)
+    {
+        return;
+    }
+
+    Health &health = m_health[m_current];
+    health.latencyMs = health.latencyMs == 0
+        ? latency.count()
+        : health.latencyMs + DAEMON_POOL_LATENCY_WEIGHT * (latency.count() - health.latencyMs);
+    health.failures = 0;
+    health.backoffs = 0;
+    health.slow = latency > budget ? health.slow + 1 : 0;
+}
+
+void DaemonPool::recordFailure()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_current >= 0)
+    {
+        ++m_health[m_current].failures;
+    }
+}
+
+void DaemonPool::recordSlow()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_current >= 0)
+    {
+        ++m_health[m_current].slow;
+    }
+}
+
+bool DaemonPool::shouldFailover() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_current < 0)
+    {
+        return false;
+    }
+
+    const Health &health = m_health[m_current];
+    return (health.failures >= DAEMON_POOL_FAILOVER_FAILURES || health.slow >= DAEMON_POOL_FAILOVER_SLOW)
+        && healthiestOther() >= 0;
+}
+
+std::optional<DaemonPool::Candidate> DaemonPool::failover()
+{
+    QMutexLocker locker(&m_mutex);
+    const int other = healthiestOther();
+    if (m_current < 0 || other < 0)
+    {
+        return {};
+    }
+
+    // a node that keeps failing backs off for longer every time
+    Health &health = m_health[m_current];
+    health.backoff.setRemainingTime(std::min(DAEMON_POOL_BACKOFF_MS << std::min(health.backoffs, 5), DAEMON_POOL_MAX_BACKOFF_MS));
+    ++health.backoffs;
+    health.failures = 0;
+    health.slow = 0;
+
+    m_current = other;
+    return Candidate{other, m_nodes[other]};
+}
+
+std::optional<DaemonPool::Height> DaemonPool::hedgeHeight(std::chrono::milliseconds timeout)
+{
+    QMutexLocker hedgeLocker(&m_hedgeMutex);
+    QMutexLocker locker(&m_mutex);
+    const int index = healthiestOther();
+    if (index < 0)
+    {
+        return {};
+    }
+    const Node node = m_nodes[index];
+    const QString proxy = isLocalAddress(node.address) ? QString() : m_proxyAddress;
+    const quint64 generation = m_generation;
+    locker.unlock();
+
+    QElapsedTimer timer;
+    timer.start();
+    std::optional<Height> result;
+    try
+    {
+        if (index != m_hedgeIndex || generation != m_hedgeGeneration)
+        {
+            m_hedgeIndex = -1;
+            m_hedgeGeneration = generation;
+            boost::optional<epee::net_utils::http::login> login;
+            if (!node.username.isEmpty())
+            {
+                login.emplace(node.username.toStdString(), node.password.toStdString());
+            }
+            if (m_hedgeClient->set_proxy(proxy.toStdString()) && m_hedgeClient->set_server(node.address.toStdString(), login))
+            {
+                m_hedgeIndex = index;
+            }
+        }
+
+        const epee::net_utils::http::http_response_info *info = nullptr;
+        const epee::net_utils::http::fields_list headers({{"Content-Type", "application/json"}});
+        const std::string body = R"({"jsonrpc":"2.0","id":"0","method":"get_info"})";
+        bool responded = false;
+        if (m_hedgeIndex == index)
+        {
+            NetworkRequestScope stats(node.address, "daemon-hedge", body.size());
+            responded = m_hedgeClient->invoke("/json_rpc", "POST", body, timeout, std::addressof(info), headers) && info != nullptr;
+            if (responded)
+            {
+                stats.received(info->m_response_code, info->m_body.size());
+            }
+        }
+        if (responded && info->m_response_code == 200)
+        {
+            const QJsonObject fields = QJsonDocument::fromJson(QByteArray::fromStdString(info->m_body)).object().value("result").toObject();
+            if (fields.value("status").toString() == "OK")
+            {
+                result = Height{
+                    static_cast<quint64>(fields.value("height").toDouble()),
+                    static_cast<quint64>(fields.value("target_height").toDouble()),
+                };
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        qDebug() << "hedged daemon request failed:" << e.what();
+    }
+
+    // hedges keep the scores of the other nodes current
+    locker.relock();
+    if (index < static_cast<int>(m_health.size()) && m_nodes[index].address == node.address)
+    {
+        Health &health = m_health[index];
+        if (result)
+        {
+            const double latency = timer.elapsed();
+            health.latencyMs = health.latencyMs == 0 ? latency : health.latencyMs + DAEMON_POOL_LATENCY_WEIGHT * (latency - health.latencyMs);
+            health.failures = 0;
+        }
+        else
+        {
+            ++health.failures;
+        }
+    }
+    return result;
+}
+
+double DaemonPool::score(const Health &health) const
+{
+    const double latency = health.latencyMs == 0 ? DAEMON_POOL_UNKNOWN_LATENCY_MS : health.latencyMs;
+    return latency * (1 + health.failures + health.slow);
+}
+
+int DaemonPool::healthiestOther() const
+{
+    int best = -1;
+    for (int index = 0; index < static_cast<int>(m_nodes.size()); ++index)
+    {
+        if (index == m_current || !m_health[index].backoff.hasExpired())
+        {
+            continue;
+        }
+        if (best < 0 || score(m_health[index]) < score(m_health[best]))
+        {
+            best = index;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef DAEMONPOOL_H
+#define DAEMONPOOL_H
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <QDeadlineTimer>
+#include <QMutex>
+#include <QString>
+
+namespace epee { namespace net_utils { namespace http { class abstract_http_client; } } }
+
+// Remote nodes a wallet may fail over to, with a health score per node.
+// The wallet reports how every daemon status query went, an unhealthy
+// current node is swapped for the healthiest one not backing off.
+// Thread safe.
+class DaemonPool
+{
+public:
+    struct Node
+    {
+        QString address;
+        QString username;
+        QString password;
+        bool trusted = false;
+    };
+
+    struct Candidate
+    {
+        int index;
+        Node node;
+    };
+
+    struct Height
+    {
+        quint64 height;
+        quint64 targetHeight;
+    };
+
+    DaemonPool();
+    ~DaemonPool();
+
+    //! an empty list disables failover, current is the node libwallet is connected to
+    void setNodes(const std::vector<Node> &nodes, int current, const QString &proxyAddress);
+    bool enabled() const;
+    //! proxy for the given node, local nodes go direct
+    QString proxyAddress(const Node &node) const;
+
+    void recordSuccess(std::chrono::milliseconds latency, std::chrono::milliseconds budget);
+    void recordFailure();
+    //! the current node missed the budget and another node answered first
+    void recordSlow();
+    bool shouldFailover() const;
+    //! backs the current node off and makes the healthiest other node current
+    std::optional<Candidate> failover();
+
+    //! asks the healthiest other node for the chain height, used when the
+    //! current node misses its latency budget
+    std::optional<Height> hedgeHeight(std::chrono::milliseconds timeout);
+
+private:
+    struct Health
+    {
+        double latencyMs = 0;
+        int failures = 0;
+        int slow = 0;
+        int backoffs = 0;
+        QDeadlineTimer backoff;
+    };
+
+    double score(const Health &health) const;
+    int healthiestOther() const;
+
+private:
+    mutable QMutex m_mutex;
+    std::vector<Node> m_nodes;
+    std::vector<Health> m_health;
+    int m_current;
+    QString m_proxyAddress;
+    // bumped by setNodes, indexes and the proxy of older generations are stale
+    quint64 m_generation;
+
+    // the hedge client keeps its connection to the last node it asked
+    QMutex m_hedgeMutex;
+    std::unique_ptr<epee::net_utils::http::abstract_http_client> m_hedgeClient;
+    int m_hedgeIndex;
+    quint64 m_hedgeGeneration;
+};
+
+#endif // DAEMONPOOL_H
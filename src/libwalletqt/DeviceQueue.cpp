@@ -0,0 +1,194 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "DeviceQueue.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#include "qt/ScopeGuard.h"
+
+namespace
+{
+
+qint64 elapsedUs(DeviceQueue::Clock::time_point from, DeviceQueue::Clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+} // namespace
+
+DeviceQueue::DeviceQueue(FutureScheduler &scheduler, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_running(false)
+{
+}
+
+void DeviceQueue::enqueue(const char *name, std::function<void()> work)
+{
+    Operation operation;
+    operation.name = name;
+    operation.items.append(QVariant());
+    operation.run = [work = std::move(work)](const QVariantList &) {
+        work();
+    };
+    push(std::move(operation));
+}
+
+void DeviceQueue::enqueueBatch(const char *name, const QString &batchKey, const QVariant &item, BatchRunner run)
+{
+    Operation operation;
+    operation.name = name;
+    operation.batchKey = batchKey;
+    operation.items.append(item);
+    operation.run = std::move(run);
+    push(std::move(operation));
+}
+
+int DeviceQueue::pending() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_queue.size());
+}
+
+QString DeviceQueue::current() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_current;
+}
+
+QVariantList DeviceQueue::stats() const
+{
+    QVariantList result;
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_stats.constBegin(); it != m_stats.constEnd(); ++it)
+    {
+        const Stats &stats = it.value();
+        result.append(QVariantMap{
+            {"name", QString::fromUtf8(it.key())},
+            {"count", stats.count},
+            {"items", stats.items},
+            {"waitAvgMs", stats.count > 0 ? stats.waitUs / 1000.0 / stats.count : 0.0},
+            {"waitMaxMs", stats.maxWaitUs / 1000.0},
+            {"runAvgMs", stats.count > 0 ? stats.runUs / 1000.0 / stats.count : 0.0},
+            {"runMaxMs", stats.maxRunUs / 1000.0},
+        });
+    }
+    return result;
+}
+
+void DeviceQueue::push(Operation operation)
+{
+    operation.queued = Clock::now();
+    bool started = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        // the running operation already took its items, only waiting ones can grow
+        if (!operation.batchKey.isEmpty())
+        {
+            const auto waiting = std::find_if(m_queue.begin(), m_queue.end(), [&operation](const Operation &queued) {
+                return queued.batchKey == operation.batchKey;
+            });
+            if (waiting != m_queue.end())
+            {
+                waiting->items.append(operation.items);
+                return;
+            }
+        }
+
+        m_queue.push_back(std::move(operation));
+        started = !m_running;
+        startNext();
+    }
+
+    emit pendingChanged();
+    if (started)
+    {
+        emit currentChanged();
+    }
+}
+
+void DeviceQueue::startNext()
+{
+    while (!m_running && !m_queue.empty())
+    {
+        Operation operation = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        m_running = true;
+        m_current = QString::fromUtf8(operation.name);
+        const auto future = m_scheduler.run([this, operation] {
+            const Clock::time_point started = Clock::now();
+            // a throwing operation must not leave the queue stuck as running
+            const auto next = sg::make_scope_guard([this, &operation, started]() {
+                finished(operation, started);
+            });
+            operation.run(operation.items);
+        }, FutureScheduler::BlockingIO, operation.name);
+        if (!future.first)
+        {
+            // shutting down, nothing queued will run anymore
+            qDebug() << "Device operation dropped:" << operation.name;
+            m_running = false;
+            m_current.clear();
+            m_queue.clear();
+        }
+    }
+}
+
+void DeviceQueue::finished(const Operation &operation, Clock::time_point started)
+{
+    const Clock::time_point now = Clock::now();
+    const qint64 waitUs = elapsedUs(operation.queued, started);
+    const qint64 runUs = elapsedUs(started, now);
+    {
+        QMutexLocker locker(&m_mutex);
+        Stats &stats = m_stats[QByteArray(operation.name)];
+        ++stats.count;
+        stats.items += operation.items.size();
+        stats.waitUs += waitUs;
+        stats.maxWaitUs = std::max(stats.maxWaitUs, waitUs);
+        stats.runUs += runUs;
+        stats.maxRunUs = std::max(stats.maxRunUs, runUs);
+
+        m_running = false;
+        m_current.clear();
+        startNext();
+    }
+
+    qDebug().noquote() << "Device operation" << operation.name << "items" << operation.items.size()
+                       << "wait ms" << waitUs / 1000.0 << "run ms" << runUs / 1000.0;
+    emit operationFinished(QString::fromUtf8(operation.name), operation.items.size(), waitUs / 1000.0, runUs / 1000.0);
+    emit pendingChanged();
+    emit currentChanged();
+}
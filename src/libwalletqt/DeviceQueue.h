@@ -0,0 +1,118 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef DEVICEQUEUE_H
+#define DEVICEQUEUE_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariantList>
+
+#include "qt/FutureScheduler.h"
+
+/*!
+ * \brief Serializes the operations of a hardware wallet. Requests from QML
+ *        no longer race each other for the device, they run one after the
+ *        other on the BlockingIO lane. Requests of a batch key that are
+ *        still waiting are joined and run as one operation, e.g. every
+ *        subaddress derivation queued for an account. Wait and run times
+ *        are kept per operation name.
+ */
+class DeviceQueue : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int pending READ pending NOTIFY pendingChanged)
+    Q_PROPERTY(QString current READ current NOTIFY currentChanged)
+
+public:
+    using Clock = std::chrono::steady_clock;
+    //! receives the items of every request that joined the batch
+    using BatchRunner = std::function<void(const QVariantList &items)>;
+
+    //! scheduler must outlive the queue's operations, typically the wallet's own
+    DeviceQueue(FutureScheduler &scheduler, QObject *parent = nullptr);
+
+    //! work runs after every operation queued before it
+    void enqueue(const char *name, std::function<void()> work);
+    //! joins a waiting operation of batchKey or queues a new one running run
+    void enqueueBatch(const char *name, const QString &batchKey, const QVariant &item, BatchRunner run);
+
+    //! operations waiting, not counting the running one
+    int pending() const;
+    //! name of the running operation, empty while idle
+    QString current() const;
+
+    //! per operation name: name, count, items, wait and run avg/max ms
+    Q_INVOKABLE QVariantList stats() const;
+
+signals:
+    void pendingChanged() const;
+    void currentChanged() const;
+    void operationFinished(const QString &name, int items, double waitMs, double runMs) const;
+
+private:
+    struct Operation
+    {
+        const char *name = nullptr;
+        QString batchKey;
+        QVariantList items;
+        BatchRunner run;
+        Clock::time_point queued;
+    };
+
+    struct Stats
+    {
+        quint64 count = 0;
+        quint64 items = 0;
+        qint64 waitUs = 0;
+        qint64 maxWaitUs = 0;
+        qint64 runUs = 0;
+        qint64 maxRunUs = 0;
+    };
+
+    void push(Operation operation);
+    //! starts the front operation unless one runs, called with m_mutex held
+    void startNext();
+    void finished(const Operation &operation, Clock::time_point started);
+
+private:
+    FutureScheduler &m_scheduler;
+    mutable QMutex m_mutex;
+    std::deque<Operation> m_queue;
+    bool m_running;
+    QString m_current;
+    QHash<QByteArray, Stats> m_stats;
+};
+
+#endif // DEVICEQUEUE_H
@@ -0,0 +1,241 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "MiningStatusMonitor.h"
+
+#include <algorithm>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QVariantMap>
+
+namespace
+{
+
+constexpr int MINING_STATUS_WATCHED_INTERVAL_MS = 2000;
+// the watched poll slows down to this while nothing changes
+constexpr int MINING_STATUS_WATCHED_MAX_INTERVAL_MS = 10000;
+// keeps the status bar indicator honest while mining in the background
+constexpr int MINING_STATUS_BACKGROUND_INTERVAL_MS = 30000;
+// ten minutes at the watched interval
+constexpr int MINING_STATUS_HISTORY_SAMPLES = 300;
+
+} // namespace
+
+MiningStatusMonitor::MiningStatusMonitor(std::function<Status()> fetch, QObject *parent /* = nullptr */)
+    : QObject(parent)
+    , m_fetch(std::move(fetch))
+    , m_watched(false)
+    , m_fetching(false)
+    , m_refreshAgain(false)
+    , m_unchanged(0)
+    , m_scheduler(this)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &MiningStatusMonitor::fetch);
+}
+
+MiningStatusMonitor::~MiningStatusMonitor()
+{
+    m_scheduler.shutdownWaitForFinished();
+}
+
+bool MiningStatusMonitor::active() const
+{
+    return m_status.active;
+}
+
+double MiningStatusMonitor::hashRate() const
+{
+    return m_status.hashRate;
+}
+
+quint64 MiningStatusMonitor::networkDifficulty() const
+{
+    return m_status.networkDifficulty;
+}
+
+bool MiningStatusMonitor::watched() const
+{
+    return m_watched;
+}
+
+void MiningStatusMonitor::setWatched(bool watched)
+{
+    if (m_watched == watched)
+    {
+        return;
+    }
+
+    m_watched = watched;
+    emit watchedChanged();
+    if (m_watched)
+    {
+        refresh();
+    }
+    else
+    {
+        schedule();
+    }
+}
+
+void MiningStatusMonitor::refresh()
+{
+    m_unchanged = 0;
+    if (m_fetching)
+    {
+        m_refreshAgain = true;
+        return;
+    }
+    m_timer.stop();
+    fetch();
+}
+
+QVariantList MiningStatusMonitor::history() const
+{
+    QVariantList samples;
+    samples.reserve(m_history.size());
+    for (const Sample &sample : m_history)
+    {
+        samples.push_back(QVariantMap{
+            {"time", sample.time},
+            {"hashRate", sample.hashRate},
+        });
+    }
+    return samples;
+}
+
+double MiningStatusMonitor::averageHashRate() const
+{
+    if (m_history.isEmpty())
+    {
+        return 0;
+    }
+
+    double total = 0;
+    for (const Sample &sample : m_history)
+    {
+        total += sample.hashRate;
+    }
+    return total / m_history.size();
+}
+
+void MiningStatusMonitor::fetch()
+{
+    if (m_fetching)
+    {
+        return;
+    }
+
+    m_fetching = true;
+    const auto future = m_scheduler.run([this] {
+        Status status;
+        try
+        {
+            status = m_fetch();
+        }
+        catch (const std::exception &e)
+        {
+            qWarning() << "failed to fetch mining status:" << e.what();
+        }
+        QMetaObject::invokeMethod(this, [this, status] {
+            finishFetch(status);
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::Interactive, "MiningStatusMonitor::fetch");
+    if (!future.first)
+    {
+        m_fetching = false;
+    }
+}
+
+void MiningStatusMonitor::finishFetch(const Status &status)
+{
+    m_fetching = false;
+
+    const bool changed = status.active != m_status.active
+        || status.hashRate != m_status.hashRate
+        || status.networkDifficulty != m_status.networkDifficulty;
+    m_unchanged = changed ? 0 : m_unchanged + 1;
+
+    if (!status.active && m_status.active)
+    {
+        m_history.clear();
+        emit historyChanged();
+    }
+    m_status = status;
+    if (m_status.active)
+    {
+        if (m_history.size() >= MINING_STATUS_HISTORY_SAMPLES)
+        {
+            m_history.removeFirst();
+        }
+        m_history.push_back({QDateTime::currentMSecsSinceEpoch(), m_status.hashRate});
+        emit historyChanged();
+    }
+    if (changed)
+    {
+        emit statusUpdated(m_status.active, m_status.hashRate);
+    }
+
+    if (m_refreshAgain)
+    {
+        m_refreshAgain = false;
+        fetch();
+        return;
+    }
+    schedule();
+}
+
+void MiningStatusMonitor::schedule()
+{
+    if (m_fetching)
+    {
+        return;
+    }
+
+    int interval = 0;
+    if (m_watched)
+    {
+        interval = std::min(MINING_STATUS_WATCHED_INTERVAL_MS << std::min(m_unchanged / 5, 3), MINING_STATUS_WATCHED_MAX_INTERVAL_MS);
+    }
+    else if (m_status.active)
+    {
+        interval = MINING_STATUS_BACKGROUND_INTERVAL_MS;
+    }
+
+    if (interval == 0)
+    {
+        m_timer.stop();
+        return;
+    }
+    if (!m_timer.isActive() || m_timer.remainingTime() > interval)
+    {
+        m_timer.start(interval);
+    }
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef MININGSTATUSMONITOR_H
+#define MININGSTATUSMONITOR_H
+
+#include <functional>
+
+#include <QObject>
+#include <QTimer>
+#include <QVariantList>
+#include <QVector>
+
+#include "qt/FutureScheduler.h"
+
+// Polls the daemon's mining status on one schedule and pushes changes.
+// Polls every couple of seconds while the mining page is watching, slowly
+// while mining with nobody watching and not at all otherwise.
+class MiningStatusMonitor : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool active READ active NOTIFY statusUpdated)
+    Q_PROPERTY(double hashRate READ hashRate NOTIFY statusUpdated)
+    Q_PROPERTY(quint64 networkDifficulty READ networkDifficulty NOTIFY statusUpdated)
+    Q_PROPERTY(bool watched READ watched WRITE setWatched NOTIFY watchedChanged)
+
+public:
+    struct Status
+    {
+        bool active = false;
+        double hashRate = 0;
+        quint64 networkDifficulty = 0;
+    };
+
+    //! fetch runs on the scheduler and may block on daemon RPCs
+    MiningStatusMonitor(std::function<Status()> fetch, QObject *parent = nullptr);
+    ~MiningStatusMonitor();
+
+    bool active() const;
+    double hashRate() const;
+    quint64 networkDifficulty() const;
+    bool watched() const;
+    void setWatched(bool watched);
+
+    //! fetch as soon as possible, e.g. after mining was started or stopped
+    Q_INVOKABLE void refresh();
+    //! recent samples while mining, oldest first: {time (ms since epoch), hashRate}
+    Q_INVOKABLE QVariantList history() const;
+    //! mean of the samples in history(), 0 without any
+    Q_INVOKABLE double averageHashRate() const;
+
+signals:
+    void statusUpdated(bool active, double hashRate) const;
+    void historyChanged() const;
+    void watchedChanged() const;
+
+private:
+    void fetch();
+    void finishFetch(const Status &status);
+    void schedule();
+
+private:
+    struct Sample
+    {
+        qint64 time;
+        double hashRate;
+    };
+
+    std::function<Status()> m_fetch;
+    Status m_status;
+    bool m_watched;
+    bool m_fetching;
+    bool m_refreshAgain;
+    // polls that didn't change anything in a row, backs the watched poll off
+    int m_unchanged;
+    QVector<Sample> m_history;
+    QTimer m_timer;
+    FutureScheduler m_scheduler;
+};
+
+#endif // MININGSTATUSMONITOR_H
@@ -0,0 +1,216 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "OpenAliasResolver.h"
+
+#include <chrono>
+
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+// libwallet doesn't pass the records' TTL on, validated answers are trusted
+// for longer than unvalidated ones or misses
+constexpr std::chrono::milliseconds OPENALIAS_VALIDATED_TTL = 1h;
+constexpr std::chrono::milliseconds OPENALIAS_UNVALIDATED_TTL = 5min;
+constexpr std::chrono::milliseconds OPENALIAS_NEGATIVE_TTL = 2min;
+constexpr int OPENALIAS_CACHE_SIZE = 256;
+constexpr int OPENALIAS_MAX_PREFETCH = 8;
+constexpr int OPENALIAS_PREFETCH_CONCURRENCY = 2;
+
+} // namespace
+
+OpenAliasResolver::OpenAliasResolver(Lookup lookup, QObject *parent /* = nullptr */)
+    : QObject(parent)
+    , m_lookup(std::move(lookup))
+    , m_scheduler(this)
+{
+}
+
+OpenAliasResolver::~OpenAliasResolver()
+{
+    m_scheduler.shutdownWaitForFinished();
+}
+
+QString OpenAliasResolver::resolve(const QString &alias)
+{
+    const QString aliasKey = key(alias);
+    QString result;
+    if (cached(aliasKey, result))
+    {
+        return result;
+    }
+
+    result = m_lookup(aliasKey);
+    store(aliasKey, result);
+    return result;
+}
+
+void OpenAliasResolver::resolveAsync(const QString &alias, const QJSValue &callback)
+{
+    const QString aliasKey = key(alias);
+    QString result;
+    if (cached(aliasKey, result))
+    {
+        if (callback.isCallable())
+        {
+            callback.call({alias, result});
+        }
+        return;
+    }
+
+    const bool inFlight = m_pending.contains(aliasKey);
+    m_pending[aliasKey].push_back({alias, callback});
+    if (!inFlight)
+    {
+        start(aliasKey);
+    }
+}
+
+void OpenAliasResolver::prefetch(const QStringList &aliases)
+{
+    for (const QString &alias : aliases)
+    {
+        if (m_prefetchQueue.size() + m_prefetching.size() >= OPENALIAS_MAX_PREFETCH)
+        {
+            break;
+        }
+        const QString aliasKey = key(alias);
+        QString result;
+        if (m_pending.contains(aliasKey) || m_prefetchQueue.contains(aliasKey) || cached(aliasKey, result))
+        {
+            continue;
+        }
+        m_prefetchQueue.append(aliasKey);
+    }
+    startPrefetches();
+}
+
+void OpenAliasResolver::startPrefetches()
+{
+    while (m_prefetching.size() < OPENALIAS_PREFETCH_CONCURRENCY && !m_prefetchQueue.isEmpty())
+    {
+        const QString aliasKey = m_prefetchQueue.takeFirst();
+        QString result;
+        // resolved or requested since it was queued
+        if (m_pending.contains(aliasKey) || cached(aliasKey, result))
+        {
+            continue;
+        }
+        m_pending.insert(aliasKey, {});
+        m_prefetching.insert(aliasKey);
+        start(aliasKey);
+    }
+}
+
+QString OpenAliasResolver::key(const QString &alias)
+{
+    // DNS names are case insensitive
+    return alias.trimmed().toLower();
+}
+
+bool OpenAliasResolver::cached(const QString &key, QString &result)
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_cache.constFind(key);
+    if (it == m_cache.constEnd() || it->expiry.hasExpired())
+    {
+        return false;
+    }
+    result = it->result;
+    return true;
+}
+
+void OpenAliasResolver::store(const QString &key, const QString &result)
+{
+    std::chrono::milliseconds ttl = OPENALIAS_NEGATIVE_TTL;
+    const qsizetype separator = result.indexOf('|');
+    if (separator >= 0 && separator + 1 < result.size())
+    {
+        ttl = result.startsWith("true|") ? OPENALIAS_VALIDATED_TTL : OPENALIAS_UNVALIDATED_TTL;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_cache.size() >= OPENALIAS_CACHE_SIZE && !m_cache.contains(key))
+    {
+        for (auto it = m_cache.begin(); it != m_cache.end();)
+        {
+            it = it->expiry.hasExpired() ? m_cache.erase(it) : std::next(it);
+        }
+        if (m_cache.size() >= OPENALIAS_CACHE_SIZE)
+        {
+            m_cache.clear();
+        }
+    }
+    m_cache.insert(key, {result, QDeadlineTimer(ttl)});
+}
+
+void OpenAliasResolver::start(const QString &key)
+{
+    const auto future = m_scheduler.run([this, key] {
+        QString result;
+        try
+        {
+            result = m_lookup(key);
+            store(key, result);
+        }
+        catch (const std::exception &e)
+        {
+            // not cached, the next attempt may get through
+            qWarning() << "OpenAlias lookup failed:" << e.what();
+        }
+        QMetaObject::invokeMethod(this, [this, key, result] {
+            finish(key, result);
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "OpenAliasResolver::start");
+    if (!future.first)
+    {
+        finish(key, QString());
+    }
+}
+
+void OpenAliasResolver::finish(const QString &key, const QString &result)
+{
+    const QList<Waiter> waiters = m_pending.take(key);
+    for (const Waiter &waiter : waiters)
+    {
+        if (waiter.callback.isCallable())
+        {
+            waiter.callback.call({waiter.alias, result});
+        }
+    }
+    if (m_prefetching.remove(key))
+    {
+        startPrefetches();
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef OPENALIASRESOLVER_H
+#define OPENALIASRESOLVER_H
+
+#include <functional>
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QJSValue>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "qt/FutureScheduler.h"
+
+// OpenAlias lookups with a cache of positive and negative results.
+// Results are "true|address" or "false|address" like
+// WalletManager::resolveOpenAlias, the prefix tells whether DNSSEC validated.
+class OpenAliasResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! blocking DNS(SEC) lookup
+    using Lookup = std::function<QString(const QString &alias)>;
+
+    OpenAliasResolver(Lookup lookup, QObject *parent = nullptr);
+    ~OpenAliasResolver();
+
+    //! blocks on a cache miss, callable from any thread
+    QString resolve(const QString &alias);
+    //! callback(alias, result) on the resolver's thread, right away when cached.
+    //! Concurrent requests for one alias share a single lookup.
+    void resolveAsync(const QString &alias, const QJSValue &callback);
+    //! warms the cache with up to 8 aliases, looked up two at a
+    //! time so that speculative lookups leave BlockingIO to other work
+    void prefetch(const QStringList &aliases);
+
+private:
+    static QString key(const QString &alias);
+    bool cached(const QString &key, QString &result);
+    void store(const QString &key, const QString &result);
+    void start(const QString &key);
+    void startPrefetches();
+    void finish(const QString &key, const QString &result);
+
+private:
+    struct Entry
+    {
+        QString result;
+        QDeadlineTimer expiry;
+    };
+
+    struct Waiter
+    {
+        // as passed in, the key is normalized
+        QString alias;
+        QJSValue callback;
+    };
+
+    Lookup m_lookup;
+    QMutex m_mutex;
+    QHash<QString, Entry> m_cache;
+    // callbacks waiting for a lookup in flight, only touched on the resolver's thread
+    QHash<QString, QList<Waiter>> m_pending;
+    // prefetches waiting for a slot and in flight, only touched on the resolver's thread
+    QStringList m_prefetchQueue;
+    QSet<QString> m_prefetching;
+    FutureScheduler m_scheduler;
+};
+
+#endif // OPENALIASRESOLVER_H
@@ -29,31 +29,131 @@
 #include "QrCode.hpp"
 
 #include "QRCodeImageProvider.h"
+#include "qt/PerfTrace.h"
 
-QImage QRCodeImageProvider::genQrImage(const QString &id, QSize *size)
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace
 {
-  using namespace qrcodegen;
+  // QML asks for the same receive address again at different sizes
+  const int QR_CODE_CACHE_SIZE = 32;
+
+  qrcodegen::QrCode encode(const QString &id)
+  {
+    using namespace qrcodegen;
+
+    static QMutex mutex;
+    static QCache<QString, QrCode> cache(QR_CODE_CACHE_SIZE);
 
-  QrCode qrcode = QrCode::encodeText(id.toStdString().c_str(), QrCode::Ecc::MEDIUM);
-  unsigned int black = 0;
-  unsigned int white = 1;
-  unsigned int borderSize = 4;
-  unsigned int imageSize = qrcode.getSize() + (2 * borderSize);
-  QImage img = QImage(imageSize, imageSize, QImage::Format_Mono);
+    // wallet keys (view-only wallet codes) are not kept around
+    if (id.contains("_key="))
+      return QrCode::encodeText(id.toStdString().c_str(), QrCode::Ecc::MEDIUM);
+
+    QMutexLocker locker(&mutex);
+    if (const QrCode *cached = cache.object(id))
+      return *cached;
+    locker.unlock();
+
+    QrCode qrcode = QrCode::encodeText(id.toStdString().c_str(), QrCode::Ecc::MEDIUM);
+
+    locker.relock();
+    cache.insert(id, new QrCode(qrcode));
+    return qrcode;
+  }
+}
+
+QImage QRCodeImageProvider::genQrImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+  const PerfScope perf("QR image", id.size());
+  const qrcodegen::QrCode qrcode = encode(id);
+  const int borderSize = 4;
+  const int modules = qrcode.getSize() + (2 * borderSize);
+
+  int scale = 1;
+  if (requestedSize.isValid() && !requestedSize.isEmpty())
+    scale = std::max(1, std::min(requestedSize.width(), requestedSize.height()) / modules);
+  const int imageSize = modules * scale;
+
+  // Format_Mono: bit 7 of a byte is its leftmost pixel, 0 black and 1 white
+  QImage img(imageSize, imageSize, QImage::Format_Mono);
+  img.fill(1);
+  std::vector<uchar> line(img.bytesPerLine());
+  for (int y = 0; y < qrcode.getSize(); ++y)
+  {
+    std::fill(line.begin(), line.end(), 0xff);
+    for (int x = 0; x < qrcode.getSize(); ++x)
+    {
+      if (!qrcode.getModule(x, y))
+        continue;
+      const int first = (x + borderSize) * scale;
+      for (int pixel = first; pixel < first + scale; ++pixel)
+        line[pixel >> 3] &= ~(0x80 >> (pixel & 7));
+    }
+    const int firstRow = (y + borderSize) * scale;
+    for (int row = firstRow; row < firstRow + scale; ++row)
+      memcpy(img.scanLine(row), line.data(), line.size());
+  }
 
-  for (unsigned int y = 0; y < imageSize; ++y)
-    for (unsigned int x = 0; x < imageSize; ++x)
-      if ((x < borderSize) || (x >= imageSize - borderSize) || (y < borderSize) || (y >= imageSize - borderSize))
-        img.setPixel(x, y, white);
-      else
-        img.setPixel(x, y, qrcode.getModule(x - borderSize, y - borderSize) ? black : white);
   if (size)
     *size = QSize(imageSize, imageSize);
 
   return img;
 }
 
-QImage QRCodeImageProvider::requestImage(const QString &id, QSize *size, const QSize &/* requestedSize */)
+QRCodeImageProvider::QRCodeImageProvider()
+{
+  m_pool.setMaxThreadCount(2);
+}
+
+QQuickImageResponse *QRCodeImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+  QRCodeImageResponse *response = new QRCodeImageResponse(id, requestedSize);
+  m_pool.start(response);
+  return response;
+}
+
+QRCodeImageResponse::QRCodeImageResponse(const QString &id, const QSize &requestedSize)
+  : m_id(id)
+  , m_requestedSize(requestedSize)
+  , m_cancelled(false)
+{
+  // the engine owns the response, the pool must not delete it
+  setAutoDelete(false);
+}
+
+QQuickTextureFactory *QRCodeImageResponse::textureFactory() const
+{
+  return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+QString QRCodeImageResponse::errorString() const
+{
+  return m_error;
+}
+
+void QRCodeImageResponse::cancel()
+{
+  m_cancelled = true;
+}
+
+void QRCodeImageResponse::run()
 {
-  return genQrImage(id, size);
+  if (!m_cancelled)
+  {
+    try
+    {
+      m_image = QRCodeImageProvider::genQrImage(m_id, nullptr, m_requestedSize);
+    }
+    catch (const std::exception &e)
+    {
+      m_error = QString::fromStdString(e.what());
+    }
+  }
+  emit finished();
 }
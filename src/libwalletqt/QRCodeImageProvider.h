@@ -26,15 +26,41 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <atomic>
+
 #include <QImage>
-#include <QQuickImageProvider>
+#include <QQuickAsyncImageProvider>
+#include <QThreadPool>
 
-class QRCodeImageProvider: public QQuickImageProvider
+// Encodes and rasterizes on a worker thread, a response QML no longer
+// needs (e.g. the address changed) is cancelled before it does any work
+class QRCodeImageProvider: public QQuickAsyncImageProvider
 {
 public:
-  QRCodeImageProvider(): QQuickImageProvider(QQuickImageProvider::Image) {}
+  QRCodeImageProvider();
+
+  QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+  // modules are scaled by the largest integer factor that fits requestedSize
+  static QImage genQrImage(const QString &id, QSize *size, const QSize &requestedSize = QSize());
 
-  QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize);
-  static QImage genQrImage(const QString &id, QSize *size);
+private:
+  QThreadPool m_pool;
 };
 
+class QRCodeImageResponse: public QQuickImageResponse, public QRunnable
+{
+public:
+  QRCodeImageResponse(const QString &id, const QSize &requestedSize);
+
+  QQuickTextureFactory *textureFactory() const override;
+  QString errorString() const override;
+  void cancel() override;
+  void run() override;
+
+private:
+  const QString m_id;
+  const QSize m_requestedSize;
+  std::atomic<bool> m_cancelled;
+  QImage m_image;
+  QString m_error;
+};
@@ -0,0 +1,356 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "RestoreHeightTable.h"
+#include "qt/NetworkStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <net/http.h>
+
+namespace {
+    constexpr int NETTYPE_COUNT = 3;
+    const char *const NETTYPE_KEYS[NETTYPE_COUNT] = {"mainnet", "testnet", "stagenet"};
+
+    // block timestamps may lag by up to the median of the last 60 blocks,
+    // and neighbouring checkpoints are interpolated linearly
+    constexpr qint64 SAFETY_MARGIN = 7 * 24 * 60 * 60;
+    // past the last checkpoint the height is extrapolated, as loosely as the
+    // estimate used without a table
+    constexpr qint64 EXTRAPOLATION_MARGIN = 30 * 24 * 60 * 60;
+    constexpr qint64 DIFFICULTY_TARGET = 120;
+    // a week of blocks
+    constexpr quint64 CHECKPOINT_SPACING = 5040;
+    // the tip may still reorganize
+    constexpr quint64 CHECKPOINT_MIN_DEPTH = 720;
+    constexpr size_t CHECKPOINT_FETCH_LIMIT = 512;
+    // average block time between checkpoints a daemon may report
+    constexpr qint64 MIN_BLOCK_TIME = DIFFICULTY_TARGET / 2;
+    constexpr qint64 MAX_BLOCK_TIME = DIFFICULTY_TARGET * 2;
+    constexpr std::chrono::seconds DAEMON_TIMEOUT{30};
+
+    // Hard fork activations, timestamps rounded up to the end of the day in
+    // UTC so a date never maps to a later height. Testnet and stagenet were
+    // rolled back too often to ship anything for them.
+    const RestoreHeightTable::Checkpoint MAINNET_CHECKPOINTS[] = {
+        {1, 1397818193},
+        {1009827, 1458748658},
+        {1546000, 1523059199},
+        {1685555, 1539907199},
+        {1788000, 1552175999},
+        {1978433, 1575158399},
+        {2210000, 1602979199},
+        {2688888, 1660435199},
+    };
+
+    QString tableFilePath()
+    {
+        return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/restore_heights.json";
+    }
+}
+
+RestoreHeightTable *RestoreHeightTable::instance()
+{
+    static RestoreHeightTable *table = new RestoreHeightTable();
+    return table;
+}
+
+RestoreHeightTable::RestoreHeightTable()
+{
+    m_checkpoints[NetworkType::MAINNET].assign(std::begin(MAINNET_CHECKPOINTS), std::end(MAINNET_CHECKPOINTS));
+    load();
+}
+
+std::optional<quint64> RestoreHeightTable::height(NetworkType::Type nettype, qint64 timestamp) const
+{
+    QMutexLocker locker(&m_mutex);
+    const std::vector<Checkpoint> &table = m_checkpoints[nettype];
+    if (table.empty())
+    {
+        return std::nullopt;
+    }
+
+    const qint64 target = timestamp - SAFETY_MARGIN;
+    if (target <= table.front().timestamp)
+    {
+        // only a table starting at the genesis block covers dates before it
+        return table.front().height <= 1 ? std::optional<quint64>(0) : std::nullopt;
+    }
+
+    const auto next = std::upper_bound(table.begin(), table.end(), target, [](qint64 timestamp, const Checkpoint &checkpoint) {
+        return timestamp < checkpoint.timestamp;
+    });
+    const Checkpoint &previous = *std::prev(next);
+    if (next == table.end())
+    {
+        const qint64 elapsed = timestamp - EXTRAPOLATION_MARGIN - previous.timestamp;
+        return previous.height + std::max<qint64>(elapsed, 0) / DIFFICULTY_TARGET;
+    }
+
+    const qint64 blocks = next->height - previous.height;
+    const qint64 span = next->timestamp - previous.timestamp;
+    return previous.height + static_cast<quint64>((target - previous.timestamp) * blocks / span);
+}
+
+int RestoreHeightTable::extendFromDaemon(
+    NetworkType::Type nettype,
+    const QString &address,
+    const QString &username,
+    const QString &password,
+    const QString &proxyAddress)
+{
+    try
+    {
+        net::http::client client;
+        if (!proxyAddress.isEmpty() && !client.set_proxy(proxyAddress.toStdString()))
+        {
+            throw std::runtime_error("failed to set proxy address");
+        }
+        boost::optional<epee::net_utils::http::login> login;
+        if (!username.isEmpty())
+        {
+            login.emplace(username.toStdString(), password.toStdString());
+        }
+        if (!client.set_server(address.toStdString(), login))
+        {
+            throw std::runtime_error("invalid address");
+        }
+
+        const auto jsonRpc = [&client, &address](const char *method, const QJsonObject &params) {
+            const QJsonObject request{
+                {"jsonrpc", "2.0"},
+                {"id", "0"},
+                {"method", method},
+                {"params", params},
+            };
+            const std::string body = QJsonDocument(request).toJson(QJsonDocument::Compact).toStdString();
+            const epee::net_utils::http::http_response_info *info = nullptr;
+            const epee::net_utils::http::fields_list headers({{"Content-Type", "application/json"}});
+            NetworkRequestScope stats(address, "restore-height", body.size());
+            if (!client.invoke("/json_rpc", "POST", body, DAEMON_TIMEOUT, std::addressof(info), headers) || info == nullptr)
+            {
+                throw std::runtime_error("no response");
+            }
+            stats.received(info->m_response_code, info->m_body.size());
+            if (info->m_response_code != 200)
+            {
+                throw std::runtime_error(QString("HTTP status %1").arg(info->m_response_code).toStdString());
+            }
+            const QJsonObject result = QJsonDocument::fromJson(QByteArray::fromStdString(info->m_body)).object().value("result").toObject();
+            if (result.value("status").toString() != "OK")
+            {
+                throw std::runtime_error(QString("%1 failed").arg(method).toStdString());
+            }
+            return result;
+        };
+
+        const QJsonObject info = jsonRpc("get_info", {});
+        if (info.value("nettype").toString() != NETTYPE_KEYS[nettype] || !info.value("synchronized").toBool())
+        {
+            return 0;
+        }
+        const std::vector<quint64> heights = missingHeights(nettype, static_cast<quint64>(info.value("height").toDouble()));
+        if (heights.empty())
+        {
+            return 0;
+        }
+
+        QJsonArray requested;
+        for (const quint64 height : heights)
+        {
+            requested.append(static_cast<qint64>(height));
+        }
+        const QJsonArray headers = jsonRpc("get_block_header_by_height", {{"heights", requested}}).value("block_headers").toArray();
+
+        std::vector<Checkpoint> checkpoints;
+        checkpoints.reserve(headers.size());
+        for (const QJsonValue &header : headers)
+        {
+            const QJsonObject fields = header.toObject();
+            checkpoints.push_back({
+                static_cast<quint64>(fields.value("height").toDouble()),
+                static_cast<qint64>(fields.value("timestamp").toDouble()),
+            });
+        }
+        const int added = merge(nettype, std::move(checkpoints));
+        if (added > 0)
+        {
+            qDebug() << "Added" << added << "restore height checkpoints from the daemon";
+        }
+        return added;
+    }
+    catch (const std::exception &e)
+    {
+        qWarning() << "Failed to extend restore height table:" << e.what();
+        return 0;
+    }
+}
+
+std::vector<quint64> RestoreHeightTable::missingHeights(NetworkType::Type nettype, quint64 blockchainHeight) const
+{
+    QMutexLocker locker(&m_mutex);
+    const std::vector<Checkpoint> &table = m_checkpoints[nettype];
+
+    std::vector<quint64> heights;
+    if (blockchainHeight <= CHECKPOINT_MIN_DEPTH)
+    {
+        return heights;
+    }
+    const quint64 last = blockchainHeight - CHECKPOINT_MIN_DEPTH;
+    quint64 height = table.empty() ? CHECKPOINT_SPACING : table.back().height + CHECKPOINT_SPACING;
+    for (; height <= last && heights.size() < CHECKPOINT_FETCH_LIMIT; height += CHECKPOINT_SPACING)
+    {
+        heights.push_back(height);
+    }
+    return heights;
+}
+
+int RestoreHeightTable::merge(NetworkType::Type nettype, std::vector<Checkpoint> checkpoints)
+{
+    std::sort(checkpoints.begin(), checkpoints.end(), [](const Checkpoint &left, const Checkpoint &right) {
+        return left.height < right.height;
+    });
+
+    QMutexLocker locker(&m_mutex);
+    std::vector<Checkpoint> &table = m_checkpoints[nettype];
+    int added = 0;
+    for (const Checkpoint &checkpoint : checkpoints)
+    {
+        if (!plausible(table, checkpoint))
+        {
+            qWarning() << "Ignoring implausible restore height checkpoint" << checkpoint.height << checkpoint.timestamp;
+            break;
+        }
+        table.push_back(checkpoint);
+        m_learned[nettype].push_back(checkpoint);
+        ++added;
+    }
+    if (added > 0)
+    {
+        save();
+    }
+    return added;
+}
+
+bool RestoreHeightTable::plausible(const std::vector<Checkpoint> &table, const Checkpoint &checkpoint)
+{
+    // a lying daemon must not move restores past the blocks with the user's funds
+    if (checkpoint.timestamp <= MAINNET_CHECKPOINTS[0].timestamp
+        || checkpoint.timestamp > QDateTime::currentSecsSinceEpoch() + 2 * 60 * 60)
+    {
+        return false;
+    }
+    if (table.empty())
+    {
+        return true;
+    }
+
+    const Checkpoint &last = table.back();
+    if (checkpoint.height <= last.height || checkpoint.timestamp <= last.timestamp)
+    {
+        return false;
+    }
+    const qint64 blockTime = (checkpoint.timestamp - last.timestamp) / static_cast<qint64>(checkpoint.height - last.height);
+    return blockTime >= MIN_BLOCK_TIME && blockTime <= MAX_BLOCK_TIME;
+}
+
+void RestoreHeightTable::load()
+{
+    QFile file(tableFilePath());
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+
+    // flat [height, timestamp, ...] per network, only what was learned
+    const QJsonObject networks = QJsonDocument::fromJson(file.readAll()).object();
+    for (int nettype = 0; nettype < NETTYPE_COUNT; ++nettype)
+    {
+        const QJsonArray values = networks.value(NETTYPE_KEYS[nettype]).toArray();
+        std::vector<Checkpoint> checkpoints;
+        for (int index = 0; index + 1 < values.size(); index += 2)
+        {
+            checkpoints.push_back({
+                static_cast<quint64>(values[index].toDouble()),
+                static_cast<qint64>(values[index + 1].toDouble()),
+            });
+        }
+        for (const Checkpoint &checkpoint : checkpoints)
+        {
+            if (!plausible(m_checkpoints[nettype], checkpoint))
+            {
+                break;
+            }
+            m_checkpoints[nettype].push_back(checkpoint);
+            m_learned[nettype].push_back(checkpoint);
+        }
+    }
+}
+
+void RestoreHeightTable::save() const
+{
+    QJsonObject networks;
+    for (int nettype = 0; nettype < NETTYPE_COUNT; ++nettype)
+    {
+        QJsonArray values;
+        for (const Checkpoint &checkpoint : m_learned[nettype])
+        {
+            values.append(static_cast<qint64>(checkpoint.height));
+            values.append(checkpoint.timestamp);
+        }
+        if (!values.isEmpty())
+        {
+            networks.insert(NETTYPE_KEYS[nettype], values);
+        }
+    }
+
+    const QString path = tableFilePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Failed to save restore height table" << path;
+        return;
+    }
+    file.write(QJsonDocument(networks).toJson(QJsonDocument::Compact));
+    file.commit();
+}
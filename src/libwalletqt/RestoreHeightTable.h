@@ -0,0 +1,83 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef RESTOREHEIGHTTABLE_H
+#define RESTOREHEIGHTTABLE_H
+
+#include <optional>
+#include <vector>
+
+#include <QMutex>
+#include <QString>
+
+#include "NetworkType.h"
+
+// Block height to timestamp checkpoints for turning a date into a restore
+// height without asking a daemon. Mainnet ships with its hard fork heights,
+// every network is extended with weekly checkpoints from a trusted daemon.
+// Thread safe.
+class RestoreHeightTable
+{
+public:
+    struct Checkpoint
+    {
+        quint64 height;
+        qint64 timestamp;
+    };
+
+    static RestoreHeightTable *instance();
+
+    //! tightest height still safely before timestamp, nothing without checkpoints to go by
+    std::optional<quint64> height(NetworkType::Type nettype, qint64 timestamp) const;
+
+    //! blocking, fetches the checkpoints missing up to the daemon's height,
+    //! returns how many were added
+    int extendFromDaemon(
+        NetworkType::Type nettype,
+        const QString &address,
+        const QString &username,
+        const QString &password,
+        const QString &proxyAddress);
+
+private:
+    RestoreHeightTable();
+
+    std::vector<quint64> missingHeights(NetworkType::Type nettype, quint64 blockchainHeight) const;
+    int merge(NetworkType::Type nettype, std::vector<Checkpoint> checkpoints);
+    static bool plausible(const std::vector<Checkpoint> &table, const Checkpoint &checkpoint);
+    void load();
+    void save() const;
+
+private:
+    mutable QMutex m_mutex;
+    std::vector<Checkpoint> m_learned[3];
+    std::vector<Checkpoint> m_checkpoints[3];
+};
+
+#endif // RESTOREHEIGHTTABLE_H
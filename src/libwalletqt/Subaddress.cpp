@@ -28,6 +28,7 @@
 
 #include "Subaddress.h"
 #include <QDebug>
+#include <QThread>
 
 Subaddress::Subaddress(Monero::Subaddress *subaddressImpl, QObject *parent)
   : QObject(parent), m_subaddressImpl(subaddressImpl)
@@ -37,30 +38,84 @@ Subaddress::Subaddress(Monero::Subaddress *subaddressImpl, QObject *parent)
 
 void Subaddress::getAll() const
 {
-    emit refreshStarted();
+    std::vector<Monero::SubaddressRow> rows;
+    for (const auto *row : m_subaddressImpl->getAll())
+    {
+        rows.push_back(*row);
+    }
 
+    // the wallet refreshes on a worker thread, models only see changes on ours
+    if (QThread::currentThread() != thread())
     {
-        QWriteLocker locker(&m_lock);
+        QMetaObject::invokeMethod(const_cast<Subaddress *>(this), [this, rows = std::move(rows)]() mutable {
+            update(std::move(rows));
+        }, Qt::QueuedConnection);
+        return;
+    }
+    update(std::move(rows));
+}
+
+void Subaddress::update(std::vector<Monero::SubaddressRow> &&rows) const
+{
+    const size_t previous = m_rows.size();
+    bool sameRows = rows.size() >= previous;
+    for (size_t index = 0; sameRows && index < previous; ++index)
+    {
+        sameRows = rows[index].getAddress() == m_rows[index].getAddress();
+    }
+
+    // anything but new rows at the end, e.g. another account, starts over
+    if (!sameRows)
+    {
+        emit refreshStarted();
+        {
+            QWriteLocker locker(&m_lock);
+            m_rows = std::move(rows);
+        }
+        emit refreshFinished();
+        return;
+    }
 
-        m_rows.clear();
-        for (auto &row: m_subaddressImpl->getAll()) {
-            m_rows.append(row);
+    int firstChanged = -1;
+    int lastChanged = -1;
+    for (size_t index = 0; index < previous; ++index)
+    {
+        if (rows[index].getLabel() != m_rows[index].getLabel())
+        {
+            if (firstChanged == -1)
+            {
+                firstChanged = index;
+            }
+            lastChanged = index;
         }
     }
 
-    emit refreshFinished();
+    const size_t current = rows.size();
+    {
+        QWriteLocker locker(&m_lock);
+        m_rows = std::move(rows);
+    }
+
+    if (firstChanged != -1)
+    {
+        emit rowsChanged(firstChanged, lastChanged);
+    }
+    if (current > previous)
+    {
+        emit rowsAppended(previous, current - 1);
+    }
 }
 
 bool Subaddress::getRow(int index, std::function<void (Monero::SubaddressRow &row)> callback) const
 {
     QReadLocker locker(&m_lock);
 
-    if (index < 0 || index >= m_rows.size())
+    if (index < 0 || static_cast<size_t>(index) >= m_rows.size())
     {
         return false;
     }
 
-    callback(*m_rows.value(index));
+    callback(m_rows[index]);
     return true;
 }
 
@@ -30,6 +30,7 @@
 #define SUBADDRESS_H
 
 #include <functional>
+#include <vector>
 
 #include <wallet/api/wallet2_api.h>
 #include <QReadWriteLock>
@@ -51,15 +52,20 @@ public:
 signals:
     void refreshStarted() const;
     void refreshFinished() const;
+    // emitted after the rows were updated in place
+    void rowsAppended(int first, int last) const;
+    void rowsChanged(int first, int last) const;
 
 public slots:
 
 private:
     explicit Subaddress(Monero::Subaddress * subaddressImpl, QObject *parent);
     friend class Wallet;
+    void update(std::vector<Monero::SubaddressRow> &&rows) const;
     mutable QReadWriteLock m_lock;
     Monero::Subaddress * m_subaddressImpl;
-    mutable QList<Monero::SubaddressRow*> m_rows;
+    // copies, the rows owned by the wallet api are recreated on every refresh
+    mutable std::vector<Monero::SubaddressRow> m_rows;
 };
 
 #endif // SUBADDRESS_H
@@ -30,6 +30,7 @@
 #define SUBADDRESSACCOUNT_H
 
 #include <functional>
+#include <vector>
 
 #include <wallet/api/wallet2_api.h>
 #include <QObject>
@@ -51,15 +52,20 @@ public:
 signals:
     void refreshStarted() const;
     void refreshFinished() const;
+    // emitted after the rows were updated in place
+    void rowsAppended(int first, int last) const;
+    void rowsChanged(int first, int last) const;
 
 public slots:
 
 private:
     explicit SubaddressAccount(Monero::SubaddressAccount * subaddressAccountImpl, QObject *parent);
     friend class Wallet;
+    void update(std::vector<Monero::SubaddressAccountRow> &&rows) const;
     mutable QReadWriteLock m_lock;
     Monero::SubaddressAccount * m_subaddressAccountImpl;
-    mutable QList<Monero::SubaddressAccountRow*> m_rows;
+    // copies, the rows owned by the wallet api are recreated on every refresh
+    mutable std::vector<Monero::SubaddressAccountRow> m_rows;
 };
 
 #endif // SUBADDRESSACCOUNT_H
@@ -0,0 +1,153 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "SubaddressLookahead.h"
+
+#include <algorithm>
+
+#include <QMutexLocker>
+
+namespace
+{
+
+// public spend key and index plus the hash table node libwallet keeps per entry
+constexpr quint64 BYTES_PER_ENTRY = 80;
+// one scalar multiplication and point addition per derived key
+constexpr double BUILD_MS_PER_ENTRY = 0.05;
+
+quint32 roundUp(quint64 value, quint32 batch)
+{
+    return static_cast<quint32>((value + batch - 1) / batch * batch);
+}
+
+} // namespace
+
+SubaddressLookahead::SubaddressLookahead(QObject *parent)
+    : QObject(parent)
+    , m_minor(DEFAULT_MINOR)
+{
+}
+
+void SubaddressLookahead::restore(quint32 minor)
+{
+    QMutexLocker locker(&m_mutex);
+    m_minor = std::clamp(minor, DEFAULT_MINOR, MAX_MINOR);
+}
+
+bool SubaddressLookahead::update(const QHash<quint32, SubaddressUsage> &usage)
+{
+    quint32 largestGap = 0;
+    for (const SubaddressUsage &account : usage)
+    {
+        largestGap = std::max(largestGap, account.largestGap);
+    }
+
+    bool grown = false;
+    bool usageChanged = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        usageChanged = m_usage != usage;
+        m_usage = usage;
+        // grown ahead of demand, a gap as wide as the lookahead would already be missed
+        const quint32 wanted = std::min(MAX_MINOR, roundUp(2ull * largestGap, GROWTH_BATCH));
+        if (wanted > m_minor)
+        {
+            m_minor = wanted;
+            grown = true;
+        }
+    }
+    if (grown || usageChanged)
+    {
+        emit changed();
+    }
+    return grown;
+}
+
+bool SubaddressLookahead::grow()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_minor >= MAX_MINOR)
+        {
+            return false;
+        }
+        m_minor = std::min(MAX_MINOR, roundUp(m_minor + 1ull, GROWTH_BATCH));
+    }
+    emit changed();
+    return true;
+}
+
+quint32 SubaddressLookahead::major() const
+{
+    return DEFAULT_MAJOR;
+}
+
+quint32 SubaddressLookahead::minor() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_minor;
+}
+
+std::optional<SubaddressUsage> SubaddressLookahead::usage(quint32 accountIndex) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_usage.constFind(accountIndex);
+    if (it == m_usage.constEnd())
+    {
+        return {};
+    }
+    return *it;
+}
+
+QVariantMap SubaddressLookahead::cost(const QVector<quint32> &numSubaddresses) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // every account is covered a lookahead past its highest used or created
+    // address, and major accounts past the last one a lookahead each
+    quint64 entries = static_cast<quint64>(DEFAULT_MAJOR) * m_minor;
+    for (int account = 0; account < numSubaddresses.size(); ++account)
+    {
+        quint64 covered = numSubaddresses[account];
+        const auto usage = m_usage.constFind(static_cast<quint32>(account));
+        if (usage != m_usage.constEnd())
+        {
+            covered = std::max<quint64>(covered, usage->highestUsed + 1ull);
+        }
+        entries += covered + m_minor;
+    }
+
+    return QVariantMap{
+        {"major", DEFAULT_MAJOR},
+        {"minor", m_minor},
+        {"tableEntries", entries},
+        {"estimatedBytes", entries * BYTES_PER_ENTRY},
+        {"estimatedBuildMs", entries * BUILD_MS_PER_ENTRY},
+    };
+}
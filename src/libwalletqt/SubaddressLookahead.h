@@ -0,0 +1,100 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SUBADDRESSLOOKAHEAD_H
+#define SUBADDRESSLOOKAHEAD_H
+
+#include <optional>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariantMap>
+#include <QVector>
+
+//! incoming transfers per account, see TransactionHistory::subaddressUsage
+struct SubaddressUsage
+{
+    quint32 highestUsed = 0;
+    //! widest run of unused indices below highestUsed, a merchant hands out at least that many ahead
+    quint32 largestGap = 0;
+
+    bool operator==(const SubaddressUsage &other) const
+    {
+        return highestUsed == other.highestUsed && largestGap == other.largestGap;
+    }
+};
+
+/*!
+ * \brief Sizes libwallet's subaddress lookahead from the incoming transfers
+ *        instead of a fixed table. The minor lookahead grows in batches to
+ *        twice the widest gap between used indices of any account and never
+ *        shrinks, payments to a handed out address keep being detected.
+ *        Growth only covers blocks scanned afterwards, earlier transfers to
+ *        the newly covered addresses need a rescan. Thread safe.
+ */
+class SubaddressLookahead : public QObject
+{
+    Q_OBJECT
+
+public:
+    // libwallet's defaults
+    static constexpr quint32 DEFAULT_MAJOR = 50;
+    static constexpr quint32 DEFAULT_MINOR = 200;
+    static constexpr quint32 GROWTH_BATCH = 1000;
+    static constexpr quint32 MAX_MINOR = 200000;
+
+    explicit SubaddressLookahead(QObject *parent = nullptr);
+
+    //! minor lookahead of an earlier session, values below the default are ignored
+    void restore(quint32 minor);
+    //! returns true if the minor lookahead grew, changed() is only emitted
+    //! if the usage or the minor lookahead differ from the last update
+    bool update(const QHash<quint32, SubaddressUsage> &usage);
+    //! grows the minor lookahead by one batch, false at MAX_MINOR
+    bool grow();
+
+    quint32 major() const;
+    quint32 minor() const;
+    std::optional<SubaddressUsage> usage(quint32 accountIndex) const;
+
+    //! addresses libwallet keeps keys for with numSubaddresses created per account:
+    //! tableEntries, estimatedBytes and estimatedBuildMs for generating them
+    QVariantMap cost(const QVector<quint32> &numSubaddresses) const;
+
+signals:
+    void changed() const;
+
+private:
+    mutable QMutex m_mutex;
+    quint32 m_minor;
+    QHash<quint32, SubaddressUsage> m_usage;
+};
+
+#endif // SUBADDRESSLOOKAHEAD_H
@@ -0,0 +1,132 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "SyncProfile.h"
+#include "qt/PerfTrace.h"
+
+#include <QMutexLocker>
+#include <QtGlobal>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+qint64 SyncProfile::processCpuMs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        return 0;
+    }
+    const auto ticks = [](const FILETIME &time) {
+        return (static_cast<qint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    // 100 ns units
+    return (ticks(kernel) + ticks(user)) / 10000;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 +
+        (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#endif
+}
+
+qint64 SyncProfile::peakRssKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(Q_OS_MACOS)
+    // bytes on macOS, kilobytes elsewhere
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+void SyncProfile::start(quint64 height)
+{
+    if (!perfTrace().isDebugEnabled())
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (auto &counter : m_counters)
+    {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    m_startHeight = height;
+    m_startCpuMs = processCpuMs();
+    m_timer.start();
+    m_running = true;
+}
+
+void SyncProfile::finish(quint64 height)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    const auto counter = [this](Counter counter) {
+        return m_counters[counter].load(std::memory_order_relaxed);
+    };
+    qCDebug(perfTrace).nospace()
+        << "wallet sync: " << (height > m_startHeight ? height - m_startHeight : 0) << " blocks"
+        << ", wall " << m_timer.elapsed() << " ms"
+        << ", cpu " << processCpuMs() - m_startCpuMs << " ms"
+        << ", peak rss " << peakRssKb() << " kB"
+        << ", newBlock " << counter(NewBlockSignals) << "/" << counter(NewBlockCallbacks)
+        << ", refreshed " << counter(RefreshedSignals)
+        << ", updated " << counter(UpdatedSignals)
+        << ", transfers " << counter(TransferSignals)
+        << ", history refreshes " << counter(HistoryRefreshes)
+        << ", history height updates " << counter(HistoryHeightUpdates)
+        << ", subaddress refreshes " << counter(SubaddressRefreshes);
+}
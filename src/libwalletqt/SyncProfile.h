@@ -0,0 +1,88 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SYNCPROFILE_H
+#define SYNCPROFILE_H
+
+#include <array>
+#include <atomic>
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+// Cost of a wallet's first sync after initAsync: wall time, process CPU
+// time, peak RSS and how often the GUI layer was woken up on the way. Only
+// collected while the monero.perf logging category is enabled, the result is
+// logged there once the wallet is synchronized. Thread safe.
+class SyncProfile
+{
+public:
+    enum Counter {
+        NewBlockCallbacks,
+        NewBlockSignals,
+        RefreshedSignals,
+        UpdatedSignals,
+        TransferSignals,
+        HistoryRefreshes,
+        HistoryHeightUpdates,
+        SubaddressRefreshes,
+        CounterCount
+    };
+
+    //! starts over, height is the wallet's height before the sync
+    void start(quint64 height);
+    bool running() const
+    {
+        return m_running.load(std::memory_order_relaxed);
+    }
+    void count(Counter counter)
+    {
+        if (running())
+        {
+            m_counters[counter].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    //! logs the profile and stops, only the first call after start() does
+    void finish(quint64 height);
+
+    //! user and system CPU time of the process so far
+    static qint64 processCpuMs();
+    //! peak resident set size of the process so far
+    static qint64 peakRssKb();
+
+private:
+    std::atomic<bool> m_running{false};
+    std::array<std::atomic<quint64>, CounterCount> m_counters{};
+    QMutex m_mutex;
+    QElapsedTimer m_timer;
+    qint64 m_startCpuMs = 0;
+    quint64 m_startHeight = 0;
+};
+
+#endif // SYNCPROFILE_H
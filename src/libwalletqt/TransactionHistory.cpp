@@ -27,86 +27,297 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "TransactionHistory.h"
+#include "TransactionHistorySnapshot.h"
 #include "TransactionInfo.h"
+#include "WalletManager.h"
+#include "qt/EventTrace.h"
+#include "qt/PerfTrace.h"
 #include <wallet/api/wallet2_api.h>
 
-#include <QFile>
+#include <algorithm>
+#include <numeric>
+
 #include <QDebug>
+#include <QMutexLocker>
 #include <QReadLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
 #include <QWriteLocker>
 #include <QtGlobal>
 
 
-bool TransactionHistory::transaction(int index, std::function<void (TransactionInfo &)> callback)
+const TransactionHistoryStore &TransactionHistory::rows() const
 {
-    QReadLocker locker(&m_lock);
+    return m_rows;
+}
 
-    if (index < 0 || index >= m_tinfo.size()) {
-        qCritical("%s: no transaction info for index %d", __FUNCTION__, index);
-        qCritical("%s: there's %d transactions in backend", __FUNCTION__, m_pimpl->count());
-        return false;
+void TransactionHistory::refresh(quint32 accountIndex)
+{
+    const TraceScope trace("wallet", "TransactionHistory::refresh");
+    QSet<QString> keys;
+    QList<TransactionRow> fresh;
+    // libwallet's confirmations are the wallet's height less the block's,
+    // callers that don't know the height still keep the rows' locks current
+    quint64 blockchainHeight = 0;
+
+    {
+        QMutexLocker refreshLocker(&m_refreshMutex);
+        QReadLocker locker(&m_lock);
+
+        m_pimpl->refresh();
+        QHash<quint32, QVector<quint32>> received;
+        for (const auto i : m_pimpl->getAll()) {
+            if (!i->isPending() && !i->isFailed() && i->confirmations() > 0) {
+                blockchainHeight = std::max<quint64>(blockchainHeight, i->blockHeight() + i->confirmations());
+            }
+            if (i->direction() == Monero::TransactionInfo::Direction_In && !i->isFailed()) {
+                QVector<quint32> &indices = received[i->subaddrAccount()];
+                for (const auto index : i->subaddrIndex()) {
+                    indices.append(index);
+                }
+            }
+
+            // every account is kept, views filter on subaddrAccount
+            const QString key = TransactionRow::makeKey(i);
+            if (keys.contains(key)) {
+                continue;
+            }
+            keys.insert(key);
+
+            const int row = m_rows.indexOf(key);
+            if (row < 0 || !m_rows.matches(row, i)) {
+                fresh.append(TransactionRow::fromPimpl(i));
+            }
+        }
+        updateSubaddressUsage(received);
     }
 
-    callback(*m_tinfo.value(index));
-    return true;
+    // rows are only ever mutated on our own thread so models can read them
+    // without locking and emit fine-grained row signals instead of resetting
+    if (QThread::currentThread() == thread()) {
+        setAccountIndex(accountIndex);
+        if (blockchainHeight > 0) {
+            setBlockchainHeight(blockchainHeight);
+        }
+        applyRefresh(keys, fresh);
+        return;
+    }
+
+    QMetaObject::invokeMethod(this, [this, accountIndex, keys, fresh, blockchainHeight] {
+        setAccountIndex(accountIndex);
+        if (blockchainHeight > 0) {
+            setBlockchainHeight(blockchainHeight);
+        }
+        applyRefresh(keys, fresh);
+    }, Qt::QueuedConnection);
 }
 
-//// XXX: not sure if this method really needed;
-//TransactionInfo *TransactionHistory::transaction(const QString &id)
-//{
-//    return nullptr;
-//}
+void TransactionHistory::setAccountIndex(quint32 accountIndex)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, accountIndex] {
+            setAccountIndex(accountIndex);
+        }, Qt::QueuedConnection);
+        return;
+    }
 
-void TransactionHistory::refresh(quint32 accountIndex)
+    if (m_accountIndex == accountIndex) {
+        return;
+    }
+    m_accountIndex = accountIndex;
+    updateLocked();
+    emit accountIndexChanged();
+}
+
+void TransactionHistory::updateSubaddressUsage(QHash<quint32, QVector<quint32>> &received)
 {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    QDateTime firstDateTime = QDate(2014, 4, 18).startOfDay();
-#else
-    QDateTime firstDateTime = QDateTime(QDate(2014, 4, 18)); // the genesis block
-#endif
-    QDateTime lastDateTime  = QDateTime::currentDateTime().addDays(1); // tomorrow (guard against jitter and timezones)
+    m_subaddressUsage.clear();
+    for (auto it = received.begin(); it != received.end(); ++it) {
+        QVector<quint32> &indices = it.value();
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+        // the run below the first used index counts too, the primary address aside
+        SubaddressUsage usage;
+        quint32 previous = 0;
+        for (const quint32 index : indices) {
+            if (index > previous) {
+                usage.largestGap = std::max(usage.largestGap, index - previous - 1);
+            }
+            previous = index;
+        }
+        usage.highestUsed = indices.isEmpty() ? 0 : indices.last();
+        m_subaddressUsage.insert(it.key(), usage);
+    }
+}
 
-    emit refreshStarted();
+QHash<quint32, SubaddressUsage> TransactionHistory::subaddressUsage() const
+{
+    QMutexLocker refreshLocker(&m_refreshMutex);
+    return m_subaddressUsage;
+}
 
+void TransactionHistory::setUserNote(const QString &hash, const QString &note)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, hash, note] {
+            setUserNote(hash, note);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    for (const int row : m_rows.rowsWithHash(hash)) {
+        quint32 changed;
+        {
+            QWriteLocker locker(&m_lock);
+            changed = m_rows.setDescription(row, note);
+        }
+        if (changed != TransactionHistoryStore::ChangedNone) {
+            emit transactionsChanged(row, row, changed);
+        }
+    }
+}
+
+bool TransactionHistory::loadSnapshot(const TransactionHistorySnapshot &snapshot)
+{
+    if (m_rows.size() > 0)
+    {
+        return false;
+    }
+
+    QList<TransactionRow> rows;
+    quint64 blockchainHeight = 0;
+    if (!snapshot.load(rows, blockchainHeight))
+    {
+        return false;
+    }
     {
         QWriteLocker locker(&m_lock);
+        m_rows.setBlockchainHeight(blockchainHeight);
+    }
 
-        qDeleteAll(m_tinfo);
-        m_tinfo.clear();
+    QSet<QString> keys;
+    for (const TransactionRow &value : rows)
+    {
+        keys.insert(value.key);
+    }
+    applyRefresh(keys, rows);
+    return true;
+}
 
-        quint64 lastTxHeight = 0;
-        m_locked = false;
-        m_minutesToUnlock = 0;
+bool TransactionHistory::saveSnapshot(const TransactionHistorySnapshot &snapshot) const
+{
+    // stores run on a pool thread while the GUI thread may be applying a refresh
+    QReadLocker locker(&m_lock);
+    if (!m_populated)
+    {
+        return false;
+    }
+    return snapshot.save(m_rows);
+}
 
-        m_pimpl->refresh();
-        for (const auto i : m_pimpl->getAll()) {
-            if (i->subaddrAccount() != accountIndex) {
-                continue;
-            }
+void TransactionHistory::applyRefresh(const QSet<QString> &keys, const QList<TransactionRow> &fresh)
+{
+    const TraceScope trace("wallet", "TransactionHistory::applyRefresh");
+    m_populated = true;
+    bool totalsChanged = false;
+    emit refreshStarted();
 
-            m_tinfo.append(new TransactionInfo(i, this));
+    // drop entries libwallet doesn't report anymore, one contiguous range at a time
+    for (int last = m_rows.size() - 1; last >= 0; --last) {
+        if (keys.contains(m_rows.key(last))) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && !keys.contains(m_rows.key(first - 1))) {
+            --first;
+        }
 
-            const TransactionInfo *ti = m_tinfo.back();
-            // looking for transactions timestamp scope
-            if (ti->timestamp() >= lastDateTime) {
-                lastDateTime = ti->timestamp();
-            }
-            if (ti->timestamp() <= firstDateTime) {
-                firstDateTime = ti->timestamp();
-            }
-            quint64 requiredConfirmations = (ti->blockHeight() < ti->unlockTime()) ? ti->unlockTime() - ti->blockHeight() : 10;
-            // store last tx height
-            if (ti->confirmations() < requiredConfirmations && ti->blockHeight() >= lastTxHeight) {
-                lastTxHeight = ti->blockHeight();
-                // TODO: Fetch block time and confirmations needed from wallet2?
-                m_minutesToUnlock = (requiredConfirmations - ti->confirmations()) * 2;
-                m_locked = true;
+        emit transactionsAboutToBeRemoved(first, last);
+        for (int row = first; row <= last; ++row) {
+            m_aggregates.subtract(m_rows, row);
+        }
+        totalsChanged = true;
+        {
+            QWriteLocker locker(&m_lock);
+            m_rows.remove(first, last);
+        }
+        emit transactionsRemoved();
+
+        last = first;
+    }
+
+    // update changed entries in place, append the new ones
+    QList<const TransactionRow *> added;
+    for (const TransactionRow &value : fresh) {
+        const int row = m_rows.indexOf(value.key);
+        if (row < 0) {
+            added.append(&value);
+            continue;
+        }
+
+        quint32 changed;
+        m_aggregates.subtract(m_rows, row);
+        {
+            QWriteLocker locker(&m_lock);
+            changed = m_rows.update(row, value);
+        }
+        m_aggregates.add(m_rows, row);
+        // a mined or unlocked entry moves its received amount out of the unconfirmed part
+        if (changed & (TransactionHistoryStore::ChangedAmount | TransactionHistoryStore::ChangedFee |
+                       TransactionHistoryStore::ChangedFailed | TransactionHistoryStore::ChangedTimestamp |
+                       TransactionHistoryStore::ChangedPending | TransactionHistoryStore::ChangedBlockHeight |
+                       TransactionHistoryStore::ChangedUnlockTime)) {
+            totalsChanged = true;
+        }
+        if (changed != TransactionHistoryStore::ChangedNone) {
+            emit transactionsChanged(row, row, changed);
+        }
+    }
+
+    if (!added.isEmpty()) {
+        const int first = m_rows.size();
+        emit transactionsAboutToBeInserted(first, first + added.size() - 1);
+        {
+            QWriteLocker locker(&m_lock);
+            for (const TransactionRow *value : added) {
+                m_rows.append(*value);
             }
         }
+        for (int row = first; row < m_rows.size(); ++row) {
+            m_aggregates.add(m_rows, row);
+        }
+        totalsChanged = true;
+        emit transactionsInserted();
     }
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    qint64 firstTimestamp = QDate(2014, 4, 18).startOfDay().toSecsSinceEpoch();
+#else
+    qint64 firstTimestamp = QDateTime(QDate(2014, 4, 18)).toSecsSinceEpoch(); // the genesis block
+#endif
+    qint64 lastTimestamp = QDateTime::currentDateTime().addDays(1).toSecsSinceEpoch(); // tomorrow (guard against jitter and timezones)
+
+    m_lockedRows.clear();
+    for (int row = 0; row < m_rows.size(); ++row) {
+        // looking for transactions timestamp scope
+        lastTimestamp = std::max(lastTimestamp, m_rows.timestamp(row));
+        firstTimestamp = std::min(firstTimestamp, m_rows.timestamp(row));
+
+        if (m_rows.isLocked(row)) {
+            m_lockedRows.append(row);
+        }
+    }
+    updateLocked();
+
     emit refreshFinished();
+    if (totalsChanged) {
+        emit aggregatesChanged();
+    }
 
+    const QDateTime firstDateTime = QDateTime::fromSecsSinceEpoch(firstTimestamp);
+    const QDateTime lastDateTime = QDateTime::fromSecsSinceEpoch(lastTimestamp);
     if (m_firstDateTime != firstDateTime) {
         m_firstDateTime = firstDateTime;
         emit firstDateTimeChanged();
@@ -117,11 +328,104 @@ void TransactionHistory::refresh(quint32 accountIndex)
     }
 }
 
+void TransactionHistory::setBlockchainHeight(quint64 height)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, height] {
+            setBlockchainHeight(height);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    const bool shrinking = height < m_rows.blockchainHeight();
+    if (height == m_rows.blockchainHeight()) {
+        return;
+    }
+
+    // a growing chain only ever unlocks rows, a shrinking one (reorg, rescan)
+    // can lock any of them again
+    QVector<int> affected = m_lockedRows;
+    if (shrinking) {
+        affected.resize(m_rows.size());
+        std::iota(affected.begin(), affected.end(), 0);
+    }
+
+    QVector<bool> wasLocked;
+    wasLocked.reserve(affected.size());
+    for (const int row : affected) {
+        wasLocked.append(m_rows.isLocked(row));
+        m_aggregates.subtract(m_rows, row);
+    }
+    {
+        QWriteLocker locker(&m_lock);
+        m_rows.setBlockchainHeight(height);
+        for (const int row : affected) {
+            m_rows.touch(row);
+        }
+    }
+    bool unlockChanged = false;
+    for (int i = 0; i < affected.size(); ++i) {
+        m_aggregates.add(m_rows, affected[i]);
+        unlockChanged |= wasLocked[i] != m_rows.isLocked(affected[i]);
+    }
+
+    m_lockedRows = affected;
+    updateLocked();
+
+    // unlocked rows aren't notified, their count is read fresh with any other change
+    if (shrinking) {
+        if (m_rows.size() > 0) {
+            emit transactionsChanged(0, m_rows.size() - 1, TransactionHistoryStore::ChangedConfirmations);
+        }
+    } else {
+        for (const int row : affected) {
+            emit transactionsChanged(row, row, TransactionHistoryStore::ChangedConfirmations);
+        }
+    }
+    if (unlockChanged) {
+        emit aggregatesChanged();
+    }
+}
+
+void TransactionHistory::updateLocked()
+{
+    m_lockedRows.erase(std::remove_if(m_lockedRows.begin(), m_lockedRows.end(), [this](int row) {
+        return !m_rows.isLocked(row);
+    }), m_lockedRows.end());
+
+    quint64 lastTxHeight = 0;
+    m_locked = false;
+    m_minutesToUnlock = 0;
+    for (const int row : m_lockedRows) {
+        if (m_rows.subaddrAccount(row) != m_accountIndex) {
+            continue;
+        }
+        const quint64 blockHeight = m_rows.blockHeight(row);
+        // store last tx height
+        if (blockHeight >= lastTxHeight) {
+            lastTxHeight = blockHeight;
+            // TODO: Fetch block time and confirmations needed from wallet2?
+            m_minutesToUnlock = (m_rows.requiredConfirmations(row) - m_rows.confirmations(row)) * 2;
+            m_locked = true;
+        }
+    }
+}
+
+const TransactionHistoryAggregates &TransactionHistory::aggregates() const
+{
+    return m_aggregates;
+}
+
+quint32 TransactionHistory::accountIndex() const
+{
+    return m_accountIndex;
+}
+
 quint64 TransactionHistory::count() const
 {
     QReadLocker locker(&m_lock);
 
-    return m_tinfo.count();
+    return m_rows.size();
 }
 
 QDateTime TransactionHistory::firstDateTime() const
@@ -146,7 +450,8 @@ bool TransactionHistory::TransactionHistory::locked() const
 
 
 TransactionHistory::TransactionHistory(Monero::TransactionHistory *pimpl, QObject *parent)
-    : QObject(parent), m_pimpl(pimpl), m_minutesToUnlock(0), m_locked(false)
+    : QObject(parent), m_pimpl(pimpl), m_accountIndex(0), m_populated(false), m_minutesToUnlock(0), m_locked(false)
+    , m_scheduler(this), m_csvExportCancelled(false)
 {
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
     m_firstDateTime = QDate(2014, 4, 18).startOfDay();
@@ -156,69 +461,174 @@ TransactionHistory::TransactionHistory(Monero::TransactionHistory *pimpl, QObjec
     m_lastDateTime = QDateTime::currentDateTime().addDays(1); // tomorrow (guard against jitter and timezones)
 }
 
+namespace {
+    // columns of a single CSV line, copied out of libwallet so formatting
+    // and disk I/O run without holding m_refreshMutex
+    struct CsvRow
+    {
+        quint64 blockHeight;
+        qint64 timestamp;
+        bool incoming;
+        quint64 amount;
+        quint64 fee;
+        quint32 subaddrAccount;
+        QString hash;
+        QString label;
+        QString paymentId;
+        QString description;
+    };
+
+    constexpr int csvBatchSize = 512;
+
+    void appendCsvRow(QString &buffer, const CsvRow &row)
+    {
+        const QDateTime timestamp = QDateTime::fromSecsSinceEpoch(row.timestamp);
+
+        buffer += QString::number(row.blockHeight);
+        buffer += QLatin1Char(',');
+        buffer += QString::number(static_cast<uint>(row.timestamp));
+        buffer += QLatin1Char(',');
+        buffer += timestamp.date().toString(Qt::ISODate);
+        buffer += QLatin1Char(' ');
+        buffer += timestamp.time().toString(Qt::ISODate);
+        buffer += row.incoming ? QLatin1String(",in,") : QLatin1String(",out,");
+        WalletManager::appendDisplayAmount(buffer, row.amount);
+        buffer += QLatin1Char(',');
+        buffer += QString::number(row.amount);
+        buffer += QLatin1Char(',');
+        if (row.fee != 0) {
+            WalletManager::appendDisplayAmount(buffer, row.fee);
+        }
+        buffer += QLatin1Char(',');
+        buffer += row.hash;
+        buffer += QLatin1String(",\"");
+        buffer += row.label;
+        buffer += QLatin1String("\",");
+        buffer += QString::number(row.subaddrAccount);
+        buffer += QLatin1Char(',');
+        buffer += row.paymentId;
+        buffer += QLatin1String(",\"");
+        buffer += row.description;
+        buffer += QLatin1String("\"\n");
+    }
+}
+
+TransactionHistory::~TransactionHistory()
+{
+    shutdown();
+}
+
+void TransactionHistory::shutdown()
+{
+    m_csvExportCancelled = true;
+    m_scheduler.shutdownWaitForFinished();
+}
+
 QString TransactionHistory::writeCSV(quint32 accountIndex, QString out)
+{
+    return exportCSV(accountIndex, false, out, nullptr);
+}
+
+void TransactionHistory::writeCSVAsync(quint32 accountIndex, bool allAccounts, const QString &out, const QJSValue &callback)
+{
+    m_csvExportCancelled = false;
+    const auto future = m_scheduler.run(
+        [this, accountIndex, allAccounts, out] {
+            return QJSValueList({exportCSV(accountIndex, allAccounts, out, &m_csvExportCancelled)});
+        },
+        callback,
+        FutureScheduler::BlockingIO, "TransactionHistory::writeCSVAsync");
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({QString("")}));
+    }
+}
+
+void TransactionHistory::cancelCSVExport()
+{
+    m_csvExportCancelled = true;
+}
+
+QString TransactionHistory::exportCSV(quint32 accountIndex, bool allAccounts, const QString &out, const std::atomic<bool> *cancelled)
 {
     // construct filename
     qint64 now = QDateTime::currentDateTime().currentMSecsSinceEpoch();
-    QString fn = QString(QString("%1/monero-txs_%2.csv").arg(out, QString::number(now / 1000)));
+    QString fn = QString(allAccounts ? "%1/monero-txs_all_%2.csv" : "%1/monero-txs_%2.csv").arg(out, QString::number(now / 1000));
+
+    QVector<CsvRow> rows;
+    {
+        QMutexLocker refreshLocker(&m_refreshMutex);
+        const auto all = m_pimpl->getAll();
+        rows.reserve(static_cast<int>(all.size()));
+        for (const auto &tx : all) {
+            if (!allAccounts && tx->subaddrAccount() != accountIndex) {
+                continue;
+            }
+
+            CsvRow row;
+            row.incoming = tx->direction() == Monero::TransactionInfo::Direction_In;
+            row.blockHeight = tx->blockHeight();
+            row.timestamp = tx->timestamp();
+            row.amount = tx->amount();
+            row.fee = tx->fee();
+            row.subaddrAccount = tx->subaddrAccount();
+            row.hash = QString::fromStdString(tx->hash());
+            row.label = QString::fromStdString(tx->label());
+            row.label.remove(QChar('"'));  // reserved
+            row.description = QString::fromStdString(tx->description());
+            row.description.remove(QChar('"')); // reserved
+            row.paymentId = QString::fromStdString(tx->paymentId());
+            if (row.paymentId == "0000000000000000") {
+                row.paymentId = "";
+            }
+            rows.append(std::move(row));
+        }
+    }
 
-    // open file
-    QFile data(fn);
-    if(!data.open(QFile::WriteOnly | QFile::Truncate)){
+    // QSaveFile only replaces the target on commit(), a cancelled or failed
+    // export never leaves a truncated file behind
+    QSaveFile data(fn);
+    if (!data.open(QIODevice::WriteOnly)) {
         return QString("");
     }
 
-    // write header
-    QTextStream output(&data);
-    output << "blockHeight,epoch,date,direction,amount,atomicAmount,fee,txid,label,subaddrAccount,paymentId,description\n";
+    const PerfScope perf("history CSV export", rows.size());
+    QString buffer;
+    buffer.reserve(csvBatchSize * 256);
+    buffer += QLatin1String("blockHeight,epoch,date,direction,amount,atomicAmount,fee,txid,label,subaddrAccount,paymentId,description\n");
 
-    QReadLocker locker(&m_lock);
-    for (const auto &tx : m_pimpl->getAll()) {
-        if (tx->subaddrAccount() != accountIndex) {
+    const int total = rows.size();
+    for (int row = 0; row < total; ++row) {
+        appendCsvRow(buffer, rows[row]);
+
+        const int written = row + 1;
+        if (written % csvBatchSize != 0 && written != total) {
             continue;
         }
 
-        TransactionInfo info(tx, this);
+        // resize(0) keeps the capacity, the buffer is reused for every batch
+        const QByteArray chunk = buffer.toUtf8();
+        buffer.resize(0);
+        if (data.write(chunk) != chunk.size()) {
+            qWarning() << "Failed to write" << fn << data.errorString();
+            data.cancelWriting();
+            return QString("");
+        }
+        if (cancelled && *cancelled) {
+            data.cancelWriting();
+            return QString("");
+        }
+        emit csvExportProgress(written, total);
+    }
 
-        // collect column data
-        quint64 atomicAmount = info.atomicAmount();
-        quint32 subaddrAccount = info.subaddrAccount();
-        QString fee = info.fee();
-        QString direction = QString("");
-        TransactionInfo::Direction _direction = info.direction();
-        if(_direction == TransactionInfo::Direction_In)
-        {
-            direction = QString("in");
-        }
-        else if(_direction == TransactionInfo::Direction_Out){
-            direction = QString("out");
-        }
-        else {
-            continue;  // skip TransactionInfo::Direction_Both
-        }
-        QString label = info.label();
-        label.remove(QChar('"'));  // reserved
-        QString description = info.description();
-        description.remove(QChar('"')); // reserved
-        quint64 blockHeight = info.blockHeight();
-        QDateTime timeStamp = info.timestamp();
-        QString date = info.date() + " " + info.time();
-        uint epoch = timeStamp.toSecsSinceEpoch();
-        QString displayAmount = info.displayAmount();
-        QString paymentId = info.paymentId();
-        if(paymentId == "0000000000000000"){
-            paymentId = "";
-        }
-
-        // format and write
-        QString line = QString("%1,%2,%3,%4,%5,%6,%7,%8,\"%9\",%10,%11,\"%12\"\n")
-            .arg(QString::number(blockHeight), QString::number(epoch), date)
-            .arg(direction, displayAmount, QString::number(atomicAmount))
-            .arg(info.fee(), info.hash(), label, QString::number(subaddrAccount))
-            .arg(paymentId, description);
-        output << line;
-    }
-
-    data.close();
+    if (total == 0 && data.write(buffer.toUtf8()) < 0) {
+        data.cancelWriting();
+        return QString("");
+    }
+
+    if (!data.commit()) {
+        qWarning() << "Failed to write" << fn << data.errorString();
+        return QString("");
+    }
     return fn;
 }
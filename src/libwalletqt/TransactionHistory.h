@@ -29,10 +29,19 @@
 #ifndef TRANSACTIONHISTORY_H
 #define TRANSACTIONHISTORY_H
 
-#include <functional>
+#include "SubaddressLookahead.h"
+#include "TransactionHistoryAggregates.h"
+#include "TransactionHistoryStore.h"
+#include "qt/FutureScheduler.h"
 
+#include <atomic>
+
+#include <QHash>
+#include <QJSValue>
 #include <QObject>
 #include <QList>
+#include <QMutex>
+#include <QSet>
 #include <QReadWriteLock>
 #include <QDateTime>
 
@@ -41,6 +50,7 @@ struct TransactionHistory;
 }
 
 class TransactionInfo;
+class TransactionHistorySnapshot;
 
 class TransactionHistory : public QObject
 {
@@ -50,12 +60,32 @@ class TransactionHistory : public QObject
     Q_PROPERTY(QDateTime lastDateTime READ lastDateTime NOTIFY lastDateTimeChanged)
     Q_PROPERTY(int minutesToUnlock READ minutesToUnlock)
     Q_PROPERTY(bool locked READ locked)
+    Q_PROPERTY(quint32 accountIndex READ accountIndex NOTIFY accountIndexChanged)
 
 public:
-    Q_INVOKABLE bool transaction(int index, std::function<void (TransactionInfo &)> callback);
+    ~TransactionHistory();
+    //! packed rows of every account backing the models, only to be read from the history's thread
+    const TransactionHistoryStore &rows() const;
+    //! totals per time bucket and subaddress, same thread rules as rows()
+    const TransactionHistoryAggregates &aggregates() const;
+    //! account the per-account views and the lock state follow
+    quint32 accountIndex() const;
+    //! switches the viewed account without rereading libwallet
+    void setAccountIndex(quint32 accountIndex);
     // Q_INVOKABLE TransactionInfo * transaction(const QString &id);
+    //! rereads the history of all accounts, accountIndex becomes the viewed account
     Q_INVOKABLE void refresh(quint32 accountIndex);
     Q_INVOKABLE QString writeCSV(quint32 accountIndex, QString out);
+    //! exports on a worker thread, callback receives the written file name or "" on failure/cancellation
+    Q_INVOKABLE void writeCSVAsync(quint32 accountIndex, bool allAccounts, const QString &out, const QJSValue &callback);
+    Q_INVOKABLE void cancelCSVExport();
+    //! edit-through for Wallet::setUserNote, updates the description of the rows
+    //! of hash without a refresh
+    void setUserNote(const QString &hash, const QString &note);
+    //! incoming transfers per account over all accounts as of the last refresh
+    QHash<quint32, SubaddressUsage> subaddressUsage() const;
+    //! moves the confirmations of every row without a refresh, only locked rows are revisited
+    void setBlockchainHeight(quint64 height);
     quint64 count() const;
     QDateTime firstDateTime() const;
     QDateTime lastDateTime() const;
@@ -65,25 +95,60 @@ public:
 signals:
     void refreshStarted() const;
     void refreshFinished() const;
+    // row level notifications, always emitted on the history's thread
+    void transactionsAboutToBeInserted(int first, int last) const;
+    void transactionsInserted() const;
+    void transactionsAboutToBeRemoved(int first, int last) const;
+    void transactionsRemoved() const;
+    //! changedFields is a mask of TransactionHistoryStore::ChangedField
+    void transactionsChanged(int first, int last, quint32 changedFields) const;
     void firstDateTimeChanged() const;
     void lastDateTimeChanged() const;
+    void aggregatesChanged() const;
+    void accountIndexChanged() const;
+    void csvExportProgress(int written, int total) const;
 
 public slots:
 
 
 private:
     explicit TransactionHistory(Monero::TransactionHistory * pimpl, QObject *parent = 0);
+    //! cancels and waits for pending exports, m_pimpl must still be alive
+    void shutdown();
+    QString exportCSV(quint32 accountIndex, bool allAccounts, const QString &out, const std::atomic<bool> *cancelled);
+    void applyRefresh(const QSet<QString> &keys, const QList<TransactionRow> &fresh);
+    //! drops rows that unlocked from m_lockedRows, recomputes m_locked and m_minutesToUnlock
+    //! from those of the viewed account
+    void updateLocked();
+    //! fills an empty history from snapshot, the next refresh reconciles it with libwallet
+    bool loadSnapshot(const TransactionHistorySnapshot &snapshot);
+    bool saveSnapshot(const TransactionHistorySnapshot &snapshot) const;
+    //! sorts received in place, called from refresh() with m_refreshMutex held
+    void updateSubaddressUsage(QHash<quint32, QVector<quint32>> &received);
 
 private:
     friend class Wallet;
+    // builds histories over generated rows for monero-gui-bench
+    friend class SyntheticHistory;
     mutable QReadWriteLock m_lock;
+    // serializes access to m_pimpl
+    mutable QMutex m_refreshMutex;
     Monero::TransactionHistory * m_pimpl;
-    mutable QList<TransactionInfo*> m_tinfo;
+    QHash<quint32, SubaddressUsage> m_subaddressUsage;
+    TransactionHistoryStore m_rows;
+    TransactionHistoryAggregates m_aggregates;
+    quint32 m_accountIndex;
+    //! m_rows were refreshed or loaded from a snapshot
+    bool m_populated;
     mutable QDateTime   m_firstDateTime;
     mutable QDateTime   m_lastDateTime;
     mutable int m_minutesToUnlock;
-    // history contains locked transfers
+    // viewed account has locked transfers
     mutable bool m_locked;
+    //! ascending rows of all accounts that are pending or short of their confirmations
+    QVector<int> m_lockedRows;
+    FutureScheduler m_scheduler;
+    std::atomic<bool> m_csvExportCancelled;
 
 };
 
@@ -0,0 +1,178 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "TransactionHistoryAggregates.h"
+#include "TransactionHistoryStore.h"
+
+#include <QDate>
+#include <QDateTime>
+
+#include <wallet/api/wallet2_api.h>
+
+TransactionHistoryAggregates::Totals &TransactionHistoryAggregates::Totals::operator+=(const Totals &other)
+{
+    incoming += other.incoming;
+    outgoing += other.outgoing;
+    fees += other.fees;
+    count += other.count;
+    return *this;
+}
+
+bool TransactionHistoryAggregates::Key::operator==(const Key &other) const
+{
+    return bucket == other.bucket && subaddrAccount == other.subaddrAccount && subaddrIndex == other.subaddrIndex;
+}
+
+size_t qHash(const TransactionHistoryAggregates::Key &key, size_t seed)
+{
+    return qHashMulti(seed, key.bucket, key.subaddrAccount, key.subaddrIndex);
+}
+
+void TransactionHistoryAggregates::add(const TransactionHistoryStore &rows, int row)
+{
+    apply(rows, row, false);
+}
+
+void TransactionHistoryAggregates::subtract(const TransactionHistoryStore &rows, int row)
+{
+    apply(rows, row, true);
+}
+
+void TransactionHistoryAggregates::clear()
+{
+    for (QHash<Key, Totals> &buckets : m_buckets)
+    {
+        buckets.clear();
+    }
+    m_received.clear();
+}
+
+void TransactionHistoryAggregates::apply(const TransactionHistoryStore &rows, int row, bool subtract)
+{
+    if (rows.isFailed(row))
+    {
+        return;
+    }
+
+    // buckets follow the local calendar, as the dates shown next to the rows do
+    const QDate date = QDateTime::fromSecsSinceEpoch(rows.timestamp(row)).date();
+    const qint64 buckets[GranularityCount] = {
+        date.toJulianDay(),
+        date.addDays(1 - date.dayOfWeek()).toJulianDay(),
+        QDate(date.year(), date.month(), 1).toJulianDay(),
+    };
+
+    // a transfer to several subaddresses is booked on the lowest one, the
+    // row doesn't tell how the amount splits. Incoming rows are per subaddress.
+    const quint32 subaddrIndex = rows.subaddrIndexCount(row) > 0 ? rows.subaddrIndex(row, 0) : 0;
+
+    const bool incoming = rows.direction(row) == Monero::TransactionInfo::Direction_In;
+    if (incoming)
+    {
+        applyReceived(rows, row, subaddrIndex, subtract);
+    }
+    for (int granularity = 0; granularity < GranularityCount; ++granularity)
+    {
+        const Key key{buckets[granularity], rows.subaddrAccount(row), subaddrIndex};
+        Totals &totals = m_buckets[granularity][key];
+        if (subtract)
+        {
+            (incoming ? totals.incoming : totals.outgoing) -= rows.amount(row);
+            totals.fees -= rows.fee(row);
+            --totals.count;
+            if (totals.count == 0)
+            {
+                m_buckets[granularity].remove(key);
+            }
+        }
+        else
+        {
+            (incoming ? totals.incoming : totals.outgoing) += rows.amount(row);
+            totals.fees += rows.fee(row);
+            ++totals.count;
+        }
+    }
+}
+
+void TransactionHistoryAggregates::applyReceived(const TransactionHistoryStore &rows, int row, quint32 subaddrIndex, bool subtract)
+{
+    // same rule the history uses for its locked state
+    const bool unconfirmed = rows.isLocked(row);
+
+    const QPair<quint32, quint32> key(rows.subaddrAccount(row), subaddrIndex);
+    Received &received = m_received[key];
+    if (subtract)
+    {
+        received.amount -= rows.amount(row);
+        if (unconfirmed)
+        {
+            received.unconfirmedAmount -= rows.amount(row);
+        }
+        --received.count;
+        received.transactions.remove(rows.timestamp(row), rows.hash(row));
+        if (received.count == 0)
+        {
+            m_received.remove(key);
+        }
+    }
+    else
+    {
+        received.amount += rows.amount(row);
+        if (unconfirmed)
+        {
+            received.unconfirmedAmount += rows.amount(row);
+        }
+        ++received.count;
+        received.transactions.insert(rows.timestamp(row), rows.hash(row));
+    }
+}
+
+const TransactionHistoryAggregates::Received *TransactionHistoryAggregates::received(quint32 subaddrAccount, quint32 subaddrIndex) const
+{
+    const auto it = m_received.constFind(qMakePair(subaddrAccount, subaddrIndex));
+    return it != m_received.cend() ? &it.value() : nullptr;
+}
+
+QMap<qint64, TransactionHistoryAggregates::Totals> TransactionHistoryAggregates::series(Granularity granularity, int subaddrAccount, int subaddrIndex) const
+{
+    QMap<qint64, Totals> result;
+    if (granularity < 0 || granularity >= GranularityCount)
+    {
+        return result;
+    }
+
+    for (auto it = m_buckets[granularity].cbegin(); it != m_buckets[granularity].cend(); ++it)
+    {
+        if ((subaddrAccount < 0 || it.key().subaddrAccount == static_cast<quint32>(subaddrAccount)) &&
+            (subaddrIndex < 0 || it.key().subaddrIndex == static_cast<quint32>(subaddrIndex)))
+        {
+            result[it.key().bucket] += it.value();
+        }
+    }
+    return result;
+}
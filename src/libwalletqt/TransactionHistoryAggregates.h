@@ -0,0 +1,107 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TRANSACTIONHISTORYAGGREGATES_H
+#define TRANSACTIONHISTORYAGGREGATES_H
+
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QtGlobal>
+
+class TransactionHistoryStore;
+
+/**
+ * @brief The TransactionHistoryAggregates class - per day, week and month
+ * totals of the history rows, split by subaddress, and the amount received
+ * per subaddress. Rows are added and subtracted one at a time as the history
+ * changes, charts and invoice lookups read the totals without walking the rows.
+ */
+class TransactionHistoryAggregates
+{
+public:
+    enum Granularity {
+        Day,
+        Week,
+        Month,
+        GranularityCount
+    };
+
+    struct Totals
+    {
+        quint64 incoming = 0;
+        quint64 outgoing = 0;
+        quint64 fees = 0;
+        quint32 count = 0;
+
+        Totals &operator+=(const Totals &other);
+    };
+
+    struct Received
+    {
+        quint64 amount = 0;
+        //! part of amount that is pending or short of its required confirmations
+        quint64 unconfirmedAmount = 0;
+        quint32 count = 0;
+        //! tx hashes by timestamp, the last one is the most recent
+        QMultiMap<qint64, QString> transactions;
+    };
+
+    //! failed transactions aren't counted
+    void add(const TransactionHistoryStore &rows, int row);
+    void subtract(const TransactionHistoryStore &rows, int row);
+    void clear();
+
+    //! totals per bucket, keyed by the julian day the bucket starts on. Negative
+    //! subaddrAccount or subaddrIndex sum over all accounts or indices.
+    QMap<qint64, Totals> series(Granularity granularity, int subaddrAccount, int subaddrIndex) const;
+
+    //! incoming transfers to one subaddress, nullptr if there are none
+    const Received *received(quint32 subaddrAccount, quint32 subaddrIndex) const;
+
+private:
+    struct Key
+    {
+        qint64 bucket;
+        quint32 subaddrAccount;
+        quint32 subaddrIndex;
+
+        bool operator==(const Key &other) const;
+    };
+    friend size_t qHash(const Key &key, size_t seed);
+
+    void apply(const TransactionHistoryStore &rows, int row, bool subtract);
+    void applyReceived(const TransactionHistoryStore &rows, int row, quint32 subaddrIndex, bool subtract);
+
+private:
+    QHash<Key, Totals> m_buckets[GranularityCount];
+    QHash<QPair<quint32, quint32>, Received> m_received;
+};
+
+#endif // TRANSACTIONHISTORYAGGREGATES_H
@@ -0,0 +1,251 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "TransactionHistorySnapshot.h"
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+#include <QSaveFile>
+
+#include "crypto/chacha.h"
+
+namespace {
+constexpr quint32 SNAPSHOT_MAGIC = 0x4d474853; // "MGHS"
+// 5 derives the keys from the password instead of the view key
+constexpr quint32 SNAPSHOT_VERSION = 6;
+constexpr int SNAPSHOT_SALT_SIZE = 16;
+// magic, version and salt
+constexpr int SNAPSHOT_HEADER_SIZE = 2 * sizeof(quint32) + SNAPSHOT_SALT_SIZE;
+constexpr int SNAPSHOT_MAC_SIZE = 32;
+
+QByteArray deriveKey(const crypto::chacha_key &passwordKey, const char *domain)
+{
+    // keccak-256, i.e. cn_fast_hash
+    return QCryptographicHash::hash(QByteArray(reinterpret_cast<const char *>(passwordKey.data()), sizeof(passwordKey)) + domain, QCryptographicHash::Keccak_256);
+}
+
+// doesn't stop at the first difference, the time taken reveals nothing about the MAC
+bool constantTimeEquals(const QByteArray &a, const QByteArray &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    unsigned char difference = 0;
+    for (qsizetype i = 0; i < a.size(); ++i)
+    {
+        difference |= static_cast<unsigned char>(a[i] ^ b[i]);
+    }
+    return difference == 0;
+}
+
+QByteArray chacha20(const QByteArray &data, const QByteArray &key, const QByteArray &iv)
+{
+    QByteArray result(data.size(), Qt::Uninitialized);
+    crypto::chacha20(data.constData(), data.size(),
+                     reinterpret_cast<const uint8_t *>(key.constData()),
+                     reinterpret_cast<const uint8_t *>(iv.constData()),
+                     result.data());
+    return result;
+}
+
+void writeRow(QDataStream &stream, const TransactionHistoryStore &rows, int row)
+{
+    stream << rows.key(row) << rows.amount(row) << rows.fee(row) << rows.blockHeight(row)
+           << rows.unlockTime(row) << rows.timestamp(row)
+           << rows.subaddrAccount(row) << qint32(rows.direction(row))
+           << rows.isPending(row) << rows.isFailed(row) << rows.isCoinbase(row)
+           << rows.hash(row) << rows.label(row) << rows.paymentId(row) << rows.description(row);
+
+    stream << quint32(rows.subaddrIndexCount(row));
+    for (int i = 0; i < rows.subaddrIndexCount(row); ++i)
+    {
+        stream << rows.subaddrIndex(row, i);
+    }
+    stream << quint32(rows.transferCount(row));
+    for (int i = 0; i < rows.transferCount(row); ++i)
+    {
+        stream << rows.transferAmount(row, i) << rows.transferAddress(row, i);
+    }
+}
+
+bool readRow(QDataStream &stream, TransactionRow &value)
+{
+    qint32 direction;
+    stream >> value.key >> value.amount >> value.fee >> value.blockHeight
+           >> value.unlockTime >> value.timestamp
+           >> value.subaddrAccount >> direction
+           >> value.pending >> value.failed >> value.coinbase
+           >> value.hash >> value.label >> value.paymentId >> value.description;
+    value.direction = direction;
+
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        quint32 index;
+        stream >> index;
+        value.subaddrIndex.append(index);
+    }
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        QPair<quint64, QString> transfer;
+        stream >> transfer.first >> transfer.second;
+        value.transfers.append(transfer);
+    }
+    return stream.status() == QDataStream::Ok;
+}
+} // namespace
+
+TransactionHistorySnapshot::TransactionHistorySnapshot(const QString &walletPath, const QString &password, quint64 kdfRounds)
+    : m_path(walletPath + ".gui-history")
+{
+    QFile file(m_path);
+    if (file.open(QIODevice::ReadOnly))
+    {
+        const QByteArray header = file.read(SNAPSHOT_HEADER_SIZE);
+        QDataStream stream(header);
+        quint32 magic = 0, version = 0;
+        stream >> magic >> version;
+        if (header.size() == SNAPSHOT_HEADER_SIZE && magic == SNAPSHOT_MAGIC && version == SNAPSHOT_VERSION)
+        {
+            m_salt = header.right(SNAPSHOT_SALT_SIZE);
+        }
+    }
+    if (m_salt.isEmpty())
+    {
+        m_salt.resize(SNAPSHOT_SALT_SIZE);
+        QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(m_salt.data()), SNAPSHOT_SALT_SIZE / sizeof(quint32));
+    }
+
+    const QByteArray secret = password.toUtf8() + m_salt;
+    crypto::chacha_key passwordKey;
+    crypto::generate_chacha_key(secret.constData(), secret.size(), passwordKey, std::max<quint64>(kdfRounds, 1));
+    m_cipherKey = deriveKey(passwordKey, "monero-gui history snapshot key");
+    m_macKey = deriveKey(passwordKey, "monero-gui history snapshot mac");
+}
+
+QString TransactionHistorySnapshot::path() const
+{
+    return m_path;
+}
+
+bool TransactionHistorySnapshot::load(QList<TransactionRow> &rows, quint64 &blockchainHeight) const
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < SNAPSHOT_HEADER_SIZE + CHACHA_IV_SIZE + SNAPSHOT_MAC_SIZE)
+    {
+        return false;
+    }
+    // mapped rather than read, decrypting makes the only copy
+    const uchar *mapped = file.map(0, file.size());
+    if (!mapped)
+    {
+        return false;
+    }
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), file.size());
+
+    const QByteArray message = data.left(data.size() - SNAPSHOT_MAC_SIZE);
+    if (!constantTimeEquals(QMessageAuthenticationCode::hash(message, m_macKey, QCryptographicHash::Sha256), data.right(SNAPSHOT_MAC_SIZE)))
+    {
+        qWarning() << "Discarding history snapshot that doesn't authenticate" << m_path;
+        return false;
+    }
+
+    QDataStream header(message.left(SNAPSHOT_HEADER_SIZE));
+    quint32 magic, version;
+    header >> magic >> version;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION || message.mid(2 * sizeof(quint32), SNAPSHOT_SALT_SIZE) != m_salt)
+    {
+        return false;
+    }
+
+    const QByteArray iv = message.mid(SNAPSHOT_HEADER_SIZE, CHACHA_IV_SIZE);
+    const QByteArray plain = qUncompress(chacha20(message.mid(SNAPSHOT_HEADER_SIZE + CHACHA_IV_SIZE), m_cipherKey, iv));
+    QDataStream stream(plain);
+    quint32 count = 0;
+    quint64 height = 0;
+    stream >> count >> height;
+    QList<TransactionRow> result;
+    for (quint32 i = 0; i < count; ++i)
+    {
+        TransactionRow value;
+        if (!readRow(stream, value))
+        {
+            return false;
+        }
+        result.append(value);
+    }
+
+    rows = result;
+    blockchainHeight = height;
+    return true;
+}
+
+bool TransactionHistorySnapshot::save(const TransactionHistoryStore &rows) const
+{
+    QByteArray plain;
+    {
+        QDataStream stream(&plain, QIODevice::WriteOnly);
+        stream << quint32(rows.size()) << rows.blockchainHeight();
+        for (int row = 0; row < rows.size(); ++row)
+        {
+            writeRow(stream, rows, row);
+        }
+    }
+
+    QByteArray iv(CHACHA_IV_SIZE, Qt::Uninitialized);
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(iv.data()), CHACHA_IV_SIZE / sizeof(quint32));
+
+    QByteArray message;
+    {
+        QDataStream header(&message, QIODevice::WriteOnly);
+        header << SNAPSHOT_MAGIC << SNAPSHOT_VERSION;
+    }
+    message += m_salt;
+    message += iv;
+    message += chacha20(qCompress(plain), m_cipherKey, iv);
+
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Failed to write history snapshot" << m_path;
+        return false;
+    }
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    file.write(message);
+    file.write(QMessageAuthenticationCode::hash(message, m_macKey, QCryptographicHash::Sha256));
+    return file.commit();
+}
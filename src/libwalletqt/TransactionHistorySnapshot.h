@@ -0,0 +1,69 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TRANSACTIONHISTORYSNAPSHOT_H
+#define TRANSACTIONHISTORYSNAPSHOT_H
+
+#include "TransactionHistoryStore.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+/**
+ * @brief The TransactionHistorySnapshot class - encrypted on-disk copy of the
+ * history rows of all accounts, kept next to the wallet file. It lets the GUI
+ * show the history of a freshly opened wallet before libwallet's history is
+ * read back, refreshing it then only applies the difference.
+ *
+ * Rows are encrypted with chacha20 and authenticated with HMAC-SHA256 under
+ * keys derived from the wallet password and a random salt kept in the file,
+ * with the same slow hash and rounds libwallet derives its cache key with.
+ * The view key alone, e.g. of a view-only copy, doesn't open it.
+ */
+class TransactionHistorySnapshot
+{
+public:
+    //! reuses the salt of an existing snapshot, derives the keys, which is slow
+    TransactionHistorySnapshot(const QString &walletPath, const QString &password, quint64 kdfRounds);
+
+    QString path() const;
+
+    //! false if there is no snapshot or it doesn't authenticate, blockchainHeight
+    //! is the height the rows' confirmations were counted against
+    bool load(QList<TransactionRow> &rows, quint64 &blockchainHeight) const;
+    bool save(const TransactionHistoryStore &rows) const;
+
+private:
+    QString m_path;
+    QByteArray m_salt;
+    QByteArray m_cipherKey;
+    QByteArray m_macKey;
+};
+
+#endif // TRANSACTIONHISTORYSNAPSHOT_H
@@ -0,0 +1,422 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "TransactionHistoryStore.h"
+
+#include <limits>
+#include <vector>
+
+#include <QDateTime>
+
+#include <wallet/api/wallet2_api.h>
+
+#include "WalletManager.h"
+
+TransactionRow TransactionRow::fromPimpl(const Monero::TransactionInfo *pimpl)
+{
+    TransactionRow row;
+    row.key = makeKey(pimpl);
+    row.amount = pimpl->amount();
+    row.fee = pimpl->fee();
+    row.blockHeight = pimpl->blockHeight();
+    row.unlockTime = pimpl->unlockTime();
+    row.timestamp = pimpl->timestamp();
+    row.subaddrAccount = pimpl->subaddrAccount();
+    row.direction = pimpl->direction();
+    row.pending = pimpl->isPending();
+    row.failed = pimpl->isFailed();
+    row.coinbase = pimpl->isCoinbase();
+    row.hash = QString::fromStdString(pimpl->hash());
+    row.label = QString::fromStdString(pimpl->label());
+    row.paymentId = QString::fromStdString(pimpl->paymentId());
+    row.description = QString::fromStdString(pimpl->description());
+    // std::set, already ordered
+    for (uint32_t i : pimpl->subaddrIndex())
+    {
+        row.subaddrIndex.append(i);
+    }
+    for (const auto &t : pimpl->transfers())
+    {
+        row.transfers.append(qMakePair(static_cast<quint64>(t.amount), QString::fromStdString(t.address)));
+    }
+    return row;
+}
+
+QString TransactionRow::makeKey(const Monero::TransactionInfo *pimpl)
+{
+    QString key = QString::fromStdString(pimpl->hash());
+    key += pimpl->direction() == Monero::TransactionInfo::Direction_In ? QStringLiteral(":in") : QStringLiteral(":out");
+    for (uint32_t i : pimpl->subaddrIndex())
+    {
+        key += QLatin1Char(':') + QString::number(i);
+    }
+    return key;
+}
+
+QString TransactionHistoryStore::key(int row) const
+{
+    QString key = hash(row);
+    key += m_direction[row] == Monero::TransactionInfo::Direction_In ? QStringLiteral(":in") : QStringLiteral(":out");
+    for (int i = 0; i < subaddrIndexCount(row); ++i)
+    {
+        key += QLatin1Char(':') + QString::number(subaddrIndex(row, i));
+    }
+    return key;
+}
+
+bool TransactionHistoryStore::matches(int row, const Monero::TransactionInfo *pimpl) const
+{
+    const quint8 flags = (pimpl->isPending() ? FlagPending : 0) |
+        (pimpl->isFailed() ? FlagFailed : 0) |
+        (pimpl->isCoinbase() ? FlagCoinbase : 0);
+
+    if (m_amount[row] != pimpl->amount() ||
+        m_fee[row] != pimpl->fee() ||
+        m_blockHeight[row] != pimpl->blockHeight() ||
+        m_unlockTime[row] != pimpl->unlockTime() ||
+        m_timestamp[row] != static_cast<qint64>(pimpl->timestamp()) ||
+        m_flags[row] != flags ||
+        label(row) != QString::fromStdString(pimpl->label()) ||
+        description(row) != QString::fromStdString(pimpl->description()))
+    {
+        return false;
+    }
+
+    const auto &transfers = pimpl->transfers();
+    if (static_cast<size_t>(transferCount(row)) != transfers.size())
+    {
+        return false;
+    }
+    for (int i = 0; i < transferCount(row); ++i)
+    {
+        if (transferAmount(row, i) != transfers[i].amount ||
+            transferAddress(row, i) != QString::fromStdString(transfers[i].address))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+quint32 TransactionHistoryStore::update(int row, const TransactionRow &value)
+{
+    quint32 changed = ChangedNone;
+    const auto assign = [&changed](auto &field, const auto &newValue, ChangedField flag) {
+        if (field != newValue)
+        {
+            field = newValue;
+            changed |= flag;
+        }
+    };
+
+    assign(m_amount[row], value.amount, ChangedAmount);
+    assign(m_fee[row], value.fee, ChangedFee);
+    assign(m_blockHeight[row], value.blockHeight, ChangedBlockHeight);
+    assign(m_unlockTime[row], value.unlockTime, ChangedUnlockTime);
+    assign(m_timestamp[row], value.timestamp, ChangedTimestamp);
+    if (isPending(row) != value.pending)
+    {
+        m_flags[row] ^= FlagPending;
+        changed |= ChangedPending;
+    }
+    if (isFailed(row) != value.failed)
+    {
+        m_flags[row] ^= FlagFailed;
+        changed |= ChangedFailed;
+    }
+    if (label(row) != value.label)
+    {
+        m_label[row] = intern(value.label);
+        changed |= ChangedLabel;
+    }
+    if (description(row) != value.description)
+    {
+        m_description[row] = intern(value.description);
+        changed |= ChangedDescription;
+    }
+
+    bool transfersChanged = transferCount(row) != value.transfers.size();
+    for (int i = 0; !transfersChanged && i < value.transfers.size(); ++i)
+    {
+        transfersChanged = transferAmount(row, i) != value.transfers[i].first ||
+            transferAddress(row, i) != value.transfers[i].second;
+    }
+    if (transfersChanged)
+    {
+        // the previous range is left behind until the next compact()
+        setTransfers(row, value.transfers);
+        m_destinations[row] = makeDestinations(row);
+        changed |= ChangedTransfers;
+    }
+    if (changed & ChangedTimestamp)
+    {
+        setTimestampText(row);
+    }
+
+    if (changed & (ChangedAmount | ChangedFee | ChangedBlockHeight | ChangedTimestamp | ChangedLabel | ChangedDescription | ChangedTransfers))
+    {
+        m_searchText[row] = makeSearchText(row);
+    }
+    if (changed != ChangedNone)
+    {
+        m_stamp[row] = ++m_nextStamp;
+    }
+
+    return changed;
+}
+
+void TransactionHistoryStore::append(const TransactionRow &value)
+{
+    const int row = size();
+
+    m_amount.push_back(value.amount);
+    m_fee.push_back(value.fee);
+    m_blockHeight.push_back(value.blockHeight);
+    m_unlockTime.push_back(value.unlockTime);
+    m_timestamp.push_back(value.timestamp);
+    m_subaddrAccount.push_back(value.subaddrAccount);
+    m_direction.push_back(static_cast<quint8>(value.direction));
+    m_flags.push_back((value.pending ? FlagPending : 0) |
+                      (value.failed ? FlagFailed : 0) |
+                      (value.coinbase ? FlagCoinbase : 0));
+    m_hash.push_back(intern(value.hash));
+    m_label.push_back(intern(value.label));
+    m_paymentId.push_back(intern(value.paymentId));
+    m_description.push_back(intern(value.description));
+    m_date.push_back(0);
+    m_time.push_back(QString());
+    setTimestampText(row);
+
+    m_subaddrBegin.push_back(m_subaddrIndices.size());
+    m_subaddrCount.push_back(value.subaddrIndex.size());
+    m_subaddrIndices.append(value.subaddrIndex);
+
+    m_transferBegin.push_back(0);
+    m_transferCount.push_back(0);
+    setTransfers(row, value.transfers);
+    m_destinations.push_back(makeDestinations(row));
+
+    m_searchText.push_back(makeSearchText(row));
+    m_stamp.push_back(++m_nextStamp);
+
+    m_rowByKey.insert(value.key, row);
+}
+
+quint32 TransactionHistoryStore::setDescription(int row, const QString &description)
+{
+    if (this->description(row) == description)
+    {
+        return ChangedNone;
+    }
+
+    // the previous description is left behind until the next compact()
+    m_description[row] = intern(description);
+    m_searchText[row] = makeSearchText(row);
+    m_stamp[row] = ++m_nextStamp;
+    return ChangedDescription;
+}
+
+QVector<int> TransactionHistoryStore::rowsWithHash(const QString &hash) const
+{
+    QVector<int> rows;
+    const auto id = m_stringIds.constFind(hash);
+    if (id == m_stringIds.constEnd())
+    {
+        return rows;
+    }
+    // interned, comparing ids is enough
+    for (int row = 0; row < size(); ++row)
+    {
+        if (m_hash[row] == id.value())
+        {
+            rows.append(row);
+        }
+    }
+    return rows;
+}
+
+void TransactionHistoryStore::remove(int first, int last)
+{
+    const auto erase = [first, last](auto &column) {
+        column.erase(column.begin() + first, column.begin() + last + 1);
+    };
+
+    erase(m_amount);
+    erase(m_fee);
+    erase(m_blockHeight);
+    erase(m_unlockTime);
+    erase(m_timestamp);
+    erase(m_subaddrAccount);
+    erase(m_direction);
+    erase(m_flags);
+    erase(m_hash);
+    erase(m_label);
+    erase(m_paymentId);
+    erase(m_description);
+    erase(m_date);
+    erase(m_time);
+    erase(m_destinations);
+    erase(m_subaddrBegin);
+    erase(m_subaddrCount);
+    erase(m_transferBegin);
+    erase(m_transferCount);
+    erase(m_searchText);
+    erase(m_stamp);
+
+    compact();
+}
+
+quint32 TransactionHistoryStore::intern(const QString &string)
+{
+    const auto existing = m_stringIds.constFind(string);
+    if (existing != m_stringIds.constEnd())
+    {
+        return existing.value();
+    }
+
+    const quint32 id = m_strings.size();
+    m_strings.append(string);
+    m_stringIds.insert(string, id);
+    return id;
+}
+
+void TransactionHistoryStore::setTransfers(int row, const QVector<QPair<quint64, QString>> &transfers)
+{
+    m_transferBegin[row] = m_transferAmounts.size();
+    m_transferCount[row] = transfers.size();
+    for (const auto &transfer : transfers)
+    {
+        m_transferAmounts.push_back(transfer.first);
+        m_transferAddresses.push_back(intern(transfer.second));
+    }
+}
+
+void TransactionHistoryStore::setTimestampText(int row)
+{
+    const QDateTime timestamp = QDateTime::fromSecsSinceEpoch(m_timestamp[row]);
+    m_date[row] = intern(timestamp.date().toString(Qt::ISODate));
+    m_time[row] = timestamp.time().toString(Qt::ISODate);
+}
+
+QString TransactionHistoryStore::makeDestinations(int row) const
+{
+    QString destinations;
+    for (int i = 0; i < transferCount(row); ++i)
+    {
+        if (!destinations.isEmpty())
+            destinations += QLatin1String("<br> ");
+        WalletManager::appendDisplayAmount(destinations, transferAmount(row, i));
+        destinations += QLatin1String(": ") + transferAddress(row, i);
+    }
+    return destinations;
+}
+
+QString TransactionHistoryStore::makeSearchText(int row) const
+{
+    QString text;
+    text += paymentId(row) + QLatin1Char('\n');
+    WalletManager::appendDisplayAmount(text, m_amount[row]);
+    text += QLatin1Char('\n');
+    if (m_blockHeight[row] != 0)
+    {
+        text += QString::number(m_blockHeight[row]);
+    }
+    text += QLatin1Char('\n');
+    if (m_fee[row] != 0)
+    {
+        WalletManager::appendDisplayAmount(text, m_fee[row]);
+    }
+    text += QLatin1Char('\n');
+    text += hash(row) + QLatin1Char('\n');
+    text += date(row) + QLatin1Char('\n');
+    text += time(row) + QLatin1Char('\n');
+    text += label(row) + QLatin1Char('\n');
+    text += description(row) + QLatin1Char('\n');
+    for (int i = 0; i < transferCount(row); ++i)
+    {
+        WalletManager::appendDisplayAmount(text, transferAmount(row, i));
+        text += QStringLiteral(": ") + transferAddress(row, i) + QLatin1Char(' ');
+    }
+    return text.toLower();
+}
+
+void TransactionHistoryStore::compact()
+{
+    // drop flattened ranges and strings that no row references anymore
+    QVector<quint32> subaddrIndices;
+    QVector<quint64> transferAmounts;
+    QVector<quint32> transferAddresses;
+    subaddrIndices.reserve(m_subaddrIndices.size());
+    transferAmounts.reserve(m_transferAmounts.size());
+    transferAddresses.reserve(m_transferAddresses.size());
+
+    QVector<QString> strings;
+    QHash<QString, quint32> stringIds;
+    std::vector<quint32> remap(m_strings.size(), std::numeric_limits<quint32>::max());
+    const auto keep = [&](quint32 id) {
+        if (remap[id] == std::numeric_limits<quint32>::max())
+        {
+            remap[id] = strings.size();
+            strings.append(m_strings[id]);
+            stringIds.insert(m_strings[id], remap[id]);
+        }
+        return remap[id];
+    };
+
+    m_rowByKey.clear();
+    for (int row = 0; row < size(); ++row)
+    {
+        m_hash[row] = keep(m_hash[row]);
+        m_label[row] = keep(m_label[row]);
+        m_paymentId[row] = keep(m_paymentId[row]);
+        m_description[row] = keep(m_description[row]);
+        m_date[row] = keep(m_date[row]);
+
+        const quint32 subaddrBegin = subaddrIndices.size();
+        subaddrIndices.append(m_subaddrIndices.mid(m_subaddrBegin[row], m_subaddrCount[row]));
+        m_subaddrBegin[row] = subaddrBegin;
+
+        const quint32 transferBegin = transferAmounts.size();
+        for (quint32 i = m_transferBegin[row]; i < m_transferBegin[row] + m_transferCount[row]; ++i)
+        {
+            transferAmounts.push_back(m_transferAmounts[i]);
+            transferAddresses.push_back(keep(m_transferAddresses[i]));
+        }
+        m_transferBegin[row] = transferBegin;
+    }
+
+    m_subaddrIndices.swap(subaddrIndices);
+    m_transferAmounts.swap(transferAmounts);
+    m_transferAddresses.swap(transferAddresses);
+    m_strings.swap(strings);
+    m_stringIds.swap(stringIds);
+
+    for (int row = 0; row < size(); ++row)
+    {
+        m_rowByKey.insert(key(row), row);
+    }
+}
@@ -0,0 +1,219 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#ifndef TRANSACTIONHISTORYSTORE_H
+#define TRANSACTIONHISTORYSTORE_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+namespace Monero {
+struct TransactionInfo;
+}
+
+/**
+ * @brief The TransactionRow struct - value snapshot of one history entry,
+ * used to stage refreshes before they're applied to TransactionHistoryStore
+ */
+struct TransactionRow
+{
+    static TransactionRow fromPimpl(const Monero::TransactionInfo *pimpl);
+
+    //! identifies the same history entry across refreshes (hash, direction and subaddresses)
+    static QString makeKey(const Monero::TransactionInfo *pimpl);
+
+    QString key;
+    quint64 amount = 0;
+    quint64 fee = 0;
+    quint64 blockHeight = 0;
+    quint64 unlockTime = 0;
+    qint64 timestamp = 0;
+    quint32 subaddrAccount = 0;
+    int direction = 0;
+    bool pending = false;
+    bool failed = false;
+    bool coinbase = false;
+    QString hash;
+    QString label;
+    QString paymentId;
+    //! libwallet fills it with the wallet's user note of hash
+    QString description;
+    //! sorted
+    QVector<quint32> subaddrIndex;
+    QVector<QPair<quint64, QString>> transfers;
+};
+
+/**
+ * @brief The TransactionHistoryStore class - packed, struct-of-arrays storage
+ * of the history rows. Strings are interned, transfers and subaddress indices
+ * are flattened into shared arrays. Columns are implicitly shared, copying
+ * the store is a cheap snapshot.
+ */
+class TransactionHistoryStore
+{
+public:
+    //! bits returned by update(), a mask of fields that changed
+    enum ChangedField : quint32 {
+        ChangedNone          = 0,
+        ChangedAmount        = 1 << 0,
+        ChangedBlockHeight   = 1 << 1,
+        ChangedConfirmations = 1 << 2,
+        ChangedFailed        = 1 << 3,
+        ChangedFee           = 1 << 4,
+        ChangedPending       = 1 << 5,
+        ChangedUnlockTime    = 1 << 6,
+        ChangedTimestamp     = 1 << 7,
+        ChangedLabel         = 1 << 8,
+        ChangedDescription   = 1 << 9,
+        ChangedTransfers     = 1 << 10
+    };
+
+    int size() const { return static_cast<int>(m_amount.size()); }
+    //! returns row index for key or -1
+    int indexOf(const QString &key) const { return m_rowByKey.value(key, -1); }
+    QString key(int row) const;
+
+    quint64 amount(int row) const { return m_amount[row]; }
+    quint64 fee(int row) const { return m_fee[row]; }
+    quint64 blockHeight(int row) const { return m_blockHeight[row]; }
+    //! libwallet's rule, derived from the row's block height and the shared chain height
+    quint64 confirmations(int row) const
+    {
+        const quint64 height = m_blockHeight[row];
+        return isPending(row) || height == 0 || m_blockchainHeight <= height ? 0 : m_blockchainHeight - height;
+    }
+    quint64 requiredConfirmations(int row) const
+    {
+        return m_blockHeight[row] < m_unlockTime[row] ? m_unlockTime[row] - m_blockHeight[row] : 10;
+    }
+    //! pending or short of its required confirmations
+    bool isLocked(int row) const { return isPending(row) || confirmations(row) < requiredConfirmations(row); }
+    quint64 unlockTime(int row) const { return m_unlockTime[row]; }
+    qint64 timestamp(int row) const { return m_timestamp[row]; }
+    quint32 subaddrAccount(int row) const { return m_subaddrAccount[row]; }
+    int direction(int row) const { return m_direction[row]; }
+    bool isPending(int row) const { return m_flags[row] & FlagPending; }
+    bool isFailed(int row) const { return m_flags[row] & FlagFailed; }
+    bool isCoinbase(int row) const { return m_flags[row] & FlagCoinbase; }
+    const QString &hash(int row) const { return m_strings[m_hash[row]]; }
+    const QString &label(int row) const { return m_strings[m_label[row]]; }
+    const QString &paymentId(int row) const { return m_strings[m_paymentId[row]]; }
+    const QString &description(int row) const { return m_strings[m_description[row]]; }
+
+    int subaddrIndexCount(int row) const { return m_subaddrCount[row]; }
+    quint32 subaddrIndex(int row, int i) const { return m_subaddrIndices[m_subaddrBegin[row] + i]; }
+
+    //! changes whenever the row is added or updated, unique across rows
+    quint64 stamp(int row) const { return m_stamp[row]; }
+    //! new stamp for a row whose derived values moved, e.g. its confirmations
+    void touch(int row) { m_stamp[row] = ++m_nextStamp; }
+
+    int transferCount(int row) const { return m_transferCount[row]; }
+    quint64 transferAmount(int row, int i) const { return m_transferAmounts[m_transferBegin[row] + i]; }
+    const QString &transferAddress(int row, int i) const { return m_strings[m_transferAddresses[m_transferBegin[row] + i]]; }
+
+    //! ISO date and time of timestamp(row), formatted once per timestamp change
+    const QString &date(int row) const { return m_strings[m_date[row]]; }
+    const QString &time(int row) const { return m_time[row]; }
+    //! "amount: address" per transfer, separated by "<br> "
+    const QString &destinations(int row) const { return m_destinations[row]; }
+
+    //! lowercase payment id, amount, height, fee, hash, date, time, label, description
+    //! and destinations, one field per line, used for substring search
+    const QString &searchText(int row) const { return m_searchText[row]; }
+
+    //! chain height the confirmations are counted against, no row changes with it
+    quint64 blockchainHeight() const { return m_blockchainHeight; }
+    void setBlockchainHeight(quint64 height) { m_blockchainHeight = height; }
+
+    //! returns true when pimpl holds the same values as row, confirmations aside
+    bool matches(int row, const Monero::TransactionInfo *pimpl) const;
+    //! copies the mutable fields of value into row, returns a mask of ChangedField
+    quint32 update(int row, const TransactionRow &value);
+    void append(const TransactionRow &value);
+    //! user note edit, returns ChangedDescription if the description of row changed,
+    //! ChangedNone otherwise
+    quint32 setDescription(int row, const QString &description);
+    //! all rows of one transaction, one per direction and subaddress set
+    QVector<int> rowsWithHash(const QString &hash) const;
+    //! removes rows [first, last]
+    void remove(int first, int last);
+
+private:
+    enum Flag : quint8 {
+        FlagPending  = 1 << 0,
+        FlagFailed   = 1 << 1,
+        FlagCoinbase = 1 << 2
+    };
+
+    quint32 intern(const QString &string);
+    void setTransfers(int row, const QVector<QPair<quint64, QString>> &transfers);
+    void setTimestampText(int row);
+    QString makeDestinations(int row) const;
+    QString makeSearchText(int row) const;
+    void compact();
+
+private:
+    QVector<quint64> m_amount;
+    QVector<quint64> m_fee;
+    QVector<quint64> m_blockHeight;
+    QVector<quint64> m_unlockTime;
+    QVector<qint64> m_timestamp;
+    QVector<quint32> m_subaddrAccount;
+    QVector<quint8> m_direction;
+    QVector<quint8> m_flags;
+    // interned string ids, see m_strings
+    QVector<quint32> m_hash;
+    QVector<quint32> m_label;
+    QVector<quint32> m_paymentId;
+    QVector<quint32> m_description;
+    // many rows share a day, dates are interned too
+    QVector<quint32> m_date;
+    QVector<QString> m_time;
+    QVector<QString> m_destinations;
+    // [begin, begin + count) ranges into the flattened arrays below
+    QVector<quint32> m_subaddrBegin;
+    QVector<quint32> m_subaddrCount;
+    QVector<quint32> m_transferBegin;
+    QVector<quint32> m_transferCount;
+    QVector<quint32> m_subaddrIndices;
+    QVector<quint64> m_transferAmounts;
+    QVector<quint32> m_transferAddresses;
+    QVector<QString> m_searchText;
+    QVector<quint64> m_stamp;
+    quint64 m_nextStamp = 0;
+    quint64 m_blockchainHeight = 0;
+
+    QVector<QString> m_strings;
+    QHash<QString, quint32> m_stringIds;
+    QHash<QString, int> m_rowByKey;
+};
+
+#endif // TRANSACTIONHISTORYSTORE_H
@@ -28,7 +28,6 @@
 
 #include "TransactionInfo.h"
 #include "WalletManager.h"
-#include "Transfer.h"
 #include <QDateTime>
 #include <QDebug>
 
@@ -55,7 +54,7 @@ bool TransactionInfo::isCoinbase() const
 double TransactionInfo::amount() const
 {
     // there's no unsigned uint64 for JS, so better use double
-    return displayAmount().toDouble();
+    return WalletManager::displayAmountToDouble(m_amount);
 }
 
 quint64 TransactionInfo::atomicAmount() const
@@ -117,12 +116,12 @@ QDateTime TransactionInfo::timestamp() const
 
 QString TransactionInfo::date() const
 {
-    return timestamp().date().toString(Qt::ISODate);
+    return m_date;
 }
 
 QString TransactionInfo::time() const
 {
-    return timestamp().time().toString(Qt::ISODate);
+    return m_time;
 }
 
 QString TransactionInfo::paymentId() const
@@ -137,13 +136,7 @@ QString TransactionInfo::description() const
 
 QString TransactionInfo::destinations_formatted() const
 {
-    QString destinations;
-    for (auto const& t: m_transfers) {
-        if (!destinations.isEmpty())
-          destinations += "<br> ";
-        destinations +=  WalletManager::displayAmount(t->amount()) + ": " + t->address();
-    }
-    return destinations;
+    return m_destinationsFormatted;
 }
 
 TransactionInfo::TransactionInfo(const Monero::TransactionInfo *pimpl, QObject *parent)
@@ -164,11 +157,17 @@ TransactionInfo::TransactionInfo(const Monero::TransactionInfo *pimpl, QObject *
     , m_timestamp(QDateTime::fromSecsSinceEpoch(pimpl->timestamp()))
     , m_unlockTime(pimpl->unlockTime())
 {
+    m_transfers.reserve(pimpl->transfers().size());
     for (auto const &t: pimpl->transfers())
     {
-        Transfer *transfer = new Transfer(t.amount, QString::fromStdString(t.address), this);
-        m_transfers.append(transfer);
+        m_transfers.append(Transfer{t.amount, QString::fromStdString(t.address)});
+        if (!m_destinationsFormatted.isEmpty())
+            m_destinationsFormatted += QLatin1String("<br> ");
+        WalletManager::appendDisplayAmount(m_destinationsFormatted, t.amount);
+        m_destinationsFormatted += QLatin1String(": ") + m_transfers.last().address;
     }
+    m_date = m_timestamp.date().toString(Qt::ISODate);
+    m_time = m_timestamp.time().toString(Qt::ISODate);
     for (uint32_t i : pimpl->subaddrIndex())
     {
         m_subaddrIndex.insert(i);
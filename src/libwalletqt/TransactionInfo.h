@@ -33,8 +33,9 @@
 #include <QObject>
 #include <QDateTime>
 #include <QSet>
+#include <QVector>
 
-class Transfer;
+#include "Transfer.h"
 
 class TransactionInfo : public QObject
 {
@@ -98,7 +99,7 @@ private:
     explicit TransactionInfo(const Monero::TransactionInfo *pimpl, QObject *parent = 0);
 private:
     friend class TransactionHistory;
-    mutable QList<Transfer*> m_transfers;
+    QVector<Transfer> m_transfers;
     quint64 m_amount;
     quint64 m_blockHeight;
     quint64 m_confirmations;
@@ -115,6 +116,10 @@ private:
     QSet<quint32> m_subaddrIndex;
     QDateTime m_timestamp;
     quint64 m_unlockTime;
+    // derived from the fields above, formatted once
+    QString m_date;
+    QString m_time;
+    QString m_destinationsFormatted;
 };
 
 #endif // TRANSACTIONINFO_H
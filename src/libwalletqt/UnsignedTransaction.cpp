@@ -42,57 +42,42 @@ QString UnsignedTransaction::errorString() const
 
 quint64 UnsignedTransaction::amount(size_t index) const
 {
-    std::vector<uint64_t> arr = m_pimpl->amount();
-    if(index > arr.size() - 1)
-        return 0;
-    return arr[index];
+    return index < m_amount.size() ? m_amount[index] : 0;
 }
 
 quint64 UnsignedTransaction::fee(size_t index) const
 {
-    std::vector<uint64_t> arr = m_pimpl->fee();
-    if(index > arr.size() - 1)
-        return 0;
-    return arr[index];
+    return index < m_fee.size() ? m_fee[index] : 0;
 }
 
 quint64 UnsignedTransaction::mixin(size_t index) const
 {
-    std::vector<uint64_t> arr = m_pimpl->mixin();
-    if(index > arr.size() - 1)
-        return 0;
-    return arr[index];
+    return index < m_mixin.size() ? m_mixin[index] : 0;
 }
 
 quint64 UnsignedTransaction::txCount() const
 {
-    return m_pimpl->txCount();
+    return m_txCount;
 }
 
 quint64 UnsignedTransaction::minMixinCount() const
 {
-    return m_pimpl->minMixinCount();
+    return m_minMixinCount;
 }
 
 QString UnsignedTransaction::confirmationMessage() const
 {
-    return QString::fromStdString(m_pimpl->confirmationMessage());
+    return m_confirmationMessage;
 }
 
 QStringList UnsignedTransaction::paymentId() const
 {
-    QList<QString> list;
-    for (const auto &t: m_pimpl->paymentId())
-        list.append(QString::fromStdString(t));
-    return list;
+    return m_paymentId;
 }
 
 QStringList UnsignedTransaction::recipientAddress() const
 {
-    QList<QString> list;
-    for (const auto &t: m_pimpl->recipientAddress())
-        list.append(QString::fromStdString(t));
-    return list;
+    return m_recipientAddress;
 }
 
 bool UnsignedTransaction::sign(const QString &fileName) const
@@ -110,8 +95,17 @@ void UnsignedTransaction::setFilename(const QString &fileName)
 
 UnsignedTransaction::UnsignedTransaction(Monero::UnsignedTransaction *pt, Monero::Wallet *walletImpl, QObject *parent)
     : QObject(parent), m_pimpl(pt), m_walletImpl(walletImpl)
+    , m_amount(pt->amount())
+    , m_fee(pt->fee())
+    , m_mixin(pt->mixin())
+    , m_txCount(pt->txCount())
+    , m_minMixinCount(pt->minMixinCount())
+    , m_confirmationMessage(QString::fromStdString(pt->confirmationMessage()))
 {
-
+    for (const auto &t: pt->recipientAddress())
+        m_recipientAddress.append(QString::fromStdString(t));
+    for (const auto &t: pt->paymentId())
+        m_paymentId.append(QString::fromStdString(t));
 }
 
 UnsignedTransaction::~UnsignedTransaction()
@@ -29,7 +29,10 @@
 #ifndef UNSIGNEDTRANSACTION_H
 #define UNSIGNEDTRANSACTION_H
 
+#include <vector>
+
 #include <QObject>
+#include <QStringList>
 
 #include <wallet/api/wallet2_api.h>
 
@@ -75,6 +78,15 @@ private:
     Monero::UnsignedTransaction * m_pimpl;
     QString m_fileName;
     Monero::Wallet * m_walletImpl;
+    // read once, libwallet returns copies of whole vectors on every call
+    std::vector<uint64_t> m_amount;
+    std::vector<uint64_t> m_fee;
+    std::vector<uint64_t> m_mixin;
+    QStringList m_recipientAddress;
+    QStringList m_paymentId;
+    quint64 m_txCount;
+    quint64 m_minMixinCount;
+    QString m_confirmationMessage;
 };
 
 #endif // UNSIGNEDTRANSACTION_H
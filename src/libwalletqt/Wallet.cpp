@@ -28,18 +28,23 @@
 
 #include "Wallet.h"
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <limits>
 #include <stdexcept>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include "PendingTransaction.h"
 #include "UnsignedTransaction.h"
 #include "TransactionHistory.h"
+#include "TransactionHistorySnapshot.h"
 #include "AddressBook.h"
+#include "CsvReader.h"
 #include "Subaddress.h"
 #include "SubaddressAccount.h"
+#include "RestoreHeightTable.h"
 #include "model/TransactionHistoryModel.h"
 #include "model/TransactionHistorySortFilterModel.h"
 #include "model/AddressBookModel.h"
@@ -49,22 +54,106 @@
 
 #include <QFile>
 #include <QDir>
+#include <QDeadlineTimer>
 #include <QDebug>
 #include <QUrl>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QtConcurrent/QtConcurrent>
 #include <QList>
 #include <QVector>
+#include <QVariantMap>
 #include <QMutexLocker>
+#include <QWaitCondition>
 
+#include "qt/BackgroundSyncPolicy.h"
+#include "qt/EventTrace.h"
+#include "qt/IndexedMap.h"
 #include "qt/ScopeGuard.h"
 
 namespace {
-    static const int DAEMON_BLOCKCHAIN_HEIGHT_CACHE_TTL_SECONDS = 5;
+    static const int DAEMON_STATUS_CACHE_TTL_SECONDS = 5;
     static const int DAEMON_BLOCKCHAIN_TARGET_HEIGHT_CACHE_TTL_SECONDS = 30;
     static const int WALLET_CONNECTION_STATUS_CACHE_TTL_SECONDS = 5;
+    // a status query slower than this counts against the node and is hedged if enabled
+    static constexpr std::chrono::milliseconds DAEMON_LATENCY_BUDGET{1500};
+    static constexpr std::chrono::milliseconds DAEMON_HEDGE_TIMEOUT{5000};
 
     static constexpr char ATTRIBUTE_SUBADDRESS_ACCOUNT[] ="gui.subaddress_account";
+    static constexpr char ATTRIBUTE_SUBADDRESS_LOOKAHEAD[] = "gui.subaddress_lookahead_minor";
+
+    // ring members separated by single spaces
+    void appendRing(std::string &out, const std::vector<uint64_t> &ring)
+    {
+        char buffer[20];
+        out.reserve(out.size() + ring.size() * 9);
+        for (size_t index = 0; index < ring.size(); ++index)
+        {
+            if (index > 0)
+                out.push_back(' ');
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), ring[index]);
+            out.append(buffer, result.ptr);
+        }
+    }
+
+    // false on a token that isn't a number or overflows, ring is then incomplete
+    bool parseRing(QStringView text, std::vector<uint64_t> &ring)
+    {
+        constexpr uint64_t max = std::numeric_limits<uint64_t>::max();
+        uint64_t value = 0;
+        bool digits = false;
+        for (qsizetype index = 0; index <= text.size(); ++index)
+        {
+            const char16_t c = index < text.size() ? text[index].unicode() : u' ';
+            if (c == u' ')
+            {
+                if (digits)
+                    ring.push_back(value);
+                value = 0;
+                digits = false;
+            }
+            else if (c >= u'0' && c <= u'9')
+            {
+                const uint64_t digit = c - u'0';
+                if (value > (max - digit) / 10)
+                    return false;
+                value = value * 10 + digit;
+                digits = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // txids and key images are 32 bytes in hex
+    bool isHash(QStringView text)
+    {
+        if (text.size() != 64)
+            return false;
+        for (const QChar c : text)
+        {
+            const char16_t u = c.unicode();
+            if (!((u >= u'0' && u <= u'9') || (u >= u'a' && u <= u'f') || (u >= u'A' && u <= u'F')))
+                return false;
+        }
+        return true;
+    }
+
+    // Every refresh loop keeps a BlockingIO thread for as long as the wallet
+    // is open, the lane grows by one thread per loop so that the other I/O
+    // work still has the lane's own threads however many wallets are open.
+    void reserveRefreshLoopThread(int delta)
+    {
+        static QMutex mutex;
+        QMutexLocker locker(&mutex);
+        const int threads = FutureScheduler::maxConcurrency(FutureScheduler::BlockingIO);
+        FutureScheduler::setMaxConcurrency(FutureScheduler::BlockingIO, threads + delta);
+    }
 }
 
 Wallet::Wallet(QObject * parent)
@@ -106,7 +195,7 @@ void Wallet::updateConnectionStatusAsync()
         {
             setConnectionStatus(ConnectionStatus_Connecting);
         }
-        ConnectionStatus newStatus = static_cast<ConnectionStatus>(m_walletImpl->connected());
+        ConnectionStatus newStatus = daemonStatus(true).connection;
         qDebug() << "Newest wallet status:" << newStatus;
         if (m_connectionStatus != newStatus)
         {
@@ -119,7 +208,7 @@ void Wallet::updateConnectionStatusAsync()
         // Release lock
         m_connectionStatusRunning = false;
         m_connectionStatusTime.restart();
-    });
+    }, FutureScheduler::Interactive, "Wallet::updateConnectionStatusAsync");
 }
 
 Wallet::ConnectionStatus Wallet::connected(bool forceCheck)
@@ -196,7 +285,7 @@ void Wallet::setProxyAddress(QString address)
             m_proxyAddress = address;
         }
         emit proxyAddressChanged();
-    });
+    }, FutureScheduler::Background, "Wallet::setProxyAddress");
 }
 
 bool Wallet::synchronized() const
@@ -211,7 +300,18 @@ QString Wallet::errorString() const
 
 bool Wallet::setPassword(const QString &password)
 {
-    return m_walletImpl->setPassword(password.toStdString());
+    if (!m_walletImpl->setPassword(password.toStdString()))
+    {
+        return false;
+    }
+
+    // the snapshot follows the password, the next store rewrites it under the new keys
+    QMutexLocker locker(&m_historySnapshotMutex);
+    if (m_historySnapshot)
+    {
+        m_historySnapshot.reset(new TransactionHistorySnapshot(QString::fromStdString(m_walletImpl->path()), password, m_kdfRounds));
+    }
+    return true;
 }
 
 QString Wallet::address(quint32 accountIndex, quint32 addressIndex) const
@@ -224,21 +324,101 @@ QString Wallet::path() const
     return QDir::toNativeSeparators(QString::fromStdString(m_walletImpl->path()));
 }
 
+void Wallet::openHistorySnapshot(const QString &password, quint64 kdfRounds)
+{
+    QElapsedTimer timer;
+    timer.start();
+    auto snapshot = std::make_unique<TransactionHistorySnapshot>(QString::fromStdString(m_walletImpl->path()), password, kdfRounds);
+    // the last session's history shows until the first refresh reconciles it
+    if (m_history->loadSnapshot(*snapshot))
+    {
+        qInfo() << "Loaded history snapshot:" << m_history->rows().size() << "rows in" << timer.elapsed() << "ms";
+    }
+
+    QMutexLocker locker(&m_historySnapshotMutex);
+    m_kdfRounds = kdfRounds;
+    m_historySnapshot = std::move(snapshot);
+}
+
+bool Wallet::storeHistorySnapshot()
+{
+    QMutexLocker locker(&m_historySnapshotMutex);
+    return m_historySnapshot && m_history->saveSnapshot(*m_historySnapshot);
+}
+
 void Wallet::storeAsync(const QJSValue &callback, const QString &path /* = "" */)
 {
     const auto future = m_scheduler.run(
         [this, path] {
-            QMutexLocker locker(&m_asyncMutex);
+            bool result;
+            {
+                QMutexLocker locker(&m_asyncMutex);
 
-            return QJSValueList({m_walletImpl->store(path.toStdString())});
+                result = m_walletImpl->store(path.toStdString());
+            }
+            // a copy stored elsewhere gets no snapshot, it belongs to the open file
+            if (result && path.isEmpty())
+            {
+                storeHistorySnapshot();
+            }
+            return QJSValueList({result});
         },
-        callback);
+        callback,
+        FutureScheduler::BlockingIO, "Wallet::storeAsync");
     if (!future.first)
     {
         QJSValue(callback).call(QJSValueList({false}));
     }
 }
 
+void Wallet::scheduleStore()
+{
+    if (QThread::currentThread() != thread())
+    {
+        QMetaObject::invokeMethod(this, &Wallet::scheduleStore, Qt::QueuedConnection);
+        return;
+    }
+    // every further edit pushes the store back
+    m_storeTimer->start();
+}
+
+void Wallet::storeScheduled()
+{
+    // edits made while storing get a store of their own
+    if (m_storeRunning)
+    {
+        m_storeAgain = true;
+        return;
+    }
+
+    m_storeRunning = true;
+    const auto future = m_scheduler.run([this] {
+        bool result;
+        {
+            QMutexLocker locker(&m_asyncMutex);
+
+            result = m_walletImpl->store("");
+        }
+        if (result)
+        {
+            storeHistorySnapshot();
+        }
+        QMetaObject::invokeMethod(this, [this, result] {
+            m_storeRunning = false;
+            if (m_storeAgain)
+            {
+                m_storeAgain = false;
+                m_storeTimer->start();
+            }
+            emit scheduledStoreFinished(result);
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "Wallet::storeScheduled");
+    if (!future.first)
+    {
+        m_storeRunning = false;
+    }
+}
+
 bool Wallet::init(const QString &daemonAddress, bool trustedDaemon, quint64 upperTransactionLimit, bool isRecovering, bool isRecoveringFromDevice, quint64 restoreHeight, const QString& proxyAddress)
 {
     qDebug() << "init non async";
@@ -263,6 +443,7 @@ bool Wallet::init(const QString &daemonAddress, bool trustedDaemon, quint64 uppe
         }
 
 
+        m_daemonAddress = daemonAddress;
         m_proxyAddress = proxyAddress;
     }
     emit proxyAddressChanged();
@@ -291,6 +472,9 @@ void Wallet::initAsync(
     m_initializing = true;
     pauseRefresh();
     const auto future = m_scheduler.run([this, daemonAddress, trustedDaemon, upperTransactionLimit, isRecovering, isRecoveringFromDevice, restoreHeight, proxyAddress] {
+        QElapsedTimer timer;
+        timer.start();
+        m_syncProfile.start(m_walletImpl->blockChainHeight());
         m_initialized = init(
             daemonAddress,
             trustedDaemon,
@@ -302,15 +486,18 @@ void Wallet::initAsync(
         m_initializing = false;
         if (m_initialized)
         {
+            const qint64 initMs = timer.restart();
+            publishBalanceSnapshot();
             emit walletCreationHeightChanged();
             qDebug() << "init async finished: " + daemonAddress;
             connected(true);
+            qInfo("Wallet init timing: daemon setup %lld ms, connection check %lld ms", initMs, timer.elapsed());
         }
         else
         {
             qCritical() << "Failed to initialize the wallet";
         }
-    });
+    }, FutureScheduler::BlockingIO, "Wallet::initAsync");
     if (future.first)
     {
         setConnectionStatus(Wallet::ConnectionStatus_Connecting);
@@ -351,6 +538,76 @@ void Wallet::setTrustedDaemon(bool arg)
     m_walletImpl->setTrustedDaemon(arg);
 }
 
+void Wallet::setFailoverNodes(const QVariantList &nodes, int current, const QString &proxyAddress)
+{
+    std::vector<DaemonPool::Node> pool;
+    pool.reserve(nodes.size());
+    for (const QVariant &node : nodes)
+    {
+        const QVariantMap fields = node.toMap();
+        pool.push_back({
+            fields.value("address").toString(),
+            fields.value("username").toString(),
+            fields.value("password").toString(),
+            fields.value("trusted").toBool(),
+        });
+    }
+    m_daemonPool.setNodes(pool, current, proxyAddress);
+}
+
+void Wallet::extendRestoreHeightTable()
+{
+    // timestamps from an untrusted node could push restores past the user's funds
+    if (!m_walletImpl->trustedDaemon())
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_proxyMutex);
+    const QString address = m_daemonAddress;
+    const QString proxyAddress = m_proxyAddress;
+    locker.unlock();
+    const NetworkType::Type networkType = nettype();
+    const QString username = m_daemonUsername;
+    const QString password = m_daemonPassword;
+    m_scheduler.run([networkType, address, username, password, proxyAddress] {
+        RestoreHeightTable::instance()->extendFromDaemon(networkType, address, username, password, proxyAddress);
+    }, FutureScheduler::BlockingIO, "Wallet::extendRestoreHeightTable");
+}
+
+bool Wallet::hedgeDaemonRequests() const
+{
+    return m_hedgeDaemonRequests;
+}
+
+void Wallet::setHedgeDaemonRequests(bool hedge)
+{
+    if (m_hedgeDaemonRequests.exchange(hedge) != hedge)
+    {
+        emit hedgeDaemonRequestsChanged();
+    }
+}
+
+void Wallet::failoverDaemon()
+{
+    // another failover or a user initiated connection is already under way
+    if (m_initializing || !m_daemonPool.shouldFailover())
+    {
+        return;
+    }
+
+    const std::optional<DaemonPool::Candidate> candidate = m_daemonPool.failover();
+    if (!candidate)
+    {
+        return;
+    }
+
+    qWarning() << "Remote node is unhealthy, failing over to" << candidate->node.address;
+    setDaemonLogin(candidate->node.username, candidate->node.password);
+    initAsync(candidate->node.address, candidate->node.trusted, 0, false, false, 0, m_daemonPool.proxyAddress(candidate->node));
+    emit daemonFailover(candidate->index, candidate->node.address);
+}
+
 bool Wallet::viewOnly() const
 {
     return m_walletImpl->watchOnly();
@@ -363,11 +620,19 @@ quint64 Wallet::balance() const
 
 quint64 Wallet::balance(quint32 accountIndex) const
 {
+    if (const BalanceSnapshot *snapshot = balanceSnapshot())
+    {
+        return accountIndex < static_cast<quint32>(snapshot->balance.size()) ? snapshot->balance[accountIndex] : 0;
+    }
     return m_walletImpl->balance(accountIndex);
 }
 
 quint64 Wallet::balanceAll() const
 {
+    if (const BalanceSnapshot *snapshot = balanceSnapshot())
+    {
+        return snapshot->balanceAll;
+    }
     return m_walletImpl->balanceAll();
 }
 
@@ -378,14 +643,68 @@ quint64 Wallet::unlockedBalance() const
 
 quint64 Wallet::unlockedBalance(quint32 accountIndex) const
 {
+    if (const BalanceSnapshot *snapshot = balanceSnapshot())
+    {
+        return accountIndex < static_cast<quint32>(snapshot->unlockedBalance.size()) ? snapshot->unlockedBalance[accountIndex] : 0;
+    }
     return m_walletImpl->unlockedBalance(accountIndex);
 }
 
 quint64 Wallet::unlockedBalanceAll() const
 {
+    if (const BalanceSnapshot *snapshot = balanceSnapshot())
+    {
+        return snapshot->unlockedBalanceAll;
+    }
     return m_walletImpl->unlockedBalanceAll();
 }
 
+const Wallet::BalanceSnapshot *Wallet::balanceSnapshot() const
+{
+    // only the wallet's thread is covered by the deferred release below
+    if (QThread::currentThread() != thread())
+    {
+        return nullptr;
+    }
+    return m_balanceSnapshot.loadAcquire();
+}
+
+bool Wallet::publishBalanceSnapshot()
+{
+    auto snapshot = std::make_shared<BalanceSnapshot>();
+    const quint32 accounts = m_walletImpl->numSubaddressAccounts();
+    snapshot->balance.reserve(accounts);
+    snapshot->unlockedBalance.reserve(accounts);
+    for (quint32 accountIndex = 0; accountIndex < accounts; ++accountIndex)
+    {
+        snapshot->balance.append(m_walletImpl->balance(accountIndex));
+        snapshot->unlockedBalance.append(m_walletImpl->unlockedBalance(accountIndex));
+        snapshot->balanceAll += snapshot->balance.last();
+        snapshot->unlockedBalanceAll += snapshot->unlockedBalance.last();
+    }
+
+    std::shared_ptr<const BalanceSnapshot> previous;
+    {
+        QMutexLocker locker(&m_balanceSnapshotMutex);
+        if (m_balanceSnapshotOwner
+            && m_balanceSnapshotOwner->balance == snapshot->balance
+            && m_balanceSnapshotOwner->unlockedBalance == snapshot->unlockedBalance)
+        {
+            return false;
+        }
+        previous = std::move(m_balanceSnapshotOwner);
+        m_balanceSnapshotOwner = snapshot;
+        m_balanceSnapshot.storeRelease(snapshot.get());
+    }
+
+    if (previous)
+    {
+        // the queued call owns the previous snapshot until it has run
+        QMetaObject::invokeMethod(this, [previous] {}, Qt::QueuedConnection);
+    }
+    return true;
+}
+
 quint32 Wallet::currentSubaddressAccount() const
 {
     return m_currentSubaddressAccount;
@@ -399,8 +718,12 @@ void Wallet::switchSubaddressAccount(quint32 accountIndex)
         {
             qWarning() << "failed to set " << ATTRIBUTE_SUBADDRESS_ACCOUNT << " cache attribute";
         }
-        m_subaddress->refresh(m_currentSubaddressAccount);
-        m_history->refresh(m_currentSubaddressAccount);
+        if (Subaddress *subaddress = m_subaddress.loadAcquire())
+        {
+            subaddress->refresh(m_currentSubaddressAccount);
+        }
+        // the history holds every account, the views only filter again
+        m_history->setAccountIndex(m_currentSubaddressAccount);
         emit currentSubaddressAccountChanged();
     }
 }
@@ -408,6 +731,7 @@ void Wallet::addSubaddressAccount(const QString& label)
 {
     m_walletImpl->addSubaddressAccount(label.toStdString());
     switchSubaddressAccount(numSubaddressAccounts() - 1);
+    scheduleStore();
 }
 quint32 Wallet::numSubaddressAccounts() const
 {
@@ -417,9 +741,142 @@ quint32 Wallet::numSubaddresses(quint32 accountIndex) const
 {
     return m_walletImpl->numSubaddresses(accountIndex);
 }
+
+quint32 Wallet::subaddressLookahead() const
+{
+    return m_subaddressLookahead->minor();
+}
+
+QVariantMap Wallet::subaddressLookaheadCost() const
+{
+    QVector<quint32> numSubaddresses;
+    const quint32 accounts = m_walletImpl->numSubaddressAccounts();
+    numSubaddresses.reserve(accounts);
+    for (quint32 accountIndex = 0; accountIndex < accounts; ++accountIndex)
+    {
+        numSubaddresses.append(m_walletImpl->numSubaddresses(accountIndex));
+    }
+    return m_subaddressLookahead->cost(numSubaddresses);
+}
+
+void Wallet::updateSubaddressLookahead()
+{
+    if (m_subaddressLookahead->update(m_history->subaddressUsage()))
+    {
+        applySubaddressLookahead();
+    }
+}
+
+void Wallet::applySubaddressLookahead()
+{
+    const quint32 minor = m_subaddressLookahead->minor();
+    qInfo() << "Growing subaddress lookahead to" << minor;
+    // libwallet derives the new keys right away, later blocks are scanned with them
+    m_walletImpl->setSubaddressLookahead(m_subaddressLookahead->major(), minor);
+    if (!setCacheAttribute(ATTRIBUTE_SUBADDRESS_LOOKAHEAD, QString::number(minor)))
+    {
+        qWarning() << "failed to set " << ATTRIBUTE_SUBADDRESS_LOOKAHEAD << " cache attribute";
+    }
+    emit subaddressLookaheadChanged();
+}
+
+void Wallet::growSubaddressLookaheadAndRescanAsync(const QJSValue &callback)
+{
+    const auto future = m_scheduler.run([this] {
+        QMutexLocker locker(&m_asyncMutex);
+
+        if (!m_subaddressLookahead->grow())
+        {
+            return QJSValueList({false, QString("subaddress lookahead is at its maximum")});
+        }
+        applySubaddressLookahead();
+
+        QString error;
+        const bool result = m_walletImpl->rescanBlockchain();
+        if (!result)
+        {
+            error = QString::fromStdString(m_walletImpl->errorString());
+        }
+        publishBalanceSnapshot();
+        m_transfersChanged = true;
+        return QJSValueList({result, error});
+    }, callback, FutureScheduler::BlockingIO, "Wallet::growSubaddressLookaheadAndRescanAsync");
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({false, QString("")}));
+    }
+}
 void Wallet::addSubaddress(const QString& label)
 {
     m_walletImpl->addSubaddress(currentSubaddressAccount(), label.toStdString());
+    scheduleStore();
+}
+void Wallet::addSubaddressesAsync(quint32 accountIndex, quint32 count, const QString &labelPattern)
+{
+    const QVariantMap request{
+        {"count", count},
+        {"labelPattern", labelPattern},
+    };
+    // requests for an account still waiting for the device are derived together
+    if (isHwBacked())
+    {
+        m_deviceQueue->enqueueBatch("Wallet::addSubaddressesAsync", QString("subaddresses/%1").arg(accountIndex), request,
+            [this, accountIndex](const QVariantList &requests) {
+                addSubaddresses(accountIndex, requests);
+            });
+        return;
+    }
+
+    m_scheduler.run([this, accountIndex, request] {
+        addSubaddresses(accountIndex, {request});
+    }, FutureScheduler::Background, "Wallet::addSubaddressesAsync");
+}
+
+void Wallet::addSubaddresses(quint32 accountIndex, const QVariantList &requests)
+{
+    QList<QPair<quint32, quint32>> added;
+    bool stored = false;
+    {
+        QMutexLocker locker(&m_asyncMutex);
+
+        if (accountIndex >= m_walletImpl->numSubaddressAccounts())
+        {
+            qWarning() << "Cannot add subaddresses to unknown account" << accountIndex;
+            return;
+        }
+
+        for (const QVariant &value : requests)
+        {
+            const QVariantMap request = value.toMap();
+            const quint32 count = request.value("count").toUInt();
+            const QString labelPattern = request.value("labelPattern").toString();
+            const quint32 firstIndex = m_walletImpl->numSubaddresses(accountIndex);
+            const bool numbered = labelPattern.contains(QStringLiteral("%1"));
+            for (quint32 index = firstIndex; index < firstIndex + count; ++index)
+            {
+                const QString label = numbered ? labelPattern.arg(index) : labelPattern;
+                m_walletImpl->addSubaddress(accountIndex, label.toStdString());
+            }
+            added.append({firstIndex, count});
+        }
+
+        stored = m_walletImpl->store("");
+        if (!stored)
+        {
+            qWarning() << "Failed to store wallet after adding subaddresses:" << QString::fromStdString(m_walletImpl->errorString());
+        }
+
+        // one refresh, the model appends the new rows in a single step
+        Subaddress *subaddress = m_subaddress.loadAcquire();
+        if (subaddress && accountIndex == currentSubaddressAccount())
+        {
+            subaddress->refresh(accountIndex);
+        }
+    }
+    for (const auto &range : added)
+    {
+        emit subaddressesAdded(accountIndex, range.first, range.second, stored);
+    }
 }
 QString Wallet::getSubaddressLabel(quint32 accountIndex, quint32 addressIndex) const
 {
@@ -428,11 +885,12 @@ QString Wallet::getSubaddressLabel(quint32 accountIndex, quint32 addressIndex) c
 void Wallet::setSubaddressLabel(quint32 accountIndex, quint32 addressIndex, const QString &label)
 {
     m_walletImpl->setSubaddressLabel(accountIndex, addressIndex, label.toStdString());
+    scheduleStore();
     emit currentSubaddressAccountChanged();
 }
 void Wallet::deviceShowAddressAsync(quint32 accountIndex, quint32 addressIndex, const QString &paymentId)
 {
-    m_scheduler.run([this, accountIndex, addressIndex, paymentId] {
+    runDeviceOperation("Wallet::deviceShowAddressAsync", FutureScheduler::BlockingIO, [this, accountIndex, addressIndex, paymentId] {
         m_walletImpl->deviceShowAddress(accountIndex, addressIndex, paymentId.toStdString());
         emit deviceShowAddressShowed();
     });
@@ -441,30 +899,9 @@ void Wallet::deviceShowAddressAsync(quint32 accountIndex, quint32 addressIndex,
 void Wallet::refreshHeightAsync()
 {
     m_scheduler.run([this] {
-        quint64 daemonHeight;
-        QPair<bool, QFuture<void>> daemonHeightFuture = m_scheduler.run([this, &daemonHeight] {
-            daemonHeight = daemonBlockChainHeight();
-        });
-        if (!daemonHeightFuture.first)
-        {
-            return;
-        }
-
-        quint64 targetHeight;
-        QPair<bool, QFuture<void>> targetHeightFuture = m_scheduler.run([this, &targetHeight] {
-            targetHeight = daemonBlockChainTargetHeight();
-        });
-        if (!targetHeightFuture.first)
-        {
-            return;
-        }
-
-        quint64 walletHeight = blockChainHeight();
-        daemonHeightFuture.second.waitForFinished();
-        targetHeightFuture.second.waitForFinished();
-
-        emit heightRefreshed(walletHeight, daemonHeight, targetHeight);
-    });
+        const DaemonStatus status = daemonStatus();
+        emit heightRefreshed(blockChainHeight(), status.height, status.targetHeight);
+    }, FutureScheduler::Interactive, "Wallet::refreshHeightAsync");
 }
 
 quint64 Wallet::blockChainHeight() const
@@ -474,31 +911,210 @@ quint64 Wallet::blockChainHeight() const
 
 quint64 Wallet::daemonBlockChainHeight() const
 {
-    // cache daemon blockchain height for some time (60 seconds by default)
-
-    if (m_daemonBlockChainHeight == 0
-            || m_daemonBlockChainHeightTime.elapsed() / 1000 > m_daemonBlockChainHeightTtl) {
-        m_daemonBlockChainHeight = m_walletImpl->daemonBlockChainHeight();
-        m_daemonBlockChainHeightTime.restart();
-    }
-    return m_daemonBlockChainHeight;
+    return daemonStatus().height;
 }
 
 quint64 Wallet::daemonBlockChainTargetHeight() const
 {
-    if (m_daemonBlockChainTargetHeight <= 1
-            || m_daemonBlockChainTargetHeightTime.elapsed() / 1000 > m_daemonBlockChainTargetHeightTtl) {
-        m_daemonBlockChainTargetHeight = m_walletImpl->daemonBlockChainTargetHeight();
+    return daemonStatus().targetHeight;
+}
+
+Wallet::DaemonStatus Wallet::daemonStatus(bool forceCheck /* = false */) const
+{
+    QMutexLocker locker(&m_daemonStatusMutex);
+
+    if (m_daemonStatusInFlight)
+    {
+        // somebody else is already asking the daemon, share their answer
+        while (m_daemonStatusInFlight)
+        {
+            m_daemonStatusCondition.wait(&m_daemonStatusMutex);
+        }
+        return m_daemonStatus;
+    }
+
+    if (!forceCheck && m_daemonStatusValid && m_daemonStatusTime.elapsed() / 1000 <= m_daemonStatusTtl)
+    {
+        return m_daemonStatus;
+    }
+
+    m_daemonStatusInFlight = true;
+    DaemonStatus status = m_daemonStatus;
+    const bool refreshTarget = !m_daemonStatusValid
+        || status.targetHeight <= 1
+        || m_daemonBlockChainTargetHeightTime.elapsed() / 1000 > m_daemonBlockChainTargetHeightTtl;
+    locker.unlock();
+
+    if (m_hedgeDaemonRequests && m_daemonPool.enabled())
+    {
+        status = hedgedDaemonStatus(status, refreshTarget);
+    }
+    else
+    {
+        QElapsedTimer timer;
+        timer.start();
+        status = queryDaemonStatus(m_walletImpl, status, refreshTarget);
+        recordDaemonHealth(status, std::chrono::milliseconds(timer.elapsed()));
+    }
+
+    locker.relock();
+    m_daemonStatus = status;
+    m_daemonStatusValid = true;
+    m_daemonStatusTime.restart();
+    if (refreshTarget && status.connection != ConnectionStatus_Disconnected)
+    {
+        m_daemonBlockChainTargetHeightTime.restart();
+    }
+    m_daemonStatusInFlight = false;
+    m_daemonStatusCondition.wakeAll();
+    locker.unlock();
 
+    if (m_daemonPool.shouldFailover())
+    {
+        Wallet *w = const_cast<Wallet*>(this);
+        QMetaObject::invokeMethod(w, [w] {
+            w->failoverDaemon();
+        }, Qt::QueuedConnection);
+    }
+
+    return status;
+}
+
+Wallet::DaemonStatus Wallet::queryDaemonStatus(Monero::Wallet *walletImpl, DaemonStatus status, bool refreshTarget)
+{
+    // libwallet has no batched status call, but none of the height queries
+    // are worth a round-trip when the daemon is unreachable
+    status.connection = static_cast<ConnectionStatus>(walletImpl->connected());
+    if (status.connection != ConnectionStatus_Disconnected)
+    {
+        status.height = walletImpl->daemonBlockChainHeight();
+        if (refreshTarget)
+        {
+            status.targetHeight = walletImpl->daemonBlockChainTargetHeight();
+        }
         // Target height is set to 0 if daemon is synced.
         // Use current height from daemon when target height < current height
-        if (m_daemonBlockChainTargetHeight < m_daemonBlockChainHeight){
-            m_daemonBlockChainTargetHeight = m_daemonBlockChainHeight;
+        if (status.targetHeight < status.height)
+        {
+            status.targetHeight = status.height;
         }
-        m_daemonBlockChainTargetHeightTime.restart();
     }
+    return status;
+}
+
+Wallet::DaemonStatus Wallet::hedgedDaemonStatus(DaemonStatus status, bool refreshTarget) const
+{
+    // the libwallet query is claimed by whoever gets to it first, the
+    // scheduler or this thread once the hedge came back empty handed
+    enum { Queued, Running, Done, Claimed };
+    struct Race
+    {
+        std::atomic<int> state{Queued};
+        QMutex mutex;
+        QWaitCondition finished;
+        DaemonStatus result;
+    };
+    const auto race = std::make_shared<Race>();
+
+    const auto hedge = [this, &status, refreshTarget] {
+        const std::optional<DaemonPool::Height> hedged = m_daemonPool.hedgeHeight(DAEMON_HEDGE_TIMEOUT);
+        if (hedged)
+        {
+            status.height = hedged->height;
+            if (refreshTarget)
+            {
+                status.targetHeight = hedged->targetHeight;
+            }
+            if (status.targetHeight < status.height)
+            {
+                status.targetHeight = status.height;
+            }
+        }
+        return hedged.has_value();
+    };
+
+    // Queries the hedge answered for keep their thread until the stalled node
+    // gives up. Until then only the other node is asked, another query would
+    // pile up on the lane behind it.
+    if (m_daemonQueryOutstanding)
+    {
+        hedge();
+        return status;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    Monero::Wallet *walletImpl = m_walletImpl;
+    Wallet *w = const_cast<Wallet*>(this);
+    m_daemonQueryOutstanding = true;
+    const auto scheduled = w->m_scheduler.run([w, race, walletImpl, status, refreshTarget] {
+        const auto outstanding = sg::make_scope_guard([w]() noexcept {
+            w->m_daemonQueryOutstanding = false;
+        });
+        int queued = Queued;
+        if (!race->state.compare_exchange_strong(queued, Running))
+        {
+            return;
+        }
+        const DaemonStatus result = queryDaemonStatus(walletImpl, status, refreshTarget);
+        QMutexLocker locker(&race->mutex);
+        race->result = result;
+        race->state = Done;
+        race->finished.wakeAll();
+    }, FutureScheduler::BlockingIO, "Wallet::hedgedDaemonStatus");
+    if (!scheduled.first)
+    {
+        m_daemonQueryOutstanding = false;
+    }
+
+    const auto waitFinished = [&race](QDeadlineTimer deadline) {
+        QMutexLocker locker(&race->mutex);
+        while (race->state != Done && !deadline.hasExpired())
+        {
+            race->finished.wait(&race->mutex, deadline);
+        }
+        return race->state == Done;
+    };
+
+    if (!waitFinished(QDeadlineTimer(DAEMON_LATENCY_BUDGET)))
+    {
+        const DaemonStatus previous = status;
+        if (hedge() && race->state != Done)
+        {
+            qDebug() << "Daemon missed its latency budget, using the hedged height";
+            m_daemonPool.recordSlow();
+            int queued = Queued;
+            race->state.compare_exchange_strong(queued, Claimed);
+            return status;
+        }
+        status = previous;
 
-    return m_daemonBlockChainTargetHeight;
+        int queued = Queued;
+        if (race->state.compare_exchange_strong(queued, Claimed))
+        {
+            // the scheduler never got to it
+            status = queryDaemonStatus(m_walletImpl, status, refreshTarget);
+            recordDaemonHealth(status, std::chrono::milliseconds(timer.elapsed()));
+            return status;
+        }
+        waitFinished(QDeadlineTimer(QDeadlineTimer::Forever));
+    }
+
+    QMutexLocker locker(&race->mutex);
+    recordDaemonHealth(race->result, std::chrono::milliseconds(timer.elapsed()));
+    return race->result;
+}
+
+void Wallet::recordDaemonHealth(const DaemonStatus &status, std::chrono::milliseconds latency) const
+{
+    if (status.connection == ConnectionStatus_Disconnected)
+    {
+        m_daemonPool.recordFailure();
+    }
+    else
+    {
+        m_daemonPool.recordSuccess(latency, DAEMON_LATENCY_BUDGET);
+    }
 }
 
 bool Wallet::exportKeyImages(const QString& path, bool all)
@@ -508,7 +1124,9 @@ bool Wallet::exportKeyImages(const QString& path, bool all)
 
 bool Wallet::importKeyImages(const QString& path)
 {
-    return m_walletImpl->importKeyImages(path.toStdString());
+    const bool result = m_walletImpl->importKeyImages(path.toStdString());
+    publishBalanceSnapshot();
+    return result;
 }
 
 bool Wallet::exportOutputs(const QString& path, bool all) {
@@ -516,7 +1134,65 @@ bool Wallet::exportOutputs(const QString& path, bool all) {
 }
 
 bool Wallet::importOutputs(const QString& path) {
-    return m_walletImpl->importOutputs(path.toStdString());
+    const bool result = m_walletImpl->importOutputs(path.toStdString());
+    publishBalanceSnapshot();
+    return result;
+}
+
+void Wallet::runColdSyncTask(std::function<bool()> task, const QJSValue &callback, const char *tag)
+{
+    const auto future = m_scheduler.run([this, task] {
+        emit coldSyncBusyChanged(true);
+        bool result;
+        QString error;
+        {
+            // the refresh thread works on the same transfers
+            QMutexLocker locker(&m_asyncMutex);
+
+            result = task();
+            if (!result)
+            {
+                error = QString::fromStdString(m_walletImpl->errorString());
+            }
+        }
+        publishBalanceSnapshot();
+        emit coldSyncBusyChanged(false);
+        return QJSValueList({result, error});
+    }, callback, FutureScheduler::BlockingIO, tag);
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({false, QString("")}));
+    }
+}
+
+void Wallet::exportKeyImagesAsync(const QString &path, bool all, const QJSValue &callback)
+{
+    runColdSyncTask([this, path, all] {
+        return m_walletImpl->exportKeyImages(path.toStdString(), all);
+    }, callback, "Wallet::exportKeyImagesAsync");
+}
+
+void Wallet::importKeyImagesAsync(const QString &path, const QJSValue &callback)
+{
+    runColdSyncTask([this, path] {
+        m_transfersChanged = true;
+        return m_walletImpl->importKeyImages(path.toStdString());
+    }, callback, "Wallet::importKeyImagesAsync");
+}
+
+void Wallet::exportOutputsAsync(const QString &path, bool all, const QJSValue &callback)
+{
+    runColdSyncTask([this, path, all] {
+        return m_walletImpl->exportOutputs(path.toStdString(), all);
+    }, callback, "Wallet::exportOutputsAsync");
+}
+
+void Wallet::importOutputsAsync(const QString &path, const QJSValue &callback)
+{
+    runColdSyncTask([this, path] {
+        m_transfersChanged = true;
+        return m_walletImpl->importOutputs(path.toStdString());
+    }, callback, "Wallet::importOutputsAsync");
 }
 
 bool Wallet::scanTransactions(const QVector<QString> &txids)
@@ -526,7 +1202,61 @@ bool Wallet::scanTransactions(const QVector<QString> &txids)
     {
         c.push_back(v.toStdString());
     }
-    return m_walletImpl->scanTransactions(c);
+    const bool result = m_walletImpl->scanTransactions(c);
+    publishBalanceSnapshot();
+    return result;
+}
+
+void Wallet::scanTransactionsAsync(const QVector<QString> &txids, const QJSValue &callback)
+{
+    // a restricted node returns at most this many per request
+    constexpr int restrictedBatchSize = 100;
+
+    m_scanTransactionsCancelled = false;
+    const auto future = m_scheduler.run([this, txids] {
+        const int total = txids.size();
+        // libwallet orders the transactions of one call by height, batches
+        // depend on the caller's order and are only used where one call
+        // would be refused anyway
+        const int batchSize = total <= restrictedBatchSize || m_walletImpl->trustedDaemon()
+            ? std::max(total, 1)
+            : restrictedBatchSize;
+        bool result = true;
+        QString error;
+        for (int first = 0; first < total && !m_scanTransactionsCancelled; first += batchSize)
+        {
+            std::vector<std::string> batch;
+            const int last = std::min(total, first + batchSize);
+            batch.reserve(last - first);
+            for (int index = first; index < last; ++index)
+            {
+                batch.push_back(txids[index].toStdString());
+            }
+
+            {
+                QMutexLocker locker(&m_asyncMutex);
+
+                if (!m_walletImpl->scanTransactions(batch))
+                {
+                    result = false;
+                    error = QString::fromStdString(m_walletImpl->errorString());
+                }
+            }
+            m_transfersChanged = true;
+            publishBalanceSnapshot();
+            emit scanTransactionsProgress(last, total);
+        }
+        return QJSValueList({result && !m_scanTransactionsCancelled, error});
+    }, callback, FutureScheduler::BlockingIO, "Wallet::scanTransactionsAsync");
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({false, QString("")}));
+    }
+}
+
+void Wallet::cancelScanTransactions()
+{
+    m_scanTransactionsCancelled = true;
 }
 
 void Wallet::setupBackgroundSync(const Wallet::BackgroundSyncType background_sync_type, const QString &wallet_password)
@@ -544,7 +1274,7 @@ void Wallet::setupBackgroundSync(const Wallet::BackgroundSyncType background_syn
         if (refreshEnabled)
             startRefresh();
         emit backgroundSyncSetup();
-    });
+    }, FutureScheduler::Background, "Wallet::setupBackgroundSync");
 }
 
 Wallet::BackgroundSyncType Wallet::getBackgroundSyncType() const
@@ -574,7 +1304,7 @@ void Wallet::startBackgroundSync()
         if (refreshEnabled)
             startRefresh();
         emit backgroundSyncStarted();
-    });
+    }, FutureScheduler::Background, "Wallet::startBackgroundSync");
 }
 
 void Wallet::stopBackgroundSync(const QString &password)
@@ -589,84 +1319,419 @@ void Wallet::stopBackgroundSync(const QString &password)
         if (refreshEnabled)
             startRefresh();
         emit backgroundSyncStopped();
-    });
+    }, FutureScheduler::Background, "Wallet::stopBackgroundSync");
 }
 
 bool Wallet::refresh(bool historyAndSubaddresses /* = true */)
 {
+    const TraceScope trace("wallet", "Wallet::refresh");
     refreshingSet(true);
     const auto cleanup = sg::make_scope_guard([this]() noexcept {
         refreshingSet(false);
     });
 
     {
-        QMutexLocker locker(&m_asyncMutex);
+        QMutexLocker locker(&m_asyncMutex);
+
+        bool result = m_walletImpl->refresh();
+        const bool balancesChanged = publishBalanceSnapshot();
+
+        // an idle tick changes nothing but confirmations, which only move with the height
+        // and are derived from it without rereading libwallet's history. Every pass moves
+        // it, the refresh loop skips the history itself.
+        const quint64 height = m_walletImpl->blockChainHeight();
+        const bool heightChanged = height != m_lastRefreshHeight;
+        m_lastRefreshHeight = height;
+        EventTrace::instance()->counter("wallet", "height", static_cast<qint64>(height));
+        if (heightChanged)
+        {
+            m_syncProfile.count(SyncProfile::HistoryHeightUpdates);
+            m_history->setBlockchainHeight(height);
+        }
+
+        if (historyAndSubaddresses)
+        {
+            const bool transfersChanged = m_transfersChanged.exchange(false);
+            if (transfersChanged)
+            {
+                m_syncProfile.count(SyncProfile::HistoryRefreshes);
+                m_history->refresh(currentSubaddressAccount());
+                updateSubaddressLookahead();
+            }
+            Subaddress *subaddress = m_subaddress.loadAcquire();
+            if (subaddress && transfersChanged)
+            {
+                m_syncProfile.count(SyncProfile::SubaddressRefreshes);
+                subaddress->refresh(currentSubaddressAccount());
+            }
+            SubaddressAccount *subaddressAccount = m_subaddressAccount.loadAcquire();
+            if (subaddressAccount && (transfersChanged || balancesChanged))
+                subaddressAccount->getAll();
+        }
+        if (m_syncProfile.running() && m_walletImpl->synchronized())
+            m_syncProfile.finish(m_walletImpl->blockChainHeight());
+        if (result)
+            emit updated();
+        return result;
+    }
+}
+
+void Wallet::startRefresh()
+{
+    qDebug() << "Starting refresh";
+    {
+        QMutexLocker locker(&m_refreshMutex);
+        m_refreshEnabled = true;
+        m_refreshNow = true;
+    }
+    m_refreshCondition.wakeAll();
+}
+
+void Wallet::pauseRefresh()
+{
+    qDebug() << "Pausing refresh";
+    QMutexLocker locker(&m_refreshMutex);
+    m_refreshEnabled = false;
+}
+
+PendingTransaction *Wallet::createTransaction(
+    const QVector<QString> &destinationAddresses,
+    const QString &payment_id,
+    const QVector<QString> &destinationAmounts,
+    quint32 mixin_count,
+    PendingTransaction::Priority priority)
+{
+    std::vector<std::string> destinations;
+    for (const auto &address : destinationAddresses) {
+        destinations.push_back(address.toStdString());
+    }
+    std::vector<uint64_t> amounts;
+    for (const auto &amount : destinationAmounts) {
+        amounts.push_back(Monero::Wallet::amountFromString(amount.toStdString()));
+    }
+    std::set<uint32_t> subaddr_indices;
+    Monero::PendingTransaction *ptImpl = m_walletImpl->createTransactionMultDest(
+        destinations,
+        payment_id.toStdString(),
+        amounts,
+        mixin_count,
+        static_cast<Monero::PendingTransaction::Priority>(priority),
+        currentSubaddressAccount(),
+        subaddr_indices);
+    PendingTransaction *result = new PendingTransaction(ptImpl, 0);
+    return result;
+}
+
+void Wallet::createTransactionAsync(
+    const QVector<QString> &destinationAddresses,
+    const QString &payment_id,
+    const QVector<QString> &destinationAmounts,
+    quint32 mixin_count,
+    PendingTransaction::Priority priority)
+{
+    const QString key = preparedTransactionKey(destinationAddresses, payment_id, destinationAmounts, mixin_count, priority);
+    if (!m_preparedKey.isEmpty() && key == m_preparedKey)
+    {
+        if (m_preparedTransaction)
+        {
+            PendingTransaction *tx = m_preparedTransaction;
+            m_preparedTransaction = nullptr;
+            m_preparedKey.clear();
+            QMetaObject::invokeMethod(this, [this, tx, destinationAddresses, payment_id, mixin_count] {
+                emit transactionCreated(tx, destinationAddresses, payment_id, mixin_count);
+            }, Qt::QueuedConnection);
+            return;
+        }
+        if (m_preparedBuilding)
+        {
+            m_preparedClaimed = true;
+            return;
+        }
+    }
+    discardPreparedTransaction();
+
+    runDeviceOperation("Wallet::createTransactionAsync", FutureScheduler::Background, [this, destinationAddresses, payment_id, destinationAmounts, mixin_count, priority] {
+        PendingTransaction *tx = createTransaction(destinationAddresses, payment_id, destinationAmounts, mixin_count, priority);
+        emit transactionCreated(tx, destinationAddresses, payment_id, mixin_count);
+    });
+}
+
+QString Wallet::preparedTransactionKey(
+    const QVector<QString> &destinationAddresses,
+    const QString &payment_id,
+    const QVector<QString> &destinationAmounts,
+    quint32 mixin_count,
+    PendingTransaction::Priority priority) const
+{
+    const quint32 account = currentSubaddressAccount();
+    return QStringList({
+        QStringList(destinationAddresses.begin(), destinationAddresses.end()).join(','),
+        QStringList(destinationAmounts.begin(), destinationAmounts.end()).join(','),
+        payment_id.trimmed(),
+        QString::number(mixin_count),
+        QString::number(static_cast<int>(priority)),
+        QString::number(account),
+        QString::number(m_walletImpl->blockChainHeight()),
+        QString::number(unlockedBalance(account)),
+    }).join('|');
+}
+
+void Wallet::prepareTransactionAsync(
+    const QVector<QString> &destinationAddresses,
+    const QString &payment_id,
+    const QVector<QString> &destinationAmounts,
+    quint32 mixin_count,
+    PendingTransaction::Priority priority)
+{
+    // every build asks the daemon for fresh decoys around the same real inputs,
+    // an untrusted node could intersect the rings of the discarded ones
+    if (!m_walletImpl->trustedDaemon())
+    {
+        discardPreparedTransaction();
+        return;
+    }
+
+    const QString key = preparedTransactionKey(destinationAddresses, payment_id, destinationAmounts, mixin_count, priority);
+    if (key == m_preparedKey || m_preparedClaimed)
+    {
+        return;
+    }
+    discardPreparedTransaction();
+
+    m_preparedKey = key;
+    m_preparedBuilding = true;
+    const auto future = m_scheduler.run([this, key, destinationAddresses, payment_id, destinationAmounts, mixin_count, priority] {
+        PendingTransaction *tx = createTransaction(destinationAddresses, payment_id, destinationAmounts, mixin_count, priority);
+        if (m_scheduler.stopping())
+        {
+            disposeTransaction(tx);
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, key, tx, destinationAddresses, payment_id, mixin_count] {
+            // inputs changed while building
+            if (key != m_preparedKey)
+            {
+                disposeTransaction(tx);
+                return;
+            }
+
+            m_preparedBuilding = false;
+            if (m_preparedClaimed)
+            {
+                m_preparedClaimed = false;
+                m_preparedKey.clear();
+                emit transactionCreated(tx, destinationAddresses, payment_id, mixin_count);
+                return;
+            }
+            // errors are reported when the user actually sends
+            if (tx->status() != PendingTransaction::Status_Ok)
+            {
+                disposeTransaction(tx);
+                m_preparedKey.clear();
+                return;
+            }
+            m_preparedTransaction = tx;
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::Background, "Wallet::prepareTransactionAsync");
+    if (!future.first)
+    {
+        m_preparedKey.clear();
+        m_preparedBuilding = false;
+    }
+}
+
+void Wallet::discardPreparedTransaction()
+{
+    // the user already sent it
+    if (m_preparedClaimed)
+    {
+        return;
+    }
+    if (m_preparedTransaction)
+    {
+        disposeTransaction(m_preparedTransaction);
+        m_preparedTransaction = nullptr;
+    }
+    m_preparedKey.clear();
+    m_preparedBuilding = false;
+    m_preparedClaimed = false;
+}
+
+void Wallet::payoutAsync(const QStringList &addresses, const QStringList &amounts, quint32 mixin_count, PendingTransaction::Priority priority)
+{
+    m_payoutCancelled = false;
+    const bool started = runDeviceOperation("Wallet::payoutAsync", FutureScheduler::BlockingIO, [this, addresses, amounts, mixin_count, priority] {
+        runPayout(addresses, amounts, mixin_count, priority);
+    });
+    if (!started)
+    {
+        emit payoutFinished(0, addresses.size());
+    }
+}
 
-        bool result = m_walletImpl->refresh();
-        if (historyAndSubaddresses)
+void Wallet::payoutCsvAsync(const QString &path, quint32 mixin_count, PendingTransaction::Priority priority)
+{
+    m_payoutCancelled = false;
+    const bool started = runDeviceOperation("Wallet::payoutCsvAsync", FutureScheduler::BlockingIO, [this, path, mixin_count, priority] {
+        constexpr int chunkRows = 1024;
+        QStringList addresses;
+        QStringList amounts;
+        CsvReader reader(path);
+        if (!reader.open())
         {
-            m_history->refresh(currentSubaddressAccount());
-            m_subaddress->refresh(currentSubaddressAccount());
-            m_subaddressAccount->getAll();
+            qWarning() << "Failed to open" << path;
+            emit payoutFinished(0, 0);
+            return;
         }
-        if (result)
-            emit updated();
-        return result;
+        while (!reader.atEnd())
+        {
+            for (const QStringList &fields : reader.read(chunkRows))
+            {
+                addresses.append(fields.at(0));
+                amounts.append(fields.value(1));
+            }
+        }
+        runPayout(addresses, amounts, mixin_count, priority);
+    });
+    if (!started)
+    {
+        emit payoutFinished(0, 0);
     }
 }
 
-void Wallet::startRefresh()
+void Wallet::cancelPayout()
 {
-    qDebug() << "Starting refresh";
-    m_refreshEnabled = true;
-    m_refreshNow = true;
+    m_payoutCancelled = true;
 }
 
-void Wallet::pauseRefresh()
+void Wallet::runPayout(const QStringList &addresses, const QStringList &amounts, quint32 mixin_count, PendingTransaction::Priority priority)
 {
-    qDebug() << "Pausing refresh";
-    m_refreshEnabled = false;
-}
+    // a transaction takes up to 16 outputs, one is left for the change
+    constexpr int maxDestinations = 15;
+    constexpr int commitAttempts = 3;
 
-PendingTransaction *Wallet::createTransaction(
-    const QVector<QString> &destinationAddresses,
-    const QString &payment_id,
-    const QVector<QString> &destinationAmounts,
-    quint32 mixin_count,
-    PendingTransaction::Priority priority)
-{
-    std::vector<std::string> destinations;
-    for (const auto &address : destinationAddresses) {
-        destinations.push_back(address.toStdString());
+    struct Recipient
+    {
+        int index;
+        std::string address;
+        uint64_t amount;
+    };
+
+    const int total = addresses.size();
+    const Monero::NetworkType nettype = m_walletImpl->nettype();
+    std::vector<Recipient> recipients;
+    int done = 0;
+    int paid = 0;
+    int failed = 0;
+    // validating is the slow part of reading a long list, the results are
+    // reported in order afterwards
+    const QVector<uint64_t> validAmounts = mapIndexes<uint64_t>(total, [&addresses, &amounts, nettype](int index) -> uint64_t {
+        const uint64_t amount = Monero::Wallet::amountFromString(amounts.value(index).toStdString());
+        return Monero::Wallet::addressValid(addresses[index].toStdString(), nettype) ? amount : 0;
+    });
+    for (int index = 0; index < total; ++index)
+    {
+        const std::string address = addresses[index].toStdString();
+        const uint64_t amount = validAmounts[index];
+        if (amount == 0)
+        {
+            emit payoutRecipientStatus(index, addresses[index], "invalid", tr("Invalid address or amount"));
+            ++done;
+            ++failed;
+            continue;
+        }
+        recipients.push_back({index, address, amount});
     }
-    std::vector<uint64_t> amounts;
-    for (const auto &amount : destinationAmounts) {
-        amounts.push_back(Monero::Wallet::amountFromString(amount.toStdString()));
+
+    // libwallet picks inputs from the unspent outputs, transactions are built
+    // after the previous one was committed so they never share an input
+    const quint32 account = currentSubaddressAccount();
+    for (size_t first = 0; first < recipients.size(); first += maxDestinations)
+    {
+        const size_t last = std::min(recipients.size(), first + maxDestinations);
+        if (m_payoutCancelled)
+        {
+            for (size_t recipient = first; recipient < recipients.size(); ++recipient)
+            {
+                emit payoutRecipientStatus(recipients[recipient].index, addresses[recipients[recipient].index], "cancelled", QString());
+            }
+            failed += static_cast<int>(recipients.size() - first);
+            break;
+        }
+
+        std::vector<std::string> destinations;
+        std::vector<uint64_t> destinationAmounts;
+        for (size_t recipient = first; recipient < last; ++recipient)
+        {
+            destinations.push_back(recipients[recipient].address);
+            destinationAmounts.push_back(recipients[recipient].amount);
+        }
+
+        Monero::PendingTransaction *tx = m_walletImpl->createTransactionMultDest(
+            destinations,
+            "",
+            destinationAmounts,
+            mixin_count,
+            static_cast<Monero::PendingTransaction::Priority>(priority),
+            account,
+            {});
+        bool committed = false;
+        QString status = "failed";
+        QString detail;
+        if (tx->status() == Monero::PendingTransaction::Status_Ok)
+        {
+            QStringList ids;
+            for (const auto &txid : tx->txid())
+            {
+                ids.append(QString::fromStdString(txid));
+            }
+
+            // The daemon may have relayed a transaction whose commit reported
+            // an error, only the same signed transaction is sent again. A new
+            // one would spend other inputs and pay the recipients twice.
+            for (int attempt = 0; attempt < commitAttempts && !committed; ++attempt)
+            {
+                if (attempt > 0 && !m_scheduler.token().sleepFor(std::chrono::seconds(5)))
+                {
+                    break;
+                }
+                committed = tx->commit();
+            }
+
+            if (committed)
+            {
+                status = "sent";
+                detail = ids.join(',');
+            }
+            else
+            {
+                status = "unknown";
+                detail = tr("Commit failed, check txid %1 before paying again: %2")
+                    .arg(ids.join(','), QString::fromStdString(tx->errorString()));
+            }
+        }
+        else
+        {
+            detail = QString::fromStdString(tx->errorString());
+        }
+        m_walletImpl->disposeTransaction(tx);
+
+        if (committed)
+        {
+            m_transfersChanged = true;
+            publishBalanceSnapshot();
+        }
+        for (size_t recipient = first; recipient < last; ++recipient)
+        {
+            emit payoutRecipientStatus(recipients[recipient].index, addresses[recipients[recipient].index], status, detail);
+        }
+        const int count = static_cast<int>(last - first);
+        done += count;
+        (committed ? paid : failed) += count;
+        emit payoutProgress(done, total);
     }
-    std::set<uint32_t> subaddr_indices;
-    Monero::PendingTransaction *ptImpl = m_walletImpl->createTransactionMultDest(
-        destinations,
-        payment_id.toStdString(),
-        amounts,
-        mixin_count,
-        static_cast<Monero::PendingTransaction::Priority>(priority),
-        currentSubaddressAccount(),
-        subaddr_indices);
-    PendingTransaction *result = new PendingTransaction(ptImpl, 0);
-    return result;
-}
 
-void Wallet::createTransactionAsync(
-    const QVector<QString> &destinationAddresses,
-    const QString &payment_id,
-    const QVector<QString> &destinationAmounts,
-    quint32 mixin_count,
-    PendingTransaction::Priority priority)
-{
-    m_scheduler.run([this, destinationAddresses, payment_id, destinationAmounts, mixin_count, priority] {
-        PendingTransaction *tx = createTransaction(destinationAddresses, payment_id, destinationAmounts, mixin_count, priority);
-        emit transactionCreated(tx, destinationAddresses, payment_id, mixin_count);
-    });
+    emit payoutFinished(paid, failed);
 }
 
 PendingTransaction *Wallet::createTransactionAll(const QString &dst_addr, const QString &payment_id,
@@ -684,7 +1749,7 @@ void Wallet::createTransactionAllAsync(const QString &dst_addr, const QString &p
                                quint32 mixin_count,
                                PendingTransaction::Priority priority)
 {
-    m_scheduler.run([this, dst_addr, payment_id, mixin_count, priority] {
+    runDeviceOperation("Wallet::createTransactionAllAsync", FutureScheduler::Background, [this, dst_addr, payment_id, mixin_count, priority] {
         PendingTransaction *tx = createTransactionAll(dst_addr, payment_id, mixin_count, priority);
         emit transactionCreated(tx, {dst_addr}, payment_id, mixin_count);
     });
@@ -699,7 +1764,7 @@ PendingTransaction *Wallet::createSweepUnmixableTransaction()
 
 void Wallet::createSweepUnmixableTransactionAsync()
 {
-    m_scheduler.run([this] {
+    runDeviceOperation("Wallet::createSweepUnmixableTransactionAsync", FutureScheduler::Background, [this] {
         PendingTransaction *tx = createSweepUnmixableTransaction();
         emit transactionCreated(tx, {""}, "", 0);
     });
@@ -726,8 +1791,11 @@ void Wallet::commitTransactionAsync(PendingTransaction *t)
 {
     m_scheduler.run([this, t] {
         auto txIdList = t->txid();  // retrieve before commit
-        emit transactionCommitted(t->commit(), t, txIdList);
-    });
+        const bool result = t->commit();
+        m_transfersChanged = true;
+        publishBalanceSnapshot();
+        emit transactionCommitted(result, t, txIdList);
+    }, FutureScheduler::BlockingIO, "Wallet::commitTransactionAsync");
 }
 
 void Wallet::disposeTransaction(PendingTransaction *t)
@@ -747,26 +1815,66 @@ void Wallet::estimateTransactionFeeAsync(
     PendingTransaction::Priority priority,
     const QJSValue &callback)
 {
-    m_scheduler.run(
-        [this, destinationAddresses, amounts, priority] {
-            if (destinationAddresses.size() != amounts.size())
-            {
-                return QJSValueList({""});
-            }
+    if (destinationAddresses.size() != amounts.size())
+    {
+        QMetaObject::invokeMethod(this, [callback] {
+            QJSValue(callback).call(QJSValueList({""}));
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    const FeeEstimateRequest request{static_cast<int>(destinationAddresses.size()), priority, callback};
+    // coalesce while typing, the running estimate picks up the latest request
+    if (m_feeEstimateRunning)
+    {
+        m_pendingFeeEstimate = request;
+        return;
+    }
+    startFeeEstimate(request);
+}
+
+void Wallet::startFeeEstimate(const FeeEstimateRequest &request)
+{
+    const QString key = QString("%1|%2").arg(request.destinations).arg(static_cast<int>(request.priority));
+    const quint64 height = m_walletImpl->blockChainHeight();
+    const auto cached = m_feeEstimates.constFind(key);
+    if (cached != m_feeEstimates.constEnd() && cached->height == height && !cached->expiry.hasExpired())
+    {
+        const QString fee = cached->fee;
+        const QJSValue callback = request.callback;
+        QMetaObject::invokeMethod(this, [callback, fee] {
+            QJSValue(callback).call(QJSValueList({fee}));
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    m_feeEstimateRunning = true;
+    const auto future = m_scheduler.run([this, request, key, height] {
+        // amounts and addresses don't change the estimate, only their count
+        const std::vector<std::pair<std::string, uint64_t>> destinations(request.destinations);
+        const uint64_t fee = m_walletImpl->estimateTransactionFee(
+            destinations,
+            static_cast<Monero::PendingTransaction::Priority>(request.priority));
+        const QString amount = QString::fromStdString(Monero::Wallet::displayAmount(fee));
+
+        QMetaObject::invokeMethod(this, [this, request, key, height, amount] {
+            m_feeEstimateRunning = false;
+            m_feeEstimates.insert(key, {amount, height, QDeadlineTimer(std::chrono::seconds(30))});
 
-            std::vector<std::pair<std::string, uint64_t>> destinations;
-            destinations.reserve(destinationAddresses.size());
-            for (size_t index = 0; index < destinationAddresses.size(); ++index)
+            if (m_pendingFeeEstimate)
             {
-                destinations.emplace_back(std::make_pair(destinationAddresses[index].toStdString(), amounts[index]));
+                const FeeEstimateRequest pending = *m_pendingFeeEstimate;
+                m_pendingFeeEstimate.reset();
+                startFeeEstimate(pending);
+                return;
             }
-
-            const uint64_t fee = m_walletImpl->estimateTransactionFee(
-                destinations,
-                static_cast<Monero::PendingTransaction::Priority>(priority));
-            return QJSValueList({QString::fromStdString(Monero::Wallet::displayAmount(fee))});
-        },
-        callback);
+            QJSValue(request.callback).call(QJSValueList({amount}));
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::Interactive, "Wallet::estimateTransactionFeeAsync");
+    if (!future.first)
+    {
+        m_feeEstimateRunning = false;
+    }
 }
 
 TransactionHistory *Wallet::history() const
@@ -791,7 +1899,17 @@ TransactionHistorySortFilterModel *Wallet::historyModel() const
 
 AddressBook *Wallet::addressBook() const
 {
-    return m_addressBook;
+    AddressBook *addressBook = m_addressBook.loadAcquire();
+    if (!addressBook) {
+        Wallet * w = const_cast<Wallet*>(this);
+        addressBook = new AddressBook(m_walletImpl->addressBook(), m_walletImpl->nettype(), w);
+        // label and note edits elsewhere in the wallet
+        connect(addressBook, &AddressBook::rowInsertionFinished, w, &Wallet::scheduleStore);
+        connect(addressBook, &AddressBook::rowRemovalFinished, w, &Wallet::scheduleStore);
+        connect(addressBook, &AddressBook::rowsChanged, w, &Wallet::scheduleStore);
+        m_addressBook.storeRelease(addressBook);
+    }
+    return addressBook;
 }
 
 AddressBookModel *Wallet::addressBookModel() const
@@ -799,7 +1917,7 @@ AddressBookModel *Wallet::addressBookModel() const
 
     if (!m_addressBookModel) {
         Wallet * w = const_cast<Wallet*>(this);
-        m_addressBookModel = new AddressBookModel(w,m_addressBook);
+        m_addressBookModel = new AddressBookModel(w, addressBook());
     }
 
     return m_addressBookModel;
@@ -807,31 +1925,62 @@ AddressBookModel *Wallet::addressBookModel() const
 
 Subaddress *Wallet::subaddress()
 {
-    return m_subaddress;
+    Subaddress *subaddress = m_subaddress.loadAcquire();
+    if (!subaddress) {
+        subaddress = new Subaddress(m_walletImpl->subaddress(), this);
+        m_subaddress.storeRelease(subaddress);
+    }
+    return subaddress;
 }
 
 SubaddressModel *Wallet::subaddressModel()
 {
     if (!m_subaddressModel) {
-        m_subaddressModel = new SubaddressModel(this, m_subaddress);
+        m_subaddressModel = new SubaddressModel(this, subaddress(), history());
     }
     return m_subaddressModel;
 }
 
 SubaddressAccount *Wallet::subaddressAccount() const
 {
-    return m_subaddressAccount;
+    SubaddressAccount *subaddressAccount = m_subaddressAccount.loadAcquire();
+    if (!subaddressAccount) {
+        Wallet * w = const_cast<Wallet*>(this);
+        subaddressAccount = new SubaddressAccount(m_walletImpl->subaddressAccount(), w);
+        m_subaddressAccount.storeRelease(subaddressAccount);
+    }
+    return subaddressAccount;
 }
 
 SubaddressAccountModel *Wallet::subaddressAccountModel() const
 {
     if (!m_subaddressAccountModel) {
         Wallet * w = const_cast<Wallet*>(this);
-        m_subaddressAccountModel = new SubaddressAccountModel(w,m_subaddressAccount);
+        m_subaddressAccountModel = new SubaddressAccountModel(w, subaddressAccount(), m_subaddressLookahead);
     }
     return m_subaddressAccountModel;
 }
 
+DeviceQueue *Wallet::deviceQueue() const
+{
+    return m_deviceQueue;
+}
+
+bool Wallet::runDeviceOperation(const char *name, FutureScheduler::Lane lane, std::function<void()> work)
+{
+    // the device handles one request at a time, concurrent ones would block a lane waiting for it
+    if (isHwBacked())
+    {
+        if (m_scheduler.stopping())
+        {
+            return false;
+        }
+        m_deviceQueue->enqueue(name, std::move(work));
+        return true;
+    }
+    return m_scheduler.run(std::move(work), lane, name).first;
+}
+
 QString Wallet::generatePaymentId() const
 {
     return QString::fromStdString(Monero::Wallet::genPaymentId());
@@ -853,7 +2002,13 @@ bool Wallet::setCacheAttribute(const QString &key, const QString &val)
 
 bool Wallet::setUserNote(const QString &txid, const QString &note)
 {
-  return m_walletImpl->setUserNote(txid.toStdString(), note.toStdString());
+  const bool result = m_walletImpl->setUserNote(txid.toStdString(), note.toStdString());
+  if (result)
+  {
+    m_history->setUserNote(txid, note);
+    scheduleStore();
+  }
+  return result;
 }
 
 QString Wallet::getUserNote(const QString &txid) const
@@ -870,7 +2025,7 @@ void Wallet::getTxKeyAsync(const QString &txid, const QJSValue &callback)
 {
     m_scheduler.run([this, txid] {
         return QJSValueList({txid, getTxKey(txid)});
-    }, callback);
+    }, callback, FutureScheduler::Interactive, "Wallet::getTxKeyAsync");
 }
 
 QString Wallet::checkTxKey(const QString &txid, const QString &tx_key, const QString &address)
@@ -895,7 +2050,7 @@ void Wallet::getTxProofAsync(const QString &txid, const QString &address, const
 {
     m_scheduler.run([this, txid, address, message] {
         return QJSValueList({txid, getTxProof(txid, address, message)});
-    }, callback);
+    }, callback, FutureScheduler::Background, "Wallet::getTxProofAsync");
 }
 
 QString Wallet::checkTxProof(const QString &txid, const QString &address, const QString &message, const QString &signature)
@@ -921,7 +2076,7 @@ void Wallet::getSpendProofAsync(const QString &txid, const QString &message, con
 {
     m_scheduler.run([this, txid, message] {
         return QJSValueList({txid, getSpendProof(txid, message)});
-    }, callback);
+    }, callback, FutureScheduler::Background, "Wallet::getSpendProofAsync");
 }
 
 Q_INVOKABLE QString Wallet::checkSpendProof(const QString &txid, const QString &message, const QString &signature) const
@@ -932,6 +2087,81 @@ Q_INVOKABLE QString Wallet::checkSpendProof(const QString &txid, const QString &
     return QString::fromStdString(result);
 }
 
+void Wallet::runProofBatch(const QStringList &txids, const QStringList &addresses, const QString &out, const QJSValue &callback,
+                           std::function<QString(int)> prove, const char *tag)
+{
+    m_proofBatchCancelled = false;
+    const auto future = m_scheduler.run([this, txids, addresses, out, prove] {
+        const int total = txids.size();
+        QVector<QString> results(total);
+
+        // one at a time, libwallet keeps a single error status per wallet and
+        // sends the daemon requests through one client anyway
+        for (int index = 0; index < total && !m_proofBatchCancelled; ++index)
+        {
+            results[index] = prove(index);
+            emit proofBatchProgress(index + 1, total, index, txids[index], results[index]);
+        }
+
+        if (m_proofBatchCancelled || out.isEmpty())
+        {
+            return QJSValueList({QString("")});
+        }
+
+        QFile file(out);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            qWarning() << "Failed to open" << out;
+            return QJSValueList({QString("")});
+        }
+        QTextStream stream(&file);
+        stream << "txid,address,result\n";
+        for (int index = 0; index < total; ++index)
+        {
+            stream << txids[index] << ',' << addresses.value(index) << ',' << results[index] << '\n';
+        }
+        stream.flush();
+        return QJSValueList({file.error() == QFileDevice::NoError ? out : QString("")});
+    }, callback, FutureScheduler::Background, tag);
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({QString("")}));
+    }
+}
+
+void Wallet::getTxProofsAsync(const QStringList &txids, const QStringList &addresses, const QString &message, const QString &out, const QJSValue &callback)
+{
+    runProofBatch(txids, addresses, out, callback, [this, txids, addresses, message](int index) {
+        return getTxProof(txids[index], addresses.value(index), message);
+    }, "Wallet::getTxProofsAsync");
+}
+
+void Wallet::checkTxProofsAsync(const QStringList &txids, const QStringList &addresses, const QString &message, const QStringList &signatures, const QString &out, const QJSValue &callback)
+{
+    runProofBatch(txids, addresses, out, callback, [this, txids, addresses, message, signatures](int index) {
+        return checkTxProof(txids[index], addresses.value(index), message, signatures.value(index));
+    }, "Wallet::checkTxProofsAsync");
+}
+
+void Wallet::getSpendProofsAsync(const QStringList &txids, const QString &message, const QString &out, const QJSValue &callback)
+{
+    runProofBatch(txids, {}, out, callback, [this, txids, message](int index) {
+        return getSpendProof(txids[index], message);
+    }, "Wallet::getSpendProofsAsync");
+}
+
+void Wallet::checkSpendProofsAsync(const QStringList &txids, const QString &message, const QStringList &signatures, const QString &out, const QJSValue &callback)
+{
+    runProofBatch(txids, {}, out, callback, [this, txids, message, signatures](int index) {
+        return checkSpendProof(txids[index], message, signatures.value(index));
+    }, "Wallet::checkSpendProofsAsync");
+}
+
+void Wallet::cancelProofBatch()
+{
+    m_proofBatchCancelled = true;
+}
+
 Q_INVOKABLE QString Wallet::getReserveProof(bool all, quint32 account_index, quint64 amount, const QString &message) const
 {
     qDebug("Generating reserve proof");
@@ -951,6 +2181,45 @@ Q_INVOKABLE QString Wallet::checkReserveProof(const QString &address, const QStr
     return QString::fromStdString(result);
 }
 
+void Wallet::getReserveProofAsync(bool all, quint32 account_index, quint64 amount, const QString &message, const QJSValue &callback)
+{
+    const quint64 generation = m_reserveProofGeneration;
+    const auto future = m_scheduler.run([this, all, account_index, amount, message, generation] {
+        if (generation != m_reserveProofGeneration)
+        {
+            return QJSValueList({QString("error|cancelled")});
+        }
+        const QString result = getReserveProof(all, account_index, amount, message);
+        return QJSValueList({generation == m_reserveProofGeneration ? result : QString("error|cancelled")});
+    }, callback, FutureScheduler::Background, "Wallet::getReserveProofAsync");
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({QString("error|cancelled")}));
+    }
+}
+
+void Wallet::checkReserveProofAsync(const QString &address, const QString &message, const QString &signature, const QJSValue &callback)
+{
+    const quint64 generation = m_reserveProofGeneration;
+    const auto future = m_scheduler.run([this, address, message, signature, generation] {
+        if (generation != m_reserveProofGeneration)
+        {
+            return QJSValueList({QString("error|cancelled")});
+        }
+        const QString result = checkReserveProof(address, message, signature);
+        return QJSValueList({generation == m_reserveProofGeneration ? result : QString("error|cancelled")});
+    }, callback, FutureScheduler::Background, "Wallet::checkReserveProofAsync");
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({QString("error|cancelled")}));
+    }
+}
+
+void Wallet::cancelReserveProof()
+{
+    ++m_reserveProofGeneration;
+}
+
 QString Wallet::signMessage(const QString &message, bool filename) const
 {
   if (filename) {
@@ -1050,7 +2319,26 @@ bool Wallet::rescanSpent()
 {
     QMutexLocker locker(&m_asyncMutex);
 
-    return m_walletImpl->rescanSpent();
+    const bool result = m_walletImpl->rescanSpent();
+    publishBalanceSnapshot();
+    return result;
+}
+
+void Wallet::rescanSpentAsync(const QJSValue &callback)
+{
+    const auto future = m_scheduler.run([this] {
+        QString error;
+        const bool result = rescanSpent();
+        if (!result)
+        {
+            error = QString::fromStdString(m_walletImpl->errorString());
+        }
+        return QJSValueList({result, error});
+    }, callback, FutureScheduler::BlockingIO, "Wallet::rescanSpentAsync");
+    if (!future.first)
+    {
+        QJSValue(callback).call(QJSValueList({false, QString("")}));
+    }
 }
 
 bool Wallet::useForkRules(quint8 required_version, quint64 earlyBlocks) const
@@ -1081,53 +2369,135 @@ QString Wallet::getRing(const QString &key_image)
     std::vector<uint64_t> cring;
     if (!m_walletImpl->getRing(key_image.toStdString(), cring))
         return "";
-    QString ring = "";
-    for (uint64_t out: cring)
+    std::string ring;
+    appendRing(ring, cring);
+    return QString::fromLatin1(ring.data(), static_cast<int>(ring.size()));
+}
+
+QString Wallet::getRings(const QString &txid)
+{
+    std::string rings;
+    if (!appendRings(rings, txid))
+        return "";
+    return QString::fromLatin1(rings.data(), static_cast<int>(rings.size()));
+}
+
+QString Wallet::getRingsForTxs(const QStringList &txids)
+{
+    std::string rings;
+    rings.reserve(txids.size() * 1024);
+    for (const QString &txid : txids)
     {
-        if (!ring.isEmpty())
-            ring = ring + " ";
-	QString s;
-	s.setNum(out);
-        ring = ring + s;
+        const size_t line = rings.size();
+        rings.append(txid.toStdString());
+        rings.push_back(' ');
+        const size_t entries = rings.size();
+        if (!appendRings(rings, txid) || rings.size() == entries)
+        {
+            rings.resize(line);
+            continue;
+        }
+        rings.push_back('\n');
     }
-    return ring;
+    return QString::fromLatin1(rings.data(), static_cast<int>(rings.size()));
 }
 
-QString Wallet::getRings(const QString &txid)
+bool Wallet::appendRings(std::string &out, const QString &txid) const
 {
     std::vector<std::pair<std::string, std::vector<uint64_t>>> crings;
     if (!m_walletImpl->getRings(txid.toStdString(), crings))
-        return "";
-    QString ring = "";
+        return false;
+    bool first = true;
     for (const auto &cring: crings)
     {
-        if (!ring.isEmpty())
-            ring = ring + "|";
-        ring = ring + QString::fromStdString(cring.first) + " absolute";
-        for (uint64_t out: cring.second)
+        if (!first)
+            out.push_back('|');
+        first = false;
+        out.append(cring.first);
+        out.append(" absolute");
+        if (!cring.second.empty())
         {
-            ring = ring + " ";
-	    QString s;
-	    s.setNum(out);
-            ring = ring + s;
+            out.push_back(' ');
+            appendRing(out, cring.second);
         }
     }
-    return ring;
+    return true;
 }
 
 bool Wallet::setRing(const QString &key_image, const QString &ring, bool relative)
 {
     std::vector<uint64_t> cring;
-    QStringList strOuts = ring.split(" ");
-    foreach(QString str, strOuts)
+    if (!parseRing(QStringView(ring), cring))
+        return false;
+    return m_walletImpl->setRing(key_image.toStdString(), cring, relative);
+}
+
+QVariantMap Wallet::setRings(const QString &rings)
+{
+    int set = 0;
+    QVariantList malformed;
+    QVariantList failed;
+    std::vector<uint64_t> cring;
+    int lineNumber = 0;
+    for (const QStringView line : QStringView(rings).split(u'\n'))
     {
-        uint64_t out;
-	bool ok;
-	out = str.toULong(&ok);
-	if (ok)
-            cring.push_back(out);
+        ++lineNumber;
+        const QStringView trimmed = line.trimmed();
+        if (trimmed.isEmpty())
+            continue;
+
+        // "txid key_image absolute|relative outs...|key_image ...", as written by getRingsForTxs
+        const qsizetype separator = trimmed.indexOf(u' ');
+        if (separator <= 0 || !isHash(trimmed.left(separator)))
+        {
+            malformed.append(lineNumber);
+            continue;
+        }
+        struct Ring
+        {
+            std::string keyImage;
+            std::vector<uint64_t> ring;
+            bool relative;
+        };
+        std::vector<Ring> parsed;
+        bool valid = true;
+        for (const QStringView entry : trimmed.mid(separator + 1).split(u'|'))
+        {
+            const QStringView fields = entry.trimmed();
+            const qsizetype keyEnd = fields.indexOf(u' ');
+            const QStringView keyImage = keyEnd < 0 ? fields : fields.left(keyEnd);
+            const QStringView rest = keyEnd < 0 ? QStringView() : fields.mid(keyEnd + 1).trimmed();
+            const qsizetype modeEnd = rest.indexOf(u' ');
+            const QStringView mode = modeEnd < 0 ? rest : rest.left(modeEnd);
+            cring.clear();
+            if (!isHash(keyImage) ||
+                (mode != u"absolute" && mode != u"relative") ||
+                !parseRing(modeEnd < 0 ? QStringView() : rest.mid(modeEnd + 1), cring))
+            {
+                valid = false;
+                break;
+            }
+            parsed.push_back({keyImage.toString().toStdString(), cring, mode == u"relative"});
+        }
+        // a malformed line sets none of its rings
+        if (!valid)
+        {
+            malformed.append(lineNumber);
+            continue;
+        }
+        for (const Ring &ring : parsed)
+        {
+            if (m_walletImpl->setRing(ring.keyImage, ring.ring, ring.relative))
+                ++set;
+            else if (failed.isEmpty() || failed.last() != lineNumber)
+                failed.append(lineNumber);
+        }
     }
-    return m_walletImpl->setRing(key_image.toStdString(), cring, relative);
+    return QVariantMap{
+        {"set", set},
+        {"malformedLines", malformed},
+        {"failedLines", failed},
+    };
 }
 
 void Wallet::segregatePreForkOutputs(bool segregate)
@@ -1158,16 +2528,19 @@ void Wallet::onPassphraseEntered(const QString &passphrase, bool enter_on_device
     }
 }
 
-Wallet::Wallet(Monero::Wallet *w, QObject *parent)
+Wallet::Wallet(Monero::Wallet *w, QObject *parent, bool refreshThread)
     : QObject(parent)
     , m_walletImpl(w)
     , m_history(new TransactionHistory(m_walletImpl->history(), this))
     , m_historyModel(nullptr)
-    , m_addressBook(new AddressBook(m_walletImpl->addressBook(), this))
+    , m_addressBook(nullptr)
     , m_addressBookModel(nullptr)
-    , m_daemonBlockChainHeight(0)
-    , m_daemonBlockChainHeightTtl(DAEMON_BLOCKCHAIN_HEIGHT_CACHE_TTL_SECONDS)
-    , m_daemonBlockChainTargetHeight(0)
+    , m_daemonStatusInFlight(false)
+    , m_daemonStatusValid(false)
+    , m_daemonStatus{ConnectionStatus_Disconnected, 0, 0}
+    , m_hedgeDaemonRequests(false)
+    , m_daemonQueryOutstanding(false)
+    , m_daemonStatusTtl(DAEMON_STATUS_CACHE_TTL_SECONDS)
     , m_daemonBlockChainTargetHeightTtl(DAEMON_BLOCKCHAIN_TARGET_HEIGHT_CACHE_TTL_SECONDS)
     , m_connectionStatus(Wallet::ConnectionStatus_Disconnected)
     , m_connectionStatusTtl(WALLET_CONNECTION_STATUS_CACHE_TTL_SECONDS)
@@ -1175,27 +2548,57 @@ Wallet::Wallet(Monero::Wallet *w, QObject *parent)
     , m_initialized(false)
     , m_initializing(false)
     , m_currentSubaddressAccount(0)
-    , m_subaddress(new Subaddress(m_walletImpl->subaddress(), this))
+    , m_subaddress(nullptr)
     , m_subaddressModel(nullptr)
-    , m_subaddressAccount(new SubaddressAccount(m_walletImpl->subaddressAccount(), this))
+    , m_subaddressAccount(nullptr)
     , m_subaddressAccountModel(nullptr)
     , m_refreshNow(false)
     , m_refreshEnabled(false)
+    , m_refreshThreadStopping(false)
     , m_refreshing(false)
+    , m_transfersChanged(true)
+    , m_lastRefreshHeight(0)
+    , m_proofBatchCancelled(false)
+    , m_storeTimer(new QTimer(this))
+    , m_storeRunning(false)
+    , m_storeAgain(false)
+    , m_payoutCancelled(false)
+    , m_scanTransactionsCancelled(false)
+    , m_feeEstimateRunning(false)
+    , m_preparedTransaction(nullptr)
+    , m_preparedBuilding(false)
+    , m_preparedClaimed(false)
+    , m_reserveProofGeneration(0)
     , m_scheduler(this)
+    , m_deviceQueue(new DeviceQueue(m_scheduler, this))
+    , m_subaddressLookahead(new SubaddressLookahead(this))
+    , m_kdfRounds(1)
 {
+    m_storeTimer->setSingleShot(true);
+    m_storeTimer->setInterval(5000);
+    connect(m_storeTimer, &QTimer::timeout, this, &Wallet::storeScheduled);
     m_walletListener = new WalletListenerImpl(this);
     m_walletImpl->setListener(m_walletListener);
     m_currentSubaddressAccount = getCacheAttribute(ATTRIBUTE_SUBADDRESS_ACCOUNT).toUInt();
+    m_subaddressLookahead->restore(getCacheAttribute(ATTRIBUTE_SUBADDRESS_LOOKAHEAD).toUInt());
+    if (m_subaddressLookahead->minor() > SubaddressLookahead::DEFAULT_MINOR)
+    {
+        m_walletImpl->setSubaddressLookahead(m_subaddressLookahead->major(), m_subaddressLookahead->minor());
+    }
+    m_history->setAccountIndex(m_currentSubaddressAccount);
     // start cache timers
     m_connectionStatusTime.start();
-    m_daemonBlockChainHeightTime.start();
+    m_daemonStatusTime.start();
     m_daemonBlockChainTargetHeightTime.start();
     m_connectionStatusRunning = false;
     m_daemonUsername = "";
     m_daemonPassword = "";
+    publishBalanceSnapshot();
 
-    startRefreshThread();
+    if (refreshThread)
+    {
+        startRefreshThread();
+    }
 }
 
 Wallet::~Wallet()
@@ -1203,8 +2606,21 @@ Wallet::~Wallet()
     qDebug("~Wallet: Closing wallet");
 
     pauseRefresh();
+    {
+        QMutexLocker locker(&m_refreshMutex);
+        m_refreshThreadStopping = true;
+    }
+    m_refreshCondition.wakeAll();
+    // running tasks see the token cancelled before libwallet is told to stop
+    m_scheduler.cancel();
     m_walletImpl->stop();
+    m_proofBatchCancelled = true;
+    m_payoutCancelled = true;
+    m_scanTransactionsCancelled = true;
     m_scheduler.shutdownWaitForFinished();
+    m_history->shutdown();
+    m_preparedClaimed = false;
+    discardPreparedTransaction();
 
     //Monero::WalletManagerFactory::getWalletManager()->closeWallet(m_walletImpl);
     if(status() == Status_Critical)
@@ -1222,30 +2638,87 @@ Wallet::~Wallet()
 
 void Wallet::startRefreshThread()
 {
+    reserveRefreshLoopThread(1);
     const auto future = m_scheduler.run([this] {
-        constexpr const std::chrono::seconds refreshInterval{10};
-        constexpr const std::chrono::milliseconds intervalResolution{100};
-
-        auto last = std::chrono::steady_clock::now();
-        while (!m_scheduler.stopping())
+        const auto release = sg::make_scope_guard([]() noexcept {
+            reserveRefreshLoopThread(-1);
+        });
+        const BackgroundSyncPolicy::Cadence foreground{
+            BackgroundSyncPolicy::Aggressive,
+            std::chrono::seconds(10),
+            std::chrono::seconds(60),
+            QThread::InheritPriority,
+        };
+        // background syncing wallets follow the host's power, idle and network state
+        const auto cadence = [this, &foreground] {
+            return m_walletImpl->isBackgroundSyncing() ? BackgroundSyncPolicy::instance()->cadence() : foreground;
+        };
+        // a longer interval is cut into slices so a change of the cadence is noticed
+        constexpr const std::chrono::seconds cadenceRecheck{60};
+
+        // Sleep until startRefresh() or the interval expires. The
+        // interval doubles for every refresh that doesn't observe a new daemon
+        // height and drops back to the cadence's interval as soon as it changes.
+        std::chrono::milliseconds interval = foreground.interval;
+        quint64 lastDaemonHeight = 0;
+        QElapsedTimer sinceRefresh;
+
+        QMutexLocker locker(&m_refreshMutex);
+        while (!m_refreshThreadStopping && !m_scheduler.stopping())
         {
-            if (m_refreshEnabled)
+            if (!m_refreshNow)
             {
-                const auto now = std::chrono::steady_clock::now();
-                const auto elapsed = now - last;
-                if (elapsed >= refreshInterval || m_refreshNow)
-                {
-                    refresh(false);
-                    last = std::chrono::steady_clock::now();
-                    m_refreshNow = false;
-                }
+                const std::chrono::milliseconds remaining = sinceRefresh.isValid()
+                    ? std::max<std::chrono::milliseconds>(interval - std::chrono::milliseconds(sinceRefresh.elapsed()), std::chrono::milliseconds(0))
+                    : interval;
+                const QDeadlineTimer deadline = m_refreshEnabled
+                    ? QDeadlineTimer(std::min<std::chrono::milliseconds>(remaining, cadenceRecheck))
+                    : QDeadlineTimer(QDeadlineTimer::Forever);
+                m_refreshCondition.wait(&m_refreshMutex, deadline);
+            }
+            if (m_refreshThreadStopping || !m_refreshEnabled)
+            {
+                continue;
+            }
+            const BackgroundSyncPolicy::Cadence current = cadence();
+            interval = std::clamp(interval, current.interval, current.maxInterval);
+            if (!m_refreshNow && sinceRefresh.isValid() && sinceRefresh.elapsed() < interval.count())
+            {
+                continue;
+            }
+            m_refreshNow = false;
+            locker.unlock();
+
+            QThread *thread = QThread::currentThread();
+            const QThread::Priority priority = thread->priority();
+            if (current.priority != QThread::InheritPriority)
+            {
+                thread->setPriority(current.priority);
+            }
+            refresh(false);
+            if (current.priority != QThread::InheritPriority)
+            {
+                thread->setPriority(priority);
+            }
+            sinceRefresh.start();
+
+            const quint64 daemonHeight = daemonBlockChainHeight();
+            if (daemonHeight != lastDaemonHeight)
+            {
+                interval = current.interval;
+                lastDaemonHeight = daemonHeight;
+            }
+            else
+            {
+                interval = std::min<std::chrono::milliseconds>(interval * 2, current.maxInterval);
             }
 
-            std::this_thread::sleep_for(intervalResolution);
+            locker.relock();
         }
-    });
+    }, FutureScheduler::BlockingIO, "Wallet::startRefreshThread");
     if (!future.first)
     {
+        reserveRefreshLoopThread(-1);
         throw std::runtime_error("failed to start auto refresh thread");
     }
 }
@@ -30,11 +30,20 @@
 #define WALLET_H
 
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
 
+#include <QAtomicPointer>
+#include <QDeadlineTimer>
 #include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QList>
+#include <QVector>
 #include <QJSValue>
 #include <QtConcurrent/QtConcurrent>
 
@@ -43,7 +52,11 @@
 #include "PendingTransaction.h" // we need to have an access to the PendingTransaction::Priority enum here;
 #include "UnsignedTransaction.h"
 #include "NetworkType.h"
+#include "DaemonPool.h"
+#include "DeviceQueue.h"
 #include "PassphraseHelper.h"
+#include "SubaddressLookahead.h"
+#include "SyncProfile.h"
 #include "WalletListenerImpl.h"
 
 namespace Monero {
@@ -51,8 +64,10 @@ struct Wallet; // forward declaration
 }
 
 
+class QTimer;
 class TransactionHistory;
 class TransactionHistoryModel;
+class TransactionHistorySnapshot;
 // Qt6 meta-type system requires full definitions for Q_PROPERTY types
 #include "model/TransactionHistorySortFilterModel.h"
 class AddressBook;
@@ -85,8 +100,10 @@ class Wallet : public QObject, public PassprasePrompter
     Q_PROPERTY(AddressBook * addressBook READ addressBook NOTIFY addressBookChanged)
     Q_PROPERTY(SubaddressModel * subaddressModel READ subaddressModel)
     Q_PROPERTY(Subaddress * subaddress READ subaddress)
+    Q_PROPERTY(DeviceQueue * deviceQueue READ deviceQueue CONSTANT)
     Q_PROPERTY(SubaddressAccountModel * subaddressAccountModel READ subaddressAccountModel)
     Q_PROPERTY(SubaddressAccount * subaddressAccount READ subaddressAccount)
+    Q_PROPERTY(quint32 subaddressLookahead READ subaddressLookahead NOTIFY subaddressLookaheadChanged)
     Q_PROPERTY(bool viewOnly READ viewOnly)
     Q_PROPERTY(QString secretViewKey READ getSecretViewKey)
     Q_PROPERTY(QString publicViewKey READ getPublicViewKey)
@@ -95,6 +112,7 @@ class Wallet : public QObject, public PassprasePrompter
     Q_PROPERTY(QString daemonLogPath READ getDaemonLogPath CONSTANT)
     Q_PROPERTY(QString proxyAddress READ getProxyAddress WRITE setProxyAddress NOTIFY proxyAddressChanged)
     Q_PROPERTY(quint64 walletCreationHeight READ getWalletCreationHeight WRITE setWalletCreationHeight NOTIFY walletCreationHeightChanged)
+    Q_PROPERTY(bool hedgeDaemonRequests READ hedgeDaemonRequests WRITE setHedgeDaemonRequests NOTIFY hedgeDaemonRequestsChanged)
 
 public:
 
@@ -162,6 +180,9 @@ public:
     //! saves wallet to the file by given path
     //! empty path stores in current location
     Q_INVOKABLE void storeAsync(const QJSValue &callback, const QString &path = "");
+    //! stores the wallet a few seconds after the last of a burst of edits,
+    //! callable from any thread
+    Q_INVOKABLE void scheduleStore();
 
     //! initializes wallet asynchronously
     Q_INVOKABLE void initAsync(
@@ -185,6 +206,13 @@ public:
     //! indicates id daemon is trusted
     Q_INVOKABLE void setTrustedDaemon(bool arg);
 
+    //! remote nodes to fail over to when the current one stops answering,
+    //! {address, username, password, trusted} maps, an empty list disables failover
+    Q_INVOKABLE void setFailoverNodes(const QVariantList &nodes, int current, const QString &proxyAddress);
+
+    //! adds the checkpoints missing from the restore height table, trusted daemons only
+    Q_INVOKABLE void extendRestoreHeightTable();
+
     //! returns balance
     Q_INVOKABLE quint64 balance() const;
     Q_INVOKABLE quint64 balance(quint32 accountIndex) const;
@@ -201,7 +229,19 @@ public:
     Q_INVOKABLE void addSubaddressAccount(const QString& label);
     Q_INVOKABLE quint32 numSubaddressAccounts() const;
     Q_INVOKABLE quint32 numSubaddresses(quint32 accountIndex) const;
+    //! minor lookahead libwallet scans ahead of the used addresses, grows with the gaps between them.
+    //! Growth only applies to blocks scanned afterwards, see growSubaddressLookaheadAndRescanAsync
+    quint32 subaddressLookahead() const;
+    //! tableEntries, estimatedBytes and estimatedBuildMs of the current lookahead, see SubaddressLookahead::cost
+    Q_INVOKABLE QVariantMap subaddressLookaheadCost() const;
+    //! grows the minor lookahead by one batch and rescans the blockchain from the
+    //! wallet's creation height, finding earlier transfers to the newly covered
+    //! addresses. callback receives whether it succeeded and the error string otherwise
+    Q_INVOKABLE void growSubaddressLookaheadAndRescanAsync(const QJSValue &callback);
     Q_INVOKABLE void addSubaddress(const QString& label);
+    //! derives count addresses and stores the wallet once, "%1" in the label
+    //! pattern is replaced with each address index
+    Q_INVOKABLE void addSubaddressesAsync(quint32 accountIndex, quint32 count, const QString &labelPattern);
     Q_INVOKABLE QString getSubaddressLabel(quint32 accountIndex, quint32 addressIndex) const;
     Q_INVOKABLE void setSubaddressLabel(quint32 accountIndex, quint32 addressIndex, const QString &label);
     Q_INVOKABLE void deviceShowAddressAsync(quint32 accountIndex, quint32 addressIndex, const QString &paymentId);
@@ -224,8 +264,24 @@ public:
     Q_INVOKABLE bool exportOutputs(const QString& path, bool all = false);
     Q_INVOKABLE bool importOutputs(const QString& path);
 
+    //! async variants run on a worker thread between refreshes, the callback receives
+    //! whether it succeeded and the error string otherwise. all = false
+    //! exports only what was added since the last export.
+    Q_INVOKABLE void exportKeyImagesAsync(const QString &path, bool all, const QJSValue &callback);
+    Q_INVOKABLE void importKeyImagesAsync(const QString &path, const QJSValue &callback);
+    Q_INVOKABLE void exportOutputsAsync(const QString &path, bool all, const QJSValue &callback);
+    Q_INVOKABLE void importOutputsAsync(const QString &path, const QJSValue &callback);
+
     //! scan transactions
     Q_INVOKABLE bool scanTransactions(const QVector<QString> &txids);
+    //! scans in one call like scanTransactions. Only lists longer than an
+    //! untrusted node serves at once are split into batches of 100, releasing
+    //! the wallet to the refresh thread in between. libwallet refuses
+    //! transactions older than ones it has seen, so such lists must be
+    //! ordered oldest first. The callback receives whether every batch
+    //! succeeded and the last error.
+    Q_INVOKABLE void scanTransactionsAsync(const QVector<QString> &txids, const QJSValue &callback);
+    Q_INVOKABLE void cancelScanTransactions();
 
     Q_INVOKABLE void setupBackgroundSync(const BackgroundSyncType background_sync_type, const QString &wallet_password);
     Q_INVOKABLE BackgroundSyncType getBackgroundSyncType() const;
@@ -253,6 +309,28 @@ public:
         quint32 mixin_count,
         PendingTransaction::Priority priority);
 
+    //! builds the transaction ahead of time while the user reviews the form,
+    //! createTransactionAsync with the same inputs hands it out right away.
+    //! Any other inputs, a new block or a balance change discard it. Does
+    //! nothing on an untrusted daemon, each build would show it new decoys
+    //! for the same inputs.
+    Q_INVOKABLE void prepareTransactionAsync(
+        const QVector<QString> &destinationAddresses,
+        const QString &payment_id,
+        const QVector<QString> &destinationAmounts,
+        quint32 mixin_count,
+        PendingTransaction::Priority priority);
+    Q_INVOKABLE void discardPreparedTransaction();
+
+    //! pays every recipient, packing as many as fit into each transaction
+    //! and committing them one after another. Reports each recipient
+    //! through payoutRecipientStatus.
+    Q_INVOKABLE void payoutAsync(const QStringList &addresses, const QStringList &amounts, quint32 mixin_count, PendingTransaction::Priority priority);
+    //! same with "address,amount" lines read from a file
+    Q_INVOKABLE void payoutCsvAsync(const QString &path, quint32 mixin_count, PendingTransaction::Priority priority);
+    //! stops before the next transaction is built
+    Q_INVOKABLE void cancelPayout();
+
     //! creates transaction with all outputs
     Q_INVOKABLE PendingTransaction * createTransactionAll(const QString &dst_addr, const QString &payment_id,
                                                        quint32 mixin_count, PendingTransaction::Priority priority);
@@ -282,6 +360,8 @@ public:
     //! deletes unsigned transaction and frees memory
     Q_INVOKABLE void disposeTransaction(UnsignedTransaction * t);
 
+    //! only the latest request is answered, callbacks of requests replaced
+    //! while an estimate was running are dropped
     Q_INVOKABLE void estimateTransactionFeeAsync(
         const QVector<QString> &destinationAddresses,
         const QVector<quint64> &amounts,
@@ -312,6 +392,9 @@ public:
     //! returns subadress account model
     SubaddressAccountModel *subaddressAccountModel() const;
 
+    //! serializes the operations of hardware wallets
+    DeviceQueue *deviceQueue() const;
+
     //! generate payment id
     Q_INVOKABLE QString generatePaymentId() const;
 
@@ -344,10 +427,29 @@ public:
     Q_INVOKABLE QString getSpendProof(const QString &txid, const QString &message) const;
     Q_INVOKABLE void getSpendProofAsync(const QString &txid, const QString &message, const QJSValue &callback);
     Q_INVOKABLE QString checkSpendProof(const QString &txid, const QString &message, const QString &signature) const;
+    //! batch variants prove or check every txid in turn in one task and report
+    //! each result through proofBatchProgress. addresses pair
+    //! up with txids. If out is given, "txid,address,result" lines are written
+    //! there in input order. The callback receives the file name, or "" on
+    //! failure, cancellation or when no file was requested.
+    Q_INVOKABLE void getTxProofsAsync(const QStringList &txids, const QStringList &addresses, const QString &message, const QString &out, const QJSValue &callback);
+    Q_INVOKABLE void checkTxProofsAsync(const QStringList &txids, const QStringList &addresses, const QString &message, const QStringList &signatures, const QString &out, const QJSValue &callback);
+    Q_INVOKABLE void getSpendProofsAsync(const QStringList &txids, const QString &message, const QString &out, const QJSValue &callback);
+    Q_INVOKABLE void checkSpendProofsAsync(const QStringList &txids, const QString &message, const QStringList &signatures, const QString &out, const QJSValue &callback);
+    Q_INVOKABLE void cancelProofBatch();
     Q_INVOKABLE QString getReserveProof(bool all, quint32 account_index, quint64 amount, const QString &message) const;
     Q_INVOKABLE QString checkReserveProof(const QString &address, const QString &message, const QString &signature) const;
+    //! callbacks receive the same strings as the synchronous calls, or
+    //! "error|cancelled" once cancelReserveProof was called
+    Q_INVOKABLE void getReserveProofAsync(bool all, quint32 account_index, quint64 amount, const QString &message, const QJSValue &callback);
+    Q_INVOKABLE void checkReserveProofAsync(const QString &address, const QString &message, const QString &signature, const QJSValue &callback);
+    Q_INVOKABLE void cancelReserveProof();
     // Rescan spent outputs
     Q_INVOKABLE bool rescanSpent();
+    //! callback receives whether it succeeded and the error string otherwise.
+    //! libwallet checks every key image in one daemon request, there is no
+    //! progress to report and nothing to cancel in between.
+    Q_INVOKABLE void rescanSpentAsync(const QJSValue &callback);
 
     // check if fork rules should be used
     Q_INVOKABLE bool useForkRules(quint8 version, quint64 earlyBlocks = 0) const;
@@ -368,6 +470,11 @@ public:
     Q_INVOKABLE QString getRing(const QString &key_image);
     Q_INVOKABLE QString getRings(const QString &txid);
     Q_INVOKABLE bool setRing(const QString &key_image, const QString &ring, bool relative);
+    //! one "txid key_image absolute outs...|key_image ..." line per txid with rings
+    Q_INVOKABLE QString getRingsForTxs(const QStringList &txids);
+    //! applies lines in the getRingsForTxs format and returns {set, malformedLines,
+    //! failedLines}. Malformed lines are skipped whole, line numbers start at 1.
+    Q_INVOKABLE QVariantMap setRings(const QString &rings);
 
     // key reuse mitigation options
     Q_INVOKABLE void segregatePreForkOutputs(bool segregate);
@@ -404,6 +511,20 @@ signals:
     void transactionCommitted(bool status, PendingTransaction *t, const QStringList& txid);
     void heightRefreshed(quint64 walletHeight, quint64 daemonHeight, quint64 targetHeight) const;
     void deviceShowAddressShowed();
+    void proofBatchProgress(int done, int total, int index, const QString &txid, const QString &result) const;
+    //! status is "sent" with the txids as detail, or "invalid", "failed" or
+    //! "cancelled" with the reason. "unknown" means the signed transaction
+    //! could not be committed and may still have been relayed, its txids
+    //! are in the detail and the batch is never rebuilt.
+    void payoutRecipientStatus(int index, const QString &address, const QString &status, const QString &detail) const;
+    void payoutProgress(int done, int total) const;
+    void payoutFinished(int paid, int failed) const;
+    void subaddressesAdded(quint32 accountIndex, quint32 firstIndex, quint32 count, bool stored) const;
+    void subaddressLookaheadChanged() const;
+    //! a cold wallet export or import started or finished
+    void coldSyncBusyChanged(bool busy) const;
+    void scheduledStoreFinished(bool success) const;
+    void scanTransactionsProgress(int scanned, int total) const;
 
     // emitted when transaction is created async
     void transactionCreated(
@@ -417,12 +538,34 @@ signals:
     void disconnectedChanged() const;
     void proxyAddressChanged() const;
     void refreshingChanged() const;
+    void hedgeDaemonRequestsChanged() const;
+    //! the wallet switched to another failover node on its own
+    void daemonFailover(int index, const QString &address) const;
 
 private:
     Wallet(QObject * parent = nullptr);
-    Wallet(Monero::Wallet *w, QObject * parent = 0);
+    //! refreshThread = false leaves refreshing to the owner, see WalletSessionManager
+    Wallet(Monero::Wallet *w, QObject * parent = 0, bool refreshThread = true);
     ~Wallet();
 
+    //! keys the on-disk copy of the history next to the wallet file with the
+    //! wallet password and shows it until the first refresh, see
+    //! TransactionHistorySnapshot. Slow, called by the opener off the GUI thread.
+    void openHistorySnapshot(const QString &password, quint64 kdfRounds);
+    //! writes the history snapshot, false if none was opened or writing failed
+    bool storeHistorySnapshot();
+
+    //! grows libwallet's lookahead to the gaps of the last history refresh, m_asyncMutex held
+    void updateSubaddressLookahead();
+    //! hands the current lookahead to libwallet and remembers it, m_asyncMutex held
+    void applySubaddressLookahead();
+
+    //! hardware wallets run work through m_deviceQueue, others on lane as before,
+    //! false if the work was refused because the wallet is closing
+    bool runDeviceOperation(const char *name, FutureScheduler::Lane lane, std::function<void()> work);
+    //! items are {count, labelPattern} requests for the same account, stored once
+    void addSubaddresses(quint32 accountIndex, const QVariantList &requests);
+
     //! returns current wallet's block height
     //! (can be less than daemon's blockchain height when wallet sync in progress)
     quint64 blockChainHeight() const;
@@ -433,6 +576,21 @@ private:
     //! returns daemon's blockchain target height
     quint64 daemonBlockChainTargetHeight() const;
 
+    struct DaemonStatus
+    {
+        ConnectionStatus connection;
+        quint64 height;
+        quint64 targetHeight;
+    };
+    //! connection status, height and target height of the daemon, cached for a few seconds.
+    //! Concurrent callers share a single in flight query.
+    DaemonStatus daemonStatus(bool forceCheck = false) const;
+    static DaemonStatus queryDaemonStatus(Monero::Wallet *walletImpl, DaemonStatus status, bool refreshTarget);
+    //! races a query that misses the latency budget against another failover node
+    DaemonStatus hedgedDaemonStatus(DaemonStatus status, bool refreshTarget) const;
+    void recordDaemonHealth(const DaemonStatus &status, std::chrono::milliseconds latency) const;
+    void failoverDaemon();
+
     //! initializes wallet
     bool init(
         const QString &daemonAddress,
@@ -450,17 +608,52 @@ private:
         quint32 mixin_count,
         PendingTransaction::Priority priority);
 
+    // balances of every subaddress account, immutable once published
+    struct BalanceSnapshot
+    {
+        QVector<quint64> balance;
+        QVector<quint64> unlockedBalance;
+        quint64 balanceAll = 0;
+        quint64 unlockedBalanceAll = 0;
+    };
+    //! reads libwallet's balances and publishes them to the balance getters,
+    //! callable from any thread, returns whether any balance changed
+    bool publishBalanceSnapshot();
+    const BalanceSnapshot *balanceSnapshot() const;
+
     bool disconnected() const;
     bool refreshing() const;
     void refreshingSet(bool value);
     void setConnectionStatus(ConnectionStatus value);
     QString getProxyAddress() const;
     void setProxyAddress(QString address);
+    bool hedgeDaemonRequests() const;
+    void setHedgeDaemonRequests(bool hedge);
     void startRefreshThread();
+    struct FeeEstimateRequest
+    {
+        int destinations;
+        PendingTransaction::Priority priority;
+        QJSValue callback;
+    };
+    void startFeeEstimate(const FeeEstimateRequest &request);
+    QString preparedTransactionKey(
+        const QVector<QString> &destinationAddresses,
+        const QString &payment_id,
+        const QVector<QString> &destinationAmounts,
+        quint32 mixin_count,
+        PendingTransaction::Priority priority) const;
+    void runPayout(const QStringList &addresses, const QStringList &amounts, quint32 mixin_count, PendingTransaction::Priority priority);
+    void runColdSyncTask(std::function<bool()> task, const QJSValue &callback, const char *tag);
+    bool appendRings(std::string &out, const QString &txid) const;
+    void storeScheduled();
+    void runProofBatch(const QStringList &txids, const QStringList &addresses, const QString &out, const QJSValue &callback,
+                       std::function<QString(int)> prove, const char *tag);
 
 private:
     friend class WalletManager;
     friend class WalletListenerImpl;
+    friend class WalletSessionManager;
     //! libwallet's
     Monero::Wallet * m_walletImpl;
     // history lifetime managed by wallet;
@@ -468,13 +661,21 @@ private:
     // Used for UI history view
     mutable TransactionHistoryModel * m_historyModel;
     mutable TransactionHistorySortFilterModel * m_historySortFilterModel;
-    AddressBook * m_addressBook;
+    // built on first access, the refresh thread skips them until then
+    mutable QAtomicPointer<AddressBook> m_addressBook;
     mutable AddressBookModel * m_addressBookModel;
-    mutable QElapsedTimer m_daemonBlockChainHeightTime;
-    mutable quint64 m_daemonBlockChainHeight;
-    int     m_daemonBlockChainHeightTtl;
+    mutable QMutex m_daemonStatusMutex;
+    mutable QWaitCondition m_daemonStatusCondition;
+    mutable bool m_daemonStatusInFlight;
+    mutable bool m_daemonStatusValid;
+    mutable DaemonStatus m_daemonStatus;
+    mutable DaemonPool m_daemonPool;
+    std::atomic<bool> m_hedgeDaemonRequests;
+    // a libwallet status query a hedge answered for may still wait on a stalled node
+    mutable std::atomic<bool> m_daemonQueryOutstanding;
+    mutable QElapsedTimer m_daemonStatusTime;
+    int     m_daemonStatusTtl;
     mutable QElapsedTimer m_daemonBlockChainTargetHeightTime;
-    mutable quint64 m_daemonBlockChainTargetHeight;
     int     m_daemonBlockChainTargetHeightTtl;
     mutable ConnectionStatus m_connectionStatus;
     int     m_connectionStatusTtl;
@@ -483,22 +684,71 @@ private:
     std::atomic<bool> m_initialized;
     std::atomic<bool> m_initializing;
     uint32_t m_currentSubaddressAccount;
-    Subaddress * m_subaddress;
+    mutable QAtomicPointer<Subaddress> m_subaddress;
     mutable SubaddressModel * m_subaddressModel;
-    SubaddressAccount * m_subaddressAccount;
+    mutable QAtomicPointer<SubaddressAccount> m_subaddressAccount;
     mutable SubaddressAccountModel * m_subaddressAccountModel;
     QMutex m_asyncMutex;
     QMutex m_connectionStatusMutex;
     bool m_connectionStatusRunning;
+    QString m_daemonAddress;
     QString m_daemonUsername;
     QString m_daemonPassword;
     QString m_proxyAddress;
     mutable QMutex m_proxyMutex;
     std::atomic<bool> m_refreshNow;
     std::atomic<bool> m_refreshEnabled;
+    bool m_refreshThreadStopping;
+    QMutex m_refreshMutex;
+    QWaitCondition m_refreshCondition;
     std::atomic<bool> m_refreshing;
+    // set by the listener's money notifications and local commits, tells
+    // refresh() to rebuild history and subaddresses
+    std::atomic<bool> m_transfersChanged;
+    quint64 m_lastRefreshHeight;
+    SyncProfile m_syncProfile;
     WalletListenerImpl *m_walletListener;
+    // readers on the wallet's thread load the raw pointer without locking,
+    // replaced snapshots are released from the wallet's event loop once no
+    // read can still be in progress
+    QAtomicPointer<const BalanceSnapshot> m_balanceSnapshot;
+    std::shared_ptr<const BalanceSnapshot> m_balanceSnapshotOwner;
+    QMutex m_balanceSnapshotMutex;
+    std::atomic<bool> m_proofBatchCancelled;
+    // debounced stores, only touched on the wallet's thread
+    QTimer *m_storeTimer;
+    bool m_storeRunning;
+    bool m_storeAgain;
+    std::atomic<bool> m_payoutCancelled;
+    std::atomic<bool> m_scanTransactionsCancelled;
+    // libwallet's estimate only depends on the number of destinations, the
+    // priority and the daemon's fee, which can change with every block.
+    // Only touched on the wallet's thread.
+    struct FeeEstimate
+    {
+        QString fee;
+        quint64 height;
+        QDeadlineTimer expiry;
+    };
+    QHash<QString, FeeEstimate> m_feeEstimates;
+    // speculatively built transaction, only touched on the wallet's thread.
+    // A claimed build is emitted as transactionCreated once it's done.
+    QString m_preparedKey;
+    PendingTransaction *m_preparedTransaction;
+    bool m_preparedBuilding;
+    bool m_preparedClaimed;
+    bool m_feeEstimateRunning;
+    std::optional<FeeEstimateRequest> m_pendingFeeEstimate;
+    // bumped to cancel, libwallet can't interrupt a proof so the result of
+    // an older generation is dropped
+    std::atomic<quint64> m_reserveProofGeneration;
     FutureScheduler m_scheduler;
+    // after m_scheduler, the queue runs its operations there
+    DeviceQueue *m_deviceQueue;
+    SubaddressLookahead *m_subaddressLookahead;
+    QMutex m_historySnapshotMutex;
+    std::unique_ptr<TransactionHistorySnapshot> m_historySnapshot;
+    quint64 m_kdfRounds;
 };
 
 
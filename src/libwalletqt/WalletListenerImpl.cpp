@@ -29,9 +29,16 @@
 #include "WalletListenerImpl.h"
 #include "Wallet.h"
 
+#include <QMutexLocker>
+
+namespace {
+    static const int NEW_BLOCK_SIGNAL_INTERVAL_MS = 100;
+}
+
 WalletListenerImpl::WalletListenerImpl(Wallet * w)
     : m_wallet(w)
     , m_phelper(w)
+    , m_pendingBlockHeight(0)
 {
 
 }
@@ -39,29 +46,54 @@ WalletListenerImpl::WalletListenerImpl(Wallet * w)
 void WalletListenerImpl::moneySpent(const std::string &txId, uint64_t amount)
 {
     qDebug() << __FUNCTION__;
+    m_wallet->m_transfersChanged = true;
+    m_wallet->m_syncProfile.count(SyncProfile::TransferSignals);
     emit m_wallet->moneySpent(QString::fromStdString(txId), amount);
 }
 
 void WalletListenerImpl::moneyReceived(const std::string &txId, uint64_t amount)
 {
     qDebug() << __FUNCTION__;
+    m_wallet->m_transfersChanged = true;
+    m_wallet->m_syncProfile.count(SyncProfile::TransferSignals);
     emit m_wallet->moneyReceived(QString::fromStdString(txId), amount);
 }
 
 void WalletListenerImpl::unconfirmedMoneyReceived(const std::string &txId, uint64_t amount)
 {
     qDebug() << __FUNCTION__;
+    m_wallet->m_transfersChanged = true;
+    m_wallet->m_syncProfile.count(SyncProfile::TransferSignals);
     emit m_wallet->unconfirmedMoneyReceived(QString::fromStdString(txId), amount);
 }
 
 void WalletListenerImpl::newBlock(uint64_t height)
 {
     // qDebug() << __FUNCTION__;
+    m_wallet->m_syncProfile.count(SyncProfile::NewBlockCallbacks);
+    {
+        QMutexLocker locker(&m_newBlockMutex);
+        if (m_newBlockTimer.isValid() && m_newBlockTimer.elapsed() < NEW_BLOCK_SIGNAL_INTERVAL_MS)
+        {
+            // delivered by the next newBlock past the interval or by refreshed()
+            m_pendingBlockHeight = height;
+            return;
+        }
+        m_newBlockTimer.start();
+        m_pendingBlockHeight = 0;
+    }
+    emitNewBlock(height);
+}
+
+void WalletListenerImpl::emitNewBlock(uint64_t height)
+{
+    m_wallet->m_syncProfile.count(SyncProfile::NewBlockSignals);
     emit m_wallet->newBlock(height, m_wallet->daemonBlockChainTargetHeight());
 }
 
 void WalletListenerImpl::updated()
 {
+    m_wallet->m_syncProfile.count(SyncProfile::UpdatedSignals);
     emit m_wallet->updated();
 }
 
@@ -69,6 +101,17 @@ void WalletListenerImpl::updated()
 void WalletListenerImpl::refreshed()
 {
     qDebug() << __FUNCTION__;
+    uint64_t pendingBlockHeight;
+    {
+        QMutexLocker locker(&m_newBlockMutex);
+        pendingBlockHeight = m_pendingBlockHeight;
+        m_pendingBlockHeight = 0;
+    }
+    if (pendingBlockHeight != 0)
+    {
+        emitNewBlock(pendingBlockHeight);
+    }
+    m_wallet->m_syncProfile.count(SyncProfile::RefreshedSignals);
     emit m_wallet->refreshed();
 }
 
@@ -29,6 +29,9 @@
 #ifndef MONERO_GUI_WALLETLISTENERIMPL_H
 #define MONERO_GUI_WALLETLISTENERIMPL_H
 
+#include <QElapsedTimer>
+#include <QMutex>
+
 #include "wallet/api/wallet2_api.h"
 #include "PassphraseHelper.h"
 
@@ -60,9 +63,16 @@ public:
 
     virtual Monero::optional<std::string> onDevicePassphraseRequest(bool & on_device) override;
 
+private:
+    void emitNewBlock(uint64_t height);
+
 private:
     Wallet * m_wallet;
     PassphraseHelper m_phelper;
+    // newBlock fires for every scanned block, forward at most one per interval
+    QMutex m_newBlockMutex;
+    QElapsedTimer m_newBlockTimer;
+    uint64_t m_pendingBlockHeight;
 };
 
 #endif //MONERO_GUI_WALLETLISTENERIMPL_H
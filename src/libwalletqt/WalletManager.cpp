@@ -28,24 +28,100 @@
 
 #include "WalletManager.h"
 #include "Wallet.h"
+#include "RestoreHeightTable.h"
 #include "wallet/api/wallet2_api.h"
 #include "zxcvbn-c/zxcvbn.h"
 #include "QRCodeImageProvider.h"
+#include "QR-Code-scanner/FountainCode.h"
+#include <QByteArray>
 #include <QClipboard>
 #include <QGuiApplication>
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
+#include <QDate>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QUrl>
 #include <QtConcurrent/QtConcurrent>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QString>
 
+#include <algorithm>
+#include <limits>
+#include <optional>
+
+#include "qt/IndexedMap.h"
 #include "qt/updater.h"
 #include "qt/ScopeGuard.h"
 
+namespace {
+    const char *nettypeName(Monero::NetworkType nettype)
+    {
+        switch (nettype)
+        {
+        case Monero::TESTNET:
+            return "testnet";
+        case Monero::STAGENET:
+            return "stagenet";
+        default:
+            return "mainnet";
+        }
+    }
+
+    // first base58 character of a subaddress on each network
+    bool isSubaddressPrefix(QChar prefix, Monero::NetworkType nettype)
+    {
+        switch (nettype)
+        {
+        case Monero::TESTNET:
+            return prefix == 'B';
+        case Monero::STAGENET:
+            return prefix == '7';
+        default:
+            return prefix == '8';
+        }
+    }
+
+    QVariantMap validateAddress(const QString &address, Monero::NetworkType nettype)
+    {
+        const QString trimmed = address.trimmed();
+        const std::string value = trimmed.toStdString();
+
+        Monero::NetworkType addressNettype = nettype;
+        bool valid = Monero::Wallet::addressValid(value, nettype);
+        if (!valid)
+        {
+            for (const Monero::NetworkType other : {Monero::MAINNET, Monero::TESTNET, Monero::STAGENET})
+            {
+                if (other != nettype && Monero::Wallet::addressValid(value, other))
+                {
+                    addressNettype = other;
+                    break;
+                }
+            }
+        }
+        const bool known = valid || addressNettype != nettype;
+
+        QVariantMap result{
+            {"address", address},
+            {"valid", valid},
+            {"status", valid ? "valid" : known ? "wrong_network" : "invalid"},
+        };
+        if (known)
+        {
+            const std::string paymentId = Monero::Wallet::paymentIdFromAddress(value, addressNettype);
+            result.insert("nettype", nettypeName(addressNettype));
+            result.insert("kind", !paymentId.empty()
+                ? "integrated"
+                : isSubaddressPrefix(trimmed.front(), addressNettype) ? "subaddress" : "standard");
+            result.insert("paymentId", QString::fromStdString(paymentId));
+        }
+        return result;
+    }
+}
+
 class WalletPassphraseListenerImpl : public  Monero::WalletListener, public PassphraseReceiver
 {
 public:
@@ -98,6 +174,7 @@ Wallet *WalletManager::createWallet(const QString &path, const QString &password
     Monero::Wallet * w = m_pimpl->createWallet(path.toStdString(), password.toStdString(),
                                                   language.toStdString(), static_cast<Monero::NetworkType>(nettype), kdfRounds);
     m_currentWallet  = new Wallet(w);
+    m_currentWallet->openHistorySnapshot(password, kdfRounds);
     return m_currentWallet;
 }
 
@@ -113,23 +190,34 @@ Wallet *WalletManager::openWallet(const QString &path, const QString &password,
         this->m_passphraseReceiver = nullptr;
     });
 
+    QElapsedTimer timer;
+    timer.start();
+    qint64 closeMs = 0;
     if (m_currentWallet) {
         qDebug() << "Closing open m_currentWallet" << m_currentWallet;
         delete m_currentWallet;
+        closeMs = timer.restart();
     }
     qDebug("%s: opening wallet at %s, nettype = %d ",
            __PRETTY_FUNCTION__, qPrintable(path), nettype);
 
+    // keys and cache, the bulk of the open time
     Monero::Wallet * w =  m_pimpl->openWallet(path.toStdString(), password.toStdString(), static_cast<Monero::NetworkType>(nettype), kdfRounds, &tmpListener);
     w->setListener(nullptr);
+    const qint64 loadMs = timer.restart();
 
     qDebug("%s: opened wallet: %s, status: %d", __PRETTY_FUNCTION__, w->address(0, 0).c_str(), w->status());
     m_currentWallet  = new Wallet(w);
+    m_currentWallet->openHistorySnapshot(password, kdfRounds);
 
     // move wallet to the GUI thread. Otherwise it wont be emitting signals
     if (m_currentWallet->thread() != qApp->thread()) {
         m_currentWallet->moveToThread(qApp->thread());
     }
+    const qint64 constructMs = timer.elapsed();
+
+    qInfo("Wallet open timing: close previous %lld ms, load keys and cache %lld ms, construct %lld ms",
+          closeMs, loadMs, constructMs);
 
     return m_currentWallet;
 }
@@ -138,7 +226,7 @@ void WalletManager::openWalletAsync(const QString &path, const QString &password
 {
     m_scheduler.run([this, path, password, nettype, kdfRounds] {
         emit walletOpened(openWallet(path, password, nettype, kdfRounds));
-    });
+    }, FutureScheduler::BlockingIO, "WalletManager::openWalletAsync");
 }
 
 
@@ -151,6 +239,7 @@ Wallet *WalletManager::recoveryWallet(const QString &path, const QString &seed,
     }
     Monero::Wallet * w = m_pimpl->recoveryWallet(path.toStdString(), "", seed.toStdString(), static_cast<Monero::NetworkType>(nettype), restoreHeight, kdfRounds, seed_offset.toStdString());
     m_currentWallet = new Wallet(w);
+    m_currentWallet->openHistorySnapshot("", kdfRounds);
     return m_currentWallet;
 }
 
@@ -167,6 +256,7 @@ Wallet *WalletManager::createWalletFromKeys(const QString &path, const QString &
     Monero::Wallet * w = m_pimpl->createWalletFromKeys(path.toStdString(), "", language.toStdString(), static_cast<Monero::NetworkType>(nettype), restoreHeight,
                                                        address.toStdString(), viewkey.toStdString(), spendkey.toStdString(), kdfRounds);
     m_currentWallet = new Wallet(w);
+    m_currentWallet->openHistorySnapshot("", kdfRounds);
     return m_currentWallet;
 }
 
@@ -193,6 +283,7 @@ Wallet *WalletManager::createWalletFromDevice(const QString &path, const QString
     w->setListener(nullptr);
 
     m_currentWallet = new Wallet(w);
+    m_currentWallet->openHistorySnapshot(password, kdfRounds);
 
     // move wallet to the GUI thread. Otherwise it wont be emitting signals
     if (m_currentWallet->thread() != qApp->thread()) {
@@ -209,7 +300,7 @@ void WalletManager::createWalletFromDeviceAsync(const QString &path, const QStri
     m_scheduler.run([this, path, password, nettype, deviceName, restoreHeight, subaddressLookahead, kdfRounds] {
         Wallet *wallet = createWalletFromDevice(path, password, nettype, deviceName, restoreHeight, subaddressLookahead, kdfRounds);
         emit walletCreated(wallet);
-    });
+    }, FutureScheduler::BlockingIO, "WalletManager::createWalletFromDeviceAsync");
 }
 
 QString WalletManager::closeWallet()
@@ -218,6 +309,8 @@ QString WalletManager::closeWallet()
     QString result;
     if (m_currentWallet) {
         result = m_currentWallet->address(0, 0);
+        if (m_currentWallet->status() != Wallet::Status_Critical && !m_currentWallet->storeHistorySnapshot())
+            qDebug("History snapshot not stored");
         delete m_currentWallet;
     } else {
         qCritical() << "Trying to close non existing wallet " << m_currentWallet;
@@ -230,7 +323,7 @@ void WalletManager::closeWalletAsync(const QJSValue& callback)
 {
     m_scheduler.run([this] {
         return QJSValueList({closeWallet()});
-    }, callback);
+    }, callback, FutureScheduler::BlockingIO, "WalletManager::closeWalletAsync");
 }
 
 bool WalletManager::walletExists(const QString &path) const
@@ -263,14 +356,129 @@ QString WalletManager::maximumAllowedAmountAsString() const
     return WalletManager::displayAmount(WalletManager::maximumAllowedAmount());
 }
 
+namespace {
+
+// cryptonote::print_money and parse_amount with the default 12 decimals,
+// the GUI never changes the display decimal point
+constexpr int amountDecimals = 12;
+// 20 digits of quint64, the point and a leading zero
+constexpr int amountBufferSize = 24;
+
+int formatAmount(quint64 amount, char *buffer)
+{
+    char digits[amountBufferSize];
+    int count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + amount % 10);
+        amount /= 10;
+    } while (amount != 0);
+    // at least one integer digit
+    while (count < amountDecimals + 1)
+    {
+        digits[count++] = '0';
+    }
+
+    int length = 0;
+    for (int i = count - 1; i >= 0; --i)
+    {
+        if (i == amountDecimals - 1)
+        {
+            buffer[length++] = '.';
+        }
+        buffer[length++] = digits[i];
+    }
+    return length;
+}
+
+bool parseAmount(QStringView text, quint64 &amount)
+{
+    text = text.trimmed();
+    qsizetype point = text.indexOf(QLatin1Char('.'));
+    if (point < 0)
+    {
+        point = text.size();
+    }
+    QStringView integer = text.left(point);
+    QStringView fraction = point < text.size() ? text.mid(point + 1) : QStringView();
+    // zeros past the last decimal place don't count
+    while (fraction.size() > amountDecimals && fraction.endsWith(QLatin1Char('0')))
+    {
+        fraction.chop(1);
+    }
+    if (fraction.size() > amountDecimals || (integer.isEmpty() && fraction.isEmpty()))
+    {
+        return false;
+    }
+
+    quint64 result = 0;
+    const auto appendDigit = [&result](QChar c) {
+        if (c < QLatin1Char('0') || c > QLatin1Char('9'))
+        {
+            return false;
+        }
+        const quint64 digit = c.unicode() - '0';
+        if (result > (std::numeric_limits<quint64>::max() - digit) / 10)
+        {
+            return false;
+        }
+        result = result * 10 + digit;
+        return true;
+    };
+    for (const QChar c : integer)
+    {
+        if (!appendDigit(c))
+        {
+            return false;
+        }
+    }
+    for (const QChar c : fraction)
+    {
+        if (!appendDigit(c))
+        {
+            return false;
+        }
+    }
+    for (qsizetype i = fraction.size(); i < amountDecimals; ++i)
+    {
+        if (!appendDigit(QLatin1Char('0')))
+        {
+            return false;
+        }
+    }
+
+    amount = result;
+    return true;
+}
+
+} // namespace
+
 QString WalletManager::displayAmount(quint64 amount)
 {
-    return QString::fromStdString(Monero::Wallet::displayAmount(amount));
+    char buffer[amountBufferSize];
+    return QString::fromLatin1(buffer, formatAmount(amount, buffer));
+}
+
+void WalletManager::appendDisplayAmount(QString &out, quint64 amount)
+{
+    char buffer[amountBufferSize];
+    out.append(QLatin1String(buffer, formatAmount(amount, buffer)));
+}
+
+double WalletManager::displayAmountToDouble(quint64 amount)
+{
+    // same value as parsing the display string, without building it
+    char buffer[amountBufferSize];
+    const int length = formatAmount(amount, buffer);
+    // QByteArray parses in the C locale, floating point std::from_chars is missing from older libc++
+    return QByteArray::fromRawData(buffer, length).toDouble();
 }
 
 quint64 WalletManager::amountFromString(const QString &amount)
 {
-    return Monero::Wallet::amountFromString(amount.toStdString());
+    // like libwallet, an invalid amount is 0
+    quint64 result = 0;
+    return parseAmount(amount, result) ? result : 0;
 }
 
 quint64 WalletManager::amountFromDouble(double amount) const
@@ -299,6 +507,14 @@ bool WalletManager::addressValid(const QString &address, NetworkType::Type netty
     return Monero::Wallet::addressValid(address.toStdString(), static_cast<Monero::NetworkType>(nettype));
 }
 
+QVariantList WalletManager::validateAddresses(const QStringList &addresses, NetworkType::Type nettype) const
+{
+    const Monero::NetworkType networkType = static_cast<Monero::NetworkType>(nettype);
+    return mapIndexes<QVariant>(addresses.size(), [&addresses, networkType](int index) {
+        return QVariant(validateAddress(addresses[index], networkType));
+    });
+}
+
 bool WalletManager::keyValid(const QString &key, const QString &address, bool isViewKey,  NetworkType::Type nettype) const
 {
     std::string error;
@@ -318,7 +534,7 @@ void WalletManager::setDaemonAddressAsync(const QString &address)
 {
     m_scheduler.run([this, address] {
         m_pimpl->setDaemonAddress(address.toStdString());
-    });
+    }, FutureScheduler::Interactive, "WalletManager::setDaemonAddressAsync");
 }
 
 bool WalletManager::connected() const
@@ -363,19 +579,28 @@ void WalletManager::miningStatusAsync()
 {
     m_scheduler.run([this] {
         emit miningStatus(isMining());
-    });
+    }, FutureScheduler::Interactive, "WalletManager::miningStatusAsync");
 }
 
 bool WalletManager::startMining(const QString &address, quint32 threads, bool backgroundMining, bool ignoreBattery)
 {
     if(threads == 0)
         threads = 1;
-    return m_pimpl->startMining(address.toStdString(), threads, backgroundMining, ignoreBattery);
+    const bool result = m_pimpl->startMining(address.toStdString(), threads, backgroundMining, ignoreBattery);
+    QMetaObject::invokeMethod(m_miningMonitor, &MiningStatusMonitor::refresh, Qt::QueuedConnection);
+    return result;
 }
 
 bool WalletManager::stopMining()
 {
-    return m_pimpl->stopMining();
+    const bool result = m_pimpl->stopMining();
+    QMetaObject::invokeMethod(m_miningMonitor, &MiningStatusMonitor::refresh, Qt::QueuedConnection);
+    return result;
+}
+
+MiningStatusMonitor *WalletManager::miningMonitor() const
+{
+    return m_miningMonitor;
 }
 
 bool WalletManager::localDaemonSynced() const
@@ -388,12 +613,31 @@ bool WalletManager::isDaemonLocal(const QString &daemon_address) const
     return daemon_address.isEmpty() ? false : Monero::Utils::isAddressLocal(daemon_address.toStdString());
 }
 
+qint64 WalletManager::restoreHeightForDate(const QString &date, NetworkType::Type nettype) const
+{
+    const QDate day = QDate::fromString(date, Qt::ISODate);
+    if (!day.isValid())
+    {
+        return -1;
+    }
+    const qint64 timestamp = (day.toJulianDay() - QDate(1970, 1, 1).toJulianDay()) * 24 * 60 * 60;
+    const std::optional<quint64> height = RestoreHeightTable::instance()->height(nettype, timestamp);
+    return height ? static_cast<qint64>(*height) : -1;
+}
+
 QString WalletManager::resolveOpenAlias(const QString &address) const
 {
-    bool dnssec_valid = false;
-    std::string res = m_pimpl->resolveOpenAlias(address.toStdString(), dnssec_valid);
-    res = std::string(dnssec_valid ? "true" : "false") + "|" + res;
-    return QString::fromStdString(res);
+    return m_openAliasResolver->resolve(address);
+}
+
+void WalletManager::resolveOpenAliasAsync(const QString &address, const QJSValue &callback)
+{
+    m_openAliasResolver->resolveAsync(address, callback);
+}
+
+void WalletManager::prefetchOpenAliases(const QStringList &addresses)
+{
+    m_openAliasResolver->prefetch(addresses);
 }
 bool WalletManager::parse_uri(const QString &uri, QString &address, QString &payment_id, uint64_t &amount, QString &tx_description, QString &recipient_name, QVector<QString> &unknown_parameters, QString &error) const
 {
@@ -469,19 +713,48 @@ QUrl WalletManager::localPathToUrl(const QString &path) const
     return QUrl::fromLocalFile(path);
 }
 
-double WalletManager::getPasswordStrength(const QString &password) const
+namespace {
+
+double passwordStrength(const QString &password)
 {
     static const char *local_dict[] = {
         "monero", "fluffypony", NULL
     };
 
-    if (!ZxcvbnInit("zxcvbn.dict")) {
+    // the dictionary is compiled in (dict-src.h) unless USE_DICT_FILE is set,
+    // in that case the file is read once and kept for the process lifetime
+    static const bool dictionaryLoaded = ZxcvbnInit("zxcvbn.dict");
+    if (!dictionaryLoaded) {
         fprintf(stderr, "Failed to open zxcvbn.dict\n");
         return 0.0;
     }
-    double e = ZxcvbnMatch(password.toStdString().c_str(), local_dict, NULL);
-    ZxcvbnUnInit();
-    return e;
+    return ZxcvbnMatch(password.toUtf8().constData(), local_dict, NULL);
+}
+
+} // namespace
+
+double WalletManager::getPasswordStrength(const QString &password) const
+{
+    return passwordStrength(password);
+}
+
+void WalletManager::getPasswordStrengthAsync(const QString &password, const QJSValue &callback)
+{
+    const quint64 generation = ++m_passwordStrengthGeneration;
+    m_scheduler.run([this, password, callback, generation] {
+        // a newer keystroke superseded this one while it was queued
+        if (generation != m_passwordStrengthGeneration)
+        {
+            return;
+        }
+        const double strength = passwordStrength(password);
+        QMetaObject::invokeMethod(this, [this, strength, callback, generation] {
+            if (generation == m_passwordStrengthGeneration)
+            {
+                QJSValue(callback).call(QJSValueList({strength}));
+            }
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::Interactive, "WalletManager::getPasswordStrengthAsync");
 }
 
 bool WalletManager::saveQrCode(const QString &code, const QString &path) const
@@ -490,6 +763,52 @@ bool WalletManager::saveQrCode(const QString &code, const QString &path) const
     return QRCodeImageProvider::genQrImage(code, &size).scaled(size.expandedTo(QSize(240, 240)), Qt::KeepAspectRatio).save(path, "PNG", 100);
 }
 
+QStringList WalletManager::fountainQrFrames(const QString &path) const
+{
+    QFile file(QDir::fromNativeSeparators(path));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Failed to open" << path;
+        return {};
+    }
+
+    const FountainEncoder encoder(file.readAll());
+    // the plain fragments plus as many mixed frames, played in a loop this
+    // covers frames the camera missed without waiting for a full cycle
+    QStringList frames;
+    const quint32 count = static_cast<quint32>(encoder.fragmentCount()) * 2;
+    for (quint32 sequence = 0; sequence < count; ++sequence)
+    {
+        frames.append(encoder.frame(sequence));
+    }
+    return frames;
+}
+
+bool WalletManager::saveFountainQrData(const QByteArray &data, const QString &path) const
+{
+    QFile file(QDir::fromNativeSeparators(path));
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+QString WalletManager::fountainQrDataKind(const QByteArray &data) const
+{
+    // the version byte following the magic is left to libwallet
+    static const QList<QPair<QByteArray, QString>> kinds = {
+        {"Monero output export", "outputs"},
+        {"Monero key image export", "key_images"},
+        {"Monero unsigned tx set", "unsigned_tx"},
+        {"Monero signed tx set", "signed_tx"},
+    };
+    for (const auto &kind : kinds)
+    {
+        if (data.startsWith(kind.first))
+        {
+            return kind.second;
+        }
+    }
+    return {};
+}
+
 void WalletManager::saveQrCodeToClipboard(const QString &code) const
 {
     QClipboard *clipboard = QGuiApplication::clipboard();
@@ -523,7 +842,7 @@ void WalletManager::checkUpdatesAsync(
         {
             const QString binaryFilename = QUrl(downloadUrl).fileName();
             QPair<QString, QString> signers;
-            const QString signedHash = Updater().fetchSignedHash(binaryFilename, hashFromDns, signers).toHex();
+            const QString signedHash = m_updater.fetchSignedHash(binaryFilename, hashFromDns, signers).toHex();
 
             qInfo() << "Update found" << version << downloadUrl << "hash" << signedHash << "signed by" << signers;
             emit checkUpdatesComplete(version, downloadUrl, signedHash, signers.first, signers.second);
@@ -532,7 +851,7 @@ void WalletManager::checkUpdatesAsync(
         {
             qCritical() << "Failed to fetch and verify signed hash:" << e.what();
         }
-    });
+    }, FutureScheduler::BlockingIO, "WalletManager::checkUpdatesAsync");
 }
 
 QString WalletManager::checkUpdates(const QString &software, const QString &subdir) const
@@ -565,13 +884,36 @@ bool WalletManager::clearWalletCache(const QString &wallet_path) const
 WalletManager::WalletManager(QObject *parent)
     : QObject(parent)
     , m_passphraseReceiver(nullptr)
+    , m_passwordStrengthGeneration(0)
     , m_scheduler(this)
 {
     m_pimpl =  Monero::WalletManagerFactory::getWalletManager();
+    // hash rate and difficulty are only worth their RPCs while mining
+    m_miningMonitor = new MiningStatusMonitor([this] {
+        MiningStatusMonitor::Status status;
+        status.active = isMining();
+        if (status.active)
+        {
+            status.hashRate = m_pimpl->miningHashRate();
+            status.networkDifficulty = m_pimpl->networkDifficulty();
+        }
+        return status;
+    }, this);
+    connect(m_miningMonitor, &MiningStatusMonitor::statusUpdated, this, [this](bool active) {
+        emit miningStatus(active);
+    });
+    m_openAliasResolver = new OpenAliasResolver([this](const QString &alias) {
+        bool dnssec_valid = false;
+        std::string res = m_pimpl->resolveOpenAlias(alias.toStdString(), dnssec_valid);
+        res = std::string(dnssec_valid ? "true" : "false") + "|" + res;
+        return QString::fromStdString(res);
+    }, this);
 }
 
 WalletManager::~WalletManager()
 {
+    delete m_miningMonitor;
+    delete m_openAliasResolver;
     m_scheduler.shutdownWaitForFinished();
 }
 
@@ -609,5 +951,5 @@ void WalletManager::setProxyAddress(QString address)
             m_proxyAddress = std::move(address);
         }
         emit proxyAddressChanged();
-    });
+    }, FutureScheduler::Background, "WalletManager::setProxyAddress");
 }
@@ -29,6 +29,8 @@
 #ifndef WALLETMANAGER_H
 #define WALLETMANAGER_H
 
+#include <atomic>
+
 #include <QVariant>
 #include <QObject>
 #include <QUrl>
@@ -39,6 +41,9 @@
 #include "qt/FutureScheduler.h"
 #include "NetworkType.h"
 #include "PassphraseHelper.h"
+#include "MiningStatusMonitor.h"
+#include "OpenAliasResolver.h"
+#include "qt/updater.h"
 
 class Wallet;
 namespace Monero {
@@ -50,6 +55,7 @@ class WalletManager : public QObject, public PassprasePrompter
     Q_OBJECT
     Q_PROPERTY(bool connected READ connected)
     Q_PROPERTY(QString proxyAddress READ proxyAddress WRITE setProxyAddress NOTIFY proxyAddressChanged)
+    Q_PROPERTY(MiningStatusMonitor * miningMonitor READ miningMonitor CONSTANT)
 
 public:
     explicit WalletManager(QObject *parent = 0);
@@ -135,6 +141,10 @@ public:
 
     //! since we can't call static method from QML, move it to this class
     Q_INVOKABLE static QString displayAmount(quint64 amount);
+    //! displayAmount() without the temporary string
+    static void appendDisplayAmount(QString &out, quint64 amount);
+    //! displayAmount(amount).toDouble() without the temporary string
+    static double displayAmountToDouble(quint64 amount);
     Q_INVOKABLE static quint64 amountFromString(const QString &amount);
     Q_INVOKABLE quint64 amountFromDouble(double amount) const;
     Q_INVOKABLE static QString amountsSumFromStrings(const QVector<QString> &amounts);
@@ -145,6 +155,11 @@ public:
 
     Q_INVOKABLE bool paymentIdValid(const QString &payment_id) const;
     Q_INVOKABLE bool addressValid(const QString &address, NetworkType::Type nettype) const;
+    //! per address {address, valid, status, nettype, kind, paymentId}. Synchronous, long lists
+    //! are validated across all cores of the global thread pool while the caller waits.
+    //! status is "valid", "wrong_network" or "invalid", kind is "standard", "subaddress" or
+    //! "integrated"; nettype, kind and paymentId are left out for invalid entries
+    Q_INVOKABLE QVariantList validateAddresses(const QStringList &addresses, NetworkType::Type nettype) const;
     Q_INVOKABLE bool keyValid(const QString &key, const QString &address, bool isViewKey, NetworkType::Type nettype) const;
 
     Q_INVOKABLE QString paymentIdFromAddress(const QString &address, NetworkType::Type nettype) const;
@@ -157,7 +172,11 @@ public:
     Q_INVOKABLE double miningHashRate() const;
     Q_INVOKABLE bool localDaemonSynced() const;
     Q_INVOKABLE bool isDaemonLocal(const QString &daemon_address) const;
+    //! restore height for a "yyyy-MM-dd" date from the bundled checkpoints, -1 when
+    //! the table doesn't cover the network and the date has to be estimated
+    Q_INVOKABLE qint64 restoreHeightForDate(const QString &date, NetworkType::Type nettype) const;
 
+    //! one off check, miningMonitor pushes status changes on its own schedule
     Q_INVOKABLE void miningStatusAsync();
     Q_INVOKABLE bool startMining(const QString &address, quint32 threads, bool backgroundMining, bool ignoreBattery);
     Q_INVOKABLE bool stopMining();
@@ -175,13 +194,27 @@ public:
     Q_INVOKABLE qint64 subi(qint64 x, qint64 y) const { return x - y; }
 
     Q_INVOKABLE double getPasswordStrength(const QString &password) const;
+    //! callback(strength) runs only for the most recent call, earlier ones are dropped
+    Q_INVOKABLE void getPasswordStrengthAsync(const QString &password, const QJSValue &callback);
 
+    //! "true|address" or "false|address", the prefix tells whether DNSSEC validated. Cached.
     Q_INVOKABLE QString resolveOpenAlias(const QString &address) const;
+    //! callback(address, result) with the result of resolveOpenAlias, without blocking
+    Q_INVOKABLE void resolveOpenAliasAsync(const QString &address, const QJSValue &callback);
+    //! looks up candidate aliases concurrently so resolving them later is instant
+    Q_INVOKABLE void prefetchOpenAliases(const QStringList &addresses);
     Q_INVOKABLE bool parse_uri(const QString &uri, QString &address, QString &payment_id, uint64_t &amount, QString &tx_description, QString &recipient_name, QVector<QString> &unknown_parameters, QString &error) const;
     Q_INVOKABLE QVariantMap parse_uri_to_object(const QString &uri) const;
     Q_INVOKABLE QString make_uri(const QString &address, const quint64 &amount = 0, const QString &tx_description = "", const QString &recipient_name = "") const;
     Q_INVOKABLE bool saveQrCode(const QString &, const QString &) const;
     Q_INVOKABLE void saveQrCodeToClipboard(const QString &) const;
+    // frames of an animated QR code carrying the file, e.g. an unsigned
+    // transaction or exported key images for an air-gapped wallet
+    Q_INVOKABLE QStringList fountainQrFrames(const QString &path) const;
+    Q_INVOKABLE bool saveFountainQrData(const QByteArray &data, const QString &path) const;
+    //! "outputs", "key_images", "unsigned_tx", "signed_tx" or "" for data scanned
+    //! from an animated QR code, from libwallet's file headers
+    Q_INVOKABLE QString fountainQrDataKind(const QByteArray &data) const;
     Q_INVOKABLE void checkUpdatesAsync(
         const QString &software,
         const QString &subdir,
@@ -197,6 +230,7 @@ public:
 
     QString proxyAddress() const;
     void setProxyAddress(QString address);
+    MiningStatusMonitor *miningMonitor() const;
 
 signals:
 
@@ -228,6 +262,10 @@ private:
     QMutex m_mutex_passphraseReceiver;
     QString m_proxyAddress;
     mutable QMutex m_proxyMutex;
+    std::atomic<quint64> m_passwordStrengthGeneration;
+    MiningStatusMonitor *m_miningMonitor;
+    OpenAliasResolver *m_openAliasResolver;
+    Updater m_updater;
     FutureScheduler m_scheduler;
 };
 
@@ -0,0 +1,345 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "WalletSessionManager.h"
+#include "Wallet.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QThread>
+
+#include <wallet/api/wallet2_api.h>
+
+namespace {
+    static const int DEFAULT_MAX_CONCURRENT_REFRESHES = 2;
+    static const int DEFAULT_REFRESH_INTERVAL_SECONDS = 10;
+}
+
+WalletSessionManager::WalletSessionManager(QObject *parent)
+    : QObject(parent)
+    , m_runningRefreshes(0)
+    , m_maxConcurrentRefreshes(DEFAULT_MAX_CONCURRENT_REFRESHES)
+    , m_scheduler(this)
+{
+    m_refreshTimer.setInterval(DEFAULT_REFRESH_INTERVAL_SECONDS * 1000);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &WalletSessionManager::refreshAll);
+    m_refreshTimer.start();
+}
+
+WalletSessionManager::~WalletSessionManager()
+{
+    m_refreshTimer.stop();
+    m_scheduler.shutdownWaitForFinished();
+
+    for (const Session &session : m_sessions)
+    {
+        delete session.wallet;
+    }
+}
+
+void WalletSessionManager::openSessionAsync(
+    const QString &path,
+    const QString &password,
+    NetworkType::Type nettype,
+    const QString &daemonAddress,
+    bool trustedDaemon /* = false */,
+    const QString &proxyAddress /* = "" */,
+    quint64 kdfRounds /* = 1 */)
+{
+    if (m_sessions.contains(path))
+    {
+        emit sessionOpened(path, false, tr("Wallet is already open"));
+        return;
+    }
+
+    const auto future = m_scheduler.run([this, path, password, nettype, daemonAddress, trustedDaemon, proxyAddress, kdfRounds] {
+        Monero::WalletManager *manager = Monero::WalletManagerFactory::getWalletManager();
+        Monero::Wallet *w = manager->openWallet(path.toStdString(), password.toStdString(), static_cast<Monero::NetworkType>(nettype), kdfRounds, nullptr);
+        if (w->status() != Monero::Wallet::Status_Ok)
+        {
+            const QString error = QString::fromStdString(w->errorString());
+            manager->closeWallet(w, false);
+            QMetaObject::invokeMethod(this, [this, path, error] {
+                emit sessionOpened(path, false, error);
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        // session wallets are refreshed from the shared queue, not by their own loops
+        Wallet *wallet = new Wallet(w, nullptr, false);
+        wallet->openHistorySnapshot(password, kdfRounds);
+        if (wallet->thread() != thread())
+        {
+            wallet->moveToThread(thread());
+        }
+
+        QMetaObject::invokeMethod(this, [this, path, wallet, daemonAddress, trustedDaemon, proxyAddress] {
+            if (m_sessions.contains(path))
+            {
+                m_scheduler.run([wallet] {
+                    delete wallet;
+                }, FutureScheduler::BlockingIO, "WalletSessionManager::openSessionAsync/duplicate");
+                emit sessionOpened(path, false, tr("Wallet is already open"));
+                return;
+            }
+
+            Session session;
+            session.wallet = wallet;
+            m_sessions.insert(path, session);
+            wallet->initAsync(daemonAddress, trustedDaemon, 0, false, false, 0, proxyAddress);
+
+            emit sessionsChanged();
+            emit sessionOpened(path, true, QString());
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "WalletSessionManager::openSessionAsync");
+    if (!future.first)
+    {
+        emit sessionOpened(path, false, tr("Shutting down"));
+    }
+}
+
+void WalletSessionManager::closeSession(const QString &path)
+{
+    auto it = m_sessions.find(path);
+    if (it == m_sessions.end())
+    {
+        return;
+    }
+
+    if (it->refreshing)
+    {
+        it->closing = true;
+        return;
+    }
+    destroySession(path);
+}
+
+void WalletSessionManager::closeAll()
+{
+    for (const QString &path : m_sessions.keys())
+    {
+        closeSession(path);
+    }
+}
+
+Wallet *WalletSessionManager::wallet(const QString &path) const
+{
+    const auto it = m_sessions.constFind(path);
+    return it == m_sessions.constEnd() || it->closing ? nullptr : it->wallet;
+}
+
+bool WalletSessionManager::contains(const QString &path) const
+{
+    return m_sessions.contains(path);
+}
+
+QStringList WalletSessionManager::paths() const
+{
+    QStringList result = m_sessions.keys();
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+QVariantList WalletSessionManager::sessions() const
+{
+    QVariantList result;
+    for (const QString &path : paths())
+    {
+        const Session &session = *m_sessions.constFind(path);
+        result.append(QVariantMap{
+            {"path", path},
+            {"balance", session.wallet->balanceAll()},
+            {"unlockedBalance", session.wallet->unlockedBalanceAll()},
+            {"height", session.height},
+            {"daemonHeight", session.daemonHeight},
+            {"refreshing", session.refreshing},
+        });
+    }
+    return result;
+}
+
+QVariantMap WalletSessionManager::aggregate() const
+{
+    quint64 balance = 0;
+    quint64 unlockedBalance = 0;
+    int synced = 0;
+    int syncing = 0;
+    for (const Session &session : m_sessions)
+    {
+        balance += session.wallet->balanceAll();
+        unlockedBalance += session.wallet->unlockedBalanceAll();
+        if (session.daemonHeight > 0 && session.height >= session.daemonHeight)
+            ++synced;
+        else
+            ++syncing;
+    }
+
+    return QVariantMap{
+        {"balance", balance},
+        {"unlockedBalance", unlockedBalance},
+        {"synced", synced},
+        {"syncing", syncing},
+    };
+}
+
+void WalletSessionManager::refreshAll()
+{
+    for (auto it = m_sessions.cbegin(); it != m_sessions.cend(); ++it)
+    {
+        enqueueRefresh(it.key());
+    }
+    startRefreshes();
+}
+
+int WalletSessionManager::count() const
+{
+    return m_sessions.size();
+}
+
+int WalletSessionManager::maxConcurrentRefreshes() const
+{
+    return m_maxConcurrentRefreshes;
+}
+
+void WalletSessionManager::setMaxConcurrentRefreshes(int value)
+{
+    value = std::max(1, value);
+    if (m_maxConcurrentRefreshes != value)
+    {
+        m_maxConcurrentRefreshes = value;
+        emit maxConcurrentRefreshesChanged();
+        startRefreshes();
+    }
+}
+
+int WalletSessionManager::refreshInterval() const
+{
+    return m_refreshTimer.interval() / 1000;
+}
+
+void WalletSessionManager::setRefreshInterval(int seconds)
+{
+    seconds = std::max(1, seconds);
+    if (refreshInterval() != seconds)
+    {
+        m_refreshTimer.setInterval(seconds * 1000);
+        emit refreshIntervalChanged();
+    }
+}
+
+void WalletSessionManager::enqueueRefresh(const QString &path)
+{
+    auto it = m_sessions.find(path);
+    // m_refreshEnabled is set once the wallet connected to the daemon
+    if (it == m_sessions.end() || it->queued || it->refreshing || it->closing || !it->wallet->m_refreshEnabled)
+    {
+        return;
+    }
+
+    it->queued = true;
+    m_refreshQueue.enqueue(path);
+}
+
+void WalletSessionManager::startRefreshes()
+{
+    while (m_runningRefreshes < m_maxConcurrentRefreshes && !m_refreshQueue.isEmpty())
+    {
+        const QString path = m_refreshQueue.dequeue();
+        auto it = m_sessions.find(path);
+        if (it == m_sessions.end())
+        {
+            continue;
+        }
+        it->queued = false;
+        if (it->closing)
+        {
+            continue;
+        }
+
+        Wallet *wallet = it->wallet;
+        const auto future = m_scheduler.run([this, path, wallet] {
+            wallet->refresh(false);
+            const quint64 height = wallet->blockChainHeight();
+            const quint64 daemonHeight = wallet->daemonBlockChainHeight();
+            QMetaObject::invokeMethod(this, [this, path, height, daemonHeight] {
+                finishRefresh(path, height, daemonHeight);
+            }, Qt::QueuedConnection);
+        }, FutureScheduler::BlockingIO, "WalletSessionManager::startRefreshes");
+        if (!future.first)
+        {
+            return;
+        }
+
+        it->refreshing = true;
+        ++m_runningRefreshes;
+    }
+}
+
+void WalletSessionManager::finishRefresh(const QString &path, quint64 height, quint64 daemonHeight)
+{
+    --m_runningRefreshes;
+
+    auto it = m_sessions.find(path);
+    if (it != m_sessions.end())
+    {
+        it->refreshing = false;
+        it->height = height;
+        it->daemonHeight = daemonHeight;
+        if (it->closing)
+        {
+            destroySession(path);
+        }
+        else
+        {
+            emit sessionUpdated(path);
+        }
+    }
+
+    startRefreshes();
+}
+
+void WalletSessionManager::destroySession(const QString &path)
+{
+    const Session session = m_sessions.take(path);
+    m_refreshQueue.removeAll(path);
+
+    // ~Wallet stores the wallet cache, don't block the GUI thread on it
+    const auto future = m_scheduler.run([session] {
+        session.wallet->storeHistorySnapshot();
+        delete session.wallet;
+    }, FutureScheduler::BlockingIO, "WalletSessionManager::destroySession");
+    if (!future.first)
+    {
+        delete session.wallet;
+    }
+
+    emit sessionsChanged();
+    emit sessionClosed(path);
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef WALLETSESSIONMANAGER_H
+#define WALLETSESSIONMANAGER_H
+
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+#include <QVariantList>
+
+#include "qt/FutureScheduler.h"
+#include "NetworkType.h"
+
+class Wallet;
+
+/*!
+ * \brief Keeps several wallets open next to WalletManager's current wallet and
+ *        syncs them against one daemon. Session wallets don't run their own
+ *        refresh loops, a shared queue refreshes at most maxConcurrentRefreshes
+ *        of them at a time.
+ */
+class WalletSessionManager : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY sessionsChanged)
+    Q_PROPERTY(int maxConcurrentRefreshes READ maxConcurrentRefreshes WRITE setMaxConcurrentRefreshes NOTIFY maxConcurrentRefreshesChanged)
+    Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval NOTIFY refreshIntervalChanged)
+
+public:
+    explicit WalletSessionManager(QObject *parent = nullptr);
+    ~WalletSessionManager();
+
+    //! opens the wallet and connects it to the daemon, sessionOpened is emitted when done
+    Q_INVOKABLE void openSessionAsync(
+        const QString &path,
+        const QString &password,
+        NetworkType::Type nettype,
+        const QString &daemonAddress,
+        bool trustedDaemon = false,
+        const QString &proxyAddress = "",
+        quint64 kdfRounds = 1);
+    //! stores and closes the wallet once its running refresh, if any, finished
+    Q_INVOKABLE void closeSession(const QString &path);
+    Q_INVOKABLE void closeAll();
+
+    //! returns the open wallet, switching between sessions needs no reopen
+    Q_INVOKABLE Wallet *wallet(const QString &path) const;
+    Q_INVOKABLE bool contains(const QString &path) const;
+    Q_INVOKABLE QStringList paths() const;
+
+    //! per session: path, balance, unlockedBalance, height, daemonHeight, refreshing
+    Q_INVOKABLE QVariantList sessions() const;
+    //! totals over all sessions: balance, unlockedBalance, synced, syncing
+    Q_INVOKABLE QVariantMap aggregate() const;
+
+    //! queues a refresh of every session right away
+    Q_INVOKABLE void refreshAll();
+
+    int count() const;
+    int maxConcurrentRefreshes() const;
+    void setMaxConcurrentRefreshes(int value);
+    int refreshInterval() const;
+    void setRefreshInterval(int seconds);
+
+signals:
+    void sessionOpened(const QString &path, bool success, const QString &errorString);
+    void sessionClosed(const QString &path);
+    void sessionUpdated(const QString &path);
+    void sessionsChanged();
+    void maxConcurrentRefreshesChanged();
+    void refreshIntervalChanged();
+
+private:
+    struct Session
+    {
+        Wallet *wallet = nullptr;
+        bool queued = false;
+        bool refreshing = false;
+        bool closing = false;
+        quint64 height = 0;
+        quint64 daemonHeight = 0;
+    };
+
+    void enqueueRefresh(const QString &path);
+    void startRefreshes();
+    void finishRefresh(const QString &path, quint64 height, quint64 daemonHeight);
+    void destroySession(const QString &path);
+
+private:
+    QHash<QString, Session> m_sessions;
+    QQueue<QString> m_refreshQueue;
+    int m_runningRefreshes;
+    int m_maxConcurrentRefreshes;
+    QTimer m_refreshTimer;
+    FutureScheduler m_scheduler;
+};
+
+#endif // WALLETSESSIONMANAGER_H
@@ -28,6 +28,12 @@
 
 #include "Logger.h"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
 #include <QCoreApplication>
 #include <QStandardPaths>
 #include <QFileInfo>
@@ -92,10 +98,18 @@ const QString getLogPath(const QString &userDefinedLogFilePath, bool portable)
 }
 
 
-// custom messageHandler that foward all messages to easylogging
-void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+namespace
+{
+
+// messages queued for the writer thread before new ones are dropped
+constexpr size_t LOG_QUEUE_CAPACITY = 8192;
+// debug and info messages accepted per category and second, warnings and errors are never limited
+constexpr int LOG_RATE_LIMIT_PER_SECOND = 200;
+constexpr size_t LOG_CATEGORY_SLOTS = 64;
+constexpr int LOG_DROP_REPORT_INTERVAL_MS = 1000;
+
+void writeMessage(QtMsgType type, const QString &message)
 {
-    (void) context; // context isn't used in release builds
     const std::string cat = "frontend"; // category displayed in the log
     const std::string msg = message.toStdString();
     switch(type)
@@ -108,22 +122,311 @@ void messageHandler(QtMsgType type, const QMessageLogContext &context, const QSt
     }
 }
 
-Logger::Logger(QCoreApplication &parent, QString userDefinedLogFilePath)
+qint64 currentSecond()
+{
+    using namespace std::chrono;
+    return duration_cast<seconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Hands messages from any thread to a single writer thread. Producers never block,
+// the queue is a bounded lock-free ring and messages that don't fit are counted and dropped.
+class LogSink
+{
+public:
+    LogSink()
+        : m_cells(LOG_QUEUE_CAPACITY)
+        , m_enqueuePos(0)
+        , m_dequeuePos(0)
+        , m_published(0)
+        , m_queueDropped(0)
+        , m_running(false)
+    {
+        static_assert((LOG_QUEUE_CAPACITY & (LOG_QUEUE_CAPACITY - 1)) == 0, "capacity must be a power of two");
+        for (size_t i = 0; i < m_cells.size(); ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    void start()
+    {
+        if (!m_running.exchange(true))
+        {
+            m_writer = std::thread([this] { run(); });
+        }
+    }
+
+    void stop()
+    {
+        if (m_running.exchange(false))
+        {
+            m_published.fetch_add(1, std::memory_order_release);
+            m_published.notify_one();
+            m_writer.join();
+            // messages that raced with stopping the writer
+            drain();
+        }
+    }
+
+    void post(QtMsgType type, const char *category, const QString &message)
+    {
+        if (!m_running.load(std::memory_order_acquire) || type == QtFatalMsg)
+        {
+            // the application aborts right after a fatal message, write it in place
+            flush();
+            writeMessage(type, message);
+            return;
+        }
+
+        if ((type == QtDebugMsg || type == QtInfoMsg) && !acquire(category))
+        {
+            return;
+        }
+
+        if (!tryEnqueue(type, message))
+        {
+            m_queueDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_published.fetch_add(1, std::memory_order_release);
+        m_published.notify_one();
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        QtMsgType type;
+        QString message;
+    };
+
+    struct Category
+    {
+        std::atomic<const char *> name{nullptr};
+        std::atomic<qint64> second{0};
+        std::atomic<int> count{0};
+        std::atomic<quint64> dropped{0};
+    };
+
+    // Per category fixed window limit, categories are identified by the address of
+    // their name which QLoggingCategory keeps alive for the lifetime of the process
+    bool acquire(const char *category)
+    {
+        Category &slot = categorySlot(category);
+
+        const qint64 now = currentSecond();
+        qint64 second = slot.second.load(std::memory_order_relaxed);
+        if (second != now && slot.second.compare_exchange_strong(second, now, std::memory_order_relaxed))
+        {
+            slot.count.store(0, std::memory_order_relaxed);
+        }
+
+        if (slot.count.fetch_add(1, std::memory_order_relaxed) < LOG_RATE_LIMIT_PER_SECOND)
+        {
+            return true;
+        }
+
+        slot.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Category &categorySlot(const char *category)
+    {
+        const size_t hash = std::hash<const void *>()(category);
+        for (size_t probe = 0; probe < LOG_CATEGORY_SLOTS; ++probe)
+        {
+            Category &slot = m_categories[(hash + probe) % LOG_CATEGORY_SLOTS];
+            const char *name = slot.name.load(std::memory_order_acquire);
+            if (name == category)
+            {
+                return slot;
+            }
+            if (name == nullptr && slot.name.compare_exchange_strong(name, category, std::memory_order_acq_rel))
+            {
+                return slot;
+            }
+            // lost the race for an empty slot, it may have been claimed for this category
+            if (name == category)
+            {
+                return slot;
+            }
+        }
+        // table is full, the remaining categories share one budget
+        return m_overflowCategory;
+    }
+
+    bool tryEnqueue(QtMsgType type, const QString &message)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = m_cells[pos & (LOG_QUEUE_CAPACITY - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.type = type;
+                    cell.message = message;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // single consumer, only called from the writer thread or while it is stopped
+    bool tryDequeue(QtMsgType &type, QString &message)
+    {
+        const size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = m_cells[pos & (LOG_QUEUE_CAPACITY - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+        {
+            return false;
+        }
+
+        type = cell.type;
+        message = std::move(cell.message);
+        cell.message = QString();
+        m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        cell.sequence.store(pos + LOG_QUEUE_CAPACITY, std::memory_order_release);
+        return true;
+    }
+
+    void drain()
+    {
+        QtMsgType type;
+        QString message;
+        while (tryDequeue(type, message))
+        {
+            writeMessage(type, message);
+        }
+    }
+
+    // waits until the writer has caught up with everything queued so far
+    void flush()
+    {
+        if (!m_running.load(std::memory_order_acquire) || std::this_thread::get_id() == m_writer.get_id())
+        {
+            return;
+        }
+
+        const size_t target = m_enqueuePos.load(std::memory_order_acquire);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (m_dequeuePos.load(std::memory_order_relaxed) < target && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void reportDropped()
+    {
+        const quint64 queueDropped = m_queueDropped.exchange(0, std::memory_order_relaxed);
+        if (queueDropped > 0)
+        {
+            writeMessage(QtWarningMsg, QString("Logger: dropped %1 messages, log queue full").arg(queueDropped));
+        }
+
+        auto report = [](Category &slot) {
+            const quint64 dropped = slot.dropped.exchange(0, std::memory_order_relaxed);
+            const char *name = slot.name.load(std::memory_order_acquire);
+            if (dropped > 0)
+            {
+                writeMessage(QtWarningMsg, QString("Logger: dropped %1 messages from category %2, rate limited")
+                    .arg(dropped)
+                    .arg(QString::fromLatin1(name ? name : "other")));
+            }
+        };
+        for (Category &slot : m_categories)
+        {
+            report(slot);
+        }
+        report(m_overflowCategory);
+    }
+
+    void run()
+    {
+        auto nextReport = std::chrono::steady_clock::now();
+        quint64 seen = m_published.load(std::memory_order_acquire);
+        while (m_running.load(std::memory_order_acquire))
+        {
+            drain();
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= nextReport)
+            {
+                reportDropped();
+                nextReport = now + std::chrono::milliseconds(LOG_DROP_REPORT_INTERVAL_MS);
+            }
+
+            m_published.wait(seen, std::memory_order_acquire);
+            seen = m_published.load(std::memory_order_acquire);
+        }
+
+        drain();
+        reportDropped();
+    }
+
+    std::vector<Cell> m_cells;
+    std::atomic<size_t> m_enqueuePos;
+    std::atomic<size_t> m_dequeuePos;
+    std::atomic<quint64> m_published;
+    std::atomic<quint64> m_queueDropped;
+    std::atomic<bool> m_running;
+    Category m_categories[LOG_CATEGORY_SLOTS];
+    Category m_overflowCategory;
+    std::thread m_writer;
+};
+
+LogSink &logSink()
+{
+    // intentionally leaked, messages may still be logged during static destruction
+    static LogSink *sink = new LogSink();
+    return *sink;
+}
+
+} // namespace
+
+// custom messageHandler that foward all messages to easylogging through the log sink
+void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    logSink().post(type, context.category ? context.category : "default", message);
+}
+
+Logger::Logger(QCoreApplication &parent, QString userDefinedLogFilePath, bool consoleOutput /* = true */)
     : QObject(&parent)
     , m_applicationFilePath(parent.applicationFilePath().toStdString())
     , m_userDefinedLogFilePath(std::move(userDefinedLogFilePath))
+    , m_consoleOutput(consoleOutput)
 {
     el::Configurations c;
     c.setGlobally(el::ConfigurationType::ToFile, "false");
-    c.setGlobally(el::ConfigurationType::ToStandardOutput, "true");
+    c.setGlobally(el::ConfigurationType::ToStandardOutput, consoleOutput ? "true" : "false");
     el::Loggers::setDefaultConfigurations(c, true);
     qInstallMessageHandler(messageHandler);
+    logSink().start();
+}
+
+Logger::~Logger()
+{
+    // later messages are written synchronously
+    logSink().stop();
 }
 
 void Logger::resetLogFilePath(bool portable)
 {
     m_logFilePath = QDir::toNativeSeparators(getLogPath(m_userDefinedLogFilePath, portable));
-    Monero::Wallet::init(m_applicationFilePath.c_str(), "monero-wallet-gui", m_logFilePath.toStdString(), true);
+    Monero::Wallet::init(m_applicationFilePath.c_str(), "monero-wallet-gui", m_logFilePath.toStdString(), m_consoleOutput);
     qWarning() << "Logging to" << m_logFilePath;
     emit logFilePathChanged();
 }
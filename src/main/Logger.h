@@ -38,7 +38,9 @@ class Logger : public QObject
     Q_PROPERTY(QString logFilePath READ logFilePath NOTIFY logFilePathChanged)
 
 public:
-    Logger(QCoreApplication &parent, QString userDefinedLogFilePath);
+    //! consoleOutput false keeps stdout free, e.g. for the wallet monitor's stream
+    Logger(QCoreApplication &parent, QString userDefinedLogFilePath, bool consoleOutput = true);
+    ~Logger();
 
     Q_INVOKABLE void resetLogFilePath(bool portable);
     QString logFilePath() const;
@@ -50,4 +52,5 @@ private:
     const std::string m_applicationFilePath;
     QString m_logFilePath;
     const QString m_userDefinedLogFilePath;
+    const bool m_consoleOutput;
 };
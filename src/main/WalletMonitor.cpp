@@ -0,0 +1,363 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "WalletMonitor.h"
+
+#include <cstdio>
+#include <utility>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include "TransactionHistory.h"
+#include "TransactionHistoryStore.h"
+#include "TransactionInfo.h"
+#include "Wallet.h"
+
+namespace
+{
+
+const QHash<QString, NetworkType::Type> NETTYPES = {
+    {"mainnet", NetworkType::MAINNET},
+    {"testnet", NetworkType::TESTNET},
+    {"stagenet", NetworkType::STAGENET},
+};
+
+// a mined, failed or edited row is reported, a confirmation tick is not
+constexpr quint32 REPORTED_CHANGES = ~static_cast<quint32>(TransactionHistoryStore::ChangedConfirmations);
+
+QString amountString(quint64 amount)
+{
+    return QString::number(amount);
+}
+
+} // namespace
+
+WalletMonitor::WalletMonitor(QObject *parent)
+    : QObject(parent)
+    , m_scheduler(this)
+{
+    connect(&m_sessions, &WalletSessionManager::sessionOpened, this, &WalletMonitor::sessionOpened);
+    connect(&m_sessions, &WalletSessionManager::sessionUpdated, this, &WalletMonitor::sessionUpdated);
+}
+
+WalletMonitor::~WalletMonitor()
+{
+    // history refreshes use the session wallets, which go with m_sessions
+    m_scheduler.shutdownWaitForFinished();
+}
+
+bool WalletMonitor::load(const QString &configPath, QString &error)
+{
+    QFile file(configPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        error = QString("failed to open %1: %2").arg(configPath, file.errorString());
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonObject config = QJsonDocument::fromJson(file.readAll(), &parseError).object();
+    if (parseError.error != QJsonParseError::NoError)
+    {
+        error = QString("failed to parse %1: %2").arg(configPath, parseError.errorString());
+        return false;
+    }
+
+    if (config.contains("refreshInterval"))
+    {
+        m_sessions.setRefreshInterval(config.value("refreshInterval").toInt());
+    }
+    if (config.contains("maxConcurrentRefreshes"))
+    {
+        m_sessions.setMaxConcurrentRefreshes(config.value("maxConcurrentRefreshes").toInt());
+    }
+
+    // wallets inherit the top level daemon settings
+    for (const QJsonValue &value : config.value("wallets").toArray())
+    {
+        const QJsonObject entry = value.toObject();
+        const auto setting = [&entry, &config](const char *key) {
+            return entry.contains(key) ? entry.value(key) : config.value(key);
+        };
+
+        const QString path = entry.value("path").toString();
+        if (path.isEmpty())
+        {
+            error = "wallet without a path";
+            return false;
+        }
+
+        Watched watched;
+        watched.password = entry.value("password").toString();
+        if (entry.contains("passwordFile"))
+        {
+            QFile passwordFile(entry.value("passwordFile").toString());
+            if (!passwordFile.open(QIODevice::ReadOnly))
+            {
+                error = QString("failed to read the password of %1: %2").arg(path, passwordFile.errorString());
+                return false;
+            }
+            watched.password = QString::fromUtf8(passwordFile.readAll()).trimmed();
+        }
+
+        const QString nettype = setting("nettype").toString("mainnet");
+        if (!NETTYPES.contains(nettype))
+        {
+            error = QString("unknown nettype %1 for %2").arg(nettype, path);
+            return false;
+        }
+        watched.nettype = NETTYPES.value(nettype);
+        watched.daemonAddress = setting("daemon").toString();
+        watched.trustedDaemon = setting("trusted").toBool();
+        watched.proxyAddress = setting("proxy").toString();
+        watched.accountIndex = static_cast<quint32>(entry.value("account").toInt());
+        m_wallets.insert(path, watched);
+    }
+
+    if (m_wallets.isEmpty())
+    {
+        error = QString("no wallets in %1").arg(configPath);
+        return false;
+    }
+    return true;
+}
+
+void WalletMonitor::start()
+{
+    for (auto it = m_wallets.cbegin(); it != m_wallets.cend(); ++it)
+    {
+        const Watched &watched = it.value();
+        m_sessions.openSessionAsync(it.key(), watched.password, watched.nettype, watched.daemonAddress, watched.trustedDaemon, watched.proxyAddress);
+    }
+}
+
+void WalletMonitor::sessionOpened(const QString &path, bool success, const QString &errorString)
+{
+    auto it = m_wallets.find(path);
+    if (it == m_wallets.end())
+    {
+        return;
+    }
+    // the password is not needed once the wallet is open
+    it->password.clear();
+
+    writeLine({
+        {"event", "opened"},
+        {"wallet", path},
+        {"success", success},
+        {"error", errorString},
+    });
+
+    Wallet *wallet = success ? m_sessions.wallet(path) : nullptr;
+    if (!wallet)
+    {
+        return;
+    }
+    it->wallet = wallet;
+    watchHistory(path, wallet);
+}
+
+void WalletMonitor::sessionUpdated(const QString &path)
+{
+    auto it = m_wallets.find(path);
+    if (it == m_wallets.end() || !it->wallet)
+    {
+        return;
+    }
+
+    quint64 height = 0;
+    quint64 daemonHeight = 0;
+    for (const QVariant &session : m_sessions.sessions())
+    {
+        const QVariantMap fields = session.toMap();
+        if (fields.value("path").toString() == path)
+        {
+            height = fields.value("height").toULongLong();
+            daemonHeight = fields.value("daemonHeight").toULongLong();
+            break;
+        }
+    }
+
+    const quint64 balance = it->wallet->balanceAll();
+    const quint64 unlockedBalance = it->wallet->unlockedBalanceAll();
+    const bool balancesChanged = balance != it->balance || unlockedBalance != it->unlockedBalance;
+    if (balancesChanged || height != it->height || daemonHeight != it->daemonHeight)
+    {
+        it->balance = balance;
+        it->unlockedBalance = unlockedBalance;
+        it->height = height;
+        it->daemonHeight = daemonHeight;
+        writeLine({
+            {"event", "status"},
+            {"wallet", path},
+            {"balance", amountString(balance)},
+            {"unlockedBalance", amountString(unlockedBalance)},
+            {"height", static_cast<qint64>(height)},
+            {"daemonHeight", static_cast<qint64>(daemonHeight)},
+            {"synchronized", daemonHeight > 0 && height >= daemonHeight},
+        });
+    }
+
+    if (balancesChanged)
+    {
+        it->historyDirty = true;
+    }
+    refreshHistory(path);
+}
+
+void WalletMonitor::watchHistory(const QString &path, Wallet *wallet)
+{
+    TransactionHistory *history = wallet->history();
+
+    // rows are inserted in one block per refresh, reported once they're readable
+    connect(history, &TransactionHistory::transactionsAboutToBeInserted, this, [this, path](int first, int last) {
+        auto it = m_wallets.find(path);
+        if (it != m_wallets.end())
+        {
+            it->insertFirst = first;
+            it->insertLast = last;
+        }
+    });
+    connect(history, &TransactionHistory::transactionsInserted, this, [this, path] {
+        auto it = m_wallets.find(path);
+        if (it != m_wallets.end() && it->insertFirst >= 0)
+        {
+            const int first = std::exchange(it->insertFirst, -1);
+            const int last = std::exchange(it->insertLast, -1);
+            writeRows("transaction", path, first, last);
+        }
+    });
+    connect(history, &TransactionHistory::transactionsChanged, this, [this, path](int first, int last, quint32 changedFields) {
+        if (changedFields & REPORTED_CHANGES)
+        {
+            writeRows("transactionChanged", path, first, last, changedFields);
+        }
+    });
+
+    // pool transfers don't move the balance yet
+    const auto markDirty = [this, path] {
+        auto it = m_wallets.find(path);
+        if (it != m_wallets.end())
+        {
+            it->historyDirty = true;
+        }
+    };
+    connect(wallet, &Wallet::moneySpent, this, markDirty);
+    connect(wallet, &Wallet::moneyReceived, this, markDirty);
+    connect(wallet, &Wallet::unconfirmedMoneyReceived, this, markDirty);
+}
+
+void WalletMonitor::refreshHistory(const QString &path)
+{
+    auto it = m_wallets.find(path);
+    if (it == m_wallets.end() || !it->wallet || !it->historyDirty || it->historyRefreshing)
+    {
+        return;
+    }
+
+    TransactionHistory *history = it->wallet->history();
+    const quint32 accountIndex = it->accountIndex;
+    const auto future = m_scheduler.run([this, path, history, accountIndex] {
+        history->refresh(accountIndex);
+        QMetaObject::invokeMethod(this, [this, path] {
+            auto it = m_wallets.find(path);
+            if (it != m_wallets.end())
+            {
+                it->historyRefreshing = false;
+            }
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::Background, "WalletMonitor::refreshHistory");
+    if (future.first)
+    {
+        it->historyDirty = false;
+        it->historyRefreshing = true;
+    }
+}
+
+void WalletMonitor::writeRows(const char *event, const QString &path, int first, int last, quint32 changedFields /* = 0 */)
+{
+    const auto it = m_wallets.constFind(path);
+    if (it == m_wallets.constEnd() || !it->wallet)
+    {
+        return;
+    }
+
+    const TransactionHistoryStore &rows = it->wallet->history()->rows();
+    for (int index = first; index <= last && index < rows.size(); ++index)
+    {
+        // the history holds every account, only the watched one is reported
+        if (rows.subaddrAccount(index) != it->accountIndex)
+        {
+            continue;
+        }
+        QJsonObject line = row(rows, index);
+        line.insert("event", event);
+        line.insert("wallet", path);
+        if (changedFields != 0)
+        {
+            line.insert("changedFields", static_cast<qint64>(changedFields));
+        }
+        writeLine(line);
+    }
+}
+
+QJsonObject WalletMonitor::row(const TransactionHistoryStore &rows, int index) const
+{
+    QJsonArray subaddresses;
+    for (int i = 0; i < rows.subaddrIndexCount(index); ++i)
+    {
+        subaddresses.append(static_cast<qint64>(rows.subaddrIndex(index, i)));
+    }
+
+    return {
+        {"hash", rows.hash(index)},
+        {"direction", rows.direction(index) == TransactionInfo::Direction_In ? "in" : "out"},
+        {"amount", amountString(rows.amount(index))},
+        {"fee", amountString(rows.fee(index))},
+        {"blockHeight", static_cast<qint64>(rows.blockHeight(index))},
+        {"timestamp", rows.timestamp(index)},
+        {"pending", rows.isPending(index)},
+        {"failed", rows.isFailed(index)},
+        {"account", static_cast<qint64>(rows.subaddrAccount(index))},
+        {"subaddresses", subaddresses},
+        {"paymentId", rows.paymentId(index)},
+    };
+}
+
+void WalletMonitor::writeLine(const QJsonObject &line) const
+{
+    // one object per line, flushed so a reading pipe sees it right away
+    const QByteArray json = QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n';
+    std::fwrite(json.constData(), 1, json.size(), stdout);
+    std::fflush(stdout);
+}
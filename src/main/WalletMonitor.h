@@ -0,0 +1,100 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef WALLETMONITOR_H
+#define WALLETMONITOR_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+
+#include "WalletSessionManager.h"
+#include "qt/FutureScheduler.h"
+#include "NetworkType.h"
+
+class TransactionHistoryStore;
+class Wallet;
+
+/*!
+ * \brief Watches the wallets of a JSON config without any UI and writes one JSON
+ *        object per line to stdout: "opened", "status" whenever balances or
+ *        heights move, "transaction" for new history rows and
+ *        "transactionChanged" for rows that got mined, failed or were edited.
+ *        Amounts are strings of atomic units.
+ */
+class WalletMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WalletMonitor(QObject *parent = nullptr);
+    ~WalletMonitor();
+
+    //! reads the config, sets error and returns false if it can't be used
+    bool load(const QString &configPath, QString &error);
+    //! opens every configured wallet, the monitor runs until the application quits
+    void start();
+
+private:
+    struct Watched
+    {
+        QString password;
+        NetworkType::Type nettype = NetworkType::MAINNET;
+        QString daemonAddress;
+        bool trustedDaemon = false;
+        QString proxyAddress;
+        quint32 accountIndex = 0;
+
+        Wallet *wallet = nullptr;
+        quint64 balance = 0;
+        quint64 unlockedBalance = 0;
+        quint64 height = 0;
+        quint64 daemonHeight = 0;
+        // set by transfers seen by the wallet listener, the history is only reread then
+        bool historyDirty = true;
+        bool historyRefreshing = false;
+        int insertFirst = -1;
+        int insertLast = -1;
+    };
+
+    void sessionOpened(const QString &path, bool success, const QString &errorString);
+    void sessionUpdated(const QString &path);
+    void watchHistory(const QString &path, Wallet *wallet);
+    void refreshHistory(const QString &path);
+    void writeRows(const char *event, const QString &path, int first, int last, quint32 changedFields = 0);
+    QJsonObject row(const TransactionHistoryStore &rows, int index) const;
+    void writeLine(const QJsonObject &line) const;
+
+private:
+    QHash<QString, Watched> m_wallets;
+    WalletSessionManager m_sessions;
+    FutureScheduler m_scheduler;
+};
+
+#endif // WALLETMONITOR_H
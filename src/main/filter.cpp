@@ -27,14 +27,91 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "filter.h"
+#include <QDateTime>
+#include <QHash>
 #include <QKeyEvent>
 #include <QDebug>
 
+namespace {
+
+constexpr qint64 activitySignalIntervalMs = 1000;
+
+int combined(Qt::KeyboardModifiers modifiers, int key)
+{
+    return modifiers.toInt() | key;
+}
+
+// the shortcuts main.qml handles, every other key press stays in C++
+const QHash<int, QString> &pressShortcuts()
+{
+    static const QHash<int, QString> shortcuts = {
+        {combined(Qt::ControlModifier, Qt::Key_L), QStringLiteral("Ctrl+L")},
+        {combined(Qt::ControlModifier, Qt::Key_S), QStringLiteral("Ctrl+S")},
+        {combined(Qt::ControlModifier, Qt::Key_R), QStringLiteral("Ctrl+R")},
+        {combined(Qt::ControlModifier, Qt::Key_H), QStringLiteral("Ctrl+H")},
+        {combined(Qt::ControlModifier, Qt::Key_B), QStringLiteral("Ctrl+B")},
+        {combined(Qt::ControlModifier, Qt::Key_E), QStringLiteral("Ctrl+E")},
+        {combined(Qt::ControlModifier, Qt::Key_D), QStringLiteral("Ctrl+D")},
+        {combined(Qt::ControlModifier, Qt::Key_T), QStringLiteral("Ctrl+T")},
+        {combined(Qt::ControlModifier, Qt::Key_Tab), QStringLiteral("Ctrl+Tab")},
+        {combined(Qt::ControlModifier | Qt::ShiftModifier, Qt::Key_Backtab), QStringLiteral("Ctrl+Shift+Backtab")},
+        {combined(Qt::ControlModifier | Qt::ShiftModifier, Qt::Key_P), QStringLiteral("Ctrl+Shift+P")},
+#ifdef Q_OS_MAC
+        // Alt+Tab belongs to the window manager elsewhere
+        {combined(Qt::AltModifier, Qt::Key_Tab), QStringLiteral("Alt+Tab")},
+        {combined(Qt::AltModifier | Qt::ShiftModifier, Qt::Key_Backtab), QStringLiteral("Alt+Shift+Backtab")},
+#endif
+    };
+    return shortcuts;
+}
+
+// Ctrl on its own, as main.qml tracks it to show shortcut hints
+bool isCtrlKey(int key)
+{
+#ifdef Q_OS_MAC
+    return key == Qt::Key_Control || key == Qt::Key_Meta;
+#else
+    return key == Qt::Key_Control;
+#endif
+}
+
+int shortcutKey(const QKeyEvent *ke)
+{
+    Qt::KeyboardModifiers modifiers = ke->modifiers() & (Qt::ControlModifier | Qt::ShiftModifier | Qt::AltModifier | Qt::MetaModifier);
+#ifdef Q_OS_MAC
+    if (modifiers & Qt::MetaModifier) {
+        modifiers &= ~Qt::MetaModifier;
+        modifiers |= Qt::ControlModifier;
+    }
+#endif
+    return combined(modifiers, ke->key());
+}
+
+} // namespace
+
 filter::filter(QObject *parent) :
     QObject(parent)
 {
     m_tabPressed = false;
     m_backtabPressed = false;
+    m_lastActivity = QDateTime::currentMSecsSinceEpoch();
+    m_lastActivitySignal = 0;
+}
+
+qint64 filter::lastActivity() const
+{
+    return m_lastActivity;
+}
+
+void filter::registerActivity()
+{
+    // a key press passes the filter once per receiver, a burst of typing is one activity
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_lastActivity = now;
+    if (now - m_lastActivitySignal >= activitySignalIntervalMs) {
+        m_lastActivitySignal = now;
+        emit userActivity();
+    }
 }
 
 bool filter::eventFilter(QObject *obj, QEvent *ev) {
@@ -46,7 +123,7 @@ bool filter::eventFilter(QObject *obj, QEvent *ev) {
     }
 
     if(ev->type() == QEvent::KeyPress || ev->type() == QEvent::MouseButtonRelease){
-        emit userActivity();
+        registerActivity();
     }
 
     switch(ev->type()) {
@@ -64,24 +141,14 @@ bool filter::eventFilter(QObject *obj, QEvent *ev) {
             else m_tabPressed = true;
         }
 
-        QString sks;
-        if(ke->key() == Qt::Key_Control) {
-            sks = "Ctrl";
-#ifdef Q_OS_MAC
-        } else if(ke->key() == Qt::Key_Meta) {
-            sks = "Ctrl";
-#endif
-        } else {
-            QKeySequence ks(ke->modifiers() | ke->key());
-            sks = ks.toString();
-        }
-#ifndef Q_OS_MAC
-        if(sks.contains("Alt+Tab") || sks.contains("Alt+Backtab"))
+        if(isCtrlKey(ke->key())) {
+            emit sequencePressed(QVariant::fromValue<QObject*>(obj), QStringLiteral("Ctrl"));
             break;
-#else
-        sks.replace("Meta", "Ctrl");
-#endif
-        emit sequencePressed(QVariant::fromValue<QObject*>(obj), sks);
+        }
+
+        const auto shortcut = pressShortcuts().constFind(shortcutKey(ke));
+        if(shortcut != pressShortcuts().constEnd())
+            emit sequencePressed(QVariant::fromValue<QObject*>(obj), *shortcut);
     } break;
     case QEvent::KeyRelease: {
         QKeyEvent *ke = static_cast<QKeyEvent*>(ev);
@@ -92,30 +159,16 @@ bool filter::eventFilter(QObject *obj, QEvent *ev) {
         if(ke->key() == Qt::Key_Tab)
             m_tabPressed = false;
 
-        QString sks;
 #ifdef Q_OS_ANDROID
         if(ke->key() == Qt::Key_Back) {
             qDebug() << "Android back hit";
-            sks = "android_back";
-        }
-#endif
-        if(ke->key() == Qt::Key_Control) {
-            sks = "Ctrl";
-#ifdef Q_OS_MAC
-        } else if(ke->key() == Qt::Key_Meta) {
-            sks = "Ctrl";
-#endif
-        } else {
-            QKeySequence ks(ke->modifiers() | ke->key());
-            sks = ks.toString();
-        }
-#ifndef Q_OS_MAC
-        if(sks.contains("Alt+Tab") || sks.contains("Alt+Backtab"))
+            emit sequenceReleased(QVariant::fromValue<QObject*>(obj), QStringLiteral("android_back"));
             break;
-#else
-        sks.replace("Meta", "Ctrl");
+        }
 #endif
-        emit sequenceReleased(QVariant::fromValue<QObject*>(obj), sks);
+        // releasing Ctrl is the only release main.qml reacts to
+        if(isCtrlKey(ke->key()))
+            emit sequenceReleased(QVariant::fromValue<QObject*>(obj), QStringLiteral("Ctrl"));
     } break;
     case QEvent::MouseButtonPress: {
         QMouseEvent *me = static_cast<QMouseEvent*>(ev);
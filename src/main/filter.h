@@ -29,17 +29,28 @@
 #ifndef FILTER_H
 #define FILTER_H
 
+#include <atomic>
+
 #include <QObject>
 
+class QKeyEvent;
+
 class filter : public QObject
 {
     Q_OBJECT
 private:
     bool m_tabPressed;
     bool m_backtabPressed;
+    std::atomic<qint64> m_lastActivity;
+    qint64 m_lastActivitySignal;
+
+    void registerActivity();
 public:
     explicit filter(QObject *parent = 0);
 
+    //! msecs since epoch of the last key press or mouse release, callable from any thread
+    qint64 lastActivity() const;
+
 protected:
     bool eventFilter(QObject *obj, QEvent *ev);
 
@@ -48,6 +59,7 @@ signals:
     void sequenceReleased(const QVariant &o, const QVariant &seq);
     void mousePressed(const QVariant &o, const QVariant &x, const QVariant &y);
     void mouseReleased(const QVariant &o, const QVariant &x, const QVariant &y);
+    // at most once a second, lastActivity() has the exact time
     void userActivity();
     void uriHandler(const QUrl &url);
 };
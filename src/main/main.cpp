@@ -28,6 +28,7 @@
 
 #include <QApplication>
 #include <QQmlApplicationEngine>
+#include <QQuickWindow>
 #include <QtQml>
 #include <QStandardPaths>
 #include <QIcon>
@@ -37,6 +38,10 @@
 #include <QScreen>
 #include <QThread>
 
+#include <csignal>
+#include <cstdio>
+#include <memory>
+
 #include <version.h>
 
 #include "clipboardAdapter.h"
@@ -44,6 +49,7 @@
 #include "oscursor.h"
 #include "oshelper.h"
 #include "WalletManager.h"
+#include "WalletSessionManager.h"
 #include "Wallet.h"
 #include "QRCodeImageProvider.h"
 #include "PendingTransaction.h"
@@ -53,6 +59,8 @@
 #include "TransactionHistory.h"
 #include "model/TransactionHistoryModel.h"
 #include "model/TransactionHistorySortFilterModel.h"
+#include "model/TransactionHistoryAggregateModel.h"
+#include "model/LogViewModel.h"
 #include "AddressBook.h"
 #include "model/AddressBookModel.h"
 #include "Subaddress.h"
@@ -61,14 +69,23 @@
 #include "model/SubaddressAccountModel.h"
 #include "Logger.h"
 #include "MainApp.h"
+#include "WalletMonitor.h"
 #include "qt/downloader.h"
 #include "qt/ipc.h"
 #include "qt/network.h"
+#include "qt/NetworkStats.h"
+#include "qt/RemoteNodeSelector.h"
 #include "qt/updater.h"
 #include "qt/utils.h"
 #include "qt/TailsOS.h"
 #include "qt/KeysFiles.h"
 #include "qt/MoneroSettings.h"
+#include "qt/EventTrace.h"
+#include "qt/PerformanceMonitor.h"
+#include "qt/RenderBackendProbe.h"
+#include "qt/SchedulerStats.h"
+#include "qt/BackgroundSyncPolicy.h"
+#include "qt/StartupTrace.h"
 #include "qt/NetworkAccessBlockingFactory.h"
 #ifdef Q_OS_MAC
 #include "qt/macoshelper.h"
@@ -80,9 +97,7 @@
 #include "p2pool/P2PoolManager.h"
 #endif
 
-#if defined(Q_OS_WIN)
-#include <QOpenGLContext>
-#elif defined(Q_OS_MACOS)
+#if defined(Q_OS_MACOS)
 #include "qt/macoshelper.h"
 #endif
 
@@ -157,8 +172,74 @@ bool isDesktop = false;
 bool isOpenGL = true;
 bool isARM = false;
 
+namespace
+{
+
+volatile std::sig_atomic_t quitRequested = 0;
+
+bool hasArgument(int argc, char *argv[], const char *name)
+{
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], name) == 0 || QByteArray(argv[i]).startsWith(QByteArray(name) + "="))
+            return true;
+    }
+    return false;
+}
+
+// headless: no QApplication, QML engine or window, only the wallets in the config
+int runWalletMonitor(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("monero-core");
+    app.setOrganizationDomain("getmonero.org");
+    app.setOrganizationName("monero-project");
+
+    QCommandLineParser parser;
+    QCommandLineOption walletMonitorOption("wallet-monitor", "Watch the wallets listed in <config> without a window and write their status and new transactions to stdout as JSON lines.", "config");
+    QCommandLineOption logPathOption(QStringList() << "l" << "log-file",
+        QCoreApplication::translate("main", "Log to specified file"),
+        QCoreApplication::translate("main", "file"));
+    parser.addOption(walletMonitorOption);
+    parser.addOption(logPathOption);
+    parser.addHelpOption();
+    parser.process(app);
+
+    Monero::Utils::onStartup();
+
+    // stdout carries the JSON lines, the log only goes to the file
+    Logger logger(app, parser.value(logPathOption), false);
+    logger.resetLogFilePath(false);
+
+    WalletMonitor monitor;
+    QString error;
+    if (!monitor.load(parser.value(walletMonitorOption), error)) {
+        // console logging is off, whoever started the monitor still has to see why it exited
+        fprintf(stderr, "%s\n", qUtf8Printable(error));
+        qCritical().noquote() << error;
+        return 1;
+    }
+
+    // quitting through the event loop lets the sessions store their wallet caches
+    std::signal(SIGINT, [](int) { quitRequested = 1; });
+    std::signal(SIGTERM, [](int) { quitRequested = 1; });
+    QTimer quitTimer;
+    QObject::connect(&quitTimer, &QTimer::timeout, &app, [] {
+        if (quitRequested)
+            QCoreApplication::quit();
+    });
+    quitTimer.start(250);
+
+    monitor.start();
+    return app.exec();
+}
+
+} // namespace
+
 int main(int argc, char *argv[])
 {
+    // starts the startup clock
+    StartupTrace::instance();
+
     Q_INIT_RESOURCE(translations);
 
     // platform dependant settings
@@ -181,7 +262,7 @@ int main(int argc, char *argv[])
     bool isARM = true;
 #endif
 
-    // detect low graphics mode (start-low-graphics-mode.bat)
+    // low graphics mode forced by hand (start-low-graphics-mode.bat), desktops probe it below
     if(qgetenv("QMLSCENE_DEVICE") == "softwarecontext")
         isOpenGL = false;
 
@@ -206,7 +287,13 @@ int main(int argc, char *argv[])
     QDir::setCurrent(QDir(MacOSHelper::bundlePath() + QDir::separator() + "..").canonicalPath());
 #endif
 
+#if defined(WITH_QML_CACHE) && defined(Q_OS_LINUX)
+    // nothing compiled from the wallet UI may persist on Tails
+    if (isTails)
+        qputenv("QML_DISABLE_DISK_CACHE", "1");
+#elif !defined(WITH_QML_CACHE)
     qputenv("QML_DISABLE_DISK_CACHE", "1");
+#endif
 
     for (int i = 0; i < argc; i++) {
         if (QString(argv[i]).contains("platformpluginpath")) {
@@ -215,23 +302,22 @@ int main(int argc, char *argv[])
         }
     }
 
-    MainApp app(argc, argv);
+    if (hasArgument(argc, argv, "--wallet-monitor"))
+        return runWalletMonitor(argc, argv);
 
-#if defined(Q_OS_WIN)
-    if (isOpenGL)
-    {
-        QOpenGLContext ctx;
-        isOpenGL = ctx.create() && ctx.format().version() >= qMakePair(2, 1);
-        if (!isOpenGL) {
-            qputenv("QMLSCENE_DEVICE", "softwarecontext");
-        }
-    }
-#endif
+    MainApp app(argc, argv);
+    StartupTrace::instance()->mark("application");
 
     app.setApplicationName("monero-core");
     app.setOrganizationDomain("getmonero.org");
     app.setOrganizationName("monero-project");
 
+    // the cached decision lives in the application's data directory
+    if (isDesktop) {
+        isOpenGL = RenderBackendProbe::choose().backend == RenderBackendProbe::Hardware;
+        StartupTrace::instance()->mark("render backend");
+    }
+
     // Ask to enable Tails OS persistence mode, it affects:
     // - Log file location
     // - QML Settings file location (monero-core.conf)
@@ -267,6 +353,9 @@ int main(int argc, char *argv[])
 
     filter *eventFilter = new filter;
     app.installEventFilter(eventFilter);
+    BackgroundSyncPolicy::instance()->initialize([eventFilter] {
+        return eventFilter->lastActivity();
+    });
 
     QCommandLineParser parser;
     QCommandLineOption logPathOption(QStringList() << "l" << "log-file",
@@ -285,6 +374,12 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
     parser.addOption(disableCheckUpdatesOption);
     QCommandLineOption socksProxyOption("socks5-proxy", "Enable socks5 proxy. Used for remote node connection (advanced mode), updates downloading and fetching price sources.", "address:port");
     parser.addOption(socksProxyOption);
+    QCommandLineOption schedulerStatsOption("scheduler-stats", "Collect async task timings and log them on exit.");
+    parser.addOption(schedulerStatsOption);
+    QCommandLineOption startupTraceOption("startup-trace", "Log the duration of each startup phase once the main window is shown.");
+    parser.addOption(startupTraceOption);
+    QCommandLineOption eventTraceOption("event-trace", "Record a timeline of wallet, daemon, network and rendering activity and write it to <file> on exit, open it in Perfetto.", "file");
+    parser.addOption(eventTraceOption);
     QCommandLineOption testQmlOption("test-qml");
     testQmlOption.setFlags(QCommandLineOption::HiddenFromHelp);
     parser.addOption(logPathOption);
@@ -296,6 +391,10 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
 
     Logger logger(app, parser.value(logPathOption));
 
+    SchedulerStats::instance()->setEnabled(parser.isSet(schedulerStatsOption));
+    EventTrace::instance()->setEnabled(parser.isSet(eventTraceOption));
+    StartupTrace::instance()->mark("arguments and logger");
+
     // loglevel is configured in main.qml. Anything lower than
     // qWarning is not shown here unless MONERO_LOG_LEVEL env var is set
     bool logLevelOk;
@@ -333,15 +432,18 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
     IPC *ipc = new IPC(&app);
     QStringList posArgs = parser.positionalArguments();
 
+    QStringList uris;
     for(int i = 0; i != posArgs.count(); i++){
         QString arg = QString(posArgs.at(i));
         if(arg.isEmpty() || arg.length() >= 512) continue;
         if(arg.contains(reURI)){
-            if(!ipc->saveCommand(arg)){
-                return 0;
-            }
+            uris << arg;
         }
     }
+    // handed to a running instance in one go, this process exits right after
+    if(!ipc->saveCommands(uris)){
+        return 0;
+    }
 
     // start listening
     QTimer::singleShot(0, ipc, SLOT(bind()));
@@ -379,8 +481,10 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
     qmlRegisterType<clipboardAdapter>("moneroComponents.Clipboard", 1, 0, "Clipboard");
     qmlRegisterType<Downloader>("moneroComponents.Downloader", 1, 0, "Downloader");
     qmlRegisterType<Network>("moneroComponents.Network", 1, 0, "Network");
+    qmlRegisterType<RemoteNodeSelector>("moneroComponents.RemoteNodeSelector", 1, 0, "RemoteNodeSelector");
     qmlRegisterType<WalletKeysFilesModel>("moneroComponents.WalletKeysFilesModel", 1, 0, "WalletKeysFilesModel");
     qmlRegisterType<WalletManager>("moneroComponents.WalletManager", 1, 0, "WalletManager");
+    qmlRegisterType<WalletSessionManager>("moneroComponents.WalletSessionManager", 1, 0, "WalletSessionManager");
 
     // Temporary Qt.labs.settings replacement
     qmlRegisterType<MoneroSettings>("moneroComponents.Settings", 1, 0, "MoneroSettings");
@@ -388,12 +492,18 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
     qmlRegisterUncreatableType<Wallet>("moneroComponents.Wallet", 1, 0, "Wallet", "Wallet can't be instantiated directly");
 
 
+    qmlRegisterUncreatableType<DeviceQueue>("moneroComponents.DeviceQueue", 1, 0, "DeviceQueue",
+                                            "DeviceQueue can't be instantiated directly");
+
     qmlRegisterUncreatableType<PendingTransaction>("moneroComponents.PendingTransaction", 1, 0, "PendingTransaction",
                                                    "PendingTransaction can't be instantiated directly");
 
     qmlRegisterUncreatableType<UnsignedTransaction>("moneroComponents.UnsignedTransaction", 1, 0, "UnsignedTransaction",
                                                    "UnsignedTransaction can't be instantiated directly");
 
+    qmlRegisterUncreatableType<MiningStatusMonitor>("moneroComponents.MiningStatusMonitor", 1, 0, "MiningStatusMonitor",
+                                                     "MiningStatusMonitor can't be instantiated directly");
+
     qmlRegisterUncreatableType<TranslationManager>("moneroComponents.TranslationManager", 1, 0, "TranslationManager",
                                                    "TranslationManager can't be instantiated directly");
 
@@ -403,6 +513,10 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
     qmlRegisterUncreatableType<TransactionHistorySortFilterModel>("moneroComponents.TransactionHistorySortFilterModel", 1, 0, "TransactionHistorySortFilterModel",
                                                         "TransactionHistorySortFilterModel can't be instantiated directly");
 
+    qmlRegisterType<TransactionHistoryAggregateModel>("moneroComponents.TransactionHistoryAggregateModel", 1, 0, "TransactionHistoryAggregateModel");
+
+    qmlRegisterType<LogViewModel>("moneroComponents.LogViewModel", 1, 0, "LogViewModel");
+
     qmlRegisterUncreatableType<TransactionHistory>("moneroComponents.TransactionHistory", 1, 0, "TransactionHistory",
                                                         "TransactionHistory can't be instantiated directly");
 
@@ -413,6 +527,8 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
                                                    "DaemonManager can't be instantiated directly");
     qmlRegisterUncreatableType<P2PoolManager>("moneroComponents.P2PoolManager", 1, 0, "P2PoolManager",
                                                    "P2PoolManager can't be instantiated directly");
+    qmlRegisterUncreatableType<P2PoolStatsModel>("moneroComponents.P2PoolStatsModel", 1, 0, "P2PoolStatsModel",
+                                                   "P2PoolStatsModel can't be instantiated directly");
 #endif
     qmlRegisterUncreatableType<AddressBookModel>("moneroComponents.AddressBookModel", 1, 0, "AddressBookModel",
                                                         "AddressBookModel can't be instantiated directly");
@@ -445,6 +561,8 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
     qmlRegisterType<QrCodeScanner>("moneroComponents.QRCodeScanner", 1, 0, "QRCodeScanner");
 #endif
 
+    StartupTrace::instance()->mark("qml types");
+
     QQmlApplicationEngine engine;
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
@@ -465,6 +583,11 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
 
     engine.rootContext()->setContextProperty("logger", &logger);
 
+    engine.rootContext()->setContextProperty("schedulerStats", SchedulerStats::instance());
+    engine.rootContext()->setContextProperty("eventTrace", EventTrace::instance());
+    engine.rootContext()->setContextProperty("performanceMonitor", PerformanceMonitor::instance());
+    engine.rootContext()->setContextProperty("networkStats", NetworkStats::instance());
+
     engine.rootContext()->setContextProperty("mainApp", &app);
 
     engine.rootContext()->setContextProperty("IPC", ipc);
@@ -532,8 +655,11 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
 
     engine.rootContext()->setContextProperty("moneroVersion", MONERO_VERSION_FULL);
 
+    StartupTrace::instance()->mark("context properties");
+
     // Load main window (context properties needs to be defined obove this line)
     engine.load(QUrl(QStringLiteral("qrc:///main.qml")));
+    StartupTrace::instance()->mark("main.qml");
     if (engine.rootObjects().isEmpty())
     {
         qCritical() << "Error: no root objects";
@@ -550,24 +676,45 @@ Verify update binary using 'shasum'-compatible (SHA256 algo) output signed by tw
     if (parser.isSet(testQmlOption))
         return 0;
 
-#ifdef WITH_SCANNER
-    QObject *qmlCamera = rootObject->findChild<QObject*>("qrCameraQML");
-    if (qmlCamera)
+    // the first frame ends the startup, the trace is complete from here on
+    if (QQuickWindow *window = qobject_cast<QQuickWindow *>(rootObject))
     {
-        qWarning() << "QrCodeScanner : object found";
-        QCamera *camera_ = qvariant_cast<QCamera*>(qmlCamera->property("mediaObject"));
-        QObject *qmlFinder = rootObject->findChild<QObject*>("QrFinder");
-        qobject_cast<QrCodeScanner*>(qmlFinder)->setSource(camera_);
+        const bool dumpStartupTrace = parser.isSet(startupTraceOption);
+        auto firstFrame = std::make_shared<QMetaObject::Connection>();
+        *firstFrame = QObject::connect(window, &QQuickWindow::frameSwapped, window, [firstFrame, dumpStartupTrace] {
+            QObject::disconnect(*firstFrame);
+            StartupTrace::instance()->mark("first frame");
+            if (dumpStartupTrace)
+                StartupTrace::instance()->dump();
+        }, Qt::QueuedConnection);
+
+        PerformanceMonitor::instance()->setWindow(window);
+
+        // both run on the render thread, a frame spans sync, render and swap
+        if (EventTrace::instance()->enabled())
+        {
+            auto frameStart = std::make_shared<EventTrace::Clock::time_point>();
+            QObject::connect(window, &QQuickWindow::beforeSynchronizing, window, [frameStart] {
+                *frameStart = EventTrace::Clock::now();
+            }, Qt::DirectConnection);
+            QObject::connect(window, &QQuickWindow::frameSwapped, window, [frameStart] {
+                EventTrace::instance()->complete("qml", "frame", *frameStart, EventTrace::Clock::now());
+            }, Qt::DirectConnection);
+        }
     }
-    else
-        qCritical() << "QrCodeScanner : something went wrong !";
-#endif
 
     QObject::connect(eventFilter, SIGNAL(sequencePressed(QVariant,QVariant)), rootObject, SLOT(sequencePressed(QVariant,QVariant)));
     QObject::connect(eventFilter, SIGNAL(sequenceReleased(QVariant,QVariant)), rootObject, SLOT(sequenceReleased(QVariant,QVariant)));
     QObject::connect(eventFilter, SIGNAL(mousePressed(QVariant,QVariant,QVariant)), rootObject, SLOT(mousePressed(QVariant,QVariant,QVariant)));
     QObject::connect(eventFilter, SIGNAL(mouseReleased(QVariant,QVariant,QVariant)), rootObject, SLOT(mouseReleased(QVariant,QVariant,QVariant)));
     QObject::connect(eventFilter, SIGNAL(userActivity()), rootObject, SLOT(userActivity()));
+    QObject::connect(eventFilter, &filter::userActivity, &daemonManager, &DaemonManager::userActivity);
     QObject::connect(eventFilter, SIGNAL(uriHandler(QUrl)), ipc, SLOT(parseCommand(QUrl)));
-    return app.exec();
+    const int result = app.exec();
+    if (SchedulerStats::instance()->enabled())
+        SchedulerStats::instance()->dump();
+    if (parser.isSet(eventTraceOption))
+        EventTrace::instance()->save(parser.value(eventTraceOption));
+    NetworkStats::instance()->save();
+    return result;
 }
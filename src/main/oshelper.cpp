@@ -28,6 +28,8 @@
 
 #include "oshelper.h"
 
+#include <atomic>
+#include <memory>
 #include <unordered_set>
 
 #include <QCoreApplication>
@@ -62,13 +64,15 @@
 #endif
 
 #include "QR-Code-scanner/Decoder.h"
+#include "qt/PerfTrace.h"
 #include "qt/ScopeGuard.h"
 #include "NetworkType.h"
 
 namespace
 {
 
-QPixmap screenshot()
+// every screen on its own, each is decoded separately and none is missed
+std::vector<QPixmap> screenshots()
 {
     std::unordered_set<QWindow *> hidden;
     const QWindowList windows = QGuiApplication::allWindows();
@@ -87,7 +91,54 @@ QPixmap screenshot()
         }
     });
 
-    return QGuiApplication::primaryScreen()->grabWindow(0);
+    // only the grabs happen while hidden, converting and decoding come after
+    std::vector<QPixmap> pixmaps;
+    const QList<QScreen *> screens = QGuiApplication::screens();
+    pixmaps.reserve(screens.size());
+    for (QScreen *screen : screens)
+    {
+        pixmaps.push_back(screen->grabWindow(0));
+    }
+    return pixmaps;
+}
+
+QList<QImage> screenImages()
+{
+    QList<QImage> images;
+    for (const QPixmap &pixmap : screenshots())
+    {
+        if (!pixmap.isNull())
+        {
+            images.push_back(pixmap.toImage());
+        }
+    }
+    return images;
+}
+
+std::vector<std::string> decodeQrCodes(const QImage &image)
+{
+    const PerfScope perf("QR decode", qint64(image.width()) * image.height());
+    try
+    {
+        return QrDecoder().decode(image);
+    }
+    catch (const std::exception &e)
+    {
+        qWarning() << e.what();
+    }
+    return {};
+}
+
+void appendUnique(QStringList &codes, const std::vector<std::string> &decoded)
+{
+    for (const std::string &code : decoded)
+    {
+        const QString value = QString::fromStdString(code);
+        if (!codes.contains(value))
+        {
+            codes.push_back(value);
+        }
+    }
 }
 
 } // namespace
@@ -119,11 +170,19 @@ bool openFolderAndSelectItem(const QString &filePath)
 }
 #endif
 
-OSHelper::OSHelper(QObject *parent) : QObject(parent)
+OSHelper::OSHelper(QObject *parent)
+    : QObject(parent)
+    , m_grabRequest(0)
+    , m_scheduler(this)
 {
 
 }
 
+OSHelper::~OSHelper()
+{
+    m_scheduler.shutdownWaitForFinished();
+}
+
 void OSHelper::createDesktopEntry() const
 {
 #if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
@@ -138,22 +197,58 @@ QString OSHelper::downloadLocation() const
 
 QList<QString> OSHelper::grabQrCodesFromScreen() const
 {
-    QList<QString> codes;
-
-    try
+    QStringList codes;
+    const QList<std::vector<std::string>> decoded = QtConcurrent::blockingMapped(screenImages(), decodeQrCodes);
+    for (const std::vector<std::string> &screen : decoded)
     {
-        const QImage image = screenshot().toImage();
-        const std::vector<std::string> decoded = QrDecoder().decode(image);
-        std::for_each(decoded.begin(), decoded.end(), [&codes](const std::string &code) {
-            codes.push_back(QString::fromStdString(code));
-        });
+        appendUnique(codes, screen);
     }
-    catch (const std::exception &e)
+    return codes;
+}
+
+int OSHelper::grabQrCodesFromScreenAsync()
+{
+    struct Grab
     {
-        qWarning() << e.what();
+        std::atomic<int> remaining;
+        QMutex mutex;
+        QStringList codes;
+    };
+
+    const int request = ++m_grabRequest;
+    const QList<QImage> images = screenImages();
+    if (images.isEmpty())
+    {
+        emit qrCodesGrabbed(request, {});
+        return request;
     }
 
-    return codes;
+    const auto grab = std::make_shared<Grab>();
+    grab->remaining = images.size();
+    for (const QImage &image : images)
+    {
+        const bool scheduled = m_scheduler.run([this, request, grab, image] {
+            const std::vector<std::string> decoded = decodeQrCodes(image);
+            {
+                QMutexLocker locker(&grab->mutex);
+                appendUnique(grab->codes, decoded);
+            }
+            if (--grab->remaining > 0)
+            {
+                return;
+            }
+            QMutexLocker locker(&grab->mutex);
+            const QStringList codes = grab->codes;
+            QMetaObject::invokeMethod(this, [this, request, codes] {
+                emit qrCodesGrabbed(request, codes);
+            }, Qt::QueuedConnection);
+        }, FutureScheduler::Background, "OSHelper::grabQrCodesFromScreen").first;
+        if (!scheduled && --grab->remaining == 0)
+        {
+            emit qrCodesGrabbed(request, grab->codes);
+        }
+    }
+    return request;
 }
 
 bool OSHelper::openFile(const QString &filePath) const
@@ -32,6 +32,9 @@
 #include <QList>
 #include <QObject>
 #include <QString>
+#include <QStringList>
+
+#include "qt/FutureScheduler.h"
 /**
  * @brief The OSHelper class - exports to QML some OS-related functions
  */
@@ -42,10 +45,14 @@ class OSHelper : public QObject
 
 public:
     explicit OSHelper(QObject *parent = 0);
+    ~OSHelper();
 
     Q_INVOKABLE void createDesktopEntry() const;
     Q_INVOKABLE QString downloadLocation() const;
     Q_INVOKABLE QList<QString> grabQrCodesFromScreen() const;
+    //! captures every screen and decodes them in parallel off the GUI thread,
+    //! the codes arrive through qrCodesGrabbed with the returned request id
+    Q_INVOKABLE int grabQrCodesFromScreenAsync();
     Q_INVOKABLE bool openFile(const QString &filePath) const;
     Q_INVOKABLE bool openContainingFolder(const QString &filePath) const;
     Q_INVOKABLE QString openSaveFileDialog(const QString &title, const QString &folder, const QString &filename) const;
@@ -61,8 +68,13 @@ private:
     bool installed() const;
 
 signals:
+    void qrCodesGrabbed(int request, const QStringList &codes) const;
 
 public slots:
+
+private:
+    int m_grabRequest;
+    FutureScheduler m_scheduler;
 };
 
 #endif // OSHELPER_H
@@ -28,6 +28,7 @@
 
 #include "AddressBookModel.h"
 #include "AddressBook.h"
+#include "qt/EventTrace.h"
 #include <QDebug>
 #include <QHash>
 #include <wallet/api/wallet2_api.h>
@@ -37,6 +38,11 @@ AddressBookModel::AddressBookModel(QObject *parent, AddressBook *addressBook)
 {
     connect(m_addressBook,SIGNAL(refreshStarted()),this,SLOT(startReset()));
     connect(m_addressBook,SIGNAL(refreshFinished()),this,SLOT(endReset()));
+    connect(m_addressBook,SIGNAL(rowRemovalStarted(int,int)),this,SLOT(startRemoval(int,int)));
+    connect(m_addressBook,SIGNAL(rowRemovalFinished()),this,SLOT(endRemoval()));
+    connect(m_addressBook,SIGNAL(rowInsertionStarted(int,int)),this,SLOT(startInsertion(int,int)));
+    connect(m_addressBook,SIGNAL(rowInsertionFinished()),this,SLOT(endInsertion()));
+    connect(m_addressBook,SIGNAL(rowsChanged(int,int)),this,SLOT(changeRows(int,int)));
 
 }
 
@@ -44,8 +50,24 @@ void AddressBookModel::startReset(){
     beginResetModel();
 }
 void AddressBookModel::endReset(){
+    const TraceScope trace("model", "AddressBookModel reset");
     endResetModel();
 }
+void AddressBookModel::startRemoval(int first, int last){
+    beginRemoveRows(QModelIndex(), first, last);
+}
+void AddressBookModel::endRemoval(){
+    endRemoveRows();
+}
+void AddressBookModel::startInsertion(int first, int last){
+    beginInsertRows(QModelIndex(), first, last);
+}
+void AddressBookModel::endInsertion(){
+    endInsertRows();
+}
+void AddressBookModel::changeRows(int first, int last){
+    emit dataChanged(index(first), index(last));
+}
 
 int AddressBookModel::rowCount(const QModelIndex &) const
 {
@@ -57,6 +57,11 @@ public:
 public slots:
     void startReset();
     void endReset();
+    void startRemoval(int first, int last);
+    void endRemoval();
+    void startInsertion(int first, int last);
+    void endInsertion();
+    void changeRows(int first, int last);
 
 private:
     AddressBook * m_addressBook;
@@ -0,0 +1,475 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "LogViewModel.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+namespace {
+    // indexing advances this far per worker pass, rows appear between passes
+    constexpr qint64 LOG_INDEX_CHUNK_SIZE = 64 * 1024 * 1024;
+    constexpr int LOG_POLL_INTERVAL_MS = 1000;
+    // binary garbage or dumped blobs must not stall a delegate
+    constexpr int LOG_MAX_LINE_LENGTH = 8 * 1024;
+    constexpr int LOG_MAX_SEARCH_MATCHES = 10000;
+    constexpr int LOG_SEARCH_CANCEL_CHECK_ROWS = 4096;
+}
+
+LogViewModel::LogViewModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_follow(true)
+    , m_indexing(false)
+    , m_searching(false)
+    , m_generation(0)
+    , m_map(nullptr)
+    , m_mapSize(0)
+    , m_scheduler(this)
+{
+    m_pollTimer.setInterval(LOG_POLL_INTERVAL_MS);
+    connect(&m_pollTimer, &QTimer::timeout, this, &LogViewModel::poll);
+}
+
+LogViewModel::~LogViewModel()
+{
+    if (m_searchCancelled)
+    {
+        m_searchCancelled->store(true);
+    }
+    m_scheduler.shutdownWaitForFinished();
+    if (m_map)
+    {
+        m_file.unmap(const_cast<uchar *>(m_map));
+    }
+}
+
+QString LogViewModel::path() const
+{
+    return m_path;
+}
+
+void LogViewModel::setPath(const QString &path)
+{
+    if (m_path == path)
+    {
+        return;
+    }
+    m_path = path;
+    reset();
+    emit pathChanged();
+
+    setFollow(m_follow);
+    if (!m_path.isEmpty())
+    {
+        indexAsync();
+    }
+}
+
+bool LogViewModel::follow() const
+{
+    return m_follow;
+}
+
+void LogViewModel::setFollow(bool follow)
+{
+    const bool changed = m_follow != follow;
+    m_follow = follow;
+    if (m_follow && !m_path.isEmpty())
+    {
+        m_pollTimer.start();
+    }
+    else
+    {
+        m_pollTimer.stop();
+    }
+    if (changed)
+    {
+        emit followChanged();
+        poll();
+    }
+}
+
+bool LogViewModel::indexing() const
+{
+    return m_indexing;
+}
+
+bool LogViewModel::searching() const
+{
+    return m_searching;
+}
+
+void LogViewModel::search(const QString &pattern, bool caseSensitive)
+{
+    cancelSearch();
+
+    QRegularExpression regex(pattern, caseSensitive
+        ? QRegularExpression::NoPatternOption
+        : QRegularExpression::CaseInsensitiveOption);
+    if (!regex.isValid())
+    {
+        emit searchFailed(pattern, regex.errorString());
+        return;
+    }
+    regex.optimize();
+
+    // the snapshot keeps row numbers stable while indexing appends meanwhile
+    const QVector<qint64> lineEnds = m_lineEnds;
+    const QString path = m_path;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_searchCancelled = cancelled;
+    setSearching(true);
+
+    const bool scheduled = m_scheduler.run([this, regex, lineEnds, path, pattern, cancelled] {
+        QVariantList rows;
+        bool truncated = false;
+
+        QFile file(path);
+        const qint64 length = lineEnds.isEmpty() ? 0 : lineEnds.last();
+        const uchar *map = nullptr;
+        if (length > 0 && file.open(QIODevice::ReadOnly) && file.size() >= length)
+        {
+            map = file.map(0, length);
+        }
+        if (map)
+        {
+            const char *data = reinterpret_cast<const char *>(map);
+            qint64 start = 0;
+            for (int row = 0; row < lineEnds.size(); ++row)
+            {
+                if (row % LOG_SEARCH_CANCEL_CHECK_ROWS == 0 && cancelled->load())
+                {
+                    break;
+                }
+                qint64 end = lineEnds[row];
+                const qint64 next = end;
+                while (end > start && (data[end - 1] == '\n' || data[end - 1] == '\r'))
+                {
+                    --end;
+                }
+                const QString text = QString::fromUtf8(data + start, end - start);
+                start = next;
+                if (regex.match(text).hasMatch())
+                {
+                    if (rows.size() == LOG_MAX_SEARCH_MATCHES)
+                    {
+                        truncated = true;
+                        break;
+                    }
+                    rows.append(row);
+                }
+            }
+            file.unmap(const_cast<uchar *>(map));
+        }
+
+        QMetaObject::invokeMethod(this, [this, pattern, rows, truncated, cancelled] {
+            if (cancelled->load())
+            {
+                return;
+            }
+            m_searchCancelled.reset();
+            setSearching(false);
+            emit searchFinished(pattern, rows, truncated);
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "LogViewModel::search").first;
+
+    if (!scheduled)
+    {
+        m_searchCancelled.reset();
+        setSearching(false);
+    }
+}
+
+void LogViewModel::cancelSearch()
+{
+    if (m_searchCancelled)
+    {
+        m_searchCancelled->store(true);
+        m_searchCancelled.reset();
+    }
+    setSearching(false);
+}
+
+QString LogViewModel::text(int first, int count) const
+{
+    const int begin = std::max(first, 0);
+    const int end = std::min(first + count, rowCount());
+    QStringList lines;
+    for (int row = begin; row < end; ++row)
+    {
+        lines << QString::fromUtf8(line(row));
+    }
+    return lines.join('\n');
+}
+
+int LogViewModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return m_lineEnds.size();
+}
+
+QVariant LogViewModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_lineEnds.size())
+    {
+        return QVariant();
+    }
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+    case TextRole:
+        return QString::fromUtf8(line(index.row()));
+    case LineNumberRole:
+        return index.row() + 1;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> LogViewModel::roleNames() const
+{
+    static const QHash<int, QByteArray> roleNames = {
+        {LineNumberRole, "lineNumber"},
+        {TextRole, "text"},
+    };
+    return roleNames;
+}
+
+LogViewModel::Chunk LogViewModel::indexChunk(const QString &path, qint64 from)
+{
+    Chunk chunk;
+
+    // a missing file reads as empty, the logger recreates it after rotating
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        chunk.truncated = from > 0;
+        return chunk;
+    }
+    chunk.fileSize = file.size();
+    if (chunk.fileSize < from)
+    {
+        chunk.truncated = true;
+        return chunk;
+    }
+
+    const qint64 length = std::min(chunk.fileSize - from, LOG_INDEX_CHUNK_SIZE);
+    if (length == 0)
+    {
+        return chunk;
+    }
+    const uchar *map = file.map(from, length);
+    if (!map)
+    {
+        qWarning() << "Failed to map" << path << file.errorString();
+        return chunk;
+    }
+
+    const char *begin = reinterpret_cast<const char *>(map);
+    const char *end = begin + length;
+    for (const char *cursor = begin; cursor < end;)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+        if (!newline)
+        {
+            break;
+        }
+        cursor = newline + 1;
+        chunk.lineEnds.append(from + (cursor - begin));
+    }
+    // a single line longer than a chunk is cut rather than never shown
+    if (chunk.lineEnds.isEmpty() && length == LOG_INDEX_CHUNK_SIZE)
+    {
+        chunk.lineEnds.append(from + length);
+    }
+
+    file.unmap(const_cast<uchar *>(map));
+    return chunk;
+}
+
+void LogViewModel::reset()
+{
+    ++m_generation;
+    cancelSearch();
+
+    beginResetModel();
+    m_lineEnds.clear();
+    if (m_map)
+    {
+        m_file.unmap(const_cast<uchar *>(m_map));
+        m_map = nullptr;
+    }
+    m_mapSize = 0;
+    m_file.close();
+    endResetModel();
+
+    emit lineCountChanged();
+    setIndexing(false);
+}
+
+void LogViewModel::poll()
+{
+    if (m_path.isEmpty() || m_indexing)
+    {
+        return;
+    }
+    const qint64 indexed = m_lineEnds.isEmpty() ? 0 : m_lineEnds.last();
+    if (QFileInfo(m_path).size() != indexed)
+    {
+        indexAsync();
+    }
+}
+
+void LogViewModel::indexAsync()
+{
+    if (m_indexing)
+    {
+        return;
+    }
+
+    const quint64 generation = m_generation;
+    const QString path = m_path;
+    const qint64 from = m_lineEnds.isEmpty() ? 0 : m_lineEnds.last();
+    setIndexing(m_scheduler.run([this, generation, path, from] {
+        const Chunk chunk = indexChunk(path, from);
+        QMetaObject::invokeMethod(this, [this, generation, chunk] {
+            if (generation == m_generation)
+            {
+                appendChunk(chunk);
+            }
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "LogViewModel::index").first);
+}
+
+void LogViewModel::appendChunk(const Chunk &chunk)
+{
+    setIndexing(false);
+
+    if (chunk.truncated)
+    {
+        reset();
+        indexAsync();
+        return;
+    }
+    if (chunk.lineEnds.isEmpty())
+    {
+        return;
+    }
+
+    const int first = m_lineEnds.size();
+    beginInsertRows(QModelIndex(), first, first + chunk.lineEnds.size() - 1);
+    m_lineEnds += chunk.lineEnds;
+    mapIndexed();
+    endInsertRows();
+    emit lineCountChanged();
+
+    // keep going until caught up, the poll picks up appends after that
+    if (chunk.fileSize > m_lineEnds.last())
+    {
+        indexAsync();
+    }
+}
+
+bool LogViewModel::mapIndexed()
+{
+    const qint64 indexed = m_lineEnds.isEmpty() ? 0 : m_lineEnds.last();
+    if (indexed <= m_mapSize)
+    {
+        return true;
+    }
+
+    if (!m_file.isOpen())
+    {
+        m_file.setFileName(m_path);
+        if (!m_file.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+    }
+    if (m_map)
+    {
+        m_file.unmap(const_cast<uchar *>(m_map));
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+
+    // map what is there already, appends usually fit without remapping
+    const qint64 size = std::max(indexed, m_file.size());
+    m_map = m_file.map(0, size);
+    if (!m_map)
+    {
+        qWarning() << "Failed to map" << m_path << m_file.errorString();
+        return false;
+    }
+    m_mapSize = size;
+    return true;
+}
+
+QByteArray LogViewModel::line(int row) const
+{
+    const qint64 start = row > 0 ? m_lineEnds[row - 1] : 0;
+    qint64 end = m_lineEnds[row];
+    if (!m_map || end > m_mapSize)
+    {
+        return QByteArray();
+    }
+
+    const char *data = reinterpret_cast<const char *>(m_map);
+    while (end > start && (data[end - 1] == '\n' || data[end - 1] == '\r'))
+    {
+        --end;
+    }
+    // raw data is only valid until the next remap, callers convert right away
+    return QByteArray::fromRawData(data + start, std::min<qint64>(end - start, LOG_MAX_LINE_LENGTH));
+}
+
+void LogViewModel::setIndexing(bool indexing)
+{
+    if (m_indexing != indexing)
+    {
+        m_indexing = indexing;
+        emit indexingChanged();
+    }
+}
+
+void LogViewModel::setSearching(bool searching)
+{
+    if (m_searching != searching)
+    {
+        m_searching = searching;
+        emit searchingChanged();
+    }
+}
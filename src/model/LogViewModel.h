@@ -0,0 +1,137 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LOGVIEWMODEL_H
+#define LOGVIEWMODEL_H
+
+#include <QAbstractListModel>
+#include <QFile>
+#include <QTimer>
+#include <QVariantList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "qt/FutureScheduler.h"
+
+/**
+ * @brief The LogViewModel class - read-only list model over a log file, one
+ * row per line. The file is memory-mapped and only the line end offsets are
+ * kept, built in chunks on a worker so multi-gigabyte logs show up at once and
+ * rows are decoded only when a delegate asks for them. Appends are picked up
+ * while following, a shrunk file (rotation) is indexed anew.
+ *
+ * The mapping keeps the file open, clear path once the viewer is closed so the
+ * logger can rotate it.
+ */
+class LogViewModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QString path READ path WRITE setPath NOTIFY pathChanged)
+    Q_PROPERTY(bool follow READ follow WRITE setFollow NOTIFY followChanged)
+    Q_PROPERTY(int lineCount READ rowCount NOTIFY lineCountChanged)
+    Q_PROPERTY(bool indexing READ indexing NOTIFY indexingChanged)
+    Q_PROPERTY(bool searching READ searching NOTIFY searchingChanged)
+
+public:
+    enum LogLineRole {
+        LineNumberRole = Qt::UserRole + 1,
+        TextRole
+    };
+    Q_ENUM(LogLineRole)
+
+    explicit LogViewModel(QObject *parent = nullptr);
+    ~LogViewModel();
+
+    QString path() const;
+    void setPath(const QString &path);
+
+    bool follow() const;
+    void setFollow(bool follow);
+
+    bool indexing() const;
+    bool searching() const;
+
+    //! regex search over the lines indexed so far, reports matching rows
+    //! through searchFinished, a new search or path cancels the running one
+    Q_INVOKABLE void search(const QString &pattern, bool caseSensitive = false);
+    Q_INVOKABLE void cancelSearch();
+    //! lines [first, first + count) joined by newlines, for copying
+    Q_INVOKABLE QString text(int first, int count) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    void pathChanged();
+    void followChanged();
+    void lineCountChanged();
+    void indexingChanged();
+    void searchingChanged();
+    //! rows ascending, truncated once too many lines matched
+    void searchFinished(const QString &pattern, const QVariantList &rows, bool truncated);
+    void searchFailed(const QString &pattern, const QString &error);
+
+private:
+    struct Chunk
+    {
+        QVector<qint64> lineEnds;
+        qint64 fileSize = 0;
+        bool truncated = false;
+    };
+
+    static Chunk indexChunk(const QString &path, qint64 from);
+    void reset();
+    void poll();
+    void indexAsync();
+    void appendChunk(const Chunk &chunk);
+    bool mapIndexed();
+    QByteArray line(int row) const;
+    void setIndexing(bool indexing);
+    void setSearching(bool searching);
+
+private:
+    QString m_path;
+    bool m_follow;
+    bool m_indexing;
+    bool m_searching;
+    quint64 m_generation;
+    //! offset after each line's newline
+    QVector<qint64> m_lineEnds;
+    QFile m_file;
+    const uchar *m_map;
+    qint64 m_mapSize;
+    std::shared_ptr<std::atomic<bool>> m_searchCancelled;
+    QTimer m_pollTimer;
+    FutureScheduler m_scheduler;
+};
+
+#endif // LOGVIEWMODEL_H
@@ -28,34 +28,106 @@
 
 #include "SubaddressAccountModel.h"
 #include "SubaddressAccount.h"
+#include "SubaddressLookahead.h"
+#include "qt/EventTrace.h"
 #include <QDebug>
 #include <QHash>
+#include <algorithm>
 #include <wallet/api/wallet2_api.h>
 
-SubaddressAccountModel::SubaddressAccountModel(QObject *parent, SubaddressAccount *subaddressAccount)
-    : QAbstractListModel(parent), m_subaddressAccount(subaddressAccount)
+namespace
+{
+    const int PAGE_SIZE = 256;
+}
+
+SubaddressAccountModel::SubaddressAccountModel(QObject *parent, SubaddressAccount *subaddressAccount, SubaddressLookahead *lookahead)
+    : QAbstractListModel(parent), m_subaddressAccount(subaddressAccount), m_loaded(0), m_lookahead(lookahead)
 {
     connect(m_subaddressAccount,SIGNAL(refreshStarted()),this,SLOT(startReset()));
     connect(m_subaddressAccount,SIGNAL(refreshFinished()),this,SLOT(endReset()));
+    connect(m_subaddressAccount,SIGNAL(rowsAppended(int,int)),this,SLOT(appendRows(int,int)));
+    connect(m_subaddressAccount,SIGNAL(rowsChanged(int,int)),this,SLOT(changeRows(int,int)));
+    // updated from the refresh thread, queued to ours
+    connect(m_lookahead, &SubaddressLookahead::changed, this, &SubaddressAccountModel::lookaheadChanged);
+    m_loaded = std::min<quint64>(m_subaddressAccount->count(), PAGE_SIZE);
 }
 
 void SubaddressAccountModel::startReset(){
     beginResetModel();
 }
 void SubaddressAccountModel::endReset(){
+    const TraceScope trace("model", "SubaddressAccountModel reset");
+    m_loaded = std::min<quint64>(m_subaddressAccount->count(), PAGE_SIZE);
     endResetModel();
 }
 
+void SubaddressAccountModel::appendRows(int first, int last)
+{
+    // new rows show up right away, along with any pages not fetched yet, so
+    // a just created address can be selected
+    if (last < m_loaded)
+        return;
+    Q_UNUSED(first)
+    beginInsertRows(QModelIndex(), m_loaded, last);
+    m_loaded = last + 1;
+    endInsertRows();
+}
+
+void SubaddressAccountModel::changeRows(int first, int last)
+{
+    last = std::min(last, m_loaded - 1);
+    if (first <= last)
+        emit dataChanged(index(first), index(last));
+}
+
+void SubaddressAccountModel::lookaheadChanged()
+{
+    if (m_loaded > 0)
+        emit dataChanged(index(0), index(m_loaded - 1), {SubaddressAccountHighestUsedRole, SubaddressAccountLargestGapRole, SubaddressAccountLookaheadRole});
+}
+
+bool SubaddressAccountModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && static_cast<quint64>(m_loaded) < m_subaddressAccount->count();
+}
+
+void SubaddressAccountModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+    const int total = static_cast<int>(m_subaddressAccount->count());
+    const int loaded = std::min(total, m_loaded + PAGE_SIZE);
+    if (loaded <= m_loaded)
+        return;
+    beginInsertRows(QModelIndex(), m_loaded, loaded - 1);
+    m_loaded = loaded;
+    endInsertRows();
+}
+
 int SubaddressAccountModel::rowCount(const QModelIndex &) const
 {
-    return m_subaddressAccount->count();
+    return m_loaded;
 }
 
 QVariant SubaddressAccountModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() < 0 || static_cast<quint64>(index.row()) >= m_subaddressAccount->count())
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_loaded)
         return {};
 
+    // rows are accounts, their usage comes from the history rather than libwallet's row
+    switch (role) {
+    case SubaddressAccountHighestUsedRole: {
+        const auto usage = m_lookahead->usage(index.row());
+        return usage ? static_cast<qint64>(usage->highestUsed) : -1;
+    }
+    case SubaddressAccountLargestGapRole: {
+        const auto usage = m_lookahead->usage(index.row());
+        return usage ? usage->largestGap : 0;
+    }
+    case SubaddressAccountLookaheadRole:
+        return m_lookahead->minor();
+    }
+
     QVariant result;
 
     bool found = m_subaddressAccount->getRow(index.row(), [&result, &role](const Monero::SubaddressAccountRow &row) {
@@ -92,6 +164,9 @@ QHash<int, QByteArray> SubaddressAccountModel::roleNames() const
         roleNames.insert(SubaddressAccountLabelRole, "label");
         roleNames.insert(SubaddressAccountBalanceRole, "balance");
         roleNames.insert(SubaddressAccountUnlockedBalanceRole, "unlockedBalance");
+        roleNames.insert(SubaddressAccountHighestUsedRole, "highestUsedIndex");
+        roleNames.insert(SubaddressAccountLargestGapRole, "largestGap");
+        roleNames.insert(SubaddressAccountLookaheadRole, "lookahead");
     }
     return roleNames;
 }
@@ -32,6 +32,7 @@
 #include <QAbstractListModel>
 
 class SubaddressAccount;
+class SubaddressLookahead;
 
 class SubaddressAccountModel : public QAbstractListModel
 {
@@ -44,21 +45,33 @@ public:
         SubaddressAccountLabelRole,
         SubaddressAccountBalanceRole,
         SubaddressAccountUnlockedBalanceRole,
+        SubaddressAccountHighestUsedRole,
+        SubaddressAccountLargestGapRole,
+        SubaddressAccountLookaheadRole,
     };
     Q_ENUM(SubaddressAccountRowRole)
 
-    SubaddressAccountModel(QObject *parent, SubaddressAccount *subaddressAccount);
+    SubaddressAccountModel(QObject *parent, SubaddressAccount *subaddressAccount, SubaddressLookahead *lookahead);
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const  override;
+    // rows are handed to views a page at a time, accounts can have tens of
+    // thousands of addresses
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
 public slots:
     void startReset();
     void endReset();
+    void appendRows(int first, int last);
+    void changeRows(int first, int last);
+    void lookaheadChanged();
 
 private:
     SubaddressAccount *m_subaddressAccount;
+    int m_loaded;
+    SubaddressLookahead *m_lookahead;
 };
 
 #endif // SUBADDRESSACCOUNTMODEL_H
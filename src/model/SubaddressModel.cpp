@@ -28,15 +28,29 @@
 
 #include "SubaddressModel.h"
 #include "Subaddress.h"
+#include "TransactionHistory.h"
+#include "WalletManager.h"
+#include "qt/EventTrace.h"
+#include <QDateTime>
 #include <QDebug>
 #include <QHash>
+#include <algorithm>
 #include <wallet/api/wallet2_api.h>
 
-SubaddressModel::SubaddressModel(QObject *parent, Subaddress *subaddress)
-    : QAbstractListModel(parent), m_subaddress(subaddress)
+namespace
 {
+    const int PAGE_SIZE = 256;
+}
+
+SubaddressModel::SubaddressModel(QObject *parent, Subaddress *subaddress, TransactionHistory *history)
+    : QAbstractListModel(parent), m_subaddress(subaddress), m_history(history), m_loaded(0)
+{
+    connect(m_history, &TransactionHistory::aggregatesChanged, this, &SubaddressModel::changeReceived);
     connect(m_subaddress,SIGNAL(refreshStarted()),this,SLOT(startReset()));
     connect(m_subaddress,SIGNAL(refreshFinished()),this,SLOT(endReset()));
+    connect(m_subaddress,SIGNAL(rowsAppended(int,int)),this,SLOT(appendRows(int,int)));
+    connect(m_subaddress,SIGNAL(rowsChanged(int,int)),this,SLOT(changeRows(int,int)));
+    m_loaded = std::min<quint64>(m_subaddress->count(), PAGE_SIZE);
 
 }
 
@@ -44,19 +58,83 @@ void SubaddressModel::startReset(){
     beginResetModel();
 }
 void SubaddressModel::endReset(){
+    const TraceScope trace("model", "SubaddressModel reset");
+    m_loaded = std::min<quint64>(m_subaddress->count(), PAGE_SIZE);
     endResetModel();
 }
 
+void SubaddressModel::appendRows(int first, int last)
+{
+    // new rows show up right away, along with any pages not fetched yet, so
+    // a just created address can be selected
+    if (last < m_loaded)
+        return;
+    Q_UNUSED(first)
+    beginInsertRows(QModelIndex(), m_loaded, last);
+    m_loaded = last + 1;
+    endInsertRows();
+}
+
+void SubaddressModel::changeRows(int first, int last)
+{
+    last = std::min(last, m_loaded - 1);
+    if (first <= last)
+        emit dataChanged(index(first), index(last));
+}
+
+void SubaddressModel::changeReceived()
+{
+    if (m_loaded > 0)
+        emit dataChanged(index(0), index(m_loaded - 1), {SubaddressReceivedAmountRole, SubaddressReceivedUnconfirmedAmountRole,
+                                                         SubaddressReceivedCountRole, SubaddressLastTxHashRole, SubaddressLastTxTimeRole});
+}
+
+bool SubaddressModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && static_cast<quint64>(m_loaded) < m_subaddress->count();
+}
+
+void SubaddressModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+    const int total = static_cast<int>(m_subaddress->count());
+    const int loaded = std::min(total, m_loaded + PAGE_SIZE);
+    if (loaded <= m_loaded)
+        return;
+    beginInsertRows(QModelIndex(), m_loaded, loaded - 1);
+    m_loaded = loaded;
+    endInsertRows();
+}
+
 int SubaddressModel::rowCount(const QModelIndex &) const
 {
-    return m_subaddress->count();
+    return m_loaded;
 }
 
 QVariant SubaddressModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() < 0 || static_cast<quint64>(index.row()) >= m_subaddress->count())
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_loaded)
         return {};
 
+    if (role >= SubaddressReceivedAmountRole && role <= SubaddressLastTxTimeRole) {
+        // history rows are those of the account whose subaddresses are listed
+        const TransactionHistoryAggregates::Received *received =
+            m_history->aggregates().received(m_history->accountIndex(), index.row());
+        switch (role) {
+        case SubaddressReceivedAmountRole:
+            return WalletManager::displayAmountToDouble(received ? received->amount : 0);
+        case SubaddressReceivedUnconfirmedAmountRole:
+            return WalletManager::displayAmountToDouble(received ? received->unconfirmedAmount : 0);
+        case SubaddressReceivedCountRole:
+            return received ? received->count : 0;
+        case SubaddressLastTxHashRole:
+            return received ? received->transactions.last() : QString();
+        case SubaddressLastTxTimeRole:
+            return received ? QDateTime::fromSecsSinceEpoch(received->transactions.lastKey()) : QDateTime();
+        }
+    }
+
     QVariant result;
 
     bool found = m_subaddress->getRow(index.row(), [&index, &result, &role](const Monero::SubaddressRow &subaddress) {
@@ -86,6 +164,11 @@ QHash<int, QByteArray> SubaddressModel::roleNames() const
     {
         roleNames.insert(SubaddressAddressRole, "address");
         roleNames.insert(SubaddressLabelRole, "label");
+        roleNames.insert(SubaddressReceivedAmountRole, "receivedAmount");
+        roleNames.insert(SubaddressReceivedUnconfirmedAmountRole, "receivedUnconfirmedAmount");
+        roleNames.insert(SubaddressReceivedCountRole, "receivedCount");
+        roleNames.insert(SubaddressLastTxHashRole, "lastTxHash");
+        roleNames.insert(SubaddressLastTxTimeRole, "lastTxTime");
     }
     return roleNames;
 }
@@ -32,6 +32,7 @@
 #include <QAbstractListModel>
 
 class Subaddress;
+class TransactionHistory;
 
 class SubaddressModel : public QAbstractListModel
 {
@@ -42,21 +43,36 @@ public:
         SubaddressRole = Qt::UserRole + 1, // for the SubaddressRow object;
         SubaddressAddressRole,
         SubaddressLabelRole,
+        // incoming transfers, looked up in TransactionHistory's received index
+        SubaddressReceivedAmountRole,
+        SubaddressReceivedUnconfirmedAmountRole,
+        SubaddressReceivedCountRole,
+        SubaddressLastTxHashRole,
+        SubaddressLastTxTimeRole,
     };
     Q_ENUM(SubaddressRowRole)
 
-    SubaddressModel(QObject *parent, Subaddress *subaddress);
+    SubaddressModel(QObject *parent, Subaddress *subaddress, TransactionHistory *history);
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QHash<int, QByteArray> roleNames() const  override;
+    // rows are handed to views a page at a time, accounts can have tens of
+    // thousands of addresses
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
 public slots:
     void startReset();
     void endReset();
+    void appendRows(int first, int last);
+    void changeRows(int first, int last);
+    void changeReceived();
 
 private:
     Subaddress *m_subaddress;
+    TransactionHistory *m_history;
+    int m_loaded;
 };
 
 #endif // SUBADDRESSMODEL_H
@@ -0,0 +1,223 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "TransactionHistoryAggregateModel.h"
+#include "TransactionHistory.h"
+#include "WalletManager.h"
+
+#include <algorithm>
+
+#include <QDate>
+
+namespace {
+    double signedAmount(qint64 amount)
+    {
+        const double value = WalletManager::displayAmountToDouble(amount < 0 ? -static_cast<quint64>(amount) : amount);
+        return amount < 0 ? -value : value;
+    }
+}
+
+TransactionHistoryAggregateModel::TransactionHistoryAggregateModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_granularity(Day)
+    , m_subaddrAccount(-1)
+    , m_subaddrIndex(-1)
+{
+}
+
+TransactionHistory *TransactionHistoryAggregateModel::transactionHistory() const
+{
+    return m_transactionHistory;
+}
+
+void TransactionHistoryAggregateModel::setTransactionHistory(TransactionHistory *history)
+{
+    if (m_transactionHistory == history)
+    {
+        return;
+    }
+    if (m_transactionHistory)
+    {
+        disconnect(m_transactionHistory, nullptr, this, nullptr);
+    }
+    m_transactionHistory = history;
+    if (m_transactionHistory)
+    {
+        connect(m_transactionHistory, &TransactionHistory::aggregatesChanged, this, &TransactionHistoryAggregateModel::update);
+    }
+    emit transactionHistoryChanged();
+    update();
+}
+
+TransactionHistoryAggregateModel::Granularity TransactionHistoryAggregateModel::granularity() const
+{
+    return m_granularity;
+}
+
+void TransactionHistoryAggregateModel::setGranularity(Granularity granularity)
+{
+    if (m_granularity != granularity)
+    {
+        m_granularity = granularity;
+        emit granularityChanged();
+        update();
+    }
+}
+
+int TransactionHistoryAggregateModel::subaddrAccount() const
+{
+    return m_subaddrAccount;
+}
+
+void TransactionHistoryAggregateModel::setSubaddrAccount(int subaddrAccount)
+{
+    if (m_subaddrAccount != subaddrAccount)
+    {
+        m_subaddrAccount = subaddrAccount;
+        emit subaddrAccountChanged();
+        update();
+    }
+}
+
+int TransactionHistoryAggregateModel::subaddrIndex() const
+{
+    return m_subaddrIndex;
+}
+
+void TransactionHistoryAggregateModel::setSubaddrIndex(int subaddrIndex)
+{
+    if (m_subaddrIndex != subaddrIndex)
+    {
+        m_subaddrIndex = subaddrIndex;
+        emit subaddrIndexChanged();
+        update();
+    }
+}
+
+int TransactionHistoryAggregateModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_buckets.size();
+}
+
+QVariant TransactionHistoryAggregateModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_buckets.size())
+    {
+        return QVariant();
+    }
+
+    const Bucket &bucket = m_buckets[index.row()];
+    switch (role)
+    {
+    case BucketStartRole:
+        return QDate::fromJulianDay(bucket.julianDay).startOfDay();
+    case IncomingRole:
+        return WalletManager::displayAmountToDouble(bucket.totals.incoming);
+    case OutgoingRole:
+        return WalletManager::displayAmountToDouble(bucket.totals.outgoing);
+    case FeeRole:
+        return WalletManager::displayAmountToDouble(bucket.totals.fees);
+    case NetRole:
+        return signedAmount(static_cast<qint64>(bucket.totals.incoming - bucket.totals.outgoing - bucket.totals.fees));
+    case BalanceRole:
+        return signedAmount(bucket.balance);
+    case CountRole:
+        return bucket.totals.count;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> TransactionHistoryAggregateModel::roleNames() const
+{
+    static const QHash<int, QByteArray> roleNames = {
+        {BucketStartRole, "bucketStart"},
+        {IncomingRole, "incoming"},
+        {OutgoingRole, "outgoing"},
+        {FeeRole, "fee"},
+        {NetRole, "net"},
+        {BalanceRole, "balance"},
+        {CountRole, "count"},
+    };
+    return roleNames;
+}
+
+void TransactionHistoryAggregateModel::update()
+{
+    QVector<Bucket> buckets;
+    if (m_transactionHistory)
+    {
+        const QMap<qint64, TransactionHistoryAggregates::Totals> series = m_transactionHistory->aggregates().series(
+            static_cast<TransactionHistoryAggregates::Granularity>(m_granularity), m_subaddrAccount, m_subaddrIndex);
+        buckets.reserve(series.size());
+        qint64 balance = 0;
+        for (auto it = series.cbegin(); it != series.cend(); ++it)
+        {
+            balance += static_cast<qint64>(it.value().incoming - it.value().outgoing - it.value().fees);
+            buckets.append({it.key(), it.value(), balance});
+        }
+    }
+
+    // a new transaction usually touches the last bucket or appends one, keep
+    // the rows before it instead of resetting the whole chart
+    int common = 0;
+    while (common < buckets.size() && common < m_buckets.size() && buckets[common].julianDay == m_buckets[common].julianDay)
+    {
+        ++common;
+    }
+    if (common < m_buckets.size())
+    {
+        beginRemoveRows(QModelIndex(), common, m_buckets.size() - 1);
+        m_buckets.resize(common);
+        endRemoveRows();
+    }
+
+    int firstChanged = common;
+    for (int row = 0; row < common; ++row)
+    {
+        const TransactionHistoryAggregates::Totals &fresh = buckets[row].totals;
+        const TransactionHistoryAggregates::Totals &current = m_buckets[row].totals;
+        if (fresh.incoming != current.incoming || fresh.outgoing != current.outgoing ||
+            fresh.fees != current.fees || fresh.count != current.count)
+        {
+            firstChanged = row;
+            break;
+        }
+    }
+    if (firstChanged < common)
+    {
+        std::copy(buckets.cbegin() + firstChanged, buckets.cbegin() + common, m_buckets.begin() + firstChanged);
+        emit dataChanged(index(firstChanged), index(common - 1));
+    }
+
+    if (common < buckets.size())
+    {
+        beginInsertRows(QModelIndex(), common, buckets.size() - 1);
+        m_buckets.append(buckets.mid(common));
+        endInsertRows();
+    }
+}
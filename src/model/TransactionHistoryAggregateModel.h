@@ -0,0 +1,117 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef TRANSACTIONHISTORYAGGREGATEMODEL_H
+#define TRANSACTIONHISTORYAGGREGATEMODEL_H
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QVector>
+
+#include "TransactionHistoryAggregates.h"
+
+class TransactionHistory;
+
+/**
+ * @brief The TransactionHistoryAggregateModel class - one row per day, week or
+ * month with transfers, oldest first, read from TransactionHistory's
+ * incrementally kept totals. Meant to back volume and balance charts.
+ */
+class TransactionHistoryAggregateModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(TransactionHistory * transactionHistory READ transactionHistory WRITE setTransactionHistory NOTIFY transactionHistoryChanged)
+    Q_PROPERTY(Granularity granularity READ granularity WRITE setGranularity NOTIFY granularityChanged)
+    //! negative values sum over all accounts or indices
+    Q_PROPERTY(int subaddrAccount READ subaddrAccount WRITE setSubaddrAccount NOTIFY subaddrAccountChanged)
+    Q_PROPERTY(int subaddrIndex READ subaddrIndex WRITE setSubaddrIndex NOTIFY subaddrIndexChanged)
+
+public:
+    enum Granularity {
+        Day = TransactionHistoryAggregates::Day,
+        Week = TransactionHistoryAggregates::Week,
+        Month = TransactionHistoryAggregates::Month
+    };
+    Q_ENUM(Granularity)
+
+    enum AggregateRole {
+        BucketStartRole = Qt::UserRole + 1,
+        IncomingRole,
+        OutgoingRole,
+        FeeRole,
+        //! incoming - outgoing - fees
+        NetRole,
+        //! running sum of NetRole up to and including this bucket
+        BalanceRole,
+        CountRole
+    };
+    Q_ENUM(AggregateRole)
+
+    explicit TransactionHistoryAggregateModel(QObject *parent = nullptr);
+
+    TransactionHistory *transactionHistory() const;
+    void setTransactionHistory(TransactionHistory *history);
+
+    Granularity granularity() const;
+    void setGranularity(Granularity granularity);
+
+    int subaddrAccount() const;
+    void setSubaddrAccount(int subaddrAccount);
+
+    int subaddrIndex() const;
+    void setSubaddrIndex(int subaddrIndex);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    void transactionHistoryChanged();
+    void granularityChanged();
+    void subaddrAccountChanged();
+    void subaddrIndexChanged();
+
+private:
+    struct Bucket
+    {
+        qint64 julianDay = 0;
+        TransactionHistoryAggregates::Totals totals;
+        qint64 balance = 0;
+    };
+
+    void update();
+
+private:
+    QPointer<TransactionHistory> m_transactionHistory;
+    Granularity m_granularity;
+    int m_subaddrAccount;
+    int m_subaddrIndex;
+    QVector<Bucket> m_buckets;
+};
+
+#endif // TRANSACTIONHISTORYAGGREGATEMODEL_H
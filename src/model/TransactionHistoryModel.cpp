@@ -29,6 +29,7 @@
 #include "TransactionHistoryModel.h"
 #include "TransactionHistory.h"
 #include "TransactionInfo.h"
+#include "WalletManager.h"
 
 #include <QDateTime>
 #include <QDebug>
@@ -46,10 +47,26 @@ void TransactionHistoryModel::setTransactionHistory(TransactionHistory *th)
     m_transactionHistory = th;
     endResetModel();
 
-    connect(m_transactionHistory, &TransactionHistory::refreshStarted,
-            this, &TransactionHistoryModel::beginResetModel);
-    connect(m_transactionHistory, &TransactionHistory::refreshFinished,
-            this, &TransactionHistoryModel::endResetModel);
+    connect(m_transactionHistory, &TransactionHistory::transactionsAboutToBeInserted,
+            this, [this](int first, int last) {
+        beginInsertRows(QModelIndex(), first, last);
+    });
+    connect(m_transactionHistory, &TransactionHistory::transactionsInserted,
+            this, &TransactionHistoryModel::endInsertRows);
+    connect(m_transactionHistory, &TransactionHistory::transactionsAboutToBeRemoved,
+            this, [this](int first, int last) {
+        beginRemoveRows(QModelIndex(), first, last);
+    });
+    connect(m_transactionHistory, &TransactionHistory::transactionsRemoved,
+            this, &TransactionHistoryModel::endRemoveRows);
+    connect(m_transactionHistory, &TransactionHistory::transactionsChanged,
+            this, [this](int first, int last, quint32 changedFields) {
+        const QVector<int> roles = changedRoles(changedFields);
+        // an empty role list would mean "everything changed"
+        if (!roles.isEmpty()) {
+            emit dataChanged(index(first), index(last), roles);
+        }
+    });
 
     emit transactionHistoryChanged();
 }
@@ -59,69 +76,105 @@ TransactionHistory *TransactionHistoryModel::transactionHistory() const
     return m_transactionHistory;
 }
 
-QVariant TransactionHistoryModel::parseTransactionInfo(const TransactionInfo &tInfo, int role) const
+QVector<int> TransactionHistoryModel::changedRoles(quint32 changedFields)
+{
+    QVector<int> roles;
+    if (changedFields & TransactionHistoryStore::ChangedAmount) {
+        roles << TransactionAmountRole << TransactionDisplayAmountRole << TransactionAtomicAmountRole;
+    }
+    if (changedFields & TransactionHistoryStore::ChangedBlockHeight) {
+        roles << TransactionBlockHeightRole;
+    }
+    if (changedFields & (TransactionHistoryStore::ChangedBlockHeight | TransactionHistoryStore::ChangedUnlockTime)) {
+        roles << TransactionConfirmationsRequiredRole;
+    }
+    // confirmations are derived from the height and pending state
+    if (changedFields & (TransactionHistoryStore::ChangedConfirmations | TransactionHistoryStore::ChangedBlockHeight | TransactionHistoryStore::ChangedPending)) {
+        roles << TransactionConfirmationsRole;
+    }
+    if (changedFields & TransactionHistoryStore::ChangedFailed) {
+        roles << TransactionFailedRole;
+    }
+    if (changedFields & TransactionHistoryStore::ChangedFee) {
+        roles << TransactionFeeRole;
+    }
+    if (changedFields & TransactionHistoryStore::ChangedPending) {
+        roles << TransactionPendingRole;
+    }
+    if (changedFields & TransactionHistoryStore::ChangedTimestamp) {
+        roles << TransactionTimeStampRole << TransactionDateRole << TransactionTimeRole;
+    }
+    if (changedFields & TransactionHistoryStore::ChangedLabel) {
+        roles << TransactionLabelRole;
+    }
+    if (changedFields & TransactionHistoryStore::ChangedTransfers) {
+        roles << TransactionDestinationsRole;
+    }
+    return roles;
+}
+
+QVariant TransactionHistoryModel::parseTransactionInfo(const TransactionHistoryStore &rows, int row, int role) const
 {
     switch (role)
     {
     case TransactionDirectionRole:
-        return QVariant::fromValue(tInfo.direction());
+        return QVariant::fromValue(static_cast<TransactionInfo::Direction>(rows.direction(row)));
     case TransactionPendingRole:
-        return tInfo.isPending();
+        return rows.isPending(row);
     case TransactionFailedRole:
-        return tInfo.isFailed();
+        return rows.isFailed(row);
     case TransactionAmountRole:
-        return tInfo.amount();
+        // there's no unsigned uint64 for JS, so better use double
+        return WalletManager::displayAmountToDouble(rows.amount(row));
     case TransactionDisplayAmountRole:
-        return tInfo.displayAmount();
+        return WalletManager::displayAmount(rows.amount(row));
     case TransactionAtomicAmountRole:
-        return tInfo.atomicAmount();
+        return rows.amount(row);
     case TransactionFeeRole:
-        return tInfo.fee();
+        return rows.fee(row) == 0 ? QString() : WalletManager::displayAmount(rows.fee(row));
     case TransactionBlockHeightRole:
     {
         // Use NULL QVariant for transactions without height.
         // Forces them to be displayed at top when sorted by blockHeight.
-        if (tInfo.blockHeight() != 0)
+        if (rows.blockHeight(row) != 0)
         {
-            return tInfo.blockHeight();
+            return rows.blockHeight(row);
         }
         return QVariant();
     }
     case TransactionSubaddrIndexRole:
     {
         QString str = QString{""};
-        bool first = true;
-        for (quint32 i : tInfo.subaddrIndex())
+        for (int i = 0; i < rows.subaddrIndexCount(row); ++i)
         {
-            if (!first)
+            if (i != 0)
                 str += QString{","};
-            first = false;
-            str += QString::number(i);
+            str += QString::number(rows.subaddrIndex(row, i));
         }
         return str;
     }
     case TransactionSubaddrAccountRole:
-        return tInfo.subaddrAccount();
+        return rows.subaddrAccount(row);
     case TransactionLabelRole:
-        return tInfo.subaddrIndex().size() == 1 && *tInfo.subaddrIndex().begin() == 0 ? tr("Primary address") : tInfo.label();
+        return rows.subaddrIndexCount(row) == 1 && rows.subaddrIndex(row, 0) == 0 ? tr("Primary address") : rows.label(row);
     case TransactionConfirmationsRole:
-        return tInfo.confirmations();
+        return rows.confirmations(row);
     case TransactionConfirmationsRequiredRole:
-        return (tInfo.blockHeight() < tInfo.unlockTime()) ? tInfo.unlockTime() - tInfo.blockHeight() : 10;
+        return rows.requiredConfirmations(row);
     case TransactionHashRole:
-        return tInfo.hash();
+        return rows.hash(row);
     case TransactionTimeStampRole:
-        return tInfo.timestamp();
+        return QDateTime::fromSecsSinceEpoch(rows.timestamp(row));
     case TransactionPaymentIdRole:
-        return tInfo.paymentId();
+        return rows.paymentId(row);
     case TransactionIsOutRole:
-        return tInfo.direction() == TransactionInfo::Direction_Out;
+        return rows.direction(row) == TransactionInfo::Direction_Out;
     case TransactionDateRole:
-        return tInfo.date();
+        return rows.date(row);
     case TransactionTimeRole:
-        return tInfo.time();
+        return rows.time(row);
     case TransactionDestinationsRole:
-        return tInfo.destinations_formatted();
+        return rows.destinations(row);
     default:
     {
         qCritical() << "Unimplemented role" << role;
@@ -136,20 +189,19 @@ QVariant TransactionHistoryModel::data(const QModelIndex &index, int role) const
         return QVariant();
     }
 
-    QVariant result;
-    bool found = m_transactionHistory->transaction(index.row(), [this, &result, &role](const TransactionInfo &tInfo) {
-        result = parseTransactionInfo(tInfo, role);
-    });
-    if (!found) {
+    // rows are mutated on the history's thread only, which is ours
+    const TransactionHistoryStore &rows = m_transactionHistory->rows();
+    if (index.row() < 0 || index.row() >= rows.size()) {
         qCritical("%s: internal error: no transaction info for index %d", __FUNCTION__, index.row());
+        return QVariant();
     }
-    return result;
+    return parseTransactionInfo(rows, index.row(), role);
 }
 
 int TransactionHistoryModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return m_transactionHistory ? m_transactionHistory->count() : 0;
+    return m_transactionHistory ? m_transactionHistory->rows().size() : 0;
 }
 
 QHash<int, QByteArray> TransactionHistoryModel::roleNames() const
@@ -30,9 +30,10 @@
 #define TRANSACTIONHISTORYMODEL_H
 
 #include <QAbstractListModel>
+#include <QVector>
 
 class TransactionHistory;
-class TransactionInfo;
+class TransactionHistoryStore;
 
 /**
  * @brief The TransactionHistoryModel class - read-only list model for Transaction History
@@ -97,7 +98,9 @@ signals:
     void transactionHistoryChanged();
 
 private:
-    QVariant parseTransactionInfo(const TransactionInfo &tInfo, int role) const;
+    QVariant parseTransactionInfo(const TransactionHistoryStore &rows, int row, int role) const;
+    //! maps a TransactionHistoryStore::ChangedField mask to the roles that depend on it
+    static QVector<int> changedRoles(quint32 changedFields);
 
 private:
     TransactionHistory * m_transactionHistory;
@@ -28,49 +28,81 @@
 
 #include "TransactionHistorySortFilterModel.h"
 #include "TransactionHistoryModel.h"
+#include "TransactionHistory.h"
 
+#include "WalletManager.h"
+#include "qt/PerfTrace.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include <QDateTime>
 #include <QDebug>
 #include <QtGlobal>
 
-namespace {
-    /**
-     * helper to extract scope value from filter
-     */
-    template <typename T>
-    T scopeFilterValue(const QMap<int, QVariant> &filters, int role, int scopeIndex)
-    {
-        if (!filters.contains(role)) {
-            return T();
-        }
-        return filters.value(role).toList().at(scopeIndex).value<T>();
-    }
+#include <wallet/api/wallet2_api.h>
 
-    /**
-     * helper to setup scope value to filter
-     */
-    template <typename T>
-    void setScopeFilterValue(QMap<int, QVariant> &filters, int role, int scopeIndex, const T &value)
-    {
-        QVariantList scopeFilter;
+void TransactionHistorySortFilterModel::Filter::compile()
+{
+    hasTimestamp = !dateFrom.isNull() || !dateTo.isNull();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    timestampFrom = dateFrom.isNull() ? std::numeric_limits<qint64>::min() : dateFrom.startOfDay().toSecsSinceEpoch();
+    timestampTo = dateTo.isNull() ? std::numeric_limits<qint64>::max() : dateTo.endOfDay().toSecsSinceEpoch();
+#else
+    timestampFrom = dateFrom.isNull() ? std::numeric_limits<qint64>::min() : QDateTime(dateFrom).toSecsSinceEpoch();
+    timestampTo = dateTo.isNull() ? std::numeric_limits<qint64>::max() : QDateTime(dateTo).addDays(1).toSecsSinceEpoch(); // including upperbound
+#endif
 
-        if (filters.contains(role)) {
-            scopeFilter = filters.value(role).toList();
-        }
-        while (scopeFilter.size() < 2) {
-            scopeFilter.append(T());
-        }
-        scopeFilter[scopeIndex] = QVariant::fromValue(value);
-        filters[role] = scopeFilter;
-    }
+    // non-positive bounds disable the amount filter
+    atomicAmountFrom = amountFrom > 0 ? Monero::Wallet::amountFromDouble(amountFrom) : 0;
+    atomicAmountTo = amountTo > 0 ? Monero::Wallet::amountFromDouble(amountTo) : std::numeric_limits<quint64>::max();
+
+    if (!hasDirection || direction == TransactionInfo::Direction_Both)
+        directionMask = std::numeric_limits<quint32>::max();
+    else
+        directionMask = (direction >= 0 && direction < 32) ? 1u << direction : 0;
 }
 
+bool TransactionHistorySortFilterModel::Filter::accepts(const TransactionHistoryStore &rows, int row) const
+{
+    if (account >= 0 && rows.subaddrAccount(row) != account)
+        return false;
+
+    if (hasPaymentId && !rows.paymentId(row).contains(paymentId))
+        return false;
+
+    if (hasTimestamp && (rows.timestamp(row) < timestampFrom || rows.timestamp(row) > timestampTo))
+        return false;
+
+    if (rows.amount(row) < atomicAmountFrom || rows.amount(row) > atomicAmountTo)
+        return false;
+
+    if (!(directionMask & (1u << rows.direction(row))))
+        return false;
+
+    return searchNeedle.isEmpty() || rows.searchText(row).contains(searchNeedle);
+}
 
 TransactionHistorySortFilterModel::TransactionHistorySortFilterModel(QObject *parent)
     : QSortFilterProxyModel(parent)
+    , m_allAccounts(false)
+    , m_pageSize(0)
+    , m_pageLimit(0)
+    , m_generation(0)
+    , m_filterGeneration(0)
+    , m_updateRunning(false)
+    , m_scheduler(this)
 {
+    m_filter.compile();
     setDynamicSortFilter(true);
 }
 
+TransactionHistorySortFilterModel::~TransactionHistorySortFilterModel()
+{
+    m_scheduler.shutdownWaitForFinished();
+}
+
 QString TransactionHistorySortFilterModel::searchFilter() const
 {
     return m_searchString;
@@ -80,99 +112,147 @@ void TransactionHistorySortFilterModel::setSearchFilter(const QString &arg)
 {
     if (searchFilter() != arg) {
         m_searchString = arg;
+        m_filter.searchNeedle = arg.toLower();
         emit searchFilterChanged();
-        invalidateFilter();
+        updateFilter();
     }
 }
 
 QString TransactionHistorySortFilterModel::paymentIdFilter() const
 {
-    return m_filterValues.value(TransactionHistoryModel::TransactionPaymentIdRole).toString();
+    return m_filter.paymentId;
 }
 
 void TransactionHistorySortFilterModel::setPaymentIdFilter(const QString &arg)
 {
     if (paymentIdFilter() != arg) {
-        m_filterValues[TransactionHistoryModel::TransactionPaymentIdRole] = arg;
+        m_filter.paymentId = arg;
+        m_filter.hasPaymentId = true;
         emit paymentIdFilterChanged();
-        invalidateFilter();
+        updateFilter();
     }
 }
 
 QDate TransactionHistorySortFilterModel::dateFromFilter() const
 {
-    return scopeFilterValue<QDate>(m_filterValues, TransactionHistoryModel::TransactionTimeStampRole, ScopeIndex::From);
+    return m_filter.dateFrom;
 }
 
 void TransactionHistorySortFilterModel::setDateFromFilter(const QDate &date)
 {
     if (date != dateFromFilter()) {
-        setScopeFilterValue(m_filterValues, TransactionHistoryModel::TransactionTimeStampRole, ScopeIndex::From, date);
+        m_filter.dateFrom = date;
         emit dateFromFilterChanged();
-        invalidateFilter();
+        updateFilter();
     }
 }
 
 QDate TransactionHistorySortFilterModel::dateToFilter() const
 {
-    return scopeFilterValue<QDate>(m_filterValues, TransactionHistoryModel::TransactionTimeStampRole, ScopeIndex::To);
+    return m_filter.dateTo;
 }
 
 void TransactionHistorySortFilterModel::setDateToFilter(const QDate &date)
 {
     if (date != dateToFilter()) {
-        setScopeFilterValue(m_filterValues, TransactionHistoryModel::TransactionTimeStampRole, ScopeIndex::To, date);
+        m_filter.dateTo = date;
         emit dateToFilterChanged();
-        invalidateFilter();
+        updateFilter();
     }
 }
 
 double TransactionHistorySortFilterModel::amountFromFilter() const
 {
-    return scopeFilterValue<double>(m_filterValues, TransactionHistoryModel::TransactionAmountRole, ScopeIndex::From);
+    return m_filter.amountFrom;
 }
 
 void TransactionHistorySortFilterModel::setAmountFromFilter(double value)
 {
     if (value != amountFromFilter()) {
-        setScopeFilterValue(m_filterValues, TransactionHistoryModel::TransactionAmountRole, ScopeIndex::From, value);
+        m_filter.amountFrom = value;
         emit amountFromFilterChanged();
-        invalidateFilter();
+        updateFilter();
     }
 }
 
 double TransactionHistorySortFilterModel::amountToFilter() const
 {
-    return scopeFilterValue<double>(m_filterValues, TransactionHistoryModel::TransactionAmountRole, ScopeIndex::To);
+    return m_filter.amountTo;
 }
 
 void TransactionHistorySortFilterModel::setAmountToFilter(double value)
 {
     if (value != amountToFilter()) {
-        setScopeFilterValue(m_filterValues, TransactionHistoryModel::TransactionAmountRole, ScopeIndex::To, value);
+        m_filter.amountTo = value;
         emit amountToFilterChanged();
-        invalidateFilter();
+        updateFilter();
     }
 }
 
 int TransactionHistorySortFilterModel::directionFilter() const
 {
-    return m_filterValues.value(TransactionHistoryModel::TransactionDirectionRole).value<TransactionInfo::Direction>();
+    return m_filter.direction;
 }
 
 void TransactionHistorySortFilterModel::setDirectionFilter(int value)
 {
     if (value != directionFilter()) {
-        m_filterValues[TransactionHistoryModel::TransactionDirectionRole] = QVariant::fromValue(value);
+        m_filter.direction = value;
+        m_filter.hasDirection = true;
         emit directionFilterChanged();
-        invalidateFilter();
+        updateFilter();
+    }
+}
+
+bool TransactionHistorySortFilterModel::allAccounts() const
+{
+    return m_allAccounts;
+}
+
+void TransactionHistorySortFilterModel::setAllAccounts(bool value)
+{
+    if (value != allAccounts()) {
+        m_allAccounts = value;
+        emit allAccountsChanged();
+        updateFilter();
     }
 }
 
+int TransactionHistorySortFilterModel::pageSize() const
+{
+    return m_pageSize;
+}
+
+void TransactionHistorySortFilterModel::setPageSize(int value)
+{
+    value = std::max(value, 0);
+    if (value != pageSize()) {
+        m_pageSize = value;
+        m_pageLimit = value;
+        emit pageSizeChanged();
+        invalidatePage();
+    }
+}
+
+int TransactionHistorySortFilterModel::totalCount() const
+{
+    return m_published.totalCount;
+}
 
 void TransactionHistorySortFilterModel::sort(int column, Qt::SortOrder order)
 {
     QSortFilterProxyModel::sort(column, order);
+    // a page holds the first rows in sort order, so it has to be cut again
+    if (m_pageSize > 0 && (m_published.sortRole != sortRole() || m_published.sortOrder != order))
+    {
+        m_pageLimit = m_pageSize;
+        invalidatePage();
+    }
+    // ranks are published per sort role
+    else if (m_published.sortRole != sortRole())
+    {
+        scheduleUpdate();
+    }
 }
 
 TransactionHistory *TransactionHistorySortFilterModel::transactionHistory() const
@@ -181,105 +261,304 @@ TransactionHistory *TransactionHistorySortFilterModel::transactionHistory() cons
     return model->transactionHistory();
 }
 
+void TransactionHistorySortFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (this->sourceModel())
+    {
+        disconnect(this->sourceModel(), nullptr, this, nullptr);
+        if (transactionHistory())
+        {
+            disconnect(transactionHistory(), nullptr, this, nullptr);
+        }
+    }
+
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+
+    if (sourceModel)
+    {
+        // switching accounts is a filter change, the rows of every account are there already
+        if (TransactionHistory *history = transactionHistory())
+        {
+            connect(history, &TransactionHistory::accountIndexChanged, this, [this] {
+                if (!m_allAccounts)
+                {
+                    updateFilter();
+                }
+            });
+        }
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &TransactionHistorySortFilterModel::scheduleUpdate);
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &, int first, int last) {
+            // keep the published results aligned with the source rows
+            if (first < m_published.stamps.size())
+            {
+                const int count = std::min(last, static_cast<int>(m_published.stamps.size()) - 1) - first + 1;
+                m_published.stamps.remove(first, count);
+                m_published.accepted.remove(first, count);
+                if (!m_published.ranks.isEmpty())
+                {
+                    m_published.ranks.remove(first, count);
+                }
+            }
+            scheduleUpdate();
+        });
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, &TransactionHistorySortFilterModel::scheduleUpdate);
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, &TransactionHistorySortFilterModel::scheduleUpdate);
+    }
+    // picks up the account of the new history
+    updateFilter();
+}
+
+bool TransactionHistorySortFilterModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return false;
+    }
+    return m_pageLimit > 0 && m_published.pageLimit == m_pageLimit && m_published.totalCount > m_pageLimit;
+}
+
+void TransactionHistorySortFilterModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent))
+    {
+        fetchRows(m_pageLimit + m_pageSize);
+    }
+}
+
+bool TransactionHistorySortFilterModel::fetchRows(int count)
+{
+    if (m_pageSize <= 0 || count <= m_pageLimit || m_published.totalCount <= m_pageLimit)
+    {
+        return false;
+    }
+    // whole pages, so a jump doesn't leave a partial one behind
+    m_pageLimit = (count + m_pageSize - 1) / m_pageSize * m_pageSize;
+    invalidatePage();
+    return true;
+}
+
 bool TransactionHistorySortFilterModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
+    Q_UNUSED(source_parent)
 
-    if (source_row < 0 || source_row >= sourceModel()->rowCount()) {
+    const TransactionHistory *history = transactionHistory();
+    if (!history || source_row < 0 || source_row >= history->rows().size()) {
         return false;
     }
 
-    QModelIndex index = sourceModel()->index(source_row, 0, source_parent);
-    if (!index.isValid()) {
+    // rows that changed after the last background pass are evaluated in place,
+    // a page may briefly grow by those until the next pass cuts it again
+    if (publishedRowValid(history->rows(), source_row)) {
+        return m_published.accepted[source_row];
+    }
+    return m_filter.accepts(history->rows(), source_row);
+}
+
+bool TransactionHistorySortFilterModel::rowLessThan(const TransactionHistoryStore &rows, int sortRole, int left, int right, bool &supported)
+{
+    supported = true;
+    switch (sortRole)
+    {
+    case TransactionHistoryModel::TransactionBlockHeightRole:
+        // height 0 is exposed as a NULL QVariant which sorts after every valid value
+        if (rows.blockHeight(left) != rows.blockHeight(right))
+        {
+            if (rows.blockHeight(left) == 0)
+                return false;
+            if (rows.blockHeight(right) == 0)
+                return true;
+            return rows.blockHeight(left) < rows.blockHeight(right);
+        }
+        break;
+    case TransactionHistoryModel::TransactionTimeStampRole:
+        if (rows.timestamp(left) != rows.timestamp(right))
+            return rows.timestamp(left) < rows.timestamp(right);
+        break;
+    case TransactionHistoryModel::TransactionAmountRole:
+    case TransactionHistoryModel::TransactionAtomicAmountRole:
+        if (rows.amount(left) != rows.amount(right))
+            return rows.amount(left) < rows.amount(right);
+        break;
+    case TransactionHistoryModel::TransactionConfirmationsRole:
+        if (rows.confirmations(left) != rows.confirmations(right))
+            return rows.confirmations(left) < rows.confirmations(right);
+        break;
+    default:
+        supported = false;
         return false;
     }
 
-    bool result = true;
-
-    // iterating through filters
-    for (int role : m_filterValues.keys()) {
-        if (m_filterValues.contains(role)) {
-            QVariant data = sourceModel()->data(index, role);
-            switch (role) {
-            case TransactionHistoryModel::TransactionPaymentIdRole:
-                result = data.toString().contains(paymentIdFilter());
-                break;
-            case TransactionHistoryModel::TransactionTimeStampRole:
-            {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-                QDateTime from = dateFromFilter().startOfDay();
-                QDateTime to = dateToFilter().endOfDay();
-#else
-                QDateTime from = QDateTime(dateFromFilter());
-                QDateTime to   = QDateTime(dateToFilter());
-                to = to.addDays(1); // including upperbound
-#endif
-                QDateTime timestamp = data.toDateTime();
-                bool matchFrom = from.isNull() || timestamp.isNull() || timestamp >= from;
-                bool matchTo = to.isNull() || timestamp.isNull() || timestamp <= to;
-                result = matchFrom && matchTo;
-            }
-                break;
-            case TransactionHistoryModel::TransactionAmountRole:
-            {
-                double from = amountFromFilter();
-                double to = amountToFilter();
-                double amount = data.toDouble();
+    // ties keep the source order, as published ranks do
+    return left < right;
+}
 
-                bool matchFrom = from <= 0 || amount  >= from;
-                bool matchTo = to <= 0 || amount <= to;
-                result = matchFrom && matchTo;
-            }
-                break;
-            case TransactionHistoryModel::TransactionDirectionRole:
-                result = directionFilter() == TransactionInfo::Direction_Both ? true
-                                                  : data.toInt() == directionFilter();
+bool TransactionHistorySortFilterModel::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
+{
+    const TransactionHistory *history = sourceModel() ? transactionHistory() : nullptr;
+    if (history && source_left.row() < history->rows().size() && source_right.row() < history->rows().size())
+    {
+        const TransactionHistoryStore &rows = history->rows();
+        const int left = source_left.row();
+        const int right = source_right.row();
+        if (m_published.sortRole == sortRole() && !m_published.ranks.isEmpty() &&
+            publishedRowValid(rows, left) && publishedRowValid(rows, right))
+        {
+            return m_published.ranks[left] < m_published.ranks[right];
+        }
 
+        bool supported;
+        const bool result = rowLessThan(rows, sortRole(), left, right, supported);
+        if (supported)
+        {
+            return result;
+        }
+    }
 
-                break;
+    return QSortFilterProxyModel::lessThan(source_left, source_right);
+}
 
-            default:
-                break;
-            }
+bool TransactionHistorySortFilterModel::publishedRowValid(const TransactionHistoryStore &rows, int row) const
+{
+    return row < m_published.stamps.size() && m_published.stamps[row] == rows.stamp(row);
+}
 
+void TransactionHistorySortFilterModel::updateFilter()
+{
+    const TransactionHistory *history = sourceModel() ? transactionHistory() : nullptr;
+    m_filter.account = m_allAccounts || !history ? -1 : history->accountIndex();
+    m_filter.compile();
+    // a new filter starts over from the first page
+    m_pageLimit = m_pageSize;
+    invalidatePage();
+}
+
+void TransactionHistorySortFilterModel::invalidatePage()
+{
+    // published acceptance stays in effect until the new pass is published
+    ++m_filterGeneration;
+    scheduleUpdate();
+}
+
+void TransactionHistorySortFilterModel::scheduleUpdate()
+{
+    ++m_generation;
+    // the running pass restarts itself once it notices it is stale
+    if (!m_updateRunning)
+    {
+        startUpdate();
+    }
+}
+
+void TransactionHistorySortFilterModel::startUpdate()
+{
+    const TransactionHistory *history = sourceModel() ? transactionHistory() : nullptr;
+    if (!history)
+    {
+        return;
+    }
+
+    // implicitly shared, the worker reads a consistent snapshot while the
+    // history keeps mutating its own copy
+    const TransactionHistoryStore rows = history->rows();
+    const Filter filter = m_filter;
+    const int role = sortRole();
+    const Qt::SortOrder order = sortOrder();
+    const int pageLimit = m_pageLimit;
+    const quint64 generation = m_generation;
+    const quint64 filterGeneration = m_filterGeneration;
+
+    m_updateRunning = true;
+    const auto future = m_scheduler.run([this, rows, filter, role, order, pageLimit, generation, filterGeneration] {
+        const PerfScope perf("history filter and sort", rows.size());
+        Published result;
+        result.generation = generation;
+        result.filterGeneration = filterGeneration;
+        result.sortRole = role;
+        result.sortOrder = order;
+        result.pageLimit = pageLimit;
+        result.stamps.resize(rows.size());
+        result.accepted.resize(rows.size());
+        for (int row = 0; row < rows.size(); ++row)
+        {
+            result.stamps[row] = rows.stamp(row);
+            result.accepted[row] = filter.accepts(rows, row);
+            result.totalCount += result.accepted[row];
+        }
+
+        QVector<int> sorted(rows.size());
+        std::iota(sorted.begin(), sorted.end(), 0);
+        bool supported = true;
+        std::sort(sorted.begin(), sorted.end(), [&rows, role, &supported](int left, int right) {
+            return rowLessThan(rows, role, left, right, supported);
+        });
+        if (supported)
+        {
+            result.ranks.resize(rows.size());
+            for (int rank = 0; rank < sorted.size(); ++rank)
+            {
+                result.ranks[sorted[rank]] = rank;
+            }
 
-            if (!result) { // stop the loop once filter doesn't match
-                break;
+            // keep only the first page worth of accepted rows in the proxy's order
+            if (pageLimit > 0 && result.totalCount > pageLimit)
+            {
+                if (order == Qt::DescendingOrder)
+                {
+                    std::reverse(sorted.begin(), sorted.end());
+                }
+                int kept = 0;
+                for (const int row : sorted)
+                {
+                    if (result.accepted[row] && ++kept > pageLimit)
+                    {
+                        result.accepted[row] = false;
+                    }
+                }
             }
         }
-    }
+        else
+        {
+            // rows can't be cut without a packed sort column, everything is one page
+            result.pageLimit = 0;
+        }
 
-    if (!result || m_searchString.isEmpty())
-        return result;
-
-    QVariant data = sourceModel()->data(index, TransactionHistoryModel::TransactionPaymentIdRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-    data = sourceModel()->data(index, TransactionHistoryModel::TransactionDisplayAmountRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-    data = sourceModel()->data(index, TransactionHistoryModel::TransactionBlockHeightRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-    data = sourceModel()->data(index, TransactionHistoryModel::TransactionFeeRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-    data = sourceModel()->data(index, TransactionHistoryModel::TransactionHashRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-    data = sourceModel()->data(index, TransactionHistoryModel::TransactionDateRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-    data = sourceModel()->data(index, TransactionHistoryModel::TransactionTimeRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-    data = sourceModel()->data(index, TransactionHistoryModel::TransactionDestinationsRole);
-    if (data.toString().contains(m_searchString))
-        return true;
-
-    return false;
+        QMetaObject::invokeMethod(this, [this, result] {
+            finishUpdate(result);
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::Interactive, "TransactionHistorySortFilterModel::startUpdate");
+    if (!future.first)
+    {
+        m_updateRunning = false;
+    }
 }
 
-bool TransactionHistorySortFilterModel::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
+void TransactionHistorySortFilterModel::finishUpdate(const Published &result)
 {
-    return QSortFilterProxyModel::lessThan(source_left, source_right);
+    m_updateRunning = false;
+    if (result.generation != m_generation)
+    {
+        startUpdate();
+        return;
+    }
+
+    // source changes are already applied by the proxy itself (rows that
+    // changed since the last pass are evaluated in place), only a new
+    // filter needs the proxy to re-run, which is now a lookup per row
+    const bool filterChanged = m_published.filterGeneration != result.filterGeneration;
+    // new rows can push others out of a page, which the proxy can't tell on its own
+    const bool pageChanged = result.pageLimit > 0 && m_published.accepted != result.accepted;
+    const bool totalChanged = m_published.totalCount != result.totalCount;
+    m_published = result;
+    if (filterChanged || pageChanged)
+    {
+        invalidateFilter();
+    }
+    if (totalChanged)
+    {
+        emit totalCountChanged();
+    }
+    if (filterChanged || pageChanged)
+    {
+        emit pageUpdated();
+    }
 }
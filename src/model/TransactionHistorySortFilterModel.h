@@ -30,14 +30,16 @@
 #define TRANSACTIONHISTORYSORTFILTERMODEL_H
 
 #include "TransactionInfo.h"
+#include "qt/FutureScheduler.h"
 
 #include <QSortFilterProxyModel>
-#include <QMap>
 #include <QVariant>
+#include <QVector>
 #include <QDate>
 
 
 class TransactionHistory;
+class TransactionHistoryStore;
 
 class TransactionHistorySortFilterModel: public QSortFilterProxyModel
 {
@@ -49,11 +51,15 @@ class TransactionHistorySortFilterModel: public QSortFilterProxyModel
     Q_PROPERTY(double amountFromFilter READ amountFromFilter WRITE setAmountFromFilter NOTIFY amountFromFilterChanged)
     Q_PROPERTY(double amountToFilter READ amountToFilter WRITE setAmountToFilter NOTIFY amountToFilterChanged)
     Q_PROPERTY(int directionFilter READ directionFilter WRITE setDirectionFilter NOTIFY directionFilterChanged)
+    Q_PROPERTY(bool allAccounts READ allAccounts WRITE setAllAccounts NOTIFY allAccountsChanged)
+    Q_PROPERTY(int pageSize READ pageSize WRITE setPageSize NOTIFY pageSizeChanged)
+    Q_PROPERTY(int totalCount READ totalCount NOTIFY totalCountChanged)
 
     Q_PROPERTY(TransactionHistory * transactionHistory READ transactionHistory)
 
 public:
     TransactionHistorySortFilterModel(QObject * parent = nullptr);
+    ~TransactionHistorySortFilterModel();
     //! filtering by string search
     QString searchFilter() const;
     void setSearchFilter(const QString &arg);
@@ -82,9 +88,28 @@ public:
     int directionFilter() const;
     void setDirectionFilter(int value);
 
+    //! rows of every account instead of those of TransactionHistory::accountIndex
+    bool allAccounts() const;
+    void setAllAccounts(bool value);
+
+    //! rows accepted per fetchMore() step, 0 accepts every matching row at once
+    int pageSize() const;
+    void setPageSize(int value);
+
+    //! rows matching the filters, including those not fetched yet
+    int totalCount() const;
+
+    //! grows the page to at least count rows, false if they are already there
+    Q_INVOKABLE bool fetchRows(int count);
+
     Q_INVOKABLE void sort(int column, Qt::SortOrder order);
     TransactionHistory * transactionHistory() const;
 
+    // QSortFilterProxyModel overrides
+    virtual void setSourceModel(QAbstractItemModel *sourceModel) override;
+    Q_INVOKABLE virtual bool canFetchMore(const QModelIndex &parent = QModelIndex()) const override;
+    Q_INVOKABLE virtual void fetchMore(const QModelIndex &parent = QModelIndex()) override;
+
 signals:
     void searchFilterChanged();
     void paymentIdFilterChanged();
@@ -93,6 +118,11 @@ signals:
     void amountFromFilterChanged();
     void amountToFilterChanged();
     void directionFilterChanged();
+    void allAccountsChanged();
+    void pageSizeChanged();
+    void totalCountChanged();
+    //! emitted once the rows of a new filter, sort order or page are in place
+    void pageUpdated();
 
 protected:
     // QSortFilterProxyModel overrides
@@ -101,14 +131,69 @@ protected:
 
 
 private:
-    enum ScopeIndex {
-        From = 0,
-        To   = 1
+    // filter settings as set from QML plus their compiled form, evaluated
+    // against the raw packed columns
+    struct Filter {
+        void compile();
+        bool accepts(const TransactionHistoryStore &rows, int row) const;
+
+        QString paymentId;
+        bool hasPaymentId = false;
+        QDate dateFrom;
+        QDate dateTo;
+        double amountFrom = 0;
+        double amountTo = 0;
+        int direction = 0;
+        bool hasDirection = false;
+        //! negative accepts every account
+        qint64 account = -1;
+        // lowercase search string, matched against TransactionHistoryStore::searchText
+        QString searchNeedle;
+
+        // compiled by compile()
+        bool hasTimestamp = false;
+        qint64 timestampFrom = 0;
+        qint64 timestampTo = 0;
+        quint64 atomicAmountFrom = 0;
+        quint64 atomicAmountTo = 0;
+        quint32 directionMask = 0;
+    };
+
+    // result of a background filter/sort pass, indexed by source row
+    struct Published {
+        quint64 generation = 0;
+        quint64 filterGeneration = 0;
+        int sortRole = -1;
+        Qt::SortOrder sortOrder = Qt::AscendingOrder;
+        //! accepted rows are cut to the first pageLimit in sort order, 0 doesn't cut
+        int pageLimit = 0;
+        int totalCount = 0;
+        //! TransactionHistoryStore::stamp of each row when it was evaluated
+        QVector<quint64> stamps;
+        QVector<bool> accepted;
+        //! position in ascending sortRole order, empty if sortRole isn't a packed column
+        QVector<int> ranks;
     };
 
+    static bool rowLessThan(const TransactionHistoryStore &rows, int sortRole, int left, int right, bool &supported);
+    bool publishedRowValid(const TransactionHistoryStore &rows, int row) const;
+    void updateFilter();
+    void invalidatePage();
+    void scheduleUpdate();
+    void startUpdate();
+    void finishUpdate(const Published &result);
+
 private:
-    QMap<int, QVariant> m_filterValues;
+    Filter m_filter;
+    bool m_allAccounts;
     QString m_searchString;
+    Published m_published;
+    int m_pageSize;
+    int m_pageLimit;
+    quint64 m_generation;
+    quint64 m_filterGeneration;
+    bool m_updateRunning;
+    FutureScheduler m_scheduler;
 };
 
 #endif // TRANSACTIONHISTORYSORTFILTERMODEL_H
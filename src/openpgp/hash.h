@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <cstring>
+#include <stdexcept>
 #include <vector>
 
 #include <gcrypt.h>
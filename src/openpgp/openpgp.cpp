@@ -120,15 +120,15 @@ public_key_block::public_key_block(const epee::span<const uint8_t> buffer)
 {
   packet_stream packets(buffer);
 
-  const std::vector<uint8_t> *data = packets.find_first(packet_tag::type::user_id);
+  const epee::span<const uint8_t> *data = packets.find_first(packet_tag::type::user_id);
   if (data == nullptr)
   {
     throw std::runtime_error("user id is missing");
   }
   m_user_id.assign(data->begin(), data->end());
 
-  const auto append_public_key = [this](const std::vector<uint8_t> &data) {
-    deserializer<std::vector<uint8_t>> serialized(data);
+  const auto append_public_key = [this](const epee::span<const uint8_t> data) {
+    deserializer<epee::span<const uint8_t>> serialized(data);
 
     const auto version = serialized.read_big_endian<uint8_t>();
     if (version != 4)
@@ -174,7 +174,7 @@ signature_rsa::signature_rsa(
   uint8_t algorithm,
   std::pair<uint8_t, uint8_t> hash_leftmost_bytes,
   uint8_t hash_algorithm,
-  const std::vector<uint8_t> &hashed_data,
+  const epee::span<const uint8_t> hashed_data,
   type type,
   s_expression signature,
   uint8_t version)
@@ -202,13 +202,13 @@ signature_rsa signature_rsa::from_buffer(const epee::span<const uint8_t> input)
 {
   packet_stream packets(input);
 
-  const std::vector<uint8_t> *data = packets.find_first(packet_tag::type::signature);
+  const epee::span<const uint8_t> *data = packets.find_first(packet_tag::type::signature);
   if (data == nullptr)
   {
     throw std::runtime_error("signature is missing");
   }
 
-  deserializer<std::vector<uint8_t>> buffer(*data);
+  deserializer<epee::span<const uint8_t>> buffer(*data);
 
   const auto version = buffer.read_big_endian<uint8_t>();
   if (version != 4)
@@ -227,7 +227,7 @@ signature_rsa signature_rsa::from_buffer(const epee::span<const uint8_t> input)
   const auto hash_algorithm = buffer.read_big_endian<uint8_t>();
 
   const auto hashed_data_length = buffer.read_big_endian<uint16_t>();
-  std::vector<uint8_t> hashed_data = buffer.read(hashed_data_length);
+  const epee::span<const uint8_t> hashed_data = buffer.read_span(hashed_data_length);
 
   const auto unhashed_data_length = buffer.read_big_endian<uint16_t>();
   buffer.read_span(unhashed_data_length);
@@ -246,48 +246,91 @@ signature_rsa signature_rsa::from_buffer(const epee::span<const uint8_t> input)
     version);
 }
 
-bool signature_rsa::verify(const epee::span<const uint8_t> message, const public_key_rsa &public_key) const
+signature_rsa::verifier::verifier(const signature_rsa &signature)
+  : m_signature(signature)
+  , m_hash(signature.m_hash_algorithm)
+  , m_pending_line_break(false)
 {
-  const s_expression signed_data = hash_message(message, public_key.bits());
-  return gcry_pk_verify(m_signature.get(), signed_data.get(), public_key.get()) == 0;
+  if (m_signature.m_type != type::binary_document && m_signature.m_type != type::canonical_text_document)
+  {
+    throw std::runtime_error("unsupported signature type");
+  }
 }
 
-s_expression signature_rsa::hash_message(const epee::span<const uint8_t> message, size_t public_key_bits) const
+signature_rsa::verifier &signature_rsa::verifier::operator<<(const epee::span<const uint8_t> chunk)
 {
-  switch (m_type)
+  if (!m_digest.empty())
+  {
+    throw std::runtime_error("message digest is already finalized");
+  }
+
+  if (m_signature.m_type == type::binary_document)
   {
-  case type::binary_document:
-    return hash_bytes(message, public_key_bits);
-  case type::canonical_text_document:
+    write(chunk.data(), chunk.size());
+    return *this;
+  }
+
+  // canonical text: CR is dropped, LF becomes CRLF except for the final one,
+  // which is only known to be final once more bytes arrive or verify() is called
+  const size_t chunk_size = chunk.size();
+  size_t run_begin = 0;
+  for (size_t offset = 0; offset < chunk_size; ++offset)
   {
-    std::vector<uint8_t> crlf_formatted;
-    crlf_formatted.reserve(message.size());
-    const size_t message_size = message.size();
-    for (size_t offset = 0; offset < message_size; ++offset)
+    if (m_pending_line_break)
+    {
+      static constexpr const uint8_t crlf[] = {'\r', '\n'};
+      write(crlf, sizeof(crlf));
+      m_pending_line_break = false;
+    }
+
+    const auto &character = chunk[offset];
+    if (character == '\r' || character == '\n')
     {
-      const auto &character = message[offset];
-      if (character == '\r')
-      {
-        continue;
-      }
-      if (character == '\n')
-      {
-        const bool skip_last_crlf = offset + 1 == message_size;
-        if (skip_last_crlf)
-        {
-          break;
-        }
-        crlf_formatted.push_back('\r');
-      }
-      crlf_formatted.push_back(character);
+      write(chunk.data() + run_begin, offset - run_begin);
+      run_begin = offset + 1;
+      m_pending_line_break = character == '\n';
     }
-    return hash_bytes(epee::to_span(crlf_formatted), public_key_bits);
   }
-  default:
-    throw std::runtime_error("unsupported signature type");
+  write(chunk.data() + run_begin, chunk_size - run_begin);
+
+  return *this;
+}
+
+bool signature_rsa::verifier::verify(const public_key_rsa &public_key)
+{
+  if (m_digest.empty())
+  {
+    m_hash << m_signature.m_hashed_appendix;
+    m_digest = m_hash.finish();
+    if (m_digest.size() < 2)
+    {
+      throw std::runtime_error("insufficient message hash size");
+    }
+  }
+  if (m_digest[0] != m_signature.m_hash_leftmost_bytes.first || m_digest[1] != m_signature.m_hash_leftmost_bytes.second)
+  {
+    throw std::runtime_error("signature checksum doesn't match the expected value");
+  }
+
+  const s_expression signed_data = m_signature.encode_digest(m_digest, public_key.bits());
+  return gcry_pk_verify(m_signature.m_signature.get(), signed_data.get(), public_key.get()) == 0;
+}
+
+void signature_rsa::verifier::write(const uint8_t *data, size_t size)
+{
+  if (size != 0)
+  {
+    m_hash << epee::span<const uint8_t>(data, size);
   }
 }
 
+bool signature_rsa::verify(const epee::span<const uint8_t> message, const public_key_rsa &public_key) const
+{
+  verifier message_verifier(*this);
+  message_verifier << message;
+  return message_verifier.verify(public_key);
+}
+
 std::vector<uint8_t> signature_rsa::hash_asn_object_id() const
 {
   size_t size;
@@ -305,18 +348,8 @@ std::vector<uint8_t> signature_rsa::hash_asn_object_id() const
   return asn_object_id;
 }
 
-s_expression signature_rsa::hash_bytes(const epee::span<const uint8_t> message, size_t public_key_bits) const
+s_expression signature_rsa::encode_digest(const std::vector<uint8_t> &plain_hash, size_t public_key_bits) const
 {
-  const std::vector<uint8_t> plain_hash = (hash(m_hash_algorithm) << message << m_hashed_appendix).finish();
-  if (plain_hash.size() < 2)
-  {
-    throw std::runtime_error("insufficient message hash size");
-  }
-  if (plain_hash[0] != m_hash_leftmost_bytes.first || plain_hash[1] != m_hash_leftmost_bytes.second)
-  {
-    throw std::runtime_error("signature checksum doesn't match the expected value");
-  }
-
   std::vector<uint8_t> asn_object_id = hash_asn_object_id();
 
   const size_t public_key_bytes = bits_to_bytes(public_key_bits);
@@ -342,7 +375,7 @@ s_expression signature_rsa::hash_bytes(const epee::span<const uint8_t> message,
 std::vector<uint8_t> signature_rsa::format_hashed_appendix(
   uint8_t algorithm,
   uint8_t hash_algorithm,
-  const std::vector<uint8_t> &hashed_data,
+  const epee::span<const uint8_t> hashed_data,
   uint8_t type,
   uint8_t version)
 {
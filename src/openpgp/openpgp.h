@@ -35,6 +35,7 @@
 
 #include <span.h>
 
+#include "hash.h"
 #include "s_expression.h"
 
 namespace openpgp
@@ -83,11 +84,32 @@ public:
     uint8_t algorithm,
     std::pair<uint8_t, uint8_t> hash_leftmost_bytes,
     uint8_t hash_algorithm,
-    const std::vector<uint8_t> &hashed_data,
+    const epee::span<const uint8_t> hashed_data,
     type type,
     s_expression signature,
     uint8_t version);
 
+  // Incremental verification, the message is fed in chunks of any size.
+  // The signature must outlive the verifier.
+  class verifier
+  {
+  public:
+    verifier(const signature_rsa &signature);
+
+    verifier &operator<<(const epee::span<const uint8_t> chunk);
+    // no more chunks can be fed after the first call
+    bool verify(const public_key_rsa &public_key);
+
+  private:
+    void write(const uint8_t *data, size_t size);
+
+  private:
+    const signature_rsa &m_signature;
+    hash m_hash;
+    bool m_pending_line_break;
+    std::vector<uint8_t> m_digest;
+  };
+
   static signature_rsa from_armored(const std::string &armored_signed_message);
   static signature_rsa from_base64(const std::string &base64);
   static signature_rsa from_buffer(const epee::span<const uint8_t> input);
@@ -95,14 +117,13 @@ public:
   bool verify(const epee::span<const uint8_t> message, const public_key_rsa &public_key) const;
 
 private:
-  s_expression hash_message(const epee::span<const uint8_t> message, size_t public_key_bits) const;
   std::vector<uint8_t> hash_asn_object_id() const;
-  s_expression hash_bytes(const epee::span<const uint8_t> message, size_t public_key_bits) const;
+  s_expression encode_digest(const std::vector<uint8_t> &plain_hash, size_t public_key_bits) const;
 
   static std::vector<uint8_t> format_hashed_appendix(
     uint8_t algorithm,
     uint8_t hash_algorithm,
-    const std::vector<uint8_t> &hashed_data,
+    const epee::span<const uint8_t> hashed_data,
     uint8_t type,
     uint8_t version);
 
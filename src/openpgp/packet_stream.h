@@ -37,27 +37,21 @@
 namespace openpgp
 {
 
+// Packets are views into the parsed buffer, which must outlive the stream
 class packet_stream
 {
 public:
   packet_stream(const epee::span<const uint8_t> buffer)
-    : packet_stream(deserializer<epee::span<const uint8_t>>(buffer))
   {
-  }
-
-  template <
-    typename byte_container,
-    typename = typename std::enable_if<(sizeof(typename byte_container::value_type) == 1)>::type>
-  packet_stream(deserializer<byte_container> buffer)
-  {
-    while (!buffer.empty())
+    deserializer<epee::span<const uint8_t>> serialized(buffer);
+    while (!serialized.empty())
     {
-      packet_tag tag = buffer.read_packet_tag();
-      packets.push_back({std::move(tag), buffer.read(tag.length)});
+      packet_tag tag = serialized.read_packet_tag();
+      packets.push_back({std::move(tag), serialized.read_span(tag.length)});
     }
   }
 
-  const std::vector<uint8_t> *find_first(packet_tag::type type) const
+  const epee::span<const uint8_t> *find_first(packet_tag::type type) const
   {
     for (const auto &packet : packets)
     {
@@ -82,7 +76,7 @@ public:
   }
 
 private:
-  std::vector<std::pair<packet_tag, std::vector<uint8_t>>> packets;
+  std::vector<std::pair<packet_tag, epee::span<const uint8_t>>> packets;
 };
 
 } // namespace openpgp
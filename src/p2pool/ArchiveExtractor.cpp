@@ -0,0 +1,509 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "ArchiveExtractor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <zlib.h>
+
+namespace
+{
+
+constexpr qint64 ARCHIVE_CHUNK_SIZE = 64 * 1024;
+constexpr int TAR_BLOCK_SIZE = 512;
+
+// Inflates a gzip stream read from file, one chunk at a time
+class GzipReader
+{
+public:
+    explicit GzipReader(QFile &file)
+        : m_file(file)
+        , m_input(ARCHIVE_CHUNK_SIZE)
+    {
+        std::memset(&m_stream, 0, sizeof(m_stream));
+        // 16 selects the gzip wrapper
+        m_initialized = inflateInit2(&m_stream, 15 + 16) == Z_OK;
+    }
+
+    ~GzipReader()
+    {
+        if (m_initialized)
+        {
+            inflateEnd(&m_stream);
+        }
+    }
+
+    // reads exactly size bytes, fails on a truncated or corrupt stream
+    bool read(char *output, size_t size)
+    {
+        if (!m_initialized)
+        {
+            return false;
+        }
+
+        m_stream.next_out = reinterpret_cast<Bytef *>(output);
+        m_stream.avail_out = static_cast<uInt>(size);
+        while (m_stream.avail_out > 0)
+        {
+            if (m_stream.avail_in == 0)
+            {
+                const qint64 read = m_file.read(m_input.data(), ARCHIVE_CHUNK_SIZE);
+                if (read <= 0)
+                {
+                    return false;
+                }
+                m_stream.next_in = reinterpret_cast<Bytef *>(m_input.data());
+                m_stream.avail_in = static_cast<uInt>(read);
+            }
+
+            const int result = inflate(&m_stream, Z_NO_FLUSH);
+            if (result == Z_STREAM_END)
+            {
+                // concatenated gzip members continue the same stream
+                if (inflateReset(&m_stream) != Z_OK)
+                {
+                    return false;
+                }
+            }
+            else if (result != Z_OK)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool skip(qint64 size)
+    {
+        char buffer[TAR_BLOCK_SIZE * 16];
+        while (size > 0)
+        {
+            const qint64 chunk = std::min<qint64>(size, sizeof(buffer));
+            if (!read(buffer, chunk))
+            {
+                return false;
+            }
+            size -= chunk;
+        }
+        return true;
+    }
+
+private:
+    QFile &m_file;
+    std::vector<char> m_input;
+    z_stream m_stream;
+    bool m_initialized;
+};
+
+quint64 parseOctal(const char *field, size_t size)
+{
+    quint64 value = 0;
+    for (size_t i = 0; i < size && field[i] != '\0' && field[i] != ' '; ++i)
+    {
+        if (field[i] < '0' || field[i] > '7')
+        {
+            break;
+        }
+        value = (value << 3) | static_cast<quint64>(field[i] - '0');
+    }
+    return value;
+}
+
+QString headerString(const char *field, size_t size)
+{
+    return QString::fromUtf8(field, static_cast<qsizetype>(strnlen(field, size)));
+}
+
+qint64 paddedSize(qint64 size)
+{
+    return (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+}
+
+bool createParent(const QString &path)
+{
+    return QDir().mkpath(QFileInfo(path).absolutePath());
+}
+
+void setExecutable(const QString &path, bool executable)
+{
+    if (executable)
+    {
+        QFile::setPermissions(path, QFile::permissions(path) | QFileDevice::ExeOwner | QFileDevice::ExeGroup | QFileDevice::ExeOther);
+    }
+}
+
+} // namespace
+
+bool ArchiveExtractor::extract(const QString &archivePath, const QString &destination, int stripComponents, QString &error)
+{
+    if (archivePath.endsWith(".tar.gz") || archivePath.endsWith(".tgz"))
+    {
+        return extractTarGz(archivePath, destination, stripComponents, error);
+    }
+    if (archivePath.endsWith(".zip"))
+    {
+        return extractZip(archivePath, destination, stripComponents, error);
+    }
+    error = "unsupported archive format";
+    return false;
+}
+
+QString ArchiveExtractor::entryPath(const QString &destination, const QString &name, int stripComponents)
+{
+    QStringList components = QDir::fromNativeSeparators(name).split('/', Qt::SkipEmptyParts);
+    if (components.size() <= stripComponents)
+    {
+        return {};
+    }
+    components.erase(components.begin(), components.begin() + stripComponents);
+
+    for (const QString &component : components)
+    {
+        if (component == ".." || component.contains(':'))
+        {
+            return {};
+        }
+    }
+    if (name.startsWith('/'))
+    {
+        return {};
+    }
+
+    return QDir(destination).filePath(components.join('/'));
+}
+
+bool ArchiveExtractor::extractTarGz(const QString &archivePath, const QString &destination, int stripComponents, QString &error)
+{
+    QFile archive(archivePath);
+    if (!archive.open(QIODevice::ReadOnly))
+    {
+        error = "failed to open archive";
+        return false;
+    }
+
+    GzipReader reader(archive);
+    std::vector<char> buffer(ARCHIVE_CHUNK_SIZE);
+    char header[TAR_BLOCK_SIZE];
+    QString longName;
+    for (;;)
+    {
+        if (!reader.read(header, TAR_BLOCK_SIZE))
+        {
+            error = "truncated or corrupt archive";
+            return false;
+        }
+
+        // the archive ends with zero blocks
+        if (std::all_of(header, header + TAR_BLOCK_SIZE, [](char c) { return c == '\0'; }))
+        {
+            return true;
+        }
+
+        const qint64 size = static_cast<qint64>(parseOctal(header + 124, 12));
+        const quint64 mode = parseOctal(header + 100, 8);
+        const char type = header[156];
+
+        QString name = headerString(header, 100);
+        const QString prefix = std::memcmp(header + 257, "ustar", 5) == 0 ? headerString(header + 345, 155) : QString();
+        if (!prefix.isEmpty())
+        {
+            name = prefix + '/' + name;
+        }
+        if (!longName.isEmpty())
+        {
+            name = std::exchange(longName, QString());
+        }
+
+        // GNU long name and pax headers carry the name of the following entry
+        if (type == 'L' || type == 'x')
+        {
+            QByteArray data(paddedSize(size), Qt::Uninitialized);
+            if (size > ARCHIVE_CHUNK_SIZE || !reader.read(data.data(), data.size()))
+            {
+                error = "corrupt extended header";
+                return false;
+            }
+            data.truncate(size);
+            if (type == 'L')
+            {
+                longName = QString::fromUtf8(data.constData(), strnlen(data.constData(), data.size()));
+            }
+            else
+            {
+                // records are "<length> <key>=<value>\n"
+                for (const QByteArray &record : data.split('\n'))
+                {
+                    const qsizetype key = record.indexOf(" path=");
+                    if (key >= 0)
+                    {
+                        longName = QString::fromUtf8(record.mid(key + 6));
+                    }
+                }
+            }
+            continue;
+        }
+
+        const QString path = entryPath(destination, name, stripComponents);
+        if (type == '5')
+        {
+            if (!path.isEmpty() && !QDir().mkpath(path))
+            {
+                error = "failed to create " + path;
+                return false;
+            }
+            continue;
+        }
+
+        if ((type != '0' && type != '\0') || path.isEmpty())
+        {
+            // links, devices and entries outside destination
+            if (!reader.skip(paddedSize(size)))
+            {
+                error = "truncated or corrupt archive";
+                return false;
+            }
+            continue;
+        }
+
+        QFile file(path);
+        if (!createParent(path) || !file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            error = "failed to create " + path;
+            return false;
+        }
+        for (qint64 remaining = size; remaining > 0;)
+        {
+            const qint64 chunk = std::min<qint64>(remaining, ARCHIVE_CHUNK_SIZE);
+            if (!reader.read(buffer.data(), chunk))
+            {
+                error = "truncated or corrupt archive";
+                return false;
+            }
+            if (file.write(buffer.data(), chunk) != chunk)
+            {
+                error = "failed to write " + path;
+                return false;
+            }
+            remaining -= chunk;
+        }
+        file.close();
+        setExecutable(path, mode & 0111);
+
+        if (!reader.skip(paddedSize(size) - size))
+        {
+            error = "truncated or corrupt archive";
+            return false;
+        }
+    }
+}
+
+bool ArchiveExtractor::extractZip(const QString &archivePath, const QString &destination, int stripComponents, QString &error)
+{
+    QFile archive(archivePath);
+    if (!archive.open(QIODevice::ReadOnly))
+    {
+        error = "failed to open archive";
+        return false;
+    }
+
+    // the end of central directory record sits within the last 64 KiB + 22 bytes
+    constexpr qint64 eocdSize = 22;
+    const qint64 tailSize = std::min<qint64>(archive.size(), 0xFFFF + eocdSize);
+    archive.seek(archive.size() - tailSize);
+    const QByteArray tail = archive.read(tailSize);
+    qsizetype eocd = -1;
+    for (qsizetype i = tail.size() - eocdSize; i >= 0; --i)
+    {
+        if (qFromLittleEndian<quint32>(tail.constData() + i) == 0x06054b50)
+        {
+            eocd = i;
+            break;
+        }
+    }
+    if (eocd < 0)
+    {
+        error = "not a zip archive";
+        return false;
+    }
+
+    const quint16 entries = qFromLittleEndian<quint16>(tail.constData() + eocd + 10);
+    const quint32 directorySize = qFromLittleEndian<quint32>(tail.constData() + eocd + 12);
+    const quint32 directoryOffset = qFromLittleEndian<quint32>(tail.constData() + eocd + 16);
+    if (directoryOffset == 0xFFFFFFFF || qint64(directoryOffset) + directorySize > archive.size())
+    {
+        error = "unsupported zip archive";
+        return false;
+    }
+
+    archive.seek(directoryOffset);
+    const QByteArray directory = archive.read(directorySize);
+    std::vector<char> input(ARCHIVE_CHUNK_SIZE);
+    std::vector<char> output(ARCHIVE_CHUNK_SIZE);
+    qsizetype position = 0;
+    for (quint16 entry = 0; entry < entries; ++entry)
+    {
+        constexpr qsizetype centralHeaderSize = 46;
+        if (position + centralHeaderSize > directory.size() || qFromLittleEndian<quint32>(directory.constData() + position) != 0x02014b50)
+        {
+            error = "corrupt zip directory";
+            return false;
+        }
+
+        const char *central = directory.constData() + position;
+        const quint16 method = qFromLittleEndian<quint16>(central + 10);
+        const quint32 crc = qFromLittleEndian<quint32>(central + 16);
+        const quint32 compressedSize = qFromLittleEndian<quint32>(central + 20);
+        const quint16 nameLength = qFromLittleEndian<quint16>(central + 28);
+        const quint16 extraLength = qFromLittleEndian<quint16>(central + 30);
+        const quint16 commentLength = qFromLittleEndian<quint16>(central + 32);
+        const quint32 externalAttributes = qFromLittleEndian<quint32>(central + 38);
+        const quint32 localOffset = qFromLittleEndian<quint32>(central + 42);
+        if (position + centralHeaderSize + nameLength > directory.size())
+        {
+            error = "corrupt zip directory";
+            return false;
+        }
+        const QString name = QString::fromUtf8(central + centralHeaderSize, nameLength);
+        position += centralHeaderSize + nameLength + extraLength + commentLength;
+
+        const QString path = entryPath(destination, name, stripComponents);
+        if (path.isEmpty())
+        {
+            continue;
+        }
+        if (name.endsWith('/'))
+        {
+            if (!QDir().mkpath(path))
+            {
+                error = "failed to create " + path;
+                return false;
+            }
+            continue;
+        }
+        if (method != 0 && method != 8)
+        {
+            error = "unsupported compression in " + name;
+            return false;
+        }
+
+        // the local header may carry a different extra field than the central one
+        char local[30];
+        if (!archive.seek(localOffset) || archive.read(local, sizeof(local)) != sizeof(local) || qFromLittleEndian<quint32>(local) != 0x04034b50)
+        {
+            error = "corrupt zip entry " + name;
+            return false;
+        }
+        archive.seek(localOffset + sizeof(local) + qFromLittleEndian<quint16>(local + 26) + qFromLittleEndian<quint16>(local + 28));
+
+        QFile file(path);
+        if (!createParent(path) || !file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            error = "failed to create " + path;
+            return false;
+        }
+
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        // negative window bits, zip entries are raw deflate
+        if (method == 8 && inflateInit2(&stream, -15) != Z_OK)
+        {
+            error = "failed to initialize inflate";
+            return false;
+        }
+
+        uLong checksum = crc32(0L, Z_NULL, 0);
+        bool finished = method == 0 && compressedSize == 0;
+        for (qint64 remaining = compressedSize; remaining > 0 && !finished;)
+        {
+            const qint64 read = archive.read(input.data(), std::min<qint64>(remaining, ARCHIVE_CHUNK_SIZE));
+            if (read <= 0)
+            {
+                break;
+            }
+            remaining -= read;
+
+            if (method == 0)
+            {
+                checksum = crc32(checksum, reinterpret_cast<const Bytef *>(input.data()), static_cast<uInt>(read));
+                if (file.write(input.data(), read) != read)
+                {
+                    break;
+                }
+                finished = remaining == 0;
+                continue;
+            }
+
+            stream.next_in = reinterpret_cast<Bytef *>(input.data());
+            stream.avail_in = static_cast<uInt>(read);
+            do
+            {
+                stream.next_out = reinterpret_cast<Bytef *>(output.data());
+                stream.avail_out = static_cast<uInt>(output.size());
+                const int result = inflate(&stream, Z_NO_FLUSH);
+                if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+                {
+                    remaining = 0;
+                    break;
+                }
+                const qint64 produced = static_cast<qint64>(output.size() - stream.avail_out);
+                checksum = crc32(checksum, reinterpret_cast<const Bytef *>(output.data()), static_cast<uInt>(produced));
+                if (file.write(output.data(), produced) != produced)
+                {
+                    remaining = 0;
+                    break;
+                }
+                finished = result == Z_STREAM_END;
+            } while (stream.avail_out == 0 && !finished);
+        }
+        if (method == 8)
+        {
+            inflateEnd(&stream);
+        }
+        file.close();
+
+        if (!finished || checksum != crc)
+        {
+            error = "corrupt zip entry " + name;
+            return false;
+        }
+
+        // the high 16 bits hold unix permissions when created on unix
+        setExecutable(path, (externalAttributes >> 16) & 0111);
+    }
+
+    return true;
+}
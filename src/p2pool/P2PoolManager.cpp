@@ -27,8 +27,9 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "P2PoolManager.h"
-#include "net/http_client.h"
+#include "ArchiveExtractor.h"
 #include "common/util.h"
+#include "daemon/HostResources.h"
 #include "qt/utils.h"
 #include <QElapsedTimer>
 #include <QFile>
@@ -42,13 +43,149 @@
 #include <QProcess>
 #include <QMap>
 #include <QCryptographicHash>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QThread>
+
+// TODO: wallet_merged - epee library triggers the warnings
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wreorder"
+#include <net/http.h>
+#pragma GCC diagnostic pop
 
 #if defined(Q_OS_MACOS) && defined(__aarch64__) && !defined(Q_OS_MACOS_AARCH64)
 #define Q_OS_MACOS_AARCH64
 #endif
 
+namespace {
+
+// RandomX dataset initialization and sidechain sync come before the first hash,
+// the miner's hashrate then needs a while to settle
+static const qint64 AUTO_TUNE_START_TIMEOUT_MS = 5 * 60 * 1000;
+static const qint64 AUTO_TUNE_SETTLE_MS = 30 * 1000;
+static const qint64 AUTO_TUNE_MEASURE_MS = 60 * 1000;
+// time for the previous p2pool to release its ports
+static const int AUTO_TUNE_RESTART_DELAY_MS = 2000;
+// more threads have to be this much better to be picked
+static const double AUTO_TUNE_MIN_GAIN = 1.03;
+
+static const int CONSOLE_MAX_LINES = 500;
+static const int CONSOLE_MAX_LINE_LENGTH = 64 * 1024;
+// p2pool rewrites its data-api files every few seconds while it's alive
+static const int WATCHDOG_INTERVAL_MS = 15 * 1000;
+static const qint64 WATCHDOG_STALE_MS = 3 * 60 * 1000;
+// the first stats only show up after RandomX init and the sidechain sync
+static const qint64 WATCHDOG_STARTUP_GRACE_MS = 10 * 60 * 1000;
+// the first restart waits for the ports to be released, repeated failures back off
+static const int RESTART_DELAY_MIN_MS = 5 * 1000;
+static const int RESTART_DELAY_MAX_MS = 5 * 60 * 1000;
+static const qint64 RESTART_HEALTHY_RESET_MS = 10 * 60 * 1000;
+static const int STOP_TIMEOUT_MS = 3000;
+
+QString autoTuneFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/p2pool_tuning.json";
+}
+
+QString autoTuneKey(bool onBattery)
+{
+    QString machine = QString::fromLatin1(QSysInfo::machineUniqueId().toHex());
+    if (machine.isEmpty()) {
+        machine = QSysInfo::machineHostName();
+    }
+    return machine + (onBattery ? "/battery" : "/ac");
+}
+
+QJsonObject readAutoTuneFile()
+{
+    QFile file(autoTuneFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void writeAutoTuneFile(const QJsonObject &profiles)
+{
+    const QString path = autoTuneFilePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save p2pool tuning profile" << path;
+        return;
+    }
+    file.write(QJsonDocument(profiles).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+// Writes a successful response body straight to file and hashes it on the way,
+// other responses (redirects, errors) are buffered as usual
+class DownloadFileClient : public net::http::client
+{
+public:
+    explicit DownloadFileClient(QFile &file)
+        : m_file(file)
+        , m_hash(QCryptographicHash::Sha256)
+    {
+    }
+
+    QString hash() const
+    {
+        return m_hash.result().toHex();
+    }
+
+    bool writeFailed() const
+    {
+        return m_writeFailed;
+    }
+
+protected:
+    bool on_header(const epee::net_utils::http::http_response_info &headers) final
+    {
+        m_streaming = headers.m_response_code == 200;
+        if (m_streaming)
+        {
+            m_hash.reset();
+            m_file.seek(0);
+            m_file.resize(0);
+        }
+        return net::http::client::on_header(headers);
+    }
+
+    bool handle_target_data(std::string &piece_of_transfer) final
+    {
+        if (!m_streaming)
+        {
+            return net::http::client::handle_target_data(piece_of_transfer);
+        }
+
+        m_hash.addData(QByteArrayView(piece_of_transfer.data(), piece_of_transfer.size()));
+        if (m_file.write(piece_of_transfer.data(), piece_of_transfer.size()) != static_cast<qint64>(piece_of_transfer.size()))
+        {
+            m_writeFailed = true;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    QFile &m_file;
+    QCryptographicHash m_hash;
+    bool m_streaming = false;
+    bool m_writeFailed = false;
+};
+
+} // namespace
+
 void P2PoolManager::download() {
     m_scheduler.run([this] {
+        // created on first download rather than at startup
+        QDir().mkpath(m_p2poolPath);
         QUrl url;
         QString fileName;
         QString validHash;
@@ -70,13 +207,18 @@ void P2PoolManager::download() {
             validHash = "53470b203209837336e60933bda9e2ba4ae179aef4ec773abb76d6f9b64023f5";
         #endif
         QFile file(fileName);
-        epee::net_utils::http::http_simple_client http_client;
+        if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+            emit p2poolDownloadFailure(InstallationFailed);
+            return;
+        }
+        DownloadFileClient http_client(file);
         const epee::net_utils::http::http_response_info* response = NULL;
         std::string userAgent = randomUserAgent().toStdString();
         std::chrono::milliseconds timeout = std::chrono::seconds(10);
         http_client.set_server(url.host().toStdString(), "443", {});
         bool success = http_client.invoke_get(url.path().toStdString(), timeout, {}, std::addressof(response), {{"User-Agent", userAgent}});
         if (success && response->m_response_code == 404) {
+            file.remove();
             emit p2poolDownloadFailure(BinaryNotAvailable);
             return;
         } else if (success && response->m_response_code == 302) {
@@ -92,22 +234,26 @@ void P2PoolManager::download() {
                 }
             }
         }
-        if (!success) {
+        file.close();
+        if (http_client.writeFailed()) {
+            file.remove();
+            emit p2poolDownloadFailure(InstallationFailed);
+        }
+        else if (!success || response->m_response_code != 200) {
+            file.remove();
             emit p2poolDownloadFailure(ConnectionIssue);
         }
         else {
-            std::string stringData = response->m_body;
-            QByteArray data(stringData.c_str(), stringData.length());
-            QByteArray hashData = QCryptographicHash::hash(data, QCryptographicHash::Sha256);
-            QString hash = hashData.toHex();
-            if (hash != validHash) {
+            // the body was hashed while it was written to disk, nothing is held in memory
+            if (http_client.hash() != validHash) {
+                file.remove();
                 emit p2poolDownloadFailure(HashVerificationFailed);
             }
             else {
-                file.open(QIODevice::WriteOnly);
-                file.write(data);
-                file.close();
-                QProcess::execute("tar", {"-xzf", fileName, "--strip=1", "-C", m_p2poolPath});
+                QString error;
+                if (!ArchiveExtractor::extract(fileName, m_p2poolPath, 1, error)) {
+                    qWarning() << "Failed to extract" << fileName << ":" << error;
+                }
                 QFile::remove(fileName);
                 if (isInstalled()) {
                     emit p2poolDownloadSuccess();
@@ -117,7 +263,7 @@ void P2PoolManager::download() {
                 }
             }
         }
-    });
+    }, FutureScheduler::BlockingIO, "P2PoolManager::download");
     return;
 }
 
@@ -130,25 +276,13 @@ bool P2PoolManager::isInstalled() {
 }
 
 void P2PoolManager::getStatus() {
-    QString statsPath = m_p2poolPath + "/stats/local/miner";
-    bool status = true;
-    if (!QFileInfo(statsPath).isFile() || !started)
-    {
-        status = started;
-        emit p2poolStatus(status, 0);
-        return;
-    }
-    QFile statsFile(statsPath);
-    statsFile.open(QIODevice::ReadOnly);
-    QTextStream statsOut(&statsFile);
-    QByteArray data;
-    statsOut >> data;
-    statsFile.close();
-    QJsonDocument json = QJsonDocument::fromJson(data);
-    QJsonObject jsonObj = json.object();
-    int hashrate = jsonObj.value("current_hashrate").toInt();
-    emit p2poolStatus(status, hashrate);
-    return;
+    // served from the watched data-api stats, no file is read here
+    emit p2poolStatus(started, started ? static_cast<int>(m_stats->hashrate()) : 0);
+}
+
+P2PoolStatsModel *P2PoolManager::stats() const
+{
+    return m_stats;
 }
 
 bool P2PoolManager::start(const QString &flags, const QString &address, const QString &chain, const QString &threads)
@@ -167,7 +301,16 @@ bool P2PoolManager::start(const QString &flags, const QString &address, const QS
         arguments << "--local-api";
     }
 
-    if (!arguments.contains("--data-api")) {
+    // the output goes to our console rather than a terminal
+    if (!arguments.contains("--no-color")) {
+        arguments << "--no-color";
+    }
+
+    QString dataApiDir;
+    const int dataApiIndex = arguments.indexOf("--data-api");
+    if (dataApiIndex != -1 && dataApiIndex + 1 < arguments.size()) {
+        dataApiDir = arguments.at(dataApiIndex + 1);
+    } else if (dataApiIndex == -1) {
         QDir dir;
         QString dirName = m_p2poolPath + "/stats/";
         QDir statsDir(dirName);
@@ -176,10 +319,7 @@ bool P2PoolManager::start(const QString &flags, const QString &address, const QS
         }
         dir.mkdir(dirName);
         arguments << "--data-api" << dirName;
-    }
-
-    if (!arguments.contains("--start-mining")) {
-        arguments << "--start-mining" << threads;
+        dataApiDir = dirName;
     }
 
     if (chain == "nano") {
@@ -194,57 +334,439 @@ bool P2PoolManager::start(const QString &flags, const QString &address, const QS
         arguments << "--wallet" << address;
     }
 
+    if (!arguments.contains("--start-mining")) {
+        if (threads == "auto") {
+            const int tuned = tunedThreads(HostResources::inspect(m_p2poolPath).onBattery);
+            if (tuned == 0) {
+                return beginAutoTune(arguments, dataApiDir);
+            }
+            arguments << "--start-mining" << QString::number(tuned);
+        } else {
+            arguments << "--start-mining" << threads;
+        }
+    }
+
+    m_restartTimer.stop();
+    m_restartDelayMs = RESTART_DELAY_MIN_MS;
+    if (m_restarts != 0) {
+        m_restarts = 0;
+        emit restartsChanged();
+    }
+
+    return launch(arguments, dataApiDir);
+}
+
+bool P2PoolManager::launch(const QStringList &arguments, const QString &dataApiDir)
+{
     qDebug() << "starting p2pool " + m_p2pool;
     qDebug() << "With command line arguments " << arguments;
 
     QMutexLocker locker(&m_p2poolMutex);
 
+    // an instance still shutting down holds the ports and the data directory
+    if (m_stopping) {
+        qWarning() << "Previous P2Pool still exiting, killing it";
+        m_stopping->kill();
+        m_stopping->waitForFinished(STOP_TIMEOUT_MS);
+    }
+
     m_p2poold.reset(new QProcess());
 
     // Set program parameters
     m_p2poold->setProgram(m_p2pool);
     m_p2poold->setArguments(arguments);
     m_p2poold->setWorkingDirectory(m_p2poolPath);
+    m_p2poold->setProcessChannelMode(QProcess::MergedChannels);
+    connect(m_p2poold.get(), &QProcess::readyReadStandardOutput, this, &P2PoolManager::readOutput);
+    connect(m_p2poold.get(), &QProcess::finished, this, &P2PoolManager::processFinished);
 
-    // Start p2pool
-    started = m_p2poold->startDetached();
+    // Start p2pool as our child, its output and exit are reported back
+    m_p2poold->start();
+    started = m_p2poold->waitForStarted();
 
     if (!started) {
         qDebug() << "P2Pool start error: " + m_p2poold->errorString();
+        m_p2poold.reset();
         emit p2poolStartFailure();
         return false;
     }
 
+    m_arguments = arguments;
+    m_dataApiDir = dataApiDir;
+    m_runningSince.start();
+    if (!dataApiDir.isEmpty()) {
+        m_stats->watch(QDir(m_p2poolPath).absoluteFilePath(dataApiDir));
+        m_watchdogTimer.start();
+    }
+    // after watch(), which reports its cleared stats right away; the startup
+    // grace period runs until the new process reports its own
+    m_lastStats.invalidate();
+
     return true;
 }
 
+void P2PoolManager::readOutput()
+{
+    // a read can end in the middle of a line, the tail is kept until its newline arrives
+    m_partialLine.append(m_p2poold->readAllStandardOutput());
+
+    QStringList lines;
+    qsizetype lineStart = 0;
+    for (qsizetype newline = m_partialLine.indexOf('\n'); newline >= 0; newline = m_partialLine.indexOf('\n', lineStart)) {
+        qsizetype lineEnd = newline;
+        if (lineEnd > lineStart && m_partialLine.at(lineEnd - 1) == '\r') {
+            --lineEnd;
+        }
+        if (lineEnd > lineStart) {
+            lines << QString::fromUtf8(m_partialLine.constData() + lineStart, lineEnd - lineStart);
+        }
+        lineStart = newline + 1;
+    }
+    m_partialLine.remove(0, lineStart);
+    if (m_partialLine.size() > CONSOLE_MAX_LINE_LENGTH) {
+        lines << QString::fromUtf8(m_partialLine);
+        m_partialLine.clear();
+    }
+
+    if (lines.isEmpty()) {
+        return;
+    }
+    for (const QString &line : lines) {
+        m_consoleLines.append(line);
+    }
+    emit consoleLinesUpdated(lines);
+}
+
+QStringList P2PoolManager::consoleLines() const
+{
+    QStringList lines;
+    lines.reserve(m_consoleLines.count());
+    for (qsizetype index = m_consoleLines.firstIndex(); index <= m_consoleLines.lastIndex(); ++index) {
+        lines.append(m_consoleLines.at(index));
+    }
+    return lines;
+}
+
+int P2PoolManager::restarts() const
+{
+    return m_restarts;
+}
+
+void P2PoolManager::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    // stopProcess() disconnects first, anything arriving here wasn't asked for
+    qWarning() << "P2Pool exited unexpectedly, code" << exitCode << "status" << exitStatus;
+    readOutput();
+
+    if (m_autoTune) {
+        // the measurements so far are of no use without the candidate that died
+        m_autoTuneTimer.stop();
+        m_autoTune.reset();
+        emit autoTuningChanged();
+    }
+    scheduleRestart(exitStatus == QProcess::CrashExit ? "crashed" : QString("exited with code %1").arg(exitCode));
+}
+
+void P2PoolManager::watchdogTick()
+{
+    if (!started || m_autoTune) {
+        return;
+    }
+
+    if (!m_lastStats.isValid()) {
+        if (m_runningSince.elapsed() >= WATCHDOG_STARTUP_GRACE_MS) {
+            scheduleRestart("no stats since start");
+        }
+        return;
+    }
+
+    if (m_lastStats.elapsed() >= WATCHDOG_STALE_MS) {
+        scheduleRestart(QString("no stats for %1 s").arg(m_lastStats.elapsed() / 1000));
+        return;
+    }
+
+    // a run that stayed healthy for a while earns a quick restart next time
+    if (m_restartDelayMs != RESTART_DELAY_MIN_MS && m_runningSince.elapsed() >= RESTART_HEALTHY_RESET_MS) {
+        m_restartDelayMs = RESTART_DELAY_MIN_MS;
+    }
+}
+
+void P2PoolManager::scheduleRestart(const QString &reason)
+{
+    const int delay = m_restartDelayMs;
+    qWarning() << "P2Pool watchdog:" << reason << "- restarting in" << delay << "ms";
+    stopProcess();
+
+    m_restartDelayMs = qMin(m_restartDelayMs * 2, RESTART_DELAY_MAX_MS);
+    ++m_restarts;
+    emit restartsChanged();
+    emit p2poolRestarting(reason, delay);
+    m_restartTimer.start(delay);
+}
+
 void P2PoolManager::exit()
 {
     qDebug("P2PoolManager: exit()");
+    m_restartTimer.stop();
+    if (m_autoTune) {
+        m_autoTuneTimer.stop();
+        m_autoTune.reset();
+        emit autoTuningChanged();
+    }
+    stopProcess();
+}
+
+void P2PoolManager::stopProcess()
+{
+    m_watchdogTimer.stop();
+    if (m_p2poold) {
+        QProcess *process = m_p2poold.release();
+        disconnect(process, nullptr, this, nullptr);
+        m_partialLine.clear();
+        if (process->state() == QProcess::NotRunning) {
+            // this may run from the process' own finished signal
+            process->deleteLater();
+        } else {
+            // Escalated from timers instead of waiting on the GUI thread. Owned by
+            // us meanwhile, QProcess kills what's still running when destroyed.
+            process->setParent(this);
+            m_stopping = process;
+            connect(process, &QProcess::finished, process, &QObject::deleteLater);
+            // p2pool saves its peer list and shuts down cleanly on its "exit" console command
+            process->write("exit\n");
+            process->closeWriteChannel();
+            QTimer::singleShot(STOP_TIMEOUT_MS, process, [process] {
+            #ifdef Q_OS_WIN
+                qWarning() << "P2Pool didn't exit in time, killing it";
+                process->kill();
+            #else
+                process->terminate();
+                QTimer::singleShot(STOP_TIMEOUT_MS, process, [process] {
+                    qWarning() << "P2Pool didn't exit in time, killing it";
+                    process->kill();
+                });
+            #endif
+            });
+        }
+    }
     if (started) {
-    #ifdef Q_OS_WIN
-        QProcess::execute("taskkill",  {"/F", "/IM", "p2pool.exe"});
-    #else
-        QProcess::execute("pkill", {"p2pool"});
-    #endif
         started = false;
+        m_stats->stop();
         QString dirName = m_p2poolPath + "/stats/";
         QDir dir(dirName);
         dir.removeRecursively();
     }
 }
 
+bool P2PoolManager::autoTuning() const
+{
+    return m_autoTune != nullptr;
+}
+
+bool P2PoolManager::beginAutoTune(const QStringList &arguments, const QString &dataApiDir)
+{
+    const HostResources host = HostResources::inspect(m_p2poolPath);
+
+    std::unique_ptr<AutoTune> tune(new AutoTune());
+    tune->arguments = arguments;
+    tune->dataApiDir = dataApiDir;
+    tune->onBattery = host.onBattery;
+    for (int threads : {host.cores / 4, host.cores / 2, host.cores * 3 / 4, host.cores}) {
+        threads = qMax(1, threads);
+        if (!tune->candidates.contains(threads)) {
+            tune->candidates << threads;
+        }
+    }
+
+    qDebug() << "P2Pool auto-tune across" << tune->candidates << "threads";
+    m_autoTune = std::move(tune);
+    emit autoTuningChanged();
+
+    launchAutoTuneCandidate();
+    return started;
+}
+
+void P2PoolManager::launchAutoTuneCandidate()
+{
+    AutoTune &tune = *m_autoTune;
+    const int threads = tune.candidates.at(tune.index);
+
+    // the default data-api directory is removed whenever p2pool stops
+    if (!tune.dataApiDir.isEmpty()) {
+        QDir().mkpath(QDir(m_p2poolPath).absoluteFilePath(tune.dataApiDir));
+    }
+
+    if (!launch(QStringList(tune.arguments) << "--start-mining" << QString::number(threads), tune.dataApiDir)) {
+        m_autoTuneTimer.stop();
+        m_autoTune.reset();
+        emit autoTuningChanged();
+        return;
+    }
+
+    tune.runningThreads = threads;
+    tune.phaseStartedAt = QDateTime::currentMSecsSinceEpoch();
+    tune.hashingSince = 0;
+    tune.measuring = false;
+    tune.hashrateSum = 0;
+    tune.hashrateSamples = 0;
+    m_autoTuneTimer.start();
+    emit p2poolAutoTuneProgress(threads, tune.index + 1, tune.candidates.size());
+}
+
+void P2PoolManager::autoTuneTick()
+{
+    AutoTune &tune = *m_autoTune;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const double hashrate = m_stats->hashrate();
+
+    if (!tune.measuring) {
+        if (hashrate > 0 && tune.hashingSince == 0) {
+            tune.hashingSince = now;
+        }
+        if (tune.hashingSince != 0 && now - tune.hashingSince >= AUTO_TUNE_SETTLE_MS) {
+            tune.measuring = true;
+            tune.phaseStartedAt = now;
+        } else if (tune.hashingSince == 0 && now - tune.phaseStartedAt >= AUTO_TUNE_START_TIMEOUT_MS) {
+            // p2pool never started hashing, later candidates won't either
+            qWarning() << "P2Pool auto-tune: no hashrate reported, giving up";
+            finishAutoTune();
+        }
+        return;
+    }
+
+    tune.hashrateSum += hashrate;
+    ++tune.hashrateSamples;
+    if (now - tune.phaseStartedAt < AUTO_TUNE_MEASURE_MS) {
+        return;
+    }
+
+    // on battery the hashes per thread stand in for the hashes per watt
+    const int threads = tune.runningThreads;
+    const double average = tune.hashrateSum / tune.hashrateSamples;
+    const double score = tune.onBattery ? average / threads : average;
+    qDebug() << "P2Pool auto-tune:" << threads << "threads," << average << "H/s";
+    if (tune.bestThreads == 0 || score > tune.bestScore * AUTO_TUNE_MIN_GAIN) {
+        tune.bestThreads = threads;
+        tune.bestScore = score;
+        tune.bestHashrate = average;
+    }
+
+    if (++tune.index < tune.candidates.size()) {
+        m_autoTuneTimer.stop();
+        stopProcess();
+        AutoTune *current = m_autoTune.get();
+        QTimer::singleShot(AUTO_TUNE_RESTART_DELAY_MS, this, [this, current] {
+            if (m_autoTune.get() == current) {
+                launchAutoTuneCandidate();
+            }
+        });
+        return;
+    }
+
+    finishAutoTune();
+}
+
+void P2PoolManager::finishAutoTune()
+{
+    m_autoTuneTimer.stop();
+    std::unique_ptr<AutoTune> tune = std::move(m_autoTune);
+    emit autoTuningChanged();
+
+    if (tune->bestThreads == 0) {
+        // nothing measured, keep mining with the usual recommendation
+        tune->bestThreads = tune->candidates.at(tune->candidates.size() / 2);
+    } else {
+        saveTunedThreads(tune->onBattery, tune->bestThreads, tune->bestHashrate);
+    }
+    qDebug() << "P2Pool auto-tune picked" << tune->bestThreads << "threads";
+    emit p2poolAutoTuneFinished(tune->bestThreads, tune->bestHashrate);
+
+    // the last candidate is still running, restart only if another one won
+    if (started && tune->runningThreads == tune->bestThreads) {
+        return;
+    }
+    stopProcess();
+    const QStringList arguments = QStringList(tune->arguments) << "--start-mining" << QString::number(tune->bestThreads);
+    const QString dataApiDir = tune->dataApiDir;
+    QTimer::singleShot(AUTO_TUNE_RESTART_DELAY_MS, this, [this, arguments, dataApiDir] {
+        if (started || m_autoTune) {
+            return;
+        }
+        if (!dataApiDir.isEmpty()) {
+            QDir().mkpath(QDir(m_p2poolPath).absoluteFilePath(dataApiDir));
+        }
+        launch(arguments, dataApiDir);
+    });
+}
+
+int P2PoolManager::tunedThreads(bool onBattery) const
+{
+    const QJsonObject profile = readAutoTuneFile().value(autoTuneKey(onBattery)).toObject();
+    // a profile from different hardware (e.g. a moved portable install) doesn't apply
+    if (profile.value("cores").toInt() != qMax(1, QThread::idealThreadCount())) {
+        return 0;
+    }
+    return profile.value("threads").toInt();
+}
+
+void P2PoolManager::saveTunedThreads(bool onBattery, int threads, double hashrate)
+{
+    const QString key = autoTuneKey(onBattery);
+    const QJsonObject profile{
+        {"cores", qMax(1, QThread::idealThreadCount())},
+        {"threads", threads},
+        {"hashrate", hashrate},
+        {"updated", QDateTime::currentSecsSinceEpoch()},
+    };
+    m_scheduler.run([key, profile] {
+        QJsonObject profiles = readAutoTuneFile();
+        profiles.insert(key, profile);
+        writeAutoTuneFile(profiles);
+    }, FutureScheduler::BlockingIO, "P2PoolManager::saveTunedThreads");
+}
+
+void P2PoolManager::resetAutoTune()
+{
+    const QStringList keys{autoTuneKey(false), autoTuneKey(true)};
+    m_scheduler.run([keys] {
+        QJsonObject profiles = readAutoTuneFile();
+        for (const QString &key : keys) {
+            profiles.remove(key);
+        }
+        writeAutoTuneFile(profiles);
+    }, FutureScheduler::BlockingIO, "P2PoolManager::resetAutoTune");
+}
+
 P2PoolManager::P2PoolManager(QObject *parent)
     : QObject(parent)
+    , m_stats(new P2PoolStatsModel(this))
+    , m_consoleLines(CONSOLE_MAX_LINES)
+    , m_restartDelayMs(RESTART_DELAY_MIN_MS)
+    , m_restarts(0)
     , m_scheduler(this)
 {
     started = false;
+    m_autoTuneTimer.setInterval(1000);
+    connect(&m_autoTuneTimer, &QTimer::timeout, this, &P2PoolManager::autoTuneTick);
+    m_watchdogTimer.setInterval(WATCHDOG_INTERVAL_MS);
+    connect(&m_watchdogTimer, &QTimer::timeout, this, &P2PoolManager::watchdogTick);
+    connect(m_stats, &P2PoolStatsModel::statsChanged, this, [this] {
+        m_lastStats.start();
+    });
+    m_restartTimer.setSingleShot(true);
+    connect(&m_restartTimer, &QTimer::timeout, this, [this] {
+        if (started || m_autoTune) {
+            return;
+        }
+        // the default data-api directory is removed whenever p2pool stops
+        if (!m_dataApiDir.isEmpty()) {
+            QDir().mkpath(QDir(m_p2poolPath).absoluteFilePath(m_dataApiDir));
+        }
+        launch(m_arguments, m_dataApiDir);
+    });
     // Platform dependent path to p2pool
 #ifdef Q_OS_WIN
     m_p2poolPath = QApplication::applicationDirPath() + "/p2pool";
-    if (!QDir(m_p2poolPath).exists()) {
-        QDir().mkdir(m_p2poolPath);
-    }
     m_p2pool = m_p2poolPath + "/p2pool.exe";
 #elif defined(Q_OS_UNIX)
     m_p2poolPath = QApplication::applicationDirPath();
@@ -256,5 +778,11 @@ P2PoolManager::P2PoolManager(QObject *parent)
 }
 
 P2PoolManager::~P2PoolManager() {
+    m_restartTimer.stop();
+    stopProcess();
+    // shutting down, p2pool gets its chance to exit cleanly before it's killed
+    if (m_stopping) {
+        m_stopping->waitForFinished(STOP_TIMEOUT_MS);
+    }
     m_scheduler.shutdownWaitForFinished();
 }
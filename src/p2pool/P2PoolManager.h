@@ -31,16 +31,24 @@
 
 #include <memory>
 
+#include <QContiguousCache>
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QObject>
+#include <QPointer>
 #include <QUrl>
 #include <QProcess>
+#include <QTimer>
 #include "NetworkType.h"
 #include "qt/FutureScheduler.h"
+#include "P2PoolStatsModel.h"
 
 class P2PoolManager : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(P2PoolStatsModel *stats READ stats CONSTANT)
+    Q_PROPERTY(bool autoTuning READ autoTuning NOTIFY autoTuningChanged)
+    Q_PROPERTY(int restarts READ restarts NOTIFY restartsChanged)
 
 public:
     explicit P2PoolManager(QObject *parent = 0);
@@ -51,6 +59,15 @@ public:
     Q_INVOKABLE bool isInstalled();
     Q_INVOKABLE void getStatus();
     Q_INVOKABLE void download();
+    // forget the tuned thread count of this machine, the next "auto" start benchmarks again
+    Q_INVOKABLE void resetAutoTune();
+    //! recent p2pool output, oldest first
+    Q_INVOKABLE QStringList consoleLines() const;
+
+    P2PoolStatsModel *stats() const;
+    bool autoTuning() const;
+    //! watchdog restarts since the last start()
+    int restarts() const;
 
     enum DownloadError {
         BinaryNotAvailable,
@@ -61,20 +78,74 @@ public:
     Q_ENUM(DownloadError)
 
 private:
+    // benchmark state of an "auto" start, one p2pool run per candidate thread count
+    struct AutoTune
+    {
+        QStringList arguments;
+        QString dataApiDir;
+        QList<int> candidates;
+        int index = 0;
+        int runningThreads = 0;
+        bool onBattery = false;
+        qint64 phaseStartedAt = 0;
+        qint64 hashingSince = 0;
+        bool measuring = false;
+        double hashrateSum = 0;
+        int hashrateSamples = 0;
+        int bestThreads = 0;
+        double bestScore = 0;
+        double bestHashrate = 0;
+    };
 
     bool running(NetworkType::Type nettype) const;
+    bool launch(const QStringList &arguments, const QString &dataApiDir);
+    void stopProcess();
+    void readOutput();
+    void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void watchdogTick();
+    void scheduleRestart(const QString &reason);
+    bool beginAutoTune(const QStringList &arguments, const QString &dataApiDir);
+    void launchAutoTuneCandidate();
+    void autoTuneTick();
+    void finishAutoTune();
+    int tunedThreads(bool onBattery) const;
+    void saveTunedThreads(bool onBattery, int threads, double hashrate);
+
 signals:
     void p2poolStartFailure() const;
     void p2poolStatus(bool isMining, int hashrate) const;
     void p2poolDownloadFailure(int errorCode) const;
     void p2poolDownloadSuccess() const;
+    void p2poolAutoTuneProgress(int threads, int step, int steps) const;
+    void p2poolAutoTuneFinished(int threads, double hashrate) const;
+    void autoTuningChanged() const;
+    void consoleLinesUpdated(const QStringList &lines) const;
+    void p2poolRestarting(const QString &reason, int delayMs) const;
+    void restartsChanged() const;
 
 private:
     std::unique_ptr<QProcess> m_p2poold;
+    // the last instance asked to exit, until it did
+    QPointer<QProcess> m_stopping;
     QMutex m_p2poolMutex;
     QString m_p2pool;
     QString m_p2poolPath;
     bool started = false;
+    P2PoolStatsModel *m_stats;
+    std::unique_ptr<AutoTune> m_autoTune;
+    QTimer m_autoTuneTimer;
+
+    QByteArray m_partialLine;
+    QContiguousCache<QString> m_consoleLines;
+    // what the watchdog relaunches with
+    QStringList m_arguments;
+    QString m_dataApiDir;
+    QTimer m_watchdogTimer;
+    QTimer m_restartTimer;
+    QElapsedTimer m_runningSince;
+    QElapsedTimer m_lastStats;
+    int m_restartDelayMs;
+    int m_restarts;
 
     mutable FutureScheduler m_scheduler;
 };
@@ -0,0 +1,285 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "P2PoolStatsModel.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+    // p2pool rewrites several files per update, parse once they settled
+    static const int P2POOL_STATS_PARSE_DELAY_MS = 250;
+    // one row per 10 seconds, one hour of history
+    static const qint64 P2POOL_STATS_HISTORY_INTERVAL_MS = 10000;
+    static const int P2POOL_STATS_HISTORY_SIZE = 360;
+
+    static const char *const P2POOL_STATS_DIRS[] = {"local", "pool", "network"};
+    static const char *const P2POOL_STATS_FILES[] = {"local/miner", "local/stratum", "pool/stats", "network/stats"};
+
+    QJsonObject readJson(const QString &path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        return QJsonDocument::fromJson(file.readAll()).object();
+    }
+}
+
+P2PoolStatsModel::P2PoolStatsModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_history(P2POOL_STATS_HISTORY_SIZE)
+    , m_lastAppendTime(0)
+    , m_generation(0)
+    , m_parsing(false)
+    , m_parsePending(false)
+    , m_scheduler(this)
+{
+    m_parseTimer.setSingleShot(true);
+    m_parseTimer.setInterval(P2POOL_STATS_PARSE_DELAY_MS);
+    connect(&m_parseTimer, &QTimer::timeout, this, &P2PoolStatsModel::parseAsync);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &P2PoolStatsModel::scheduleParse);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, [this] {
+        // files are replaced rather than rewritten, and subdirectories appear after start
+        updateWatchedPaths();
+        scheduleParse();
+    });
+}
+
+P2PoolStatsModel::~P2PoolStatsModel()
+{
+    m_scheduler.shutdownWaitForFinished();
+}
+
+void P2PoolStatsModel::watch(const QString &dataApiDir)
+{
+    stop();
+
+    m_dataApiDir = dataApiDir;
+    beginResetModel();
+    m_history.clear();
+    m_latest = Sample();
+    endResetModel();
+    emit statsChanged();
+
+    updateWatchedPaths();
+    scheduleParse();
+}
+
+void P2PoolStatsModel::stop()
+{
+    ++m_generation;
+    m_parseTimer.stop();
+    m_parsePending = false;
+    m_dataApiDir.clear();
+
+    const QStringList watched = m_watcher.files() + m_watcher.directories();
+    if (!watched.isEmpty()) {
+        m_watcher.removePaths(watched);
+    }
+}
+
+void P2PoolStatsModel::updateWatchedPaths()
+{
+    if (m_dataApiDir.isEmpty()) {
+        return;
+    }
+
+    const QDir root(m_dataApiDir);
+    QStringList paths{root.absolutePath()};
+    for (const char *dir : P2POOL_STATS_DIRS) {
+        paths << root.absoluteFilePath(dir);
+    }
+    for (const char *file : P2POOL_STATS_FILES) {
+        paths << root.absoluteFilePath(file);
+    }
+
+    const QStringList watched = m_watcher.files() + m_watcher.directories();
+    QStringList missing;
+    for (const QString &path : paths) {
+        if (!watched.contains(path) && QFileInfo::exists(path)) {
+            missing << path;
+        }
+    }
+    if (!missing.isEmpty()) {
+        m_watcher.addPaths(missing);
+    }
+}
+
+void P2PoolStatsModel::scheduleParse()
+{
+    if (!m_dataApiDir.isEmpty() && !m_parseTimer.isActive()) {
+        m_parseTimer.start();
+    }
+}
+
+void P2PoolStatsModel::parseAsync()
+{
+    // one parse at a time, changes arriving meanwhile trigger one more
+    if (m_parsing) {
+        m_parsePending = true;
+        return;
+    }
+
+    const quint64 generation = m_generation;
+    const QString dataApiDir = m_dataApiDir;
+    m_parsing = m_scheduler.run([this, generation, dataApiDir] {
+        const Sample sample = parse(dataApiDir);
+        QMetaObject::invokeMethod(this, [this, generation, sample] {
+            m_parsing = false;
+            if (generation != m_generation) {
+                return;
+            }
+            append(sample);
+            if (std::exchange(m_parsePending, false)) {
+                scheduleParse();
+            }
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "P2PoolStatsModel::parse").first;
+}
+
+P2PoolStatsModel::Sample P2PoolStatsModel::parse(const QString &dataApiDir)
+{
+    const QDir root(dataApiDir);
+    const QJsonObject miner = readJson(root.filePath("local/miner"));
+    const QJsonObject stratum = readJson(root.filePath("local/stratum"));
+    const QJsonObject pool = readJson(root.filePath("pool/stats")).value("pool_statistics").toObject();
+    const QJsonObject network = readJson(root.filePath("network/stats"));
+
+    Sample sample;
+    sample.timestamp = QDateTime::currentMSecsSinceEpoch();
+    sample.hashrate = miner.value("current_hashrate").toDouble();
+    sample.sharesFound = miner.contains("shares_found") ? miner.value("shares_found").toInteger() : stratum.value("shares_found").toInteger();
+    sample.sharesFailed = miner.contains("shares_failed") ? miner.value("shares_failed").toInteger() : stratum.value("shares_failed").toInteger();
+    sample.currentEffort = stratum.value("current_effort").toDouble();
+    sample.averageEffort = stratum.value("average_effort").toDouble();
+    sample.uncles = pool.value("uncles").toInteger();
+    sample.poolHashrate = pool.value("hashRate").toDouble();
+    sample.sidechainHeight = pool.value("sidechainHeight").toInteger();
+    sample.networkDifficulty = network.value("difficulty").toInteger();
+    return sample;
+}
+
+void P2PoolStatsModel::append(const Sample &sample)
+{
+    m_latest = sample;
+
+    // within the interval the newest row is updated in place
+    if (!m_history.isEmpty() && sample.timestamp - m_lastAppendTime < P2POOL_STATS_HISTORY_INTERVAL_MS) {
+        m_history.last() = sample;
+        const QModelIndex last = index(m_history.count() - 1);
+        emit dataChanged(last, last);
+        emit statsChanged();
+        return;
+    }
+
+    m_lastAppendTime = sample.timestamp;
+    if (m_history.count() == m_history.capacity()) {
+        beginRemoveRows(QModelIndex(), 0, 0);
+        m_history.removeFirst();
+        endRemoveRows();
+    }
+    beginInsertRows(QModelIndex(), m_history.count(), m_history.count());
+    m_history.append(sample);
+    endInsertRows();
+    emit statsChanged();
+}
+
+double P2PoolStatsModel::hashrate() const
+{
+    return m_latest.hashrate;
+}
+
+quint64 P2PoolStatsModel::sharesFound() const
+{
+    return m_latest.sharesFound;
+}
+
+double P2PoolStatsModel::currentEffort() const
+{
+    return m_latest.currentEffort;
+}
+
+int P2PoolStatsModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_history.count();
+}
+
+QVariant P2PoolStatsModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_history.count()) {
+        return QVariant();
+    }
+
+    const Sample &sample = m_history.at(m_history.firstIndex() + index.row());
+    switch (role) {
+    case TimestampRole:
+        return sample.timestamp;
+    case HashrateRole:
+        return sample.hashrate;
+    case SharesFoundRole:
+        return sample.sharesFound;
+    case SharesFailedRole:
+        return sample.sharesFailed;
+    case CurrentEffortRole:
+        return sample.currentEffort;
+    case AverageEffortRole:
+        return sample.averageEffort;
+    case UnclesRole:
+        return sample.uncles;
+    case PoolHashrateRole:
+        return sample.poolHashrate;
+    case SidechainHeightRole:
+        return sample.sidechainHeight;
+    case NetworkDifficultyRole:
+        return sample.networkDifficulty;
+    }
+    return QVariant();
+}
+
+QHash<int, QByteArray> P2PoolStatsModel::roleNames() const
+{
+    static const QHash<int, QByteArray> roles = {
+        {TimestampRole, "timestamp"},
+        {HashrateRole, "hashrate"},
+        {SharesFoundRole, "sharesFound"},
+        {SharesFailedRole, "sharesFailed"},
+        {CurrentEffortRole, "currentEffort"},
+        {AverageEffortRole, "averageEffort"},
+        {UnclesRole, "uncles"},
+        {PoolHashrateRole, "poolHashrate"},
+        {SidechainHeightRole, "sidechainHeight"},
+        {NetworkDifficultyRole, "networkDifficulty"},
+    };
+    return roles;
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef P2POOLSTATSMODEL_H
+#define P2POOLSTATSMODEL_H
+
+#include <QAbstractListModel>
+#include <QContiguousCache>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#include "qt/FutureScheduler.h"
+
+// Rolling history of the stats p2pool writes to its --data-api directory. The
+// directory is watched and the files are parsed only after they changed.
+class P2PoolStatsModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(double hashrate READ hashrate NOTIFY statsChanged)
+    Q_PROPERTY(quint64 sharesFound READ sharesFound NOTIFY statsChanged)
+    Q_PROPERTY(double currentEffort READ currentEffort NOTIFY statsChanged)
+
+public:
+    enum StatsRole {
+        TimestampRole = Qt::UserRole + 1,
+        HashrateRole,
+        SharesFoundRole,
+        SharesFailedRole,
+        CurrentEffortRole,
+        AverageEffortRole,
+        UnclesRole,
+        PoolHashrateRole,
+        SidechainHeightRole,
+        NetworkDifficultyRole,
+    };
+    Q_ENUM(StatsRole)
+
+    explicit P2PoolStatsModel(QObject *parent = nullptr);
+    ~P2PoolStatsModel();
+
+    void watch(const QString &dataApiDir);
+    void stop();
+
+    double hashrate() const;
+    quint64 sharesFound() const;
+    double currentEffort() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    void statsChanged() const;
+
+private:
+    struct Sample
+    {
+        qint64 timestamp = 0;
+        double hashrate = 0;
+        quint64 sharesFound = 0;
+        quint64 sharesFailed = 0;
+        double currentEffort = 0;
+        double averageEffort = 0;
+        quint64 uncles = 0;
+        double poolHashrate = 0;
+        quint64 sidechainHeight = 0;
+        quint64 networkDifficulty = 0;
+    };
+
+    static Sample parse(const QString &dataApiDir);
+    void updateWatchedPaths();
+    void scheduleParse();
+    void parseAsync();
+    void append(const Sample &sample);
+
+private:
+    QString m_dataApiDir;
+    QContiguousCache<Sample> m_history;
+    Sample m_latest;
+    qint64 m_lastAppendTime;
+    quint64 m_generation;
+    bool m_parsing;
+    bool m_parsePending;
+    QFileSystemWatcher m_watcher;
+    QTimer m_parseTimer;
+    FutureScheduler m_scheduler;
+};
+
+#endif // P2POOLSTATSMODEL_H
@@ -0,0 +1,142 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "BackgroundSyncPolicy.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+#include <QNetworkInformation>
+#endif
+
+#include "daemon/HostResources.h"
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+// the power source is read from the OS at most this often
+constexpr std::chrono::milliseconds POWER_SAMPLE_INTERVAL = 30s;
+constexpr qint64 USER_IDLE_MS = 2 * 60 * 1000;
+
+const char *modeName(BackgroundSyncPolicy::Mode mode)
+{
+    switch (mode)
+    {
+    case BackgroundSyncPolicy::Aggressive:
+        return "aggressive";
+    case BackgroundSyncPolicy::Normal:
+        return "normal";
+    case BackgroundSyncPolicy::Trickle:
+        return "trickle";
+    default:
+        return "minimal";
+    }
+}
+
+} // namespace
+
+BackgroundSyncPolicy::BackgroundSyncPolicy()
+    : QObject(nullptr)
+    , m_metered(false)
+    , m_onBattery(false)
+    , m_onBatteryExpiry(0)
+    , m_lastMode(Normal)
+{
+}
+
+BackgroundSyncPolicy *BackgroundSyncPolicy::instance()
+{
+    // never destroyed, refresh threads may still ask during shutdown
+    static BackgroundSyncPolicy *policy = new BackgroundSyncPolicy();
+    return policy;
+}
+
+void BackgroundSyncPolicy::initialize(std::function<qint64()> lastActivity)
+{
+    m_lastActivity = std::move(lastActivity);
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    if (QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Metered))
+    {
+        QNetworkInformation *information = QNetworkInformation::instance();
+        m_metered = information->isMetered();
+        connect(information, &QNetworkInformation::isMeteredChanged, this, [this](bool metered) {
+            m_metered = metered;
+        });
+    }
+#endif
+}
+
+BackgroundSyncPolicy::Cadence BackgroundSyncPolicy::cadence()
+{
+    const bool battery = onBattery();
+    const bool metered = m_metered;
+    const bool idle = m_lastActivity && QDateTime::currentMSecsSinceEpoch() - m_lastActivity() >= USER_IDLE_MS;
+
+    Cadence cadence;
+    if (battery && metered)
+    {
+        cadence = {Minimal, 5min, 20min, QThread::LowestPriority};
+    }
+    else if (battery || metered)
+    {
+        cadence = {Trickle, 2min, 10min, QThread::LowestPriority};
+    }
+    else if (idle)
+    {
+        cadence = {Aggressive, 10s, 30s, QThread::NormalPriority};
+    }
+    else
+    {
+        // plugged in but the user is busy with something else
+        cadence = {Normal, 30s, 2min, QThread::LowPriority};
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (cadence.mode != m_lastMode)
+    {
+        qDebug() << "Background sync cadence:" << modeName(cadence.mode);
+        m_lastMode = cadence.mode;
+    }
+    return cadence;
+}
+
+bool BackgroundSyncPolicy::onBattery()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_onBatteryExpiry.hasExpired())
+    {
+        m_onBattery = HostResources::batteryPowered();
+        m_onBatteryExpiry.setRemainingTime(POWER_SAMPLE_INTERVAL);
+    }
+    return m_onBattery;
+}
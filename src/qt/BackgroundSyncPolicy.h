@@ -0,0 +1,88 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef BACKGROUNDSYNCPOLICY_H
+#define BACKGROUNDSYNCPOLICY_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include <QDeadlineTimer>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+
+// Refresh cadence for wallets that background sync while locked. Plugged in,
+// unmetered and idle hosts sync close to the tip, on battery or metered
+// networks the wallet trickles along at a low thread priority.
+class BackgroundSyncPolicy : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        Aggressive,
+        Normal,
+        Trickle,
+        Minimal
+    };
+
+    struct Cadence
+    {
+        Mode mode;
+        std::chrono::milliseconds interval;
+        // the interval doubles up to this while the daemon height doesn't change
+        std::chrono::milliseconds maxInterval;
+        QThread::Priority priority;
+    };
+
+    static BackgroundSyncPolicy *instance();
+
+    //! call once from the GUI thread, source returns msecs since epoch of the last user input
+    void initialize(std::function<qint64()> lastActivity);
+
+    //! callable from any thread
+    Cadence cadence();
+
+private:
+    BackgroundSyncPolicy();
+
+    bool onBattery();
+
+private:
+    std::function<qint64()> m_lastActivity;
+    std::atomic<bool> m_metered;
+    QMutex m_mutex;
+    bool m_onBattery;
+    QDeadlineTimer m_onBatteryExpiry;
+    Mode m_lastMode;
+};
+
+#endif // BACKGROUNDSYNCPOLICY_H
@@ -0,0 +1,239 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "DeltaPatch.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <QCryptographicHash>
+#include <QIODevice>
+
+#include <zlib.h>
+
+namespace
+{
+
+constexpr char DELTA_MAGIC[] = "MGUIDIFF";
+constexpr int DELTA_MAGIC_SIZE = sizeof(DELTA_MAGIC) - 1;
+constexpr char DELTA_VERSION = 1;
+constexpr int DELTA_HASH_SIZE = 32;
+// qCompress prepends the uncompressed size, the stream is inflated without trusting it
+constexpr int DELTA_SIZE_PREFIX = 4;
+// literal runs are written through in pieces of this size
+constexpr qint64 DELTA_WRITE_CHUNK = 1024 * 1024;
+// The delta is unsigned, a hostile one must not be able to exhaust memory or
+// disk before the hash of the result is checked. A release bundle never grows
+// this much from one version to the next, and neither the target nor the
+// inflated operations can be larger than it.
+constexpr quint64 DELTA_MAX_GROWTH = 2;
+constexpr quint64 DELTA_MIN_LIMIT = 64 * 1024 * 1024;
+
+enum Operation : quint8
+{
+    End = 0,
+    Copy = 1,
+    Add = 2,
+};
+
+void write(QIODevice &target, QCryptographicHash &targetHash, const char *data, qint64 size)
+{
+    for (qint64 offset = 0; offset < size; offset += DELTA_WRITE_CHUNK)
+    {
+        const qint64 length = std::min(DELTA_WRITE_CHUNK, size - offset);
+        if (target.write(data + offset, length) != length)
+        {
+            throw std::runtime_error("failed to write the patched file");
+        }
+        targetHash.addData(QByteArrayView(data + offset, length));
+    }
+}
+
+// Inflates the operation stream on demand, at most limit bytes in total.
+class DeltaReader
+{
+public:
+    DeltaReader(const char *data, qint64 size, quint64 limit)
+        : m_limit(limit)
+        , m_read(0)
+    {
+        m_stream = {};
+        m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        m_stream.avail_in = static_cast<uInt>(size);
+        if (inflateInit(&m_stream) != Z_OK)
+        {
+            throw std::runtime_error("failed to initialize zlib");
+        }
+    }
+
+    ~DeltaReader()
+    {
+        inflateEnd(&m_stream);
+    }
+
+    DeltaReader(const DeltaReader &) = delete;
+    DeltaReader &operator=(const DeltaReader &) = delete;
+
+    void read(char *output, quint64 size)
+    {
+        if (size > m_limit - m_read)
+        {
+            throw std::runtime_error("delta expands beyond its limit");
+        }
+        m_read += size;
+
+        m_stream.next_out = reinterpret_cast<Bytef *>(output);
+        m_stream.avail_out = static_cast<uInt>(size);
+        while (m_stream.avail_out > 0)
+        {
+            const int result = inflate(&m_stream, Z_NO_FLUSH);
+            if (result == Z_STREAM_END && m_stream.avail_out > 0)
+            {
+                throw std::runtime_error("truncated delta");
+            }
+            if (result != Z_OK && result != Z_STREAM_END)
+            {
+                throw std::runtime_error("corrupted delta");
+            }
+        }
+    }
+
+    quint64 readU64()
+    {
+        uchar bytes[8];
+        read(reinterpret_cast<char *>(bytes), sizeof(bytes));
+        quint64 value = 0;
+        for (int index = 7; index >= 0; --index)
+        {
+            value = (value << 8) | bytes[index];
+        }
+        return value;
+    }
+
+    quint8 readU8()
+    {
+        char value = 0;
+        read(&value, 1);
+        return static_cast<quint8>(value);
+    }
+
+private:
+    z_stream m_stream;
+    const quint64 m_limit;
+    quint64 m_read;
+};
+
+} // namespace
+
+void DeltaPatch::apply(
+    const QByteArray &delta,
+    const uchar *base,
+    qint64 baseSize,
+    const QByteArray &baseHash,
+    QIODevice &target,
+    QCryptographicHash &targetHash)
+{
+    constexpr int headerSize = DELTA_MAGIC_SIZE + 1 + DELTA_SIZE_PREFIX;
+    if (delta.size() <= headerSize ||
+        !delta.startsWith(QByteArrayView(DELTA_MAGIC, DELTA_MAGIC_SIZE)) ||
+        delta[DELTA_MAGIC_SIZE] != DELTA_VERSION)
+    {
+        throw std::runtime_error("unsupported delta format");
+    }
+
+    const quint64 limit = std::max(DELTA_MIN_LIMIT, static_cast<quint64>(baseSize) * DELTA_MAX_GROWTH);
+    DeltaReader stream(delta.constData() + headerSize, delta.size() - headerSize, limit);
+
+    QByteArray expectedBaseHash(DELTA_HASH_SIZE, 0);
+    stream.read(expectedBaseHash.data(), DELTA_HASH_SIZE);
+    const quint64 targetSize = stream.readU64();
+    if (expectedBaseHash != baseHash)
+    {
+        throw std::runtime_error("delta is for a different base");
+    }
+    if (targetSize > limit)
+    {
+        throw std::runtime_error("patched file is too large");
+    }
+
+    const char *source = reinterpret_cast<const char *>(base);
+    std::vector<char> literal;
+    quint64 written = 0;
+    for (;;)
+    {
+        const quint8 operation = stream.readU8();
+        if (operation == End)
+        {
+            break;
+        }
+        else if (operation == Copy)
+        {
+            const quint64 offset = stream.readU64();
+            const quint64 length = stream.readU64();
+            if (offset > static_cast<quint64>(baseSize) ||
+                length > static_cast<quint64>(baseSize) - offset)
+            {
+                throw std::runtime_error("copy out of the base file");
+            }
+            if (length > targetSize - written)
+            {
+                throw std::runtime_error("patched file is too large");
+            }
+            write(target, targetHash, source + offset, length);
+            written += length;
+        }
+        else if (operation == Add)
+        {
+            quint64 length = stream.readU64();
+            if (length > targetSize - written)
+            {
+                throw std::runtime_error("patched file is too large");
+            }
+            written += length;
+            literal.resize(static_cast<size_t>(std::min<quint64>(length, DELTA_WRITE_CHUNK)));
+            while (length > 0)
+            {
+                const quint64 chunk = std::min<quint64>(length, literal.size());
+                stream.read(literal.data(), chunk);
+                write(target, targetHash, literal.data(), chunk);
+                length -= chunk;
+            }
+        }
+        else
+        {
+            throw std::runtime_error("unknown delta operation");
+        }
+    }
+
+    if (written != targetSize)
+    {
+        throw std::runtime_error("patched file size mismatch");
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <QByteArray>
+
+class QCryptographicHash;
+class QIODevice;
+
+// Binary delta between two consecutive release bundles, applied against the
+// previous bundle to rebuild the new one. The result is checked against the
+// signed hash of the full bundle, the delta itself needs no signature.
+//
+// "MGUIDIFF", format version byte 1, then a qCompress'ed little-endian stream:
+//   base sha256 (32 bytes), target size (u64), operations until END
+//   COPY (u8 1): offset (u64), length (u64), a range of the base bundle
+//   ADD (u8 2): length (u64), length literal bytes
+//   END (u8 0)
+// The target and the inflated stream are limited to a small multiple of the
+// base size, an unsigned delta can't fill memory or disk before the check.
+class DeltaPatch
+{
+public:
+    // Writes the target to target, feeding it to targetHash on the way.
+    // Throws std::runtime_error on a malformed delta or the wrong base.
+    static void apply(
+        const QByteArray &delta,
+        const uchar *base,
+        qint64 baseSize,
+        const QByteArray &baseHash,
+        QIODevice &target,
+        QCryptographicHash &targetHash);
+};
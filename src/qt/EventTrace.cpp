@@ -0,0 +1,235 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "EventTrace.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+namespace
+{
+
+void appendEscaped(QByteArray &out, const char *text)
+{
+    for (const char *c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out += '\\';
+        }
+        if (static_cast<unsigned char>(*c) >= 0x20)
+        {
+            out += *c;
+        }
+    }
+}
+
+} // namespace
+
+EventTrace::EventTrace()
+    : QObject(nullptr)
+    , m_epoch(Clock::now())
+    , m_enabled(false)
+{
+}
+
+EventTrace *EventTrace::instance()
+{
+    // never destroyed, like SchedulerStats, threads may record during shutdown
+    static EventTrace *trace = new EventTrace();
+    return trace;
+}
+
+void EventTrace::setEnabled(bool enabled)
+{
+    if (m_enabled.exchange(enabled) != enabled)
+    {
+        emit enabledChanged();
+    }
+}
+
+void EventTrace::complete(const char *category, const char *name, Clock::time_point begin, Clock::time_point end)
+{
+    record('X', category, name, begin, std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count());
+}
+
+void EventTrace::instant(const char *category, const char *name)
+{
+    if (enabled())
+    {
+        record('i', category, name, Clock::now(), 0);
+    }
+}
+
+void EventTrace::counter(const char *category, const char *name, qint64 value)
+{
+    if (enabled())
+    {
+        record('C', category, name, Clock::now(), value);
+    }
+}
+
+void EventTrace::record(char phase, const char *category, const char *name, Clock::time_point at, qint64 value)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    const quint64 index = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[index % bufferCapacity] = Event{
+        category,
+        name,
+        phase,
+        std::chrono::duration_cast<std::chrono::microseconds>(at - m_epoch).count(),
+        value,
+    };
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+EventTrace::ThreadBuffer *EventTrace::threadBuffer()
+{
+    // buffers are never released, the trace outlives every thread
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (buffer)
+    {
+        return buffer;
+    }
+
+    auto created = std::make_shared<ThreadBuffer>();
+    created->events.resize(bufferCapacity);
+    QThread *thread = QThread::currentThread();
+    created->name = thread->objectName();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+    {
+        created->name = QStringLiteral("main");
+    }
+
+    QMutexLocker locker(&m_mutex);
+    created->id = m_buffers.size() + 1;
+    if (created->name.isEmpty())
+    {
+        created->name = QStringLiteral("thread %1").arg(created->id);
+    }
+    m_buffers.push_back(created);
+    buffer = created.get();
+    return buffer;
+}
+
+bool EventTrace::save(const QString &path) const
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        QMutexLocker locker(&m_mutex);
+        buffers = m_buffers;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Failed to write event trace" << path;
+        return false;
+    }
+
+    QByteArray out;
+    out.reserve(1 << 20);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    const auto separator = [&out, &first] {
+        if (!first)
+        {
+            out += ",\n";
+        }
+        first = false;
+    };
+
+    for (const std::shared_ptr<ThreadBuffer> &buffer : buffers)
+    {
+        const QByteArray tid = QByteArray::number(buffer->id);
+        separator();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":\"";
+        appendEscaped(out, buffer->name.toUtf8().constData());
+        out += "\"}}";
+
+        const quint64 end = buffer->written.load(std::memory_order_acquire);
+        const quint64 begin = end > quint64(bufferCapacity) ? end - bufferCapacity : 0;
+        std::vector<Event> events;
+        events.reserve(end - begin);
+        for (quint64 index = begin; index < end; ++index)
+        {
+            events.push_back(buffer->events[index % bufferCapacity]);
+        }
+        // whatever the thread wrote while copying replaced the oldest events
+        const quint64 after = buffer->written.load(std::memory_order_acquire);
+        const quint64 overwritten = after > quint64(bufferCapacity) ? after - bufferCapacity : 0;
+        const size_t skip = overwritten > begin ? std::min<size_t>(overwritten - begin, events.size()) : 0;
+
+        for (size_t i = skip; i < events.size(); ++i)
+        {
+            const Event &event = events[i];
+            separator();
+            out += "{\"name\":\"";
+            appendEscaped(out, event.name);
+            out += "\",\"cat\":\"";
+            appendEscaped(out, event.category);
+            out += "\",\"ph\":\"";
+            out += event.phase;
+            out += "\",\"ts\":" + QByteArray::number(event.timestampUs) + ",\"pid\":1,\"tid\":" + tid;
+            if (event.phase == 'X')
+            {
+                out += ",\"dur\":" + QByteArray::number(event.value);
+            }
+            else if (event.phase == 'i')
+            {
+                out += ",\"s\":\"t\"";
+            }
+            else if (event.phase == 'C')
+            {
+                out += ",\"args\":{\"value\":" + QByteArray::number(event.value) + "}";
+            }
+            out += "}";
+
+            if (out.size() >= (1 << 20))
+            {
+                file.write(out);
+                out.resize(0);
+            }
+        }
+    }
+    out += "]}\n";
+    file.write(out);
+
+    if (!file.commit())
+    {
+        qWarning() << "Failed to write event trace" << path;
+        return false;
+    }
+    return true;
+}
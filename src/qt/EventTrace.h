@@ -0,0 +1,141 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef EVENTTRACE_H
+#define EVENTTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+
+// Timeline of what the GUI was busy with, in the Chrome trace format that
+// Perfetto and chrome://tracing open. Off unless enabled, recording then
+// appends to a fixed size ring per thread without taking a lock, the oldest
+// events of a busy thread are overwritten. save() writes what is buffered.
+class EventTrace : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // events kept per thread
+    static constexpr int bufferCapacity = 1 << 14;
+
+    static EventTrace *instance();
+
+    bool enabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+    void setEnabled(bool enabled);
+
+    // callable from any thread, category and name must be string literals
+    void complete(const char *category, const char *name, Clock::time_point begin, Clock::time_point end);
+    void instant(const char *category, const char *name);
+    void counter(const char *category, const char *name, qint64 value);
+
+    //! writes the buffered events as Chrome trace JSON
+    Q_INVOKABLE bool save(const QString &path) const;
+
+signals:
+    void enabledChanged() const;
+
+private:
+    EventTrace();
+
+    struct Event
+    {
+        const char *category;
+        const char *name;
+        char phase;
+        qint64 timestampUs;
+        // duration of complete events, value of counters
+        qint64 value;
+    };
+
+    struct ThreadBuffer
+    {
+        quint64 id;
+        QString name;
+        std::vector<Event> events;
+        // only the owning thread writes, readers skip what it overwrote meanwhile
+        std::atomic<quint64> written{0};
+    };
+
+    void record(char phase, const char *category, const char *name, Clock::time_point at, qint64 value);
+    ThreadBuffer *threadBuffer();
+
+private:
+    const Clock::time_point m_epoch;
+    std::atomic<bool> m_enabled;
+    mutable QMutex m_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+};
+
+//! traces the lifetime of a scope as one complete event
+class TraceScope
+{
+public:
+    TraceScope(const char *category, const char *name)
+        : m_category(category)
+        , m_name(name)
+        , m_active(EventTrace::instance()->enabled())
+    {
+        if (m_active)
+        {
+            m_begin = EventTrace::Clock::now();
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (m_active)
+        {
+            EventTrace::instance()->complete(m_category, m_name, m_begin, EventTrace::Clock::now());
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_category;
+    const char *m_name;
+    const bool m_active;
+    EventTrace::Clock::time_point m_begin;
+};
+
+#endif // EVENTTRACE_H
@@ -1,9 +1,88 @@
 #include "FutureScheduler.h"
+#include "EventTrace.h"
+#include "SchedulerStats.h"
 
+#include <algorithm>
 #include <mutex>
 
+#include <QDeadlineTimer>
 #include <QThreadPool>
 
+namespace
+{
+
+struct LanePools
+{
+    LanePools()
+    {
+        pools[FutureScheduler::Interactive].setMaxThreadCount(2);
+        pools[FutureScheduler::Background].setMaxThreadCount(2);
+        // every wallet's refresh loop adds a thread of its own on top
+        pools[FutureScheduler::BlockingIO].setMaxThreadCount(5);
+    }
+
+    QThreadPool pools[FutureScheduler::LaneCount];
+};
+
+Q_GLOBAL_STATIC(LanePools, lanePools)
+
+static_assert(FutureScheduler::LaneCount == SchedulerStats::laneCount, "lane count mismatch");
+
+} // namespace
+
+CancellationToken::CancellationToken()
+    : m_state(std::make_shared<State>())
+{
+}
+
+bool CancellationToken::cancelled() const noexcept
+{
+    return m_state->cancelled;
+}
+
+bool CancellationToken::sleepFor(std::chrono::milliseconds duration) const
+{
+    const QDeadlineTimer deadline(duration);
+    QMutexLocker locker(&m_state->mutex);
+    while (!m_state->cancelled && !deadline.hasExpired())
+    {
+        m_state->condition.wait(&m_state->mutex, deadline);
+    }
+    return !m_state->cancelled;
+}
+
+void CancellationToken::onCancelled(std::function<void()> callback) const
+{
+    {
+        QMutexLocker locker(&m_state->mutex);
+        if (!m_state->cancelled)
+        {
+            m_state->callbacks.push_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+void CancellationToken::cancel() const
+{
+    std::vector<std::function<void()>> callbacks;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        if (m_state->cancelled.exchange(true))
+        {
+            return;
+        }
+        callbacks.swap(m_state->callbacks);
+    }
+    m_state->condition.wakeAll();
+
+    for (const auto &callback : callbacks)
+    {
+        callback();
+    }
+}
+
 FutureScheduler::FutureScheduler(QObject *parent)
     : QObject(parent), Alive(0), Stopping(false)
 {
@@ -13,60 +92,100 @@ FutureScheduler::FutureScheduler(QObject *parent)
     });
 }
 
+QThreadPool *FutureScheduler::pool(Lane lane)
+{
+    return &lanePools->pools[lane];
+}
+
+void FutureScheduler::setMaxConcurrency(Lane lane, int maxThreads)
+{
+    pool(lane)->setMaxThreadCount(std::max(1, maxThreads));
+}
+
+int FutureScheduler::maxConcurrency(Lane lane)
+{
+    return pool(lane)->maxThreadCount();
+}
+
 FutureScheduler::~FutureScheduler()
 {
     shutdownWaitForFinished();
 }
 
+void FutureScheduler::cancel() noexcept
+{
+    {
+        QMutexLocker locker(&Mutex);
+        Stopping = true;
+    }
+
+    try
+    {
+        Token.cancel();
+    }
+    catch (const std::exception &exception)
+    {
+        qWarning() << "Exception thrown from cancellation callback: " << exception.what();
+    }
+}
+
 void FutureScheduler::shutdownWaitForFinished() noexcept
 {
-    QMutexLocker locker(&Mutex);
+    cancel();
 
-    Stopping = true;
+    QMutexLocker locker(&Mutex);
     while (Alive > 0)
     {
         Condition.wait(&Mutex);
     }
 }
 
-QPair<bool, QFuture<void>> FutureScheduler::run(std::function<void()> function) noexcept
+QPair<bool, QFuture<void>> FutureScheduler::run(std::function<void()> function, Lane lane /* = Background */, const char *tag /* = nullptr */) noexcept
 {
-    return execute<void>([this, function](QFutureWatcher<void> *) {
-        return QtConcurrent::run([this, function] {
+    return execute<void>([this, function, lane, tag](QFutureWatcher<void> *) {
+        const auto queued = SchedulerStats::instance()->taskQueued(lane);
+        return QtConcurrent::run(pool(lane), [this, function, lane, tag, queued] {
+            const auto started = SchedulerStats::instance()->taskStarted(lane);
             try
             {
+                const TraceScope trace("scheduler", tag ? tag : "task");
                 function();
             }
             catch (const std::exception &exception)
             {
                 qWarning() << "Exception thrown from async function: " << exception.what();
             }
+            SchedulerStats::instance()->taskFinished(lane, tag, queued, started);
             done();
         });
     });
 }
 
-QPair<bool, QFuture<QJSValueList>> FutureScheduler::run(std::function<QJSValueList()> function, const QJSValue &callback)
+QPair<bool, QFuture<QJSValueList>> FutureScheduler::run(std::function<QJSValueList()> function, const QJSValue &callback, Lane lane /* = Background */, const char *tag /* = nullptr */)
 {
     if (!callback.isCallable())
     {
         throw std::runtime_error("js callback must be callable");
     }
 
-    return execute<QJSValueList>([this, function, callback](QFutureWatcher<QJSValueList> *watcher) {
+    return execute<QJSValueList>([this, function, callback, lane, tag](QFutureWatcher<QJSValueList> *watcher) {
         connect(watcher, &QFutureWatcher<QJSValueList>::finished, [watcher, callback] {
             QJSValue(callback).call(watcher->future().result());
         });
-        return QtConcurrent::run([this, function] {
+        const auto queued = SchedulerStats::instance()->taskQueued(lane);
+        return QtConcurrent::run(pool(lane), [this, function, lane, tag, queued] {
+            const auto started = SchedulerStats::instance()->taskStarted(lane);
             QJSValueList result;
             try
             {
+                const TraceScope trace("scheduler", tag ? tag : "task");
                 result = function();
             }
             catch (const std::exception &exception)
             {
                 qWarning() << "Exception thrown from async function: " << exception.what();
             }
+            SchedulerStats::instance()->taskFinished(lane, tag, queued, started);
             done();
             return result;
         });
@@ -78,6 +197,11 @@ bool FutureScheduler::stopping() const noexcept
     return Stopping;
 }
 
+const CancellationToken &FutureScheduler::token() const noexcept
+{
+    return Token;
+}
+
 bool FutureScheduler::add() noexcept
 {
     QMutexLocker locker(&Mutex);
@@ -1,7 +1,11 @@
 #ifndef FUTURE_SCHEDULER_H
 #define FUTURE_SCHEDULER_H
 
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
+#include <vector>
 
 #include <QtConcurrent/QtConcurrent>
 #include <QFuture>
@@ -11,21 +15,69 @@
 #include <QPair>
 #include <QWaitCondition>
 
+class QThreadPool;
+
+// Cancelled as soon as the owning scheduler starts shutting down. Loops poll
+// it and wait on it instead of sleeping, callbacks abort blocking I/O, so a
+// shutdown doesn't have to sit out whatever is in flight. Copies share state.
+class CancellationToken
+{
+public:
+    CancellationToken();
+
+    bool cancelled() const noexcept;
+    // false as soon as the token is cancelled, true once duration passed
+    bool sleepFor(std::chrono::milliseconds duration) const;
+    // runs on the cancelling thread, right away if already cancelled
+    void onCancelled(std::function<void()> callback) const;
+    void cancel() const;
+
+private:
+    struct State
+    {
+        std::atomic<bool> cancelled{false};
+        QMutex mutex;
+        QWaitCondition condition;
+        std::vector<std::function<void()>> callbacks;
+    };
+    std::shared_ptr<State> m_state;
+};
+
 class FutureScheduler : public QObject
 {
     Q_OBJECT
 
 public:
+    // Every lane runs on its own bounded thread pool shared by all schedulers,
+    // long running work in one lane can't starve the others.
+    enum Lane {
+        Interactive = 0, // short tasks the UI is waiting for (status, heights, fees)
+        Background,      // CPU heavy wallet work (transactions, proofs)
+        BlockingIO,      // disk, network, device and process I/O, long running loops
+        LaneCount
+    };
+
     FutureScheduler(QObject *parent);
     ~FutureScheduler();
 
+    // cancels the token and refuses new tasks without waiting for running ones
+    void cancel() noexcept;
     void shutdownWaitForFinished() noexcept;
 
-    QPair<bool, QFuture<void>> run(std::function<void()> function) noexcept;
-    QPair<bool, QFuture<QJSValueList>> run(std::function<QJSValueList()> function, const QJSValue &callback);
+    // Tasks must not block on other tasks of the same scheduler, a pool thread
+    // waiting for a queued task is a deadlock once the lane is saturated.
+    // tag names the call site in SchedulerStats and must be a string literal.
+    QPair<bool, QFuture<void>> run(std::function<void()> function, Lane lane = Background, const char *tag = nullptr) noexcept;
+    QPair<bool, QFuture<QJSValueList>> run(std::function<QJSValueList()> function, const QJSValue &callback, Lane lane = Background, const char *tag = nullptr);
     bool stopping() const noexcept;
+    const CancellationToken &token() const noexcept;
+
+    static void setMaxConcurrency(Lane lane, int maxThreads);
+    static int maxConcurrency(Lane lane);
 
 private:
+    static QThreadPool *pool(Lane lane);
+
     bool add() noexcept;
     void done() noexcept;
 
@@ -58,6 +110,7 @@ private:
     QWaitCondition Condition;
     QMutex Mutex;
     std::atomic<bool> Stopping;
+    CancellationToken Token;
 };
 
 #endif // FUTURE_SCHEDULER_H
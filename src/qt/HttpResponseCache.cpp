@@ -0,0 +1,212 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "HttpResponseCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "TailsOS.h"
+
+namespace
+{
+    constexpr qint64 MEMORY_CACHE_BYTES = 4 * 1024 * 1024;
+    // larger bodies (release bundles) are only kept in memory
+    constexpr qint64 DISK_CACHE_MAX_BODY_BYTES = 1024 * 1024;
+    constexpr quint32 DISK_CACHE_VERSION = 1;
+}
+
+bool HttpResponseCache::Entry::fresh(qint64 overrideMaxAge) const
+{
+    const qint64 limit = overrideMaxAge >= 0 ? overrideMaxAge : (noCache ? 0 : std::max<qint64>(maxAge, 0));
+    return QDateTime::currentMSecsSinceEpoch() - storedAt < limit * 1000;
+}
+
+bool HttpResponseCache::Entry::revalidatable() const
+{
+    return !etag.isEmpty() || !lastModified.isEmpty();
+}
+
+HttpResponseCache &HttpResponseCache::instance()
+{
+    static HttpResponseCache cache;
+    return cache;
+}
+
+HttpResponseCache::HttpResponseCache()
+    : m_memory(MEMORY_CACHE_BYTES)
+    , m_directory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http")
+    , m_diskEnabled(!TailsOS::detect())
+{
+}
+
+bool HttpResponseCache::lookup(const QString &url, Entry &entry, bool persistent)
+{
+    QMutexLocker locker(&m_mutex);
+    if (const Entry *cached = m_memory.object(url))
+    {
+        entry = *cached;
+        return true;
+    }
+    if (!persistent || !m_diskEnabled || !load(url, entry))
+    {
+        return false;
+    }
+    m_memory.insert(url, new Entry(entry), entry.body.size());
+    return true;
+}
+
+void HttpResponseCache::store(const QString &url, Entry entry, const QString &cacheControl, qint64 maxAge, bool persistent)
+{
+    bool noStore = false;
+    parseCacheControl(cacheControl, entry, noStore);
+    entry.storedAt = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    // useless without validators or a freshness lifetime
+    if (noStore || (!entry.revalidatable() && entry.maxAge <= 0 && maxAge <= 0))
+    {
+        m_memory.remove(url);
+        if (m_diskEnabled)
+        {
+            QFile::remove(filePath(url));
+        }
+        return;
+    }
+
+    if (persistent && m_diskEnabled)
+    {
+        save(url, entry);
+    }
+    const qsizetype cost = entry.body.size();
+    m_memory.insert(url, new Entry(std::move(entry)), cost);
+}
+
+void HttpResponseCache::refresh(const QString &url, const QString &cacheControl, bool persistent)
+{
+    QMutexLocker locker(&m_mutex);
+    persistent = persistent && m_diskEnabled;
+    Entry *entry = m_memory.object(url);
+    if (!entry)
+    {
+        Entry loaded;
+        if (!persistent || !load(url, loaded))
+        {
+            return;
+        }
+        const qsizetype cost = loaded.body.size();
+        entry = new Entry(std::move(loaded));
+        if (!m_memory.insert(url, entry, cost))
+        {
+            return;
+        }
+    }
+
+    bool noStore = false;
+    parseCacheControl(cacheControl, *entry, noStore);
+    entry->storedAt = QDateTime::currentMSecsSinceEpoch();
+    if (persistent)
+    {
+        save(url, *entry);
+    }
+}
+
+QString HttpResponseCache::filePath(const QString &url) const
+{
+    return m_directory + "/" + QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha256).toHex();
+}
+
+bool HttpResponseCache::load(const QString &url, Entry &entry) const
+{
+    QFile file(filePath(url));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 version = 0;
+    QString storedUrl;
+    stream >> version >> storedUrl;
+    if (version != DISK_CACHE_VERSION || storedUrl != url)
+    {
+        return false;
+    }
+    stream >> entry.etag >> entry.lastModified >> entry.storedAt >> entry.maxAge >> entry.noCache >> entry.body;
+    return stream.status() == QDataStream::Ok;
+}
+
+void HttpResponseCache::save(const QString &url, const Entry &entry) const
+{
+    if (entry.body.size() > DISK_CACHE_MAX_BODY_BYTES)
+    {
+        return;
+    }
+
+    QDir().mkpath(m_directory);
+    QSaveFile file(filePath(url));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Failed to write HTTP cache entry" << file.fileName();
+        return;
+    }
+    QDataStream stream(&file);
+    stream << DISK_CACHE_VERSION << url;
+    stream << entry.etag << entry.lastModified << entry.storedAt << entry.maxAge << entry.noCache << entry.body;
+    file.commit();
+}
+
+void HttpResponseCache::parseCacheControl(const QString &cacheControl, Entry &entry, bool &noStore)
+{
+    entry.maxAge = -1;
+    entry.noCache = false;
+    for (const QString &directive : cacheControl.split(',', Qt::SkipEmptyParts))
+    {
+        const QString token = directive.trimmed().toLower();
+        if (token == "no-store")
+        {
+            noStore = true;
+        }
+        else if (token == "no-cache")
+        {
+            entry.noCache = true;
+        }
+        else if (token.startsWith("max-age="))
+        {
+            bool ok = false;
+            const qint64 maxAge = token.mid(8).toLongLong(&ok);
+            entry.maxAge = ok ? maxAge : -1;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QString>
+
+// Process-wide cache of GET responses: a small in-memory LRU in front of an
+// on-disk tier. Freshness follows Cache-Control unless the request overrides
+// the max-age, stale entries are revalidated with their ETag/Last-Modified.
+// The disk tier is never used on Tails, nor for requests made with
+// persistent = false (e.g. through a proxy).
+class HttpResponseCache
+{
+public:
+    struct Entry
+    {
+        QByteArray body;
+        QString etag;
+        QString lastModified;
+        qint64 storedAt = 0;
+        // seconds, -1 when the server didn't say
+        qint64 maxAge = -1;
+        bool noCache = false;
+
+        // maxAge >= 0 overrides the server provided freshness
+        bool fresh(qint64 maxAge) const;
+        bool revalidatable() const;
+    };
+
+    static HttpResponseCache &instance();
+
+    // persistent = false keeps the entry in memory only
+    bool lookup(const QString &url, Entry &entry, bool persistent);
+    // cacheControl is the response's Cache-Control header value
+    void store(const QString &url, Entry entry, const QString &cacheControl, qint64 maxAge, bool persistent);
+    // a 304 response renews the stored entry
+    void refresh(const QString &url, const QString &cacheControl, bool persistent);
+
+private:
+    HttpResponseCache();
+
+    QString filePath(const QString &url) const;
+    bool load(const QString &url, Entry &entry) const;
+    void save(const QString &url, const Entry &entry) const;
+    static void parseCacheControl(const QString &cacheControl, Entry &entry, bool &noStore);
+
+private:
+    QMutex m_mutex;
+    QCache<QString, Entry> m_memory;
+    QString m_directory;
+    const bool m_diskEnabled;
+};
@@ -0,0 +1,67 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef INDEXEDMAP_H
+#define INDEXEDMAP_H
+
+#include <numeric>
+
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+
+// Computes function(index) for every index below count and returns the
+// results in index order. Runs synchronously on the calling thread, larger
+// batches are spread over QThreadPool::globalInstance() and the call returns
+// once all of them are done.
+template<typename Result, typename Function>
+QVector<Result> mapIndexes(int count, Function function)
+{
+    // batches below this aren't worth waking the pool for
+    constexpr int parallelThreshold = 64;
+
+    QVector<Result> results(count);
+    // detach once up front, the workers then only write their own element
+    Result *out = results.data();
+    if (count < parallelThreshold)
+    {
+        for (int index = 0; index < count; ++index)
+        {
+            out[index] = function(index);
+        }
+        return results;
+    }
+
+    QVector<int> indexes(count);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    QtConcurrent::blockingMap(indexes, [out, &function](int index) {
+        out[index] = function(index);
+    });
+    return results;
+}
+
+#endif // INDEXEDMAP_H
@@ -26,11 +26,16 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QMap>
 #include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
 #include <QUrl>
 #include <QtConcurrent/QtConcurrent>
 #include <QMutex>
@@ -43,6 +48,13 @@
 
 #include "KeysFiles.h"
 
+namespace
+{
+    // keys files handed to a single parse task
+    constexpr int KEYS_FILES_BATCH_SIZE = 16;
+    constexpr int KEYS_FILES_RESCAN_DELAY_MS = 500;
+    constexpr int KEYS_FILES_CACHE_VERSION = 1;
+}
 
 WalletKeysFiles::WalletKeysFiles(const QFileInfo &info, quint8 networkType, QString address)
     : m_fileName(info.fileName())
@@ -81,11 +93,27 @@ quint8 WalletKeysFiles::networkType() const
 
 WalletKeysFilesModel::WalletKeysFilesModel(QObject *parent)
     : QAbstractListModel(parent)
+    , m_scanGeneration(0)
+    , m_scanPending(0)
+    , m_scanning(false)
+    , m_cacheDirty(false)
+    , m_scheduler(this)
 {
     this->m_walletKeysFilesModelProxy.setSourceModel(this);
     this->m_walletKeysFilesModelProxy.setSortRole(WalletKeysFilesModel::ModifiedRole);
     this->m_walletKeysFilesModelProxy.setDynamicSortFilter(true);
     this->m_walletKeysFilesModelProxy.sort(0, Qt::DescendingOrder);
+
+    // a wallet being created or copied touches the directory several times
+    m_rescanTimer.setSingleShot(true);
+    m_rescanTimer.setInterval(KEYS_FILES_RESCAN_DELAY_MS);
+    connect(&m_rescanTimer, &QTimer::timeout, this, &WalletKeysFilesModel::scan);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &WalletKeysFilesModel::scheduleRescan);
+}
+
+WalletKeysFilesModel::~WalletKeysFilesModel()
+{
+    m_scheduler.shutdownWaitForFinished();
 }
 
 QSortFilterProxyModel *WalletKeysFilesModel::proxyModel()
@@ -95,15 +123,411 @@ QSortFilterProxyModel *WalletKeysFilesModel::proxyModel()
 
 void WalletKeysFilesModel::clear()
 {
+    ++m_scanGeneration;
+    m_scanPending = 0;
+    m_scanSeen.clear();
+    m_moneroAccountsDir.clear();
+    m_rescanTimer.stop();
+    const QStringList watched = m_watcher.directories();
+    if (!watched.isEmpty())
+    {
+        m_watcher.removePaths(watched);
+    }
+    setScanning(false);
+
     beginResetModel();
     m_walletKeyFiles.clear();
     endResetModel();
+    emit countChanged();
 }
 
 void WalletKeysFilesModel::refresh(const QString &moneroAccountsDir)
 {
     this->clear();
-    this->findWallets(moneroAccountsDir);
+    m_moneroAccountsDir = moneroAccountsDir;
+    this->scan();
+}
+
+void WalletKeysFilesModel::scheduleRescan()
+{
+    if (!m_moneroAccountsDir.isEmpty())
+    {
+        m_rescanTimer.start();
+    }
+}
+
+void WalletKeysFilesModel::scan()
+{
+    if (m_moneroAccountsDir.isEmpty())
+    {
+        return;
+    }
+
+    const quint64 generation = ++m_scanGeneration;
+    const QString moneroAccountsDir = m_moneroAccountsDir;
+    const bool cacheLoaded = m_cacheDir == moneroAccountsDir;
+    m_scanPending = 0;
+    m_scanSeen.clear();
+
+    const auto future = m_scheduler.run([this, moneroAccountsDir, generation, cacheLoaded, cache = cacheLoaded ? m_cache : Cache()]() mutable {
+        if (!cacheLoaded)
+        {
+            cache = loadCache(moneroAccountsDir);
+            QMetaObject::invokeMethod(this, [this, moneroAccountsDir, cache] {
+                if (m_cacheDir != moneroAccountsDir)
+                {
+                    m_cache = cache;
+                    m_cacheDir = moneroAccountsDir;
+                    m_cacheDirty = false;
+                }
+            }, Qt::QueuedConnection);
+        }
+
+        // files whose stamp matches the cache only need the stat done above,
+        // everything else is handed to parse tasks
+        const QDir root(moneroAccountsDir);
+        QStringList directories{moneroAccountsDir};
+        QSet<QString> found;
+        QList<WalletKeysFiles> cached;
+        QStringList changed;
+        QDirIterator it(moneroAccountsDir, QDirIterator::Subdirectories);
+        while (it.hasNext() && !m_scheduler.stopping())
+        {
+            it.next();
+
+            const QFileInfo keysFileinfo = it.fileInfo();
+            if (keysFileinfo.isDir())
+            {
+                if (keysFileinfo.fileName() != "." && keysFileinfo.fileName() != "..")
+                {
+                    directories << keysFileinfo.filePath();
+                }
+                continue;
+            }
+
+            constexpr const char keysFileExtension[] = "keys";
+            if (!keysFileinfo.isFile() || keysFileinfo.suffix() != keysFileExtension)
+            {
+                continue;
+            }
+
+            const QString keysFilePath = keysFileinfo.filePath();
+            const QString relativePath = root.relativeFilePath(keysFilePath);
+            found.insert(relativePath);
+
+            const auto entry = cache.constFind(relativePath);
+            if (entry != cache.constEnd() && entry->stamp == keysFileStamp(keysFilePath))
+            {
+                cached << WalletKeysFiles(QFileInfo(walletPathFromKeysFile(keysFilePath)), entry->networkType, entry->address);
+            }
+            else
+            {
+                changed << keysFilePath;
+            }
+
+            if (cached.size() + changed.size() >= KEYS_FILES_BATCH_SIZE)
+            {
+                QMetaObject::invokeMethod(this, [this, generation, cached, changed] {
+                    keysFilesParsed(generation, cached);
+                    keysFilesFound(generation, changed);
+                }, Qt::QueuedConnection);
+                cached.clear();
+                changed.clear();
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, moneroAccountsDir, generation, cached, changed, directories, found] {
+            keysFilesParsed(generation, cached);
+            keysFilesFound(generation, changed);
+            if (generation == m_scanGeneration)
+            {
+                updateWatchedDirectories(directories);
+                if (m_cacheDir == moneroAccountsDir)
+                {
+                    for (auto entry = m_cache.begin(); entry != m_cache.end();)
+                    {
+                        if (found.contains(entry.key()))
+                        {
+                            ++entry;
+                        }
+                        else
+                        {
+                            entry = m_cache.erase(entry);
+                            m_cacheDirty = true;
+                        }
+                    }
+                }
+            }
+            scanTaskDone(generation);
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "WalletKeysFilesModel::scan");
+
+    if (future.first)
+    {
+        m_scanPending = 1;
+    }
+    setScanning(future.first);
+}
+
+void WalletKeysFilesModel::keysFilesFound(quint64 generation, const QStringList &keysFilePaths)
+{
+    if (generation != m_scanGeneration || keysFilePaths.isEmpty())
+    {
+        return;
+    }
+
+    const QString moneroAccountsDir = m_moneroAccountsDir;
+    const auto future = m_scheduler.run([this, moneroAccountsDir, generation, keysFilePaths] {
+        const QDir root(moneroAccountsDir);
+        QList<WalletKeysFiles> walletKeysFiles;
+        QList<QPair<QString, CacheEntry>> entries;
+        walletKeysFiles.reserve(keysFilePaths.size());
+        entries.reserve(keysFilePaths.size());
+        for (const QString &keysFilePath : keysFilePaths)
+        {
+            // stamp before parsing, a file changing meanwhile is parsed again next time
+            const KeysFileStamp stamp = keysFileStamp(keysFilePath);
+            WalletKeysFiles walletKeysFile = walletKeysFileFromPath(keysFilePath);
+            entries << qMakePair(root.relativeFilePath(keysFilePath), CacheEntry{stamp, walletKeysFile.networkType(), walletKeysFile.address()});
+            walletKeysFiles << std::move(walletKeysFile);
+        }
+
+        QMetaObject::invokeMethod(this, [this, moneroAccountsDir, generation, walletKeysFiles, entries] {
+            if (generation == m_scanGeneration)
+            {
+                keysFilesParsed(generation, walletKeysFiles);
+                if (m_cacheDir == moneroAccountsDir)
+                {
+                    for (const auto &entry : entries)
+                    {
+                        m_cache.insert(entry.first, entry.second);
+                    }
+                    m_cacheDirty = true;
+                }
+            }
+            scanTaskDone(generation);
+        }, Qt::QueuedConnection);
+    }, FutureScheduler::BlockingIO, "WalletKeysFilesModel::parse");
+
+    if (future.first)
+    {
+        ++m_scanPending;
+    }
+}
+
+void WalletKeysFilesModel::keysFilesParsed(quint64 generation, const QList<WalletKeysFiles> &walletKeysFiles)
+{
+    if (generation != m_scanGeneration || walletKeysFiles.isEmpty())
+    {
+        return;
+    }
+
+    QList<WalletKeysFiles> added;
+    for (const WalletKeysFiles &walletKeysFile : walletKeysFiles)
+    {
+        m_scanSeen.insert(walletKeysFile.path());
+
+        const auto existing = std::find_if(m_walletKeyFiles.begin(), m_walletKeyFiles.end(), [&walletKeysFile](const WalletKeysFiles &row) {
+            return row.path() == walletKeysFile.path();
+        });
+        if (existing == m_walletKeyFiles.end())
+        {
+            added << walletKeysFile;
+            continue;
+        }
+
+        *existing = walletKeysFile;
+        const QModelIndex changed = index(std::distance(m_walletKeyFiles.begin(), existing));
+        emit dataChanged(changed, changed);
+    }
+
+    addWalletKeysFiles(added);
+}
+
+void WalletKeysFilesModel::scanTaskDone(quint64 generation)
+{
+    if (generation != m_scanGeneration || --m_scanPending > 0)
+    {
+        return;
+    }
+
+    removeMissingWalletKeysFiles();
+    setScanning(false);
+
+    if (m_cacheDirty && m_cacheDir == m_moneroAccountsDir)
+    {
+        m_cacheDirty = false;
+        m_scheduler.run([moneroAccountsDir = m_cacheDir, cache = m_cache] {
+            saveCache(moneroAccountsDir, cache);
+        }, FutureScheduler::BlockingIO, "WalletKeysFilesModel::saveCache");
+    }
+}
+
+void WalletKeysFilesModel::removeMissingWalletKeysFiles()
+{
+    bool removed = false;
+    for (int row = m_walletKeyFiles.size() - 1; row >= 0; --row)
+    {
+        if (!m_scanSeen.contains(m_walletKeyFiles[row].path()))
+        {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_walletKeyFiles.removeAt(row);
+            endRemoveRows();
+            removed = true;
+        }
+    }
+
+    if (removed)
+    {
+        emit countChanged();
+    }
+}
+
+void WalletKeysFilesModel::updateWatchedDirectories(const QStringList &directories)
+{
+    const QStringList watchedList = m_watcher.directories();
+    const QSet<QString> watched(watchedList.begin(), watchedList.end());
+    const QSet<QString> wanted(directories.begin(), directories.end());
+
+    const QSet<QString> stale = watched - wanted;
+    if (!stale.isEmpty())
+    {
+        m_watcher.removePaths(stale.values());
+    }
+
+    const QSet<QString> added = wanted - watched;
+    if (!added.isEmpty())
+    {
+        m_watcher.addPaths(added.values());
+    }
+}
+
+bool WalletKeysFilesModel::scanning() const
+{
+    return m_scanning;
+}
+
+void WalletKeysFilesModel::setScanning(bool scanning)
+{
+    if (m_scanning != scanning)
+    {
+        m_scanning = scanning;
+        emit scanningChanged();
+    }
+}
+
+QString WalletKeysFilesModel::walletPathFromKeysFile(const QString &keysFilePath)
+{
+    const QFileInfo keysFileinfo(keysFilePath);
+    return keysFileinfo.path() + QDir::separator() + keysFileinfo.completeBaseName();
+}
+
+WalletKeysFiles WalletKeysFilesModel::walletKeysFileFromPath(const QString &keysFilePath)
+{
+    QString wallet(walletPathFromKeysFile(keysFilePath));
+    auto networkTypeAndAddress = OSHelper::getNetworkTypeAndAddressFromFile(wallet);
+    quint8 networkType = networkTypeAndAddress.first;
+    QString address = networkTypeAndAddress.second;
+
+    return WalletKeysFiles(QFileInfo(wallet), networkType, std::move(address));
+}
+
+WalletKeysFilesModel::KeysFileStamp WalletKeysFilesModel::keysFileStamp(const QString &keysFilePath)
+{
+    // the network type and address are read from the address file next to the keys file
+    KeysFileStamp stamp;
+    const QFileInfo keysFileinfo(keysFilePath);
+    stamp.keysSize = keysFileinfo.size();
+    stamp.keysModified = keysFileinfo.lastModified().toMSecsSinceEpoch();
+
+    const QFileInfo addressFileinfo(walletPathFromKeysFile(keysFilePath) + ".address.txt");
+    if (addressFileinfo.exists())
+    {
+        stamp.addressSize = addressFileinfo.size();
+        stamp.addressModified = addressFileinfo.lastModified().toMSecsSinceEpoch();
+    }
+    return stamp;
+}
+
+QString WalletKeysFilesModel::cacheFilePath(const QString &moneroAccountsDir)
+{
+    // kept next to the wallets, it holds nothing the address files don't
+    return QDir(moneroAccountsDir).filePath(".keys_files_cache.json");
+}
+
+WalletKeysFilesModel::Cache WalletKeysFilesModel::loadCache(const QString &moneroAccountsDir)
+{
+    Cache cache;
+
+    QFile file(cacheFilePath(moneroAccountsDir));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return cache;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject())
+    {
+        qWarning() << "Ignoring malformed keys files cache" << file.fileName();
+        return cache;
+    }
+
+    const QJsonObject root = document.object();
+    if (root.value("version").toInt() != KEYS_FILES_CACHE_VERSION)
+    {
+        return cache;
+    }
+
+    const QJsonObject files = root.value("files").toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it)
+    {
+        const QJsonObject value = it.value().toObject();
+
+        CacheEntry entry;
+        entry.stamp.keysSize = value.value("keysSize").toInteger(-1);
+        entry.stamp.keysModified = value.value("keysModified").toInteger(-1);
+        entry.stamp.addressSize = value.value("addressSize").toInteger(-1);
+        entry.stamp.addressModified = value.value("addressModified").toInteger(-1);
+        entry.networkType = static_cast<quint8>(value.value("networkType").toInt(NetworkType::MAINNET));
+        entry.address = value.value("address").toString();
+        cache.insert(it.key(), entry);
+    }
+
+    return cache;
+}
+
+void WalletKeysFilesModel::saveCache(const QString &moneroAccountsDir, const Cache &cache)
+{
+    QJsonObject files;
+    for (auto it = cache.constBegin(); it != cache.constEnd(); ++it)
+    {
+        QJsonObject value;
+        value.insert("keysSize", it->stamp.keysSize);
+        value.insert("keysModified", it->stamp.keysModified);
+        value.insert("addressSize", it->stamp.addressSize);
+        value.insert("addressModified", it->stamp.addressModified);
+        value.insert("networkType", it->networkType);
+        value.insert("address", it->address);
+        files.insert(it.key(), value);
+    }
+
+    QJsonObject root;
+    root.insert("version", KEYS_FILES_CACHE_VERSION);
+    root.insert("files", files);
+
+    QSaveFile file(cacheFilePath(moneroAccountsDir));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Failed to write keys files cache" << file.fileName();
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+    {
+        qWarning() << "Failed to write keys files cache" << file.fileName();
+    }
 }
 
 void WalletKeysFilesModel::findWallets(const QString &moneroAccountsDir)
@@ -121,12 +545,7 @@ void WalletKeysFilesModel::findWallets(const QString &moneroAccountsDir)
             continue;
         }
 
-        QString wallet(keysFileinfo.path() + QDir::separator() + keysFileinfo.completeBaseName());
-        auto networkTypeAndAddress = OSHelper::getNetworkTypeAndAddressFromFile(wallet);
-        quint8 networkType = networkTypeAndAddress.first;
-        QString address = networkTypeAndAddress.second;
-
-        this->addWalletKeysFile(WalletKeysFiles(QFileInfo(wallet), networkType, std::move(address)));
+        this->addWalletKeysFile(walletKeysFileFromPath(keysFileinfo.filePath()));
     }
 }
 
@@ -135,6 +554,20 @@ void WalletKeysFilesModel::addWalletKeysFile(const WalletKeysFiles &walletKeysFi
     beginInsertRows(QModelIndex(), rowCount(), rowCount());
     m_walletKeyFiles << walletKeysFile;
     endInsertRows();
+    emit countChanged();
+}
+
+void WalletKeysFilesModel::addWalletKeysFiles(const QList<WalletKeysFiles> &walletKeysFiles)
+{
+    if (walletKeysFiles.isEmpty())
+    {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), rowCount(), rowCount() + walletKeysFiles.size() - 1);
+    m_walletKeyFiles << walletKeysFiles;
+    endInsertRows();
+    emit countChanged();
 }
 
 int WalletKeysFilesModel::rowCount(const QModelIndex & parent) const {
@@ -32,6 +32,7 @@
 #include <qqmlcontext.h>
 #include "libwalletqt/WalletManager.h"
 #include "NetworkType.h"
+#include "qt/FutureScheduler.h"
 #include <QtCore>
 
 class WalletKeysFiles
@@ -57,6 +58,8 @@ class WalletKeysFilesModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(QSortFilterProxyModel *proxyModel READ proxyModel NOTIFY proxyModelChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(bool scanning READ scanning NOTIFY scanningChanged)
 
 public:
     enum KeysFilesRoles {
@@ -68,28 +71,86 @@ public:
     };
 
     WalletKeysFilesModel(QObject *parent = 0);
+    ~WalletKeysFilesModel();
 
+    // Scans the directory on a worker thread, rows are inserted as they are parsed.
+    // Afterwards the directory is watched and additions and removals are applied
+    // incrementally until clear() is called.
     Q_INVOKABLE void refresh(const QString &moneroAccountsDir);
     Q_INVOKABLE void clear();
 
     void findWallets(const QString &moneroAccountsDir);
     void addWalletKeysFile(const WalletKeysFiles &walletKeysFile);
+    void addWalletKeysFiles(const QList<WalletKeysFiles> &walletKeysFiles);
+    bool scanning() const;
     int rowCount(const QModelIndex & parent = QModelIndex()) const;
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     QHash<int, QByteArray> roleNames() const;
 
 private:
+    // Identifies the state of the files a cache entry was parsed from
+    struct KeysFileStamp
+    {
+        qint64 keysSize = -1;
+        qint64 keysModified = -1;
+        qint64 addressSize = -1;
+        qint64 addressModified = -1;
+
+        bool operator==(const KeysFileStamp &other) const = default;
+    };
+
+    struct CacheEntry
+    {
+        KeysFileStamp stamp;
+        quint8 networkType;
+        QString address;
+    };
+
+    // keyed by the keys file path relative to the scanned directory
+    using Cache = QHash<QString, CacheEntry>;
+
     QSortFilterProxyModel *proxyModel();
+    static WalletKeysFiles walletKeysFileFromPath(const QString &keysFilePath);
+    static QString walletPathFromKeysFile(const QString &keysFilePath);
+    static KeysFileStamp keysFileStamp(const QString &keysFilePath);
+    static QString cacheFilePath(const QString &moneroAccountsDir);
+    static Cache loadCache(const QString &moneroAccountsDir);
+    static void saveCache(const QString &moneroAccountsDir, const Cache &cache);
+    void scan();
+    void scheduleRescan();
+    void keysFilesFound(quint64 generation, const QStringList &keysFilePaths);
+    void keysFilesParsed(quint64 generation, const QList<WalletKeysFiles> &walletKeysFiles);
+    void scanTaskDone(quint64 generation);
+    void updateWatchedDirectories(const QStringList &directories);
+    void removeMissingWalletKeysFiles();
+    void setScanning(bool scanning);
 
 protected:
 
 signals:
     void proxyModelChanged() const;
+    void countChanged() const;
+    void scanningChanged() const;
 
 private:
     QList<WalletKeysFiles> m_walletKeyFiles;
 
+    // bumped by every scan, results of older scans are dropped
+    quint64 m_scanGeneration;
+    int m_scanPending;
+    bool m_scanning;
+    QSet<QString> m_scanSeen;
+    QString m_moneroAccountsDir;
+
+    Cache m_cache;
+    QString m_cacheDir;
+    bool m_cacheDirty;
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_rescanTimer;
+    FutureScheduler m_scheduler;
+
     QSortFilterProxyModel m_walletKeysFilesModelProxy;
 };
 
@@ -41,6 +41,7 @@
 #include <QMetaProperty>
 
 #include "qt/MoneroSettings.h"
+#include "qt/PerfTrace.h"
 
 /*!
     \qmlmodule moneroSettings 1.0
@@ -92,12 +93,13 @@ void MoneroSettings::load()
         // ensure that a non-existent setting gets written
         // even if the property wouldn't change later
         if (!this->m_settings->contains(property.name()))
-            this->_q_propertyChanged();
+            this->markDirty(i);
 
         // setup change notifications on first load
         if (!this->m_initialized && property.hasNotifySignal()) {
             static const int propertyChangedIndex = mo->indexOfSlot("_q_propertyChanged()");
             int signalIndex = property.notifySignalIndex();
+            this->m_notifyProperties.insert(signalIndex, i);
             QMetaObject::connect(this, signalIndex, this, propertyChangedIndex);
         }
     }
@@ -105,18 +107,15 @@ void MoneroSettings::load()
 
 void MoneroSettings::_q_propertyChanged()
 {
-    // Called on QML property change
-    const QMetaObject *mo = this->metaObject();
-    const int offset = mo->propertyOffset();
-    const int count = mo->propertyCount();
-    for (int i = offset; i < count; ++i) {
-        const QMetaProperty &property = mo->property(i);
-        const QVariant value = readProperty(property);
-        this->m_changedProperties.insert(property.name(), value);
-#ifdef QT_DEBUG
-        //qDebug() << "QQmlSettings: cache" << property.name() << ":" << value;
-#endif
-    }
+    // Called on QML property change, only the property whose notify signal fired is marked
+    const auto property = this->m_notifyProperties.constFind(this->senderSignalIndex());
+    if (property != this->m_notifyProperties.constEnd())
+        this->markDirty(property.value());
+}
+
+void MoneroSettings::markDirty(int propertyIndex)
+{
+    this->m_dirtyProperties.insert(propertyIndex);
 
     if (this->m_timerId != 0)
         this->killTimer(this->m_timerId);
@@ -146,7 +145,7 @@ void MoneroSettings::init()
 
 void MoneroSettings::reset()
 {
-    if (this->m_initialized && this->m_settings && !this->m_changedProperties.isEmpty())
+    if (this->m_initialized && this->m_settings && !this->m_dirtyProperties.isEmpty())
         this->store();
     if (this->m_settings)
         this->m_settings.reset();
@@ -154,24 +153,109 @@ void MoneroSettings::reset()
 
 void MoneroSettings::store()
 {
-    if (!m_writable)
+    if (!m_writable || !this->m_settings)
     {
         return;
     }
 
-    QHash<const char *, QVariant>::const_iterator it = this->m_changedProperties.constBegin();
+    // properties are read here on the GUI thread, the file is written by the writer task
+    Batch batch;
+    batch.target.fileName = this->m_settings->fileName();
+    batch.target.format = this->m_settings->format();
+    batch.target.organizationName = this->m_settings->organizationName();
+    batch.target.applicationName = this->m_settings->applicationName();
 
-    while (it != this->m_changedProperties.constEnd()) {
-        this->m_settings->setValue(it.key(), it.value());
+    const QMetaObject *mo = this->metaObject();
+    for (const int propertyIndex : std::as_const(this->m_dirtyProperties)) {
+        const QMetaProperty property = mo->property(propertyIndex);
+        const QVariant value = readProperty(property);
+        batch.values.insert(QString::fromLatin1(property.name()), value);
 
 #ifdef QT_DEBUG
-            //qDebug() << "QQmlSettings: store" << it.key() << ":" << it.value();
+            //qDebug() << "QQmlSettings: store" << property.name() << ":" << value;
 #endif
+    }
+
+    this->m_dirtyProperties.clear();
+    this->enqueue(std::move(batch));
+}
+
+void MoneroSettings::enqueue(Batch batch)
+{
+    {
+        QMutexLocker locker(&m_writeMutex);
+        if (!m_writeQueue.isEmpty() && m_writeQueue.last().target == batch.target)
+        {
+            m_writeQueue.last().values.insert(batch.values);
+        }
+        else
+        {
+            m_writeQueue.append(std::move(batch));
+        }
+
+        if (m_writerRunning)
+        {
+            return;
+        }
+        m_writerRunning = true;
+    }
 
-        ++it;
+    if (!m_scheduler.run([this] {
+            writePending();
+        }, FutureScheduler::BlockingIO, "MoneroSettings::store").first)
+    {
+        writePending();
+    }
+}
+
+void MoneroSettings::writePending()
+{
+    for (;;)
+    {
+        Batch batch;
+        {
+            QMutexLocker locker(&m_writeMutex);
+            if (m_writeQueue.isEmpty())
+            {
+                m_writerRunning = false;
+                m_writeCondition.wakeAll();
+                return;
+            }
+            batch = m_writeQueue.takeFirst();
+        }
+
+        write(batch);
+    }
+}
+
+void MoneroSettings::write(const Batch &batch)
+{
+    const PerfScope perf("settings write", batch.values.size());
+    // QSettings instances of the same file share their state and are safe to use
+    // from different threads, sync() replaces ini files atomically
+    std::unique_ptr<QSettings> settings(batch.target.format == QSettings::NativeFormat
+        ? new QSettings(batch.target.organizationName, batch.target.applicationName)
+        : new QSettings(batch.target.fileName, batch.target.format));
+
+    for (auto it = batch.values.constBegin(); it != batch.values.constEnd(); ++it)
+    {
+        settings->setValue(it.key(), it.value());
+    }
+
+    settings->sync();
+    if (settings->status() != QSettings::NoError)
+    {
+        qWarning() << "Failed to write settings to" << settings->fileName();
     }
+}
 
-    this->m_changedProperties.clear();
+void MoneroSettings::waitForPendingWrites()
+{
+    QMutexLocker locker(&m_writeMutex);
+    while (m_writerRunning)
+    {
+        m_writeCondition.wait(&m_writeMutex);
+    }
 }
 
 bool MoneroSettings::portable() const
@@ -212,6 +296,9 @@ std::unique_ptr<QSettings> MoneroSettings::unportableSettings() const
 
 void MoneroSettings::swap(std::unique_ptr<QSettings> newSettings)
 {
+    // the previous file may be removed once swapped out
+    this->waitForPendingWrites();
+
     const QMetaObject *mo = this->metaObject();
     const int count = mo->propertyCount();
     for (int offset = mo->propertyOffset(); offset < count; ++offset)
@@ -285,6 +372,13 @@ void MoneroSettings::classBegin()
 }
 
 MoneroSettings::MoneroSettings(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    m_scheduler(this)
+{
+}
+
+MoneroSettings::~MoneroSettings()
 {
+    this->waitForPendingWrites();
+    m_scheduler.shutdownWaitForFinished();
 }
@@ -43,8 +43,16 @@
 #include <QClipboard>
 #include <QObject>
 #include <QDebug>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QVariantMap>
+#include <QWaitCondition>
 #include <qsettings.h>
 
+#include "qt/FutureScheduler.h"
+
 static const int settingsWriteDelay = 500; // ms
 
 class MoneroSettings : public QObject, public QQmlParserStatus
@@ -57,6 +65,7 @@ class MoneroSettings : public QObject, public QQmlParserStatus
 
 public:
     explicit MoneroSettings(QObject *parent = nullptr);
+    ~MoneroSettings();
 
     QString fileName() const;
     void setFileName(const QString &fileName);
@@ -78,11 +87,36 @@ protected:
     void componentComplete() override;
 
 private:
+    // monero-gui-bench stores right away instead of waiting out settingsWriteDelay
+    friend class Benchmarks;
+
+    // Identifies the settings file a batch of values is written to
+    struct Target
+    {
+        QString fileName;
+        QSettings::Format format;
+        QString organizationName;
+        QString applicationName;
+
+        bool operator==(const Target &other) const = default;
+    };
+
+    struct Batch
+    {
+        Target target;
+        QVariantMap values;
+    };
+
     QVariant readProperty(const QMetaProperty &property) const;
+    void markDirty(int propertyIndex);
     void init();
     void reset();
     void load();
     void store();
+    void enqueue(Batch batch);
+    void writePending();
+    void waitForPendingWrites();
+    static void write(const Batch &batch);
 
     bool portable() const;
     static QString portableFilePath();
@@ -90,12 +124,23 @@ private:
     std::unique_ptr<QSettings> unportableSettings() const;
     void swap(std::unique_ptr<QSettings> newSettings);
 
-    QHash<const char *, QVariant> m_changedProperties;
+    // notify signal index -> index of the property it belongs to
+    QHash<int, int> m_notifyProperties;
+    // properties to write on the next store(), values are read at that time
+    QSet<int> m_dirtyProperties;
     std::unique_ptr<QSettings> m_settings;
     QString m_fileName = QString("");
     bool m_initialized = false;
     bool m_writable = true;
     int m_timerId = 0;
+
+    // batches not yet written by the writer task, consecutive stores to the
+    // same file are merged so a burst of changes costs a single sync
+    QList<Batch> m_writeQueue;
+    bool m_writerRunning = false;
+    QMutex m_writeMutex;
+    QWaitCondition m_writeCondition;
+    FutureScheduler m_scheduler;
 };
 
 #endif // MONEROSETTINGS_H
@@ -0,0 +1,260 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "NetworkStats.h"
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace
+{
+
+constexpr size_t LATENCY_SAMPLES = 512;
+constexpr int SESSION_FILE_VERSION = 1;
+
+qint64 percentileUs(std::vector<qint64> samples, double percentile)
+{
+    if (samples.empty())
+    {
+        return 0;
+    }
+    const auto nth = samples.begin() + static_cast<size_t>(percentile * (samples.size() - 1));
+    std::nth_element(samples.begin(), nth, samples.end());
+    return *nth;
+}
+
+} // namespace
+
+NetworkStats::NetworkStats()
+    : QObject(nullptr)
+    , m_requests(0)
+    , m_errors(0)
+    , m_bytesIn(0)
+    , m_bytesOut(0)
+    , m_updatePending(false)
+{
+    // updated() is delivered on the GUI thread whichever thread records first
+    if (QCoreApplication::instance())
+    {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+
+    QFile file(sessionPath());
+    if (file.open(QIODevice::ReadOnly))
+    {
+        const QJsonObject session = QJsonDocument::fromJson(file.readAll()).object();
+        if (session.value("version").toInt() == SESSION_FILE_VERSION)
+        {
+            m_previousSession = session.value("hosts").toArray().toVariantList();
+        }
+    }
+}
+
+NetworkStats *NetworkStats::instance()
+{
+    // never destroyed, requests may still finish on worker threads during shutdown
+    static NetworkStats *stats = new NetworkStats();
+    return stats;
+}
+
+void NetworkStats::record(const QString &host, const char *source, quint64 bytesOut, quint64 bytesIn, Clock::duration latency, int responseCode)
+{
+    const qint64 us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    const bool failed = responseCode == 0 || responseCode >= 400;
+    {
+        QMutexLocker locker(&m_mutex);
+        Host &entry = m_hosts[host];
+        const QString sourceName = QString::fromLatin1(source);
+        if (!entry.sources.contains(sourceName))
+        {
+            entry.sources.append(sourceName);
+        }
+        ++entry.requests;
+        entry.errors += failed;
+        entry.bytesIn += bytesIn;
+        entry.bytesOut += bytesOut;
+        entry.maxUs = std::max(entry.maxUs, us);
+        if (entry.latenciesUs.size() < LATENCY_SAMPLES)
+        {
+            entry.latenciesUs.push_back(us);
+        }
+        else
+        {
+            entry.latenciesUs[entry.next] = us;
+            entry.next = (entry.next + 1) % LATENCY_SAMPLES;
+        }
+
+        ++m_requests;
+        m_errors += failed;
+        m_bytesIn += bytesIn;
+        m_bytesOut += bytesOut;
+    }
+
+    // one pending notification covers a burst of requests
+    if (!m_updatePending.exchange(true))
+    {
+        QMetaObject::invokeMethod(this, [this] {
+            m_updatePending = false;
+            emit updated();
+        }, Qt::QueuedConnection);
+    }
+}
+
+quint64 NetworkStats::requests() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_requests;
+}
+
+quint64 NetworkStats::errors() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_errors;
+}
+
+quint64 NetworkStats::bytesIn() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytesIn;
+}
+
+quint64 NetworkStats::bytesOut() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytesOut;
+}
+
+QVariantList NetworkStats::hosts() const
+{
+    QVariantList result;
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_hosts.constBegin(); it != m_hosts.constEnd(); ++it)
+    {
+        result.append(it.value().toVariant(it.key()));
+    }
+    return result;
+}
+
+QVariantList NetworkStats::previousSession() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_previousSession;
+}
+
+void NetworkStats::reset()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_hosts.clear();
+        m_requests = 0;
+        m_errors = 0;
+        m_bytesIn = 0;
+        m_bytesOut = 0;
+    }
+    emit updated();
+}
+
+void NetworkStats::save() const
+{
+    const QVariantList current = hosts();
+    if (current.isEmpty())
+    {
+        return;
+    }
+
+    const QString path = sessionPath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Failed to write network stats" << file.fileName();
+        return;
+    }
+    const QJsonObject session{
+        {"version", SESSION_FILE_VERSION},
+        {"hosts", QJsonArray::fromVariantList(current)},
+    };
+    file.write(QJsonDocument(session).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+QString NetworkStats::sessionPath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/network-stats.json";
+}
+
+QVariantMap NetworkStats::Host::toVariant(const QString &host) const
+{
+    return QVariantMap{
+        {"host", host},
+        {"sources", sources},
+        {"requests", requests},
+        {"errors", errors},
+        {"errorRate", requests > 0 ? static_cast<double>(errors) / requests : 0.0},
+        {"bytesIn", bytesIn},
+        {"bytesOut", bytesOut},
+        {"p50Ms", percentileUs(latenciesUs, 0.5) / 1000.0},
+        {"p90Ms", percentileUs(latenciesUs, 0.9) / 1000.0},
+        {"p99Ms", percentileUs(latenciesUs, 0.99) / 1000.0},
+        {"maxMs", maxUs / 1000.0},
+    };
+}
+
+NetworkRequestScope::NetworkRequestScope(QString host, const char *source, quint64 bytesOut)
+    : m_host(std::move(host))
+    , m_source(source)
+    , m_bytesOut(bytesOut)
+    , m_bytesIn(0)
+    , m_responseCode(0)
+    , m_started(NetworkStats::Clock::now())
+{
+}
+
+NetworkRequestScope::~NetworkRequestScope()
+{
+    NetworkStats::instance()->record(m_host, m_source, m_bytesOut, m_bytesIn, NetworkStats::Clock::now() - m_started, m_responseCode);
+}
+
+void NetworkRequestScope::received(int responseCode, quint64 bytesIn)
+{
+    m_responseCode = responseCode;
+    m_bytesIn = bytesIn;
+}
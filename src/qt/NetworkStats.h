@@ -0,0 +1,126 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef NETWORKSTATS_H
+#define NETWORKSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariantList>
+
+// Requests, payload bytes, latency and errors per host:port over the session,
+// for Network, Downloader, Updater and the GUI's own daemon RPC calls.
+// The previous session's numbers are kept for comparison.
+class NetworkStats : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(quint64 requests READ requests NOTIFY updated)
+    Q_PROPERTY(quint64 errors READ errors NOTIFY updated)
+    Q_PROPERTY(quint64 bytesIn READ bytesIn NOTIFY updated)
+    Q_PROPERTY(quint64 bytesOut READ bytesOut NOTIFY updated)
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static NetworkStats *instance();
+
+    //! callable from any thread, responseCode 0 means no response
+    void record(const QString &host, const char *source, quint64 bytesOut, quint64 bytesIn, Clock::duration latency, int responseCode);
+
+    quint64 requests() const;
+    quint64 errors() const;
+    quint64 bytesIn() const;
+    quint64 bytesOut() const;
+
+    //! per host: host, sources, requests, errors, errorRate, bytesIn, bytesOut, p50Ms, p90Ms, p99Ms, maxMs
+    Q_INVOKABLE QVariantList hosts() const;
+    Q_INVOKABLE QVariantList previousSession() const;
+    Q_INVOKABLE void reset();
+
+    // the session file is read once on first use and written on exit
+    void save() const;
+
+signals:
+    void updated() const;
+
+private:
+    NetworkStats();
+
+    struct Host
+    {
+        QStringList sources;
+        quint64 requests = 0;
+        quint64 errors = 0;
+        quint64 bytesIn = 0;
+        quint64 bytesOut = 0;
+        qint64 maxUs = 0;
+        // the latest latencies, percentiles follow recent behaviour
+        std::vector<qint64> latenciesUs;
+        size_t next = 0;
+
+        QVariantMap toVariant(const QString &host) const;
+    };
+
+    QString sessionPath() const;
+
+    mutable QMutex m_mutex;
+    QHash<QString, Host> m_hosts;
+    quint64 m_requests;
+    quint64 m_errors;
+    quint64 m_bytesIn;
+    quint64 m_bytesOut;
+    QVariantList m_previousSession;
+    std::atomic<bool> m_updatePending;
+};
+
+// Times one request and records it when it goes out of scope,
+// as failed unless a response was passed to received()
+class NetworkRequestScope
+{
+public:
+    NetworkRequestScope(QString host, const char *source, quint64 bytesOut);
+    ~NetworkRequestScope();
+
+    void received(int responseCode, quint64 bytesIn);
+
+private:
+    QString m_host;
+    const char *m_source;
+    quint64 m_bytesOut;
+    quint64 m_bytesIn;
+    int m_responseCode;
+    NetworkStats::Clock::time_point m_started;
+};
+
+#endif // NETWORKSTATS_H
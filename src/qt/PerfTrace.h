@@ -0,0 +1,83 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef PERFTRACE_H
+#define PERFTRACE_H
+
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+
+// Timings of the hot paths (history sort/filter passes, CSV export, QR codes,
+// signature checks, settings writes), logged when the category is enabled,
+// e.g. QT_LOGGING_RULES="monero.perf.debug=true". Comparing the lines of two
+// builds on the same wallet shows where a regression came in.
+Q_DECLARE_LOGGING_CATEGORY(perfTrace)
+
+//! logs the time until it goes out of scope, a disabled category costs one check
+class PerfScope
+{
+public:
+    //! name must outlive the scope, size is the amount of work (rows, pixels, bytes), -1 for none
+    explicit PerfScope(const char *name, qint64 size = -1)
+        : m_name(name)
+        , m_size(size)
+    {
+        if (perfTrace().isDebugEnabled())
+        {
+            m_timer.start();
+        }
+    }
+
+    ~PerfScope()
+    {
+        if (!m_timer.isValid())
+        {
+            return;
+        }
+        const qint64 us = m_timer.nsecsElapsed() / 1000;
+        if (m_size < 0)
+        {
+            qCDebug(perfTrace).nospace() << m_name << ": " << us << " us";
+        }
+        else
+        {
+            qCDebug(perfTrace).nospace() << m_name << " (" << m_size << "): " << us << " us";
+        }
+    }
+
+    PerfScope(const PerfScope &) = delete;
+    PerfScope &operator=(const PerfScope &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_size;
+    QElapsedTimer m_timer;
+};
+
+#endif // PERFTRACE_H
@@ -0,0 +1,271 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "PerformanceMonitor.h"
+#include "SchedulerStats.h"
+
+#include <algorithm>
+
+#include <QFile>
+#include <QQuickWindow>
+#include <QThreadPool>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+// the GUI thread is late by however much this timer fires late
+constexpr int PROBE_INTERVAL_MS = 100;
+constexpr int SAMPLE_INTERVAL_MS = 1000;
+
+qint64 currentRssKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.WorkingSetSize / 1024;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+    {
+        return 0;
+    }
+    return info.resident_size / 1024;
+#else
+    // size and resident pages
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+    {
+        return 0;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+    {
+        return 0;
+    }
+    return fields[1].toLongLong() * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+}
+
+void updateMax(std::atomic<qint64> &max, qint64 value)
+{
+    qint64 current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+} // namespace
+
+PerformanceMonitor::PerformanceMonitor()
+    : QObject(nullptr)
+    , m_enabled(false)
+    , m_frameStartUs(0)
+    , m_frames(0)
+    , m_frameTotalUs(0)
+    , m_frameMaxUs(0)
+    , m_latencyMaxMs(0)
+    , m_frameTimeMs(0)
+    , m_maxFrameTimeMs(0)
+    , m_framesPerSecond(0)
+    , m_eventLoopLatencyMs(0)
+    , m_poolActive(0)
+    , m_poolMax(0)
+    , m_tasksQueued(0)
+    , m_tasksRunning(0)
+    , m_rssKb(0)
+{
+    m_clock.start();
+    m_probeTimer.setTimerType(Qt::PreciseTimer);
+    m_probeTimer.setInterval(PROBE_INTERVAL_MS);
+    connect(&m_probeTimer, &QTimer::timeout, this, &PerformanceMonitor::probe);
+    m_sampleTimer.setInterval(SAMPLE_INTERVAL_MS);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &PerformanceMonitor::sample);
+}
+
+PerformanceMonitor *PerformanceMonitor::instance()
+{
+    // never destroyed, the render thread may still report a frame during shutdown
+    static PerformanceMonitor *monitor = new PerformanceMonitor();
+    return monitor;
+}
+
+void PerformanceMonitor::setWindow(QQuickWindow *window)
+{
+    if (m_window)
+    {
+        disconnect(m_window, nullptr, this, nullptr);
+    }
+    m_window = window;
+    if (!window)
+    {
+        return;
+    }
+
+    // both run on the render thread, a frame spans sync, render and swap
+    connect(window, &QQuickWindow::beforeSynchronizing, this, [this] {
+        if (m_enabled.load(std::memory_order_relaxed))
+        {
+            m_frameStartUs.store(m_clock.nsecsElapsed() / 1000, std::memory_order_relaxed);
+        }
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this] {
+        const qint64 start = m_frameStartUs.exchange(0, std::memory_order_relaxed);
+        if (start == 0)
+        {
+            return;
+        }
+        const qint64 us = m_clock.nsecsElapsed() / 1000 - start;
+        m_frames.fetch_add(1, std::memory_order_relaxed);
+        m_frameTotalUs.fetch_add(us, std::memory_order_relaxed);
+        updateMax(m_frameMaxUs, us);
+    }, Qt::DirectConnection);
+}
+
+bool PerformanceMonitor::enabled() const
+{
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+void PerformanceMonitor::setEnabled(bool enabled)
+{
+    if (m_enabled.exchange(enabled) == enabled)
+    {
+        return;
+    }
+
+    if (enabled)
+    {
+        m_frames = 0;
+        m_frameTotalUs = 0;
+        m_frameMaxUs = 0;
+        m_latencyMaxMs = 0;
+        m_sinceProbe.start();
+        m_sinceSample.start();
+        m_probeTimer.start();
+        m_sampleTimer.start();
+        sample();
+    }
+    else
+    {
+        m_probeTimer.stop();
+        m_sampleTimer.stop();
+    }
+    emit enabledChanged();
+}
+
+void PerformanceMonitor::probe()
+{
+    m_latencyMaxMs = std::max(m_latencyMaxMs, m_sinceProbe.restart() - PROBE_INTERVAL_MS);
+}
+
+void PerformanceMonitor::sample()
+{
+    const qint64 elapsedMs = std::max<qint64>(1, m_sinceSample.restart());
+    const quint64 frames = m_frames.exchange(0, std::memory_order_relaxed);
+    const qint64 frameTotalUs = m_frameTotalUs.exchange(0, std::memory_order_relaxed);
+    const qint64 frameMaxUs = m_frameMaxUs.exchange(0, std::memory_order_relaxed);
+
+    m_frameTimeMs = frames ? frameTotalUs / 1000.0 / frames : 0;
+    m_maxFrameTimeMs = frameMaxUs / 1000.0;
+    m_framesPerSecond = static_cast<int>(frames * 1000 / elapsedMs);
+    m_eventLoopLatencyMs = m_latencyMaxMs;
+    m_latencyMaxMs = 0;
+
+    m_poolActive = QThreadPool::globalInstance()->activeThreadCount();
+    m_poolMax = QThreadPool::globalInstance()->maxThreadCount();
+    m_tasksQueued = 0;
+    m_tasksRunning = 0;
+    for (const QVariant &lane : SchedulerStats::instance()->lanes())
+    {
+        const QVariantMap depth = lane.toMap();
+        m_tasksQueued += depth.value("queued").toInt();
+        m_tasksRunning += depth.value("running").toInt();
+    }
+    m_rssKb = currentRssKb();
+
+    emit updated();
+}
+
+double PerformanceMonitor::frameTimeMs() const
+{
+    return m_frameTimeMs;
+}
+
+double PerformanceMonitor::maxFrameTimeMs() const
+{
+    return m_maxFrameTimeMs;
+}
+
+int PerformanceMonitor::framesPerSecond() const
+{
+    return m_framesPerSecond;
+}
+
+double PerformanceMonitor::eventLoopLatencyMs() const
+{
+    return m_eventLoopLatencyMs;
+}
+
+int PerformanceMonitor::poolActive() const
+{
+    return m_poolActive;
+}
+
+int PerformanceMonitor::poolMax() const
+{
+    return m_poolMax;
+}
+
+int PerformanceMonitor::tasksQueued() const
+{
+    return m_tasksQueued;
+}
+
+int PerformanceMonitor::tasksRunning() const
+{
+    return m_tasksRunning;
+}
+
+qint64 PerformanceMonitor::rssKb() const
+{
+    return m_rssKb;
+}
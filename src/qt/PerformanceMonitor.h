@@ -0,0 +1,118 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef PERFORMANCEMONITOR_H
+#define PERFORMANCEMONITOR_H
+
+#include <atomic>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class QQuickWindow;
+
+// Live numbers behind the performance overlay: render time, GUI thread
+// latency, worker pool load and memory. Nothing is sampled while disabled.
+class PerformanceMonitor : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(double frameTimeMs READ frameTimeMs NOTIFY updated)
+    Q_PROPERTY(double maxFrameTimeMs READ maxFrameTimeMs NOTIFY updated)
+    Q_PROPERTY(int framesPerSecond READ framesPerSecond NOTIFY updated)
+    Q_PROPERTY(double eventLoopLatencyMs READ eventLoopLatencyMs NOTIFY updated)
+    Q_PROPERTY(int poolActive READ poolActive NOTIFY updated)
+    Q_PROPERTY(int poolMax READ poolMax NOTIFY updated)
+    Q_PROPERTY(int tasksQueued READ tasksQueued NOTIFY updated)
+    Q_PROPERTY(int tasksRunning READ tasksRunning NOTIFY updated)
+    Q_PROPERTY(qint64 rssKb READ rssKb NOTIFY updated)
+
+public:
+    static PerformanceMonitor *instance();
+
+    //! frame timings come from window's render thread
+    void setWindow(QQuickWindow *window);
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    //! averages and maxima over the last sample interval
+    double frameTimeMs() const;
+    double maxFrameTimeMs() const;
+    int framesPerSecond() const;
+    double eventLoopLatencyMs() const;
+    //! QThreadPool::globalInstance()
+    int poolActive() const;
+    int poolMax() const;
+    //! FutureScheduler tasks over all lanes
+    int tasksQueued() const;
+    int tasksRunning() const;
+    qint64 rssKb() const;
+
+signals:
+    void enabledChanged() const;
+    void updated() const;
+
+private:
+    PerformanceMonitor();
+
+    void probe();
+    void sample();
+
+private:
+    QPointer<QQuickWindow> m_window;
+    std::atomic<bool> m_enabled;
+
+    // written on the render thread
+    std::atomic<qint64> m_frameStartUs;
+    std::atomic<quint64> m_frames;
+    std::atomic<qint64> m_frameTotalUs;
+    std::atomic<qint64> m_frameMaxUs;
+    QElapsedTimer m_clock;
+
+    QTimer m_probeTimer;
+    QTimer m_sampleTimer;
+    QElapsedTimer m_sinceProbe;
+    QElapsedTimer m_sinceSample;
+    qint64 m_latencyMaxMs;
+
+    double m_frameTimeMs;
+    double m_maxFrameTimeMs;
+    int m_framesPerSecond;
+    double m_eventLoopLatencyMs;
+    int m_poolActive;
+    int m_poolMax;
+    int m_tasksQueued;
+    int m_tasksRunning;
+    qint64 m_rssKb;
+};
+
+#endif // PERFORMANCEMONITOR_H
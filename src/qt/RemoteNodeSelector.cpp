@@ -0,0 +1,376 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "RemoteNodeSelector.h"
+#include "NetworkStats.h"
+#include "network.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVariantMap>
+
+#include <net/http.h>
+
+namespace
+{
+
+// leaves BlockingIO threads for the wallet refresh loops and downloads
+constexpr int REMOTE_NODE_PROBE_PARALLEL = 4;
+constexpr std::chrono::milliseconds REMOTE_NODE_PROBE_TIMEOUT{5000};
+// headers fetched to estimate the transfer rate, a few tens of KiB
+constexpr quint64 REMOTE_NODE_PROBE_HEADERS = 100;
+// a refresh round moves about this much, weighs latency against transfer rate
+constexpr double REMOTE_NODE_REFERENCE_TRANSFER_BYTES = 1024 * 1024;
+// nodes further behind the best tip are ranked after every fresh node
+constexpr quint64 REMOTE_NODE_MAX_BLOCKS_BEHIND = 2;
+constexpr double REMOTE_NODE_BLOCK_BEHIND_PENALTY_MS = 1000;
+
+struct Candidate
+{
+    QString address;
+    QString username;
+    QString password;
+};
+
+struct Probe
+{
+    bool ok = false;
+    QString error;
+    qint64 connectTime = 0;
+    qint64 latency = 0;
+    quint64 height = 0;
+    bool synchronized = false;
+    double throughput = 0;
+};
+
+const char *nettypeName(NetworkType::Type nettype)
+{
+    switch (nettype)
+    {
+    case NetworkType::TESTNET:
+        return "testnet";
+    case NetworkType::STAGENET:
+        return "stagenet";
+    default:
+        return "mainnet";
+    }
+}
+
+QJsonObject jsonRpc(
+    HttpClient &client,
+    const CancellationToken &token,
+    const QString &address,
+    const char *method,
+    const QJsonObject &params,
+    std::string &response)
+{
+    if (token.cancelled())
+    {
+        throw std::runtime_error("cancelled");
+    }
+
+    const QJsonObject request{
+        {"jsonrpc", "2.0"},
+        {"id", "0"},
+        {"method", method},
+        {"params", params},
+    };
+    const std::string body = QJsonDocument(request).toJson(QJsonDocument::Compact).toStdString();
+    const epee::net_utils::http::http_response_info *info = nullptr;
+    const epee::net_utils::http::fields_list headers({{"Content-Type", "application/json"}});
+    NetworkRequestScope stats(address, "node-probe", body.size());
+    if (!client.invoke("/json_rpc", "POST", body, REMOTE_NODE_PROBE_TIMEOUT, std::addressof(info), headers) || info == nullptr)
+    {
+        throw std::runtime_error("no response");
+    }
+    stats.received(info->m_response_code, info->m_body.size());
+    if (info->m_response_code != 200)
+    {
+        throw std::runtime_error(QString("HTTP status %1").arg(info->m_response_code).toStdString());
+    }
+
+    response = info->m_body;
+    const QJsonObject result = QJsonDocument::fromJson(QByteArray::fromStdString(response)).object().value("result").toObject();
+    if (result.value("status").toString() != "OK")
+    {
+        throw std::runtime_error(QString("%1 failed").arg(method).toStdString());
+    }
+    return result;
+}
+
+// a cancelled token aborts the request in flight once data arrives and skips the rest
+Probe probeNode(const Candidate &candidate, const QString &proxyAddress, NetworkType::Type nettype, const CancellationToken &token)
+{
+    Probe probe;
+    try
+    {
+        const auto client = std::make_shared<HttpClient>();
+        token.onCancelled([client] {
+            client->cancel();
+        });
+        // same rule as the wallet connection, local nodes go direct
+        if (!isLocalAddress(candidate.address) && !client->set_proxy(proxyAddress.toStdString()))
+        {
+            throw std::runtime_error("failed to set proxy address");
+        }
+
+        boost::optional<epee::net_utils::http::login> login;
+        if (!candidate.username.isEmpty())
+        {
+            login.emplace(candidate.username.toStdString(), candidate.password.toStdString());
+        }
+        if (!client->set_server(candidate.address.toStdString(), login))
+        {
+            throw std::runtime_error("invalid address");
+        }
+
+        std::string response;
+        QElapsedTimer timer;
+        timer.start();
+        jsonRpc(*client, token, candidate.address, "get_info", {}, response);
+        probe.connectTime = timer.restart();
+
+        // the second request reuses the connection, that's the latency a refresh sees
+        const QJsonObject info = jsonRpc(*client, token, candidate.address, "get_info", {}, response);
+        probe.latency = std::max<qint64>(timer.restart(), 1);
+
+        if (info.value("nettype").toString() != nettypeName(nettype))
+        {
+            throw std::runtime_error(QString("node is on %1").arg(info.value("nettype").toString()).toStdString());
+        }
+        probe.height = static_cast<quint64>(info.value("height").toDouble());
+        probe.synchronized = info.value("synchronized").toBool() && !info.value("busy_syncing").toBool();
+        if (probe.height < 2)
+        {
+            throw std::runtime_error("node has no blocks");
+        }
+
+        const quint64 endHeight = probe.height - 1;
+        const quint64 startHeight = endHeight - std::min(endHeight, REMOTE_NODE_PROBE_HEADERS - 1);
+        timer.restart();
+        jsonRpc(*client, token, candidate.address, "get_block_headers_range", {
+            {"start_height", static_cast<qint64>(startHeight)},
+            {"end_height", static_cast<qint64>(endHeight)},
+        }, response);
+        probe.throughput = response.size() * 1000.0 / std::max<qint64>(timer.elapsed(), 1);
+        probe.ok = true;
+    }
+    catch (const std::exception &e)
+    {
+        probe.error = e.what();
+    }
+    return probe;
+}
+
+} // namespace
+
+struct RemoteNodeSelector::Round
+{
+    std::vector<Candidate> candidates;
+    std::vector<Probe> probes;
+    QString proxyAddress;
+    NetworkType::Type nettype;
+    std::atomic<size_t> next{0};
+    std::atomic<int> workers{0};
+    CancellationToken token;
+};
+
+RemoteNodeSelector::RemoteNodeSelector(QObject *parent /* = nullptr */)
+    : QObject(parent)
+    , m_scheduler(this)
+{
+}
+
+RemoteNodeSelector::~RemoteNodeSelector()
+{
+    cancel();
+    m_scheduler.shutdownWaitForFinished();
+}
+
+void RemoteNodeSelector::rank(const QVariantList &nodes, NetworkType::Type nettype)
+{
+    cancel();
+
+    auto round = std::make_shared<Round>();
+    for (const QVariant &node : nodes)
+    {
+        const QVariantMap fields = node.toMap();
+        round->candidates.push_back({
+            fields.value("address").toString(),
+            fields.value("username").toString(),
+            fields.value("password").toString(),
+        });
+    }
+    round->probes.resize(round->candidates.size());
+    round->proxyAddress = m_proxyAddress;
+    round->nettype = nettype;
+
+    m_round = round;
+    emit probingChanged();
+
+    // every worker takes the next unprobed node, the last one to run out publishes the ranking
+    const int workers = std::max(std::min<int>(REMOTE_NODE_PROBE_PARALLEL, round->candidates.size()), 1);
+    round->workers = workers;
+    for (int worker = 0; worker < workers; ++worker)
+    {
+        const auto future = m_scheduler.run([this, round] {
+            while (!round->token.cancelled())
+            {
+                const size_t index = round->next++;
+                if (index >= round->candidates.size())
+                {
+                    break;
+                }
+                round->probes[index] = probeNode(round->candidates[index], round->proxyAddress, round->nettype, round->token);
+            }
+            if (--round->workers == 0)
+            {
+                QMetaObject::invokeMethod(this, [this, round] {
+                    finish(round);
+                }, Qt::QueuedConnection);
+            }
+        }, FutureScheduler::BlockingIO, "RemoteNodeSelector::rank");
+        if (!future.first)
+        {
+            qWarning() << "failed to schedule remote node probe";
+            if (--round->workers == 0)
+            {
+                finish(round);
+            }
+        }
+    }
+}
+
+void RemoteNodeSelector::cancel()
+{
+    if (!m_round)
+    {
+        return;
+    }
+
+    // aborts the probes in flight, the destructor doesn't wait out their timeouts
+    m_round->token.cancel();
+    m_round.reset();
+    emit probingChanged();
+}
+
+bool RemoteNodeSelector::probing() const
+{
+    return m_round != nullptr;
+}
+
+void RemoteNodeSelector::finish(const std::shared_ptr<Round> &round)
+{
+    if (round != m_round)
+    {
+        return;
+    }
+    m_round.reset();
+
+    quint64 bestHeight = 0;
+    for (const Probe &probe : round->probes)
+    {
+        if (probe.ok)
+        {
+            bestHeight = std::max(bestHeight, probe.height);
+        }
+    }
+
+    struct Ranked
+    {
+        size_t index;
+        bool fresh;
+        double score;
+    };
+    std::vector<Ranked> ranked;
+    ranked.reserve(round->probes.size());
+    for (size_t index = 0; index < round->probes.size(); ++index)
+    {
+        const Probe &probe = round->probes[index];
+        if (!probe.ok)
+        {
+            ranked.push_back({index, false, std::numeric_limits<double>::infinity()});
+            continue;
+        }
+        const quint64 behind = bestHeight - probe.height;
+        ranked.push_back({
+            index,
+            probe.synchronized && behind <= REMOTE_NODE_MAX_BLOCKS_BEHIND,
+            probe.latency
+                + REMOTE_NODE_REFERENCE_TRANSFER_BYTES * 1000.0 / probe.throughput
+                + behind * REMOTE_NODE_BLOCK_BEHIND_PENALTY_MS,
+        });
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const Ranked &lhs, const Ranked &rhs) {
+        if (lhs.fresh != rhs.fresh)
+        {
+            return lhs.fresh;
+        }
+        return lhs.score < rhs.score;
+    });
+
+    QVariantList nodes;
+    nodes.reserve(ranked.size());
+    for (const Ranked &entry : ranked)
+    {
+        const Probe &probe = round->probes[entry.index];
+        nodes.push_back(QVariantMap{
+            {"index", static_cast<int>(entry.index)},
+            {"address", round->candidates[entry.index].address},
+            {"ok", probe.ok},
+            {"error", probe.error},
+            {"connectTime", probe.connectTime},
+            {"latency", probe.latency},
+            {"height", probe.height},
+            {"blocksBehind", probe.ok ? bestHeight - probe.height : 0},
+            {"synchronized", probe.synchronized},
+            {"throughput", probe.throughput},
+            {"score", probe.ok ? entry.score : -1},
+        });
+        qDebug() << "remote node" << round->candidates[entry.index].address
+                 << (probe.ok ? QString("latency %1 ms, %2 KiB/s, %3 blocks behind")
+                                    .arg(probe.latency)
+                                    .arg(probe.throughput / 1024, 0, 'f', 1)
+                                    .arg(bestHeight - probe.height)
+                              : probe.error);
+    }
+
+    emit probingChanged();
+    emit rankingFinished(nodes);
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef REMOTENODESELECTOR_H
+#define REMOTENODESELECTOR_H
+
+#include <memory>
+
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+
+#include "FutureScheduler.h"
+#include "NetworkType.h"
+
+// Probes remote nodes in parallel over the configured proxy and ranks them
+// by RPC latency, transfer rate and how far behind the chain tip they are.
+class RemoteNodeSelector : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString proxyAddress MEMBER m_proxyAddress NOTIFY proxyAddressChanged)
+    Q_PROPERTY(bool probing READ probing NOTIFY probingChanged)
+
+public:
+    explicit RemoteNodeSelector(QObject *parent = nullptr);
+    ~RemoteNodeSelector();
+
+    //! nodes are {address, username, password} maps, a new call supersedes a running one
+    Q_INVOKABLE void rank(const QVariantList &nodes, NetworkType::Type nettype);
+    Q_INVOKABLE void cancel();
+
+    bool probing() const;
+
+signals:
+    void proxyAddressChanged() const;
+    void probingChanged() const;
+    //! best first: {index, address, ok, error, connectTime, latency, height,
+    //! blocksBehind, synchronized, throughput, score}, times in ms, throughput in bytes/s
+    void rankingFinished(const QVariantList &nodes) const;
+
+private:
+    struct Round;
+    void finish(const std::shared_ptr<Round> &round);
+
+private:
+    QString m_proxyAddress;
+    std::shared_ptr<Round> m_round;
+    FutureScheduler m_scheduler;
+};
+
+#endif // REMOTENODESELECTOR_H
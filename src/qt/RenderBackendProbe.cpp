@@ -0,0 +1,306 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "RenderBackendProbe.h"
+
+#include <cmath>
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QtGlobal>
+
+#if QT_CONFIG(opengl)
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#endif
+
+namespace
+{
+
+constexpr int CACHE_VERSION = 2;
+constexpr int PROBE_SIZE = 512;
+constexpr int PROBE_LAYERS = 16;
+constexpr int PROBE_WARMUP_FRAMES = 2;
+constexpr int PROBE_FRAMES = 20;
+constexpr float PROBE_ALPHA = 0.25f;
+// a GPU blends the probe frame in well under a millisecond, a rasterizer
+// that needs longer redraws the UI slower than the software backend repaints it
+constexpr double MAX_FRAME_MS = 4.0;
+// one slow probe may have raced a busy machine, it is repeated after as many starts
+constexpr int SLOW_VERDICT_STARTS = 5;
+
+const char SOFTWARE_RENDERERS[][32] = {
+    "llvmpipe",
+    "softpipe",
+    "swrast",
+    "SwiftShader",
+    "GDI Generic",
+    "Microsoft Basic Render Driver",
+};
+
+const char VERTEX_SHADER[] =
+    "attribute vec2 position;\n"
+    "void main() { gl_Position = vec4(position, 0.0, 1.0); }\n";
+const char FRAGMENT_SHADER[] =
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform vec4 color;\n"
+    "void main() { gl_FragColor = color; }\n";
+
+const char *backendName(RenderBackendProbe::Backend backend)
+{
+    return backend == RenderBackendProbe::Software ? "software" : "hardware";
+}
+
+bool isSoftwareRenderer(const QString &renderer)
+{
+    for (const char *name : SOFTWARE_RENDERERS)
+    {
+        if (renderer.contains(QLatin1String(name), Qt::CaseInsensitive))
+            return true;
+    }
+    return false;
+}
+
+#if QT_CONFIG(opengl)
+
+GLuint compileShader(QOpenGLFunctions *gl, GLenum type, const char *source)
+{
+    const GLuint shader = gl->glCreateShader(type);
+    gl->glShaderSource(shader, 1, &source, nullptr);
+    gl->glCompileShader(shader);
+    GLint compiled = GL_FALSE;
+    gl->glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE)
+    {
+        gl->glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// blends layers of translucent quads over a texture the size of a small
+// window, false if the driver can't or renders them wrong
+bool timeRender(QOpenGLContext &context, double &frameMs)
+{
+    QOpenGLFunctions *gl = context.functions();
+
+    GLuint texture = 0;
+    gl->glGenTextures(1, &texture);
+    gl->glBindTexture(GL_TEXTURE_2D, texture);
+    gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PROBE_SIZE, PROBE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    GLuint framebuffer = 0;
+    gl->glGenFramebuffers(1, &framebuffer);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    const GLuint vertexShader = compileShader(gl, GL_VERTEX_SHADER, VERTEX_SHADER);
+    const GLuint fragmentShader = compileShader(gl, GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    const GLuint program = gl->glCreateProgram();
+    GLint linked = GL_FALSE;
+    if (vertexShader && fragmentShader)
+    {
+        gl->glAttachShader(program, vertexShader);
+        gl->glAttachShader(program, fragmentShader);
+        gl->glBindAttribLocation(program, 0, "position");
+        gl->glLinkProgram(program);
+        gl->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+
+    bool rendered = false;
+    if (linked == GL_TRUE && gl->glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+    {
+        static const GLfloat quad[] = {-1, -1, 1, -1, -1, 1, 1, 1};
+        gl->glViewport(0, 0, PROBE_SIZE, PROBE_SIZE);
+        gl->glUseProgram(program);
+        gl->glUniform4f(gl->glGetUniformLocation(program, "color"), 1, 1, 1, PROBE_ALPHA);
+        gl->glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, quad);
+        gl->glEnableVertexAttribArray(0);
+        gl->glEnable(GL_BLEND);
+        gl->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        const auto frame = [gl] {
+            gl->glClearColor(0, 0, 0, 1);
+            gl->glClear(GL_COLOR_BUFFER_BIT);
+            for (int layer = 0; layer < PROBE_LAYERS; ++layer)
+                gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        };
+        // the first frames pay for the driver's lazy initialization
+        for (int i = 0; i < PROBE_WARMUP_FRAMES; ++i)
+            frame();
+        gl->glFinish();
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < PROBE_FRAMES; ++i)
+            frame();
+        gl->glFinish();
+        frameMs = timer.nsecsElapsed() / 1e6 / PROBE_FRAMES;
+
+        GLubyte pixel[4] = {};
+        gl->glReadPixels(PROBE_SIZE / 2, PROBE_SIZE / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        const double expected = 255 * (1 - std::pow(1 - PROBE_ALPHA, PROBE_LAYERS));
+        rendered = gl->glGetError() == GL_NO_ERROR && std::abs(pixel[0] - expected) < 8 && std::abs(pixel[2] - expected) < 8;
+
+        gl->glDisableVertexAttribArray(0);
+        gl->glUseProgram(0);
+    }
+
+    gl->glDeleteProgram(program);
+    gl->glDeleteShader(vertexShader);
+    gl->glDeleteShader(fragmentShader);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, context.defaultFramebufferObject());
+    gl->glDeleteFramebuffers(1, &framebuffer);
+    gl->glDeleteTextures(1, &texture);
+    return rendered;
+}
+
+#endif
+
+QJsonObject readCache(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    const QJsonObject cache = QJsonDocument::fromJson(file.readAll()).object();
+    if (cache.value("version").toInt() != CACHE_VERSION)
+        return {};
+    return cache;
+}
+
+void writeCache(const QString &path, const QJsonObject &cache)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Failed to write render backend cache" << file.fileName();
+        return;
+    }
+    QJsonObject versioned = cache;
+    versioned.insert("version", CACHE_VERSION);
+    file.write(QJsonDocument(versioned).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+} // namespace
+
+RenderBackendProbe::Result RenderBackendProbe::choose()
+{
+    Result result;
+
+    // start-low-graphics-mode.bat and users picking a backend by hand
+    if (!qEnvironmentVariableIsEmpty("QMLSCENE_DEVICE") || !qEnvironmentVariableIsEmpty("QT_QUICK_BACKEND"))
+    {
+        const bool software = qgetenv("QMLSCENE_DEVICE") == "softwarecontext" || qgetenv("QT_QUICK_BACKEND") == "software";
+        result.backend = software ? Software : Hardware;
+        return result;
+    }
+
+#if QT_CONFIG(opengl)
+    QOpenGLContext context;
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (context.create() && context.format().version() >= qMakePair(2, 1) && context.makeCurrent(&surface))
+    {
+        QOpenGLFunctions *gl = context.functions();
+        result.renderer = QString::fromLatin1(reinterpret_cast<const char *>(gl->glGetString(GL_RENDERER))) + ' ' +
+            QString::fromLatin1(reinterpret_cast<const char *>(gl->glGetString(GL_VERSION)));
+    }
+
+    // no usable OpenGL, as before the probe
+    if (result.renderer.isEmpty())
+    {
+        result.backend = Software;
+    }
+    else
+    {
+        const QString path = cachePath();
+        const QJsonObject cache = readCache(path);
+        const bool slowVerdict = cache.value("startsLeft").toInt() > 0;
+        const int startsLeft = cache.value("startsLeft").toInt() - 1;
+        // failures and fast renders are kept for the renderer, slow ones for a few starts
+        int slowStartsLeft = 0;
+        if (cache.value("renderer").toString() == result.renderer && (!slowVerdict || startsLeft > 0))
+        {
+            result.cached = true;
+            result.frameMs = cache.value("frameMs").toDouble();
+            // a probe that never finished took the process down with it
+            result.backend = cache.value("probing").toBool() || cache.value("backend").toString() == backendName(Software) ? Software : Hardware;
+            slowStartsLeft = slowVerdict ? startsLeft : 0;
+        }
+        else if (isSoftwareRenderer(result.renderer))
+        {
+            result.backend = Software;
+        }
+        else
+        {
+            writeCache(path, {{"renderer", result.renderer}, {"probing", true}});
+            const bool rendered = timeRender(context, result.frameMs);
+            result.backend = rendered && result.frameMs <= MAX_FRAME_MS ? Hardware : Software;
+            slowStartsLeft = rendered && result.frameMs > MAX_FRAME_MS ? SLOW_VERDICT_STARTS : 0;
+        }
+
+        if (!result.cached || cache.value("probing").toBool() || slowStartsLeft > 0)
+        {
+            writeCache(path, {
+                {"renderer", result.renderer},
+                {"backend", backendName(result.backend)},
+                {"frameMs", result.frameMs},
+                {"startsLeft", slowStartsLeft},
+            });
+        }
+        context.doneCurrent();
+    }
+#endif
+
+    if (result.backend == Software)
+        qputenv("QMLSCENE_DEVICE", "softwarecontext");
+
+    qInfo().noquote() << "Render backend:" << backendName(result.backend)
+                      << (result.cached ? "(cached)" : "")
+                      << result.renderer << result.frameMs << "ms per probe frame";
+    return result;
+}
+
+QString RenderBackendProbe::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/render-backend.json";
+}
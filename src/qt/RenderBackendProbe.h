@@ -0,0 +1,66 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef RENDERBACKENDPROBE_H
+#define RENDERBACKENDPROBE_H
+
+#include <QString>
+
+// Picks the Qt Quick backend at startup, replacing the manual low graphics
+// launcher. A tiny offscreen OpenGL render is timed once per machine and
+// renderer, the decision is cached next to the other application data.
+// Failed renders and known software rasterizers are final, a render that was
+// only too slow is probed again after a few starts.
+class RenderBackendProbe
+{
+public:
+    enum Backend {
+        Hardware,
+        Software,
+    };
+
+    struct Result
+    {
+        Backend backend = Hardware;
+        //! GL_RENDERER and GL_VERSION, empty without a usable OpenGL context
+        QString renderer;
+        //! per probe frame, 0 if the probe didn't run
+        double frameMs = 0;
+        bool cached = false;
+    };
+
+    //! needs the QGuiApplication and its name, runs before the first QQuickWindow;
+    //! a backend forced through the environment is left alone
+    static Result choose();
+
+private:
+    static QString cachePath();
+};
+
+#endif // RENDERBACKENDPROBE_H
@@ -0,0 +1,212 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "SchedulerStats.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace
+{
+
+const char *laneName(int lane)
+{
+    static const char *names[SchedulerStats::laneCount] = {"interactive", "background", "blocking-io"};
+    return lane >= 0 && lane < SchedulerStats::laneCount ? names[lane] : "unknown";
+}
+
+qint64 elapsedUs(SchedulerStats::Clock::time_point from, SchedulerStats::Clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+} // namespace
+
+SchedulerStats::SchedulerStats()
+    : QObject(nullptr)
+    , m_enabled(false)
+{
+}
+
+SchedulerStats *SchedulerStats::instance()
+{
+    // never destroyed, scheduler threads may still report during shutdown
+    static SchedulerStats *stats = new SchedulerStats();
+    return stats;
+}
+
+bool SchedulerStats::enabled() const
+{
+    return m_enabled;
+}
+
+void SchedulerStats::setEnabled(bool enabled)
+{
+    if (m_enabled.exchange(enabled) != enabled)
+    {
+        emit enabledChanged();
+    }
+}
+
+SchedulerStats::Clock::time_point SchedulerStats::taskQueued(int lane)
+{
+    LaneDepth &depth = m_lanes[lane];
+    const int queued = ++depth.queued;
+    int maxQueued = depth.maxQueued;
+    while (queued > maxQueued && !depth.maxQueued.compare_exchange_weak(maxQueued, queued))
+    {
+    }
+
+    return m_enabled ? Clock::now() : Clock::time_point();
+}
+
+SchedulerStats::Clock::time_point SchedulerStats::taskStarted(int lane)
+{
+    --m_lanes[lane].queued;
+    ++m_lanes[lane].running;
+
+    return m_enabled ? Clock::now() : Clock::time_point();
+}
+
+void SchedulerStats::taskFinished(int lane, const char *tag, Clock::time_point queued, Clock::time_point started)
+{
+    --m_lanes[lane].running;
+
+    // enabled while the task was waiting in the queue, no meaningful timings
+    if (!m_enabled || queued == Clock::time_point())
+    {
+        return;
+    }
+
+    const Clock::time_point finished = Clock::now();
+    const QByteArray key = tag ? QByteArray(tag) : QByteArray("untagged");
+
+    QMutexLocker locker(&m_mutex);
+    Entry &entry = m_entries[key];
+    entry.lane = lane;
+    entry.wait.add(elapsedUs(queued, started));
+    entry.run.add(elapsedUs(started, finished));
+}
+
+QVariantList SchedulerStats::tasks() const
+{
+    QVariantList result;
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+    {
+        result.append(QVariantMap{
+            {"tag", QString::fromUtf8(it.key())},
+            {"lane", QString::fromLatin1(laneName(it.value().lane))},
+            {"count", it.value().run.count},
+            {"wait", it.value().wait.toVariant()},
+            {"run", it.value().run.toVariant()},
+        });
+    }
+
+    return result;
+}
+
+QVariantList SchedulerStats::lanes() const
+{
+    QVariantList result;
+    for (int lane = 0; lane < laneCount; ++lane)
+    {
+        result.append(QVariantMap{
+            {"lane", QString::fromLatin1(laneName(lane))},
+            {"queued", m_lanes[lane].queued.load()},
+            {"running", m_lanes[lane].running.load()},
+            {"maxQueued", m_lanes[lane].maxQueued.load()},
+        });
+    }
+    return result;
+}
+
+void SchedulerStats::reset()
+{
+    for (LaneDepth &depth : m_lanes)
+    {
+        depth.maxQueued = depth.queued.load();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+}
+
+void SchedulerStats::dump() const
+{
+    for (int lane = 0; lane < laneCount; ++lane)
+    {
+        qInfo().noquote() << "Scheduler lane" << laneName(lane)
+                          << "queued" << m_lanes[lane].queued.load()
+                          << "running" << m_lanes[lane].running.load()
+                          << "max queued" << m_lanes[lane].maxQueued.load();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    QList<QByteArray> tags = m_entries.keys();
+    std::sort(tags.begin(), tags.end(), [this](const QByteArray &left, const QByteArray &right) {
+        return m_entries.constFind(left)->run.totalUs > m_entries.constFind(right)->run.totalUs;
+    });
+    for (const QByteArray &tag : tags)
+    {
+        const Entry &entry = *m_entries.constFind(tag);
+        qInfo().noquote() << "Scheduler task" << tag << laneName(entry.lane)
+                          << "count" << entry.run.count
+                          << "wait avg/max ms" << entry.wait.totalUs / 1000.0 / entry.wait.count << entry.wait.maxUs / 1000.0
+                          << "run avg/max ms" << entry.run.totalUs / 1000.0 / entry.run.count << entry.run.maxUs / 1000.0;
+    }
+}
+
+void SchedulerStats::Histogram::add(qint64 us)
+{
+    ++count;
+    totalUs += us;
+    maxUs = std::max(maxUs, us);
+
+    const auto bound = std::upper_bound(bucketBounds.begin(), bucketBounds.end(), us / 1000);
+    ++buckets[std::distance(bucketBounds.begin(), bound)];
+}
+
+QVariantMap SchedulerStats::Histogram::toVariant() const
+{
+    QVariantList histogram;
+    for (quint64 bucket : buckets)
+    {
+        histogram.append(bucket);
+    }
+
+    return QVariantMap{
+        {"totalMs", totalUs / 1000.0},
+        {"avgMs", count > 0 ? totalUs / 1000.0 / count : 0.0},
+        {"maxMs", maxUs / 1000.0},
+        {"histogram", histogram},
+    };
+}
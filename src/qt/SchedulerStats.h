@@ -0,0 +1,110 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SCHEDULERSTATS_H
+#define SCHEDULERSTATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QVariantList>
+
+// Aggregated FutureScheduler timings. Queue depth per lane is always tracked,
+// wait and run times per call site only while enabled.
+class SchedulerStats : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // upper bounds of the histogram buckets in milliseconds, the last bucket is open
+    static constexpr std::array<int, 8> bucketBounds{{1, 4, 16, 64, 256, 1000, 4000, 16000}};
+    static constexpr int bucketCount = static_cast<int>(bucketBounds.size()) + 1;
+    static constexpr int laneCount = 3;
+
+    static SchedulerStats *instance();
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    //! per call site: tag, lane, count, wait/run totals, maxima and histograms (ms)
+    Q_INVOKABLE QVariantList tasks() const;
+    //! per lane: queued, running, maxQueued
+    Q_INVOKABLE QVariantList lanes() const;
+    Q_INVOKABLE void reset();
+    Q_INVOKABLE void dump() const;
+
+    // FutureScheduler hooks, callable from any thread
+    Clock::time_point taskQueued(int lane);
+    Clock::time_point taskStarted(int lane);
+    void taskFinished(int lane, const char *tag, Clock::time_point queued, Clock::time_point started);
+
+signals:
+    void enabledChanged() const;
+
+private:
+    SchedulerStats();
+
+    struct Histogram
+    {
+        quint64 count = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+        std::array<quint64, bucketCount> buckets{};
+
+        void add(qint64 us);
+        QVariantMap toVariant() const;
+    };
+
+    struct Entry
+    {
+        int lane = 0;
+        Histogram wait;
+        Histogram run;
+    };
+
+    struct LaneDepth
+    {
+        std::atomic<int> queued{0};
+        std::atomic<int> running{0};
+        std::atomic<int> maxQueued{0};
+    };
+
+    std::atomic<bool> m_enabled;
+    LaneDepth m_lanes[laneCount];
+    mutable QMutex m_mutex;
+    QHash<QByteArray, Entry> m_entries;
+};
+
+#endif // SCHEDULERSTATS_H
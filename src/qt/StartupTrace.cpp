@@ -0,0 +1,85 @@
+// Copyright (c) 2014-2024, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "StartupTrace.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+StartupTrace::StartupTrace()
+    : QObject(nullptr)
+{
+    m_timer.start();
+}
+
+StartupTrace *StartupTrace::instance()
+{
+    // never destroyed, like SchedulerStats
+    static StartupTrace *trace = new StartupTrace();
+    return trace;
+}
+
+void StartupTrace::mark(const QString &phase)
+{
+    const qint64 atUs = m_timer.nsecsElapsed() / 1000;
+
+    QMutexLocker locker(&m_mutex);
+    m_marks.append(Mark{phase, atUs});
+}
+
+QVariantList StartupTrace::phases() const
+{
+    QVariantList result;
+
+    QMutexLocker locker(&m_mutex);
+    qint64 previousUs = 0;
+    for (const Mark &mark : m_marks)
+    {
+        result.append(QVariantMap{
+            {"phase", mark.phase},
+            {"at", mark.atUs / 1000.0},
+            {"duration", (mark.atUs - previousUs) / 1000.0},
+        });
+        previousUs = mark.atUs;
+    }
+
+    return result;
+}
+
+void StartupTrace::dump() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 previousUs = 0;
+    for (const Mark &mark : m_marks)
+    {
+        qInfo().noquote() << "Startup" << mark.phase
+                          << "at ms" << mark.atUs / 1000.0
+                          << "took ms" << (mark.atUs - previousUs) / 1000.0;
+        previousUs = mark.atUs;
+    }
+}
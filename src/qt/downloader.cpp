@@ -28,14 +28,46 @@
 
 #include "downloader.h"
 
+#include <chrono>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
 #include <QReadLocker>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUrl>
 #include <QWriteLocker>
 
-#include "updater.h"
+#include "DeltaPatch.h"
+#include "ScopeGuard.h"
 
 namespace
 {
 
+// consecutive interrupted attempts without any progress
+constexpr int DOWNLOAD_MAX_STALLED_ATTEMPTS = 5;
+constexpr unsigned long DOWNLOAD_RETRY_DELAY_MS = 1000;
+// hex digits of the base bundle hash in a delta's file name
+constexpr int DELTA_BASE_HASH_PREFIX = 16;
+// a delta is kept in memory, anything this large isn't worth it over the full bundle
+constexpr quint64 DELTA_MAX_SIZE = 64 * 1024 * 1024;
+
+void truncate(QIODevice &device)
+{
+    device.seek(0);
+    if (QFileDevice *file = qobject_cast<QFileDevice *>(&device))
+    {
+        file->resize(0);
+    }
+    else if (QBuffer *buffer = qobject_cast<QBuffer *>(&device))
+    {
+        buffer->buffer().clear();
+    }
+}
+
 class DownloaderStateGuard
 {
 public:
@@ -92,26 +124,38 @@ private:
 Downloader::Downloader(QObject *parent)
     : QObject(parent)
     , m_active(false)
+    , m_cancelled(false)
     , m_httpClient(new HttpClient())
     , m_network(this)
     , m_scheduler(this)
 {
+    m_network.setStatsSource("downloader");
+
     QObject::connect(m_httpClient.get(), SIGNAL(contentLengthChanged()), this, SIGNAL(totalChanged()));
     QObject::connect(m_httpClient.get(), SIGNAL(receivedChanged()), this, SIGNAL(loadedChanged()));
+
+    // a transfer in flight is aborted rather than waited for on shutdown
+    std::shared_ptr<HttpClient> httpClient = m_httpClient;
+    m_scheduler.token().onCancelled([this, httpClient]() {
+        m_cancelled = true;
+        httpClient->cancel();
+    });
 }
 
 Downloader::~Downloader()
 {
     cancel();
+    m_scheduler.shutdownWaitForFinished();
 }
 
 void Downloader::cancel()
 {
+    m_cancelled = true;
     m_httpClient->cancel();
 
     QWriteLocker locker(&m_mutex);
 
-    m_contents.clear();
+    m_file.reset();
 }
 
 bool Downloader::get(const QString &url, const QString &hash, const QJSValue &callback)
@@ -129,79 +173,241 @@ bool Downloader::get(const QString &url, const QString &hash, const QJSValue &ca
             {
                 QWriteLocker locker(&m_mutex);
 
-                m_contents.clear();
+                m_file.reset();
             }
+            m_cancelled = false;
 
-            std::string response;
+            const QByteArray expectedHash = QByteArray::fromHex(hash.toUtf8());
+            std::unique_ptr<QTemporaryFile> file = patchCachedBundle(url, expectedHash);
+            if (!file && !m_cancelled)
             {
-                QString error;
-                auto task = m_scheduler.run([this, &error, &response, &url] {
-                    error = m_network.get(m_httpClient, url, response);
-                });
-                if (!task.first)
+                file.reset(new QTemporaryFile(QDir::tempPath() + "/monero-gui-download-XXXXXX"));
+                if (!file->open())
                 {
-                    return QJSValueList({"failed to start downloading task"});
+                    return QJSValueList({"failed to create a temporary file"});
                 }
-                task.second.waitForFinished();
-
+                QCryptographicHash calculatedHash(QCryptographicHash::Sha256);
+                const QString error = download(url, *file, calculatedHash);
                 if (!error.isEmpty())
                 {
                     return QJSValueList({error});
                 }
-            }
-
-            if (response.empty())
-            {
-                return QJSValueList({"empty response"});
-            }
-
-            try
-            {
-                const QByteArray calculatedHash = Updater().getHash(&response[0], response.size());
-                if (QByteArray::fromHex(hash.toUtf8()) != calculatedHash)
+                if (expectedHash != calculatedHash.result())
                 {
                     return QJSValueList({"hash sum mismatch"});
                 }
             }
-            catch (const std::exception &e)
+            if (m_cancelled)
+            {
+                return QJSValueList({"cancelled"});
+            }
+
+            if (!file->flush())
             {
-                return QJSValueList({e.what()});
+                return QJSValueList({"failed to write to a temporary file"});
             }
+            cacheBundle(url, *file);
 
             {
                 QWriteLocker locker(&m_mutex);
 
-                m_contents = std::move(response);
+                m_file = std::move(file);
             }
 
             return QJSValueList({});
         },
-        callback);
+        callback,
+        FutureScheduler::BlockingIO, "Downloader::get");
 
     return future.first;
 }
 
-bool Downloader::saveToFile(const QString &path) const
+QString Downloader::download(const QString &url, QIODevice &file, QCryptographicHash &calculatedHash, quint64 maxSize)
 {
-    QWriteLocker locker(&m_mutex);
+    // the body goes straight to disk and is hashed on the way, an
+    // interrupted transfer resumes with a Range request
+    quint64 written = 0;
+    bool writeFailed = false;
+    bool tooLarge = false;
+
+    m_httpClient->setSink(
+        [&](int responseCode) {
+            if (responseCode == 200)
+            {
+                // the server ignored the range, start over
+                truncate(file);
+                calculatedHash.reset();
+                written = 0;
+            }
+            return responseCode == 200 || responseCode == 206;
+        },
+        [&](const std::string &piece) {
+            if (maxSize > 0 && written + piece.size() > maxSize)
+            {
+                tooLarge = true;
+                return false;
+            }
+            if (file.write(piece.data(), piece.size()) != static_cast<qint64>(piece.size()))
+            {
+                writeFailed = true;
+                return false;
+            }
+            calculatedHash.addData(QByteArrayView(piece.data(), piece.size()));
+            written += piece.size();
+            return true;
+        });
+    const auto resetSink = sg::make_scope_guard([this]() {
+        m_httpClient->setSink({}, {});
+        m_httpClient->setResumeOffset(0);
+    });
 
-    if (m_active || m_contents.empty())
+    for (int stalled = 0;;)
     {
-        return false;
+        const quint64 offset = written;
+        m_httpClient->setResumeOffset(offset);
+
+        int responseCode = 0;
+        const QString error = m_network.getRange(m_httpClient, url, offset, responseCode);
+        if (error.isEmpty())
+        {
+            break;
+        }
+        if (writeFailed)
+        {
+            return "failed to write to a temporary file";
+        }
+        if (tooLarge)
+        {
+            return "response is too large";
+        }
+        // only interrupted transfers are resumed, not server errors
+        if (m_cancelled || responseCode != 0)
+        {
+            return error;
+        }
+        stalled = written > offset ? 0 : stalled + 1;
+        if (stalled >= DOWNLOAD_MAX_STALLED_ATTEMPTS)
+        {
+            return error;
+        }
+        if (!m_scheduler.token().sleepFor(std::chrono::milliseconds(DOWNLOAD_RETRY_DELAY_MS * (stalled + 1))))
+        {
+            return "cancelled";
+        }
     }
 
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly))
+    if (written == 0)
     {
-        return false;
+        return "empty response";
+    }
+    return {};
+}
+
+std::unique_ptr<QTemporaryFile> Downloader::patchCachedBundle(const QString &url, const QByteArray &expectedHash)
+{
+    QFile base(cachedBundlePath(url));
+    if (!base.open(QIODevice::ReadOnly) || base.size() == 0)
+    {
+        return nullptr;
+    }
+    const uchar *baseData = base.map(0, base.size());
+    if (!baseData)
+    {
+        return nullptr;
+    }
+    const auto unmap = sg::make_scope_guard([&base, baseData]() {
+        base.unmap(const_cast<uchar *>(baseData));
+    });
+    const QByteArray baseHash = QCryptographicHash::hash(
+        QByteArrayView(reinterpret_cast<const char *>(baseData), base.size()),
+        QCryptographicHash::Sha256);
+
+    std::unique_ptr<QTemporaryFile> file(new QTemporaryFile(QDir::tempPath() + "/monero-gui-download-XXXXXX"));
+    if (!file->open())
+    {
+        return nullptr;
+    }
+    QCryptographicHash calculatedHash(QCryptographicHash::Sha256);
+    if (baseHash == expectedHash)
+    {
+        // downloaded before but not installed
+        if (file->write(reinterpret_cast<const char *>(baseData), base.size()) != base.size())
+        {
+            return nullptr;
+        }
+        return file;
+    }
+
+    // deltas are published next to the full bundle, named by the base they apply to
+    const QString deltaUrl = QString("%1.from-%2.delta").arg(url, QString::fromLatin1(baseHash.toHex().left(DELTA_BASE_HASH_PREFIX)));
+    QBuffer delta;
+    delta.open(QIODevice::ReadWrite);
+    QCryptographicHash deltaHash(QCryptographicHash::Sha256);
+    const QString error = download(deltaUrl, delta, deltaHash, DELTA_MAX_SIZE);
+    if (!error.isEmpty())
+    {
+        qInfo() << "No delta update available, downloading the full bundle:" << error;
+        return nullptr;
+    }
+
+    try
+    {
+        DeltaPatch::apply(delta.data(), baseData, base.size(), baseHash, *file, calculatedHash);
+    }
+    catch (const std::exception &e)
+    {
+        qWarning() << "Failed to apply delta update, downloading the full bundle:" << e.what();
+        return nullptr;
+    }
+    if (calculatedHash.result() != expectedHash)
+    {
+        qWarning() << "Delta update produced the wrong bundle, downloading the full bundle";
+        return nullptr;
+    }
+
+    qInfo() << "Applied a" << delta.size() << "bytes delta update";
+    return file;
+}
+
+QString Downloader::cachedBundlePath(const QString &url)
+{
+    // one bundle per build, monero-gui-linux-x64-v0.18.3.4.tar.bz2 is kept as monero-gui-linux-x64
+    static const QRegularExpression version("-v?\\d+(\\.\\d+)+.*$");
+    const QString build = QUrl(url).fileName().remove(version);
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/updates/" + build;
+}
+
+void Downloader::cacheBundle(const QString &url, QFile &file)
+{
+    // the next update only has to fetch the delta against this bundle
+    const QString path = cachedBundlePath(url);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile::remove(path);
+    if (!QFile::copy(file.fileName(), path))
+    {
+        qWarning() << "Failed to keep the release bundle for delta updates" << path;
     }
+}
 
-    if (static_cast<size_t>(file.write(m_contents.data(), m_contents.size())) != m_contents.size())
+bool Downloader::saveToFile(const QString &path)
+{
+    QWriteLocker locker(&m_mutex);
+
+    if (m_active || !m_file)
     {
         return false;
     }
 
-    return true;
+    QFile::remove(path);
+    if (m_file->rename(path))
+    {
+        m_file->setAutoRemove(false);
+        m_file.reset();
+        return true;
+    }
+
+    // rename doesn't work across file systems
+    return QFile::copy(m_file->fileName(), path);
 }
 
 bool Downloader::active() const
@@ -238,5 +444,5 @@ void Downloader::setProxyAddress(QString address)
         QMutexLocker locker(&m_proxyMutex);
         m_proxyAddress = address;
         emit proxyAddressChanged();
-    });
+    }, FutureScheduler::Background, "Downloader::setProxyAddress");
 }
@@ -28,7 +28,9 @@
 
 #pragma once
 
+#include <QCryptographicHash>
 #include <QReadWriteLock>
+#include <QTemporaryFile>
 
 #include "network.h"
 
@@ -46,7 +48,7 @@ public:
 
     Q_INVOKABLE void cancel();
     Q_INVOKABLE bool get(const QString &url, const QString &hash, const QJSValue &callback);
-    Q_INVOKABLE bool saveToFile(const QString &path) const;
+    Q_INVOKABLE bool saveToFile(const QString &path);
 
 signals:
     void activeChanged() const;
@@ -61,9 +63,18 @@ private:
     QString proxyAddress() const;
     void setProxyAddress(QString address);
 
+    // maxSize 0 doesn't limit the response
+    QString download(const QString &url, QIODevice &file, QCryptographicHash &calculatedHash, quint64 maxSize = 0);
+    // rebuilds the bundle from the one kept from the previous update and a
+    // delta, nothing when there is no usable delta and the full bundle is needed
+    std::unique_ptr<QTemporaryFile> patchCachedBundle(const QString &url, const QByteArray &expectedHash);
+    static QString cachedBundlePath(const QString &url);
+    static void cacheBundle(const QString &url, QFile &file);
+
 private:
     bool m_active;
-    std::string m_contents;
+    std::atomic<bool> m_cancelled;
+    std::unique_ptr<QTemporaryFile> m_file;
     std::shared_ptr<HttpClient> m_httpClient;
     mutable QReadWriteLock m_mutex;
     Network m_network;
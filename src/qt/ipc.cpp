@@ -30,8 +30,11 @@
 #include <QLocalSocket>
 #include <QLocalServer>
 #include <QtNetwork>
+#include <QtEndian>
 #include <QDebug>
 
+#include <memory>
+
 #include "ipc.h"
 #include "utils.h"
 
@@ -66,28 +69,53 @@ void IPC::bind(){
     connect(this->m_server, &QLocalServer::newConnection, this, &IPC::handleConnection);
 }
 
+namespace {
+
+// URIs longer than this are rejected by main() already
+constexpr quint32 maxFrameSize = 4096;
+
+QByteArray frame(const QString &cmdString){
+    const QByteArray payload = cmdString.toUtf8();
+    QByteArray result(sizeof(quint32), Qt::Uninitialized);
+    qToBigEndian<quint32>(payload.size(), result.data());
+    return result.append(payload);
+}
+
+} // namespace
+
 // Process incoming IPC command. First check if monero-wallet-gui is
 // already running. If it is, send it to that instance instead, if not,
 // queue the command for later use inside our QML engine. Returns true
 // when queued, false if sent to another instance, at which point we can
 // kill the current process.
 bool IPC::saveCommand(QString cmdString){
-    qDebug() << QString("saveCommand called: %1").arg(cmdString);
+    return this->saveCommands(QStringList{cmdString});
+}
+
+// Same as saveCommand, all commands are pipelined over a single connection
+// as length-prefixed frames. Only the last one is queued when no other
+// instance is running.
+bool IPC::saveCommands(const QStringList &cmdStrings){
+    if(cmdStrings.isEmpty())
+        return true;
+    qDebug() << QString("saveCommands called: %1").arg(cmdStrings.join(", "));
 
     QLocalSocket ls;
     QByteArray buffer;
-    buffer = buffer.append(cmdString.toUtf8());
+    for(const QString &cmdString : cmdStrings)
+        buffer.append(frame(cmdString));
     QString socketFilePath = this->socketFile().filePath();
 
     ls.connectToServer(socketFilePath, QIODevice::WriteOnly);
     if(ls.waitForConnected(1000)){
         ls.write(buffer);
         if (!ls.waitForBytesWritten(1000)){
-            qDebug() << QString("Could not send command \"%1\" over IPC %2: \"%3\"").arg(cmdString, socketFilePath, ls.errorString());
+            qDebug() << QString("Could not send %1 command(s) over IPC %2: \"%3\"").arg(cmdStrings.size()).arg(socketFilePath, ls.errorString());
             return false;
         }
 
-        qDebug() << QString("Sent command \"%1\" over IPC \"%2\"").arg(cmdString, socketFilePath);
+        qDebug() << QString("Sent %1 command(s) over IPC \"%2\"").arg(cmdStrings.size()).arg(socketFilePath);
+        ls.disconnectFromServer();
         return false;
     }
 
@@ -95,7 +123,7 @@ bool IPC::saveCommand(QString cmdString){
         ls.disconnectFromServer();
 
     // Queue for later
-    this->SetQueuedCmd(cmdString);
+    this->SetQueuedCmd(cmdStrings.last());
     return true;
 }
 
@@ -103,19 +131,46 @@ bool IPC::saveCommand(const QUrl &url){
     return this->saveCommand(url.toString());
 }
 
+// Commands arrive as frames of a 32-bit big-endian length and the UTF-8
+// command. Older clients write a bare command and disconnect, their first
+// four bytes never decode to a valid length.
 void IPC::handleConnection(){
-    QLocalSocket *clientConnection = this->m_server->nextPendingConnection();
-    connect(clientConnection, &QLocalSocket::disconnected,
-            clientConnection, &QLocalSocket::deleteLater);
-
-    clientConnection->waitForReadyRead(2);
-    QString cmdString = QString(clientConnection->readAll());
-    qDebug() << cmdString;
-
-    this->parseCommand(cmdString);
-
-    clientConnection->close();
-    delete clientConnection;
+    while(QLocalSocket *clientConnection = this->m_server->nextPendingConnection()){
+        auto buffer = std::make_shared<QByteArray>();
+        auto legacy = std::make_shared<bool>(false);
+
+        connect(clientConnection, &QLocalSocket::readyRead, this, [this, clientConnection, buffer, legacy]{
+            buffer->append(clientConnection->readAll());
+            if(*legacy){
+                return;
+            }
+            while(buffer->size() >= static_cast<int>(sizeof(quint32))){
+                const quint32 length = qFromBigEndian<quint32>(buffer->constData());
+                if(length > maxFrameSize){
+                    *legacy = true;
+                    return;
+                }
+                if(buffer->size() < static_cast<int>(sizeof(quint32) + length)){
+                    return;
+                }
+                const QString cmdString = QString::fromUtf8(buffer->constData() + sizeof(quint32), length);
+                buffer->remove(0, sizeof(quint32) + length);
+                qDebug() << cmdString;
+                this->parseCommand(cmdString);
+            }
+        });
+        connect(clientConnection, &QLocalSocket::disconnected, this, [this, clientConnection, buffer, legacy]{
+            buffer->append(clientConnection->readAll());
+            // a framed client that disconnects mid-frame sent nothing usable
+            const bool bare = *legacy || (!buffer->isEmpty() && buffer->size() < static_cast<int>(sizeof(quint32)));
+            if(bare && buffer->size() <= static_cast<int>(maxFrameSize)){
+                const QString cmdString = QString::fromUtf8(*buffer);
+                qDebug() << cmdString;
+                this->parseCommand(cmdString);
+            }
+            clientConnection->deleteLater();
+        });
+    }
 }
 
 void IPC::parseCommand(const QUrl &url){
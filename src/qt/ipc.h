@@ -46,6 +46,7 @@ public slots:
     void bind();
     void handleConnection();
     bool saveCommand(QString cmdString);
+    bool saveCommands(const QStringList &cmdStrings);
     bool saveCommand(const QUrl &url);
     void parseCommand(QString cmdString);
     void parseCommand(const QUrl &url);
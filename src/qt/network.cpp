@@ -31,6 +31,8 @@
 #include <QDebug>
 #include <QtCore>
 
+#include "EventTrace.h"
+#include "NetworkStats.h"
 #include "utils.h"
 
 using epee::net_utils::http::fields_list;
@@ -42,6 +44,9 @@ HttpClient::HttpClient(QObject *parent /* = nullptr */)
     , m_cancel(false)
     , m_contentLength(0)
     , m_received(0)
+    , m_bodyBytes(0)
+    , m_sinking(false)
+    , m_resumeOffset(0)
 {
 }
 
@@ -60,6 +65,22 @@ quint64 HttpClient::received() const
     return m_received;
 }
 
+quint64 HttpClient::bodyBytes() const
+{
+    return m_bodyBytes;
+}
+
+void HttpClient::setSink(std::function<bool(int)> onResponse, std::function<bool(const std::string &)> onData)
+{
+    m_onResponse = std::move(onResponse);
+    m_onData = std::move(onData);
+}
+
+void HttpClient::setResumeOffset(quint64 offset)
+{
+    m_resumeOffset = offset;
+}
+
 bool HttpClient::on_header(const http_response_info &headers)
 {
     if (m_cancel.exchange(false))
@@ -72,10 +93,14 @@ bool HttpClient::on_header(const http_response_info &headers)
     {
         qWarning() << "Failed to get Content-Length";
     }
-    m_contentLength = contentLength;
+    m_sinking = m_onResponse && m_onData && m_onResponse(headers.m_response_code);
+    const size_t offset = m_sinking && headers.m_response_code == 206 ? m_resumeOffset : 0;
+
+    m_contentLength = offset + contentLength;
     emit contentLengthChanged();
 
-    m_received = 0;
+    m_received = offset;
+    m_bodyBytes = 0;
     emit receivedChanged();
 
     return net::http::client::on_header(headers);
@@ -89,47 +114,239 @@ bool HttpClient::handle_target_data(std::string &piece_of_transfer)
     }
 
     m_received += piece_of_transfer.size();
+    m_bodyBytes += piece_of_transfer.size();
     emit receivedChanged();
 
+    if (m_sinking)
+    {
+        const bool accepted = m_onData(piece_of_transfer);
+        piece_of_transfer.clear();
+        return accepted;
+    }
+
     return net::http::client::handle_target_data(piece_of_transfer);
 }
 
+namespace
+{
+    // servers drop idle keep-alive connections, typically after 60 s or less
+    constexpr std::chrono::seconds POOL_IDLE_TIMEOUT = std::chrono::seconds(30);
+    constexpr size_t POOL_MAX_CONNECTIONS_PER_HOST = 4;
+    // a warm-up is only a head start, a circuit that takes longer is left to the first request
+    constexpr std::chrono::seconds WARM_UP_TIMEOUT = std::chrono::seconds(15);
+
+    std::string serverPort(const QUrl &url)
+    {
+        return std::to_string(url.port(url.scheme() == "https" ? 443 : 80));
+    }
+
+    QString responseHeader(const http_response_info &info, const char *name)
+    {
+        for (const auto &field : info.m_header_info.m_etc_fields)
+        {
+            if (QString::fromStdString(field.first).compare(name, Qt::CaseInsensitive) == 0)
+            {
+                return QString::fromStdString(field.second).trimmed();
+            }
+        }
+        return {};
+    }
+
+    fields_list contentTypeHeaders(const QString &contentType)
+    {
+        fields_list headers;
+        if (!contentType.isEmpty())
+        {
+            headers.push_back({"Content-Type", contentType.toStdString()});
+        }
+        return headers;
+    }
+}
+
+HttpClientPool::HttpClientPool(size_t maxPerHost)
+    : m_state(std::make_shared<State>())
+{
+    m_state->maxPerHost = std::max<size_t>(1, maxPerHost);
+}
+
+HttpClientPool::~HttpClientPool()
+{
+    clear();
+}
+
+HttpClientPool::Lease HttpClientPool::acquire(const QUrl &url, const QString &proxyAddress)
+{
+    const std::string port = serverPort(url);
+    const QString key = QString("%1|%2://%3:%4")
+        .arg(proxyAddress, url.scheme(), url.host(), QString::fromStdString(port));
+
+    std::unique_ptr<abstract_http_client> client;
+    quint64 generation;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        Host &host = m_state->hosts[key];
+        if (host.idle.empty() && host.inUse >= m_state->maxPerHost)
+        {
+            throw std::runtime_error("too many concurrent requests to the host");
+        }
+
+        while (!host.idle.empty() && !client)
+        {
+            Idle idle = std::move(host.idle.back());
+            host.idle.pop_back();
+            if (!idle.expires.hasExpired())
+            {
+                client = std::move(idle.client);
+            }
+        }
+        ++host.inUse;
+        generation = m_state->generation;
+    }
+
+    const bool reused = client != nullptr;
+    if (!reused)
+    {
+        client.reset(new net::http::client());
+        if (!client->set_proxy(proxyAddress.toStdString()))
+        {
+            release(m_state, key, generation, nullptr);
+            throw std::runtime_error("failed to set proxy address");
+        }
+        client->set_server(url.host().toStdString(), port, {});
+    }
+
+    const std::weak_ptr<State> state = m_state;
+    std::shared_ptr<abstract_http_client> leased(client.release(), [state, key, generation](abstract_http_client *client) {
+        release(state, key, generation, client);
+    });
+    return {std::move(leased), reused};
+}
+
+void HttpClientPool::clear()
+{
+    // idle clients disconnect on destruction, outside the lock
+    std::vector<Idle> idle;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        ++m_state->generation;
+        for (auto &host : m_state->hosts)
+        {
+            std::move(host.second.idle.begin(), host.second.idle.end(), std::back_inserter(idle));
+            host.second.idle.clear();
+        }
+    }
+}
+
+void HttpClientPool::release(
+    const std::weak_ptr<State> &weakState,
+    const QString &key,
+    quint64 generation,
+    abstract_http_client *client)
+{
+    std::unique_ptr<abstract_http_client> owned(client);
+    const std::shared_ptr<State> state = weakState.lock();
+    if (!state)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&state->mutex);
+    Host &host = state->hosts[key];
+    --host.inUse;
+    if (owned && generation == state->generation && host.idle.size() < state->maxPerHost)
+    {
+        host.idle.push_back({std::move(owned), QDeadlineTimer(POOL_IDLE_TIMEOUT)});
+    }
+}
+
 Network::Network(QObject *parent)
     : QObject(parent)
+    , m_cacheEnabled(true)
+    , m_statsSource("network")
+    , m_pool(POOL_MAX_CONNECTIONS_PER_HOST)
     , m_scheduler(this)
 {
+    // pooled connections go through the proxy they were opened with
+    connect(this, &Network::proxyAddressChanged, this, [this] {
+        m_pool.clear();
+    });
 }
 
-void Network::get(const QString &url, const QJSValue &callback, const QString &contentType /* = {} */) const
+void Network::setStatsSource(const char *source)
+{
+    m_statsSource = source;
+}
+
+void Network::get(const QString &url, const QJSValue &callback, const QString &contentType /* = {} */, int maxAge /* = -1 */) const
 {
     m_scheduler.run(
-        [this, url, contentType] {
-            std::shared_ptr<abstract_http_client> httpClient = newClient();
-            if (httpClient.get() == nullptr)
+        [this, url, contentType, maxAge] {
+            std::string response;
+            QString error;
+            try
             {
-                return QJSValueList({url, "", "failed to initialize a client"});
+                error = fetch(url, response, contentType, maxAge);
+            }
+            catch (const std::exception &e)
+            {
+                error = e.what();
             }
-            std::string response;
-            QString error = get(httpClient, url, response, contentType);
             return QJSValueList({url, QString::fromStdString(response), error});
         },
-        callback);
+        callback,
+        FutureScheduler::BlockingIO, "Network::get");
 }
 
-void Network::getJSON(const QString &url, const QJSValue &callback) const
+void Network::getJSON(const QString &url, const QJSValue &callback, int maxAge /* = -1 */) const
 {
-    get(url, callback, "application/json; charset=utf-8");
+    get(url, callback, "application/json; charset=utf-8", maxAge);
 }
 
-std::string Network::get(const QString &url, const QString &contentType /* = {} */) const
+void Network::warmUp(const QStringList &urls) const
 {
-    std::string response;
-    std::shared_ptr<abstract_http_client> httpClient = newClient();
-    if (httpClient.get() == nullptr)
+    const QString proxyAddress = m_proxyAddress;
+    if (proxyAddress.isEmpty())
+    {
+        return;
+    }
+
+    for (const QString &url : urls)
     {
-        throw std::runtime_error("failed to initialize a client");
+        m_scheduler.run([this, url, proxyAddress] {
+            const QUrl urlParsed(url);
+            if (urlParsed.host().isEmpty())
+            {
+                return;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            try
+            {
+                HttpClientPool::Lease lease = m_pool.acquire(urlParsed, proxyAddress);
+                if (lease.reused)
+                {
+                    return;
+                }
+                if (!lease.client->connect(WARM_UP_TIMEOUT))
+                {
+                    qWarning() << "Failed to warm up connection to" << urlParsed.host() << "through" << proxyAddress;
+                    return;
+                }
+                qDebug() << "Warmed up connection to" << urlParsed.host() << "in" << timer.elapsed() << "ms";
+            }
+            catch (const std::exception &e)
+            {
+                qWarning() << "Failed to warm up connection to" << urlParsed.host() << e.what();
+            }
+        }, FutureScheduler::Background, "Network::warmUp");
     }
-    QString error = get(httpClient, url, response, contentType);
+}
+
+std::string Network::get(const QString &url, const QString &contentType /* = {} */) const
+{
+    std::string response;
+    QString error = fetch(url, response, contentType, -1);
     if (!error.isEmpty())
     {
         throw std::runtime_error(QString("failed to fetch %1: %2").arg(url).arg(error).toStdString());
@@ -137,6 +354,70 @@ std::string Network::get(const QString &url, const QString &contentType /* = {}
     return response;
 }
 
+QString Network::fetch(const QString &url, std::string &response, const QString &contentType, int maxAge) const
+{
+    const TraceScope trace("network", "Network::get");
+    const QUrl urlParsed(url);
+    HttpResponseCache &cache = HttpResponseCache::instance();
+    HttpResponseCache::Entry cached;
+    // responses fetched through a proxy never touch the disk
+    const bool persistent = m_proxyAddress.isEmpty();
+    const bool hasCached = m_cacheEnabled && cache.lookup(url, cached, persistent);
+    if (hasCached && cached.fresh(maxAge))
+    {
+        response = cached.body.toStdString();
+        return {};
+    }
+
+    fields_list headers = contentTypeHeaders(contentType);
+    if (hasCached && !cached.etag.isEmpty())
+    {
+        headers.push_back({"If-None-Match", cached.etag.toStdString()});
+    }
+    if (hasCached && !cached.lastModified.isEmpty())
+    {
+        headers.push_back({"If-Modified-Since", cached.lastModified.toStdString()});
+    }
+
+    for (bool retry = true;;)
+    {
+        HttpClientPool::Lease lease = m_pool.acquire(urlParsed, m_proxyAddress);
+        const http_response_info *info = nullptr;
+        const QString error = invoke(*lease.client, urlParsed, headers, info);
+        if (error.isEmpty())
+        {
+            if (info->m_response_code == 304 && hasCached)
+            {
+                cache.refresh(url, responseHeader(*info, "Cache-Control"), persistent);
+                response = cached.body.toStdString();
+                return {};
+            }
+            if (info->m_response_code != 200)
+            {
+                return QString("response code %1").arg(info->m_response_code);
+            }
+
+            response = std::move(info->m_body);
+            if (m_cacheEnabled)
+            {
+                HttpResponseCache::Entry entry;
+                entry.body = QByteArray::fromStdString(response);
+                entry.etag = responseHeader(*info, "ETag");
+                entry.lastModified = responseHeader(*info, "Last-Modified");
+                cache.store(url, std::move(entry), responseHeader(*info, "Cache-Control"), maxAge, persistent);
+            }
+            return {};
+        }
+
+        lease.client->disconnect();
+        // a reused connection may have been closed by the server meanwhile
+        if (!lease.reused || !std::exchange(retry, false))
+        {
+            return error;
+        }
+    }
+}
+
 QString Network::get(
     std::shared_ptr<abstract_http_client> httpClient,
     const QString &url,
@@ -144,41 +425,78 @@ QString Network::get(
     const QString &contentType /* = {} */) const
 {
     const QUrl urlParsed(url);
-    httpClient->set_server(urlParsed.host().toStdString(), urlParsed.scheme() == "https" ? "443" : "80", {});
+    httpClient->set_server(urlParsed.host().toStdString(), serverPort(urlParsed), {});
 
-    const QString uri = (urlParsed.hasQuery() ? urlParsed.path() + "?" + urlParsed.query() : urlParsed.path());
-    const http_response_info *pri = NULL;
-    constexpr std::chrono::milliseconds timeout = std::chrono::seconds(15);
-
-    fields_list headers({{"User-Agent", randomUserAgent().toStdString()}});
-    if (!contentType.isEmpty())
+    const http_response_info *info = nullptr;
+    const QString error = invoke(*httpClient, urlParsed, contentTypeHeaders(contentType), info);
+    if (!error.isEmpty())
     {
-        headers.push_back({"Content-Type", contentType.toStdString()});
+        return error;
     }
-    const bool result = httpClient->invoke(uri.toStdString(), "GET", {}, timeout, std::addressof(pri), headers);
-    if (!result)
+    if (info->m_response_code != 200)
     {
-        return "unknown error";
+        return QString("response code %1").arg(info->m_response_code);
     }
-    if (!pri)
+
+    response = std::move(info->m_body);
+    return {};
+}
+
+QString Network::getRange(
+    std::shared_ptr<abstract_http_client> httpClient,
+    const QString &url,
+    quint64 offset,
+    int &responseCode) const
+{
+    const QUrl urlParsed(url);
+    httpClient->set_server(urlParsed.host().toStdString(), serverPort(urlParsed), {});
+
+    fields_list headers;
+    if (offset > 0)
     {
-        return "internal error";
+        headers.push_back({"Range", "bytes=" + std::to_string(offset) + "-"});
     }
-    if (pri->m_response_code != 200)
+
+    const http_response_info *info = nullptr;
+    responseCode = 0;
+    const QString error = invoke(*httpClient, urlParsed, headers, info);
+    if (!error.isEmpty())
     {
-        return QString("response code %1").arg(pri->m_response_code);
+        return error;
     }
 
-    response = std::move(pri->m_body);
+    responseCode = info->m_response_code;
+    if (responseCode != 200 && responseCode != 206)
+    {
+        return QString("response code %1").arg(responseCode);
+    }
     return {};
 }
 
-std::shared_ptr<abstract_http_client> Network::newClient() const
+QString Network::invoke(
+    abstract_http_client &httpClient,
+    const QUrl &urlParsed,
+    const fields_list &extraHeaders,
+    const http_response_info *&pri) const
 {
-    std::shared_ptr<abstract_http_client> client(new net::http::client());
-    if (!client->set_proxy(m_proxyAddress.toStdString()))
+    const QString uri = (urlParsed.hasQuery() ? urlParsed.path() + "?" + urlParsed.query() : urlParsed.path());
+    constexpr std::chrono::milliseconds timeout = std::chrono::seconds(15);
+
+    fields_list headers({{"User-Agent", randomUserAgent().toStdString()}});
+    headers.insert(headers.end(), extraHeaders.begin(), extraHeaders.end());
+    pri = NULL;
+    NetworkRequestScope stats(urlParsed.host() + ":" + QString::fromStdString(serverPort(urlParsed)), m_statsSource, uri.size());
+    const bool result = httpClient.invoke(uri.toStdString(), "GET", {}, timeout, std::addressof(pri), headers);
+    if (!result)
+    {
+        return "unknown error";
+    }
+    if (!pri)
     {
-        throw std::runtime_error("failed to set proxy address");
+        return "internal error";
     }
-    return client;
+    // sunk bodies are passed on and never buffered in the response
+    const HttpClient *counting = dynamic_cast<const HttpClient *>(&httpClient);
+    stats.received(pri->m_response_code, counting ? counting->bodyBytes() : pri->m_body.size());
+    return {};
 }
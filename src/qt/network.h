@@ -28,6 +28,10 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <vector>
+
 #include <QCoreApplication>
 #include <QtNetwork>
 
@@ -39,6 +43,7 @@
 #pragma GCC diagnostic pop
 
 #include "FutureScheduler.h"
+#include "HttpResponseCache.h"
 
 class HttpClient : public QObject, public net::http::client
 {
@@ -52,6 +57,15 @@ public:
     void cancel();
     quint64 contentLength() const;
     quint64 received() const;
+    // body bytes of the latest response that went over the wire
+    quint64 bodyBytes() const;
+
+    // Bodies of the responses accepted by onResponse(code) are passed to onData
+    // piece by piece instead of being buffered, returning false aborts the transfer.
+    // Must not be changed while a request is running.
+    void setSink(std::function<bool(int)> onResponse, std::function<bool(const std::string &)> onData);
+    // bytes already received by an earlier request of a resumed transfer
+    void setResumeOffset(quint64 offset);
     
     // Qt6 meta-type system requires comparison operators
     bool operator==(const HttpClient &other) const { return this == &other; }
@@ -69,19 +83,86 @@ private:
     std::atomic<bool> m_cancel;
     std::atomic<size_t> m_contentLength;
     std::atomic<size_t> m_received;
+    std::atomic<size_t> m_bodyBytes;
+    std::function<bool(int)> m_onResponse;
+    std::function<bool(const std::string &)> m_onData;
+    bool m_sinking;
+    size_t m_resumeOffset;
+};
+
+// Keep-alive clients per proxy and host, shared by the requests of one Network.
+// At most maxPerHost connections to a host are in use at a time, requests run
+// on FutureScheduler lanes and must not wait for each other, so a further one fails.
+class HttpClientPool
+{
+public:
+    struct Lease
+    {
+        std::shared_ptr<epee::net_utils::http::abstract_http_client> client;
+        // the connection may have been closed by the server while idle
+        bool reused;
+    };
+
+    explicit HttpClientPool(size_t maxPerHost);
+    ~HttpClientPool();
+
+    // throws while all connections to the host are in use
+    Lease acquire(const QUrl &url, const QString &proxyAddress);
+    void clear();
+
+private:
+    struct Idle
+    {
+        std::unique_ptr<epee::net_utils::http::abstract_http_client> client;
+        QDeadlineTimer expires;
+    };
+
+    struct Host
+    {
+        std::vector<Idle> idle;
+        size_t inUse = 0;
+    };
+
+    struct State
+    {
+        QMutex mutex;
+        std::map<QString, Host> hosts;
+        size_t maxPerHost;
+        quint64 generation = 0;
+    };
+
+    static void release(
+        const std::weak_ptr<State> &state,
+        const QString &key,
+        quint64 generation,
+        epee::net_utils::http::abstract_http_client *client);
+
+private:
+    std::shared_ptr<State> m_state;
 };
 
 class Network : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QString proxyAddress MEMBER m_proxyAddress NOTIFY proxyAddressChanged)
+    Q_PROPERTY(bool cacheEnabled MEMBER m_cacheEnabled NOTIFY cacheEnabledChanged)
 
 public:
     Network(QObject *parent = nullptr);
 
+    // requests are accounted to source in NetworkStats, "network" by default
+    void setStatsSource(const char *source);
+
 public:
-    Q_INVOKABLE void get(const QString &url, const QJSValue &callback, const QString &contentType = {}) const;
-    Q_INVOKABLE void getJSON(const QString &url, const QJSValue &callback) const;
+    // maxAge >= 0 serves a cached response younger than maxAge seconds
+    // regardless of its Cache-Control, 0 always revalidates
+    Q_INVOKABLE void get(const QString &url, const QJSValue &callback, const QString &contentType = {}, int maxAge = -1) const;
+    Q_INVOKABLE void getJSON(const QString &url, const QJSValue &callback, int maxAge = -1) const;
+    // Opens a connection to each host through the SOCKS proxy on the Background
+    // lane and leaves it in the pool for the first request of this Network,
+    // no-op without a proxy. Only pass hosts this Network will fetch from,
+    // connections of other clients (e.g. libwallet's daemon) don't use the pool.
+    Q_INVOKABLE void warmUp(const QStringList &urls) const;
 
     std::string get(const QString &url, const QString &contentType = {}) const;
     QString get(
@@ -89,15 +170,31 @@ public:
         const QString &url,
         std::string &response,
         const QString &contentType = {}) const;
+    // requests the body from offset on, both 200 and 206 count as success
+    // and responseCode stays 0 if the server didn't respond
+    QString getRange(
+        std::shared_ptr<epee::net_utils::http::abstract_http_client> httpClient,
+        const QString &url,
+        quint64 offset,
+        int &responseCode) const;
 
 signals:
     void proxyAddressChanged() const;
+    void cacheEnabledChanged() const;
 
 private:
-    std::shared_ptr<epee::net_utils::http::abstract_http_client> newClient() const;
+    QString fetch(const QString &url, std::string &response, const QString &contentType, int maxAge) const;
+    QString invoke(
+        epee::net_utils::http::abstract_http_client &httpClient,
+        const QUrl &url,
+        const epee::net_utils::http::fields_list &extraHeaders,
+        const epee::net_utils::http::http_response_info *&info) const;
 
 private:
     QString m_proxyAddress;
+    bool m_cacheEnabled;
+    const char *m_statsSource;
+    mutable HttpClientPool m_pool;
     mutable FutureScheduler m_scheduler;
 };
 
@@ -36,14 +36,80 @@
 
 #include <openpgp/hash.h>
 
+#include <atomic>
+#include <future>
+
+#include <QHash>
+#include <QMutex>
+
 #include "network.h"
+#include "PerfTrace.h"
 #include "utils.h"
 
+namespace
+{
+
+// Maintainer keys from the resources, parsed once per process on first use.
+// openpgp::signature_rsa doesn't expose the issuer key id, so the key that
+// verified last is tried first instead.
+class MaintainerKeyRing
+{
+public:
+    static const MaintainerKeyRing &instance()
+    {
+        static const MaintainerKeyRing keyRing;
+        return keyRing;
+    }
+
+    QString verify(const epee::span<const uint8_t> data, const openpgp::signature_rsa &signature) const
+    {
+        const size_t first = m_lastMatch.load(std::memory_order_relaxed);
+        for (size_t offset = 0; offset < m_keys.size(); ++offset)
+        {
+            const size_t index = (first + offset) % m_keys.size();
+            if (signature.verify(data, *m_keys[index].publicKey))
+            {
+                m_lastMatch.store(index, std::memory_order_relaxed);
+                return QString::fromStdString(m_maintainers[m_keys[index].maintainer].user_id());
+            }
+        }
+
+        throw std::runtime_error("not signed by a maintainer");
+    }
+
+private:
+    MaintainerKeyRing()
+        : m_lastMatch(0)
+    {
+        m_maintainers.emplace_back(fileGetContents(":/monero/utils/gpg_keys/binaryfate.asc").toStdString());
+        m_maintainers.emplace_back(fileGetContents(":/monero/utils/gpg_keys/fluffypony.asc").toStdString());
+        m_maintainers.emplace_back(fileGetContents(":/monero/utils/gpg_keys/luigi1111.asc").toStdString());
+
+        for (size_t maintainer = 0; maintainer < m_maintainers.size(); ++maintainer)
+        {
+            for (const auto &publicKey : m_maintainers[maintainer])
+            {
+                m_keys.push_back({&publicKey, maintainer});
+            }
+        }
+    }
+
+    struct Key
+    {
+        const openpgp::public_key_rsa *publicKey;
+        size_t maintainer;
+    };
+
+    std::vector<openpgp::public_key_block> m_maintainers;
+    std::vector<Key> m_keys;
+    mutable std::atomic<size_t> m_lastMatch;
+};
+
+} // namespace
+
 Updater::Updater()
 {
-    m_maintainers.emplace_back(fileGetContents(":/monero/utils/gpg_keys/binaryfate.asc").toStdString());
-    m_maintainers.emplace_back(fileGetContents(":/monero/utils/gpg_keys/fluffypony.asc").toStdString());
-    m_maintainers.emplace_back(fileGetContents(":/monero/utils/gpg_keys/luigi1111.asc").toStdString());
+    m_network.setStatsSource("updater");
 }
 
 QByteArray Updater::fetchSignedHash(
@@ -54,9 +120,25 @@ QByteArray Updater::fetchSignedHash(
     static constexpr const char hashesTxtUrl[] = "https://web.getmonero.org/downloads/hashes.txt";
     static constexpr const char hashesTxtSigUrl[] = "https://web.getmonero.org/downloads/hashes.txt.sig";
 
-    const Network network;
-    std::string hashesTxt = network.get(hashesTxtUrl);
-    std::string hashesTxtSig = network.get(hashesTxtSigUrl);
+    // a release verified once doesn't have to be fetched again
+    static QMutex verifiedMutex;
+    static QHash<QPair<QString, QByteArray>, QPair<QString, QString>> verified;
+    const QPair<QString, QByteArray> release(binaryFilename, hashFromDns);
+    {
+        QMutexLocker locker(&verifiedMutex);
+        const auto it = verified.constFind(release);
+        if (it != verified.constEnd())
+        {
+            signers = *it;
+            return hashFromDns;
+        }
+    }
+
+    std::future<std::string> hashesTxtSigFuture = std::async(std::launch::async, [this] {
+        return m_network.get(hashesTxtSigUrl);
+    });
+    std::string hashesTxt = m_network.get(hashesTxtUrl);
+    std::string hashesTxtSig = hashesTxtSigFuture.get();
 
     const QByteArray signedHash = verifyParseSignedHahes(
         QByteArray(&hashesTxt[0], hashesTxt.size()),
@@ -69,6 +151,9 @@ QByteArray Updater::fetchSignedHash(
         throw std::runtime_error("DNS hash mismatch");
     }
 
+    QMutexLocker locker(&verifiedMutex);
+    verified.insert(release, signers);
+
     return signedHash;
 }
 
@@ -78,15 +163,19 @@ QByteArray Updater::verifyParseSignedHahes(
     const QString &binaryFilename,
     QPair<QString, QString> &signers) const
 {
-    const QString signedMessage = verifySignature(armoredSignedHashes, signers.first);
+    // the detached signature is checked alongside the clearsigned one
+    std::future<QString> secondSigner = std::async(std::launch::async, [this, &armoredSignedHashes, &secondDetachedSignature] {
+        return verifySignature(
+            epee::span<const uint8_t>(
+                reinterpret_cast<const uint8_t *>(armoredSignedHashes.data()),
+                armoredSignedHashes.size()),
+            openpgp::signature_rsa::from_buffer(epee::span<const uint8_t>(
+                reinterpret_cast<const uint8_t *>(secondDetachedSignature.data()),
+                secondDetachedSignature.size())));
+    });
 
-    signers.second = verifySignature(
-        epee::span<const uint8_t>(
-            reinterpret_cast<const uint8_t *>(armoredSignedHashes.data()),
-            armoredSignedHashes.size()),
-        openpgp::signature_rsa::from_buffer(epee::span<const uint8_t>(
-            reinterpret_cast<const uint8_t *>(secondDetachedSignature.data()),
-            secondDetachedSignature.size())));
+    const QString signedMessage = verifySignature(armoredSignedHashes, signers.first);
+    signers.second = secondSigner.get();
 
     if (signers.first == signers.second)
     {
@@ -160,16 +249,6 @@ QString Updater::verifySignature(const QByteArray &armoredSignedMessage, QString
 
 QString Updater::verifySignature(const epee::span<const uint8_t> data, const openpgp::signature_rsa &signature) const
 {
-    for (const auto &maintainer : m_maintainers)
-    {
-        for (const auto &public_key : maintainer)
-        {
-            if (signature.verify(data, public_key))
-            {
-                return QString::fromStdString(maintainer.user_id());
-            }
-        }
-    }
-
-    throw std::runtime_error("not signed by a maintainer");
+    const PerfScope perf("signature verification", qint64(data.size()));
+    return MaintainerKeyRing::instance().verify(data, signature);
 }
@@ -32,11 +32,15 @@
 
 #include <openpgp/openpgp.h>
 
+#include "network.h"
+
 class Updater
 {
 public:
     Updater();
 
+    //! fetches hashes.txt and its signature through one Network, so keep an
+    //! Updater around to reuse its pooled connections between checks
     QByteArray fetchSignedHash(
         const QString &binaryFilename,
         const QByteArray &hashFromDns,
@@ -60,5 +64,5 @@ private:
     QByteArray parseShasumOutput(const QString &message, const QString &filename) const;
 
 private:
-    std::vector<openpgp::public_key_block> m_maintainers;
+    Network m_network;
 };
@@ -214,3 +214,29 @@ QString randomUserAgent(){
     int irand = rand() % urand.length();
     return urand.at(irand);
 }
+
+bool isLocalAddress(const QString &address){
+    // host:port, IPv6 hosts are bracketed
+    QString host = address.trimmed().toLower();
+    if (host.startsWith('[')) {
+        host = host.mid(1, host.indexOf(']') - 1);
+    } else if (host.count(':') == 1) {
+        host = host.left(host.indexOf(':'));
+    }
+
+    if (host == "localhost" || host == "::1" || host == "0:0:0:0:0:0:0:1")
+        return true;
+    if (host.startsWith("::ffff:"))
+        host = host.mid(7);
+
+    // 127.0.0.0/8
+    const QStringList octets = host.split('.');
+    if (octets.size() != 4)
+        return false;
+    for (const QString &octet : octets) {
+        bool ok = false;
+        if (octet.toUInt(&ok) > 255 || !ok)
+            return false;
+    }
+    return octets.first().toUInt() == 127;
+}
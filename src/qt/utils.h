@@ -44,5 +44,7 @@ void registerXdgMime();
 #endif
 const static QRegularExpression reURI = QRegularExpression("^\\w+:\\/\\/([\\w+\\-?\\-_\\-=\\-&]+)");
 QString randomUserAgent();
+// host:port of a loopback node (127.0.0.0/8, localhost or [::1]), reached without the proxy
+bool isLocalAddress(const QString &address);
 
 #endif // UTILS_H
@@ -55,7 +55,12 @@ ColumnLayout {
         }
 
         // scorePassword returns value from 0 to... lots
-        var strength = walletManager.getPasswordStrength(passwordInput.text);
+        // estimated off the GUI thread, only the latest input's result comes back
+        walletManager.getPasswordStrengthAsync(passwordInput.text, updatePasswordStrength);
+    }
+
+    function updatePasswordStrength(strength) {
+        if(!progressLayout.visible) return;
         // consider anything below 10 bits as dire
         strength -= 10
         if (strength < 0)
@@ -165,6 +165,7 @@ Rectangle {
 
                          Image {
                              Layout.alignment: Qt.AlignTop | Qt.AlignHCenter
+                             asynchronous: true
                              source: {
                                 if (hardwareWalletType == "Trezor") {
                                     if (trezorType == "Trezor Model T") {
@@ -84,6 +84,8 @@ Rectangle {
         Image {
             id: globe
             source: "qrc:///images/world-flags-globe.png"
+            // the largest image in the UI, decode it off the GUI thread
+            asynchronous: true
             opacity: 0
             property bool small: appWindow.width < 700 ? true : false
             property int size: {
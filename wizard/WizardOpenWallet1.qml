@@ -48,12 +48,14 @@ Rectangle {
     property alias pageHeight: pageRoot.height
     property alias pageRoot: pageRoot
     property string viewName: "wizardOpenWallet1"
-    property int walletCount: walletKeysFilesModel.rowCount()
+    property int walletCount: walletKeysFilesModel.count
 
     WalletKeysFilesModel {
         id: walletKeysFilesModel
     }
 
+    onWalletCountChanged: flow._height = flow.calcHeight()
+
     ColumnLayout {
         id: pageRoot
         Layout.alignment: Qt.AlignHCenter;
@@ -84,7 +86,7 @@ Rectangle {
             }
 
             GridLayout {
-                visible: (walletKeysFilesModel ? walletKeysFilesModel.rowCount() : 0) > 0
+                visible: (walletKeysFilesModel ? walletKeysFilesModel.count : 0) > 0
                 Layout.topMargin: 10
                 Layout.fillWidth: true
                 columnSpacing: 20
@@ -350,8 +352,6 @@ Rectangle {
     function onPageCompleted(previousView){
         if(previousView.viewName == "wizardHome"){
             walletKeysFilesModel.refresh(appWindow.accountsDir);
-            wizardOpenWallet1.walletCount = walletKeysFilesModel.rowCount();
-            flow._height = flow.calcHeight();
         }
     }
 }
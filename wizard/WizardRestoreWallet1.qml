@@ -151,8 +151,10 @@ Rectangle {
                         seedRadioButton.checked = false;
                         keysRadioButton.checked = false;
                         wizardController.walletRestoreMode = 'qr';
-                        cameraUi.state = "Capture";
-                        cameraUi.qrcode_decoded.connect(Wizard.updateFromQrCode);
+                        if (appWindow.ensureCameraUi()) {
+                            cameraUi.state = "Capture";
+                            cameraUi.qrcode_decoded.connect(Wizard.updateFromQrCode);
+                        }
                     }
                 }
             }